@@ -14,7 +14,26 @@
 //
 // Usage:
 //   trading_server [--tcp-port 7000] [--market-data-port 7001]
-//                   [--http-port 8080] [--static-dir <path>]
+//                   [--http-port 8080] [--static-dir <path>] [--io-threads <n>]
+//                   [--io-uring] [--pin <role>=<cpus>]... [--fifo <role>=<priority>]...
+//
+// --io-threads serves every order-entry connection from that many epoll
+// event loops instead of a reader and a writer thread each (see
+// OrderEntryGatewayOptions::io_threads); 0, the default, keeps the threads.
+// --io-uring makes those loops io_uring ones, falling back to epoll where
+// the kernel will not have it (see OrderEntryGatewayOptions::io_backend).
+//
+// --pin and --fifo place one thread role (see common/thread_placement.hpp):
+// matching, accept, reader, writer, io, snapshot, market_data, routing or
+// publishing. --pin takes a CPU list ("3", "2,3", "4-7"); --fifo a
+// SCHED_FIFO priority, 1-99. Both may repeat, one role each time. For example, a matching thread alone on
+// core 3 and ahead of everything else there:
+//
+//   trading_server --pin matching=3 --fifo matching=80
+//
+// Either one the OS refuses -- a core outside this process's cpuset, no
+// CAP_SYS_NICE for SCHED_FIFO -- leaves that thread unplaced and the server
+// running.
 //
 // Shutdown is Ctrl+C and nothing more, the same scope decision the other
 // demo apps make. Everything is then torn down in dependency order: the UI
@@ -29,8 +48,11 @@
 #include <optional>
 #include <span>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <thread>
 
+#include "common/thread_placement.hpp"
 #include "exchange/gateway/order_entry_gateway.hpp"
 #include "exchange/market_data/market_data_publisher.hpp"
 #include "net/packet.hpp"
@@ -48,8 +70,25 @@ struct Args {
     std::uint16_t market_data_port = 7001;
     std::uint16_t http_port = 8080;
     std::string static_dir;
+    std::size_t io_threads = 0;
+    bool io_uring = false;
+    ThreadPlacementProfile placement;
 };
 
+// "<role>=<value>" as the role and the value, or nullopt if either is missing
+// or the role is not one of thread_role_from_name()'s.
+std::optional<std::pair<ThreadRole, std::string_view>> parse_role_setting(std::string_view setting) {
+    const std::size_t equals = setting.find('=');
+    if (equals == std::string_view::npos || equals + 1 == setting.size()) {
+        return std::nullopt;
+    }
+    const auto role = thread_role_from_name(setting.substr(0, equals));
+    if (!role) {
+        return std::nullopt;
+    }
+    return std::pair{*role, setting.substr(equals + 1)};
+}
+
 std::optional<Args> parse_args(int argc, char** argv) {
     Args args;
     for (int i = 1; i < argc; ++i) {
@@ -75,6 +114,32 @@ std::optional<Args> parse_args(int argc, char** argv) {
             auto v = next();
             if (!v) return std::nullopt;
             args.static_dir = *v;
+        } else if (flag == "--io-threads") {
+            auto v = next();
+            if (!v) return std::nullopt;
+            args.io_threads = std::stoul(*v);
+        } else if (flag == "--io-uring") {
+            args.io_uring = true;
+        } else if (flag == "--pin") {
+            auto v = next();
+            if (!v) return std::nullopt;
+            const auto setting = parse_role_setting(*v);
+            const auto cpus = setting ? parse_cpu_list(setting->second) : std::nullopt;
+            if (!cpus) {
+                std::cerr << "bad --pin " << *v << " (want <role>=<cpu list>)\n";
+                return std::nullopt;
+            }
+            args.placement[setting->first].cpus = *cpus;
+        } else if (flag == "--fifo") {
+            auto v = next();
+            if (!v) return std::nullopt;
+            const auto setting = parse_role_setting(*v);
+            const int priority = setting ? std::atoi(std::string(setting->second).c_str()) : 0;
+            if (priority < 1 || priority > 99) {
+                std::cerr << "bad --fifo " << *v << " (want <role>=<priority 1-99>)\n";
+                return std::nullopt;
+            }
+            args.placement[setting->first].realtime_priority = priority;
         } else {
             std::cerr << "unrecognized argument: " << flag << "\n";
             return std::nullopt;
@@ -85,7 +150,9 @@ std::optional<Args> parse_args(int argc, char** argv) {
 
 void print_usage() {
     std::cerr << "Usage: trading_server [--tcp-port <port>] [--market-data-port <port>]\n"
-              << "                       [--http-port <port>] [--static-dir <path>]\n";
+              << "                       [--http-port <port>] [--static-dir <path>] [--io-threads <n>]\n"
+              << "                       [--io-uring] [--pin <role>=<cpus>]... [--fifo <role>=<priority>]...\n"
+              << "roles: matching accept reader writer io snapshot market_data routing publishing\n";
 }
 
 std::atomic<bool> g_stop_requested{false};
@@ -122,6 +189,17 @@ int main(int argc, char** argv) {
 
     OrderEntryGatewayOptions gateway_options;
     gateway_options.instruments = ui_options.demo_instrument_ids;
+    // Good-till-date orders expire on the gateway's clock ticks; a tenth of a
+    // second is as late as one of them ever fires.
+    gateway_options.clock_tick_interval = std::chrono::milliseconds(100);
+    // A demo exchange sits idle most of the time, usually on a laptop: park
+    // the matching thread between commands instead of spinning a core on it.
+    gateway_options.matching_wait = WaitPolicy::Park;
+    gateway_options.placement = args->placement;
+    gateway_options.io_threads = args->io_threads;
+    if (args->io_uring) {
+        gateway_options.io_backend = GatewayIoBackend::IoUring;
+    }
     gateway_options.extra_event_sink = [&](const ExchangeEvent& event) {
         publisher.publish(event, [&](const protocol::Event& wire_event) {
             const std::array<protocol::Event, 1> frames{wire_event};
@@ -159,6 +237,7 @@ int main(int argc, char** argv) {
     std::cout << "order-entry gateway listening on tcp:" << *gateway.local_port() << "\n";
 
     ui_options.static_files_dir = args->static_dir;
+    ui_options.market_data_placement = args->placement[ThreadRole::MarketData];
     ui_gateway::UiGateway ui(gateway, args->tcp_port, args->market_data_port, args->http_port, ui_options);
     if (!ui.start()) {
         std::cerr << "failed to start UI gateway (http-port " << args->http_port << " or market-data-port "
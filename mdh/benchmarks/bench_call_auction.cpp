@@ -0,0 +1,160 @@
+// An opening with many orders, a share of them crossing, taken two ways
+// against an in-process MatchingEngine on one book:
+//
+//   1. Continuous: every order matches as it arrives, so the crossing ones
+//      trade there and then, each paying its own sweep and its own events.
+//   2. A call: the same orders arrive while the book is in its call phase
+//      and only rest, and one TradingPhaseCommand back to continuous then
+//      uncrosses the whole book at its equilibrium price in one batch.
+//
+// Per-command cost is timed in both arms and printed side by side: what an
+// order costs the matching thread while it is only being collected against
+// what it costs when it may trade. The uncross is timed on its own, as one
+// command -- which is also how long every other instrument on the matching
+// thread waits behind it -- and its events are counted against the
+// continuous arm's, since the call's single price is what lets it report
+// far fewer trades for the same crossing interest.
+//
+// Run at 10,000 orders, where the book and its directory stay in cache, and
+// at 1,000,000, where they do not. At the larger size resting an order --
+// a directory insert and a slab append into tens of megabytes -- costs far
+// more than deciding whether it trades, and a call rests every order where
+// continuous trading rests only what is left over; the two sizes together
+// show how much of the per-order figure is matching and how much is memory.
+//
+// Orders are a fixed pseudo-random stream: buys from 50 ticks below the mid
+// to 10 above it, sells from 10 below to 50 above, one to ten lots each, so
+// the two sides overlap by twenty ticks. Events go into a sink that only
+// counts them, so what is timed is the matching side alone. Standalone
+// rather than a Google Benchmark case for the same reason as
+// bench_mass_cancel.cpp. Run from a Release build only.
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "exchange/matching/matching_engine.hpp"
+
+using namespace mdh;
+using namespace mdh::exchange;
+
+namespace {
+
+constexpr InstrumentId kInstrument = 1;
+constexpr Price kMid = 10'000;
+constexpr int kRounds = 3;
+
+struct CountingSink {
+    std::size_t* events;
+    std::size_t* trades;
+    void operator()(const ExchangeEvent& event) const {
+        ++*events;
+        *trades += std::holds_alternative<TradeExecuted>(event) ? 1 : 0;
+    }
+};
+
+std::vector<NewOrderCommand> order_flow(std::size_t count) {
+    std::mt19937_64 rng(20240901);
+    std::vector<NewOrderCommand> orders;
+    orders.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        const bool buy = rng() % 2 == 0;
+        const Price offset = static_cast<Price>(rng() % 61);
+        orders.push_back(NewOrderCommand{.command_sequence = 0,
+                                         .account_id = 1 + i % 64,
+                                         .client_order_id = i + 1,
+                                         .instrument_id = kInstrument,
+                                         .side = buy ? Side::Buy : Side::Sell,
+                                         .price = buy ? kMid - 50 + offset : kMid - 10 + offset,
+                                         .quantity = 1 + rng() % 10,
+                                         .order_type = OrderType::Limit,
+                                         .time_in_force = TimeInForce::GTC});
+    }
+    return orders;
+}
+
+struct Sample {
+    double per_order_ns;
+    double uncross_ns;
+    std::size_t events;
+    std::size_t trades;
+    std::size_t resting;
+};
+
+Sample run(const std::vector<NewOrderCommand>& orders, bool call) {
+    MatchingEngine engine({kInstrument}, orders.size());
+    CommandSequence sequence = 0;
+    std::size_t events = 0;
+    std::size_t trades = 0;
+    if (call) {
+        engine.process(TradingPhaseCommand{.command_sequence = ++sequence,
+                                           .instrument_id = kInstrument,
+                                           .phase = TradingPhase::Call},
+                       CountingSink{&events, &trades});
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    for (NewOrderCommand order : orders) {
+        order.command_sequence = ++sequence;
+        engine.process(order, CountingSink{&events, &trades});
+    }
+    const double orders_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    double uncross_ns = 0;
+    if (call) {
+        const auto uncross_start = std::chrono::steady_clock::now();
+        engine.process(TradingPhaseCommand{.command_sequence = ++sequence,
+                                           .instrument_id = kInstrument,
+                                           .phase = TradingPhase::Continuous},
+                       CountingSink{&events, &trades});
+        uncross_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - uncross_start).count();
+    }
+
+    std::size_t resting = 0;
+    for (const auto& book : engine.snapshot().instruments) {
+        resting += book.bids.size() + book.asks.size();
+    }
+    return {orders_ns / static_cast<double>(orders.size()), uncross_ns, events, trades, resting};
+}
+
+double median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+} // namespace
+
+int main() {
+    for (const std::size_t count : {std::size_t{10'000}, std::size_t{1'000'000}}) {
+        const std::vector<NewOrderCommand> orders = order_flow(count);
+        std::vector<double> continuous_ns;
+        std::vector<double> call_ns;
+        std::vector<double> uncross_ns;
+        Sample continuous{};
+        Sample call{};
+        for (int round = 0; round < kRounds; ++round) {
+            continuous = run(orders, false);
+            call = run(orders, true);
+            continuous_ns.push_back(continuous.per_order_ns);
+            call_ns.push_back(call.per_order_ns);
+            uncross_ns.push_back(call.uncross_ns);
+        }
+        if (call.trades == 0 || continuous.trades == 0) {
+            std::fprintf(stderr, "%zu orders: %zu trades continuous, %zu in the uncross\n", count, continuous.trades,
+                         call.trades);
+            return EXIT_FAILURE;
+        }
+
+        const double uncross = median(uncross_ns);
+        std::printf("%zu orders on one book, median of %d rounds\n", count, kRounds);
+        std::printf("  per order, continuous            %8.1f ns  (%zu trades, %zu events)\n", median(continuous_ns),
+                    continuous.trades, continuous.events);
+        std::printf("  per order, during the call       %8.1f ns\n", median(call_ns));
+        std::printf("  uncross of the accumulated book  %8.2f ms  (%zu trades, %.1f ns/trade; %zu events in all)\n",
+                    uncross / 1e6, call.trades, uncross / static_cast<double>(call.trades), call.events);
+        std::printf("  left resting: %zu continuous, %zu after the uncross\n", continuous.resting, call.resting);
+    }
+    return EXIT_SUCCESS;
+}
@@ -28,11 +28,13 @@
 #include <chrono>
 #include <cstdio>
 #include <cstdlib>
+#include <ctime>
 #include <numeric>
 #include <optional>
 #include <span>
 #include <string>
 #include <thread>
+#include <utility>
 #include <vector>
 
 #include "exchange/gateway/order_entry_gateway.hpp"
@@ -51,6 +53,9 @@ namespace {
 
 constexpr InstrumentId kInstrument = 1;
 constexpr AccountId kAccount = 1;
+// Where the snapshot arm keeps its deep, untouched book.
+constexpr InstrumentId kDeepInstrument = 2;
+constexpr std::size_t kDeepBookOrders = 50'000;
 
 // Same minimal test-only client shape as
 // tests/test_order_entry_gateway_e2e.cpp's TestClient -- duplicated rather
@@ -233,6 +238,76 @@ private:
     return samples_ns;
 }
 
+// A fully-wired gateway on an ephemeral port, measured with
+// measure_round_trips(). `resting_orders` GTC buys are rested first on a
+// second instrument, out of the way of the measured flow, so that the
+// engine holds a book a full snapshot would have to copy. If `io_stats` is
+// given, the gateway's system-call and message counts land there.
+[[nodiscard]] std::vector<double> measure_gateway(OrderEntryGatewayOptions options, std::size_t resting_orders,
+                                                  std::size_t iterations, GatewayIoStats* io_stats = nullptr) {
+    options.instruments = {kInstrument, kDeepInstrument};
+    const GatewayIoBackend requested =
+        options.io_threads > 0 ? options.io_backend : GatewayIoBackend::Threads;
+    OrderEntryGateway gateway(0, std::move(options));
+    if (!gateway.start()) {
+        std::fprintf(stderr, "failed to start gateway\n");
+        return {};
+    }
+    gateway.deposit_cash(kAccount, 1'000'000'000'000LL);
+
+    LatencyClient client;
+    if (!client.connect_to(*gateway.local_port())) {
+        std::fprintf(stderr, "failed to connect to gateway\n");
+        return {};
+    }
+    for (std::size_t i = 0; i < resting_orders; ++i) {
+        client.send(Message{NewOrder{.account_id = kAccount,
+                                      .client_order_id = 2'000'000 + i,
+                                      .instrument_id = kDeepInstrument,
+                                      .side = Side::Buy,
+                                      .price = 1 + static_cast<Price>(i % 500),
+                                      .quantity = 1,
+                                      .order_type = OrderType::Limit,
+                                      .time_in_force = TimeInForce::GTC}});
+        if (!client.receive(1000ms)) {
+            std::fprintf(stderr, "no response while resting order %zu\n", i);
+            return {};
+        }
+    }
+
+    std::vector<double> samples_ns = measure_round_trips(client, iterations);
+    gateway.stop();
+    if (io_stats != nullptr) {
+        *io_stats = gateway.io_stats();
+        if (gateway.io_backend() != requested) {
+            std::fprintf(stderr, "requested I/O backend unavailable; measured the fallback\n");
+        }
+    }
+    return samples_ns;
+}
+
+// Process CPU time burned per second of wall-clock by a started gateway
+// with one connected, silent client -- so the matching thread and one
+// writer thread are both idle, waiting however `options` tells them to.
+// Measured with std::clock(), i.e. across every thread of this process;
+// nothing else in it is running while this sleeps.
+[[nodiscard]] std::optional<double> measure_idle_cpu(OrderEntryGatewayOptions options) {
+    options.instruments = {kInstrument};
+    OrderEntryGateway gateway(0, std::move(options));
+    LatencyClient client;
+    if (!gateway.start() || !client.connect_to(*gateway.local_port())) {
+        return std::nullopt;
+    }
+    std::this_thread::sleep_for(100ms); // past any spin before the threads settle into their idle wait
+    const std::clock_t cpu_start = std::clock();
+    const auto wall_start = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(1s);
+    const double cpu_s = static_cast<double>(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+    const double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+    gateway.stop();
+    return cpu_s / wall_s;
+}
+
 void report(const char* title, std::vector<double>& sorted_ns) {
     const double sum = std::accumulate(sorted_ns.begin(), sorted_ns.end(), 0.0);
     std::printf("\n%s\n", title);
@@ -254,25 +329,73 @@ int main(int argc, char** argv) {
         iterations = static_cast<std::size_t>(std::atoll(argv[1]));
     }
 
-    OrderEntryGateway gateway(0, OrderEntryGatewayOptions{.instruments = {kInstrument}});
-    if (!gateway.start()) {
-        std::fprintf(stderr, "failed to start gateway\n");
+    GatewayIoStats threads_io;
+    std::vector<double> gateway_ns = measure_gateway({}, 0, iterations, &threads_io);
+    if (gateway_ns.empty()) {
         return EXIT_FAILURE;
     }
-    gateway.deposit_cash(kAccount, 1'000'000'000'000LL);
 
-    LatencyClient client;
-    if (!client.connect_to(*gateway.local_port())) {
-        std::fprintf(stderr, "failed to connect to gateway\n");
+    // The same connection served by one event loop instead of its own reader
+    // and writer threads: epoll, which reads and writes the socket itself on
+    // each readiness event, and io_uring, whose multishot recv and queued
+    // sends go in with the one io_uring_enter() the loop waits in. The
+    // system calls each spends per message are printed beside the latency.
+    GatewayIoStats epoll_io;
+    std::vector<double> epoll_ns = measure_gateway(
+        OrderEntryGatewayOptions{.io_threads = 1, .io_backend = GatewayIoBackend::Epoll}, 0, iterations, &epoll_io);
+    GatewayIoStats uring_io;
+    std::vector<double> uring_ns = measure_gateway(
+        OrderEntryGatewayOptions{.io_threads = 1, .io_backend = GatewayIoBackend::IoUring}, 0, iterations, &uring_io);
+    if (epoll_ns.empty() || uring_ns.empty()) {
         return EXIT_FAILURE;
     }
 
-    std::vector<double> gateway_ns = measure_round_trips(client, iterations);
-    gateway.stop();
-    if (gateway_ns.empty()) {
+    // Background snapshots every 100 commands, next to a book of
+    // kDeepBookOrders that the measured flow never touches. Only books that
+    // changed are copied at a capture, so the deep book is copied once, on
+    // the first capture after it was seeded, and this arm should sit on top
+    // of the plain one; a capture that copied every book would charge one
+    // command in a hundred for all of it.
+    std::vector<double> snapshotting_ns =
+        measure_gateway(OrderEntryGatewayOptions{.snapshot_every_commands = 100}, kDeepBookOrders, iterations);
+    if (snapshotting_ns.empty()) {
+        return EXIT_FAILURE;
+    }
+
+    // Without the event ring (event_ring_capacity = 0), events are routed
+    // on the matching thread itself as they are produced: translating each
+    // into reports, resolving their sessions and queueing them, all before
+    // the next command is matched. The ring's routing thread does the same
+    // work off the matching thread in the default arm, so the gap between
+    // the two is what routing costs matching per event.
+    std::vector<double> inline_routing_ns =
+        measure_gateway(OrderEntryGatewayOptions{.event_ring_capacity = 0}, 0, iterations);
+    if (inline_routing_ns.empty()) {
         return EXIT_FAILURE;
     }
 
+    // The idle wait of the matching thread and the writers, parked and
+    // busy-spinning, against the default above (matching thread spins then
+    // yields, writers park). Busy-spinning is skipped on a host without a
+    // core each for the client, the matching thread and the writer: there
+    // the spinners only take turns with the threads they are waiting on,
+    // and what would be measured is the scheduler's time slice.
+    std::vector<double> parked_ns = measure_gateway(
+        OrderEntryGatewayOptions{.matching_wait = WaitPolicy::Park, .writer_wait = WaitPolicy::Park}, 0, iterations);
+    if (parked_ns.empty()) {
+        return EXIT_FAILURE;
+    }
+    const bool cores_for_spinning = std::thread::hardware_concurrency() >= 4;
+    std::vector<double> spinning_ns;
+    if (cores_for_spinning) {
+        spinning_ns = measure_gateway(
+            OrderEntryGatewayOptions{.matching_wait = WaitPolicy::BusySpin, .writer_wait = WaitPolicy::BusySpin}, 0,
+            iterations);
+        if (spinning_ns.empty()) {
+            return EXIT_FAILURE;
+        }
+    }
+
     // The floor, measured second and in the same process, so it sees the
     // same machine state rather than a number carried over from another run.
     std::vector<std::byte> canned_response;
@@ -305,8 +428,43 @@ int main(int argc, char** argv) {
 
     std::printf("mdh order-entry latency: NewOrder -> Accepted, IOC, empty book, loopback TCP\n");
     report("Fully-wired gateway (decode, risk, ledger, matching, encode, two thread handoffs)", gateway_ns);
+    report("Same, with a 50k-order idle book and a background snapshot every 100 commands", snapshotting_ns);
+    report("Events routed on the matching thread, no event ring (event_ring_capacity = 0)", inline_routing_ns);
+    report("Matching thread and writers parked between commands (WaitPolicy::Park)", parked_ns);
+    if (cores_for_spinning) {
+        report("Matching thread and writers busy-spinning (WaitPolicy::BusySpin)", spinning_ns);
+    } else {
+        std::printf("\nBusy-spinning arm skipped: %u hardware threads, fewer than the 4 it needs\n",
+                    std::thread::hardware_concurrency());
+    }
+    report("One epoll event loop for the connection (io_threads = 1)", epoll_ns);
+    report("One io_uring event loop for the connection (io_threads = 1, io_backend = IoUring)", uring_ns);
     report("Transport floor (same bytes, same client, canned reply, nothing in between)", floor_ns);
 
+    std::printf("\nGateway system calls per message (socket reads and writes, epoll_wait, io_uring_enter)\n");
+    const std::pair<const char*, const GatewayIoStats*> io_arms[] = {
+        {"reader and writer threads", &threads_io},
+        {"epoll event loop", &epoll_io},
+        {"io_uring event loop", &uring_io},
+    };
+    for (const auto& [name, stats] : io_arms) {
+        std::printf("  %-28s %6.2f  (%llu calls, %llu messages)\n", name, stats->syscalls_per_message(),
+                    static_cast<unsigned long long>(stats->syscalls),
+                    static_cast<unsigned long long>(stats->messages_in + stats->messages_out));
+    }
+
+    std::printf("\nIdle CPU, one silent connection, process CPU time per wall-clock second\n");
+    const std::pair<const char*, OrderEntryGatewayOptions> idle_arms[] = {
+        {"default (matching spins then yields, writers park)", {}},
+        {"parked (matching and writers park)",
+         {.matching_wait = WaitPolicy::Park, .writer_wait = WaitPolicy::Park}},
+    };
+    for (const auto& [name, options] : idle_arms) {
+        if (const auto fraction = measure_idle_cpu(options)) {
+            std::printf("  %-52s %6.1f%%\n", name, 100.0 * *fraction);
+        }
+    }
+
     std::printf("\nWhat this codebase adds, floor subtracted at each percentile\n");
     for (const double p : {0.50, 0.90, 0.99, 0.999}) {
         const double added = percentile(gateway_ns, p) - percentile(floor_ns, p);
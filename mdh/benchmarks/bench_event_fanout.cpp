@@ -0,0 +1,162 @@
+// What the matching thread pays for a slow event consumer, inline against
+// behind an EventFanout.
+//
+// The consumer is trading_server's market-data sink, unmodified in
+// substance: every event through a MarketDataPublisher, each wire event
+// packed into a datagram and sent over loopback UDP -- a syscall per public
+// event, and the slowest thing the gateway used to call on the matching
+// thread. The producer is an in-process MatchingEngine fed one maker resting
+// a lot at the touch and one taker lifting it, over and over.
+//
+//   inline  The sink is the engine's event sink, as extra_event_sink was
+//           before the event ring: every send_to() happens inside
+//           process().
+//   ring    The engine's sink writes the event into an EventFanout slot; the
+//           sink runs on the fanout's own thread. The matching thread
+//           publishes once per command.
+//
+// Timed per command on the producer, which is the matching thread's
+// critical path: p50, p99, p99.9 and mean. "drained" is the whole run, from
+// the first command until the sink has handled the last event, as commands
+// per second -- the ring cannot make the sink itself faster, only take it off
+// the critical path, so with fewer cores than threads this is where its
+// extra thread shows. A ring that filled is reported as producer stalls.
+//
+// Standalone for the same reason as bench_matching_workload.cpp: the
+// percentiles need the individual samples. Run from a Release build only.
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <span>
+#include <vector>
+
+#include "exchange/market_data/market_data_publisher.hpp"
+#include "exchange/matching/matching_engine.hpp"
+#include "exchange/sequencing/event_fanout.hpp"
+#include "net/packet.hpp"
+#include "net/udp_receiver.hpp"
+#include "net/udp_socket.hpp"
+
+using namespace mdh;
+using namespace mdh::exchange;
+
+namespace {
+
+constexpr std::size_t kCommands = 100'000;
+constexpr InstrumentId kInstrument = 1;
+constexpr Price kTouch = 1'000;
+
+NewOrderCommand limit(CommandSequence seq, AccountId account, ClientOrderId client_id, Side side) {
+    return NewOrderCommand{.command_sequence = seq,
+                           .account_id = account,
+                           .client_order_id = client_id,
+                           .instrument_id = kInstrument,
+                           .side = side,
+                           .price = kTouch,
+                           .quantity = 1,
+                           .order_type = OrderType::Limit,
+                           .time_in_force = TimeInForce::GTC};
+}
+
+// trading_server's extra_event_sink, minus the gateway around it.
+class UdpMarketData {
+public:
+    explicit UdpMarketData(std::uint16_t port) : port_(port) {}
+
+    void operator()(const ExchangeEvent& event) {
+        publisher_.publish(event, [this](const protocol::Event& wire_event) {
+            const std::array<protocol::Event, 1> frames{wire_event};
+            auto datagram = net::pack_frames(next_packet_sequence_++, std::span<const protocol::Event>(frames));
+            (void)socket_.send_to(datagram, "127.0.0.1", port_);
+        });
+    }
+
+private:
+    market_data::MarketDataPublisher publisher_;
+    net::UdpSocket socket_;
+    std::uint16_t port_;
+    std::uint64_t next_packet_sequence_ = 1;
+};
+
+struct Result {
+    std::vector<double> ns; // per command, sorted
+    double drained_seconds = 0;
+    std::size_t stalls = 0;
+};
+
+template <class Submit>
+Result run_commands(Submit&& submit) {
+    Result result;
+    result.ns.reserve(kCommands);
+    CommandSequence sequence = 0;
+    for (std::size_t i = 0; i < kCommands; ++i) {
+        const bool maker = i % 2 == 0;
+        const NewOrderCommand command =
+            limit(++sequence, maker ? 1 : 2, i / 2 + 1, maker ? Side::Sell : Side::Buy);
+        const auto start = std::chrono::steady_clock::now();
+        submit(command);
+        result.ns.push_back(
+            std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+    }
+    return result;
+}
+
+Result run_inline(std::uint16_t port) {
+    MatchingEngine engine({kInstrument}, kCommands);
+    UdpMarketData sink(port);
+    const auto start = std::chrono::steady_clock::now();
+    Result result = run_commands([&](const NewOrderCommand& command) { engine.process(command, sink); });
+    result.drained_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+Result run_ring(std::uint16_t port) {
+    MatchingEngine engine({kInstrument}, kCommands);
+    UdpMarketData sink(port);
+    sequencing::EventFanout<ExchangeEvent> fanout;
+    fanout.add_handler("md-bench", [&sink](const ExchangeEvent& event) { sink(event); });
+    fanout.start();
+
+    const auto start = std::chrono::steady_clock::now();
+    Result result = run_commands([&](const NewOrderCommand& command) {
+        engine.process(command, [&fanout](const ExchangeEvent& event) { fanout.claim() = event; });
+        fanout.publish();
+    });
+    fanout.stop();
+    result.drained_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.stalls = fanout.producer_stalls();
+    return result;
+}
+
+double percentile(const std::vector<double>& sorted, double p) {
+    return sorted[static_cast<std::size_t>(p * static_cast<double>(sorted.size() - 1))];
+}
+
+} // namespace
+
+int main() {
+    net::UdpReceiver receiver(0); // holds the port the sends go to; never read, the kernel drops the overflow
+    const std::uint16_t port = *receiver.local_port();
+
+    std::printf("%zu commands (maker/taker pairs), market data sent over loopback UDP, ns/command on the "
+                "matching thread\n",
+                kCommands);
+    std::printf("  %-7s %8s %8s %8s %8s %14s %8s\n", "arm", "p50", "p99", "p99.9", "mean", "drained cmd/s",
+                "stalls");
+    for (const bool ring : {false, true}) {
+        Result result = ring ? run_ring(port) : run_inline(port);
+        std::sort(result.ns.begin(), result.ns.end());
+        double sum = 0;
+        for (const double ns : result.ns) {
+            sum += ns;
+        }
+        std::printf("  %-7s %8.0f %8.0f %8.0f %8.0f %14.0f %8zu\n", ring ? "ring" : "inline",
+                    percentile(result.ns, 0.50), percentile(result.ns, 0.99), percentile(result.ns, 0.999),
+                    sum / static_cast<double>(result.ns.size()),
+                    static_cast<double>(kCommands) / result.drained_seconds, result.stalls);
+    }
+    return EXIT_SUCCESS;
+}
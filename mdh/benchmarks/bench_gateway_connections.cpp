@@ -0,0 +1,234 @@
+// What a thousand sessions cost the order-entry gateway, served by a thread
+// pair per connection against a fixed set of epoll or io_uring event loops
+// (OrderEntryGatewayOptions::io_threads and io_backend).
+//
+// A real gateway over loopback TCP, risk, ledger and matching included.
+// kSessions clients connect, each as its own account, and then trade in
+// rounds: every client sends one resting NewOrder, and the round ends when
+// every client has read its Accepted back -- kSessions orders in flight at
+// once, spread across every connection, which is the load that turns a
+// thread per connection into context switches. The client side is one
+// thread over a net::Poller of its own, so it adds the same one thread to
+// both arms.
+//
+//   threads  io_threads = 0: an accept thread, and a reader and a writer
+//            thread per connection.
+//   epoll    io_threads = kIoThreads: that many event loops, whatever the
+//            number of connections.
+//   io_uring the same loops over io_uring: a multishot recv per connection
+//            into shared provided buffers, and every send of a turn
+//            submitted with the one io_uring_enter() the loop waits in. If
+//            the kernel will not have it, the gateway falls back to epoll
+//            and the arm says so.
+//
+// Reported per arm: orders per second over every round after the first,
+// the median round -- one order from every session and every reply back --
+// the gateway's thread count once everybody has connected, i.e. the
+// process's threads less the client's and the ones it had before the
+// gateway started, and its system calls per message in or out
+// (OrderEntryGateway::io_stats()).
+//
+// Standalone, like bench_end_to_end_latency.cpp: it runs its own client
+// thread and a gateway per arm, neither of which fits a benchmark::State
+// loop. Needs a file descriptor limit over 2 * kSessions plus change. Run
+// from a Release build only.
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "exchange/gateway/order_entry_gateway.hpp"
+#include "net/poller.hpp"
+#include "net/tcp_socket.hpp"
+#include "protocol/order_entry/decoder.hpp"
+#include "protocol/order_entry/encoder.hpp"
+
+using namespace mdh;
+using namespace mdh::exchange;
+using namespace mdh::exchange::gateway;
+using namespace mdh::protocol::order_entry;
+using namespace std::chrono_literals;
+
+namespace {
+
+constexpr std::size_t kSessions = 1'000;
+constexpr std::size_t kRounds = 50;
+constexpr std::size_t kIoThreads = 2;
+constexpr InstrumentId kInstrument = 1;
+
+std::size_t thread_count() {
+    std::size_t count = 0;
+    for ([[maybe_unused]] const auto& entry : std::filesystem::directory_iterator("/proc/self/task")) {
+        ++count;
+    }
+    return count;
+}
+
+struct Session {
+    net::TcpSocket socket;
+    std::vector<std::byte> inbound;
+    std::size_t replies = 0; // Accepted frames read so far
+};
+
+// Reads whatever `session` has, to WouldBlock, counting whole frames.
+void read_replies(Session& session) {
+    std::array<std::byte, 4096> chunk{};
+    while (true) {
+        const auto result = session.socket.try_read(chunk);
+        if (result.status != net::TcpSocket::IoStatus::Done || result.bytes == 0) {
+            break;
+        }
+        session.inbound.insert(session.inbound.end(), chunk.begin(),
+                               chunk.begin() + static_cast<std::ptrdiff_t>(result.bytes));
+    }
+    std::size_t offset = 0;
+    while (true) {
+        auto header = decode_header(std::span(session.inbound).subspan(offset));
+        const auto* parsed = std::get_if<Header>(&header);
+        if (parsed == nullptr || session.inbound.size() - offset < HEADER_SIZE + parsed->payload_size) {
+            break;
+        }
+        offset += HEADER_SIZE + parsed->payload_size;
+        ++session.replies;
+    }
+    session.inbound.erase(session.inbound.begin(), session.inbound.begin() + static_cast<std::ptrdiff_t>(offset));
+}
+
+void send_all(net::TcpSocket& socket, std::span<const std::byte> bytes) {
+    std::size_t written = 0;
+    while (written < bytes.size()) {
+        const auto result = socket.try_write(bytes.subspan(written));
+        if (result.status == net::TcpSocket::IoStatus::Done) {
+            written += result.bytes;
+        }
+    }
+}
+
+struct Result {
+    double orders_per_second = 0;
+    double median_round_ms = 0;
+    std::size_t gateway_threads = 0;
+    double syscalls_per_message = 0;
+    GatewayIoBackend backend = GatewayIoBackend::Threads;
+    bool complete = true;
+};
+
+Result run(GatewayIoBackend backend) {
+    const std::size_t threads_before = thread_count();
+
+    OrderEntryGatewayOptions options;
+    options.instruments = {kInstrument};
+    options.io_threads = backend == GatewayIoBackend::Threads ? 0 : kIoThreads;
+    options.io_backend = backend;
+    options.accept_backlog = static_cast<int>(kSessions);
+    options.matching_queue_capacity = 2 * kSessions;
+    options.outbound_queue_capacity = 64; // one reply per round; two queues each for a thousand sessions add up
+    options.expected_resting_orders = kSessions * kRounds;
+    OrderEntryGateway gateway(0, options);
+    for (AccountId account = 1; account <= kSessions; ++account) {
+        gateway.deposit_cash(account, 1'000'000'000);
+    }
+    if (!gateway.start()) {
+        std::fprintf(stderr, "gateway failed to start\n");
+        std::exit(EXIT_FAILURE);
+    }
+
+    net::Poller poller;
+    std::vector<std::unique_ptr<Session>> sessions;
+    for (std::size_t i = 0; i < kSessions; ++i) {
+        auto session = std::make_unique<Session>();
+        if (!session->socket.connect("127.0.0.1", *gateway.local_port())) {
+            std::fprintf(stderr, "connect %zu failed (file descriptor limit?)\n", i);
+            std::exit(EXIT_FAILURE);
+        }
+        session->socket.set_non_blocking();
+        (void)poller.add(session->socket.raw_fd(), i, false);
+        sessions.push_back(std::move(session));
+    }
+    while (gateway.connection_count() < kSessions) {
+        std::this_thread::sleep_for(1ms);
+    }
+
+    Result result;
+    result.gateway_threads = thread_count() - threads_before;
+    result.backend = gateway.io_backend();
+
+    std::vector<double> round_ms;
+    std::array<net::PollEvent, net::Poller::kMaxEvents> events{};
+    std::vector<std::byte> frame;
+    std::chrono::steady_clock::time_point timed_from;
+    for (std::size_t round = 0; round < kRounds; ++round) {
+        const auto start = std::chrono::steady_clock::now();
+        if (round == 1) {
+            timed_from = start; // round 0 warms every connection's path up
+        }
+        for (std::size_t i = 0; i < kSessions; ++i) {
+            frame.clear();
+            encode_message(Message{NewOrder{.account_id = static_cast<AccountId>(i + 1),
+                                            .client_order_id = round + 1,
+                                            .instrument_id = kInstrument,
+                                            .side = Side::Buy,
+                                            .price = 100,
+                                            .quantity = 1,
+                                            .order_type = OrderType::Limit,
+                                            .time_in_force = TimeInForce::GTC}},
+                           frame);
+            send_all(sessions[i]->socket, frame);
+        }
+
+        std::size_t waiting = kSessions;
+        const auto deadline = start + 10s;
+        while (waiting > 0 && std::chrono::steady_clock::now() < deadline) {
+            const std::size_t n = poller.wait(events, 100ms);
+            for (std::size_t e = 0; e < n; ++e) {
+                Session& session = *sessions[events[e].key];
+                const bool was_waiting = session.replies <= round;
+                read_replies(session);
+                if (was_waiting && session.replies > round) {
+                    --waiting;
+                }
+            }
+        }
+        if (waiting > 0) {
+            result.complete = false; // a reply was dropped on a full queue, or the gateway fell over
+            break;
+        }
+        round_ms.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - timed_from).count();
+    result.orders_per_second = static_cast<double>(kSessions * (kRounds - 1)) / seconds;
+    std::sort(round_ms.begin(), round_ms.end());
+    result.median_round_ms = round_ms.empty() ? 0 : round_ms[round_ms.size() / 2];
+
+    result.syscalls_per_message = gateway.io_stats().syscalls_per_message();
+    sessions.clear();
+    gateway.stop();
+    return result;
+}
+
+} // namespace
+
+int main() {
+    std::printf("%zu sessions, %zu rounds of one resting NewOrder per session, loopback TCP\n", kSessions, kRounds);
+    std::printf("  %-8s %12s %16s %16s %14s\n", "arm", "orders/s", "median round ms", "gateway threads",
+                "syscalls/msg");
+    const std::pair<const char*, GatewayIoBackend> arms[] = {
+        {"threads", GatewayIoBackend::Threads},
+        {"epoll", GatewayIoBackend::Epoll},
+        {"io_uring", GatewayIoBackend::IoUring},
+    };
+    for (const auto& [name, backend] : arms) {
+        const Result result = run(backend);
+        std::printf("  %-8s %12.0f %16.2f %16zu %14.2f%s%s\n", name, result.orders_per_second, result.median_round_ms,
+                    result.gateway_threads, result.syscalls_per_message, result.complete ? "" : "  (incomplete)",
+                    result.backend == backend ? "" : "  (unavailable here; fell back)");
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,260 @@
+// What a burst of execution reports to one client costs the order-entry
+// gateway's write side: throughput on that one connection, system calls per
+// report, and heap allocations per report.
+//
+// A real gateway over loopback TCP. A maker rests kFills single-lot asks,
+// then a taker lifts them all with one bid, and matching emits kFills fills
+// to each of the two connections at once -- the burst a large aggressive
+// order produces. Each round is timed from the taker's send to the maker
+// reading its last fill, and repeated kRounds times after a warm-up round.
+//
+//   per report  write_flush_bytes = 1: every report encoded and written on
+//               its own, as a writer thread did before output was
+//               coalesced.
+//   coalesced   the default: encoded back to back into the connection's
+//               write buffer, written once the queues run dry or
+//               write_flush_bytes have built up.
+//   linger      the same with write_linger = kLinger, so reports routed
+//               just after the queues ran dry still share a write.
+//   epoll       the default under one epoll event loop, which writes once
+//               per turn.
+//   no ring     the default with event_ring_capacity = 0, so the matching
+//               thread routes every fill itself before matching on: the
+//               arm where what routing costs per event is matching's cost.
+//
+// Reported per arm: fills per second to the maker's connection (median
+// round), and over the timed bursts alone, from the taker's send to its
+// last fill read, the gateway's system calls per report
+// (OrderEntryGateway::io_stats()) and heap allocations per report. The
+// allocations are every operator new in the process, gateway threads and
+// this client alike -- deliberately the whole path, routing and matching
+// included, so that zero means no report allocates anywhere between the
+// book and the socket.
+//
+// Standalone, like bench_gateway_connections.cpp, and a separate binary
+// because it replaces the global operator new, as bench_matching_memory.cpp
+// does. Run from a Release build only.
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "exchange/gateway/order_entry_gateway.hpp"
+#include "net/tcp_socket.hpp"
+#include "protocol/order_entry/decoder.hpp"
+#include "protocol/order_entry/encoder.hpp"
+
+using namespace mdh;
+using namespace mdh::exchange;
+using namespace mdh::exchange::gateway;
+using namespace mdh::protocol::order_entry;
+using namespace std::chrono_literals;
+
+// ── Global allocation counter ──────────────────────────────────────────────
+//
+// Unlike bench_matching_memory's, this process is multi-threaded, so the
+// count is atomic. Relaxed is enough: it is only read once the round it
+// covers has visibly finished.
+namespace {
+std::atomic<std::uint64_t> g_allocations{0};
+} // namespace
+
+void* operator new(std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size) { return ::operator new(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size == 0 ? 1 : size);
+}
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept { return ::operator new(size, tag); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+
+namespace {
+
+constexpr std::size_t kFills = 1'000;
+constexpr std::size_t kRounds = 20;
+constexpr auto kLinger = 50us;
+constexpr InstrumentId kInstrument = 1;
+constexpr AccountId kMaker = 1;
+constexpr AccountId kTaker = 2;
+
+// A blocking client connection that counts whole frames as they arrive.
+// Its buffer is reserved up front and compacted in place, so reading adds
+// nothing to the allocation count.
+class Client {
+public:
+    explicit Client(std::uint16_t port) {
+        if (!socket_.connect("127.0.0.1", port)) {
+            std::fprintf(stderr, "connect failed\n");
+            std::exit(EXIT_FAILURE);
+        }
+        inbound_.reserve(1 << 20);
+    }
+
+    void send(const Message& message) {
+        frame_.clear();
+        encode_message(message, frame_);
+        std::size_t written = 0;
+        while (written < frame_.size()) {
+            const auto n = socket_.write(std::span(frame_).subspan(written));
+            if (!n) {
+                std::fprintf(stderr, "write failed\n");
+                std::exit(EXIT_FAILURE);
+            }
+            written += *n;
+        }
+    }
+
+    // Reads until `frames` more whole frames have arrived.
+    void await(std::size_t frames) {
+        std::size_t seen = 0;
+        while (true) {
+            std::size_t offset = 0;
+            while (seen < frames) {
+                auto header = decode_header(std::span(inbound_).subspan(offset));
+                const auto* parsed = std::get_if<Header>(&header);
+                if (parsed == nullptr || inbound_.size() - offset < HEADER_SIZE + parsed->payload_size) {
+                    break;
+                }
+                offset += HEADER_SIZE + parsed->payload_size;
+                ++seen;
+            }
+            inbound_.erase(inbound_.begin(), inbound_.begin() + static_cast<std::ptrdiff_t>(offset));
+            if (seen == frames) {
+                return;
+            }
+            const auto n = socket_.read(chunk_);
+            if (!n || *n == 0) {
+                std::fprintf(stderr, "connection lost\n");
+                std::exit(EXIT_FAILURE);
+            }
+            inbound_.insert(inbound_.end(), chunk_.begin(), chunk_.begin() + static_cast<std::ptrdiff_t>(*n));
+        }
+    }
+
+private:
+    net::TcpSocket socket_;
+    std::vector<std::byte> frame_;
+    std::vector<std::byte> inbound_;
+    std::array<std::byte, 64 * 1024> chunk_{};
+};
+
+NewOrder order(AccountId account, ClientOrderId id, Side side, Quantity quantity) {
+    return NewOrder{.account_id = account,
+                    .client_order_id = id,
+                    .instrument_id = kInstrument,
+                    .side = side,
+                    .price = 100,
+                    .quantity = quantity,
+                    .order_type = OrderType::Limit,
+                    .time_in_force = TimeInForce::GTC};
+}
+
+struct Result {
+    double fills_per_second = 0;
+    double syscalls_per_report = 0;
+    double allocations_per_report = 0;
+    GatewayIoBackend backend = GatewayIoBackend::Threads;
+};
+
+Result run(OrderEntryGatewayOptions options) {
+    options.instruments = {kInstrument};
+    options.outbound_queue_capacity = 2 * kFills; // the whole burst fits: nothing dropped
+    options.matching_queue_capacity = 2 * kFills;
+    options.expected_resting_orders = kFills;
+    OrderEntryGateway gateway(0, options);
+    gateway.deposit_position(kMaker, kInstrument, kFills * (kRounds + 1));
+    gateway.deposit_cash(kTaker, 1'000'000'000);
+    if (!gateway.start()) {
+        std::fprintf(stderr, "gateway failed to start\n");
+        std::exit(EXIT_FAILURE);
+    }
+    Client maker(*gateway.local_port());
+    Client taker(*gateway.local_port());
+
+    std::vector<double> round_seconds;
+    std::uint64_t syscalls = 0;
+    std::uint64_t messages_out = 0;
+    std::uint64_t allocations = 0;
+    ClientOrderId next_id = 1;
+    for (std::size_t round = 0; round <= kRounds; ++round) {
+        for (std::size_t i = 0; i < kFills; ++i) {
+            maker.send(Message{order(kMaker, next_id++, Side::Sell, 1)});
+        }
+        maker.await(kFills); // every Accepted
+
+        // Round 0 is a warm-up: it grows every buffer and queue to size.
+        const GatewayIoStats stats_before = gateway.io_stats();
+        const std::uint64_t allocations_before = g_allocations.load(std::memory_order_relaxed);
+        const auto start = std::chrono::steady_clock::now();
+        taker.send(Message{order(kTaker, round + 1, Side::Buy, kFills)});
+        maker.await(kFills); // every fill
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        taker.await(kFills + 1); // its Accepted and every fill, so the next round starts clean
+        if (round > 0) {
+            const std::uint64_t allocations_after = g_allocations.load(std::memory_order_relaxed);
+            const GatewayIoStats stats_after = gateway.io_stats();
+            round_seconds.push_back(std::chrono::duration<double>(elapsed).count());
+            allocations += allocations_after - allocations_before;
+            syscalls += stats_after.syscalls - stats_before.syscalls;
+            messages_out += stats_after.messages_out - stats_before.messages_out;
+        }
+    }
+
+    Result result;
+    std::sort(round_seconds.begin(), round_seconds.end());
+    result.fills_per_second = static_cast<double>(kFills) / round_seconds[round_seconds.size() / 2];
+    result.syscalls_per_report = static_cast<double>(syscalls) / static_cast<double>(messages_out);
+    result.allocations_per_report = static_cast<double>(allocations) / static_cast<double>(messages_out);
+    result.backend = gateway.io_backend();
+    gateway.stop();
+    return result;
+}
+
+} // namespace
+
+int main() {
+    std::printf("%zu fills to each of two connections per round, %zu rounds, loopback TCP\n", kFills, kRounds);
+    std::printf("  %-11s %14s %16s %14s\n", "arm", "fills/s", "syscalls/report", "allocs/report");
+
+    OrderEntryGatewayOptions per_report;
+    per_report.write_flush_bytes = 1;
+    OrderEntryGatewayOptions coalesced;
+    OrderEntryGatewayOptions linger;
+    linger.write_linger = kLinger;
+    OrderEntryGatewayOptions epoll;
+    epoll.io_threads = 1;
+    OrderEntryGatewayOptions no_ring;
+    no_ring.event_ring_capacity = 0;
+    const std::pair<const char*, OrderEntryGatewayOptions> arms[] = {
+        {"per report", per_report},
+        {"coalesced", coalesced},
+        {"linger", linger},
+        {"epoll", epoll},
+        {"no ring", no_ring},
+    };
+    for (const auto& [name, options] : arms) {
+        const Result result = run(options);
+        std::printf("  %-11s %14.0f %16.3f %14.3f%s\n", name, result.fills_per_second, result.syscalls_per_report,
+                    result.allocations_per_report,
+                    result.backend == options.io_backend || options.io_threads == 0 ? "" : "  (fell back)");
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,207 @@
+// Pulling one account out of the market: 100,000 resting orders spread over
+// eight books, cancelled three ways against an in-process MatchingEngine.
+//
+//   1. 100,000 CancelOrderCommands, one per order -- what a client had to
+//      send before MassCancel existed, each paying its own visit, directory
+//      lookup and book removal.
+//   2. One MassCancelCommand. The engine walks the account's chain in each
+//      book, so the cost is the account's orders and not the books': a
+//      second account rests just as many orders alongside and is never
+//      touched.
+//   3. The same MassCancelCommand with max_orders set to the gateway's
+//      default mass_cancel_batch, sent again until one comes up short --
+//      what OrderEntryGateway does, less the queue trip between batches.
+//
+// Every arm emits the same events (one OrderCancelled and one
+// BookOrderRemoved per order), into a sink that only counts them, so what
+// is timed is the matching side alone. How long every other account waits
+// behind a mass cancel on the matching thread is its longest single
+// command: all of arm 2, one batch of arm 3. Those are printed on their
+// own.
+//
+// The book is rebuilt before every round and the rebuild is not timed.
+// Standalone rather than a Google Benchmark case for the same reason as
+// bench_mass_quote.cpp: the per-round samples are wanted. Run from a
+// Release build only.
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <optional>
+#include <vector>
+
+#include "exchange/gateway/order_entry_gateway.hpp"
+#include "exchange/matching/matching_engine.hpp"
+
+using namespace mdh;
+using namespace mdh::exchange;
+
+namespace {
+
+constexpr std::size_t kOrders = 100'000;
+constexpr InstrumentId kInstruments = 8;
+constexpr AccountId kLeaving = 1;
+constexpr AccountId kStaying = 2;
+constexpr int kRounds = 7;
+
+struct CountingSink {
+    std::size_t* events;
+    void operator()(const ExchangeEvent&) const { ++*events; }
+};
+
+// kOrders for each account, interleaved so the two accounts' orders share
+// every price level and neither's sits in a contiguous run of the slab.
+// Bids and asks either side of a fixed mid, so nothing crosses.
+void seed(MatchingEngine& engine, CommandSequence& sequence) {
+    std::size_t events = 0;
+    for (std::size_t i = 0; i < kOrders; ++i) {
+        const InstrumentId instrument = static_cast<InstrumentId>(i % kInstruments) + 1;
+        const bool buy = (i / kInstruments) % 2 == 0;
+        const Price price = buy ? 1'000 - static_cast<Price>(i % 50) : 1'001 + static_cast<Price>(i % 50);
+        for (const AccountId account : {kLeaving, kStaying}) {
+            engine.process(NewOrderCommand{.command_sequence = ++sequence,
+                                           .account_id = account,
+                                           .client_order_id = i + 1,
+                                           .instrument_id = instrument,
+                                           .side = buy ? Side::Buy : Side::Sell,
+                                           .price = price,
+                                           .quantity = 1,
+                                           .order_type = OrderType::Limit,
+                                           .time_in_force = TimeInForce::GTC},
+                           CountingSink{&events});
+        }
+    }
+}
+
+[[nodiscard]] std::vector<InstrumentId> universe() {
+    std::vector<InstrumentId> ids;
+    for (InstrumentId id = 1; id <= kInstruments; ++id) ids.push_back(id);
+    return ids;
+}
+
+struct Sample {
+    double ns;
+    std::size_t events;
+    double longest_ns = 0; // the longest single command
+};
+
+Sample one_by_one() {
+    const std::vector<InstrumentId> ids = universe();
+    MatchingEngine engine(ids, 2 * kOrders);
+    CommandSequence sequence = 0;
+    seed(engine, sequence);
+
+    std::size_t events = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < kOrders; ++i) {
+        engine.process(CancelOrderCommand{.command_sequence = ++sequence,
+                                          .account_id = kLeaving,
+                                          .client_order_id = i + 1,
+                                          .instrument_id = static_cast<InstrumentId>(i % kInstruments) + 1},
+                       CountingSink{&events});
+    }
+    const auto stop = std::chrono::steady_clock::now();
+    return {std::chrono::duration<double, std::nano>(stop - start).count(), events};
+}
+
+Sample all_at_once() {
+    const std::vector<InstrumentId> ids = universe();
+    MatchingEngine engine(ids, 2 * kOrders);
+    CommandSequence sequence = 0;
+    seed(engine, sequence);
+
+    std::size_t events = 0;
+    const auto start = std::chrono::steady_clock::now();
+    engine.process(MassCancelCommand{.command_sequence = ++sequence,
+                                     .account_id = kLeaving,
+                                     .instrument_id = std::nullopt,
+                                     .side = std::nullopt},
+                   CountingSink{&events});
+    const auto stop = std::chrono::steady_clock::now();
+    const double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+    return {ns, events, ns};
+}
+
+Sample in_batches() {
+    const std::vector<InstrumentId> ids = universe();
+    MatchingEngine engine(ids, 2 * kOrders);
+    CommandSequence sequence = 0;
+    seed(engine, sequence);
+
+    const std::uint32_t batch = gateway::OrderEntryGatewayOptions{}.mass_cancel_batch;
+    std::size_t events = 0;
+    double total = 0;
+    double longest = 0;
+    while (true) {
+        const std::size_t before = events;
+        const auto start = std::chrono::steady_clock::now();
+        engine.process(MassCancelCommand{.command_sequence = ++sequence,
+                                         .account_id = kLeaving,
+                                         .instrument_id = std::nullopt,
+                                         .side = std::nullopt,
+                                         .max_orders = batch},
+                       CountingSink{&events});
+        const auto stop = std::chrono::steady_clock::now();
+        const double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+        total += ns;
+        longest = std::max(longest, ns);
+        if ((events - before) / 2 < batch) {
+            break;
+        }
+    }
+    return {total, events, longest};
+}
+
+double median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+} // namespace
+
+int main() {
+    std::vector<double> single_ns;
+    std::vector<double> mass_ns;
+    std::vector<double> batched_ns;
+    std::vector<double> batch_longest_ns;
+    std::size_t single_events = 0;
+    std::size_t mass_events = 0;
+    std::size_t batched_events = 0;
+    for (int round = 0; round < kRounds; ++round) {
+        const Sample single = one_by_one();
+        const Sample mass = all_at_once();
+        const Sample batched = in_batches();
+        single_ns.push_back(single.ns);
+        mass_ns.push_back(mass.ns);
+        batched_ns.push_back(batched.ns);
+        batch_longest_ns.push_back(batched.longest_ns);
+        single_events = single.events;
+        mass_events = mass.events;
+        batched_events = batched.events;
+    }
+    if (single_events != mass_events || mass_events != batched_events || mass_events != 2 * kOrders) {
+        std::fprintf(stderr, "arms disagree: %zu events one by one, %zu from a mass cancel, %zu in batches\n",
+                     single_events, mass_events, batched_events);
+        return EXIT_FAILURE;
+    }
+
+    const double single = median(single_ns);
+    const double mass = median(mass_ns);
+    const double batched = median(batched_ns);
+    const double batch_longest = median(batch_longest_ns);
+    std::printf("cancelling %zu resting orders of one account (another rests as many alongside), "
+                "median of %d rounds\n",
+                kOrders, kRounds);
+    std::printf("  %zu CancelOrderCommands   %10.2f ms  %7.1f ns/order\n", kOrders, single / 1e6,
+                single / static_cast<double>(kOrders));
+    std::printf("  1 MassCancelCommand        %10.2f ms  %7.1f ns/order\n", mass / 1e6,
+                mass / static_cast<double>(kOrders));
+    std::printf("  MassCancelCommands of %-5u %10.2f ms  %7.1f ns/order\n",
+                gateway::OrderEntryGatewayOptions{}.mass_cancel_batch, batched / 1e6,
+                batched / static_cast<double>(kOrders));
+    std::printf("  speedup                    %10.2fx (one mass cancel over single cancels)\n", single / mass);
+    std::printf("  longest single visit -- the stall every other account sees:\n");
+    std::printf("    one mass cancel          %10.3f ms\n", mass / 1e6);
+    std::printf("    one batch of it          %10.3f ms\n", batch_longest / 1e6);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,347 @@
+// Requote throughput -- a market maker moving a ten-level-a-side ladder by
+// one tick, sent to a real, fully-wired OrderEntryGateway over loopback TCP,
+// two ways:
+//
+//   1. Twenty ReplaceOrders, one per level, each repricing its level in
+//      place. This is what a client had to do before MassQuote existed, and
+//      every one of them pays its own decode, risk check, sequencer step,
+//      queue slot and matching-thread visit.
+//   2. One MassQuote carrying the whole new ladder. The engine pairs the
+//      nine levels per side whose price did not move with their standing
+//      orders, cancels the one that fell off the back and enters the one
+//      that appeared at the front -- all in one visit.
+//
+// Both arms are closed loop: send the requote, wait for every report it
+// produces, repeat. Reports are still one per level (20 Replaced for arm 1;
+// 18 Replaced + 2 Cancelled + 2 Accepted for arm 2), so this measures what
+// collapsing the *inbound* side buys, with the outbound fan-out left as it
+// was. The ladder ping-pongs between two mid prices so the book is the same
+// shape at the start of every round and nothing accumulates across a run.
+//
+// The gateway round trip is dominated by thread handoffs and wakeups (see
+// bench_end_to_end_latency.cpp's transport floor), which both arms pay once
+// per requote, so a second pair of arms times only the matching-thread side
+// of the same requotes -- RiskGatedEngine over a MatchingEngine and Ledger,
+// in process, which is where the per-command overhead this command removes
+// actually lives.
+//
+// Standalone rather than a Google Benchmark case for the same reason as
+// bench_end_to_end_latency.cpp: the per-round samples are wanted, not just
+// a mean. Run from a Release build only.
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "exchange/gateway/order_entry_gateway.hpp"
+#include "exchange/ledger/ledger.hpp"
+#include "exchange/matching/matching_engine.hpp"
+#include "exchange/risk/risk_gated_engine.hpp"
+#include "net/tcp_socket.hpp"
+#include "protocol/order_entry/decoder.hpp"
+#include "protocol/order_entry/encoder.hpp"
+
+using namespace mdh;
+using namespace mdh::exchange;
+using namespace mdh::exchange::gateway;
+using namespace mdh::net;
+using namespace mdh::protocol::order_entry;
+using namespace std::chrono_literals;
+
+namespace {
+
+constexpr InstrumentId kInstrument = 1;
+constexpr AccountId kAccount = 1;
+constexpr std::size_t kLevelsPerSide = 10;
+constexpr std::size_t kLevels = 2 * kLevelsPerSide;
+constexpr Price kMid = 1'000;
+
+// Same client shape as bench_end_to_end_latency.cpp's LatencyClient, except
+// that send() can put several frames on the wire in one write -- arm 1
+// pipelines its twenty replaces rather than paying a round trip for each,
+// which is the most charitable way to send them and so the fairer baseline.
+class QuoteClient {
+public:
+    [[nodiscard]] bool connect_to(std::uint16_t port) {
+        if (!socket_.connect("127.0.0.1", port)) return false;
+        socket_.set_non_blocking();
+        return true;
+    }
+
+    void send(std::span<const Message> messages) {
+        std::vector<std::byte> buf;
+        for (const Message& message : messages) {
+            encode_message(message, buf);
+        }
+        std::size_t written = 0;
+        while (written < buf.size()) {
+            auto n = socket_.write(std::span(buf).subspan(written));
+            if (n) {
+                written += *n;
+            } else {
+                std::this_thread::sleep_for(1ms);
+            }
+        }
+    }
+
+    [[nodiscard]] std::optional<Message> receive(std::chrono::milliseconds timeout) {
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (true) {
+            if (auto message = try_decode_one()) return message;
+            if (std::chrono::steady_clock::now() >= deadline) return std::nullopt;
+            std::array<std::byte, 4096> chunk{};
+            if (auto n = socket_.read(chunk); n && *n > 0) {
+                buffer_.insert(buffer_.end(), chunk.begin(), chunk.begin() + static_cast<std::ptrdiff_t>(*n));
+            }
+        }
+    }
+
+    // Drains exactly `count` reports, failing on a rejection or a timeout:
+    // a requote that was partly refused would make the two arms incomparable.
+    [[nodiscard]] bool expect_reports(std::size_t count) {
+        for (std::size_t i = 0; i < count; ++i) {
+            auto message = receive(1000ms);
+            if (!message.has_value() || std::holds_alternative<Rejected>(*message)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    [[nodiscard]] std::optional<Message> try_decode_one() {
+        auto header_result = decode_header(buffer_);
+        const auto* header = std::get_if<Header>(&header_result);
+        if (!header) return std::nullopt;
+        const std::size_t frame_size = HEADER_SIZE + header->payload_size;
+        if (buffer_.size() < frame_size) return std::nullopt;
+        auto message_result = decode_message(std::span(buffer_).first(frame_size));
+        buffer_.erase(buffer_.begin(), buffer_.begin() + static_cast<std::ptrdiff_t>(frame_size));
+        const auto* message = std::get_if<Message>(&message_result);
+        return message ? std::optional<Message>(*message) : std::nullopt;
+    }
+
+    TcpSocket socket_;
+    std::vector<std::byte> buffer_;
+};
+
+// Level `i` of the ladder around `mid`: bids below it, offers above, the
+// nearest level first on each side.
+MassQuoteEntry level(Price mid, std::size_t i, ClientOrderId client_order_id) {
+    const auto depth = static_cast<Price>(i % kLevelsPerSide) + 1;
+    const bool bid = i < kLevelsPerSide;
+    return MassQuoteEntry{.client_order_id = client_order_id,
+                          .side = bid ? Side::Buy : Side::Sell,
+                          .price = bid ? mid - depth : mid + depth,
+                          .quantity = 10};
+}
+
+// The mid of round `round`: alternates between kMid and kMid + 1.
+Price mid_of(std::size_t round) { return kMid + static_cast<Price>(round % 2); }
+
+// Client order ids of round `round`'s ladder -- fresh every round, since a
+// replace must name a new id and a mass quote may.
+ClientOrderId id_of(std::size_t round, std::size_t i) { return 1 + (round * kLevels) + i; }
+
+struct Arm {
+    std::vector<Message> (*requote)(std::size_t round);
+    std::size_t reports_per_requote;
+};
+
+std::vector<Message> replace_every_level(std::size_t round) {
+    std::vector<Message> messages;
+    messages.reserve(kLevels);
+    for (std::size_t i = 0; i < kLevels; ++i) {
+        const MassQuoteEntry target = level(mid_of(round), i, id_of(round, i));
+        messages.push_back(Message{ReplaceOrder{.account_id = kAccount,
+                                                .original_client_order_id = id_of(round - 1, i),
+                                                .new_client_order_id = target.client_order_id,
+                                                .instrument_id = kInstrument,
+                                                .new_price = target.price,
+                                                .new_quantity = target.quantity}});
+    }
+    return messages;
+}
+
+std::vector<Message> one_mass_quote(std::size_t round) {
+    MassQuote quote{.account_id = kAccount, .instrument_id = kInstrument, .entries = {}};
+    for (std::size_t i = 0; i < kLevels; ++i) {
+        quote.entries.push_back(level(mid_of(round), i, id_of(round, i)));
+    }
+    return {Message{std::move(quote)}};
+}
+
+// Seeds the ladder at round 0 with one MassQuote (so both arms start from
+// the identical book), then times `rounds` requotes. Returns the per-round
+// samples sorted, or empty on any failure.
+[[nodiscard]] std::vector<double> measure(const Arm& arm, std::size_t rounds) {
+    OrderEntryGatewayOptions options;
+    options.instruments = {kInstrument};
+    OrderEntryGateway gateway(0, std::move(options));
+    if (!gateway.start()) {
+        std::fprintf(stderr, "failed to start gateway\n");
+        return {};
+    }
+    gateway.deposit_cash(kAccount, 1'000'000'000'000LL);
+    gateway.deposit_position(kAccount, kInstrument, 1'000'000'000);
+
+    QuoteClient client;
+    if (!client.connect_to(*gateway.local_port())) {
+        std::fprintf(stderr, "failed to connect to gateway\n");
+        return {};
+    }
+    const auto seed = one_mass_quote(0);
+    client.send(seed);
+    if (!client.expect_reports(kLevels)) {
+        std::fprintf(stderr, "seeding the ladder failed\n");
+        return {};
+    }
+
+    // Warm-up rounds are the first 100 of the run and are not recorded.
+    constexpr std::size_t kWarmup = 100;
+    std::vector<double> samples_ns;
+    samples_ns.reserve(rounds);
+    for (std::size_t round = 1; round <= kWarmup + rounds; ++round) {
+        const auto messages = arm.requote(round);
+        const auto start = std::chrono::steady_clock::now();
+        client.send(messages);
+        if (!client.expect_reports(arm.reports_per_requote)) {
+            std::fprintf(stderr, "requote %zu was not fully acknowledged -- aborting\n", round);
+            return {};
+        }
+        const auto end = std::chrono::steady_clock::now();
+        if (round > kWarmup) {
+            samples_ns.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+        }
+    }
+    gateway.stop();
+    std::sort(samples_ns.begin(), samples_ns.end());
+    return samples_ns;
+}
+
+// The same requotes as commands, for the in-process arms.
+ExchangeCommand to_command(const Message& message) {
+    if (const auto* replace = std::get_if<ReplaceOrder>(&message)) {
+        return ReplaceOrderCommand{.command_sequence = 0,
+                                   .account_id = replace->account_id,
+                                   .original_client_order_id = replace->original_client_order_id,
+                                   .new_client_order_id = replace->new_client_order_id,
+                                   .instrument_id = replace->instrument_id,
+                                   .new_price = replace->new_price,
+                                   .new_quantity = replace->new_quantity};
+    }
+    const auto& quote = std::get<MassQuote>(message);
+    MassQuoteCommand command{
+        .command_sequence = 0, .account_id = quote.account_id, .instrument_id = quote.instrument_id, .entries = {}};
+    for (const MassQuoteEntry& entry : quote.entries) {
+        command.entries.push_back(QuoteEntry{.client_order_id = entry.client_order_id,
+                                             .side = entry.side,
+                                             .price = entry.price,
+                                             .quantity = entry.quantity});
+    }
+    return command;
+}
+
+// Matching-thread cost only: every round's commands are built before the
+// clock starts, then run back to back through the risk gate. Returns the
+// mean nanoseconds per requote, or a negative value if any level was
+// rejected.
+[[nodiscard]] double measure_in_process(const Arm& arm, std::size_t rounds) {
+    MatchingEngine engine({kInstrument});
+    ledger::Ledger ledger;
+    ledger.deposit_cash(kAccount, 1'000'000'000'000LL);
+    ledger.deposit_position(kAccount, kInstrument, 1'000'000'000);
+    risk::RiskGatedEngine gated(engine, ledger);
+
+    std::size_t rejected = 0;
+    auto sink = [&rejected](const ExchangeEvent& event) {
+        rejected += std::holds_alternative<OrderRejected>(event) ? 1 : 0;
+    };
+    gated.process(to_command(one_mass_quote(0).front()), sink);
+
+    std::vector<std::vector<ExchangeCommand>> commands(rounds);
+    for (std::size_t round = 1; round <= rounds; ++round) {
+        for (const Message& message : arm.requote(round)) {
+            commands[round - 1].push_back(to_command(message));
+        }
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    for (const auto& requote : commands) {
+        for (const ExchangeCommand& command : requote) {
+            gated.process(command, sink);
+        }
+    }
+    const auto end = std::chrono::steady_clock::now();
+    if (rejected != 0) {
+        std::fprintf(stderr, "%zu levels rejected in process -- aborting\n", rejected);
+        return -1.0;
+    }
+    return std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(rounds);
+}
+
+double percentile(const std::vector<double>& sorted_ns, double p) {
+    if (sorted_ns.empty()) return 0.0;
+    const auto rank = static_cast<std::size_t>(p * static_cast<double>(sorted_ns.size() - 1));
+    return sorted_ns[rank];
+}
+
+double report(const char* title, const std::vector<double>& sorted_ns) {
+    const double mean_ns = std::accumulate(sorted_ns.begin(), sorted_ns.end(), 0.0) / static_cast<double>(sorted_ns.size());
+    std::printf("\n%s\n", title);
+    std::printf("requotes:      %zu\n", sorted_ns.size());
+    std::printf("requotes/s:    %.0f\n", 1e9 / mean_ns);
+    std::printf("mean:          %.2f us\n", mean_ns / 1000.0);
+    std::printf("p50:           %.2f us\n", percentile(sorted_ns, 0.50) / 1000.0);
+    std::printf("p99:           %.2f us\n", percentile(sorted_ns, 0.99) / 1000.0);
+    return mean_ns;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::size_t rounds = 5'000;
+    if (argc > 1) {
+        rounds = static_cast<std::size_t>(std::atoll(argv[1]));
+    }
+
+    // 18 levels stay put and are renamed, 1 per side falls off, 1 per side
+    // is new.
+    const std::vector<double> mass_quote_ns =
+        measure(Arm{.requote = one_mass_quote, .reports_per_requote = kLevels + 2}, rounds);
+    const std::vector<double> replaces_ns =
+        measure(Arm{.requote = replace_every_level, .reports_per_requote = kLevels}, rounds);
+    if (mass_quote_ns.empty() || replaces_ns.empty()) {
+        return EXIT_FAILURE;
+    }
+
+    std::printf("mdh requote: %zu-level ladder moved one tick, closed loop, loopback TCP\n", kLevels);
+    const double replaces_mean = report("20 pipelined ReplaceOrders", replaces_ns);
+    const double mass_quote_mean = report("1 MassQuote", mass_quote_ns);
+    std::printf("\nspeed-up (mean): %.2fx\n", replaces_mean / mass_quote_mean);
+
+    // Many more rounds in process: each one is a few microseconds, not a
+    // millisecond.
+    const std::size_t in_process_rounds = rounds * 20;
+    const double in_process_replaces_ns = measure_in_process(
+        Arm{.requote = replace_every_level, .reports_per_requote = kLevels}, in_process_rounds);
+    const double in_process_mass_quote_ns =
+        measure_in_process(Arm{.requote = one_mass_quote, .reports_per_requote = kLevels + 2}, in_process_rounds);
+    if (in_process_replaces_ns < 0.0 || in_process_mass_quote_ns < 0.0) {
+        return EXIT_FAILURE;
+    }
+    std::printf("\nMatching thread only (risk gate + engine + ledger, in process, %zu requotes)\n", in_process_rounds);
+    std::printf("20 ReplaceOrders:  %8.0f ns/requote  %10.0f requotes/s\n", in_process_replaces_ns,
+                1e9 / in_process_replaces_ns);
+    std::printf("1 MassQuote:       %8.0f ns/requote  %10.0f requotes/s\n", in_process_mass_quote_ns,
+                1e9 / in_process_mass_quote_ns);
+    std::printf("speed-up:          %.2fx\n", in_process_replaces_ns / in_process_mass_quote_ns);
+    return EXIT_SUCCESS;
+}
@@ -48,12 +48,14 @@
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <span>
 #include <string>
 #include <vector>
 
 #include <benchmark/benchmark.h>
 
 #include "exchange/matching/matching_engine.hpp"
+#include "exchange/persistence/state_hash.hpp"
 #include "exchange/testing/matching_scenarios.hpp"
 
 using namespace mdh;
@@ -128,6 +130,15 @@ constexpr std::int64_t kScanBudget = 64'000'000;
     return clamp_ops(kMaxRestingOrders / std::max<std::int64_t>(levels, 1));
 }
 
+// The scattered-queue match seeds one level per operation too, but every
+// level's queue is interleaved with every other's, so the level count is
+// also how far apart consecutive orders in one queue sit. Capped so those
+// levels stay well inside one ladder band: the argument should vary queue
+// depth, not whether the prices spill into the fallback map.
+[[nodiscard]] std::int64_t ops_per_scattered_level(std::int64_t orders_at_level) {
+    return std::min<std::int64_t>(ops_per_seeded_level(orders_at_level), 2'048);
+}
+
 // Total preflight scanning across an executed-FOK run is about
 // cases^2 * levels / 2 (each of `cases` orders re-reads a contra side that
 // starts at cases*levels orders and drains to zero), so the iteration count
@@ -232,18 +243,56 @@ static void BM_Match_SingleLevel(benchmark::State& state) {
     state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(orders_at_level));
 }
 
+// The same one-level match, against queues built the way a real book builds
+// them: orders arrive at every level in turn, so consecutive orders in one
+// queue were added `cases` orders apart and sit that far apart in the slab.
+// BM_Match_SingleLevel seeds each level in one run, which leaves its queue
+// contiguous and lets the hardware prefetcher hide every miss; here each
+// fill is a fresh line, which is the case splitting the slab and
+// prefetching the next order in the queue are for.
+static void BM_Match_ScatteredQueue(benchmark::State& state) {
+    const auto orders_at_level = static_cast<std::size_t>(state.range(0));
+    const auto cases = static_cast<std::size_t>(state.max_iterations);
+    constexpr Quantity kPerOrder = 10;
+
+    MatchingEngine engine({kInstrument}, cases * orders_at_level);
+    SequentialIds ids;
+    const EventSink& sink = discard_events();
+    for (std::size_t round = 0; round < orders_at_level; ++round) {
+        for (std::size_t i = 0; i < cases; ++i) {
+            engine.process(ExchangeCommand{new_order(ids.take_command_sequence(), kMaker, ids.take_client_order_id(),
+                                                      kInstrument, Side::Sell, kBase + static_cast<Price>(i),
+                                                      kPerOrder)},
+                           sink);
+        }
+    }
+
+    std::vector<ExchangeCommand> commands;
+    commands.reserve(cases);
+    for (std::size_t i = 0; i < cases; ++i) {
+        commands.push_back(ExchangeCommand{new_order(ids.take_command_sequence(), kTaker, ids.take_client_order_id(),
+                                                      kInstrument, Side::Buy, kBase + static_cast<Price>(i),
+                                                      kPerOrder * orders_at_level, TimeInForce::IOC)});
+    }
+
+    std::size_t next = 0;
+    for (auto _ : state) {
+        engine.process(commands[next++], sink);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(orders_at_level));
+}
+
 // ── 3. Multi-level sweep ───────────────────────────────────────────────────
 
-// An IOC buy that walks `range(0)` distinct ask levels in one process()
-// call. Case i owns a contiguous block of `levels` prices immediately above
-// case i-1's block, and the blocks are consumed lowest-first, so each timed
-// operation sweeps exactly its own block and stops.
-static void BM_Sweep_Levels(benchmark::State& state) {
-    const auto levels = static_cast<std::size_t>(state.range(0));
-    const auto cases = static_cast<std::size_t>(state.max_iterations);
+// Seeds `cases` disjoint blocks of `levels` ask prices, one order each,
+// and returns the IOC buy that sweeps each block. Case i owns a contiguous
+// block immediately above case i-1's, and the blocks are consumed
+// lowest-first, so each timed operation sweeps exactly its own block and
+// stops. Shared by every sweep case below so they differ only in how events
+// leave the engine.
+[[nodiscard]] static std::vector<ExchangeCommand> seed_sweep_cases(MatchingEngine& engine, std::size_t levels,
+                                                                   std::size_t cases) {
     constexpr Quantity kPerLevel = 10;
-
-    MatchingEngine engine{kInstrument};
     SequentialIds ids;
     seed_resting_orders(engine, ids, kMaker, kInstrument, Side::Sell, kBase, 1, cases * levels, 1, kPerLevel);
 
@@ -255,6 +304,15 @@ static void BM_Sweep_Levels(benchmark::State& state) {
                                                       kInstrument, Side::Buy, worst, kPerLevel * levels,
                                                       TimeInForce::IOC)});
     }
+    return commands;
+}
+
+// An IOC buy that walks `range(0)` distinct ask levels in one process()
+// call, delivering each event through an EventSink.
+static void BM_Sweep_Levels(benchmark::State& state) {
+    const auto levels = static_cast<std::size_t>(state.range(0));
+    MatchingEngine engine{kInstrument};
+    const auto commands = seed_sweep_cases(engine, levels, static_cast<std::size_t>(state.max_iterations));
 
     const EventSink& sink = discard_events();
     std::size_t next = 0;
@@ -265,6 +323,49 @@ static void BM_Sweep_Levels(benchmark::State& state) {
     state.SetComplexityN(static_cast<std::int64_t>(levels));
 }
 
+// The same sweep with a sink whose type the engine can see: a lambda
+// counting events, passed straight to the templated process(). It does
+// strictly more than the discarding EventSink above, so whatever it saves
+// is the std::function call per event and nothing else.
+static void BM_Sweep_Levels_TypedSink(benchmark::State& state) {
+    const auto levels = static_cast<std::size_t>(state.range(0));
+    MatchingEngine engine{kInstrument};
+    const auto commands = seed_sweep_cases(engine, levels, static_cast<std::size_t>(state.max_iterations));
+
+    std::size_t emitted = 0;
+    const auto count = [&emitted](const auto&) { ++emitted; };
+    std::size_t next = 0;
+    for (auto _ : state) {
+        engine.process(commands[next++], count);
+    }
+    benchmark::DoNotOptimize(emitted);
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(levels));
+    state.SetComplexityN(static_cast<std::int64_t>(levels));
+}
+
+// The same sweep through process_batch(), one command per batch, into a
+// buffer reused across iterations. Nothing else differs from
+// BM_Sweep_Levels, so the gap between the two at a given `levels` is what
+// per-event delivery through an EventSink costs; with it gone, the
+// per-level figure should stay flat as the sweep gets wider.
+static void BM_Sweep_Levels_Batched(benchmark::State& state) {
+    const auto levels = static_cast<std::size_t>(state.range(0));
+    MatchingEngine engine{kInstrument};
+    const auto commands = seed_sweep_cases(engine, levels, static_cast<std::size_t>(state.max_iterations));
+
+    // A sweep of n levels emits 1 + 2n events; sized so no iteration grows it.
+    EventBuffer buffer(1 + 2 * levels, 1);
+    const std::span<const ExchangeCommand> all(commands);
+    std::size_t next = 0;
+    for (auto _ : state) {
+        buffer.clear();
+        engine.process_batch(all.subspan(next++, 1), buffer);
+        benchmark::DoNotOptimize(buffer.events().data());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(levels));
+    state.SetComplexityN(static_cast<std::int64_t>(levels));
+}
+
 // ── 4. Cancel ──────────────────────────────────────────────────────────────
 
 // Cancel of a live resting order in a book holding `range(0)` distinct price
@@ -459,13 +560,13 @@ static void BM_Fok_Rejected_CrossableLevels(benchmark::State& state) {
 // one level and `range(0)` *non-crossable* levels parked far above it.
 //
 // This exists to answer a specific structural question about
-// crossable_quantity(): it obtains the contra side via
-// MatchingBook::all_asks(), which materialises a std::vector copy of every
-// resting order on that side before the loop that stops at the first
-// non-crossing level ever runs. If preflight cost were a function of levels
-// actually crossed, this benchmark would be flat in `range(0)`. If it grows
-// with `range(0)`, the cost is a function of total contra-side depth
-// instead. Also a perfect steady state -- a rejected FOK mutates nothing.
+// crossable_quantity(): is its cost a function of the levels it actually
+// crosses, or of the whole contra side? It once obtained that side through
+// MatchingBook::all_asks(), copying every resting order before the loop
+// that stops at the first non-crossing level ever ran. It now walks the
+// price index in place, so this should be flat in `range(0)`; growth here
+// means something has started looking past the limit price again. Also a
+// perfect steady state -- a rejected FOK mutates nothing.
 static void BM_Fok_Rejected_BackgroundDepth(benchmark::State& state) {
     const auto background = static_cast<std::size_t>(state.range(0));
     constexpr Quantity kPerLevel = 10;
@@ -493,6 +594,41 @@ static void BM_Fok_Rejected_BackgroundDepth(benchmark::State& state) {
     state.SetComplexityN(static_cast<std::int64_t>(background));
 }
 
+// The rejected FOK again, across a fixed 16 crossable levels, with each
+// level split into `range(0)` small orders -- the fragmented book a
+// market-making crowd leaves behind, where the same quantity rests as many
+// one-lot orders instead of a few large ones.
+//
+// crossable_quantity() reads each level's running total rather than its
+// orders, so this should be flat in `range(0)`: the preflight costs what
+// the number of levels costs. Summing order by order would make it grow
+// linearly, which is what this is here to catch.
+static void BM_Fok_Rejected_FragmentedLevels(benchmark::State& state) {
+    const auto orders_per_level = static_cast<std::size_t>(state.range(0));
+    constexpr std::size_t kLevels = 16;
+    constexpr Quantity kPerOrder = 1;
+
+    MatchingEngine engine{kInstrument};
+    SequentialIds ids;
+    seed_resting_orders(engine, ids, kMaker, kInstrument, Side::Sell, kBase, 1, kLevels, orders_per_level, kPerOrder);
+
+    const Price worst = kBase + static_cast<Price>(kLevels) - 1;
+    const Quantity unfillable = kPerOrder * kLevels * orders_per_level + 1;
+    std::vector<ExchangeCommand> commands;
+    commands.reserve(static_cast<std::size_t>(state.max_iterations));
+    for (std::int64_t i = 0; i < state.max_iterations; ++i) {
+        commands.push_back(ExchangeCommand{new_order(ids.take_command_sequence(), kTaker, ids.take_client_order_id(),
+                                                      kInstrument, Side::Buy, worst, unfillable, TimeInForce::FOK)});
+    }
+
+    const EventSink& sink = discard_events();
+    std::size_t next = 0;
+    for (auto _ : state) {
+        engine.process(commands[next++], sink);
+    }
+    state.SetComplexityN(static_cast<std::int64_t>(orders_per_level));
+}
+
 // FOK that passes preflight and executes in full across `range(0)` levels:
 // preflight walk plus the same matching walk BM_Sweep_Levels measures, so
 // the gap between the two at equal `levels` is what the all-or-none
@@ -527,6 +663,38 @@ static void BM_Fok_Executed(benchmark::State& state) {
     state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(levels));
 }
 
+// ── 7. State fingerprint ───────────────────────────────────────────────────
+
+// The determinism check as it stood: build a full snapshot and FNV it, byte
+// by byte. Design 1 -- reads only. Cost grows with every resting order,
+// which is `range(0)` of them here on one book.
+static void BM_StateHash_FullSnapshot(benchmark::State& state) {
+    const auto depth = static_cast<std::size_t>(state.range(0));
+    MatchingEngine engine{kInstrument};
+    SequentialIds ids;
+    seed_resting_orders(engine, ids, kMaker, kInstrument, Side::Buy, kBase, -1, depth, 1, 10);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(persistence::hash_state_snapshot(engine.snapshot()));
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(depth));
+}
+
+// The same question answered from the rolling hash, which the engine has
+// already kept current: a load, whatever the depth. What it costs is paid
+// inside every command instead, and shows up in sections 1-6 rather than
+// here.
+static void BM_StateHash_Rolling(benchmark::State& state) {
+    const auto depth = static_cast<std::size_t>(state.range(0));
+    MatchingEngine engine{kInstrument};
+    SequentialIds ids;
+    seed_resting_orders(engine, ids, kMaker, kInstrument, Side::Buy, kBase, -1, depth, 1, 10);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(engine.state_hash());
+    }
+}
+
 // Registration happens here rather than through the BENCHMARK macro so that
 // each argument can carry its own iteration count (see
 // register_per_argument's comment), which in turn is why this file supplies
@@ -535,8 +703,14 @@ int main(int argc, char** argv) {
     register_per_argument("BM_Rest_ExistingPriceLevel", BM_Rest_ExistingPriceLevel, kDepthArgs, fixed_target_ops);
     register_per_argument("BM_Rest_NewPriceLevel", BM_Rest_NewPriceLevel, kDepthArgs, fixed_target_ops);
     register_per_argument("BM_Match_SingleLevel", BM_Match_SingleLevel, {1, 4, 16, 64, 256}, ops_per_seeded_level);
+    register_per_argument("BM_Match_ScatteredQueue", BM_Match_ScatteredQueue, {4, 16, 64, 256},
+                          ops_per_scattered_level);
     register_per_argument("BM_Sweep_Levels", BM_Sweep_Levels, kLevelArgs, ops_per_seeded_level,
                           /*with_complexity=*/true);
+    register_per_argument("BM_Sweep_Levels_TypedSink", BM_Sweep_Levels_TypedSink, kLevelArgs, ops_per_seeded_level,
+                          /*with_complexity=*/true);
+    register_per_argument("BM_Sweep_Levels_Batched", BM_Sweep_Levels_Batched, kLevelArgs, ops_per_seeded_level,
+                          /*with_complexity=*/true);
     register_per_argument("BM_Cancel", BM_Cancel, kDepthArgs, fixed_target_ops);
     register_per_argument("BM_Replace_PriorityPreserving", BM_Replace_PriorityPreserving, kDepthArgs,
                           fixed_target_ops);
@@ -548,7 +722,11 @@ int main(int argc, char** argv) {
                           ops_for_scan);
     register_per_argument("BM_Fok_Rejected_BackgroundDepth", BM_Fok_Rejected_BackgroundDepth,
                           {0, 16, 256, 4'096, 65'536}, ops_for_scan_with_background);
+    register_per_argument("BM_Fok_Rejected_FragmentedLevels", BM_Fok_Rejected_FragmentedLevels,
+                          {1, 16, 256, 4'096}, fixed_target_ops, /*with_complexity=*/true);
     register_per_argument("BM_Fok_Executed", BM_Fok_Executed, kLevelArgs, ops_for_executed_fok);
+    register_per_argument("BM_StateHash_FullSnapshot", BM_StateHash_FullSnapshot, kDepthArgs, ops_for_scan);
+    register_per_argument("BM_StateHash_Rolling", BM_StateHash_Rolling, kDepthArgs, fixed_target_ops);
 
     benchmark::Initialize(&argc, argv);
     if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
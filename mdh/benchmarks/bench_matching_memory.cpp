@@ -33,6 +33,7 @@
 #include <functional>
 #include <new>
 #include <string>
+#include <utility>
 #include <vector>
 
 #if defined(__APPLE__)
@@ -486,9 +487,11 @@ void report_allocation_shape() {
                 "allocator is a few dozen bulk buffers rather than a few million nodes -- which is\n"
                 "why nearly all the bytes land in the >=1024 row.\n\n");
     std::printf("Type sizes on this build:\n");
-    std::printf("  sizeof(BookOrder)                 %3zu  (what a slab entry actually holds)\n", sizeof(BookOrder));
-    std::printf("  slab entry                        %3zu  (BookOrder plus two 32-bit FIFO links)\n",
-                sizeof(BookOrder) + 2 * sizeof(std::uint32_t));
+    std::printf("  sizeof(BookOrder)                 %3zu  (an order as the book hands it out)\n", sizeof(BookOrder));
+    std::printf("  slab entry                        %3zu  (16 hot: quantity and two 32-bit FIFO links;\n"
+                "                                           40 cold: ids, account, price, side, TIF;\n"
+                "                                           12 account chain: two links and its chain)\n",
+                sizeof(BookOrder) + 5 * sizeof(std::uint32_t));
     std::printf("  sizeof(ExchangeRestingOrder)      %3zu  (the reassembled form: commands, snapshots)\n",
                 sizeof(ExchangeRestingOrder));
     std::printf("  sizeof(Price)                     %3zu\n", sizeof(Price));
@@ -537,6 +540,96 @@ void report_allocation_shape() {
     }
 }
 
+// ── A large universe on a shared ladder budget ─────────────────────────────
+
+// A hundred thousand instruments, a few hundred trading at a time, and which
+// few hundred changes as the session goes on. Split evenly, the default
+// budget buys each of these books nothing -- band_for() says zero -- so
+// before ladders were drawn from a shared budget a universe this size ran on
+// the map alone. Drawn on demand, the active books get ladders and the idle
+// ones hand theirs back, and what this section has to show is that memory
+// stays flat as the active set moves: the ladder bytes bounded by the
+// budget, and the engine's live bytes levelling off once every cohort has
+// had its turn.
+void report_large_universe() {
+    constexpr std::size_t kUniverse = 100'000;
+    constexpr std::size_t kActive = 200; // instruments per cohort
+    constexpr std::size_t kCohorts = 4;
+    constexpr std::size_t kPhases = 12;
+    constexpr std::size_t kLevels = 8; // per side, one order each
+    constexpr std::size_t kStride = kUniverse / kActive;
+    constexpr LadderPolicy kPolicy{.idle_commands = 4'096};
+
+    rule("A 100,000-instrument universe on a shared ladder budget");
+    std::printf("%zu instruments; each phase one of %zu cohorts of %zu trades -- rests %zu levels a side,\n"
+                "cancels them, rests them again, then goes quiet leaving its best bid and ask -- and\n"
+                "cohorts rotate. Ladder budget %.0f MB, reclaimed after %llu commands idle. An even\n"
+                "split of that budget gives each book a band of %u ticks: no ladder at all.\n"
+                "Live bytes are everything the engine holds, measured from before it was built.\n\n",
+                kUniverse, kCohorts, kActive, kLevels, static_cast<double>(kPolicy.byte_budget) / (1024.0 * 1024.0),
+                static_cast<unsigned long long>(kPolicy.idle_commands),
+                MatchingBook::band_for(kUniverse, kPolicy.byte_budget));
+    std::printf("%6s %7s | %14s %14s | %12s %10s %10s %9s %14s\n", "phase", "cohort", "live MB", "ladder MB",
+                "materialised", "reclaimed", "refusals", "widened", "out-of-band");
+    std::printf("%s\n", std::string(110, '-').c_str());
+
+    const AllocationSnapshot before = snapshot_allocations();
+    const std::vector<InstrumentId> universe = instrument_universe(kUniverse);
+    MatchingEngine engine(universe, /*expected_resting_orders=*/kUniverse, {}, kPolicy);
+    SequentialIds ids;
+    const EventSink& sink = discard_events();
+
+    const auto rest = [&](InstrumentId instrument_id, Side side, Price price) {
+        const ClientOrderId client_order_id = ids.take_client_order_id();
+        engine.process(ExchangeCommand{new_order(ids.take_command_sequence(), kMaker, client_order_id, instrument_id,
+                                                 side, price, 10)},
+                       sink);
+        return client_order_id;
+    };
+    const auto cancel = [&](InstrumentId instrument_id, ClientOrderId client_order_id) {
+        engine.process(
+            ExchangeCommand{cancel_order(ids.take_command_sequence(), kMaker, client_order_id, instrument_id)}, sink);
+    };
+
+    for (std::size_t phase = 0; phase < kPhases; ++phase) {
+        const std::size_t cohort = phase % kCohorts;
+        std::vector<InstrumentId> active;
+        for (std::size_t k = 0; k < kActive; ++k) {
+            active.push_back(static_cast<InstrumentId>(1 + k * kStride + cohort));
+        }
+        // A cohort's previous turn left its best bid and ask resting; they
+        // stay where they are and this turn's orders join them.
+        for (int round = 0; round < 2; ++round) {
+            std::vector<std::pair<InstrumentId, ClientOrderId>> rested;
+            for (const InstrumentId instrument_id : active) {
+                for (std::size_t level = 1; level <= kLevels; ++level) {
+                    const auto offset = static_cast<Price>(level);
+                    rested.emplace_back(instrument_id, rest(instrument_id, Side::Buy, kBase - offset));
+                    rested.emplace_back(instrument_id, rest(instrument_id, Side::Sell, kBase + offset));
+                }
+            }
+            // The first round cancels everything; the second leaves the
+            // best level on each side behind.
+            for (std::size_t i = 0; i < rested.size(); ++i) {
+                if (round == 1 && i % (2 * kLevels) < 2) {
+                    continue;
+                }
+                cancel(rested[i].first, rested[i].second);
+            }
+        }
+
+        const AllocationSnapshot delta = since(before);
+        const LadderBudget& budget = engine.ladder_budget();
+        std::printf("%6zu %7zu | %14.2f %14.2f | %12llu %10llu %10llu %9llu %14zu\n", phase + 1, cohort,
+                    static_cast<double>(delta.live_bytes()) / (1024.0 * 1024.0),
+                    static_cast<double>(budget.bytes_in_use) / (1024.0 * 1024.0),
+                    static_cast<unsigned long long>(budget.materialised),
+                    static_cast<unsigned long long>(budget.reclaimed),
+                    static_cast<unsigned long long>(budget.refusals), static_cast<unsigned long long>(budget.widened),
+                    engine.out_of_band_levels());
+    }
+}
+
 } // namespace
 
 int main() {
@@ -553,6 +646,7 @@ int main() {
     report_operation_allocations();
     report_footprint();
     report_allocation_shape();
+    report_large_universe();
     std::printf("\n");
     return EXIT_SUCCESS;
 }
@@ -35,9 +35,11 @@
 #include <cstdlib>
 #include <cstring>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "exchange/matching/matching_engine.hpp"
+#include "exchange/sequencing/sharded_matching_pipeline.hpp"
 #include "exchange/testing/hr_timer.hpp"
 #include "exchange/testing/matching_scenarios.hpp"
 #include "exchange/testing/matching_workload.hpp"
@@ -536,6 +538,122 @@ void report_scaling_instruments(std::size_t operations, std::uint64_t seed) {
     }
 }
 
+// A trending market. The touch walks several band-widths from where each
+// ladder first anchored, so without re-centering every new level would end
+// up in the overflow map. Reports what the re-centering cost -- how often
+// it ran and how many levels it moved -- next to the latency it was meant
+// to protect, and the worst out-of-band level count seen along the way,
+// which is the figure that should stay near zero.
+void report_drifting_prices(std::size_t operations, std::uint64_t seed) {
+    rule("Drifting prices: ladder re-centering");
+    std::printf("Trending mix, 4 instruments; drift is ticks of mid movement per 1000 operations.\n"
+                "\"spilled\" is the most levels held outside a ladder at any 1000-operation checkpoint.\n\n");
+    std::printf("%8s %10s | %10s %10s %9s | %12s %12s\n", "drift", "travelled", "rebases", "migrated", "spilled",
+                "ns/op", "p99 ns");
+    std::printf("%s\n", std::string(84, '-').c_str());
+
+    for (const Price drift : {Price{0}, Price{10}, Price{25}, Price{50}}) {
+        WorkloadConfig config;
+        config.seed = seed;
+        config.operation_count = operations;
+        config.instrument_count = 4;
+        config.initial_orders_per_side = 500;
+        config.drift_ticks_per_thousand_operations = drift;
+        config.mix = WorkloadMix::trending();
+        const Workload workload = generate_workload(config);
+
+        MatchingEngine batch_engine(config.instruments(), workload.resting_orders_at_end);
+        apply_seed(batch_engine, workload);
+        const BatchResult batch = time_batch(batch_engine, workload.operations);
+
+        // Untimed pass for the checkpoints, so reading the counters never
+        // lands inside a measured region.
+        MatchingEngine walked(config.instruments(), workload.resting_orders_at_end);
+        apply_seed(walked, workload);
+        std::size_t spilled = 0;
+        for (std::size_t i = 0; i < workload.operations.size(); ++i) {
+            walked.process(workload.operations[i], discard_events());
+            if ((i + 1) % 1'000 == 0) {
+                spilled = std::max(spilled, walked.out_of_band_levels());
+            }
+        }
+
+        MatchingEngine sampled_engine(config.instruments(), workload.resting_orders_at_end);
+        apply_seed(sampled_engine, workload);
+        const LatencySummary sampled = time_sampled(sampled_engine, workload.operations);
+
+        const LadderRebaseCounters counters = walked.ladder_rebase_counters();
+        std::printf("%8lld %10lld | %10llu %10llu %9zu | %12.1f %12.0f\n", static_cast<long long>(drift),
+                    static_cast<long long>(drift * static_cast<Price>(operations) / 1'000),
+                    static_cast<unsigned long long>(counters.rebases),
+                    static_cast<unsigned long long>(counters.levels_migrated), spilled, batch.ns_per_op,
+                    sampled.p99_ns);
+    }
+}
+
+// Scaling: matching threads. One realistic stream over 16 instruments, fed
+// through ShardedMatchingPipeline at each shard count and timed from the
+// first measured submit to the last event reaching the sink. Unlike every
+// other section this includes the queues, the producer and the merge, so
+// its one-shard row is slower than the bare engine above -- the column to
+// read is the speedup, not the absolute figure.
+//
+// Shards beyond the machine's free cores only add contention, so a flat
+// curve on a small box says nothing about the design; the core count is
+// printed for that reason.
+void report_scaling_shards(std::size_t operations, std::uint64_t seed) {
+    rule("Scaling: matching shards (ShardedMatchingPipeline)");
+    std::printf("16 instruments, realistic mix, 256 resting orders per side per instrument; %u hardware threads.\n\n",
+                std::thread::hardware_concurrency());
+    std::printf("%8s | %12s %14s %10s\n", "shards", "ns/op", "ops/sec", "speedup");
+    std::printf("%s\n", std::string(50, '-').c_str());
+
+    WorkloadConfig config;
+    config.seed = seed;
+    config.operation_count = operations;
+    config.instrument_count = 16;
+    config.initial_orders_per_side = 256;
+    const Workload workload = generate_workload(config);
+
+    const auto feed = [](sequencing::ShardedMatchingPipeline& pipeline, const std::vector<ExchangeCommand>& commands) {
+        for (const auto& command : commands) {
+            while (!pipeline.submit(command)) {
+                std::this_thread::yield();
+            }
+        }
+    };
+    const auto wait_for = [](const sequencing::ShardedMatchingPipeline& pipeline, std::size_t processed) {
+        while (pipeline.commands_processed() < processed) {
+            std::this_thread::yield();
+        }
+    };
+
+    double single_shard_ns = 0.0;
+    for (const std::size_t shards : {std::size_t{1}, std::size_t{2}, std::size_t{4}, std::size_t{8}}) {
+        sequencing::ShardedMatchingPipeline pipeline(
+            discard_events(), sequencing::ShardedMatchingPipelineOptions{
+                                  .shard_count = shards,
+                                  .queue_capacity = 4'096,
+                                  .instruments = config.instruments(),
+                                  .expected_resting_orders = workload.resting_orders_at_end,
+                              });
+        feed(pipeline, workload.seed);
+        wait_for(pipeline, workload.seed.size());
+
+        const std::uint64_t start = timer_ticks();
+        feed(pipeline, workload.operations);
+        wait_for(pipeline, workload.seed.size() + workload.operations.size());
+        const std::uint64_t end = timer_ticks();
+        pipeline.stop();
+
+        const double ns_per_op = to_ns(end - start) / static_cast<double>(workload.operations.size());
+        if (shards == 1) {
+            single_shard_ns = ns_per_op;
+        }
+        std::printf("%8zu | %12.1f %14.0f %9.2fx\n", shards, ns_per_op, 1e9 / ns_per_op, single_shard_ns / ns_per_op);
+    }
+}
+
 } // namespace
 
 int main(int argc, char** argv) {
@@ -578,6 +696,8 @@ int main(int argc, char** argv) {
     report_scaling_cancel(scaling_ops);
     report_scaling_sweep();
     report_scaling_instruments(quick ? 50'000 : 200'000, seed);
+    report_drifting_prices(quick ? 200'000 : 1'000'000, seed);
+    report_scaling_shards(quick ? 100'000 : 1'000'000, seed);
 
     std::printf("\n");
     return EXIT_SUCCESS;
@@ -0,0 +1,98 @@
+// Multi-producer submit throughput: the gateway's shape, several reader
+// threads feeding one matching thread, taken two ways.
+//
+//   1. BM_MutexSpscQueue_Producers: every producer takes one std::mutex
+//      around SpscQueue::try_push -- how OrderEntryGateway::submit_command()
+//      serialized its reader threads before the pipeline moved to
+//      MpscQueue.
+//   2. BM_MpscQueue_Producers: every producer pushes straight into an
+//      MpscQueue, one fetch_add per push (see mpsc_queue.hpp).
+//
+// The argument is the number of producer threads; the total number of
+// items is fixed and split between them, so items/sec is directly
+// comparable across rows and between the two. One consumer drains in both,
+// spinning like the matching thread does. Producers retry on a full queue
+// rather than drop, as in bench_spsc_queue.cpp's two-thread case, so what is
+// measured is the ingress ceiling, not a backpressure policy.
+//
+// Wall-clock (UseRealTime): the work is on threads other than the one
+// Google Benchmark times. The comparison only means something with at least
+// as many cores as producers plus one; with fewer, the threads take turns
+// on a core and both arms mostly measure the scheduler.
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "common/mpsc_queue.hpp"
+#include "common/spsc_queue.hpp"
+
+using namespace mdh;
+
+namespace {
+
+constexpr std::uint64_t kItems = 400'000;
+constexpr std::size_t kCapacity = 4096;
+
+// A SpscQueue made safe for several producers the simple way.
+class MutexSpscQueue {
+public:
+    bool try_push(std::uint64_t value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return queue_.try_push(value);
+    }
+    std::optional<std::uint64_t> try_pop() { return queue_.try_pop(); }
+
+private:
+    std::mutex mutex_;
+    SpscQueue<std::uint64_t> queue_{kCapacity};
+};
+
+template <class Queue>
+void run_producers(benchmark::State& state) {
+    const auto producers = static_cast<std::uint64_t>(state.range(0));
+    const std::uint64_t per_producer = kItems / producers;
+    for (auto _ : state) {
+        Queue queue;
+        std::thread consumer([&] {
+            for (std::uint64_t received = 0; received < per_producer * producers;) {
+                if (auto value = queue.try_pop()) {
+                    benchmark::DoNotOptimize(*value);
+                    ++received;
+                }
+            }
+        });
+        std::vector<std::thread> threads;
+        for (std::uint64_t p = 0; p < producers; ++p) {
+            threads.emplace_back([&queue, per_producer] {
+                for (std::uint64_t i = 0; i < per_producer; ++i) {
+                    while (!queue.try_push(i)) {
+                        // Backpressure: retry rather than drop, as above.
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        consumer.join();
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(per_producer * producers));
+}
+
+struct LockFreeQueue : MpscQueue<std::uint64_t> {
+    LockFreeQueue() : MpscQueue<std::uint64_t>(kCapacity) {}
+};
+
+} // namespace
+
+static void BM_MutexSpscQueue_Producers(benchmark::State& state) { run_producers<MutexSpscQueue>(state); }
+BENCHMARK(BM_MutexSpscQueue_Producers)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+static void BM_MpscQueue_Producers(benchmark::State& state) { run_producers<LockFreeQueue>(state); }
+BENCHMARK(BM_MpscQueue_Producers)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,176 @@
+// The end of the trading day: 100,000 good-till-date orders spread over
+// eight books, all due to expire at the close, taken off two ways against an
+// in-process MatchingEngine.
+//
+//   1. 100,000 CancelOrderCommands, one per order -- what a client, or a
+//      gateway sweeping on the clients' behalf, had to send before the engine
+//      kept time, each paying its own visit, directory lookup and book
+//      removal.
+//   2. One ClockTickCommand carrying the close. The timer wheel hands back
+//      exactly the orders that are due, so the cost is theirs and not the
+//      books': a second account rests just as many GTC orders alongside and
+//      is never touched.
+//
+// Both arms emit the same events (one OrderCancelled and one
+// BookOrderRemoved per order), into a sink that only counts them, so what
+// is timed is the matching side alone. Arm 2 is a single command, and its
+// time is also how long every other account waits behind it on the
+// matching thread; that figure is printed on its own. Arming the timers is
+// part of accepting the orders and is not timed in either arm, but its cost
+// per order is printed separately, against accepting the same orders GTC.
+//
+// The book is rebuilt before every round and the rebuild is not timed.
+// Standalone rather than a Google Benchmark case for the same reason as
+// bench_mass_cancel.cpp. Run from a Release build only.
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "exchange/matching/matching_engine.hpp"
+
+using namespace mdh;
+using namespace mdh::exchange;
+
+namespace {
+
+constexpr std::size_t kOrders = 100'000;
+constexpr InstrumentId kInstruments = 8;
+constexpr AccountId kExpiring = 1;
+constexpr AccountId kStaying = 2;
+constexpr Timestamp kOpen = 9 * 3'600'000'000'000ULL;
+constexpr Timestamp kClose = 17 * 3'600'000'000'000ULL;
+constexpr int kRounds = 7;
+
+struct CountingSink {
+    std::size_t* events;
+    void operator()(const ExchangeEvent&) const { ++*events; }
+};
+
+// kOrders for each account, interleaved so the two accounts' orders share
+// every price level and neither's sits in a contiguous run of the slab.
+// Bids and asks either side of a fixed mid, so nothing crosses. The
+// expiring account's orders are GTD to the close when `gtd` is set, GTC
+// otherwise; the staying account's are always GTC. Returns how long the
+// expiring account's orders took to accept.
+double seed(MatchingEngine& engine, CommandSequence& sequence, bool gtd) {
+    std::size_t events = 0;
+    engine.process(ClockTickCommand{.command_sequence = ++sequence, .now = kOpen}, CountingSink{&events});
+    double accept_ns = 0;
+    for (std::size_t i = 0; i < kOrders; ++i) {
+        const InstrumentId instrument = static_cast<InstrumentId>(i % kInstruments) + 1;
+        const bool buy = (i / kInstruments) % 2 == 0;
+        const Price price = buy ? 1'000 - static_cast<Price>(i % 50) : 1'001 + static_cast<Price>(i % 50);
+        for (const AccountId account : {kExpiring, kStaying}) {
+            const bool expires = gtd && account == kExpiring;
+            const NewOrderCommand command{.command_sequence = ++sequence,
+                                          .account_id = account,
+                                          .client_order_id = i + 1,
+                                          .instrument_id = instrument,
+                                          .side = buy ? Side::Buy : Side::Sell,
+                                          .price = price,
+                                          .quantity = 1,
+                                          .order_type = OrderType::Limit,
+                                          .time_in_force = expires ? TimeInForce::GTD : TimeInForce::GTC,
+                                          .expire_at = expires ? kClose : 0};
+            const auto start = std::chrono::steady_clock::now();
+            engine.process(command, CountingSink{&events});
+            if (account == kExpiring) {
+                accept_ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start)
+                                 .count();
+            }
+        }
+    }
+    return accept_ns;
+}
+
+[[nodiscard]] std::vector<InstrumentId> universe() {
+    std::vector<InstrumentId> ids;
+    for (InstrumentId id = 1; id <= kInstruments; ++id) ids.push_back(id);
+    return ids;
+}
+
+struct Sample {
+    double ns;
+    double accept_ns;
+    std::size_t events;
+};
+
+Sample cancel_flood() {
+    const std::vector<InstrumentId> ids = universe();
+    MatchingEngine engine(ids, 2 * kOrders);
+    CommandSequence sequence = 0;
+    const double accept_ns = seed(engine, sequence, false);
+
+    std::size_t events = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < kOrders; ++i) {
+        engine.process(CancelOrderCommand{.command_sequence = ++sequence,
+                                          .account_id = kExpiring,
+                                          .client_order_id = i + 1,
+                                          .instrument_id = static_cast<InstrumentId>(i % kInstruments) + 1},
+                       CountingSink{&events});
+    }
+    const auto stop = std::chrono::steady_clock::now();
+    return {std::chrono::duration<double, std::nano>(stop - start).count(), accept_ns, events};
+}
+
+Sample closing_tick() {
+    const std::vector<InstrumentId> ids = universe();
+    MatchingEngine engine(ids, 2 * kOrders);
+    CommandSequence sequence = 0;
+    const double accept_ns = seed(engine, sequence, true);
+
+    std::size_t events = 0;
+    const auto start = std::chrono::steady_clock::now();
+    engine.process(ClockTickCommand{.command_sequence = ++sequence, .now = kClose}, CountingSink{&events});
+    const auto stop = std::chrono::steady_clock::now();
+    return {std::chrono::duration<double, std::nano>(stop - start).count(), accept_ns, events};
+}
+
+double median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+} // namespace
+
+int main() {
+    std::vector<double> flood_ns;
+    std::vector<double> tick_ns;
+    std::vector<double> gtc_accept_ns;
+    std::vector<double> gtd_accept_ns;
+    std::size_t flood_events = 0;
+    std::size_t tick_events = 0;
+    for (int round = 0; round < kRounds; ++round) {
+        const Sample flood = cancel_flood();
+        const Sample tick = closing_tick();
+        flood_ns.push_back(flood.ns);
+        tick_ns.push_back(tick.ns);
+        gtc_accept_ns.push_back(flood.accept_ns);
+        gtd_accept_ns.push_back(tick.accept_ns);
+        flood_events = flood.events;
+        tick_events = tick.events;
+    }
+    if (flood_events != tick_events || tick_events != 2 * kOrders) {
+        std::fprintf(stderr, "arms disagree: %zu events from cancels, %zu from the closing tick\n", flood_events,
+                     tick_events);
+        return EXIT_FAILURE;
+    }
+
+    const double flood = median(flood_ns);
+    const double tick = median(tick_ns);
+    const double orders = static_cast<double>(kOrders);
+    std::printf("expiring %zu resting orders of one account at the close (another rests as many alongside), "
+                "median of %d rounds\n",
+                kOrders, kRounds);
+    std::printf("  %zu CancelOrderCommands   %10.2f ms  %7.1f ns/order\n", kOrders, flood / 1e6, flood / orders);
+    std::printf("  1 ClockTickCommand         %10.2f ms  %7.1f ns/order\n", tick / 1e6, tick / orders);
+    std::printf("  speedup                    %10.2fx\n", flood / tick);
+    std::printf("  longest single visit: %.2f ms for the closing tick -- the stall every other account sees\n",
+                tick / 1e6);
+    std::printf("  accepting the orders: %.1f ns/order GTC, %.1f ns/order GTD (timer armed)\n",
+                median(gtc_accept_ns) / orders, median(gtd_accept_ns) / orders);
+    return EXIT_SUCCESS;
+}
@@ -8,14 +8,25 @@
 // automatically via the for (auto _ : state) idiom below: everything before
 // the loop is untimed), so decode benchmarks measure decode_event()/
 // decode_message() alone, not encoding cost bleeding into the same number.
+//
+// The FrameNewOrderBurst pair frames a whole read's worth of back-to-back
+// NewOrders, 4 to 64 KiB of them, the way a stream reader does: once by
+// erasing each frame from the front of a std::vector, as the gateway's and
+// the trader client's readers used to, and once in place off a
+// net::ReceiveBuffer with decode_frames(), as they do now. Frames per
+// second across the sizes is the thing to read: flat in place, falling
+// with the burst as the erases each move everything behind them. Each also
+// reports Google Benchmark's fitted complexity in the burst size.
 #include <benchmark/benchmark.h>
 
 #include <cstddef>
 #include <span>
+#include <variant>
 #include <vector>
 
 #include "common/types.hpp"
 #include "exchange/core/types.hpp"
+#include "net/receive_buffer.hpp"
 #include "protocol/decoder.hpp"
 #include "protocol/encoder.hpp"
 #include "protocol/messages.hpp"
@@ -45,6 +56,18 @@ protocol::order_entry::Message make_new_order() {
         .time_in_force = exchange::TimeInForce::GTC}};
 }
 
+// `bytes` worth of encoded NewOrders, whole frames only.
+std::vector<std::byte> new_order_burst(std::size_t bytes) {
+    const auto message = make_new_order();
+    std::vector<std::byte> burst;
+    std::vector<std::byte> frame;
+    protocol::order_entry::encode_message(message, frame);
+    while (burst.size() + frame.size() <= bytes) {
+        burst.insert(burst.end(), frame.begin(), frame.end());
+    }
+    return burst;
+}
+
 } // namespace
 
 static void BM_MarketData_EncodeAddOrder(benchmark::State& state) {
@@ -95,4 +118,50 @@ static void BM_OrderEntry_DecodeNewOrder(benchmark::State& state) {
 }
 BENCHMARK(BM_OrderEntry_DecodeNewOrder);
 
+static void BM_OrderEntry_FrameNewOrderBurst_EraseFront(benchmark::State& state) {
+    using namespace protocol::order_entry;
+    const auto burst = new_order_burst(static_cast<std::size_t>(state.range(0)));
+    std::vector<std::byte> buffer;
+    std::size_t frames = 0;
+    for (auto _ : state) {
+        buffer.assign(burst.begin(), burst.end());
+        frames = 0;
+        while (true) {
+            auto header = decode_header(buffer);
+            const auto* parsed = std::get_if<Header>(&header);
+            if (parsed == nullptr || buffer.size() < HEADER_SIZE + parsed->payload_size) {
+                break;
+            }
+            const std::size_t frame_size = HEADER_SIZE + parsed->payload_size;
+            auto result = decode_message(std::span(buffer).first(frame_size));
+            benchmark::DoNotOptimize(result);
+            buffer.erase(buffer.begin(), buffer.begin() + static_cast<std::ptrdiff_t>(frame_size));
+            ++frames;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(frames));
+    state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(burst.size()));
+    state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_OrderEntry_FrameNewOrderBurst_EraseFront)->RangeMultiplier(2)->Range(4 << 10, 64 << 10)->Complexity();
+
+static void BM_OrderEntry_FrameNewOrderBurst_InPlace(benchmark::State& state) {
+    using namespace protocol::order_entry;
+    const auto burst = new_order_burst(static_cast<std::size_t>(state.range(0)));
+    net::ReceiveBuffer buffer(burst.size());
+    std::size_t frames = 0;
+    for (auto _ : state) {
+        buffer.append(burst);
+        frames = 0;
+        buffer.consume(decode_frames(buffer.readable(), [&](std::variant<Message, DecodeError>&& result) {
+            benchmark::DoNotOptimize(result);
+            ++frames;
+        }));
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(frames));
+    state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(burst.size()));
+    state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_OrderEntry_FrameNewOrderBurst_InPlace)->RangeMultiplier(2)->Range(4 << 10, 64 << 10)->Complexity();
+
 BENCHMARK_MAIN();
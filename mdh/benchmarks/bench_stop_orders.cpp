@@ -0,0 +1,136 @@
+// What resting stop orders cost the trades that do not reach them: 100,000
+// trades on one book against an in-process MatchingEngine, with 0, 1,000,
+// 10,000 and 100,000 stops waiting on that book, half buy stops above the
+// market and half sell stops below it, spread over 500 prices each way and
+// none within reach of the trades.
+//
+// Each trade is a maker resting one lot at the touch and a taker lifting it.
+// Only the taker's command is timed: it is the one that trades, and so the
+// one that has to ask whether any stop was reached. The answer comes from
+// the front of each side of the stop book, one look each, so the cost per
+// trade should not move with the number of stops -- that is what this
+// measures. Placing the stops is not timed.
+//
+// Every stop also holds a directory entry, as every live order does, and a
+// bigger directory is a colder one for the taker's duplicate-id probe. So
+// each count is run a second time with the same number of plain limit
+// orders resting at the same far prices in place of the stops -- sells
+// above the market, buys below -- and the column that matters is the
+// difference: what stops cost that the same number of live orders would not.
+//
+// Events go into a sink that only counts them, so what is timed is the
+// matching side alone. Standalone rather than a Google Benchmark case for
+// the same reason as bench_mass_cancel.cpp. Run from a Release build only.
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "exchange/matching/matching_engine.hpp"
+#include "exchange/testing/matching_scenarios.hpp"
+
+using namespace mdh;
+using namespace mdh::exchange;
+
+namespace {
+
+constexpr std::size_t kTrades = 100'000;
+constexpr InstrumentId kInstrument = 1;
+constexpr AccountId kMaker = 1;
+constexpr AccountId kTaker = 2;
+constexpr AccountId kStopper = 3;
+constexpr Price kTouch = 1'000;
+constexpr int kRounds = 7;
+
+struct CountingSink {
+    std::size_t* events;
+    void operator()(const ExchangeEvent&) const { ++*events; }
+};
+
+NewOrderCommand limit(CommandSequence seq, AccountId account, ClientOrderId client_id, Side side, Price price) {
+    return NewOrderCommand{.command_sequence = seq,
+                           .account_id = account,
+                           .client_order_id = client_id,
+                           .instrument_id = kInstrument,
+                           .side = side,
+                           .price = price,
+                           .quantity = 1,
+                           .order_type = OrderType::Limit,
+                           .time_in_force = TimeInForce::GTC};
+}
+
+struct Sample {
+    double ns;
+    std::size_t events;
+    std::size_t stops_left;
+};
+
+Sample run(std::size_t stops, bool as_stops) {
+    MatchingEngine engine({kInstrument}, kTrades);
+    CommandSequence sequence = 0;
+    std::size_t events = 0;
+    // Placed before the book's first trade, when any stop price is
+    // accepted; these are all out of the trades' reach regardless. As plain
+    // orders, a buy stop's price is an ask and a sell stop's a bid.
+    for (std::size_t i = 0; i < stops; ++i) {
+        const bool buy = i % 2 == 0;
+        const Price offset = 100 + static_cast<Price>(i / 2 % 500);
+        const Price price = buy ? kTouch + offset : kTouch - offset;
+        const Side side = buy == as_stops ? Side::Buy : Side::Sell;
+        const NewOrderCommand far = as_stops ? testing::stop_limit_order(++sequence, kStopper, i + 1, kInstrument,
+                                                                         side, price, price, 1)
+                                             : limit(++sequence, kStopper, i + 1, side, price);
+        engine.process(far, CountingSink{&events});
+    }
+
+    double ns = 0;
+    events = 0;
+    for (std::size_t i = 0; i < kTrades; ++i) {
+        engine.process(limit(++sequence, kMaker, i + 1, Side::Sell, kTouch), CountingSink{&events});
+        const NewOrderCommand taker = limit(++sequence, kTaker, i + 1, Side::Buy, kTouch);
+        const auto start = std::chrono::steady_clock::now();
+        engine.process(taker, CountingSink{&events});
+        ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    }
+    return {ns, events, as_stops ? engine.pending_stops() : stops};
+}
+
+double median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+} // namespace
+
+int main() {
+    std::printf("%zu trades on one book with orders resting out of reach, median of %d rounds, ns/trade\n",
+                kTrades, kRounds);
+    std::printf("  %7s   %10s   %10s   %10s\n", "resting", "as stops", "as limits", "difference");
+    std::size_t expected_events = 0;
+    for (const std::size_t count : {std::size_t{0}, std::size_t{1'000}, std::size_t{10'000}, std::size_t{100'000}}) {
+        std::vector<double> stop_ns;
+        std::vector<double> limit_ns;
+        for (int round = 0; round < kRounds; ++round) {
+            for (const bool as_stops : {true, false}) {
+                const Sample sample = run(count, as_stops);
+                if (sample.stops_left != count) {
+                    std::fprintf(stderr, "%zu stops placed, %zu still pending\n", count, sample.stops_left);
+                    return EXIT_FAILURE;
+                }
+                if (expected_events == 0) {
+                    expected_events = sample.events;
+                } else if (sample.events != expected_events) {
+                    std::fprintf(stderr, "%zu events with %zu resting, %zu with none\n", sample.events, count,
+                                 expected_events);
+                    return EXIT_FAILURE;
+                }
+                (as_stops ? stop_ns : limit_ns).push_back(sample.ns / static_cast<double>(kTrades));
+            }
+        }
+        const double stops = median(stop_ns);
+        const double limits = median(limit_ns);
+        std::printf("  %7zu   %10.1f   %10.1f   %+10.1f\n", count, stops, limits, stops - limits);
+    }
+    return EXIT_SUCCESS;
+}
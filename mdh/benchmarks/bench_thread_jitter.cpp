@@ -0,0 +1,168 @@
+// What thread placement buys the matching thread on a busy machine: the
+// tail of per-command latency, with and without a placement profile, while
+// other threads compete for every core.
+//
+// The measured thread plays the matching thread: an in-process
+// MatchingEngine, and per iteration one maker resting a lot at the touch and
+// one taker lifting it, timed together. Alongside it run as many load
+// threads as the machine has cores, each spinning on arithmetic -- the
+// stand-in for everything else on an exchange box that wants CPU.
+//
+//   unplaced  Every thread where the OS puts it, under the ordinary
+//             scheduler -- how trading_server runs without --pin/--fifo.
+//   placed    The measured thread pinned to the last core and run
+//             SCHED_FIFO through place_current_thread(), the load threads
+//             pinned to the other cores -- the profile --pin matching=<n>
+//             --fifo matching=<p> sets up. With one core there is nowhere
+//             else for the load to go, and SCHED_FIFO alone keeps it off the
+//             measured thread.
+//
+// p50 moves little: an iteration that is not interrupted costs what it
+// costs. The tail is the point. Unplaced, an iteration now and then waits
+// out another thread's time slice, or restarts on a different core with a
+// cold cache, and p99.9 and max show it. If SCHED_FIFO is refused (no
+// CAP_SYS_NICE) or a core does not exist, the placed arm says so and runs
+// with whatever was granted.
+//
+// Each arm runs a few hundred milliseconds at most: the kernel's realtime
+// throttling (sched_rt_runtime_us, 95% of each second by default) would
+// otherwise stall a SCHED_FIFO thread that never sleeps, and that stall,
+// not placement, would be the max. Standalone rather than a Google
+// Benchmark case for the same reason as bench_matching_workload.cpp. Run
+// from a Release build only.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+
+#include "common/thread_placement.hpp"
+#include "exchange/matching/matching_engine.hpp"
+
+using namespace mdh;
+using namespace mdh::exchange;
+
+namespace {
+
+constexpr std::size_t kIterations = 200'000;
+constexpr std::size_t kWarmup = 10'000;
+constexpr InstrumentId kInstrument = 1;
+constexpr Price kTouch = 1'000;
+constexpr int kRealtimePriority = 50;
+
+struct CountingSink {
+    std::size_t* events;
+    void operator()(const ExchangeEvent&) const { ++*events; }
+};
+
+NewOrderCommand limit(CommandSequence seq, AccountId account, ClientOrderId client_id, Side side) {
+    return NewOrderCommand{.command_sequence = seq,
+                           .account_id = account,
+                           .client_order_id = client_id,
+                           .instrument_id = kInstrument,
+                           .side = side,
+                           .price = kTouch,
+                           .quantity = 1,
+                           .order_type = OrderType::Limit,
+                           .time_in_force = TimeInForce::GTC};
+}
+
+struct Result {
+    std::vector<double> ns; // sorted
+    PlacementOutcome outcome;
+};
+
+// Spins until told to stop, pinned to `cpus` if any are given.
+void load(const std::atomic<bool>& stop, std::vector<int> cpus) {
+    place_current_thread("mdh-jitter-load", ThreadPlacement{.cpus = std::move(cpus)});
+    std::uint64_t x = 1;
+    while (!stop.load(std::memory_order_relaxed)) {
+        for (int i = 0; i < 1'000; ++i) {
+            x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+        }
+    }
+    volatile std::uint64_t sink = x;
+    (void)sink;
+}
+
+Result run(bool placed, unsigned cores) {
+    const int measured_core = static_cast<int>(cores) - 1;
+    std::vector<int> load_cores;
+    if (placed) {
+        for (int core = 0; core < measured_core; ++core) {
+            load_cores.push_back(core);
+        }
+    }
+
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> loaders;
+    for (unsigned i = 0; i < cores; ++i) {
+        loaders.emplace_back(load, std::cref(stop), load_cores);
+    }
+
+    Result result;
+    std::thread measured([&] {
+        const ThreadPlacement placement =
+            placed ? ThreadPlacement{.cpus = {measured_core}, .realtime_priority = kRealtimePriority} : ThreadPlacement{};
+        result.outcome = place_current_thread("mdh-jitter", placement);
+
+        MatchingEngine engine({kInstrument}, 1'024);
+        std::size_t events = 0;
+        CommandSequence sequence = 0;
+        result.ns.reserve(kIterations);
+        for (std::size_t i = 0; i < kWarmup + kIterations; ++i) {
+            const auto start = std::chrono::steady_clock::now();
+            engine.process(limit(++sequence, 1, i + 1, Side::Sell), CountingSink{&events});
+            engine.process(limit(++sequence, 2, i + 1, Side::Buy), CountingSink{&events});
+            const auto end = std::chrono::steady_clock::now();
+            if (i >= kWarmup) {
+                result.ns.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+            }
+        }
+        if (events == 0) {
+            std::fprintf(stderr, "no events\n");
+        }
+    });
+    measured.join();
+    stop.store(true, std::memory_order_relaxed);
+    for (auto& loader : loaders) {
+        loader.join();
+    }
+    std::sort(result.ns.begin(), result.ns.end());
+    return result;
+}
+
+double percentile(const std::vector<double>& sorted, double p) {
+    const auto index = static_cast<std::size_t>(p * static_cast<double>(sorted.size() - 1));
+    return sorted[index];
+}
+
+} // namespace
+
+int main() {
+    const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    std::printf("%zu maker+taker iterations against %u spinning load thread(s) on %u core(s), ns/iteration\n",
+                kIterations, cores, cores);
+    std::printf("  %-9s %10s %10s %10s %12s %12s\n", "arm", "p50", "p99", "p99.9", "max", "mean");
+    for (const bool placed : {false, true}) {
+        const Result result = run(placed, cores);
+        double sum = 0;
+        for (const double ns : result.ns) {
+            sum += ns;
+        }
+        std::printf("  %-9s %10.0f %10.0f %10.0f %12.0f %12.0f\n", placed ? "placed" : "unplaced",
+                    percentile(result.ns, 0.50), percentile(result.ns, 0.99), percentile(result.ns, 0.999),
+                    result.ns.back(), sum / static_cast<double>(result.ns.size()));
+        if (placed && (!result.outcome.pinned || !result.outcome.realtime)) {
+            std::printf("  (placed arm ran %s%s)\n", result.outcome.pinned ? "" : "unpinned ",
+                        result.outcome.realtime ? "" : "without SCHED_FIFO");
+        }
+    }
+    return EXIT_SUCCESS;
+}
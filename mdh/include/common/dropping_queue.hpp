@@ -39,6 +39,12 @@ public:
 
     [[nodiscard]] std::optional<T> try_pop() { return queue_.try_pop(); }
 
+    // Consumer side only; see SpscQueue::consume().
+    template <typename Fn>
+    std::size_t consume(std::size_t max, Fn&& fn) {
+        return queue_.consume(max, std::forward<Fn>(fn));
+    }
+
     [[nodiscard]] std::size_t capacity() const { return queue_.capacity(); }
     [[nodiscard]] std::size_t size() const { return queue_.size(); }
     [[nodiscard]] std::size_t high_water_mark() const { return queue_.high_water_mark(); }
@@ -0,0 +1,251 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <initializer_list>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "common/wait_strategy.hpp"
+
+namespace mdh {
+
+// A bounded single-producer ring that every consumer reads in full, each at
+// its own pace -- the LMAX Disruptor's shape, for the events the matching
+// thread produces.
+//
+// SpscQueue and MpscQueue hand each element to one consumer, which takes it
+// out. Here nothing is taken out: every consumer sees every element, in
+// sequence order, and an element's slot is reused only once the slowest
+// consumer has passed it. What each consumer has read is one counter of its
+// own -- its cursor -- so adding a consumer costs the producer nothing per
+// element, and a consumer that falls behind delays the others not at all
+// until it is a whole ring behind.
+//
+// ── Sequences ──────────────────────────────────────────────────────────────
+// Elements are numbered from 0 in the order they are claimed; element n
+// lives in slot n & (capacity - 1). Three kinds of counter move along that
+// numbering, each a count of elements rather than an index:
+//
+//   producer   claimed  -- slots handed out by claim(), producer-only
+//              published -- elements consumers may read, release-stored
+//   consumer   cursor   -- elements this consumer has finished with
+//
+// A consumer reads up to the smallest of the counters it depends on: the
+// producer's `published`, or -- when it was added with upstream consumers --
+// theirs instead. That is how ordering between consumers is declared:
+// a consumer added after "journal" never sees an element before the
+// journal has finished with it. Every consumer still receives every
+// element; a dependency only delays it.
+//
+// The producer may claim element n only once every consumer's cursor has
+// passed n - capacity. claim() checks a cached copy of the slowest cursor
+// and re-reads the real ones only when that copy says the ring is full, so
+// a producer well ahead of the consumers' lag touches no consumer's line at
+// all.
+//
+// Claiming and publishing are separate, so the producer can fill several
+// slots and expose them with one release store and one round of wake-ups --
+// the matching thread publishes once per command, not once per event. A
+// run of claims that would itself fill the ring is published first, since
+// no consumer could otherwise free a slot for it.
+//
+// ── Full ───────────────────────────────────────────────────────────────────
+// A full ring makes claim() wait, spinning then yielding, for the slowest
+// consumer. Nothing is dropped: every consumer is owed every element. The
+// queues elsewhere drop or reject instead, because their producer had
+// someone to tell; here the producer is the matching thread, and an event it
+// has produced has already happened. So the ring is sized for the worst
+// consumer's worst lag, and a consumer that must never stall matching
+// bounds its own work -- e.g. the gateway's report routing, which drops
+// into a full connection queue rather than wait on it. stalls() counts
+// claims that had to wait.
+//
+// ── Waiting ────────────────────────────────────────────────────────────────
+// Each consumer has a WaitStrategy. publish() notifies the consumers that
+// read the producer's counter, and each consumer's advance notifies those
+// downstream of it, so a parked consumer is woken only by the counter it is
+// actually waiting on.
+//
+// Consumers must all be added before the first claim(). One producer
+// thread; one thread per consumer.
+template <typename T>
+class EventRing {
+public:
+    // Capacity is rounded up to the next power of two, as SpscQueue's is.
+    // Capacity 0 is treated as 1. Every slot is default-constructed up
+    // front and reused, never destroyed, for the life of the ring.
+    explicit EventRing(std::size_t capacity)
+        : capacity_(next_power_of_two(capacity)), mask_(capacity_ - 1), slots_(std::make_unique<T[]>(capacity_)) {}
+
+    EventRing(const EventRing&) = delete;
+    EventRing& operator=(const EventRing&) = delete;
+
+    // Setup only. Returns the new consumer's id. `after` names consumers,
+    // by id, that must finish with an element before this one may read it;
+    // empty reads straight behind the producer.
+    std::size_t add_consumer(std::initializer_list<std::size_t> after = {},
+                             WaitPolicy wait = WaitPolicy::SpinThenYield) {
+        const std::size_t id = consumers_.size();
+        auto consumer = std::make_unique<Consumer>(wait);
+        for (const std::size_t upstream : after) {
+            consumer->barrier.push_back(&consumers_[upstream]->cursor);
+            consumers_[upstream]->dependents.push_back(consumer.get());
+        }
+        if (after.size() == 0) {
+            consumer->barrier.push_back(&published_);
+            heads_.push_back(consumer.get());
+        }
+        consumers_.push_back(std::move(consumer));
+        return id;
+    }
+
+    // ── Producer ───────────────────────────────────────────────────────────
+
+    // The slot for the next element, which holds whatever the last lap left
+    // there: overwrite what matters. Not visible to any consumer until
+    // publish().
+    [[nodiscard]] T& claim() {
+        const std::size_t next = claimed_;
+        if (next - cached_gate_ >= capacity_) {
+            if (next - published_.load(std::memory_order_relaxed) >= capacity_) {
+                publish(); // a run this long could never be freed otherwise
+            }
+            cached_gate_ = slowest_cursor();
+            while (next - cached_gate_ >= capacity_) {
+                // The slowest consumer is a lap behind. Yield rather than
+                // spin, since on a host with fewer cores than threads it may
+                // be the one waiting for this core.
+                stalls_.fetch_add(1, std::memory_order_relaxed);
+                std::this_thread::yield();
+                cached_gate_ = slowest_cursor();
+            }
+        }
+        ++claimed_;
+        return slots_[next & mask_];
+    }
+
+    // Makes every claimed element visible, with one release store, and
+    // wakes whichever consumers read behind the producer. Free when nothing
+    // was claimed since the last call.
+    void publish() {
+        if (claimed_ == published_.load(std::memory_order_relaxed)) {
+            return;
+        }
+        published_.store(claimed_, std::memory_order_release);
+        for (Consumer* consumer : heads_) {
+            consumer->wait.notify();
+        }
+    }
+
+    // ── Consumer ───────────────────────────────────────────────────────────
+
+    // Consumer `id`'s thread only. Calls `fn(const T&)` on up to `max`
+    // elements in sequence order, then advances its cursor past all of them
+    // with one release store and wakes its dependents. Returns how many.
+    template <typename Fn>
+    std::size_t consume(std::size_t id, std::size_t max, Fn&& fn) {
+        Consumer& consumer = *consumers_[id];
+        const std::size_t from = consumer.cursor.load(std::memory_order_relaxed); // only this consumer writes it
+        const std::size_t count = std::min(available(consumer) - from, max);
+        for (std::size_t i = 0; i < count; ++i) {
+            fn(static_cast<const T&>(slots_[(from + i) & mask_]));
+        }
+        if (count > 0) {
+            consumer.cursor.store(from + count, std::memory_order_release);
+            for (Consumer* dependent : consumer.dependents) {
+                dependent->wait.notify();
+            }
+        }
+        return count;
+    }
+
+    // Consumer `id`'s thread only. Returns once there is something for it to
+    // read or `stop()` is true, waiting as its WaitPolicy says.
+    template <typename Stop>
+    void wait(std::size_t id, Stop&& stop) {
+        Consumer& consumer = *consumers_[id];
+        consumer.wait.wait_until([&] {
+            return available(consumer) != consumer.cursor.load(std::memory_order_relaxed) || stop();
+        });
+    }
+
+    // Any thread: wakes every consumer, so each re-checks whatever `stop`
+    // it is waiting with.
+    void notify_all() {
+        for (const auto& consumer : consumers_) {
+            consumer->wait.notify();
+        }
+    }
+
+    // Whether consumer `id` has read everything published so far.
+    [[nodiscard]] bool caught_up(std::size_t id) const {
+        return consumers_[id]->cursor.load(std::memory_order_acquire) == published_.load(std::memory_order_acquire);
+    }
+
+    [[nodiscard]] std::size_t published() const { return published_.load(std::memory_order_acquire); }
+    [[nodiscard]] std::size_t cursor(std::size_t id) const {
+        return consumers_[id]->cursor.load(std::memory_order_acquire);
+    }
+    [[nodiscard]] std::size_t consumer_count() const { return consumers_.size(); }
+    [[nodiscard]] std::size_t capacity() const { return capacity_; }
+
+    // Claims that found the ring full and had to wait. Zero for a ring
+    // sized to its consumers.
+    [[nodiscard]] std::size_t stalls() const { return stalls_.load(std::memory_order_relaxed); }
+
+private:
+    struct Consumer {
+        explicit Consumer(WaitPolicy policy) : wait(policy) {}
+
+        alignas(64) std::atomic<std::size_t> cursor{0}; // its own line: the producer and dependents read it
+        std::vector<const std::atomic<std::size_t>*> barrier; // the counters it reads up to
+        std::vector<Consumer*> dependents;                    // woken when it advances
+        WaitStrategy wait;
+    };
+
+    static std::size_t next_power_of_two(std::size_t n) {
+        std::size_t p = 1;
+        while (p < n) {
+            p <<= 1;
+        }
+        return p;
+    }
+
+    static std::size_t available(const Consumer& consumer) {
+        std::size_t limit = std::numeric_limits<std::size_t>::max();
+        for (const auto* counter : consumer.barrier) {
+            limit = std::min(limit, counter->load(std::memory_order_acquire));
+        }
+        return limit;
+    }
+
+    // Every consumer gates the producer, not only the last of each chain: a
+    // downstream cursor is never ahead of its upstream's, so this costs a
+    // few extra loads on the slow path and saves tracking chain ends.
+    std::size_t slowest_cursor() const {
+        std::size_t slowest = published_.load(std::memory_order_relaxed);
+        for (const auto& consumer : consumers_) {
+            slowest = std::min(slowest, consumer->cursor.load(std::memory_order_acquire));
+        }
+        return slowest;
+    }
+
+    std::size_t capacity_;
+    std::size_t mask_;
+    std::unique_ptr<T[]> slots_;
+    std::vector<std::unique_ptr<Consumer>> consumers_;
+    std::vector<Consumer*> heads_; // consumers reading straight behind the producer
+    std::atomic<std::size_t> stalls_{0};
+
+    // Producer-only.
+    std::size_t claimed_ = 0;
+    std::size_t cached_gate_ = 0; // slowest cursor, as last read
+
+    alignas(64) std::atomic<std::size_t> published_{0}; // its own line: every head consumer reads it
+};
+
+} // namespace mdh
@@ -0,0 +1,209 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <optional>
+#include <utility>
+
+namespace mdh {
+
+// A bounded, multi-producer single-consumer ring buffer.
+//
+// SpscQueue's sibling for the one place in this project where several
+// threads feed one consumer: the gateway's reader threads all submitting to
+// the matching thread. SpscQueue gets away with plain loads and stores
+// because each index has exactly one writer; here every producer writes the
+// tail, so something has to decide which producer owns which slot. That
+// something is a compare-and-swap on `tail_`, taken only once the slot at
+// that position has been seen to be free (Vyukov's bounded MPMC design, cut
+// down to one consumer). Each slot carries its own sequence number:
+//
+//   seq == pos            free, waiting for the producer that claims pos
+//   seq == pos + 1        filled, waiting for the consumer
+//   seq == pos + capacity freed by the consumer, waiting for pos + capacity
+//
+// A producer reads the slot at the current tail first. Free, and it tries
+// to move the tail past it; a failed CAS means another producer took that
+// position, and it tries the next. Still holding last lap's value, and the
+// queue is full: try_push() returns false there and then, having claimed
+// nothing. A producer never owns a position it cannot fill straight away,
+// so no push waits on the consumer -- not even one racing others for the
+// last free slot of a queue whose consumer has stopped. The CAS is retried
+// only when another producer won the same position, which is progress for
+// the queue as a whole, and contention costs no more than the cache-line
+// transfer a fetch_add would have paid.
+//
+// The winning producer constructs into the slot and release-stores
+// `pos + 1`; the consumer acquire-loads that before it reads the value, and
+// release-stores `pos + capacity` after it has destroyed it, which is what
+// makes the slot free for the next lap's producer. Claiming a position and
+// filling it are still two steps, so a filled slot behind an unfilled one
+// simply waits: the consumer stops at the first slot that is not ready, so
+// what comes out is the order in which positions were claimed, and each
+// producer's own pushes stay in the order it made them.
+//
+// Full is decided by the slot, not by the consumer's `head_`, which the
+// consumer publishes once per consume() batch: a slot is free as soon as
+// its own sequence store says so, and the consumer itself can push into
+// room it made earlier in the same batch.
+//
+// Slots and the two indices are each padded to their own cache line, for
+// the same false-sharing reason as SpscQueue's indices: producers filling
+// neighbouring slots should not invalidate each other's lines, nor the
+// consumer's.
+template <typename T>
+class MpscQueue {
+public:
+    // Capacity is rounded up to the next power of two, as SpscQueue's is,
+    // but never below 2: with one slot, the sequence that marks it filled
+    // for one lap is the one that marks it free for the next.
+    explicit MpscQueue(std::size_t capacity)
+        : capacity_(next_power_of_two(std::max<std::size_t>(capacity, 2))), mask_(capacity_ - 1), slots_(std::make_unique<Slot[]>(capacity_)) {
+        for (std::size_t i = 0; i < capacity_; ++i) {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // Only the values between head and tail are live; no producer may still
+    // be pushing once the queue is being destroyed.
+    ~MpscQueue() {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        for (std::size_t i = head_.load(std::memory_order_relaxed); i != tail; ++i) {
+            std::destroy_at(slots_[i & mask_].value());
+        }
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+    MpscQueue(MpscQueue&&) = delete;
+    MpscQueue& operator=(MpscQueue&&) = delete;
+
+    // Any thread. Returns false, leaving `value` unconsumed, if the queue
+    // is full. Never waits: see the class comment.
+    [[nodiscard]] bool try_push(T value) { return try_emplace(std::move(value)); }
+
+    // Any thread. Constructs the element in its slot from `args`, as
+    // SpscQueue::try_emplace() does; false, constructing nothing, if full.
+    template <typename... Args>
+    [[nodiscard]] bool try_emplace(Args&&... args) {
+        std::size_t pos = tail_.load(std::memory_order_relaxed);
+        Slot* slot = nullptr;
+        while (true) {
+            slot = &slots_[pos & mask_];
+            const std::size_t seq = slot->sequence.load(std::memory_order_acquire);
+            const auto lag = static_cast<std::ptrdiff_t>(seq - pos);
+            if (lag == 0) {
+                // Free. On failure the CAS reloads `pos` with the tail some
+                // other producer has since moved it to.
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (lag < 0) {
+                return false; // full: the consumer has not freed this slot from its previous lap
+            } else {
+                pos = tail_.load(std::memory_order_relaxed); // claimed and filled under us; look again
+            }
+        }
+        std::construct_at(slot->value(), std::forward<Args>(args)...);
+        slot->sequence.store(pos + 1, std::memory_order_release); // publishes the constructed slot to the consumer
+
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        raise_high_water_mark(std::min(pos + 1 - head, capacity_)); // head may be stale, never beyond capacity
+        return true;
+    }
+
+    // Consumer side only. Returns std::nullopt if the next slot in claim
+    // order is not filled yet -- which includes a slot whose producer has
+    // claimed it and is still constructing, even if later ones are ready.
+    [[nodiscard]] std::optional<T> try_pop() {
+        const std::size_t head = head_.load(std::memory_order_relaxed); // only the consumer writes head_
+        Slot& slot = slots_[head & mask_];
+        if (slot.sequence.load(std::memory_order_acquire) != head + 1) {
+            return std::nullopt; // empty, or the next producer has not finished
+        }
+        T value = std::move(*slot.value());
+        std::destroy_at(slot.value());
+        slot.sequence.store(head + capacity_, std::memory_order_release); // frees the slot for the next lap
+        head_.store(head + 1, std::memory_order_release);
+        return value;
+    }
+
+    // Consumer side only. The batch form of try_pop(), with the same
+    // contract as SpscQueue::consume(): `fn(T&)` on up to `max` elements in
+    // place, stopping early at the first slot not yet filled. Each slot is
+    // still freed by its own sequence store, since that is what its next
+    // producer waits on, but `head_` -- the line every producer reads in
+    // its full check -- is published once for the batch.
+    template <typename Fn>
+    std::size_t consume(std::size_t max, Fn&& fn) {
+        const std::size_t head = head_.load(std::memory_order_relaxed); // only the consumer writes head_
+        std::size_t count = 0;
+        for (; count < max; ++count) {
+            Slot& slot = slots_[(head + count) & mask_];
+            if (slot.sequence.load(std::memory_order_acquire) != head + count + 1) {
+                break; // empty, or the next producer has not finished
+            }
+            fn(*slot.value());
+            std::destroy_at(slot.value());
+            slot.sequence.store(head + count + capacity_, std::memory_order_release);
+        }
+        if (count > 0) {
+            head_.store(head + count, std::memory_order_release);
+        }
+        return count;
+    }
+
+    [[nodiscard]] std::size_t capacity() const { return capacity_; }
+
+    // Positions claimed and not yet popped, including any a producer is
+    // still filling. A best-effort snapshot with the same caveats as
+    // SpscQueue::size().
+    [[nodiscard]] std::size_t size() const {
+        const std::size_t head = head_.load(std::memory_order_acquire);
+        const std::size_t tail = tail_.load(std::memory_order_acquire);
+        return tail - head;
+    }
+
+    // Largest occupancy any producer observed on its own push. As in
+    // SpscQueue, monotonically non-decreasing.
+    [[nodiscard]] std::size_t high_water_mark() const { return high_water_mark_.load(std::memory_order_acquire); }
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<std::size_t> sequence;
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        T* value() { return std::launder(reinterpret_cast<T*>(storage)); }
+    };
+
+    static std::size_t next_power_of_two(std::size_t n) {
+        std::size_t p = 1;
+        while (p < n) {
+            p <<= 1;
+        }
+        return p;
+    }
+
+    // Several producers write this, unlike SpscQueue's, so raising it is a
+    // CAS -- but only when the mark actually moves, which after warm-up is
+    // almost never; the common case is one relaxed load.
+    void raise_high_water_mark(std::size_t occupancy) {
+        std::size_t seen = high_water_mark_.load(std::memory_order_relaxed);
+        while (occupancy > seen &&
+               !high_water_mark_.compare_exchange_weak(seen, occupancy, std::memory_order_relaxed)) {
+        }
+    }
+
+    std::size_t capacity_;
+    std::size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+    std::atomic<std::size_t> high_water_mark_{0};
+
+    alignas(64) std::atomic<std::size_t> tail_{0}; // next position a producer will claim
+    alignas(64) std::atomic<std::size_t> head_{0}; // next position the consumer will read
+};
+
+} // namespace mdh
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <atomic>
 #include <cstddef>
 #include <memory>
@@ -29,6 +30,29 @@ namespace mdh {
 // sharing) -- they're logically independent counters, so they shouldn't
 // share a cache line just because they're declared next to each other.
 //
+// Padding stops the two sides *writing* each other's lines, but reading
+// the other side's index still pulls its line across on every call. So
+// each side keeps a plain, private copy of the other's index as last seen
+// (`cached_tail_` next to `head_`, `cached_head_` next to `tail_`) and
+// reloads the real one only when the copy says it must: the producer when
+// the queue looks full (or, see try_emplace(), about to set a new high
+// water mark), the consumer when it looks empty. A stale copy is always
+// conservative -- it can only make the queue look fuller to the producer
+// or emptier to the consumer than it is -- so correctness never depends
+// on it being fresh. A producer running well ahead of its consumer then
+// touches the consumer's line once per lap rather than once per push. The
+// high-water-mark condition is the price of keeping that mark exact: a
+// queue that has never been more than a few deep reloads often, since any
+// push might be its new peak, while one that has absorbed a burst -- the
+// case where throughput matters -- rarely does.
+//
+// consume() is the batch form of try_pop(): it hands up to n elements to a
+// callback in place, without moving each one out into an optional first,
+// and frees all of their slots with a single release-store of `tail_` --
+// one cache-line transfer back to the producer per batch rather than per
+// element. try_emplace() is the matching producer-side form, constructing
+// straight into the slot.
+//
 // try_push()/try_pop() only -- neither blocks. This is deliberate: a live
 // UDP receive loop must never stall waiting for a slow consumer (that
 // would mean not reading off the socket, i.e. dropping packets at the OS
@@ -64,19 +88,32 @@ public:
 
     // Producer side only. Returns false, leaving `value` unconsumed, if
     // the queue is currently full.
-    [[nodiscard]] bool try_push(T value) {
+    [[nodiscard]] bool try_push(T value) { return try_emplace(std::move(value)); }
+
+    // Producer side only. Constructs the element in its slot from `args`;
+    // returns false, constructing nothing, if the queue is currently full.
+    template <typename... Args>
+    [[nodiscard]] bool try_emplace(Args&&... args) {
         const std::size_t head = head_.load(std::memory_order_relaxed); // only the producer writes head_
-        const std::size_t tail = tail_.load(std::memory_order_acquire); // syncs with consumer's destroy_at before this slot is reused
-        if (head - tail >= capacity_) {
-            return false; // full
-        }
-        std::construct_at(storage_ + (head & mask_), std::move(value));
 
-        const std::size_t new_occupancy = head + 1 - tail;
-        if (new_occupancy > high_water_mark_.load(std::memory_order_relaxed)) {
-            high_water_mark_.store(new_occupancy, std::memory_order_relaxed); // only the producer writes this, so no CAS needed
+        // Against the cached tail, occupancy can only be overstated. Reload
+        // only if that overstatement would matter: the queue looks full, or
+        // this push looks like a new high water mark, which must be recorded
+        // exactly. The mark never exceeds capacity_, so the first condition
+        // implies the second and one comparison covers both.
+        std::size_t new_occupancy = head + 1 - cached_tail_;
+        const std::size_t mark = high_water_mark_.load(std::memory_order_relaxed); // only the producer writes it
+        if (new_occupancy > mark) {
+            cached_tail_ = tail_.load(std::memory_order_acquire); // syncs with consumer's destroy_at before this slot is reused
+            new_occupancy = head + 1 - cached_tail_;
+            if (new_occupancy > capacity_) {
+                return false; // full
+            }
+            if (new_occupancy > mark) {
+                high_water_mark_.store(new_occupancy, std::memory_order_relaxed); // only the producer writes this, so no CAS needed
+            }
         }
-
+        std::construct_at(storage_ + (head & mask_), std::forward<Args>(args)...);
         head_.store(head + 1, std::memory_order_release); // publishes the constructed slot to the consumer
         return true;
     }
@@ -85,9 +122,11 @@ public:
     // empty.
     [[nodiscard]] std::optional<T> try_pop() {
         const std::size_t tail = tail_.load(std::memory_order_relaxed); // only the consumer writes tail_
-        const std::size_t head = head_.load(std::memory_order_acquire); // syncs with producer's construct_at before we read this slot
-        if (tail == head) {
-            return std::nullopt; // empty
+        if (tail == cached_head_) {
+            cached_head_ = head_.load(std::memory_order_acquire); // syncs with producer's construct_at before we read this slot
+            if (tail == cached_head_) {
+                return std::nullopt; // empty
+            }
         }
         T value = std::move(*(storage_ + (tail & mask_)));
         std::destroy_at(storage_ + (tail & mask_));
@@ -95,6 +134,30 @@ public:
         return value;
     }
 
+    // Consumer side only. Calls `fn(T&)` on up to `max` elements in FIFO
+    // order, each in place in its slot -- `fn` may move from it -- and
+    // destroys each right after. Returns how many it handed over, 0 if the
+    // queue was empty. Elements pushed while this runs wait for the next
+    // call: the batch is fixed by one load of head_ up front, and its slots
+    // are released together by one store at the end.
+    template <typename Fn>
+    std::size_t consume(std::size_t max, Fn&& fn) {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed); // only the consumer writes tail_
+        if (cached_head_ - tail < max) {
+            cached_head_ = head_.load(std::memory_order_acquire); // syncs with every construct_at up to this head
+        }
+        const std::size_t count = std::min(cached_head_ - tail, max);
+        for (std::size_t i = tail; i != tail + count; ++i) {
+            T* slot = storage_ + (i & mask_);
+            fn(*slot);
+            std::destroy_at(slot);
+        }
+        if (count > 0) {
+            tail_.store(tail + count, std::memory_order_release); // publishes every freed slot at once
+        }
+        return count;
+    }
+
     [[nodiscard]] std::size_t capacity() const { return capacity_; }
 
     // Current occupancy. A best-effort snapshot, not a synchronized read
@@ -126,11 +189,13 @@ private:
     std::size_t mask_;
     std::allocator<T> alloc_;
     T* storage_;
-    std::atomic<std::size_t> high_water_mark_{0}; // written only by the producer (in try_push); no false-sharing
+    std::atomic<std::size_t> high_water_mark_{0}; // written only by the producer (in try_emplace); no false-sharing
                                                    // concern with head_ since the same thread writes both
 
     alignas(64) std::atomic<std::size_t> head_{0}; // next slot the producer will write
+    std::size_t cached_tail_ = 0;                  // producer only: tail_ as last loaded, on head_'s line
     alignas(64) std::atomic<std::size_t> tail_{0}; // next slot the consumer will read
+    std::size_t cached_head_ = 0;                  // consumer only: head_ as last loaded, on tail_'s line
 };
 
 } // namespace mdh
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+// Where a long-lived thread runs, and under what name.
+//
+// Left alone, the OS schedules every thread anywhere and migrates it
+// whenever it likes. For most of this project that is the right call. For
+// the matching thread it costs twice: a migration leaves the books' cache
+// lines on the core it came from, and a thread that shares its core with
+// whatever else is runnable waits its turn behind it. Both show up as the
+// occasional command that takes ten times as long as its neighbours --
+// jitter, not throughput.
+//
+// So each thread role gets a ThreadPlacement, set from configuration: the
+// cores it may run on, and whether it runs SCHED_FIFO, i.e. ahead of every
+// ordinary thread on those cores. The thread applies its own placement as
+// the first thing it does, through place_current_thread(), which also names
+// it -- "mdh-matching" in top, perf and gdb rather than the process name
+// repeated once per thread.
+//
+// Every step is best effort. Naming is always possible on Linux; pinning
+// fails for a core that does not exist or is outside this process's
+// cpuset; SCHED_FIFO needs CAP_SYS_NICE or an RLIMIT_RTPRIO allowance. A
+// refused step leaves the thread as the OS would have had it and is
+// reported in the outcome rather than failing the thread: an exchange that
+// cannot get the isolation it asked for should still trade. Elsewhere than
+// Linux, only naming is attempted.
+//
+// SCHED_FIFO on a thread that never blocks -- a busy-spinning matching
+// thread, see WaitPolicy -- owns its core outright; that is the point, and
+// also why it belongs on a core nothing else was pinned to.
+namespace mdh {
+
+// The threads whose placement can be configured. Names below are what
+// configuration uses for them (see thread_role_from_name()).
+enum class ThreadRole : std::uint8_t {
+    Matching,      // the pipeline's matching thread: "matching"
+    GatewayAccept, // the gateway's accept loop, clock ticks and auctions: "accept"
+    GatewayReader, // one per connection, decoding and submitting: "reader"
+    GatewayWriter, // one per connection, writing reports: "writer"
+    Snapshot,      // the background snapshotter: "snapshot"
+    MarketData,    // the UI gateway's market-data receiver: "market_data"
+    Routing,       // the gateway's execution-report router: "routing"
+    Publishing,    // the gateway's extra_event_sink, e.g. market data out: "publishing"
+    GatewayIo,     // the gateway's epoll event loops, when it runs them: "io"
+};
+inline constexpr std::size_t kThreadRoleCount = 9;
+
+struct ThreadPlacement {
+    // The cores this thread may run on. Empty leaves it to the OS.
+    std::vector<int> cpus{};
+
+    // Above zero, run SCHED_FIFO at this priority (1-99 on Linux); zero
+    // leaves the thread under the ordinary time-sharing scheduler.
+    int realtime_priority = 0;
+};
+
+// What place_current_thread() managed. A step that was not asked for
+// counts as done.
+struct PlacementOutcome {
+    bool named = false;
+    bool pinned = false;
+    bool realtime = false;
+};
+
+// One ThreadPlacement per role. Default-constructed, every role is left to
+// the OS -- exactly how every thread ran before this existed.
+struct ThreadPlacementProfile {
+    std::array<ThreadPlacement, kThreadRoleCount> roles{};
+
+    [[nodiscard]] ThreadPlacement& operator[](ThreadRole role) { return roles[static_cast<std::size_t>(role)]; }
+    [[nodiscard]] const ThreadPlacement& operator[](ThreadRole role) const {
+        return roles[static_cast<std::size_t>(role)];
+    }
+};
+
+// Names, pins and schedules the calling thread. `name` is cut to the
+// fifteen characters Linux keeps.
+PlacementOutcome place_current_thread(std::string_view name, const ThreadPlacement& placement);
+
+// The configuration name of `role`, and back. Unknown names give nullopt.
+[[nodiscard]] std::string_view thread_role_name(ThreadRole role);
+[[nodiscard]] std::optional<ThreadRole> thread_role_from_name(std::string_view name);
+
+// A Linux-style CPU list -- "3", "0,2", "4-7", "0,4-7" -- as the cores it
+// names, ascending and without repeats. Nullopt for anything malformed,
+// including an empty list or a range that runs backwards.
+[[nodiscard]] std::optional<std::vector<int>> parse_cpu_list(std::string_view text);
+
+} // namespace mdh
@@ -0,0 +1,295 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "common/types.hpp"
+
+namespace mdh {
+
+// A hierarchical timer wheel: timers keyed by a Timestamp, each fired once
+// the wheel has been advanced to or past it.
+//
+// Four levels of 256 slots. A timer goes into the lowest level whose slots
+// still cover its deadline from where the wheel now stands: level 0 holds
+// what is due in the current 256 ticks, level 1 what is due in the current
+// 65,536, and so on. When the wheel reaches a slot of a higher level, the
+// timers in it are re-filed one level down -- nearer now, so into finer
+// slots -- until they land in level 0 and fire. Each timer is re-filed at
+// most once per level, so scheduling, cancelling and firing are all O(1)
+// no matter how many timers are pending. Deadlines past the top level's
+// reach (2^32 ticks) wait on an overflow list, re-filed when the wheel
+// crosses into their span.
+//
+// Nothing here reads a clock. advance() is told what time it is, and which
+// timers fire in what order depends only on the sequence of calls made, so
+// a wheel driven from a journaled time source fires exactly the same timers
+// in exactly the same order on replay. Within one tick, that order is not
+// the order of the timers' exact times.
+//
+// Advancing costs the slots that hold something, not the ticks that
+// passed: each level keeps a bitmap of its occupied slots, and advance()
+// jumps from one occupied slot to the next. A wheel told the time once a
+// second does no more work than one told it every millisecond.
+//
+// A timer fires no earlier than its deadline, and at most one tick after
+// it, since deadlines are rounded up to a whole tick. Single-threaded; the
+// fire callback must not schedule or cancel timers on the wheel firing it.
+template <class Payload>
+class TimerWheel {
+public:
+    using TimerId = std::uint32_t;
+    static constexpr TimerId kNoTimer = std::numeric_limits<TimerId>::max();
+
+    static constexpr std::size_t kLevels = 4;
+    static constexpr std::size_t kSlotBits = 8;
+    static constexpr std::size_t kSlots = std::size_t{1} << kSlotBits;
+
+    // `tick` is the wheel's resolution, in the same units as the times it
+    // is given. Zero is treated as 1.
+    explicit TimerWheel(Timestamp tick, std::size_t expected_timers = 0) : tick_(tick == 0 ? 1 : tick) {
+        nodes_.reserve(expected_timers);
+    }
+
+    // Fires `payload` once the wheel reaches `at`. A time the wheel has
+    // already reached fires at its next tick.
+    TimerId schedule(Timestamp at, Payload payload) {
+        TimerId id = free_;
+        if (id != kNoTimer) {
+            free_ = nodes_[id].next;
+        } else {
+            id = static_cast<TimerId>(nodes_.size());
+            nodes_.emplace_back();
+        }
+        Node& node = nodes_[id];
+        node.at = at;
+        node.deadline = std::max(deadline_of(at), now_tick_ + 1);
+        node.payload = std::move(payload);
+        file(id);
+        ++size_;
+        return id;
+    }
+
+    // Forgets a pending timer. `id` must be one schedule() returned that has
+    // neither fired nor been cancelled.
+    void cancel(TimerId id) {
+        unlink(id);
+        release(id);
+    }
+
+    // The time a pending timer was scheduled for, exactly as given.
+    [[nodiscard]] Timestamp expires_at(TimerId id) const { return nodes_[id].at; }
+
+    // Moves the wheel to `now`, calling fire(payload, at) for every timer
+    // due by then, earliest tick first. A `now` behind the wheel's is
+    // ignored. Returns how many fired.
+    template <class Fire>
+    std::size_t advance(Timestamp now, Fire&& fire) {
+        const std::uint64_t target = now / tick_;
+        std::size_t fired = 0;
+        while (now_tick_ < target) {
+            const auto [level, at_tick] = next_event();
+            if (at_tick > target) {
+                now_tick_ = target;
+                break;
+            }
+            now_tick_ = at_tick;
+            if (level == kLevels) {
+                fired += refile_overflow(fire);
+            } else {
+                fired += refile_slot(level, slot_of(now_tick_, level), fire);
+            }
+        }
+        return fired;
+    }
+
+    [[nodiscard]] std::size_t size() const { return size_; }
+    [[nodiscard]] bool empty() const { return size_ == 0; }
+    [[nodiscard]] Timestamp tick() const { return tick_; }
+
+private:
+    static constexpr std::uint32_t kNone = std::numeric_limits<std::uint32_t>::max();
+    static constexpr std::uint32_t kOverflow = kLevels * kSlots;
+    static constexpr std::uint64_t kNever = std::numeric_limits<std::uint64_t>::max();
+
+    struct Node {
+        Timestamp at = 0;
+        std::uint64_t deadline = 0; // in ticks, rounded up
+        std::uint32_t next = kNone; // doubles as the free list's link
+        std::uint32_t prev = kNone;
+        std::uint32_t bucket = kNone; // level * kSlots + slot, or kOverflow
+        Payload payload{};
+    };
+
+    struct List {
+        std::uint32_t head = kNone;
+        std::uint32_t tail = kNone;
+    };
+
+    [[nodiscard]] std::uint64_t deadline_of(Timestamp at) const { return at / tick_ + (at % tick_ != 0 ? 1 : 0); }
+
+    [[nodiscard]] static std::size_t slot_of(std::uint64_t tick, std::size_t level) {
+        return static_cast<std::size_t>(tick >> (level * kSlotBits)) & (kSlots - 1);
+    }
+
+    // The lowest level whose current span includes `deadline`: the two
+    // agree on every bit above it. kLevels if none does.
+    [[nodiscard]] std::size_t level_for(std::uint64_t deadline) const {
+        for (std::size_t level = 0; level < kLevels; ++level) {
+            const std::size_t above = (level + 1) * kSlotBits;
+            if ((deadline >> above) == (now_tick_ >> above)) {
+                return level;
+            }
+        }
+        return kLevels;
+    }
+
+    void file(std::uint32_t id) {
+        Node& node = nodes_[id];
+        const std::size_t level = level_for(node.deadline);
+        if (level == kLevels) {
+            node.bucket = kOverflow;
+            overflow_min_ = std::min(overflow_min_, node.deadline);
+            append(overflow_, id);
+            return;
+        }
+        const std::size_t slot = slot_of(node.deadline, level);
+        node.bucket = static_cast<std::uint32_t>(level * kSlots + slot);
+        append(slots_[level][slot], id);
+        occupied_[level][slot / 64] |= std::uint64_t{1} << (slot % 64);
+    }
+
+    void append(List& list, std::uint32_t id) {
+        Node& node = nodes_[id];
+        node.next = kNone;
+        node.prev = list.tail;
+        if (list.tail != kNone) {
+            nodes_[list.tail].next = id;
+        } else {
+            list.head = id;
+        }
+        list.tail = id;
+    }
+
+    void unlink(std::uint32_t id) {
+        Node& node = nodes_[id];
+        List& list = node.bucket == kOverflow ? overflow_ : slots_[node.bucket / kSlots][node.bucket % kSlots];
+        if (node.prev != kNone) {
+            nodes_[node.prev].next = node.next;
+        } else {
+            list.head = node.next;
+        }
+        if (node.next != kNone) {
+            nodes_[node.next].prev = node.prev;
+        } else {
+            list.tail = node.prev;
+        }
+        if (list.head == kNone && node.bucket != kOverflow) {
+            const std::size_t slot = node.bucket % kSlots;
+            occupied_[node.bucket / kSlots][slot / 64] &= ~(std::uint64_t{1} << (slot % 64));
+        }
+    }
+
+    void release(std::uint32_t id) {
+        Node& node = nodes_[id];
+        node.bucket = kNone;
+        node.payload = Payload{};
+        node.next = free_;
+        free_ = id;
+        --size_;
+    }
+
+    // The first occupied slot of `level` after the one the wheel is on, or
+    // kSlots if there is none before the level wraps.
+    [[nodiscard]] std::size_t next_occupied(std::size_t level) const {
+        const std::size_t from = slot_of(now_tick_, level) + 1;
+        for (std::size_t word = from / 64; word < kSlots / 64; ++word) {
+            std::uint64_t bits = occupied_[level][word];
+            if (word == from / 64) {
+                bits &= from % 64 == 0 ? ~std::uint64_t{0} : ~((std::uint64_t{1} << (from % 64)) - 1);
+            }
+            if (bits != 0) {
+                return word * 64 + static_cast<std::size_t>(std::countr_zero(bits));
+            }
+        }
+        return kSlots;
+    }
+
+    // Where the wheel next has something to do, as (level, tick): the
+    // nearest occupied slot of the lowest level that has one ahead, since
+    // every slot of a lower level comes before any of a higher one. Every
+    // timer is filed ahead of the wheel, so nothing is ever behind it.
+    [[nodiscard]] std::pair<std::size_t, std::uint64_t> next_event() const {
+        for (std::size_t level = 0; level < kLevels; ++level) {
+            const std::size_t slot = next_occupied(level);
+            if (slot == kSlots) {
+                continue;
+            }
+            const std::size_t shift = level * kSlotBits;
+            const std::uint64_t span_start = (now_tick_ >> (shift + kSlotBits)) << (shift + kSlotBits);
+            return {level, span_start | (std::uint64_t{slot} << shift)};
+        }
+        if (overflow_.head == kNone) {
+            return {kLevels, kNever};
+        }
+        constexpr std::size_t kReach = kLevels * kSlotBits;
+        return {kLevels, (overflow_min_ >> kReach) << kReach};
+    }
+
+    // The wheel has just reached this slot: fire what is due and file the
+    // rest one level nearer.
+    template <class Fire>
+    std::size_t refile_slot(std::size_t level, std::size_t slot, Fire& fire) {
+        List taken = std::exchange(slots_[level][slot], List{});
+        occupied_[level][slot / 64] &= ~(std::uint64_t{1} << (slot % 64));
+        return refile(taken, fire);
+    }
+
+    template <class Fire>
+    std::size_t refile_overflow(Fire& fire) {
+        List taken = std::exchange(overflow_, List{});
+        overflow_min_ = kNever;
+        return refile(taken, fire);
+    }
+
+    template <class Fire>
+    std::size_t refile(List taken, Fire& fire) {
+        std::size_t fired = 0;
+        for (std::uint32_t id = taken.head; id != kNone;) {
+            Node& node = nodes_[id];
+            const std::uint32_t next = node.next;
+            if (node.deadline <= now_tick_) {
+                const Timestamp at = node.at;
+                Payload payload = std::move(node.payload);
+                release(id);
+                fire(std::as_const(payload), at);
+                ++fired;
+            } else {
+                file(id); // ahead of the wheel, so always into a lower level
+            }
+            id = next;
+        }
+        return fired;
+    }
+
+    Timestamp tick_;
+    std::uint64_t now_tick_ = 0;
+    std::vector<Node> nodes_;
+    std::uint32_t free_ = kNone;
+    std::size_t size_ = 0;
+    std::array<std::array<List, kSlots>, kLevels> slots_{};
+    std::array<std::array<std::uint64_t, kSlots / 64>, kLevels> occupied_{};
+    List overflow_;
+    // No greater than the smallest deadline on the overflow list: exact when
+    // set, and left as it was when a cancel removes the smallest, which
+    // costs at most one early, empty visit.
+    std::uint64_t overflow_min_ = kNever;
+};
+
+} // namespace mdh
@@ -0,0 +1,217 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <thread>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace mdh {
+
+// What a consumer thread does while it has nothing to consume.
+//
+//   BusySpin       Re-checks as fast as it can, with a CPU pause hint
+//                  between checks. The lowest wake-up latency there is, at
+//                  the price of a core pinned at 100% whether or not there
+//                  is work -- only for a thread that has a core to itself.
+//   SpinThenYield  Spins briefly, then gives its time slice back on every
+//                  re-check. What the matching thread always did. Still
+//                  shows as a busy core (each yield is a syscall straight
+//                  back into the run queue), but lets other threads run on
+//                  it.
+//   Park           Spins briefly, then sleeps in the kernel until a
+//                  producer wakes it. Near-zero idle CPU; the first message
+//                  after a sleep pays one futex wake. Producers pay for the
+//                  wake only when the consumer is actually parked.
+enum class WaitPolicy : std::uint8_t { BusySpin, SpinThenYield, Park };
+
+// One consumer's idle loop, and the producer-side half of waking it, behind
+// a policy chosen at construction -- so the matching thread and the
+// gateway's writer threads can each be configured for latency or for idle
+// CPU without either knowing which.
+//
+// The consumer calls wait_until(ready) once its queue comes up empty;
+// `ready` is its own "is there work, or should I stop" check, and
+// wait_until() returns as soon as that is true. Every producer calls
+// notify() after publishing anything `ready` could observe -- a queued
+// item, a stop request, a closed connection.
+//
+// ── Parking without losing a wake-up ──────────────────────────────────────
+// The consumer announces it is about to sleep by setting `parked_`, checks
+// `ready` one last time, and only then sleeps on `parked_` (a raw FUTEX_WAIT
+// on Linux, std::atomic::wait elsewhere -- see below for why not
+// std::atomic::wait everywhere). A producer publishes, then reads `parked_`
+// and wakes the consumer only if it is set. Each side writes one location
+// and then reads the other's, which is the one pattern acquire/release does
+// not order -- both could read the old value and the consumer would sleep on
+// a published item. A seq_cst fence between the write and the read on each
+// side rules that out: either the producer sees `parked_` set and wakes it,
+// or the consumer's last check sees the item.
+//
+// A notify() that finds nobody parked is one fence and one load. Several
+// producers may race to wake the same consumer; exchange() lets exactly one
+// of them make the wake call.
+//
+// On Linux the sleep is a futex called directly rather than through
+// std::atomic::wait, which has no timed form: wait_until() with a deadline
+// parks too, and wakes on notify() or at the deadline, whichever is first.
+// Elsewhere a wait with a deadline yields instead of parking.
+//
+// Single waiter. notify() is safe from any thread.
+class WaitStrategy {
+public:
+    explicit WaitStrategy(WaitPolicy policy = WaitPolicy::SpinThenYield) : policy_(policy) {}
+
+    WaitStrategy(const WaitStrategy&) = delete;
+    WaitStrategy& operator=(const WaitStrategy&) = delete;
+
+    [[nodiscard]] WaitPolicy policy() const { return policy_; }
+
+    // Consumer side only. Returns once `ready()` is true.
+    template <typename Ready>
+    void wait_until(Ready&& ready) {
+        if (policy_ == WaitPolicy::BusySpin) {
+            while (!ready()) {
+                cpu_relax();
+            }
+            return;
+        }
+        for (int spin = 0; spin < kSpinChecks; ++spin) {
+            if (ready()) {
+                return;
+            }
+            cpu_relax();
+        }
+        if (policy_ == WaitPolicy::SpinThenYield) {
+            while (!ready()) {
+                std::this_thread::yield();
+            }
+            return;
+        }
+        while (true) {
+            parked_.store(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst); // see "Parking without losing a wake-up"
+            if (ready()) {
+                parked_.store(0, std::memory_order_relaxed);
+                return;
+            }
+            parks_.fetch_add(1, std::memory_order_relaxed);
+            while (parked_.load(std::memory_order_acquire) != 0) {
+                park(nullptr); // until a producer has cleared it
+            }
+            if (ready()) {
+                return;
+            }
+        }
+    }
+
+    // Consumer side only. As above, but gives up at `deadline`: returns
+    // whether `ready()` came true before it did. For a consumer that has
+    // something else to do at a known time, e.g. a writer whose linger is up.
+    template <typename Ready, typename Clock, typename Duration>
+    bool wait_until(Ready&& ready, std::chrono::time_point<Clock, Duration> deadline) {
+        for (int spin = 0; policy_ != WaitPolicy::BusySpin && spin < kSpinChecks; ++spin) {
+            if (ready()) {
+                return true;
+            }
+            cpu_relax();
+        }
+#if defined(__linux__)
+        const bool parks = policy_ == WaitPolicy::Park;
+#else
+        const bool parks = false; // no timed sleep to park in -- see the class comment
+#endif
+        while (!parks) {
+            if (ready()) {
+                return true;
+            }
+            if (Clock::now() >= deadline) {
+                return false;
+            }
+            if (policy_ == WaitPolicy::BusySpin) {
+                cpu_relax();
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        while (true) {
+            parked_.store(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst); // see "Parking without losing a wake-up"
+            if (ready()) {
+                parked_.store(0, std::memory_order_relaxed);
+                return true;
+            }
+            const auto left = deadline - Clock::now();
+            if (left <= Duration::zero()) {
+                parked_.store(0, std::memory_order_relaxed); // so that producers stop paying for a wake
+                return false;
+            }
+            const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(left).count();
+            const std::timespec timeout{.tv_sec = static_cast<std::time_t>(ns / 1'000'000'000),
+                                   .tv_nsec = static_cast<long>(ns % 1'000'000'000)};
+            parks_.fetch_add(1, std::memory_order_relaxed);
+            park(&timeout); // woken, timed out or interrupted: the loop re-checks all three
+            if (ready()) {
+                parked_.store(0, std::memory_order_relaxed);
+                return true;
+            }
+        }
+    }
+
+    // Any thread, after publishing. Free unless the policy is Park, and then
+    // only a fence and a load unless the consumer is actually asleep.
+    void notify() {
+        if (policy_ != WaitPolicy::Park) {
+            return;
+        }
+        std::atomic_thread_fence(std::memory_order_seq_cst); // see "Parking without losing a wake-up"
+        if (parked_.load(std::memory_order_relaxed) != 0 && parked_.exchange(0, std::memory_order_release) != 0) {
+#if defined(__linux__)
+            ::syscall(SYS_futex, &parked_, FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+#else
+            parked_.notify_one();
+#endif
+        }
+    }
+
+    // How many times the consumer has gone to sleep. Introspection only --
+    // for a test to tell a consumer that parked from one that never had to.
+    [[nodiscard]] std::size_t park_count() const { return parks_.load(std::memory_order_relaxed); }
+
+private:
+    // Roughly a few microseconds of pause-hinted re-checks before yielding
+    // or parking: long enough to catch the next message of a burst without
+    // a syscall, short enough not to matter to an idle core.
+    static constexpr int kSpinChecks = 256;
+
+    static void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__)
+        asm volatile("yield");
+#endif
+    }
+
+    // Sleeps while parked_ is still set, for at most `timeout` if given. May
+    // return early and spuriously; callers re-check parked_ or `ready`.
+    void park([[maybe_unused]] const std::timespec* timeout) {
+#if defined(__linux__)
+        ::syscall(SYS_futex, &parked_, FUTEX_WAIT_PRIVATE, 1u, timeout, nullptr, 0);
+#else
+        parked_.wait(1, std::memory_order_acquire);
+#endif
+    }
+
+    WaitPolicy policy_;
+    std::atomic<std::size_t> parks_{0};
+    alignas(64) std::atomic<std::uint32_t> parked_{0}; // its own line: every producer reads it on notify()
+};
+
+} // namespace mdh
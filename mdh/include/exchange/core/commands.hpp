@@ -1,6 +1,8 @@
 #pragma once
 
+#include <optional>
 #include <variant>
+#include <vector>
 
 #include "common/types.hpp"
 #include "exchange/core/types.hpp"
@@ -9,7 +11,9 @@
 // These carry only what deterministic processing needs: no socket handles,
 // no file offsets, no JSON, and no timestamp read inside the matcher. A
 // command's effect must depend only on its own fields and the book state
-// when it is processed, never on the clock.
+// when it is processed, never on the clock. Where time matters -- GTD
+// expiry -- it arrives as a command too (ClockTickCommand), sequenced and
+// journaled like any other, so replay sees the same time at the same point.
 //
 // Whatever produces them -- the TCP gateway, or a test building them
 // directly -- is entirely decoupled from this definition. Nothing here has
@@ -29,6 +33,12 @@ struct NewOrderCommand {
     Quantity quantity;
     OrderType order_type;
     TimeInForce time_in_force;
+    // When a GTD order stops resting, in the command clock's nanoseconds
+    // (see ClockTickCommand). Must be zero for every other time in force.
+    Timestamp expire_at = 0;
+    // The price a trade has to print at, or through, to release a StopLimit
+    // order onto the book. Must be zero for every other order type.
+    Price stop_price = 0;
 
     bool operator==(const NewOrderCommand&) const = default;
 };
@@ -54,6 +64,112 @@ struct ReplaceOrderCommand {
     bool operator==(const ReplaceOrderCommand&) const = default;
 };
 
-using ExchangeCommand = std::variant<NewOrderCommand, CancelOrderCommand, ReplaceOrderCommand>;
+// One level of a mass quote. A GTC limit order in all but name: it rests,
+// matches and is reported exactly like one, under its own client order id.
+struct QuoteEntry {
+    ClientOrderId client_order_id;
+    Side side;
+    Price price;
+    Quantity quantity;
+
+    bool operator==(const QuoteEntry&) const = default;
+};
+
+// Replaces everything `account_id` is quoting on `instrument_id` with
+// `entries`, in one command. A market maker refreshing ten levels a side
+// would otherwise send twenty replaces, each paying decode, the submit
+// lock, a sequence number and a queue slot of its own; this pays them once.
+//
+// The quote set it replaces is whatever the account's previous mass quote
+// on this instrument left resting. Orders entered any other way are never
+// touched, and a quote that has since been cancelled, replaced or filled
+// has left the set. No entries withdraws the quote altogether. See
+// MatchingEngine for how levels are paired up and what each one reports.
+//
+// The only command that owns heap memory: the levels are a vector, which
+// keeps the variant's size that of the largest fixed command rather than
+// kMaxQuoteEntries of them.
+struct MassQuoteCommand {
+    CommandSequence command_sequence;
+    AccountId account_id;
+    InstrumentId instrument_id;
+    std::vector<QuoteEntry> entries;
+
+    bool operator==(const MassQuoteCommand&) const = default;
+};
+
+// Cancels every order `account_id` has resting -- on one instrument if
+// `instrument_id` is set, on one side if `side` is -- in one command. This
+// is what a client's kill switch sends, and what the gateway sends for an
+// account whose last session has disconnected. One cancel per order would
+// pay a sequence number, a queue slot and a directory lookup each, and the
+// client would have to know every id it had resting to send them.
+//
+// Each order taken off is reported exactly as an ordinary cancel would
+// report it. Nothing is reported when there was nothing to cancel: the
+// account's resting orders are what it is about, and it has none.
+//
+// `max_orders`, if not 0, caps how many orders this one command cancels,
+// in the same order they would otherwise go in. A command that cancelled
+// exactly that many may have left more behind, and its sender sends it
+// again until one cancels fewer -- which is how the gateway keeps one
+// account's hundred thousand orders from holding the matching thread for
+// the whole of them (see OrderEntryGatewayOptions::mass_cancel_batch).
+//
+// `before_exchange_order_id`, if not 0, leaves alone every order whose
+// exchange order id is that or higher -- every order the engine entered
+// after it handed that id out. This is what keeps the later commands of a
+// sliced mass cancel to the orders that were resting when the first one
+// ran: the sender fills it in from MatchingEngine::next_exchange_order_id()
+// after the first, so an order entered between two slices -- by a session
+// that has just reconnected, say -- survives them. A stop released meanwhile
+// keeps the id it was given when it was entered, so it is still caught; an
+// order replaced meanwhile at a new price or a larger size was given a new
+// id, and counts as entered then.
+struct MassCancelCommand {
+    CommandSequence command_sequence;
+    AccountId account_id;
+    std::optional<InstrumentId> instrument_id;
+    std::optional<Side> side;
+    std::uint32_t max_orders = 0;
+    ExchangeOrderId before_exchange_order_id = 0;
+
+    bool operator==(const MassCancelCommand&) const = default;
+};
+
+// Tells the engine what time it is: nanoseconds since the Unix epoch, as
+// read by whoever sequences commands -- the gateway -- and never by the
+// matcher itself. The engine's clock moves to `now` and every GTD order
+// whose expiry it has reached is cancelled, each reported exactly as an
+// ordinary cancel would be. A tick no later than the clock already is does
+// nothing, so a time source that steps backwards cannot un-expire anything
+// or expire it twice.
+//
+// Because time reaches the engine only this way, a journal replayed later
+// expires the same orders at the same point in the command stream.
+struct ClockTickCommand {
+    CommandSequence command_sequence;
+    Timestamp now;
+
+    bool operator==(const ClockTickCommand&) const = default;
+};
+
+// Moves one book between continuous matching and an auction's call phase.
+// Sent by the venue -- the gateway, on its auction schedule -- never by a
+// client. Into Call, the book stops matching and collects orders. Back to
+// Continuous, it uncrosses: every order that can trade at the price that
+// trades the most does, in one batch at that one price, and matching then
+// carries on as before. Setting the phase a book is already in does
+// nothing.
+struct TradingPhaseCommand {
+    CommandSequence command_sequence;
+    InstrumentId instrument_id;
+    TradingPhase phase;
+
+    bool operator==(const TradingPhaseCommand&) const = default;
+};
+
+using ExchangeCommand = std::variant<NewOrderCommand, CancelOrderCommand, ReplaceOrderCommand, MassQuoteCommand,
+                                     MassCancelCommand, ClockTickCommand, TradingPhaseCommand>;
 
 } // namespace mdh::exchange
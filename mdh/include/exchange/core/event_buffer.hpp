@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "exchange/core/events.hpp"
+
+// A reusable arena of events, filled by MatchingEngine::process_batch() and
+// read back as a span.
+//
+// The per-event EventSink call is a std::function invocation plus a
+// variant built at the call site, and a sweep through fifty levels makes a
+// hundred and fifty of them. Appending to this instead is a bounds check
+// and a copy into memory the buffer already owns: no type erasure, and --
+// once it has grown to the largest batch it has seen -- no allocation,
+// because clear() keeps the capacity.
+//
+// The records are ExchangeEvent itself rather than a separate compact
+// encoding. Every event struct is plain data, so the variant is trivially
+// copyable (asserted below) and the arena is just contiguous POD; keeping
+// the type means every existing consumer reads a span of what it already
+// understands, with no decode step on the far side.
+//
+// Commands are delimited too: end_command() records where each command's
+// events stop, so a consumer that acts per command -- the sharded
+// pipeline's merge, a ledger that must see one command settle before the
+// next is checked -- can still find the boundaries after a whole batch has
+// been processed in one go.
+namespace mdh::exchange {
+
+static_assert(std::is_trivially_copyable_v<ExchangeEvent>,
+              "EventBuffer relies on events being plain data; see the note above");
+
+class EventBuffer {
+public:
+    EventBuffer() = default;
+
+    // Sizes the arena up front. Growth is the only allocation this class
+    // ever makes, so a caller that knows its largest batch can rule it out
+    // entirely.
+    EventBuffer(std::size_t expected_events, std::size_t expected_commands) {
+        events_.reserve(expected_events);
+        command_ends_.reserve(expected_commands);
+    }
+
+    // Appends one event. Taking the concrete struct rather than an
+    // ExchangeEvent lets the variant be built in place, in the arena, instead
+    // of built and then copied in.
+    template <class Event>
+    void append(const Event& event) {
+        events_.emplace_back(std::in_place_type<Event>, event);
+    }
+
+    // Closes the current command: every event appended since the previous
+    // call belongs to it, including none at all.
+    void end_command() { command_ends_.push_back(static_cast<std::uint32_t>(events_.size())); }
+
+    // Forgets the contents and keeps the memory.
+    void clear() {
+        events_.clear();
+        command_ends_.clear();
+    }
+
+    [[nodiscard]] std::span<const ExchangeEvent> events() const { return events_; }
+    [[nodiscard]] std::size_t size() const { return events_.size(); }
+    [[nodiscard]] bool empty() const { return events_.empty(); }
+
+    [[nodiscard]] std::size_t command_count() const { return command_ends_.size(); }
+
+    // The events the `index`th closed command produced, in emission order.
+    [[nodiscard]] std::span<const ExchangeEvent> events_of(std::size_t index) const {
+        const std::size_t begin = index == 0 ? 0 : command_ends_[index - 1];
+        return std::span<const ExchangeEvent>(events_).subspan(begin, command_ends_[index] - begin);
+    }
+
+private:
+    std::vector<ExchangeEvent> events_;
+    // One past each closed command's last event, as an index into events_.
+    // 32 bits, because one batch is never four billion events.
+    std::vector<std::uint32_t> command_ends_;
+};
+
+} // namespace mdh::exchange
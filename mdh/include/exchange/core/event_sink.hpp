@@ -1,5 +1,6 @@
 #pragma once
 
+#include <concepts>
 #include <functional>
 
 #include "exchange/core/events.hpp"
@@ -9,10 +10,29 @@
 // A std::function alias rather than a virtual interface: every use -- real
 // dispatch, and a test collecting events into a vector -- is satisfied by a
 // callable, so a base class, a unique_ptr and a vtable would buy nothing.
-// Worth revisiting only against a measured need, such as avoiding
-// std::function's type erasure on a hot path.
+//
+// ── Typed sinks ───────────────────────────────────────────────────────────
+// std::function's type erasure did turn out to matter on the hot path: a
+// sweep emits three events per level, each an indirect call, and
+// RiskGatedEngine wrapped the caller's sink in a second std::function per
+// command, so every event crossed two. MatchingEngine, RiskGatedEngine and
+// BasicMatchingPipeline therefore also take any callable satisfying
+// ExchangeEventSink as a template parameter, and the compiler sees straight
+// through to whatever the caller does with each event.
+//
+// EventSink stays, and stays the default: it is what a caller storing a sink
+// of unknown type, or crossing a translation-unit boundary, still wants.
+// Passing one to the templated entry points is simply that caller paying the
+// one indirect call it chose.
 namespace mdh::exchange {
 
 using EventSink = std::function<void(const ExchangeEvent&)>;
 
+// Anything the engine can emit into. Each event is passed as its concrete
+// struct, so a sink taking `const auto&` sees the type directly; one taking
+// `const ExchangeEvent&` gets the variant built at the call, as EventSink
+// always has.
+template <class Sink>
+concept ExchangeEventSink = std::invocable<Sink&, const ExchangeEvent&>;
+
 } // namespace mdh::exchange
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <string_view>
 
@@ -20,13 +21,26 @@ using ExchangeOrderId = std::uint64_t;
 using CommandSequence = std::uint64_t;
 using EventSequence = std::uint64_t;
 
+// The most levels one mass quote may carry, both sides together. Ten a side
+// is what the command exists for; the cap is what keeps one command's work
+// on the matching thread, and one frame on the wire, bounded. Here rather
+// than beside MassQuoteCommand because the order-entry wire format is held
+// to it too, and that depends on this file alone.
+inline constexpr std::size_t kMaxQuoteEntries = 32;
+
 enum class OrderType {
     Limit,
+    // A limit order held off the book until a trade on its instrument
+    // prints at its stop price or through it -- at or above for a buy, at
+    // or below for a sell -- and then entered as a limit order at its
+    // price. Appended last so Limit keeps its on-wire encoding.
+    StopLimit,
 };
 
 [[nodiscard]] constexpr std::string_view to_string(OrderType t) {
     switch (t) {
         case OrderType::Limit: return "Limit";
+        case OrderType::StopLimit: return "StopLimit";
     }
     return "UnknownOrderType";
 }
@@ -35,6 +49,11 @@ enum class TimeInForce : std::uint8_t {
     GTC, // Good-Til-Cancelled: unmatched remainder rests on the book.
     IOC, // Immediate-Or-Cancel: unmatched remainder is discarded, never rests.
     FOK, // Fill-Or-Kill: fully filled immediately, or not executed at all.
+    // Good-Til-Date: rests like GTC until the command clock reaches its
+    // expire_at, then is cancelled by the exchange. A day order is one of
+    // these with the session's end as its expiry. Appended last so every
+    // existing value keeps its on-wire encoding.
+    GTD,
 };
 
 [[nodiscard]] constexpr std::string_view to_string(TimeInForce t) {
@@ -42,10 +61,28 @@ enum class TimeInForce : std::uint8_t {
         case TimeInForce::GTC: return "GTC";
         case TimeInForce::IOC: return "IOC";
         case TimeInForce::FOK: return "FOK";
+        case TimeInForce::GTD: return "GTD";
     }
     return "UnknownTimeInForce";
 }
 
+// How a book treats orders that cross. Continuous matches each as it
+// arrives. Call is the collecting half of an auction: orders rest without
+// matching, even when they cross, until the book goes back to Continuous and
+// uncrosses in one batch at a single price.
+enum class TradingPhase : std::uint8_t {
+    Continuous,
+    Call,
+};
+
+[[nodiscard]] constexpr std::string_view to_string(TradingPhase p) {
+    switch (p) {
+        case TradingPhase::Continuous: return "Continuous";
+        case TradingPhase::Call: return "Call";
+    }
+    return "UnknownTradingPhase";
+}
+
 // Only the reasons this project actually needs -- not an encyclopaedia of
 // every rejection a real exchange might issue.
 enum class RejectReason {
@@ -74,6 +111,20 @@ enum class RejectReason {
     // OrderEntryGateway's own session-binding doc comment. Appended last
     // so every existing reason keeps its on-wire value.
     AccountMismatch,
+    // A mass quote malformed as a whole rather than in any one level: more
+    // levels than kMaxQuoteEntries, or one client order id used twice.
+    // Appended after AccountMismatch for the same reason it was appended.
+    InvalidQuote,
+    // A GTD order whose expiry the command clock has already reached, or
+    // an expiry on an order that is not GTD.
+    InvalidExpiry,
+    // A stop order whose stop price is not positive, or that the last
+    // trade on its instrument has already triggered, or that is anything
+    // but GTC; or a stop price on an order that is not a stop.
+    InvalidStopPrice,
+    // An IOC or FOK order sent while its book is in an auction's call
+    // phase, when nothing trades and so nothing could fill it.
+    InvalidDuringCall,
 };
 
 [[nodiscard]] constexpr std::string_view to_string(RejectReason r) {
@@ -91,6 +142,10 @@ enum class RejectReason {
         case RejectReason::InsufficientPosition:  return "InsufficientPosition";
         case RejectReason::OrderTooLarge:         return "OrderTooLarge";
         case RejectReason::AccountMismatch:       return "AccountMismatch";
+        case RejectReason::InvalidQuote:          return "InvalidQuote";
+        case RejectReason::InvalidExpiry:         return "InvalidExpiry";
+        case RejectReason::InvalidStopPrice:      return "InvalidStopPrice";
+        case RejectReason::InvalidDuringCall:     return "InvalidDuringCall";
     }
     return "UnknownRejectReason";
 }
@@ -1,10 +1,13 @@
 #pragma once
 
+#include <array>
 #include <atomic>
-#include <condition_variable>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <deque>
+#include <functional>
+#include <list>
 #include <memory>
 #include <mutex>
 #include <optional>
@@ -15,16 +18,23 @@
 #include <vector>
 
 #include "common/spsc_queue.hpp"
+#include "common/thread_placement.hpp"
+#include "common/wait_strategy.hpp"
 #include "exchange/core/commands.hpp"
 #include "exchange/core/event_sink.hpp"
 #include "exchange/core/events.hpp"
 #include "exchange/ledger/ledger.hpp"
 #include "exchange/matching/matching_engine.hpp"
 #include "exchange/matching/state_snapshot.hpp"
+#include "exchange/persistence/background_snapshotter.hpp"
 #include "exchange/risk/risk_engine.hpp"
 #include "exchange/risk/risk_gated_engine.hpp"
+#include "exchange/sequencing/event_fanout.hpp"
 #include "exchange/sequencing/matching_pipeline.hpp"
+#include "net/poller.hpp"
+#include "net/receive_buffer.hpp"
 #include "net/tcp_socket.hpp"
+#include "net/uring.hpp"
 #include "protocol/order_entry/messages.hpp"
 
 // The exchange's networked front door: the piece that makes the matching
@@ -46,26 +56,85 @@
 //       |
 //       +--> per connection: reader thread --> submit_command() --> pipeline
 //       |                                                              |
-//       +--> per connection: writer thread <-- outbound queue <-- route_event()
-//                                                          (runs on the matching thread)
+//       +--> per connection: writer thread <-- outbound queue <-- routing thread
+//                                                                      |
+//                       matching thread --> route_event() --> event ring
+//                                                                      |
+//                                     extra_event_sink <-- publishing thread
 //
 // One accept thread polls accept() in a non-blocking loop against a shared
 // stop token rather than blocking inside it -- see accept_loop() for why.
 // Each accepted connection then gets a reader thread and a writer thread of
 // its own, and those two are the only threads allowed to touch its socket.
 //
-// The pipeline's submit() takes a single producer, but this gateway has one
-// reader thread per connection, so submit_command() serializes them behind
-// submit_mutex_. A plain mutex is the right answer here: submit() is not the
-// hot path, and matching itself stays single-threaded and lock-free.
+// With OrderEntryGatewayOptions::io_threads, the accept thread and every
+// reader and writer thread are replaced by that many event loops, each an
+// edge-triggered epoll set (net::Poller) over its share of the connections:
+//
+//   I/O thread 0 .. n-1 (fixed)
+//       each: its connections' reads --> submit_command() --> pipeline
+//             its connections' writes <-- outbound queues <-- routing thread
+//       thread 0 also: accept, clock ticks, auctions
+//
+// A connection belongs to one loop for life, assigned round-robin as it is
+// accepted, and that loop is then the only thread touching its socket. The
+// Connection itself is the same in both modes -- the same read buffer,
+// queues, binding and ownership, decoded by the same handle_input() and
+// drained by the same drain_output() -- so the two are interchangeable, and
+// can be measured against each other, by changing that one option. What
+// differs is how a connection's turn comes round: a blocked read() or a
+// parked writer in one, a readiness event or a wake-up of its loop in the
+// other. Hundreds of sessions thus cost a handful of threads rather than
+// two each, at the price of one session's work delaying the others on its
+// loop.
+//
+// OrderEntryGatewayOptions::io_backend swaps epoll for io_uring (net::Uring)
+// under the same loops. Where epoll reports readiness and the loop then
+// reads and writes each socket itself, a system call apiece, an io_uring loop
+// has the kernel do the reading: one multishot recv per connection, armed
+// once, lands bytes in buffers the loop lends the kernel, and one multishot
+// accept does the same for new connections. Sends queue up across all the
+// loop's connections and go in with the next wait, so a turn costs one
+// io_uring_enter() however many sockets it served. io_stats() counts the
+// system calls either way.
+//
+// Whichever thread writes a connection encodes its reports back to back into
+// one buffer of its own, kept for the life of the connection, and writes
+// them out together: once the queues run dry or write_flush_bytes have built
+// up, whichever comes first, and under a writer thread optionally after a
+// short write_linger for more to join them. A burst of fills to one client
+// is then a handful of write()s, not one per fill, and costs no allocation.
+//
+// Every reader thread submits to the pipeline directly, with no lock: the
+// pipeline's queue is multi-producer, and each submission claims its slot
+// with a compare-and-swap, so connections do not queue up behind one
+// another on the way in. The command's sequence number is assigned on the matching
+// thread as it is dequeued. Matching itself stays single-threaded.
 //
 // route_event() is the sink the pipeline hands to its processor, so it runs
-// on the matching thread, synchronously, and must not block. It translates
-// each event into wire messages and pushes them onto the target connection's
-// own outbound queue. Every connection gets a queue precisely so that
-// route_event() never calls write() itself -- one slow client's socket would
-// otherwise throttle matching for everyone. It also passes the raw event to
-// OrderEntryGatewayOptions::extra_event_sink, if one is set.
+// on the matching thread, synchronously, and must not block. All it does is
+// copy the event into a slot of an EventRing (see EventFanout); the ring is
+// published once per command. Two threads read that ring independently, each
+// at its own pace:
+//
+//   routing     translates each event into wire messages and pushes them
+//               onto the target connection's own outbound queue -- under
+//               sessions_mutex_, which the matching thread therefore never
+//               takes. Every connection gets a queue precisely so that
+//               routing never calls write() itself: one slow client's
+//               socket would otherwise hold up reports for everyone.
+//   publishing  passes the raw event to
+//               OrderEntryGatewayOptions::extra_event_sink, if one is set.
+//
+// Neither waits on the other, so a slow market-data sink delays no report
+// and matching waits on neither unless one falls a whole ring behind. The
+// ledger is not among them: the risk check on the very next command reads
+// it, so it is updated inline on the matching thread, as before. What the
+// routing thread needs from the ledger -- whether a rejected order still
+// holds funds -- is read on the matching thread and carried in the slot.
+//
+// OrderEntryGatewayOptions::event_ring_capacity = 0 keeps the older shape:
+// route_event() does all of the above itself, on the matching thread.
 //
 // ── Sessions, and how a private report finds its way home ─────────────────
 //
@@ -88,14 +157,44 @@
 // -- the same key the engine uses for live orders. A reader thread records
 // that before it submits, so an event can never arrive for an unknown owner.
 //
-// route_event() then resolves a report in three steps: the owning session if
+// The routing thread then resolves a report in three steps: the owning session if
 // it is still connected; failing that, any other live session of the same
-// account (a resting order outlives the session that placed it -- there is
-// no cancel-on-disconnect here); failing that, pending_reports_, which holds
+// account (a resting order outlives the session that placed it unless
+// cancel_on_disconnect is set); failing that, pending_reports_, which holds
 // it for the next session to bind to that account. That last queue is
 // bounded and in-memory only -- reports can be dropped on overflow and are
 // lost on restart -- not durable offline delivery.
 //
+// With OrderEntryGatewayOptions::cancel_on_disconnect, the last session of
+// an account to go away also takes the account's resting orders with it: its
+// reader submits a MassCancelCommand on the way out, which the engine runs
+// like any other command, so the cancels are sequenced, journaled and
+// reported (to pending_reports_, since nobody is left) like any others. An
+// I/O thread never waits for room in the queue to do it, since the other
+// connections on its loop would wait with it; it retries on later turns.
+// Every mass cancel is cut into batches of mass_cancel_batch orders, each
+// queued by the matching thread behind whatever arrived meanwhile, so one
+// account's cancels never hold up every other session's commands for long.
+// That makes a mass cancel -- the kill switch included -- no longer atomic:
+// the account's remaining orders can trade between batches. What the later
+// batches take is still fixed when the first runs: they carry the engine's
+// next exchange order id as of then (MassCancelCommand::before_exchange_order_id),
+// so an order entered between batches, by a session binding to the account
+// after it dropped, is left resting.
+//
+// With OrderEntryGatewayOptions::clock_tick_interval, the accept thread is
+// also the exchange's clock: it reads the system clock and submits a
+// ClockTickCommand that often, which is what expires GTD orders. The time
+// is taken here, outside the matcher, and sequenced and journaled with
+// everything else, so the engine stays a function of its command stream.
+//
+// With OrderEntryGatewayOptions::auction_interval, the accept thread also
+// runs periodic call auctions on every instrument in
+// OrderEntryGatewayOptions::instruments: a TradingPhaseCommand into the call
+// for each, then, auction_call_duration later, one back to continuous,
+// which uncrosses the book. The schedule is the gateway's; the engine only
+// ever sees the commands, sequenced and journaled like the clock ticks.
+//
 // None of this reaches into ExchangeCommand or ExchangeEvent. The exchange
 // core stays transport-independent, deterministic and replayable, and has
 // never heard of a socket; the whole session model lives here.
@@ -108,6 +207,33 @@ namespace mdh::exchange::gateway {
 // only -- routing keys on (account_id, client_order_id), never on this.
 using SessionId = std::uint64_t;
 
+// What serves the gateway's connections -- see
+// OrderEntryGatewayOptions::io_threads and io_backend, and
+// OrderEntryGateway::io_backend() for which one start() actually got.
+enum class GatewayIoBackend : std::uint8_t {
+    Threads, // a reader and a writer thread per connection, and an accept thread
+    Epoll,   // io_threads epoll event loops (net::Poller)
+    IoUring, // io_threads io_uring event loops (net::Uring)
+};
+
+// What the gateway's socket I/O has cost so far -- see
+// OrderEntryGateway::io_stats().
+struct GatewayIoStats {
+    // System calls made to move connection bytes or wait for them: read()
+    // and write() on the per-connection threads, and each event loop's
+    // epoll_wait(), reads and writes, or io_uring_enter(). Accepting and
+    // waking a thread are left out, in every mode, so the modes compare
+    // like for like.
+    std::uint64_t syscalls = 0;
+    std::uint64_t messages_in = 0;  // frames decoded from clients
+    std::uint64_t messages_out = 0; // messages handed to a socket for clients
+
+    [[nodiscard]] double syscalls_per_message() const {
+        const std::uint64_t messages = messages_in + messages_out;
+        return messages == 0 ? 0.0 : static_cast<double>(syscalls) / static_cast<double>(messages);
+    }
+};
+
 struct OrderEntryGatewayOptions {
     risk::RiskLimits risk_limits{};
 
@@ -115,11 +241,46 @@ struct OrderEntryGatewayOptions {
     // InvalidInstrument over the wire. Instrument ids arrive from clients,
     // so without this list every id a client invented got a book of its own.
     // Empty rejects every order, so a real deployment must set it.
-    std::vector<InstrumentId> instruments;
+    std::vector<InstrumentId> instruments{};
 
     // The pipeline's inbound command queue.
     std::size_t matching_queue_capacity = 1024;
 
+    // How the matching thread and each connection's writer thread wait for
+    // work -- see WaitPolicy. The matching thread keeps its old spin-then-
+    // yield by default: one thread, and the one every order waits on.
+    // Writers park by default, since there is one per connection and most
+    // connections are idle most of the time; BusySpin on a writer buys the
+    // lowest report latency for a connection that has a core to spare.
+    WaitPolicy matching_wait = WaitPolicy::SpinThenYield;
+    WaitPolicy writer_wait = WaitPolicy::Park;
+
+    // Where each of the gateway's threads runs -- see thread_placement.hpp.
+    // Uses the Matching, GatewayAccept, GatewayReader, GatewayWriter,
+    // GatewayIo, Snapshot, Routing and Publishing roles; every reader shares
+    // one placement, as does every writer and every I/O thread. Threads are
+    // named either way: "mdh-matching", "mdh-accept", "mdh-snapshot",
+    // "mdh-routing", "mdh-publishing", "mdh-rd-<session>" /
+    // "mdh-wr-<session>" per connection, and "mdh-io-<n>" per event loop.
+    // The default pins nothing and raises nothing.
+    ThreadPlacementProfile placement{};
+
+    // How connections are served. Zero, the default, gives each its own
+    // reader and writer thread and runs an accept thread beside them. Above
+    // zero, that many epoll event loops serve every connection between them
+    // instead, and the first also accepts -- see the class comment. The
+    // thread count then stays the same however many clients connect. Linux
+    // only: elsewhere, or if epoll cannot be set up, start() falls back to
+    // the threads.
+    std::size_t io_threads = 0;
+
+    // Which kind of event loop io_threads runs. IoUring needs Linux 6.0 or
+    // later with io_uring allowed (container runtimes often block it);
+    // without, start() falls back to Epoll, and from there to Threads as
+    // above -- io_backend() says which it got. Threads here means the same
+    // as io_threads = 0.
+    GatewayIoBackend io_backend = GatewayIoBackend::Epoll;
+
     // Passed to the matching engine -- see kDefaultExpectedRestingOrders. A
     // gateway carrying real order flow should raise it.
     std::size_t expected_resting_orders = MatchingEngine::kDefaultExpectedRestingOrders;
@@ -128,6 +289,25 @@ struct OrderEntryGatewayOptions {
     // a real policy decision -- see Connection::outbound below.
     std::size_t outbound_queue_capacity = 1024;
 
+    // How much encoded output a connection's writer gathers before it writes
+    // -- see the class comment. A writer that drains the queues dry writes
+    // whatever it has straight away; this caps what one write() carries
+    // while reports keep coming, and so how long the first of them waits
+    // for the last to be encoded. 1 writes every report on its own, as a
+    // writer thread did before output was coalesced. Event loops gather a
+    // whole batch of the queue even then: they cannot write mid-batch.
+    std::size_t write_flush_bytes = 16 * 1024;
+
+    // Writer threads only: once the queues run dry with output gathered,
+    // wait up to this long -- counted from the first report gathered -- for
+    // more to go out in the same write(), waiting as writer_wait says and
+    // waking for each report that arrives meanwhile. Zero, the default,
+    // writes at once and adds no latency. It buys fewer system calls when
+    // reports to a client arrive in quick succession rather than in one
+    // burst, e.g. fills of several orders from separate commands. Event loops write once per turn regardless,
+    // which already gathers whatever arrived while the loop was busy.
+    std::chrono::microseconds write_linger{0};
+
     // Passed through to TcpSocket::listen()'s backlog.
     int accept_backlog = 16;
 
@@ -141,15 +321,77 @@ struct OrderEntryGatewayOptions {
     std::size_t pending_report_capacity = 1024;
 
     // An optional second observer of every event the matching thread
-    // produces, called from route_event() alongside -- never instead of --
-    // the per-connection wire routing. Unlike the wire path, which only
+    // produces, called alongside -- never instead of -- the per-connection
+    // wire routing. Unlike the wire path, which only
     // looks at account-addressed events, this sees everything, including the
     // anonymous book and trade events. Wiring a MarketDataPublisher in here
     // is what lets a live feed watch a real running gateway.
     //
-    // Runs on the matching thread, synchronously, under the same "must not
-    // block" rule as route_event() itself. Null by default.
-    EventSink extra_event_sink;
+    // Runs on its own publishing thread, behind the event ring (see the
+    // class comment), in event order. It may take its time: matching waits on
+    // it only once it is event_ring_capacity events behind. Without a ring
+    // it runs on the matching thread and must not block. Null by default.
+    EventSink extra_event_sink{};
+
+    // Slots in the event ring between the matching thread and the routing
+    // and publishing threads -- see the class comment. Zero routes and
+    // publishes on the matching thread instead, with no ring and no extra
+    // threads. event_wait is how those two threads wait for events.
+    std::size_t event_ring_capacity = 4096;
+    WaitPolicy event_wait = WaitPolicy::Park;
+
+    // Periodic state snapshots while the gateway runs. Every this many
+    // commands the matching thread hands the books that changed to a
+    // persistence::BackgroundSnapshotter, whose own thread keeps a full
+    // image current and passes it to on_snapshot -- so a snapshot costs the
+    // matching thread a copy of the busy books, not of the whole engine.
+    // stop() takes a final one once matching has drained. Zero, the
+    // default, takes none; snapshot() after stop() works either way.
+    std::size_t snapshot_every_commands = 0;
+    std::function<void(const EngineStateSnapshot&, const EngineStateChanges&)> on_snapshot{};
+
+    // When the last live session of an account disconnects, cancel every
+    // order that account has resting, on every instrument. Off by default,
+    // because it changes what a dropped connection means: a client whose
+    // link flaps loses its queue position, in exchange for never leaving
+    // quotes in the book that nobody is watching. stop() disconnects every
+    // session, so with this set a stopped gateway's book holds no orders
+    // from accounts that were connected at the time.
+    bool cancel_on_disconnect = false;
+
+    // The most orders one MassCancelCommand cancels before the matching
+    // thread moves on (MassCancelCommand::max_orders). Every mass cancel the
+    // gateway submits -- a client's, or cancel_on_disconnect's -- carries
+    // it, and the matching thread queues the rest of one that reached it as
+    // a further command behind whatever arrived meanwhile. An account with
+    // a hundred thousand orders then holds matching for about a millisecond
+    // at a time rather than fourteen, at the price of the cancel no longer
+    // being atomic: its orders can still trade between batches, though an
+    // order entered after the first batch is never cancelled by a later one.
+    // Zero cancels everything in one command, as the engine does by default.
+    std::uint32_t mass_cancel_batch = 1024;
+
+    // How often the accept thread submits a ClockTickCommand carrying the
+    // system clock's time since the Unix epoch -- the time GTD expiries are
+    // measured against. An order expires on the first tick at or after its
+    // expire_at, so this is how late an expiry can be, give or take the
+    // accept thread's own 1 ms poll. A tick that finds the queue full is
+    // skipped; the next one carries a later time anyway. Zero, the default,
+    // sends none, and a GTD order then rests until it is cancelled.
+    std::chrono::nanoseconds clock_tick_interval{0};
+
+    // Periodic call auctions: every auction_interval, the accept thread puts
+    // every instrument in `instruments` into a call, and auction_call_duration
+    // later takes them all out again, which uncrosses each at its
+    // equilibrium price. In between, orders on those books rest without
+    // matching and IOC/FOK orders are rejected (see MatchingEngine's class
+    // comment). The interval counts from the start of one call to the start
+    // of the next, so a duration as long as the interval leaves no
+    // continuous trading at all. A phase command that finds the queue full
+    // is retried on the next poll rather than skipped, since a book left in
+    // a call never trades again. Zero, the default, runs none.
+    std::chrono::nanoseconds auction_interval{0};
+    std::chrono::nanoseconds auction_call_duration{0};
 };
 
 class OrderEntryGateway {
@@ -164,17 +406,20 @@ public:
     OrderEntryGateway(OrderEntryGateway&&) = delete;
     OrderEntryGateway& operator=(OrderEntryGateway&&) = delete;
 
-    // Starts listening and spawns the accept thread. Returns false, having
-    // spawned nothing, if listen() fails -- a port already in use, say -- so
-    // a caller can check before assuming the gateway is reachable.
+    // Starts listening and spawns the accept thread, or the I/O threads
+    // with io_threads set. Returns false, having spawned nothing, if listen()
+    // fails -- a port already in use, say -- so a caller can check before
+    // assuming the gateway is reachable.
     [[nodiscard]] bool start();
 
     // Shuts everything down, in this order:
-    //   1. Request stop on the shared stop source, and wake every writer.
-    //   2. Join the accept thread, so no new connection can appear while
-    //      steps 3 and 4 walk the connection list.
+    //   1. Request stop on the shared stop source, and wake every I/O thread.
+    //   2. Join the accept thread or the I/O threads, so no new connection
+    //      can appear while steps 3 and 4 walk the connection list.
     //   3. shutdown() every live socket. This is what unblocks each reader
-    //      thread, which is otherwise parked in a blocking read().
+    //      thread, which is otherwise parked in a blocking read(). A
+    //      connection an I/O thread served is closed here instead, as its
+    //      reader would have closed it on the way out.
     //   4. Join every reader and writer thread.
     //   5. Stop the pipeline, which drains whatever is already queued.
     // Safe to call more than once, including from the destructor, and a
@@ -189,6 +434,16 @@ public:
     // client disconnects; see Connection on why dead ones are not pruned.
     [[nodiscard]] std::size_t connection_count() const;
 
+    // How connections are being served: what options_.io_backend asked for,
+    // or what start() fell back to. Threads before start(). Read it from the
+    // thread that called start(), or after.
+    [[nodiscard]] GatewayIoBackend io_backend() const { return backend_; }
+
+    // System calls and messages so far, summed over every connection and
+    // event loop. Safe from any thread; while the gateway runs, each count
+    // is as of a moment ago, and they are not taken at the same instant.
+    [[nodiscard]] GatewayIoStats io_stats() const;
+
     // Read-only access to the matching state, for tests that want to assert
     // on the book rather than only on wire responses.
     //
@@ -198,6 +453,12 @@ public:
     // MatchingPipeline::snapshot(), which has the same precondition.
     [[nodiscard]] EngineStateSnapshot snapshot() const { return engine_.snapshot(); }
 
+    // How many periodic snapshots have been completed so far; see
+    // OrderEntryGatewayOptions::snapshot_every_commands. Safe from any thread.
+    [[nodiscard]] std::uint64_t snapshots_taken() const {
+        return snapshotter_ ? snapshotter_->snapshots_applied() : 0;
+    }
+
     // Test and admin seeding, forwarded to the ledger -- the only way
     // balances ever start out non-zero. The ledger is not synchronized
     // against the matching thread, so call these before any traffic that
@@ -228,14 +489,20 @@ private:
         }
     };
 
+    struct IoLoop;
+
     // One accepted TCP connection -- one session -- and everything that
     // belongs to it. Held by unique_ptr in connections_ so its address stays
     // put for the life of the connection even as that vector grows, because
     // the routing maps below hold raw pointers into these.
+    //
+    // The same in both I/O modes. Where this says "reader thread" or
+    // "writer thread", read "its I/O thread" when io_threads is set: that
+    // one thread then plays both parts.
     struct Connection {
-        explicit Connection(SessionId id, net::TcpSocket socket_in, std::size_t outbound_capacity)
+        Connection(SessionId id, net::TcpSocket socket_in, std::size_t outbound_capacity, WaitPolicy writer_wait)
             : session_id(id), socket(std::move(socket_in)), outbound(outbound_capacity),
-              session_outbound(outbound_capacity) {}
+              session_outbound(outbound_capacity), wake(writer_wait) {}
 
         SessionId session_id;
 
@@ -244,11 +511,14 @@ private:
         // Bytes read but not yet decoded into a complete message. TCP is a
         // byte stream with no message boundaries, so one read() can return
         // half a message or three and a half, and the reader has to
-        // accumulate here until there is enough to decode.
-        std::vector<std::byte> read_buffer;
+        // accumulate here until there is enough to decode. Framed in place
+        // and consumed once per read, so a read of many small frames costs
+        // time linear in its size -- see net::ReceiveBuffer.
+        net::ReceiveBuffer read_buffer;
 
-        // Reports for this client: pushed by route_event() on the matching
-        // thread, drained by this connection's writer thread. What to do
+        // Reports for this client: pushed by the routing thread (the
+        // matching thread, without an event ring), drained by this
+        // connection's writer thread. What to do
         // when it fills is a genuine policy choice rather than an oversight
         // -- see MatchingPipeline on drop versus reject versus block.
         SpscQueue<protocol::order_entry::Message> outbound;
@@ -258,7 +528,7 @@ private:
         // somebody else's account. This is a second queue rather than a
         // second producer on `outbound` because SpscQueue permits exactly
         // one producer, and these come from the reader thread while
-        // `outbound`'s come from the matching thread. The writer thread
+        // `outbound`'s come from the routing thread. The writer thread
         // drains both.
         SpscQueue<protocol::order_entry::Message> session_outbound;
 
@@ -267,34 +537,87 @@ private:
         // can reconcile. The writer drains this ahead of both queues above,
         // and the handover happens under sessions_mutex_ before this session
         // is visible for routing, so a retained report can never arrive
-        // after a live one.
+        // after a live one. A deque, as pending_reports_ is: it is taken
+        // over whole and drained from the front.
         std::mutex replay_mutex;
-        std::vector<protocol::order_entry::Message> replay_backlog;
+        std::deque<protocol::order_entry::Message> replay_backlog;
+
+        // How many messages wait in the three sources above, never fewer:
+        // each producer adds before it publishes (and takes back what would
+        // not fit), drain_output() subtracts what it took. This is what
+        // has_output() reads, so a writer deciding whether to sleep checks
+        // one atomic rather than taking replay_mutex.
+        std::atomic<std::size_t> output_pending{0};
+
+        // The event loop this connection belongs to, or null when it has
+        // reader and writer threads instead. Set before the connection is
+        // visible to anyone but the thread accepting it, never changed.
+        IoLoop* loop = nullptr;
+
+        // Encoded reports gathered for one write, by whichever thread writes
+        // this connection; cleared, never shrunk, so it stops allocating
+        // once it has grown to the largest flush. Under an event loop, what
+        // the socket would not take yet, from write_offset on, written out
+        // before anything more is drained.
+        std::vector<std::byte> write_buffer;
+        std::size_t write_offset = 0;
+
+        // Under an event loop only. Set by whoever queues output for this
+        // connection and finds it clear, which then puts the connection on
+        // its loop's ready list; cleared by the loop just before draining.
+        // So a burst of reports costs one ready-list entry, and a report
+        // pushed after the drain started finds it clear and schedules
+        // another.
+        std::atomic<bool> output_scheduled{false};
 
-        // Lets the writer thread sleep until there is actually something to
-        // send, rather than waking on a fixed interval to look. That poll
-        // interval used to dominate this gateway's end-to-end latency; see
+        // Under an event loop only, and only its thread touches it: the last
+        // turn's reads stopped at kReadsPerTurn rather than at WouldBlock,
+        // so there may be bytes left that no edge will announce.
+        bool input_pending = false;
+
+        // Under an io_uring loop only, and only its thread touches it: a
+        // send of write_buffer is with the kernel, which therefore must not
+        // be touched until it completes.
+        bool send_in_flight = false;
+
+        // What io_stats() adds up. Each has one writer -- reads and
+        // messages_in the reader thread, writes and messages_out the writer
+        // thread, all four the I/O thread under an event loop -- so they
+        // are counted with a plain load and store, not a locked increment.
+        std::atomic<std::uint64_t> reads{0};
+        std::atomic<std::uint64_t> writes{0};
+        std::atomic<std::uint64_t> messages_in{0};
+        std::atomic<std::uint64_t> messages_out{0};
+
+        // How the writer thread waits for something to send, per
+        // OrderEntryGatewayOptions::writer_wait. Anything that gives the
+        // writer work or a reason to exit -- a queued report, a replay
+        // backlog, `closed`, stop() -- calls wake.notify() afterwards. Under
+        // Park that is a futex wake only if the writer is actually asleep,
+        // and it can never be lost (see WaitStrategy), so unlike the
+        // condition variable this replaces there is no timeout: the writer
+        // sleeps until there is something to do. A timed poll here once
+        // dominated this gateway's end-to-end latency; see
         // docs/benchmarks.md §7.
-        //
-        // wake_mutex guards only the wait itself -- `outbound` stays
-        // lock-free. A producer does not need to hold it to notify, because
-        // the writer re-checks the queue as its own wait predicate, so a
-        // notification arriving just before the wait begins is redundant
-        // rather than lost. The wait still has a timeout, purely as a safety
-        // net against a missed wakeup.
-        std::mutex wake_mutex;
-        std::condition_variable wake_cv;
+        WaitStrategy wake;
 
         // The account this session bound to on its first valid request, and
         // nothing else ever after. Written once, by this connection's reader
         // thread alone, so it needs no atomic. account_sessions_ is what
-        // makes the binding visible to the matching thread; this field is
+        // makes the binding visible to the routing thread; this field is
         // just how the reader checks "am I bound, and to whom" on every
         // later message without taking a mutex.
         std::optional<AccountId> account_id;
 
+        // Every order id order_owner_ currently attributes to this session,
+        // so unbinding drops exactly those without scanning everybody
+        // else's. Guarded by sessions_mutex_ like order_owner_ itself, whose
+        // entries hold an iterator into it; a std::list so that iterator
+        // survives every other insertion and erasure.
+        std::list<OrderKey> owned_orders;
+
         // Set by the reader thread as it exits -- peer hung up, read failed,
-        // or stop() shut the socket down -- and read by the matching thread.
+        // or stop() shut the socket down -- and read by the routing thread.
         // Between that store and the unbinding that follows, this is what
         // stops a report being pushed onto a queue whose writer is on its
         // way out; after unbinding, nothing can route here at all. It is
@@ -302,46 +625,222 @@ private:
         // writer does not linger until stop().
         std::atomic<bool> closed{false};
 
+        // Set by the writer thread as it exits, once whatever it had staged
+        // in write_buffer has been written out. stop() waits for it before
+        // shutting the socket down -- see connection_writer_loop().
+        std::atomic<bool> writer_finished{false};
+
         std::jthread reader_thread;
         std::jthread writer_thread;
     };
 
-    // Serializes pipeline submissions across every reader thread. Always use
-    // this rather than calling pipeline_.submit() directly.
+    // The one way into the pipeline, from any thread -- readers, the accept
+    // loop's clock ticks and phase changes, cancel-on-disconnect. Lock-free;
+    // see the class comment.
     [[nodiscard]] bool submit_command(ExchangeCommand command);
 
     // ── Translation between the wire and the exchange core ────────────────
     // tests/test_order_entry_gateway_e2e.cpp is the spec for all of it.
 
-    // Runs on the accept thread. Polls accept() against the stop token and,
-    // for each new connection, builds a Connection, adds it to the list, and
-    // spawns its reader and writer threads.
+    // One event loop, with io_threads set: its Poller or its Uring,
+    // whichever the backend is, the connections that have output waiting,
+    // and its thread. Connections are registered with the poller under their
+    // own address as the key; the listener, on loop 0 only, under
+    // kListenerKey. A ring tags the address with the operation instead --
+    // see uring_complete().
+    struct IoLoop {
+        explicit IoLoop(std::size_t index_in) : index(index_in) {}
+
+        std::size_t index;
+        std::unique_ptr<net::Poller> poller; // Epoll
+        std::unique_ptr<net::Uring> ring;    // IoUring
+
+        void wake() {
+            if (ring) {
+                ring->wake();
+            } else {
+                poller->wake();
+            }
+        }
+
+        // Connections that output was queued for since the loop last looked
+        // -- see Connection::output_scheduled. Pushed by the routing thread
+        // and by this loop itself; swapped out whole by this loop.
+        std::mutex ready_mutex;
+        std::vector<Connection*> ready;
+
+        // io_uring only: connections accepted for this loop and not yet
+        // armed. Under ready_mutex, since loop 0 accepts for every loop but
+        // only this loop's thread may submit to its ring.
+        std::vector<Connection*> arriving;
+
+        // io_uring only, and only this loop's thread touches them: every
+        // connection it has armed, and how many of their operations the
+        // kernel still holds -- which must reach zero before the loop exits,
+        // since each points at its Connection.
+        std::vector<Connection*> connections;
+        std::size_t in_flight = 0;
+
+        // Whether a wake-up is already on its way, so a burst of reports
+        // for this loop's connections costs one eventfd write, not one
+        // each. Cleared by the loop just before it takes the ready list.
+        std::atomic<bool> wake_pending{false};
+
+        // epoll_wait() or io_uring_enter() calls, for io_stats(). This
+        // loop's thread is the only writer.
+        std::atomic<std::uint64_t> syscalls{0};
+
+        // Cancel-on-disconnect commands the queue had no room for when one
+        // of this loop's connections closed, retried every turn -- which
+        // then waits no longer than kPollInterval -- and, before the loop
+        // exits, until they go. Only this loop's thread touches it.
+        std::vector<ExchangeCommand> deferred;
+
+        std::jthread thread;
+    };
+
+    // The accept thread's schedule of clock ticks and auction phase
+    // changes, run by accept_loop(), or by I/O thread 0 instead.
+    struct Schedule {
+        std::chrono::steady_clock::time_point next_tick;
+        std::chrono::steady_clock::time_point next_call;
+        std::chrono::steady_clock::time_point call_ends;
+        // The phase every instrument is being moved to, and how many of them
+        // have been told so far. All told means the move is done and the
+        // next one is waited for.
+        TradingPhase phase = TradingPhase::Continuous;
+        std::size_t phase_sent = 0;
+    };
+    [[nodiscard]] Schedule make_schedule() const;
+    [[nodiscard]] bool has_schedule() const {
+        return options_.clock_tick_interval.count() > 0 || options_.auction_interval.count() > 0;
+    }
+
+    // Submits whatever clock tick or phase change `schedule` says is due,
+    // if clock_tick_interval and auction_interval ask for any.
+    void run_schedule(Schedule& schedule);
+
+    // Runs on the accept thread. Polls accept() against the stop token and
+    // hands each new connection to adopt_connection(). Runs the schedule
+    // too.
     void accept_loop();
 
-    // Runs on this connection's reader thread. Reads bytes, accumulates them
-    // in conn.read_buffer, decodes whole messages out of it, translates each
-    // to a command and submits it. Also handles this session's account
-    // binding, claims ownership of every order id it submits, and unbinds
-    // the session on the way out. Exits when read() reports end of stream or
+    // Builds a Connection for a freshly accepted socket and adds it to the
+    // list, then either spawns its reader and writer threads or registers it
+    // with an event loop, round-robin. Accept thread, or I/O thread 0.
+    void adopt_connection(net::TcpSocket socket);
+
+    // Runs on each I/O thread: waits on the loop's poller and services
+    // whatever it reports -- accepting on loop 0, reading on readability,
+    // writing on writability -- then every connection on the ready list. Loop
+    // 0 also runs the schedule, waking at least every kPollInterval to do so
+    // while there is one. Exits on the stop token.
+    void io_loop(IoLoop& loop);
+
+    // io_loop() for an io_uring loop: arms a multishot recv for each
+    // connection handed to it, and on loop 0 a multishot accept, then
+    // queues a send for every connection on the ready list and waits for
+    // completions -- one io_uring_enter() a turn -- handing each to
+    // uring_complete(). On the way out it shuts its sockets down and waits
+    // for the kernel to give back every operation still pointing at them.
+    void uring_loop(IoLoop& loop);
+
+    // One completion on an io_uring loop: a connection accepted, bytes
+    // received (passed to handle_input(), then the buffer handed back), or
+    // a send finished (the next one queued). End of stream or an error
+    // closes the connection; a multishot operation the kernel ended for any
+    // other reason is armed again.
+    void uring_complete(IoLoop& loop, const net::UringCompletion& completion);
+
+    // io_uring's write_ready(): unless a send is already in flight, queues
+    // one for the rest of write_buffer, refilling it from drain_output()
+    // first if it has all gone. Submitted with the loop's next wait.
+    void uring_send(IoLoop& loop, Connection& conn);
+
+    // I/O thread 0, when the listener is readable: accepts up to
+    // kAcceptBatch connections, so one burst of connects cannot hold up
+    // every session on that loop.
+    void accept_ready();
+
+    // I/O thread, when `conn` is readable: reads until the socket would
+    // block, handing every chunk to handle_input(), or closes the connection
+    // on end of stream or error. Returns true if it stopped at
+    // kReadsPerTurn instead, in which case there may be more to read and the
+    // loop must come back without waiting for another edge.
+    bool read_ready(Connection& conn, std::span<std::byte> chunk);
+
+    // I/O thread, when `conn` is writable or has output scheduled: writes
+    // out write_buffer, refilling it from drain_output() until there is
+    // nothing left or the socket would block. A full socket is left to the
+    // next writability edge; meanwhile the outbound queue fills and routing
+    // drops, exactly as for a writer thread stuck in write().
+    void write_ready(Connection& conn);
+
+    // I/O thread: refills an emptied write_buffer from drain_output(), batch
+    // by batch, until it holds write_flush_bytes or the queues run dry.
+    // Returns false if there was nothing to drain. Nothing more is taken
+    // off the queues than one flush, so a client that stops reading backs
+    // up into its own outbound queue, not into this buffer.
+    bool refill_write_buffer(Connection& conn);
+
+    // Submits a TradingPhaseCommand moving every instrument in
+    // options_.instruments to `phase`, starting from the `next`th; returns
+    // how many the queue took, so a caller can resume where a full queue
+    // stopped it.
+    std::size_t submit_phase(TradingPhase phase, std::size_t next);
+
+    // Runs on this connection's reader thread. Reads bytes into
+    // conn.read_buffer and hands them to handle_input(), then closes the
+    // connection on the way out. Exits when read() reports end of stream or
     // an error, including the shutdown() that stop() performs.
+    void connection_reader_loop(Connection& conn);
+
+    // Decodes every whole message out of conn.read_buffer, translates each
+    // to a command and submits it, leaving any partial frame for next time.
+    // Also handles this session's account binding and claims ownership of
+    // every order id it submits. The reader thread's, or the I/O thread's.
     //
     // A bad type byte and a header whose payload has not fully arrived are
     // treated identically -- wait for more bytes -- because a length-
     // prefixed stream cannot tell them apart. A malformed payload under a
     // valid header drops only that message and keeps the connection, since
     // framing is still intact.
-    void connection_reader_loop(Connection& conn);
+    void handle_input(Connection& conn);
+
+    // The end of a session, for whichever thread reads it: marks it closed,
+    // unbinds it, and shuts its socket down so its writer -- or its event
+    // loop's registration -- lets go of it. Once per connection.
+    void close_connection(Connection& conn);
 
-    // Runs on this connection's writer thread. Drains, in this order: the
-    // replay backlog handed over at bind time, the gateway's own replies,
-    // and reports from the matching thread -- encoding and writing each.
-    // write() can return a short count, so one call is not guaranteed to
-    // flush a whole message. When all three are empty it blocks on the
-    // connection's condition variable rather than polling, so it reacts the
-    // moment a producer pushes. Exits on the stop token, or as soon as its
-    // connection is marked closed.
+    // Runs on this connection's writer thread. Encodes each message
+    // drain_output() yields into conn.write_buffer and writes the lot with a
+    // blocking write -- several if write() comes up short -- once the queues
+    // run dry (after write_linger, if set) or write_flush_bytes have
+    // gathered. With nothing to drain it waits on conn.wake rather than
+    // polling, so it reacts the moment a producer pushes; a linger is the
+    // same wait with a deadline. Exits on the stop token, or as soon as its
+    // connection is marked closed, writing out what it had staged first.
     void connection_writer_loop(Connection& conn, std::stop_token token);
 
+    // One round of a connection's output, shared by both modes: up to one
+    // batch of messages, taken from the first of these that has any -- the
+    // replay backlog handed over at bind time (one message), the gateway's
+    // own replies, the routing thread's reports -- each passed to
+    // `send(const Message&)`. Returns how many; zero means nothing is
+    // waiting. Only the thread writing this connection calls it.
+    template <typename Send>
+    std::size_t drain_output(Connection& conn, Send&& send);
+
+    // Whether drain_output() would find anything -- Connection::output_pending,
+    // so without a lock. Any thread.
+    [[nodiscard]] static bool has_output(Connection& conn);
+
+    // Tells whoever writes `conn` that it has output or a reason to exit:
+    // its writer thread's WaitStrategy, or its event loop's ready list.
+    // Every producer of anything drain_output() takes calls this after
+    // publishing it, so no wake-up is lost. Any thread.
+    void wake_writer(Connection& conn);
+
     // Binds this session to `account_id` on its first valid request and
     // hands over whatever reports accumulated for that account while it had
     // no live session. Runs on the reader thread.
@@ -349,9 +848,17 @@ private:
 
     // Drops this session from the account map and removes every ownership
     // entry pointing at it, so nothing can route to a connection on its way
-    // out. Runs on the reader thread as it exits.
+    // out, then -- if cancel_on_disconnect is set and this was the account's
+    // last session -- submits a MassCancelCommand for the account. Runs on
+    // the reader thread as it exits, or on the connection's I/O thread, or
+    // in stop(). Only the I/O thread must not wait for room in the queue:
+    // it leaves a cancel that does not fit on its loop's `deferred` list.
     void unbind_session(Connection& conn);
 
+    // Submits as much of `loop.deferred` as the queue takes, oldest first.
+    // The loop's own thread only.
+    void submit_deferred(IoLoop& loop);
+
     // Answers a request naming an account this session is not bound to with
     // a Rejected{AccountMismatch}, without the command reaching the
     // pipeline. The connection stays open and stays bound to its original
@@ -360,34 +867,63 @@ private:
 
     // Records this connection as the owner of every order id the message
     // submits under, so the resulting reports come back to this session.
-    // Must run before submit_command(), or the matching thread could emit an
+    // Must run before submit_command(), or the routing thread could see an
     // event for an id with no owner yet. Runs on the reader thread.
     void claim_order_ownership(Connection& conn, AccountId account_id,
                                 const protocol::order_entry::Message& message);
 
+    // One event on its way from the matching thread to routing and
+    // publishing. `hold_remains` is the ledger's answer for a rejected
+    // order, taken on the matching thread when the event was produced -- see
+    // update_order_ownership().
+    struct RoutedEvent {
+        ExchangeEvent event;
+        bool hold_remains = false;
+    };
+
     // The sink handed to the pipeline, so it runs on the matching thread and
-    // must not block. Translates the event into reports, resolves each to a
-    // session -- owning session, else another live session of the account,
-    // else retained -- and then updates order ownership.
+    // must not block. Writes the event into the ring, or, without one, calls
+    // the two below itself.
     void route_event(const ExchangeEvent& event);
 
+    // The ring and its routing and publishing threads, started; null when
+    // event_ring_capacity is zero. Called from the constructor.
+    std::unique_ptr<sequencing::EventFanout<RoutedEvent>> make_event_fanout();
+
+    // The publishing thread's handler: extra_event_sink, if any.
+    void publish_event(const RoutedEvent& routed);
+
+    // The routing thread's handler. Translates the event into reports,
+    // resolves each to a session -- owning session, else another live
+    // session of the account, else retained -- and then updates order
+    // ownership.
+    void route_reports(const RoutedEvent& routed);
+
     // Pushes one report onto a connection's outbound queue and wakes its
     // writer. Called with sessions_mutex_ held. A full queue drops: that
-    // writer has fallen behind, and the matching thread must not wait on it.
+    // writer has fallen behind, and routing -- and so, once the ring fills,
+    // matching -- must not wait on it.
     void deliver(Connection& conn, protocol::order_entry::Message message);
 
+    // Record `conn` as the owner of `key` unless somebody already is, and
+    // forget whoever owns `key`. The only two ways order_owner_ and the
+    // owning session's owned_orders change, so the two never disagree.
+    // Called with sessions_mutex_ held.
+    void claim_owner(const OrderKey& key, Connection& conn);
+    void release_owner(const OrderKey& key);
+
     // Keeps ownership in step with the engine's live orders as events go by:
     // moves ownership to the new id on a replace, and drops keys whose order
     // is provably gone -- cancelled, fully filled, or rejected leaving
     // nothing behind. Called with sessions_mutex_ held.
-    void update_order_ownership(const ExchangeEvent& event);
+    void update_order_ownership(const RoutedEvent& routed);
 
     // Turns one decoded client message into a command. Returns nullopt for a
     // message that is valid wire protocol but not a valid client request --
     // a gateway-to-client type like Accepted arriving from a client, say.
     // The reader ignores a nullopt rather than disconnecting, since this
     // protocol has no error-response type to report it with.
-    [[nodiscard]] static std::optional<ExchangeCommand> to_command(const protocol::order_entry::Message& message);
+    [[nodiscard]] std::optional<ExchangeCommand> to_command(const protocol::order_entry::Message& message) const;
 
     // Turns one event into zero or more (order key, message) pairs to send.
     // Zero for every book event -- those are anonymous and belong to market
@@ -396,34 +932,70 @@ private:
     // different connections, which is why TradeReport is one-sided rather
     // than mirroring TradeExecuted.
     //
-    // The key is what route_event() resolves to a session. The account alone
+    // The key is what route_reports() resolves to a session. The account alone
     // would only narrow a report down to "some connection of this account",
     // which is the exact ambiguity the session model exists to remove.
-    [[nodiscard]] static std::vector<std::pair<OrderKey, protocol::order_entry::Message>> to_execution_reports(
-        const ExchangeEvent& event);
+    //
+    // Two is therefore the most any event yields, so the reports are held
+    // inline, in ExecutionReports below, rather than in a vector: this runs
+    // once per event on the routing thread -- on the matching thread itself
+    // without an event ring -- and a heap allocation per event was once the
+    // only one left between the book and the socket.
+    struct ExecutionReport {
+        OrderKey key;
+        protocol::order_entry::Message message;
+    };
+    class ExecutionReports {
+    public:
+        static constexpr std::size_t kCapacity = 2; // a trade's buyer and seller
+
+        void push(const OrderKey& key, protocol::order_entry::Message message) {
+            reports_[count_++] = ExecutionReport{.key = key, .message = std::move(message)};
+        }
+        [[nodiscard]] bool empty() const { return count_ == 0; }
+        [[nodiscard]] std::size_t size() const { return count_; }
+        [[nodiscard]] ExecutionReport* begin() { return reports_.data(); }
+        [[nodiscard]] ExecutionReport* end() { return reports_.data() + count_; }
+
+    private:
+        std::array<ExecutionReport, kCapacity> reports_{};
+        std::size_t count_ = 0;
+    };
+    [[nodiscard]] static ExecutionReports to_execution_reports(const ExchangeEvent& event);
 
     std::uint16_t port_;
     OrderEntryGatewayOptions options_;
 
     net::TcpSocket listener_;
-    std::stop_source stop_source_; // shared by accept_loop() and every connection_writer_loop()
+    std::stop_source stop_source_; // shared by accept_loop(), every connection_writer_loop() and io_loop()
     std::jthread accept_thread_;
 
+    // Empty unless io_threads is set and epoll or io_uring could be set up,
+    // which is then what every other part of the gateway checks. Filled by
+    // start(), before any thread that reads it exists; a connection's `loop`
+    // points into it. backend_ is which of the two, or Threads.
+    std::vector<std::unique_ptr<IoLoop>> io_loops_;
+    GatewayIoBackend backend_ = GatewayIoBackend::Threads;
+
+    // Fills io_loops_ with options_.io_threads loops of `backend`, or leaves
+    // it empty and returns false if that backend cannot be set up here.
+    bool make_io_loops(GatewayIoBackend backend);
+
     // Guarded by connections_mutex_: the accept thread appends, and
     // connection_count() and stop() read from whatever thread calls them.
     // Connections are held by unique_ptr so the raw pointers in the routing
     // maps below stay valid as this vector grows, and none are erased before
     // stop() -- a disconnected session makes itself unreachable by unbinding
-    // rather than by being destroyed under a pointer the matching thread may
+    // rather than by being destroyed under a pointer the routing thread may
     // still hold.
     mutable std::mutex connections_mutex_;
     std::vector<std::unique_ptr<Connection>> connections_;
 
-    SessionId next_session_id_ = 1; // accept thread only
+    SessionId next_session_id_ = 1; // accept thread, or I/O thread 0, only
 
     // ── Routing state, all guarded by sessions_mutex_ ─────────────────────
     // Written by reader threads when they bind, unbind or claim an order id,
-    // and read and written by the matching thread in route_event(). Every
+    // and read and written by the routing thread in route_reports(). Every
     // pointer here is non-owning; connections_ above owns the objects.
     std::mutex sessions_mutex_;
 
@@ -433,19 +1005,75 @@ private:
 
     // Which session an order belongs to, and therefore where its private
     // reports go. Filled in when a reader thread submits a command, kept in
-    // step with the engine's live orders by update_order_ownership().
-    std::unordered_map<OrderKey, Connection*, OrderKeyHash> order_owner_;
+    // step with the engine's live orders by update_order_ownership(). `entry`
+    // is this key's place in conn->owned_orders.
+    struct Owner {
+        Connection* conn;
+        std::list<OrderKey>::iterator entry;
+    };
+    std::unordered_map<OrderKey, Owner, OrderKeyHash> order_owner_;
 
     // Reports for an account with no live session, replayed to the next
     // session that binds to it. Bounded by pending_report_capacity.
     std::unordered_map<AccountId, std::deque<protocol::order_entry::Message>> pending_reports_;
 
-    std::mutex submit_mutex_; // see submit_command()
+    // The pipeline's sink and processor, as named types rather than
+    // std::functions, so the matching thread's path from command to
+    // route_event() -- risk check, matching, ledger update -- has no
+    // type-erased call in it (see event_sink.hpp).
+    struct RouteEvent {
+        OrderEntryGateway* gateway;
+        void operator()(const ExchangeEvent& event) const { gateway->route_event(event); }
+    };
+    struct RiskGated {
+        OrderEntryGateway* gateway;
+        void operator()(const ExchangeCommand& command, RouteEvent& sink) const {
+            gateway->risk_gated_engine_.process(command, sink);
+            gateway->after_command(command);
+        }
+    };
+
+    // Runs on the matching thread after every command: publishes the
+    // command's events to the ring in one go, queues the rest of a mass
+    // cancel that stopped at its batch, counts towards the next periodic
+    // snapshot and captures it when due. A capture the snapshot thread is
+    // too far behind to take is retried on the next command rather than
+    // skipped.
+    void after_command(const ExchangeCommand& command) {
+        if (events_) {
+            events_->publish();
+        }
+        if (const std::size_t cancelled = std::exchange(cancelled_in_command_, 0);
+            cancelled > 0 || !unfinished_mass_cancels_.empty()) {
+            continue_mass_cancel(command, cancelled);
+        }
+        if (snapshotter_ && ++commands_since_snapshot_ >= options_.snapshot_every_commands &&
+            snapshotter_->capture(engine_)) {
+            commands_since_snapshot_ = 0;
+        }
+    }
 
     MatchingEngine engine_;
     ledger::Ledger ledger_;
     risk::RiskGatedEngine risk_gated_engine_; // engine_ + ledger_ + RiskEngine
-    sequencing::MatchingPipeline pipeline_;    // its processor calls risk_gated_engine_
+    // Null unless snapshot_every_commands is set. Before the pipeline, so it
+    // exists before the matching thread that feeds it starts.
+    std::unique_ptr<persistence::BackgroundSnapshotter> snapshotter_;
+    std::size_t commands_since_snapshot_ = 0; // matching thread only
+
+    // Submits the rest of `command` if it was a mass cancel that cancelled
+    // its whole batch (`cancelled` orders), after any earlier rest still
+    // waiting for room. Matching thread only.
+    void continue_mass_cancel(const ExchangeCommand& command, std::size_t cancelled);
+    // OrderCancelled events the command being matched has produced so far,
+    // and the rests of mass cancels the queue was full for. Matching thread
+    // only.
+    std::size_t cancelled_in_command_ = 0;
+    std::deque<MassCancelCommand> unfinished_mass_cancels_;
+    // Null when event_ring_capacity is zero. Before the pipeline, so it
+    // exists before the matching thread that writes to it starts.
+    std::unique_ptr<sequencing::EventFanout<RoutedEvent>> events_;
+    sequencing::BasicMatchingPipeline<RouteEvent, RiskGated> pipeline_; // its processor calls risk_gated_engine_
 };
 
 } // namespace mdh::exchange::gateway
@@ -22,7 +22,9 @@
 // A resting GTC order can outlive many other commands, so the money behind
 // it has to be locked for as long as it rests. Otherwise two GTC orders from
 // the same account could each pass a balance check against the same unspent
-// funds.
+// funds. A GTD order is a GTC order that the engine cancels at its expiry,
+// and is held exactly the same way; the expiry is an OrderCancelled like
+// any other, so its hold is released by the same path.
 //
 // IOC and FOK orders are different. The engine resolves them completely
 // inside one process() call, and matching is single-threaded, so no other
@@ -50,7 +52,9 @@
 // is released for the filled slice but only the true trade price is debited,
 // so the difference reappears in `available` (total minus reserved) by
 // itself, with no refund bookkeeping. A resting order's own price *is* the
-// trade price, so this never applies to the passive side.
+// trade price in continuous trading; only an auction's uncross fills resting
+// orders at a better price than their own, and the same arithmetic covers
+// that without change.
 namespace mdh::exchange::ledger {
 
 // Cash is kept on the same fixed-point tick scale as Price (common/
@@ -177,7 +181,7 @@ private:
     void settle_leg(const TradeCounterparty& leg, Side side, InstrumentId instrument_id, Price trade_price,
                      Quantity trade_quantity);
 
-    // Opens a hold for a newly-accepted GTC order (no-op for IOC/FOK).
+    // Opens a hold for a newly-accepted GTC or GTD order (no-op for IOC/FOK).
     void on_order_accepted(const OrderAccepted& event);
     // Releases the old order's hold and opens a fresh one for the replacement.
     void on_order_replaced(const OrderReplaced& event);
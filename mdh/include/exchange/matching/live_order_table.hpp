@@ -0,0 +1,203 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "exchange/core/types.hpp"
+#include "exchange/matching/matching_book.hpp"
+
+// The matching engine's directory of live resting orders: (account, client
+// order id) -> where the order rests and the fields only a snapshot reads.
+//
+// It was a std::pmr::unordered_map, which cost a pooled 56-byte node per
+// order plus a bucket pointer, so every cancel and replace paid a bucket
+// load and then a hop into pool memory to reach one 24-byte value. Its hash
+// was account ^ (client << 1), and order flow is exactly the input that
+// breaks that: one account's client order ids are sequential, so consecutive
+// orders landed in consecutive buckets and a few busy accounts piled up on
+// the same ones.
+//
+// This is a flat open-addressing table instead:
+//   - Entries are stored inline in one array, key and OrderRef together, so
+//     a hit is one probe into memory the table owns.
+//   - Robin Hood linear probing, with a byte per slot recording how far its
+//     entry sits from its home slot. A lookup stops as soon as it meets an
+//     entry closer to home than it is, so a miss -- every new order's
+//     duplicate check -- costs about as much as a hit, and probe lengths
+//     stay short even near full.
+//   - Deletion shifts the following run back one slot rather than leaving a
+//     tombstone, so a table that cancels as fast as it rests never fills up
+//     with dead slots and never needs a cleaning rehash.
+//   - The home slot is the hash scaled onto the capacity (a multiply and a
+//     shift) rather than masked, so the capacity need not be a power of two
+//     and a table sized for a million orders is not rounded up to two.
+namespace mdh::exchange {
+
+// A client order id is only unique within an account -- two accounts may
+// both pick id 1 -- so live orders are keyed on the pair. The key is global
+// rather than per-instrument, which is what makes an id already live on
+// another instrument count as a duplicate.
+struct LiveKey {
+    AccountId account_id;
+    ClientOrderId client_order_id;
+
+    bool operator==(const LiveKey&) const = default;
+};
+
+// Everything the engine knows about a live resting order that the book does
+// not: which book it is in, where in that book, and the two fields only a
+// snapshot reads.
+//
+// This is the one per-order directory. It replaced a pair of tables -- this
+// one plus a per-book index keyed by exchange order id -- whose lookups ran
+// strictly one after the other, so every cancel and replace paid both cache
+// misses and every resting order carried two hash entries that grew and
+// rehashed independently.
+//
+// Fields are widest-first on purpose, for the reason given on
+// ExchangeRestingOrder: grouped by meaning instead, this would pad to 32
+// bytes. At 24 a table entry is 40 bytes, key included.
+struct OrderRef {
+    Quantity original_quantity;
+    std::uint64_t order_sequence;
+    MatchingBook::Handle handle;
+    InstrumentId instrument_id;
+};
+
+static_assert(sizeof(OrderRef) == 24, "see the note above on what this size is protecting");
+
+// A pending stop order (see MatchingEngine) has an entry here too, so that
+// whether a client order id is taken stays one probe however many stops
+// are waiting. Its order_sequence carries kPendingStop, a bit no real
+// priority reaches, and its handle is into its book's stop book.
+inline constexpr std::uint64_t kPendingStop = std::uint64_t{1} << 63;
+
+[[nodiscard]] constexpr bool is_pending_stop(const OrderRef& ref) { return (ref.order_sequence & kPendingStop) != 0; }
+
+class LiveOrderTable {
+public:
+    // Sized so that `expected_entries` fit without growing. Growth rehashes
+    // every entry at once, which is the one slow operation this table has,
+    // so the engine passes its expected_resting_orders straight through.
+    explicit LiveOrderTable(std::size_t expected_entries = 0);
+
+    // Null if the key is not live. The pointer is good until the next
+    // insert or erase.
+    [[nodiscard]] OrderRef* find(const LiveKey& key) {
+        const std::size_t index = index_of(key);
+        return index == kNotFound ? nullptr : &entries_[index].ref;
+    }
+    [[nodiscard]] const OrderRef* find(const LiveKey& key) const {
+        const std::size_t index = index_of(key);
+        return index == kNotFound ? nullptr : &entries_[index].ref;
+    }
+    [[nodiscard]] bool contains(const LiveKey& key) const { return index_of(key) != kNotFound; }
+
+    void insert_or_assign(const LiveKey& key, const OrderRef& ref);
+
+    // Returns whether the key was live.
+    bool erase(const LiveKey& key) {
+        const std::size_t index = index_of(key);
+        if (index == kNotFound) {
+            return false;
+        }
+        erase_at(index);
+        return true;
+    }
+
+    // Erases the entry `found` points at, which find() must just have
+    // returned, without probing for it a second time. Cancel and replace
+    // both look an order up before deciding to remove it.
+    void erase(const OrderRef* found) {
+        const auto* entry = reinterpret_cast<const Entry*>(reinterpret_cast<const char*>(found) - offsetof(Entry, ref));
+        erase_at(static_cast<std::size_t>(entry - entries_.get()));
+    }
+
+    // Makes room for `entries` without any further growth.
+    void reserve(std::size_t entries);
+
+    [[nodiscard]] std::size_t size() const { return size_; }
+    [[nodiscard]] bool empty() const { return size_ == 0; }
+    [[nodiscard]] std::size_t capacity() const { return capacity_; }
+
+private:
+    struct Entry {
+        LiveKey key;
+        OrderRef ref;
+    };
+
+    static_assert(sizeof(Entry) == 40, "an entry is its key and its OrderRef, nothing else");
+
+    static constexpr std::size_t kNotFound = ~std::size_t{0};
+
+    // Probe distance plus one, per slot; zero means empty. Stored values stop
+    // at kMaxDistance, one short of the byte's range, so a lookup that has
+    // walked further than any entry could sit always meets a smaller byte
+    // and ends. A decent hash at this load never gets near it: an insert
+    // that would pass it grows the table instead.
+    static constexpr std::uint8_t kEmpty = 0;
+    static constexpr std::uint8_t kMaxDistance = 254;
+
+    // Entries per slot at most, as a fraction: 7/8. Robin Hood keeps probes
+    // short well past where plain linear probing degrades, and the
+    // difference between this and a lower bound is memory on every table.
+    static constexpr std::size_t kLoadNumerator = 7;
+    static constexpr std::size_t kLoadDenominator = 8;
+
+    // The key's two halves mixed through a full 64-bit finaliser, so that
+    // sequential client order ids -- which is what every account sends --
+    // scatter across the table instead of landing side by side.
+    [[nodiscard]] static std::uint64_t hash(const LiveKey& key) {
+        std::uint64_t x = key.client_order_id ^ (key.account_id * 0x9E3779B97F4A7C15ULL);
+        x ^= x >> 33U;
+        x *= 0xFF51AFD7ED558CCDULL;
+        x ^= x >> 33U;
+        x *= 0xC4CEB9FE1A85EC53ULL;
+        x ^= x >> 33U;
+        return x;
+    }
+
+    [[nodiscard]] std::size_t home_of(const LiveKey& key) const {
+        return static_cast<std::size_t>((static_cast<__uint128_t>(hash(key)) * capacity_) >> 64U);
+    }
+    [[nodiscard]] std::size_t next(std::size_t index) const { return index + 1 == capacity_ ? 0 : index + 1; }
+
+    [[nodiscard]] std::size_t index_of(const LiveKey& key) const {
+        if (size_ == 0) {
+            return kNotFound;
+        }
+        std::size_t index = home_of(key);
+        // An entry at distance d can only be in a slot whose byte says d, and
+        // once the bytes fall below the distance walked so far, it would
+        // have been placed before them.
+        for (std::uint8_t distance = 1;; ++distance) {
+            const std::uint8_t here = distance_[index];
+            if (here < distance) {
+                return kNotFound;
+            }
+            if (here == distance && entries_[index].key == key) {
+                return index;
+            }
+            index = next(index);
+        }
+    }
+
+    // Places an entry known not to be present. Returns false, having placed
+    // nothing further, if some entry would have had to travel past
+    // kMaxDistance -- `entry` then holds whichever entry was left homeless.
+    [[nodiscard]] bool place(Entry& entry);
+    void erase_at(std::size_t index);
+    void rehash(std::size_t capacity);
+
+    std::size_t capacity_ = 0;
+    std::size_t size_ = 0;
+    std::size_t max_size_ = 0; // size_ beyond which the next insert grows
+    // Uninitialised on purpose: an entry means nothing unless its distance
+    // byte says the slot is occupied, and the bytes are zeroed.
+    std::unique_ptr<Entry[]> entries_;
+    std::vector<std::uint8_t> distance_;
+};
+
+} // namespace mdh::exchange
@@ -2,14 +2,18 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <limits>
 #include <map>
 #include <memory>
 #include <memory_resource>
 #include <optional>
+#include <span>
+#include <unordered_map>
 #include <vector>
 
 #include "common/types.hpp"
 #include "exchange/matching/resting_order.hpp"
+#include "exchange/matching/state_digest.hpp"
 
 // The exchange's authoritative order book for one instrument. It holds
 // BookOrder (account, remaining quantity, time in force) and exposes the
@@ -25,34 +29,115 @@
 // hash lookups to reach one list node, and every resting order carried two
 // hash nodes that rehashed independently.
 //
-// Three structures, none of them the obvious one:
+// Four structures, none of them the obvious one:
 //   - Orders live in one flat per-book slab, and a price level is just a
 //     pair of indices into it, so a level needs no container of its own.
+//     The slab is two parallel arrays: the queue links and quantity that
+//     every walk reads, and the identity fields only an event reads.
 //   - Prices within a band around the book are indexed by a tick ladder: a
 //     flat array plus a hierarchical occupancy bitmap, so finding the best
 //     price is a few count-leading-zeros over words that stay in L1, and
-//     finding a level is an array index.
+//     finding a level is an array index. The band follows the touch when
+//     the market trends away from it; see SideIndex.
 //   - Prices outside that band fall back to a std::pmr::map. Real exchanges
 //     do band prices, but as a published risk control rather than as a side
 //     effect of a data structure, so an out-of-band price is stored here,
 //     not rejected. See bench-results/stage3-ladder-band-decision.txt for
 //     the measurements behind the band width.
+//   - Each account's orders on the book are chained through the slab a
+//     second way, oldest first: links in a third array parallel to the
+//     slab's two, and one small map from account to chain. The ladder and
+//     the map above find an order by price; the chain finds it by owner, so
+//     taking all of one account's orders off is a walk down that chain
+//     rather than a search of every level. Every insert and removal keeps
+//     both in step.
 namespace mdh::exchange {
 
+// One price level as a market observer sees it: how much rests there and
+// in how many orders, but not whose.
+struct LevelDepth {
+    Price price;
+    Quantity quantity;
+    std::uint32_t order_count;
+
+    bool operator==(const LevelDepth&) const = default;
+};
+
+// Where a book in its call phase would uncross: the one price every
+// matched order trades at, how much trades there, and the buy quantity
+// willing to trade at that price less the sell -- positive when buyers are
+// left over, negative when sellers are.
+struct Equilibrium {
+    Price price;
+    Quantity volume;
+    std::int64_t imbalance;
+
+    bool operator==(const Equilibrium&) const = default;
+};
+
+// How often a book's ladders have had to move to follow the touch, and how
+// much moving them cost. Cumulative over the book's life; the engine sums
+// them across its books.
+struct LadderRebaseCounters {
+    // Re-centerings started. Each one runs to completion over as many
+    // operations as it takes before the next can start.
+    std::uint64_t rebases = 0;
+    // Price levels moved between a ladder and its overflow map, in either
+    // direction, by those re-centerings.
+    std::uint64_t levels_migrated = 0;
+
+    LadderRebaseCounters& operator+=(const LadderRebaseCounters& other) {
+        rebases += other.rebases;
+        levels_migrated += other.levels_migrated;
+        return *this;
+    }
+};
+
+// The ladder memory a set of books shares: every book an engine owns draws
+// its ladders from one of these, so the engine's byte budget is spent on
+// the instruments actually resting orders rather than split evenly across
+// the whole universe up front. Counted in LevelSlot bytes, the way band_for()
+// counts them; the occupancy bitmaps are under 1% on top and left out.
+struct LadderBudget {
+    std::size_t byte_limit = 0;
+    std::size_t bytes_in_use = 0;
+    // Over the budget's life: ladders allocated, ladders re-allocated wider,
+    // ladders given back, and the inserts that wanted one and found not even
+    // the narrowest band would fit.
+    std::uint64_t materialised = 0;
+    std::uint64_t widened = 0;
+    std::uint64_t reclaimed = 0;
+    std::uint64_t refusals = 0;
+};
+
 class MatchingBook {
 public:
-    // The widest band one side will index with a ladder, in ticks. At 8
-    // bytes a level that is 64 KB per side. Measured distributions put a
+    // The widest band one side will index with a ladder, in ticks. At 24
+    // bytes a level that is 192 KB per side. Measured distributions put a
     // realistic book's entire occupied range under a hundred ticks, so this
     // is not a tight fit -- it is the point where the next step up stops
     // paying for itself.
     static constexpr std::uint32_t kMaxBandTicks = 8'192;
 
     // Below this a ladder is not worth its fixed cost and the book runs on
-    // the map alone. The engine passes a band of zero when its universe is
-    // too large for every book to afford one.
+    // the map alone. A book drawing on a LadderBudget that cannot spare this
+    // much runs on the map until it can.
     static constexpr std::uint32_t kMinBandTicks = 1'024;
 
+    // The most price levels one operation will move between a ladder and
+    // its overflow map while re-centering. Each move is one map insert or
+    // erase, so this is what bounds the latency a rebase can add to any
+    // single command; a rebase needing more finishes over the next few.
+    static constexpr std::uint32_t kRebaseLevelsPerStep = 8;
+
+    // The most price levels a side may hold for its ladder to be allocated,
+    // widened or given back. Each of those moves every level the side has
+    // between the ladder and the map in one go -- unlike a rebase, there is
+    // no half-built ladder to spread the work across -- so this bounds what
+    // one command can pay for it. A side deeper than this keeps whatever it
+    // has until it thins out.
+    static constexpr std::uint32_t kMaxLevelsMovedAtOnce = 128;
+
     // The widest band `instrument_count` books can each afford two of within
     // `byte_budget`, rounded down to a power of two, or zero if that comes
     // out below kMinBandTicks. A ladder costs instruments x band x 2 sides,
@@ -70,7 +155,17 @@ public:
     // `band_ticks` is how wide this book's ladder may be: zero, or a power
     // of two between kMinBandTicks and kMaxBandTicks. Zero means no ladder.
     // The engine works out both numbers, so those are the ones to get right.
-    explicit MatchingBook(std::size_t expected_resting_orders = 0, std::uint32_t band_ticks = kMaxBandTicks);
+    //
+    // A side's ladder is allocated when it first gets an order, not here.
+    // Without a `budget` that is all: the band is fixed and the ladder is
+    // kept for the book's life. With one, the ladder comes out of the
+    // budget, `band_ticks` is only where a side starts -- narrower if the
+    // budget is short, none at all if it is spent, and doubling, up to
+    // kMaxBandTicks, each time the side has to re-centre with levels
+    // already spilled past both edges -- and release_ladders() gives it
+    // back. The budget must outlive the book.
+    explicit MatchingBook(std::size_t expected_resting_orders = 0, std::uint32_t band_ticks = kMaxBandTicks,
+                          LadderBudget* budget = nullptr);
 
     // Where one resting order sits: an index into this book's slab, nothing
     // more. Returned by add(), accepted by every operation on an order
@@ -105,7 +200,9 @@ public:
     void reduce_at(Handle handle, Quantity new_remaining_quantity);
     void set_client_order_id_at(Handle handle, ClientOrderId new_client_order_id);
 
-    [[nodiscard]] const BookOrder& at(Handle handle) const;
+    // A copy: the order's fields are split across the slab's two arrays
+    // (see HotOrder), so there is no one BookOrder to point at.
+    [[nodiscard]] BookOrder at(Handle handle) const;
 
     [[nodiscard]] std::optional<Price> best_bid_price() const;
     [[nodiscard]] std::optional<Price> best_ask_price() const;
@@ -114,15 +211,15 @@ public:
     // the best price on one side. `book_side` picks the side (Buy -> bids,
     // Sell -> asks), matching the resting orders' own .side.
     //
-    // Returns a pointer into the book, not a copy: the matching loop calls
-    // this once per fill and reads only a few fields, so returning by value
-    // copied the whole order every iteration. nullptr means that side is
-    // empty. The pointee dies at the next change to *either* side --
-    // remove_front() destroys it, and any add() may relocate the slab -- so
-    // read out anything needed afterwards first. remove_front() also
-    // invalidates that order's Handle, which the caller must drop from its
-    // own table.
-    [[nodiscard]] const BookOrder* front_of_best(Side book_side) const;
+    // Returns the order by value, assembled from both halves of the slab;
+    // nullopt means that side is empty. Every field it copies is one a fill
+    // reports, so nothing is read that the loop did not need. It also
+    // prefetches the order queued behind this one: a sweep consumes fronts
+    // one after another, and the next one's cache misses are then already
+    // under way while the engine emits this one's events. remove_front()
+    // invalidates the returned order's Handle, which the caller must drop
+    // from its own table.
+    [[nodiscard]] std::optional<BookOrder> front_of_best(Side book_side) const;
     void reduce_front(Side book_side, Quantity new_remaining_quantity);
     void remove_front(Side book_side);
 
@@ -133,13 +230,74 @@ public:
     [[nodiscard]] std::vector<BookOrder> all_bids() const;
     [[nodiscard]] std::vector<BookOrder> all_asks() const;
 
+    // How many orders `account_id` has resting here.
+    [[nodiscard]] std::size_t account_order_count(AccountId account_id) const;
+
+    // Removes every order `account_id` has resting here -- on `side` only,
+    // if one is given -- oldest first, and calls `on_removed(order)` with
+    // each as it goes, after the order has left the book. Stops after
+    // `limit` of them, leaving the rest for a later call, and passes over
+    // any order whose exchange order id is `before_exchange_order_id` or
+    // higher. Returns how many it removed. One hash lookup finds the
+    // account's chain; each order after that is a link followed, so the
+    // cost is the account's orders here and not the book's. Every Handle to
+    // a removed order is dead, and `on_removed` must not touch this book.
+    //
+    // The id bound is checked order by order rather than ending the walk:
+    // the chain is in the order orders came to rest, and a released stop
+    // rests later than orders with higher ids than its own.
+    template <class OnRemoved>
+    std::size_t remove_account_orders(AccountId account_id, std::optional<Side> side, OnRemoved&& on_removed,
+                                      std::size_t limit = std::numeric_limits<std::size_t>::max(),
+                                      ExchangeOrderId before_exchange_order_id =
+                                          std::numeric_limits<ExchangeOrderId>::max()) {
+        const auto found = chain_of_account_.find(account_id);
+        if (found == chain_of_account_.end()) {
+            return 0;
+        }
+        const std::uint32_t chain = found->second;
+        std::size_t removed = 0;
+        std::uint32_t slot = account_chains_[chain].head;
+        while (slot != kNil && removed < limit) {
+            const std::uint32_t next = account_links_[slot].next;
+            if ((!side.has_value() || cold_[slot].side == *side) &&
+                cold_[slot].exchange_order_id < before_exchange_order_id) {
+                on_removed(remove_at(Handle{.slot = slot}));
+                ++removed;
+            }
+            slot = next;
+        }
+        return removed;
+    }
+
+    // Calls `fn(account_id)` for each account that has rested its first
+    // order here since the last call, once each, and forgets them. An
+    // account's chain outlives its orders, so an account is new to a book
+    // only once. This is how MatchingEngine learns which books an account
+    // has orders in without asking every book on every mass cancel.
+    template <class Fn>
+    void take_new_accounts(Fn&& fn) {
+        for (const AccountId account_id : new_accounts_) {
+            fn(account_id);
+        }
+        new_accounts_.clear();
+    }
+    [[nodiscard]] bool has_new_accounts() const { return !new_accounts_.empty(); }
+
     // FOK's all-or-nothing pre-check: sums resting quantity on `book_side`
     // that would immediately cross at `price` or better, stopping at the
-    // first non-crossing level or as soon as `quantity` is covered. Walks
-    // the price index in place, so unlike all_bids()/all_asks() it copies
-    // nothing and costs only what it actually looks at.
+    // first non-crossing level or as soon as `quantity` is covered. Reads
+    // each level's running total rather than its orders, so it costs one
+    // step per level crossed however finely those levels are split.
     [[nodiscard]] Quantity crossable_quantity(Side book_side, Price price, Quantity quantity) const;
 
+    // Aggregated depth: the best `out.size()` levels of `book_side`, best
+    // first, written into `out`. Returns how many were written -- fewer when
+    // the side is shallower. Writes into the caller's storage and reads only
+    // the level totals, so a depth-of-book view costs one step per level and
+    // allocates nothing, where all_bids()/all_asks() copy every order.
+    std::size_t depth(Side book_side, std::span<LevelDepth> out) const;
+
     // How many of this book's price levels sit outside the ladder's band and
     // so live in the fallback map. Zero is the case the ladder was built
     // for; a book where this keeps pace with the level count has its band in
@@ -147,39 +305,151 @@ public:
     // inferring from a latency.
     [[nodiscard]] std::size_t out_of_band_levels() const;
 
+    // Both sides' ladder re-centering so far.
+    [[nodiscard]] LadderRebaseCounters rebase_counters() const;
+
+    // The book's trading phase. The book does not act on it -- the engine
+    // is what declines to match during a call -- but keeps it because the
+    // engine's matching path reads the book anyway. A change bumps
+    // version(), so an incremental snapshot copies the book.
+    [[nodiscard]] TradingPhase trading_phase() const { return phase_; }
+    void set_trading_phase(TradingPhase phase) {
+        if (phase != phase_) {
+            phase_ = phase;
+            ++version_;
+        }
+    }
+
+    // The uncrossing price of a crossed book, or nullopt if it is not
+    // crossed. The price is the one that trades the most quantity; among
+    // those, the one leaving the smallest imbalance; among those, the
+    // highest if every one leaves buyers over, the lowest if every one
+    // leaves sellers over, and otherwise the one nearest `reference`
+    // (lower on a tie), or nearest the midpoint of the best bid and ask
+    // without one.
+    //
+    // One pass over the levels that cross -- bids at or above the best ask
+    // and asks at or below the best bid -- reading each level's running
+    // total and never its orders, so the cost is the crossed levels however
+    // many orders make them up.
+    [[nodiscard]] std::optional<Equilibrium> equilibrium(std::optional<Price> reference) const;
+
+    // Bumped by every change to what the book holds -- an order added,
+    // removed, or edited in place -- and by a change of trading phase, and
+    // by nothing else: moving levels between the ladder and the map is not
+    // a change. Two reads that return
+    // the same number saw the same orders, which is what lets the engine
+    // tell which books an incremental snapshot has to copy.
+    [[nodiscard]] std::uint64_t version() const { return version_; }
+
+    // The sum of order_digest() over every resting order (see
+    // state_digest.hpp), kept current by the same operations that bump
+    // version(): each adds the digest of what it created and subtracts the
+    // digest of what it destroyed or rewrote, so reading it is free and
+    // keeping it costs a few multiplies per change, however deep the book.
+    // Two books holding the same orders have the same digest whatever route
+    // they took there, which version() cannot say.
+    [[nodiscard]] std::uint64_t state_digest() const { return digest_; }
+
+    // Whether either side currently holds a ladder, and how wide the
+    // widest is. Zero for a book with no ladder, which is every book before
+    // its first order and every book the budget could not fit.
+    [[nodiscard]] bool has_ladder() const { return bids_.has_ladder() || asks_.has_ladder(); }
+    [[nodiscard]] std::uint32_t ladder_band_ticks() const {
+        return bids_.band_ticks() > asks_.band_ticks() ? bids_.band_ticks() : asks_.band_ticks();
+    }
+
+    // Gives each side's ladder back to the budget, moving whatever levels
+    // it held into the overflow map, for an instrument that has gone quiet.
+    // A side deeper than kMaxLevelsMovedAtOnce keeps its ladder. Each side
+    // starts again from the book's original band the next time it gets an
+    // order: the band it grew into described activity that has stopped.
+    void release_ladders();
+
 private:
     // End-of-chain and empty-level sentinel. Slots are 32-bit, not
     // size_t: a book with four billion resting orders has a bigger problem
-    // than its index width, and halving the links keeps a slab entry at 56
+    // than its index width, and halving the links keeps a hot entry at 16
     // bytes.
     static constexpr std::uint32_t kNil = ~0U;
 
-    // One resting order plus its place in a doubly-linked queue, held by
-    // index. This replaced a std::pmr::list per price level, which cost a
-    // 64-byte pooled node per order plus a 32-byte list header per level and
-    // reached each order by chasing a pointer into pool memory.
+    // One resting order is one slot in two parallel arrays. This replaced a
+    // std::pmr::list per price level, which cost a 64-byte pooled node per
+    // order plus a 32-byte list header per level and reached each order by
+    // chasing a pointer into pool memory.
     //
-    // Indices rather than pointers are what let the slab be a plain vector:
+    // Indices rather than pointers are what let the slab be plain vectors:
     // growth relocates every order, and a handle is an offset, so it
     // survives untouched. So does moving the whole book, which happens to
     // every book when the engine grows its own vector.
-    struct SlabOrder {
-        BookOrder order;
+    //
+    // The split is by who reads what. Walking a queue -- unlinking a
+    // cancelled order, which rewrites both neighbours' links, or taking a
+    // level's front and moving to the next -- needs only the links and the
+    // quantity, which level totals are kept from. Those are HotOrder, four
+    // to a cache line. Who the order belongs to and what it is called are
+    // read only when an event names it, so they sit apart in ColdOrder and
+    // a walk never drags them through the cache. It was one 56-byte entry
+    // before, with a neighbour's link sharing its line with that order's
+    // account and ids; the two halves still add up to 56.
+    struct HotOrder {
+        Quantity remaining_quantity;
         std::uint32_t next;
         std::uint32_t prev;
     };
 
-    static_assert(sizeof(SlabOrder) == 56, "a slab entry is BookOrder plus two 32-bit links, and 56 bytes of it "
-                                            "per resting order is the figure bench_matching_memory reports");
+    struct ColdOrder {
+        ExchangeOrderId exchange_order_id;
+        ClientOrderId client_order_id;
+        AccountId account_id;
+        Price price;
+        Side side;
+        TimeInForce time_in_force;
+    };
 
-    // A whole price level: the head and tail of its queue through the slab.
-    // Eight bytes, which is what makes a ladder of them affordable -- a band
-    // of 8192 is 64 KB.
+    // The order's place in its account's chain on this book: the account's
+    // previous and next order here, and which chain. A third array rather
+    // than more of ColdOrder because only adding, removing and a mass cancel
+    // read it -- never a fill's events, never a queue walk -- and because
+    // carrying the chain's index is what lets a removal fix the chain's
+    // ends without hashing the account.
+    struct AccountLink {
+        std::uint32_t next;
+        std::uint32_t prev;
+        std::uint32_t chain;
+    };
+
+    // One account's orders on this book, oldest first.
+    struct AccountChain {
+        std::uint32_t head = kNil;
+        std::uint32_t tail = kNil;
+        std::uint32_t count = 0;
+    };
+
+    static_assert(sizeof(HotOrder) == 16, "four hot entries to a cache line is what the split is for");
+    static_assert(sizeof(AccountLink) == 12, "bench_matching_memory reports a slab entry as 16 + 40 + 12");
+    static_assert(sizeof(HotOrder) + sizeof(ColdOrder) == 56,
+                  "the two halves of an order are the figure bench_matching_memory reports per slab entry");
+
+    // A whole price level: the head and tail of its queue through the slab,
+    // plus the level's running totals. link_back() and unlink() keep the
+    // totals in step with the queue, and every quantity edit goes through
+    // adjust_quantity(), so they are exact at every point a caller can
+    // observe.
+    //
+    // The totals took this from 8 bytes to 24 -- a band of 8192 is now
+    // 192 KB -- and kLadderByteBudget grew by the same factor, so every
+    // universe size keeps the band it had. The pages a book never touches
+    // are still never faulted in.
     struct LevelSlot {
+        Quantity total_quantity = 0;
         std::uint32_t head = kNil;
         std::uint32_t tail = kNil;
+        std::uint32_t order_count = 0;
     };
 
+    static_assert(sizeof(LevelSlot) == 24, "band_for() and kLadderByteBudget are sized from this");
+
     // One side's price index: a tick ladder over a band, plus a map for
     // anything outside it. Ordering is by price priority -- descending for
     // bids, ascending for asks -- so "first" always means the best price and
@@ -190,12 +460,44 @@ private:
     // occupied, so there is nothing to zero, and pages of a band nobody
     // touches are never faulted in. That is what makes a wide band cheap for
     // a book using only a corner of it.
+    //
+    // The band slides. A side anchors on its first price, but a market that
+    // trends far enough would otherwise leave every new level in the
+    // overflow map and quietly turn matching back into tree operations. So
+    // the ladder is a ring: a price lives at slot `price mod band`, whatever
+    // the band's base is. Moving the base by d ticks therefore moves no
+    // level that stays inside the band -- only the ones crossing its edges,
+    // which go to the map on one side and come out of it on the other. When
+    // the touch leaves the middle half of the band, maintain() re-centres
+    // the band on it, kRebaseLevelsPerStep levels per operation at most, so
+    // a rebase is spread across commands instead of landing on one.
     class SideIndex {
     public:
+        // No ladder yet: see materialise().
         SideIndex(Side side, std::uint32_t band_ticks, std::pmr::memory_resource* resource);
 
         [[nodiscard]] bool empty() const { return summary_ == 0 && overflow_.empty(); }
 
+        // What the LadderBudget is charged for a band of this width.
+        [[nodiscard]] static std::size_t ladder_bytes(std::uint32_t band_ticks) {
+            return static_cast<std::size_t>(band_ticks) * sizeof(LevelSlot);
+        }
+
+        // The ladder's lifecycle. materialise() allocates one `band_ticks`
+        // wide and, if the side already has levels, centres it on the best
+        // one and moves in every level it covers; release() moves every
+        // laddered level into the map and frees the arrays. Both move
+        // level_count() levels at most. preferred_band() is what the side
+        // would like next time -- it doubles when a rebase finds levels
+        // already spilled -- and reset_preferred_band() puts it back.
+        [[nodiscard]] bool has_ladder() const { return ladder_ != nullptr; }
+        [[nodiscard]] std::uint32_t band_ticks() const { return band_ticks_; }
+        [[nodiscard]] std::uint32_t preferred_band() const { return preferred_band_; }
+        void reset_preferred_band() { preferred_band_ = initial_band_; }
+        [[nodiscard]] std::size_t level_count() const { return laddered_levels_ + overflow_.size(); }
+        void materialise(std::uint32_t band_ticks);
+        void release();
+
         // Creates the level if this price has none. The reference is stable
         // until the next insert on this side.
         [[nodiscard]] LevelSlot& level_for(Price price);
@@ -216,6 +518,14 @@ private:
 
         [[nodiscard]] std::size_t overflow_levels() const { return overflow_.size(); }
 
+        // Called after every change to this side, with the price it touched.
+        // Starts a re-centering if the touch has left the middle half of the
+        // band, and advances one already under way by a bounded step. Moves
+        // ladder levels, so no LevelSlot reference survives it.
+        void maintain(Price touched);
+
+        [[nodiscard]] const LadderRebaseCounters& rebase_counters() const { return rebase_counters_; }
+
     private:
         // The bitmap has three levels: one bit per tick at the bottom, one
         // bit per bottom word in the middle, and one bit per middle word in
@@ -223,6 +533,10 @@ private:
         // kMaxBandTicks.
         [[nodiscard]] static constexpr std::size_t words_for(std::uint32_t ticks) { return (ticks + 63U) / 64U; }
 
+        // Two coordinates for a ladder position. A tick is a price's offset
+        // from the base, so tick order is price order; a slot is where that
+        // price lives in the ring, and does not change when the base does.
+        // The band is a power of two, so a slot is the price's low bits.
         [[nodiscard]] bool in_band(Price price) const {
             // Unsigned wrap makes one comparison do both bounds: a price
             // below the base becomes a very large offset.
@@ -232,22 +546,64 @@ private:
             return static_cast<std::uint32_t>(price - base_);
         }
         [[nodiscard]] Price price_of(std::uint32_t tick) const { return base_ + static_cast<Price>(tick); }
+        [[nodiscard]] std::uint32_t slot_of(Price price) const {
+            return static_cast<std::uint32_t>(static_cast<std::uint64_t>(price) & (band_ticks_ - 1U));
+        }
+        [[nodiscard]] std::uint32_t tick_of_slot(std::uint32_t slot) const {
+            return (slot - slot_of(base_)) & (band_ticks_ - 1U);
+        }
+        // Inside the middle half of the band: far enough from both edges
+        // that the ladder has room to follow the touch either way.
+        [[nodiscard]] bool centred(Price price) const {
+            return in_band(price) && tick_of(price) - band_ticks_ / 4U < band_ticks_ / 2U;
+        }
 
         void anchor(Price price);
-        void set_occupied(std::uint32_t tick);
-        void clear_occupied(std::uint32_t tick);
-        [[nodiscard]] bool is_occupied(std::uint32_t tick) const;
-        // Both return band_ticks_ when there is none, so callers test
-        // against the band rather than against a sentinel.
+
+        // The bitmap, by slot.
+        void set_occupied(std::uint32_t slot);
+        void clear_occupied(std::uint32_t slot);
+        [[nodiscard]] bool is_occupied(std::uint32_t slot) const;
+        [[nodiscard]] std::uint32_t highest_set() const;
+        [[nodiscard]] std::uint32_t lowest_set() const;
+        [[nodiscard]] std::uint32_t highest_set_below(std::uint32_t slot) const;
+        [[nodiscard]] std::uint32_t lowest_set_above(std::uint32_t slot) const;
+
+        // The same searches by tick, which is what price order needs: the
+        // ring wraps at the base's slot, so each is at most two of the slot
+        // searches above. All of these return band_ticks_ when there is
+        // none, so callers test against the band rather than against a
+        // sentinel.
         [[nodiscard]] std::uint32_t highest_occupied() const;
         [[nodiscard]] std::uint32_t lowest_occupied() const;
         [[nodiscard]] std::uint32_t highest_occupied_below(std::uint32_t tick) const;
         [[nodiscard]] std::uint32_t lowest_occupied_above(std::uint32_t tick) const;
 
+        // Re-centering. Each step slides the base towards rebase_target_ one
+        // migration at a time: the base jumps straight over ticks where
+        // nothing crosses an edge, so a step costs what it moves, not how
+        // far it goes.
+        void rebase_step();
+        // Both return how many levels they moved.
+        [[nodiscard]] std::uint32_t slide_up();
+        [[nodiscard]] std::uint32_t slide_down();
+        // Moves a ladder level into the map, and a map level into the
+        // ladder. Both expect the caller to have just made it true that the
+        // price is out of band, or in it.
+        void evict(Price price);
+        void admit(std::pmr::map<Price, LevelSlot>::iterator level);
+
         Side side_;
-        std::uint32_t band_ticks_;
+        // Zero until materialise() and again after release().
+        std::uint32_t band_ticks_ = 0;
+        std::uint32_t initial_band_;
+        std::uint32_t preferred_band_;
+        std::uint32_t laddered_levels_ = 0;
         Price base_ = 0;
         bool anchored_ = false;
+        bool rebasing_ = false;
+        Price rebase_target_ = 0;
+        LadderRebaseCounters rebase_counters_;
 
         std::unique_ptr<LevelSlot[]> ladder_;
         std::vector<std::uint64_t> occupancy_;
@@ -267,14 +623,45 @@ private:
     // Leaves `level` with head == kNil if `slot` was its last order, which
     // is how callers decide whether to erase the level.
     void unlink(LevelSlot& level, std::uint32_t slot);
+    // Sets one resting order's remaining quantity and moves its level's
+    // total by the same amount.
+    void adjust_quantity(LevelSlot& level, std::uint32_t slot, Quantity new_remaining_quantity);
+    // Appends the order in `slot` to its account's chain, opening a chain
+    // for an account new to this book, and takes it off again.
+    void link_account(std::uint32_t slot, AccountId account_id);
+    void unlink_account(std::uint32_t slot);
+    // Moves digest_ from the order in `slot` to the same order holding
+    // `new_remaining_quantity`. Called before the quantity itself changes.
+    void rehash_quantity(std::uint32_t slot, Quantity new_remaining_quantity);
 
     [[nodiscard]] SideIndex& side_of(Side side) { return side == Side::Buy ? bids_ : asks_; }
     [[nodiscard]] const SideIndex& side_of(Side side) const { return side == Side::Buy ? bids_ : asks_; }
 
     [[nodiscard]] std::vector<BookOrder> all_of(Side side) const;
-
-    std::vector<SlabOrder> slab_;
-    // Freed slots, threaded through SlabOrder::next. A book that cancels as
+    [[nodiscard]] BookOrder assemble(std::uint32_t slot) const;
+
+    // Gives `side` a ladder, as wide as it would like if the budget has
+    // room and as wide as the budget can spare if not; and re-allocates an
+    // existing one at the width the side now wants, if the budget covers the
+    // difference. Both charge and credit budget_ when there is one.
+    void materialise(SideIndex& side);
+    void widen(SideIndex& side);
+    void release(SideIndex& side);
+
+    // Indexed by the same slot, always the same length.
+    std::vector<HotOrder> hot_;
+    std::vector<ColdOrder> cold_;
+    std::vector<AccountLink> account_links_;
+    // Chains by index, and the one lookup that finds an account's. A chain
+    // stays when its account's last order leaves, empty, so removing an
+    // order never has to touch the map; there is one per account that has
+    // ever rested here.
+    std::vector<AccountChain> account_chains_;
+    std::unordered_map<AccountId, std::uint32_t> chain_of_account_;
+    // Accounts whose chain opened since take_new_accounts() last emptied
+    // this, in the order they opened.
+    std::vector<AccountId> new_accounts_;
+    // Freed slots, threaded through HotOrder::next. A book that cancels as
     // fast as it rests reuses a bounded set of slots forever instead of
     // growing the slab, and reuse is last-in-first-out, so the slot handed
     // out is the one most recently touched and most likely still cached.
@@ -288,6 +675,10 @@ private:
     // at a fixed address, so the resource pointers inside the containers
     // survive a move of the book.
     std::unique_ptr<std::pmr::unsynchronized_pool_resource> pool_;
+    LadderBudget* budget_;
+    std::uint64_t version_ = 0;
+    std::uint64_t digest_ = 0;
+    TradingPhase phase_ = TradingPhase::Continuous;
     SideIndex bids_;
     SideIndex asks_;
 };
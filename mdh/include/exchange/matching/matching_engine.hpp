@@ -1,21 +1,27 @@
 #pragma once
 
+#include <algorithm>
+#include <concepts>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <initializer_list>
 #include <memory>
-#include <memory_resource>
 #include <span>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "common/timer_wheel.hpp"
 #include "common/types.hpp"
 #include "exchange/core/commands.hpp"
+#include "exchange/core/event_buffer.hpp"
 #include "exchange/core/event_sink.hpp"
+#include "exchange/matching/live_order_table.hpp"
 #include "exchange/matching/matching_book.hpp"
 #include "exchange/matching/resting_order.hpp"
+#include "exchange/matching/state_digest.hpp"
 #include "exchange/matching/state_snapshot.hpp"
 
 // The exchange's authoritative matching engine: a command goes in, zero or
@@ -24,10 +30,45 @@
 //
 // Single-threaded and deterministic. Every decision depends only on the
 // command's own fields and the current book state -- never on the clock,
-// thread scheduling, or randomness. It touches no sockets, files or logs,
+// thread scheduling, or randomness. What time it is arrives as a command
+// (ClockTickCommand) like everything else. It touches no sockets, files or logs,
 // which is what makes it replayable and testable on its own.
 namespace mdh::exchange {
 
+// How a MatchingEngine numbers the exchange order ids it assigns: `first`,
+// then every `stride` after it. The default is 1, 2, 3, ..., which is
+// what a lone engine has always produced.
+//
+// It exists for the sharded pipeline, where several engines trade
+// disjoint instruments side by side. Shard k of n numbers from k + 1 in
+// steps of n, so ids stay unique across the whole exchange without a
+// shared counter -- and which id an order gets depends only on which
+// shard its instrument lives in, never on how the threads interleaved.
+struct ExchangeOrderIdSpace {
+    ExchangeOrderId first = 1;
+    ExchangeOrderId stride = 1;
+};
+
+// How a MatchingEngine spends memory on its books' tick ladders.
+//
+// `byte_budget` is shared by every book the engine owns. A book takes a
+// ladder out of it when one of its sides first gets an order, rather than
+// every book taking an equal share at registration -- so a universe of a
+// hundred thousand instruments, a few hundred of them active at a time,
+// costs what the active ones rest, and each of those can afford a band an
+// even split would never have given it. A book whose side keeps spilling
+// past its band asks for twice the band, and gets it if the budget has
+// room.
+//
+// `idle_commands` is how long a book may go without a command naming it
+// before its ladders are given back to the budget, counted in commands the
+// engine has processed rather than in time so that replay does exactly
+// what the live run did. Zero keeps every ladder once allocated.
+struct LadderPolicy {
+    std::size_t byte_budget = 24U << 20;
+    std::uint64_t idle_commands = 1U << 20;
+};
+
 // ── Replace policy ─────────────────────────────────────────────────────────
 // A quantity decrease at the same price keeps time priority: the resting
 // order is edited in place, keeping its exchange order id and its position
@@ -36,6 +77,122 @@ namespace mdh::exchange {
 // into a crossing price executes immediately like any other aggressive
 // order.
 //
+// ── Mass quotes ────────────────────────────────────────────────────────────
+// A MassQuoteCommand replaces the account's quote on one instrument, all of
+// it within the one command, so nothing else can trade against a ladder
+// that is half old and half new. Each new level is paired, if it can be,
+// with a standing level of the old quote on the same side at the same
+// price that has at least its quantity left; the pair is then exactly a
+// priority-preserving replace, and is reported as one (OrderReplaced and
+// BookOrderReduced). Old levels left unpaired are cancelled (OrderCancelled
+// and BookOrderRemoved). New levels left unpaired are entered as GTC limit
+// orders, by the same code a NewOrderCommand goes through, so one that
+// crosses trades at once. Cancels come first, then replaces, then new
+// orders: the old quote is off the book before the new one can cross it.
+//
+// A level that is malformed -- a bad price or quantity, or an id the
+// account already has live outside the old quote -- rejects the whole
+// quote, with an OrderRejected for every level and the old quote left
+// resting. A quote that replaced half its ladder and rejected the rest
+// would be worse than either.
+//
+// ── Mass cancels ───────────────────────────────────────────────────────────
+// A MassCancelCommand takes every matching order the account has resting
+// off the book within the one command, each reported as an ordinary cancel
+// would be (OrderCancelled and BookOrderRemoved), instrument by instrument
+// in ascending id order and oldest order first within each. Every book
+// chains each account's orders through its slab, so this walks the
+// account's own orders rather than searching for them, and costs nothing
+// per order the account does not have. Without an instrument it visits
+// only the books the account has ever rested an order in, which the engine
+// keeps per account, rather than every book it trades. Naming an
+// instrument the engine does not trade is rejected, under client order id
+// 0.
+//
+// The engine itself never splits one across commands, but the command can
+// ask it to stop after max_orders, and a sender that wants the matching
+// thread back between batches sends the rest as further commands. Each is
+// sequenced, journaled and replayed like any other command, so a sliced
+// mass cancel replays exactly as it ran. What slicing gives up is that it
+// is no longer one step: other commands are matched between the slices,
+// and trade against the orders the later ones have yet to take off. A
+// later slice that carries before_exchange_order_id passes over every order
+// entered after the id it names, so an order the account enters meanwhile
+// is not caught by it.
+//
+// ── Expiry ─────────────────────────────────────────────────────────────────
+// A GTD order rests exactly like a GTC one until the engine's clock reaches
+// its expire_at, and is then cancelled by the engine: OrderCancelled and
+// BookOrderRemoved, under the command sequence of the ClockTickCommand that
+// got there, earliest expiry first (to the millisecond; see kExpiryTick).
+// The clock is whatever the last ClockTickCommand said, zero before the
+// first, and never moves backwards. A GTD order whose expiry the clock has
+// already reached is rejected with InvalidExpiry, as is an expiry on any
+// other time in force.
+//
+// Expiries are kept on a timer wheel, keyed by exchange order id, and only
+// GTD orders have one. Every path that takes a GTD order off the book --
+// fill, cancel, replace, mass cancel -- disarms its timer there and then,
+// so a timer that fires always names an order that is still resting. A
+// priority-losing replace re-enters the order under its old expiry; one
+// that keeps priority keeps its timer, since the order does not move.
+//
+// ── Stop orders ────────────────────────────────────────────────────────────
+// A StopLimit order is accepted (OrderAccepted, as for any order) but not
+// put on the book: it waits, unseen by the market, until a trade on its
+// instrument prints at its stop price or through it -- at or above for a
+// buy stop, at or below for a sell stop. It is then entered exactly as a
+// GTC limit order at its own price would be, under the command sequence of
+// the command whose trade released it, so it can trade at once and rest
+// what is left (TradeExecuted, BookOrderAdded); there is no separate
+// report of the release itself. Stops must be GTC, and one that the last
+// trade on its instrument has already triggered is rejected with
+// InvalidStopPrice rather than released on arrival.
+//
+// Releases happen at the end of the command whose trades caused them, so a
+// mass quote is never interleaved with the stops it sets off. Every price
+// the command traded at counts, not only the last: a sweep through five
+// levels releases a stop at the second. Buy stops go first, lowest stop
+// price first, then sell stops, highest first, in arrival order within a
+// price, and the trades each released stop makes can release more, in the
+// same command, until none is left that the command's trades reached.
+//
+// Each book's pending stops sit in a MatchingBook of their own, filed under
+// the side whose priority order is the order they trigger in: buy stops on
+// its asks (lowest stop price first), sell stops on its bids (highest
+// first). So finding the stops a trade released is the same tick ladder and
+// occupancy bitmap that finds the best price, and costs the stop prices
+// crossed, not the stops pending. A pending stop can be cancelled and mass
+// cancelled -- OrderCancelled alone, since it was never on the book -- but
+// not replaced (InvalidReplacement). Its client order id is as taken as a
+// resting order's, and costs the same single directory probe to check.
+//
+// ── Call auctions ──────────────────────────────────────────────────────────
+// A TradingPhaseCommand puts one book into a call, or takes it out of one.
+// During a call nothing matches on that book: orders are accepted, rest
+// where their price puts them -- the book may cross -- and can be cancelled
+// and replaced, all as usual, but no order trades on arrival. IOC and FOK
+// orders need a trade on arrival to mean anything, so they are rejected with
+// InvalidDuringCall rather than accepted and discarded.
+//
+// Going back to continuous uncrosses the book within the same command. The
+// equilibrium price is the one at which the most quantity trades (see
+// MatchingBook::equilibrium() for the tie-breaks), reference price being the
+// book's last trade; every matched order trades at it, bids from the highest
+// down and asks from the lowest up, each in time priority within its price.
+// Each fill is an ordinary TradeExecuted and BookOrderRemoved or
+// BookOrderReduced, under the phase command's sequence. There is no aggressor
+// in an auction: aggressor_side names the side left with quantity over, Buy
+// when neither is. The uncross counts as the book's trades for stop orders,
+// which are released at the end of the same command, into a continuous book.
+//
+// The phase itself is not announced with an event -- whoever sent the
+// command knows it -- but it is part of the book's state: it is in the
+// snapshot, so replay and an incremental snapshot both see it, and a book in
+// call is kept in the snapshot even with nothing resting. Naming an
+// instrument the engine does not trade is rejected under account and client
+// order id 0; naming the phase the book is already in does nothing.
+//
 // ── Self-trade policy ──────────────────────────────────────────────────────
 // Not implemented. Two orders from the same account match each other
 // normally, and TradeExecuted reports both accounts as-is.
@@ -51,8 +208,9 @@ public:
     // at a million resting orders, one insert costs 81 ns against a
     // directory sized up front and 1814 ns against one growing into itself;
     // the slab shows the same effect at 47 ns against 104. Guessing high
-    // costs 8 bytes per unused directory slot and 56 per unused slab entry,
-    // so it is much the cheaper direction to be wrong in.
+    // costs about 47 bytes per unused directory entry -- the table is flat,
+    // so an entry's room is reserved whole -- and 68 per unused slab entry,
+    // so it is still the cheaper direction to be wrong in.
     //
     // The default suits a test or a small book. Anything carrying real order
     // flow should say what it expects.
@@ -65,16 +223,26 @@ public:
     // capacity one.
     static constexpr InstrumentId kMaxInstrumentId = (1U << 22) - 1;
 
-    // What the whole engine may spend on tick ladders, split evenly across
-    // the universe. Each book indexes a band of prices with a flat array and
-    // falls back to a map outside it, so this decides how wide that band is
-    // -- and, for a universe large enough that its share stops being worth
-    // the fixed cost, whether there is a ladder at all.
+    // What the whole engine may spend on tick ladders by default. Each book
+    // indexes a band of prices with a flat array and falls back to a map
+    // outside it, so this decides how wide those bands are -- and, once it
+    // is spent, which books get one at all.
     //
-    // 8 MB buys the full band for 64 instruments. It is a budget rather than
-    // a per-book size because the cost is instruments x band x 2 sides, and
-    // the instrument count is the part a single book cannot know.
-    static constexpr std::size_t kLadderByteBudget = 8U << 20;
+    // 24 MB buys the full band for 64 instruments all active at once. It is
+    // a budget rather than a per-book size because the cost is active
+    // instruments x band x 2 sides, and how many are active is the part a
+    // single book cannot know. It tripled when a ladder level grew to carry
+    // its own totals, which left every universe size with the band it had
+    // before.
+    static constexpr std::size_t kLadderByteBudget = LadderPolicy{}.byte_budget;
+
+    // The expiry wheel's resolution, in nanoseconds. A GTD order is
+    // cancelled by the first ClockTickCommand at or after its expire_at
+    // rounded up to this, so at most a millisecond late and never early --
+    // finer than any session boundary a day order is set to, and coarse
+    // enough that a day's worth of ticks crosses the wheel's top level
+    // only a handful of times.
+    static constexpr Timestamp kExpiryTick = 1'000'000;
 
     // `universe` is every instrument this engine will trade. A command
     // naming anything else is rejected with InvalidInstrument rather than
@@ -87,9 +255,11 @@ public:
     // Nothing is thrown: an instrument that fails to register simply stays
     // unknown, and its commands are rejected the ordinary, visible way.
     explicit MatchingEngine(std::span<const InstrumentId> universe,
-                            std::size_t expected_resting_orders = kDefaultExpectedRestingOrders);
+                            std::size_t expected_resting_orders = kDefaultExpectedRestingOrders,
+                            ExchangeOrderIdSpace id_space = {}, LadderPolicy ladders = {});
     explicit MatchingEngine(std::initializer_list<InstrumentId> universe,
-                            std::size_t expected_resting_orders = kDefaultExpectedRestingOrders);
+                            std::size_t expected_resting_orders = kDefaultExpectedRestingOrders,
+                            ExchangeOrderIdSpace id_space = {}, LadderPolicy ladders = {});
 
     // Adds one instrument after construction. Replay needs this: it learns
     // the universe from the journal's own RegisterInstrument frames as it
@@ -110,12 +280,17 @@ public:
 
     [[nodiscard]] std::size_t instrument_count() const { return books_.size(); }
 
-    // How wide a band each book registered from here on indexes with a
-    // ladder, in ticks; zero when the universe is too large for one to be
-    // worth its fixed cost. Exposed so a benchmark can report which
-    // structure it actually measured.
+    // How wide a band a book registered from here on asks for when its
+    // first order arrives, in ticks: its even share of the budget, but never
+    // less than MatchingBook::kMinBandTicks, since a book that is active
+    // while most are idle can afford more than its share. What it actually
+    // gets depends on the budget at the time. Exposed so a benchmark can
+    // report which structure it actually measured.
     [[nodiscard]] std::uint32_t ladder_band_ticks() const { return band_ticks_; }
 
+    // The ladder memory in use and how it got there: see LadderBudget.
+    [[nodiscard]] const LadderBudget& ladder_budget() const { return *ladder_budget_; }
+
     // Resting price levels that fell outside their book's band and are held
     // by the fallback map instead, summed across instruments. The ladder is
     // built for this to be zero; a number that tracks the level count means
@@ -123,8 +298,41 @@ public:
     // off a benchmark rather than inferring from a latency.
     [[nodiscard]] std::size_t out_of_band_levels() const;
 
+    // How often the books' ladders have re-centred to follow a moving
+    // touch, summed across instruments. A count that climbs with every few
+    // thousand commands on a flat market means the band is too narrow for
+    // how far the book actually spreads.
+    [[nodiscard]] LadderRebaseCounters ladder_rebase_counters() const;
+
+    // Aggregated depth of one side of one instrument's book, best level
+    // first, into `out`; see MatchingBook::depth(). Zero for an instrument
+    // this engine does not trade, as for an empty side.
+    std::size_t aggregated_depth(InstrumentId instrument_id, Side book_side, std::span<LevelDepth> out) const;
+
     void process(const ExchangeCommand& command, const EventSink& sink);
 
+    // The same, with the sink's type known at compile time, so the call to
+    // it inlines into the matching loop instead of going through
+    // std::function once per event. EventSink itself is excluded and takes
+    // the overload above, whose body is compiled once in the .cpp.
+    template <ExchangeEventSink Sink>
+        requires(!std::same_as<std::remove_cvref_t<Sink>, EventSink>)
+    void process(const ExchangeCommand& command, Sink&& sink) {
+        process_command(command, sink);
+    }
+
+    // The same matching, for a run of commands at once, with every event
+    // appended to `out` rather than handed to a sink -- and end_command()
+    // called after each command, so out.events_of(i) is what commands[i]
+    // produced. `out` is appended to, not cleared; reusing one buffer and
+    // clearing it between batches is what keeps this allocation-free.
+    //
+    // The events, their order and their sequence numbers are exactly what
+    // process() would have emitted for the same commands one by one. Only
+    // the delivery differs: nothing is called per event, so the cost of a
+    // sweep is the matching itself.
+    void process_batch(std::span<const ExchangeCommand> commands, EventBuffer& out);
+
     // Emits an OrderRejected for `command` using this engine's own
     // event-sequence counter, touching no book state. It exists for
     // rejections decided before a command ever reaches process() -- the
@@ -132,67 +340,96 @@ public:
     // increasing across everything this engine emits, wherever the rejection
     // was decided. It does not decide *whether* to reject; that is the
     // caller's business.
-    void reject_new_order(const NewOrderCommand& command, RejectReason reason, const EventSink& sink);
+    template <ExchangeEventSink Sink>
+    void reject_new_order(const NewOrderCommand& command, RejectReason reason, Sink&& sink);
 
     // The same, for a replace rejected before process_replace() runs.
     // Reported under original_client_order_id, as every replace rejection
     // is. The resting order and its ledger hold are left alone, so the
     // caller must not also call process() for this command.
-    void reject_replace_order(const ReplaceOrderCommand& command, RejectReason reason, const EventSink& sink);
+    template <ExchangeEventSink Sink>
+    void reject_replace_order(const ReplaceOrderCommand& command, RejectReason reason, Sink&& sink);
+
+    // The same, for a mass quote: an OrderRejected under every level's own
+    // client order id, or one under id 0 if the quote has none, since a
+    // rejection nobody is told about is not one. The quote the account
+    // already has stays as it was.
+    template <ExchangeEventSink Sink>
+    void reject_mass_quote(const MassQuoteCommand& command, RejectReason reason, Sink&& sink);
+
+    // The levels `account_id` is quoting on `instrument_id`, by client order
+    // id, into `out`, returning how many were written: what its last mass
+    // quote there left resting that has not since been cancelled, replaced
+    // or filled. The pre-trade check reads this to credit the holds a new
+    // quote will release. An `out` of kMaxQuoteEntries is always enough.
+    std::size_t live_quotes(AccountId account_id, InstrumentId instrument_id, std::span<ClientOrderId> out) const;
 
     // A canonical dump of every resting order across every instrument, in a
     // fixed order, so two independently-built engines can be compared with
     // == (see state_snapshot.hpp). Instruments come out in ascending id
     // order, and registered instruments with nothing resting are left out --
     // so two engines with different universes still compare equal when the
-    // same orders rest on both.
+    // same orders rest on both. A book in a call is kept regardless.
     [[nodiscard]] EngineStateSnapshot snapshot() const;
 
-private:
-    static constexpr std::uint32_t kNoSlot = ~0U;
-
-    // Everything the engine knows about a live resting order that the book
-    // does not: which book it is in, where in that book, and the two fields
-    // only a snapshot reads.
+    // The incremental form: every book whose orders changed since the
+    // previous call, or since construction for the first, copied out the way
+    // snapshot() would copy it -- and nothing else. Applied in order with
+    // apply_changes(), a run of these rebuilds snapshot() exactly.
     //
-    // This is the one per-order directory. It replaced a pair of tables --
-    // this one plus a per-book index keyed by exchange order id -- whose
-    // lookups ran strictly one after the other, so every cancel and replace
-    // paid both cache misses and every resting order carried two hash nodes
-    // that grew and rehashed independently.
+    // What it costs the calling thread is the changed books, not the
+    // engine: the engine keeps a list of them as it goes, one compare per
+    // command, so a quiet book is never even looked at. A busy book is still
+    // copied whole, however little of it moved. Meant to be called on the
+    // matching thread between commands -- the one point at which every book
+    // is consistent -- with the expensive part, turning the result into
+    // bytes, left to another thread (see persistence::BackgroundSnapshotter).
+    [[nodiscard]] EngineStateChanges snapshot_changes();
+
+    // Whether snapshot_changes() would report any book.
+    [[nodiscard]] bool has_snapshot_changes() const { return !dirty_books_.empty(); }
+
+    // A 64-bit fingerprint of every book's resting orders, current as of
+    // the last command processed: each book's MatchingBook::state_digest()
+    // weighted by its instrument and summed (see state_digest.hpp). It is
+    // kept up to date as commands run, at one compare per command, so
+    // reading it costs nothing -- unlike hash_state_snapshot(), which builds
+    // and serialises a full snapshot first. Two engines that processed the
+    // same commands return the same value after the same number of them,
+    // which is what lets a primary and a replica check each other every few
+    // commands rather than once at the end.
     //
-    // Fields are widest-first on purpose, for the reason given on
-    // ExchangeRestingOrder: grouped by meaning instead, this would pad to 32
-    // bytes. At 24 it makes a 56-byte hash node -- pointer, cached hash,
-    // key, value -- which fits the pool's 64-byte block, the same
-    // constraint BookOrder is under.
-    struct OrderRef {
-        Quantity original_quantity;
-        std::uint64_t order_sequence;
-        MatchingBook::Handle handle;
-        InstrumentId instrument_id;
-    };
+    // It covers what the books hold. The two snapshot-only fields kept in
+    // the directory -- original_quantity and order_sequence -- are left out:
+    // neither decides anything, and both follow from the same commands that
+    // fixed the fields it does cover. GTD expiries are left out on the same
+    // grounds: an order's expiry is fixed by the command that entered it.
+    // Pending stops are left out too: they are not on any book until
+    // released, and a release changes the book. persistence::rolling_state_hash()
+    // computes the same value from a snapshot.
+    [[nodiscard]] std::uint64_t state_hash() const { return state_hash_; }
+
+    // Commands process() and process_batch() have been given, rejected ones
+    // included: the position in the command stream state_hash() describes.
+    [[nodiscard]] std::uint64_t commands_processed() const { return commands_seen_; }
+
+    // The engine's clock: the `now` of the latest ClockTickCommand that moved
+    // it, zero if none has.
+    [[nodiscard]] Timestamp clock() const { return clock_; }
+
+    // GTD orders resting with an expiry still to come.
+    [[nodiscard]] std::size_t pending_expiries() const { return expiries_.size(); }
+
+    // Stop orders accepted and not yet released, cancelled or rejected.
+    [[nodiscard]] std::size_t pending_stops() const { return stop_limit_prices_.size(); }
+
+    // The exchange order id the next order entered will be given. Every
+    // order entered so far has a lower one, which is what a sliced mass
+    // cancel's later commands carry as MassCancelCommand::before_exchange_order_id.
+    [[nodiscard]] ExchangeOrderId next_exchange_order_id() const { return next_exchange_order_id_; }
 
-    static_assert(sizeof(OrderRef) == 24, "see the note above on what this size is protecting");
-
-    // A client order id is only unique within an account -- two accounts may
-    // both pick id 1 -- so live orders are keyed on the pair. The key is
-    // global rather than per-instrument, which is what makes an id already
-    // live on another instrument count as a duplicate.
-    struct LiveKey {
-        AccountId account_id;
-        ClientOrderId client_order_id;
-
-        bool operator==(const LiveKey& other) const {
-            return account_id == other.account_id && client_order_id == other.client_order_id;
-        }
-    };
-
-    struct LiveKeyHash {
-        std::size_t operator()(const LiveKey& key) const noexcept {
-            return std::hash<AccountId>{}(key.account_id) ^ (std::hash<ClientOrderId>{}(key.client_order_id) << 1);
-        }
-    };
+private:
+    static constexpr std::uint32_t kNoSlot = ~0U;
 
     // Both assume the instrument is registered. Every caller has already
     // been through knows_instrument(), which is the check that turns an
@@ -204,13 +441,159 @@ private:
 
     // Rebuilds a full resting order for the snapshot: the book holds the
     // order, orders_ holds the fields the book gave up, and the caller
-    // supplies the instrument. One hash lookup per order, on a path that
+    // supplies the instrument. One table lookup per order, on a path that
     // already copies the whole book.
     [[nodiscard]] ExchangeRestingOrder compose(const BookOrder& order, InstrumentId instrument_id) const;
 
-    void process_new_order(const NewOrderCommand& cmd, const EventSink& sink);
-    void process_cancel(const CancelOrderCommand& cmd, const EventSink& sink);
-    void process_replace(const ReplaceOrderCommand& cmd, const EventSink& sink);
+    // One book as snapshot() reports it, by slot. Both sides and its stops
+    // empty if nothing rests or waits there.
+    [[nodiscard]] InstrumentBookSnapshot snapshot_book(std::uint32_t slot) const;
+
+    // What snapshot_changes() compares to tell whether a book moved: its own
+    // version plus its stop book's, both of which only ever go up, so the
+    // sum moves whenever either does.
+    [[nodiscard]] std::uint64_t book_version(std::uint32_t slot) const {
+        const MatchingBook* stops = stop_books_[slot].get();
+        return books_[slot].version() + (stops != nullptr ? stops->version() : 0);
+    }
+
+    // Everything below that emits is a template over its sink, so that every
+    // entry point shares one body of matching code while each gets a direct
+    // call to its own kind of output. Defined in matching_engine_process.hpp.
+    template <class Sink>
+    void process_command(const ExchangeCommand& command, Sink& sink);
+
+    // Per-command bookkeeping on the book a command named. A book whose
+    // version has moved since snapshot_changes() last copied it joins
+    // dirty_books_, once. A book whose digest has moved since the last
+    // command that named it moves state_hash_ by the difference, weighted:
+    // every command but a mass cancel changes only the one book it names,
+    // so this sees every change, and a mass cancel calls note_book() for
+    // each book it touched instead.
+    //
+    // Idle-ladder reclaim, a step of it per command. Each command stamps
+    // the book it named, and a book that has come out of it holding a
+    // ladder joins laddered_books_; then one entry of that list -- the next
+    // in a round-robin -- is checked against LadderPolicy::idle_commands.
+    // The round-robin is over books with a ladder rather than over the
+    // universe, so how late a reclaim can be is bounded by how many ladders
+    // the budget holds, not by how many instruments there are, and the
+    // command path pays a compare instead of a scan.
+    void note_activity(InstrumentId instrument_id) {
+        ++commands_seen_;
+        if (knows_instrument(instrument_id)) {
+            note_book(slot_of_id_[instrument_id]);
+        }
+    }
+    //
+    // It is also where books_of_account_ learns of an account's first order
+    // on a book: every order that rests does so under a command that names
+    // its book, or in a stop release that notes the book after it.
+    void note_book(std::uint32_t slot) {
+        BookActivity& activity = activity_[slot];
+        activity.last_command = commands_seen_;
+        const MatchingBook& book = books_[slot];
+        if (const MatchingBook* stops = stop_books_[slot].get();
+            book.has_new_accounts() || (stops != nullptr && stops->has_new_accounts())) {
+            index_new_accounts(slot);
+        }
+        if (!activity.tracked && book.has_ladder()) {
+            activity.tracked = true;
+            laddered_books_.push_back(slot);
+        }
+        if (!activity.dirty && book_version(slot) != activity.snapshot_version) {
+            activity.dirty = true;
+            dirty_books_.push_back(slot);
+        }
+        const std::uint64_t digest = book.state_digest();
+        state_hash_ += instrument_weight(activity.instrument_id) * (digest - activity.digest);
+        activity.digest = digest;
+    }
+    void reclaim_idle_ladder() {
+        if (ladder_policy_.idle_commands == 0 || laddered_books_.empty()) {
+            return;
+        }
+        if (++reclaim_cursor_ >= laddered_books_.size()) {
+            reclaim_cursor_ = 0;
+        }
+        const std::uint32_t slot = laddered_books_[reclaim_cursor_];
+        if (commands_seen_ - activity_[slot].last_command < ladder_policy_.idle_commands) {
+            return;
+        }
+        MatchingBook& book = books_[slot];
+        book.release_ladders();
+        // A side too deep to move at once keeps its ladder, and its book
+        // stays on the list to be tried again next time round.
+        if (!book.has_ladder()) {
+            activity_[slot].tracked = false;
+            laddered_books_[reclaim_cursor_] = laddered_books_.back();
+            laddered_books_.pop_back();
+        }
+    }
+
+    template <class Sink>
+    void process_new_order(const NewOrderCommand& cmd, Sink& sink);
+    template <class Sink>
+    void process_cancel(const CancelOrderCommand& cmd, Sink& sink);
+    template <class Sink>
+    void process_replace(const ReplaceOrderCommand& cmd, Sink& sink);
+    template <class Sink>
+    void process_mass_quote(const MassQuoteCommand& cmd, Sink& sink);
+    // Does its own per-command bookkeeping, since it may touch many books.
+    template <class Sink>
+    void process_mass_cancel(const MassCancelCommand& cmd, Sink& sink);
+    // One book's part of a mass cancel: at most `left` orders, which it
+    // reduces by however many it cancelled.
+    template <class Sink>
+    void mass_cancel_book(const MassCancelCommand& cmd, InstrumentId instrument_id, std::uint32_t slot,
+                          std::size_t& left, Sink& sink);
+    // Files each account new to the book at `slot`, or to its stop book,
+    // under that book in books_of_account_.
+    void index_new_accounts(std::uint32_t slot);
+    // Moves the clock and cancels every GTD order it has reached. Does its
+    // own per-command bookkeeping, like a mass cancel, for the same reason.
+    template <class Sink>
+    void process_clock_tick(const ClockTickCommand& cmd, Sink& sink);
+    // Moves one book between continuous trading and a call, uncrossing it
+    // on the way out of the call.
+    template <class Sink>
+    void process_trading_phase(const TradingPhaseCommand& cmd, Sink& sink);
+    // Trades a crossed book down to uncrossed at its equilibrium price, in
+    // one batch: the fronts of both sides, in priority order, until the
+    // equilibrium volume has traded.
+    template <class Sink>
+    void uncross(InstrumentId instrument_id, CommandSequence command_sequence, Sink& sink);
+    // reject_mass_quote()'s body, for the engine's own rejections: the
+    // public one's ExchangeEventSink constraint would be checked against
+    // every internal sink, and process_batch()'s cannot take a whole
+    // ExchangeEvent.
+    template <class Sink>
+    void reject_quote(const MassQuoteCommand& cmd, RejectReason reason, Sink& sink);
+
+    // Everything a new order does once it has passed validation: takes the
+    // next exchange order id and priority, announces OrderAccepted, matches,
+    // and rests what is left. Shared by process_new_order() and the new
+    // levels of a mass quote, which are new orders in every respect but how
+    // they arrived.
+    template <class Sink>
+    void accept_and_match(const NewOrderCommand& cmd, Sink& sink);
+    // The first of those steps on its own -- an id, a priority and
+    // OrderAccepted -- returning the order as it stands before matching.
+    template <class Sink>
+    ExchangeRestingOrder accept(const NewOrderCommand& cmd, Sink& sink);
+    // A validated StopLimit order: accepted, then filed in its book's stop
+    // book rather than matched.
+    template <class Sink>
+    void accept_stop(const NewOrderCommand& cmd, Sink& sink);
+    // Enters every stop the current command's trades reached, and every
+    // stop those entries' own trades reach, in the order the class comment
+    // gives. Called once per command, after the command itself.
+    template <class Sink>
+    void release_triggered_stops(Sink& sink);
+    // A cancel that found a pending stop: takes it out of the stop book and
+    // the directory, reporting OrderCancelled alone.
+    template <class Sink>
+    void cancel_pending_stop(const CancelOrderCommand& cmd, const OrderRef& ref, Sink& sink);
 
     // Matches `incoming` against the other side of its book in price-time
     // priority, one resting order at a time, emitting TradeExecuted and
@@ -218,12 +601,73 @@ private:
     // `incoming.remaining_quantity` in place. Never adds `incoming` to the
     // book itself -- what happens to any remainder is the caller's decision
     // (see rest_remainder_if_applicable).
-    void match_and_rest(ExchangeRestingOrder& incoming, CommandSequence command_sequence, const EventSink& sink);
-
-    // GTC: any remainder rests on the book and a BookOrderAdded is emitted.
+    template <class Sink>
+    void match_and_rest(ExchangeRestingOrder& incoming, CommandSequence command_sequence, Sink& sink);
+
+    // The resting side of one trade: `front`, a copy of the order at the
+    // front of its side of `book`, left with `remaining_after`. Removed
+    // with its directory entry and timer if that is nothing, reduced
+    // otherwise, and reported either way (BookOrderRemoved or
+    // BookOrderReduced). Shared by continuous matching and the uncross,
+    // which fill resting orders the same way.
+    template <class Sink>
+    void fill_front(MatchingBook& book, const BookOrder& front, Quantity remaining_after,
+                    InstrumentId instrument_id, Sink& sink);
+
+    // GTC/GTD: any remainder rests on the book and a BookOrderAdded is
+    // emitted; a GTD remainder also gets its timer, for `expire_at`.
     // IOC/FOK: any remainder is discarded silently -- it was never resting,
     // so there is nothing to cancel or announce.
-    void rest_remainder_if_applicable(const ExchangeRestingOrder& order, const EventSink& sink);
+    template <class Sink>
+    void rest_remainder_if_applicable(const ExchangeRestingOrder& order, Timestamp expire_at, Sink& sink);
+
+    // The expiry bookkeeping for one order leaving the book, whichever path
+    // it left by: nothing for anything but GTD, which has its timer
+    // cancelled. Returns the expiry it had, or zero.
+    Timestamp disarm_expiry(const BookOrder& order) {
+        if (order.time_in_force != TimeInForce::GTD) {
+            return 0;
+        }
+        const auto it = expiry_of_.find(order.exchange_order_id);
+        const Timestamp expire_at = expiries_.expires_at(it->second);
+        expiries_.cancel(it->second);
+        expiry_of_.erase(it);
+        return expire_at;
+    }
+
+    // Whether a stop order may be accepted as it stands: a positive stop
+    // price, GTC, and not already reached by the last trade on its book.
+    [[nodiscard]] bool valid_stop(const NewOrderCommand& cmd) const;
+
+    // Records that the current command traded on `instrument_id` between
+    // `low` and `high`, ending at `last`, so release_triggered_stops() knows
+    // how far it reached. A release is armed only if the range reaches the
+    // front of either side of the book's stop book, so a trade that
+    // releases nothing costs two looks at the stop book's best prices and
+    // nothing more, however many stops are waiting. Once armed, each further
+    // trade only widens the range.
+    void note_trades(InstrumentId instrument_id, Price low, Price high, Price last,
+                     CommandSequence command_sequence) {
+        const std::uint32_t slot = slot_of_id_[instrument_id];
+        activity_[slot].last_trade_price = last;
+        activity_[slot].has_traded = true;
+        if (triggers_.armed) {
+            triggers_.low = std::min(triggers_.low, low);
+            triggers_.high = std::max(triggers_.high, high);
+            return;
+        }
+        const MatchingBook* stops = stop_books_[slot].get();
+        if (stops == nullptr) {
+            return;
+        }
+        const std::optional<Price> lowest_buy_stop = stops->best_ask_price();
+        const std::optional<Price> highest_sell_stop = stops->best_bid_price();
+        if ((lowest_buy_stop.has_value() && *lowest_buy_stop <= high) ||
+            (highest_sell_stop.has_value() && *highest_sell_stop >= low)) {
+            triggers_ = TriggerRange{
+                .command_sequence = command_sequence, .low = low, .high = high, .slot = slot, .armed = true};
+        }
+    }
 
     // Sums the resting quantity that would immediately cross at `price` or
     // better, without touching the book. This is FOK's all-or-nothing
@@ -231,14 +675,6 @@ private:
     [[nodiscard]] Quantity crossable_quantity(InstrumentId instrument_id, Side incoming_side, Price price,
                                                Quantity quantity) const;
 
-    // orders_ holds one node per resting order -- the only one left outside
-    // the book's own slab -- so it draws from an engine-owned pool, for the
-    // same reason each book's containers draw from a book-owned one. The
-    // books themselves stay on the general heap: there is one per
-    // instrument, and that count does not grow with order flow. Declared
-    // first so it outlives them (see MatchingBook::pool_).
-    std::unique_ptr<std::pmr::unsynchronized_pool_resource> pool_;
-
     // The registry, in three parts. slot_of_id_ is a flat array rather than
     // a hash map because every command carries an instrument id, making this
     // the hottest lookup in the engine, and a bounds check plus an array
@@ -250,23 +686,136 @@ private:
     // a book registered later is sized like the ones that came with the
     // universe.
     std::size_t expected_orders_per_book_ = 0;
-    // Each book's share of kLadderByteBudget, as a band width. It only ever
+    // Each book's share of the ladder budget, as a band width. It only ever
     // narrows: an engine told its universe up front sizes this once and
     // gives every book the same band, while one learning its instruments as
     // it goes (replay) narrows the band for later books rather than
     // rebuilding the ones already made.
     std::uint32_t band_ticks_ = MatchingBook::kMaxBandTicks;
+    // Behind a pointer because every book holds its address, and that has
+    // to survive the engine being moved.
+    LadderPolicy ladder_policy_;
+    std::unique_ptr<LadderBudget> ladder_budget_;
+    // By slot, like books_: the value of commands_seen_ when a command last
+    // named the book, the book's version when snapshot_changes() last copied
+    // it, its digest as state_hash_ last counted it, whether it is in
+    // laddered_books_ and dirty_books_, and the price of its last trade,
+    // which is what a new stop order is checked against.
+    struct BookActivity {
+        std::uint64_t last_command = 0;
+        std::uint64_t snapshot_version = 0;
+        std::uint64_t digest = 0;
+        Price last_trade_price = 0;
+        InstrumentId instrument_id = 0;
+        bool tracked = false;
+        bool dirty = false;
+        bool has_traded = false;
+    };
+    std::vector<BookActivity> activity_;
+    std::vector<std::uint32_t> laddered_books_; // slots, in no order
+    std::vector<std::uint32_t> dirty_books_;    // slots, in no order
+    std::uint64_t snapshot_epoch_ = 0;
+    std::uint64_t state_hash_ = 0;
+    std::uint64_t commands_seen_ = 0;
+    std::size_t reclaim_cursor_ = 0;
     // Registration order is not id order, and snapshot() must emit
     // instruments by ascending id, so it walks this rather than sorting.
     std::vector<std::pair<InstrumentId, std::uint32_t>> by_id_;
+    // For each account, every book it has ever rested an order in (or a
+    // stop, in that book's stop book), as by_id_ entries in the same order.
+    // A mass cancel without an instrument walks this instead of by_id_, so
+    // its cost is the account's books and not the universe. Entries are
+    // never removed, as a book's account chains are not: an account that
+    // has left a book costs a mass cancel one empty chain lookup there.
+    std::unordered_map<AccountId, std::vector<std::pair<InstrumentId, std::uint32_t>>> books_of_account_;
+
+    // The live-order directory, one inline entry per resting order. It
+    // used to be the only per-order node outside the books' slabs, with an
+    // engine-owned pool to hold it; a flat table needs neither.
+    LiveOrderTable orders_;
+
+    // Mass-quote state: for each (account, instrument) that has quoted, the
+    // levels its last mass quote entered. A level is recorded by client
+    // order id and by the order_sequence of the order it became, and only
+    // counts while orders_ still has that id resting with that sequence --
+    // so a level cancelled, filled or replaced away drops out of the quote
+    // with nothing here having to hear about it, and an id the account has
+    // since reused for an ordinary order is not mistaken for a quote. A
+    // priority-preserving replace keeps the sequence, which is what lets a
+    // paired level stay in the quote under its new id.
+    struct QuoteKey {
+        AccountId account_id;
+        InstrumentId instrument_id;
 
-    std::pmr::unordered_map<LiveKey, OrderRef, LiveKeyHash> orders_;
+        bool operator==(const QuoteKey&) const = default;
+    };
+    struct QuoteKeyHash {
+        std::size_t operator()(const QuoteKey& key) const noexcept {
+            return static_cast<std::size_t>(state_digest_detail::mix(key.account_id ^
+                                                                     (std::uint64_t{key.instrument_id} << 40U)));
+        }
+    };
+    struct QuotedLevel {
+        ClientOrderId client_order_id;
+        std::uint64_t order_sequence;
+    };
+    std::unordered_map<QuoteKey, std::vector<QuotedLevel>, QuoteKeyHash> quotes_;
+
+    // The directory entry `level` became, if it is still resting on
+    // `key`'s instrument as that same order; null otherwise.
+    [[nodiscard]] const OrderRef* find_quoted(const QuoteKey& key, const QuotedLevel& level) const {
+        const OrderRef* ref = orders_.find(LiveKey{key.account_id, level.client_order_id});
+        if (ref == nullptr || ref->instrument_id != key.instrument_id || ref->order_sequence != level.order_sequence) {
+            return nullptr;
+        }
+        return ref;
+    }
+
+    // GTD expiry. Each pending timer names the book slot and handle of the
+    // order it will cancel; expiry_of_ finds the timer from the order, by
+    // the one id of it that neither a fill nor an in-place replace changes.
+    // A hash map rather than a field beside every resting order, since it
+    // is only GTD orders that pay for it.
+    struct ExpiryTimer {
+        std::uint32_t slot = 0;
+        MatchingBook::Handle handle{};
+    };
+    Timestamp clock_ = 0;
+    TimerWheel<ExpiryTimer> expiries_{kExpiryTick};
+    std::unordered_map<ExchangeOrderId, TimerWheel<ExpiryTimer>::TimerId> expiry_of_;
+
+    // Stop orders. stop_books_ is by slot, like books_, and null until the
+    // book's first stop: most books never see one, and a MatchingBook is a
+    // pool and two ladders' worth of bookkeeping. A stop book's ladder is the
+    // narrowest there is, outside the engine's ladder budget, and kept for
+    // the book's life -- stops cluster near the touch like orders do, and a
+    // stop price beyond the band still works, through the map. The book
+    // holds a stop under its stop price, on its filing side, and orders_
+    // holds its directory entry (see kPendingStop) like any live order's.
+    // What neither has room for is the limit price the stop will enter at,
+    // so that is kept here, by the id that never changes, and read only
+    // when the stop is released or snapshotted.
+    std::vector<std::unique_ptr<MatchingBook>> stop_books_;
+    std::unordered_map<ExchangeOrderId, Price> stop_limit_prices_;
+    // How far the current command's trades reached on the one book they
+    // were on. Commands trade on one book at most, so one range is enough.
+    struct TriggerRange {
+        CommandSequence command_sequence = 0;
+        Price low = 0;
+        Price high = 0;
+        std::uint32_t slot = 0;
+        bool armed = false;
+    };
+    TriggerRange triggers_;
 
     // Engine-owned counters -- no clock, no randomness, so a replay produces
     // the same numbers.
     ExchangeOrderId next_exchange_order_id_ = 1;
+    ExchangeOrderId exchange_order_id_stride_ = 1;
     EventSequence next_event_sequence_ = 1;
     std::uint64_t next_priority_ = 1;
 };
 
 } // namespace mdh::exchange
+
+#include "exchange/matching/matching_engine_process.hpp"
@@ -0,0 +1,1110 @@
+#pragma once
+
+// The half of MatchingEngine that emits events: every path from a command to
+// its events, templated on the sink that receives them.
+//
+// These are out of matching_engine.cpp because a template has to be visible
+// where it is instantiated, and the point of templating them is that each
+// caller's own sink type gets its own copy of the matching loop with the
+// sink call inlined into it (see event_sink.hpp). Include
+// matching_engine.hpp rather than this; it includes this at its end.
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <optional>
+#include <type_traits>
+#include <variant>
+
+#include "exchange/matching/matching_engine.hpp"
+
+namespace mdh::exchange {
+
+template <ExchangeEventSink Sink>
+void MatchingEngine::reject_new_order(const NewOrderCommand& command, RejectReason reason, Sink&& sink) {
+    sink(OrderRejected{
+        .event_sequence = next_event_sequence_++,
+        .command_sequence = command.command_sequence,
+        .account_id = command.account_id,
+        .client_order_id = command.client_order_id,
+        .instrument_id = command.instrument_id,
+        .reason = reason,
+    });
+}
+
+template <ExchangeEventSink Sink>
+void MatchingEngine::reject_replace_order(const ReplaceOrderCommand& command, RejectReason reason, Sink&& sink) {
+    sink(OrderRejected{
+        .event_sequence = next_event_sequence_++,
+        .command_sequence = command.command_sequence,
+        .account_id = command.account_id,
+        .client_order_id = command.original_client_order_id,
+        .instrument_id = command.instrument_id,
+        .reason = reason,
+    });
+}
+
+template <ExchangeEventSink Sink>
+void MatchingEngine::reject_mass_quote(const MassQuoteCommand& command, RejectReason reason, Sink&& sink) {
+    reject_quote(command, reason, sink);
+}
+
+template <class Sink>
+void MatchingEngine::reject_quote(const MassQuoteCommand& command, RejectReason reason, Sink& sink) {
+    if (command.entries.empty()) {
+        sink(OrderRejected{
+            .event_sequence = next_event_sequence_++,
+            .command_sequence = command.command_sequence,
+            .account_id = command.account_id,
+            .client_order_id = 0,
+            .instrument_id = command.instrument_id,
+            .reason = reason,
+        });
+        return;
+    }
+    for (const QuoteEntry& entry : command.entries) {
+        sink(OrderRejected{
+            .event_sequence = next_event_sequence_++,
+            .command_sequence = command.command_sequence,
+            .account_id = command.account_id,
+            .client_order_id = entry.client_order_id,
+            .instrument_id = command.instrument_id,
+            .reason = reason,
+        });
+    }
+}
+
+template <class Sink>
+void MatchingEngine::process_command(const ExchangeCommand& command, Sink& sink) {
+    std::visit(
+        [&](const auto& cmd) {
+            using T = std::decay_t<decltype(cmd)>;
+            if constexpr (std::is_same_v<T, NewOrderCommand>) {
+                process_new_order(cmd, sink);
+            } else if constexpr (std::is_same_v<T, CancelOrderCommand>) {
+                process_cancel(cmd, sink);
+            } else if constexpr (std::is_same_v<T, ReplaceOrderCommand>) {
+                process_replace(cmd, sink);
+            } else if constexpr (std::is_same_v<T, MassQuoteCommand>) {
+                process_mass_quote(cmd, sink);
+            } else if constexpr (std::is_same_v<T, TradingPhaseCommand>) {
+                process_trading_phase(cmd, sink);
+            }
+            if constexpr (std::is_same_v<T, MassCancelCommand>) {
+                process_mass_cancel(cmd, sink);
+            } else if constexpr (std::is_same_v<T, ClockTickCommand>) {
+                process_clock_tick(cmd, sink);
+            } else {
+                note_activity(cmd.instrument_id);
+            }
+        },
+        command);
+    if (triggers_.armed) {
+        release_triggered_stops(sink);
+    }
+    reclaim_idle_ladder();
+}
+
+template <class Sink>
+void MatchingEngine::match_and_rest(ExchangeRestingOrder& incoming, CommandSequence command_sequence, Sink& sink) {
+    MatchingBook& book = book_for(incoming.instrument_id);
+    if (book.trading_phase() == TradingPhase::Call) {
+        // Nothing trades during a call; what would have crossed rests and
+        // waits for the uncross.
+        return;
+    }
+    const Side contra_side = incoming.side == Side::Buy ? Side::Sell : Side::Buy;
+    // One sweep trades at prices moving one way only, so its first and last
+    // prices bound every price it traded at -- which is what stop orders
+    // need to know, and all they need.
+    std::optional<Price> first_trade_price;
+    Price last_trade_price = 0;
+
+    while (incoming.remaining_quantity > 0) {
+        const std::optional<BookOrder> contra = book.front_of_best(contra_side);
+        if (!contra.has_value()) {
+            break;
+        }
+        const bool crosses = incoming.side == Side::Buy ? incoming.price >= contra->price : incoming.price <= contra->price;
+        if (!crosses) {
+            break;
+        }
+
+        // Everything this iteration reports about the resting side. `contra`
+        // is a copy, so these stay good after remove_front() below destroys
+        // the order itself.
+        const AccountId contra_account_id = contra->account_id;
+        const ClientOrderId contra_client_order_id = contra->client_order_id;
+        const ExchangeOrderId contra_exchange_order_id = contra->exchange_order_id;
+        const Price contra_price = contra->price;
+
+        const Quantity trade_qty = std::min(incoming.remaining_quantity, contra->remaining_quantity);
+        incoming.remaining_quantity -= trade_qty;
+        if (!first_trade_price.has_value()) {
+            first_trade_price = contra_price;
+        }
+        last_trade_price = contra_price;
+        const Quantity contra_remaining_after = contra->remaining_quantity - trade_qty;
+
+        const TradeCounterparty aggressor_cp{
+            .account_id = incoming.account_id,
+            .client_order_id = incoming.client_order_id,
+            .exchange_order_id = incoming.exchange_order_id,
+            .remaining_quantity = incoming.remaining_quantity,
+        };
+        const TradeCounterparty resting_cp{
+            .account_id = contra_account_id,
+            .client_order_id = contra_client_order_id,
+            .exchange_order_id = contra_exchange_order_id,
+            .remaining_quantity = contra_remaining_after,
+        };
+
+        // Price-time priority convention: a trade executes at the resting
+        // (passive) order's price, never the incoming (aggressive) order's
+        // price -- the resting order is the one that already committed to a
+        // price by sitting on the book.
+        sink(TradeExecuted{
+            .event_sequence = next_event_sequence_++,
+            .command_sequence = command_sequence,
+            .instrument_id = incoming.instrument_id,
+            .price = contra_price,
+            .quantity = trade_qty,
+            .aggressor_side = incoming.side,
+            .buyer = incoming.side == Side::Buy ? aggressor_cp : resting_cp,
+            .seller = incoming.side == Side::Buy ? resting_cp : aggressor_cp,
+        });
+
+        fill_front(book, *contra, contra_remaining_after, incoming.instrument_id, sink);
+    }
+
+    if (first_trade_price.has_value()) {
+        note_trades(incoming.instrument_id, std::min(*first_trade_price, last_trade_price),
+                    std::max(*first_trade_price, last_trade_price), last_trade_price, command_sequence);
+    }
+}
+
+template <class Sink>
+void MatchingEngine::fill_front(MatchingBook& book, const BookOrder& front, Quantity remaining_after,
+                                InstrumentId instrument_id, Sink& sink) {
+    if (remaining_after == 0) {
+        book.remove_front(front.side);
+        orders_.erase(LiveKey{front.account_id, front.client_order_id});
+        disarm_expiry(front);
+        sink(BookOrderRemoved{
+            .event_sequence = next_event_sequence_++,
+            .instrument_id = instrument_id,
+            .exchange_order_id = front.exchange_order_id,
+            .side = front.side,
+            .price = front.price,
+        });
+    } else {
+        book.reduce_front(front.side, remaining_after);
+        sink(BookOrderReduced{
+            .event_sequence = next_event_sequence_++,
+            .instrument_id = instrument_id,
+            .exchange_order_id = front.exchange_order_id,
+            .side = front.side,
+            .price = front.price,
+            .new_remaining_quantity = remaining_after,
+        });
+    }
+}
+
+template <class Sink>
+void MatchingEngine::rest_remainder_if_applicable(const ExchangeRestingOrder& order, Timestamp expire_at, Sink& sink) {
+    const bool rests = order.time_in_force == TimeInForce::GTC || order.time_in_force == TimeInForce::GTD;
+    if (!rests || order.remaining_quantity == 0) {
+        // IOC/FOK: any remainder is discarded silently -- never accepted as
+        // resting, so there is nothing to announce.
+        return;
+    }
+    const MatchingBook::Handle handle = book_for(order.instrument_id).add(BookOrder{
+        .exchange_order_id = order.exchange_order_id,
+        .client_order_id = order.client_order_id,
+        .account_id = order.account_id,
+        .price = order.price,
+        .remaining_quantity = order.remaining_quantity,
+        .side = order.side,
+        .time_in_force = order.time_in_force,
+    });
+    orders_.insert_or_assign(LiveKey{order.account_id, order.client_order_id},
+                             OrderRef{
+                                 .original_quantity = order.original_quantity,
+                                 .order_sequence = order.order_sequence,
+                                 .handle = handle,
+                                 .instrument_id = order.instrument_id,
+                             });
+    if (order.time_in_force == TimeInForce::GTD) {
+        const std::uint32_t slot = slot_of_id_[order.instrument_id];
+        expiry_of_.emplace(order.exchange_order_id,
+                           expiries_.schedule(expire_at, ExpiryTimer{.slot = slot, .handle = handle}));
+    }
+    sink(BookOrderAdded{
+        .event_sequence = next_event_sequence_++,
+        .instrument_id = order.instrument_id,
+        .exchange_order_id = order.exchange_order_id,
+        .side = order.side,
+        .price = order.price,
+        .quantity = order.remaining_quantity,
+    });
+}
+
+template <class Sink>
+void MatchingEngine::process_new_order(const NewOrderCommand& cmd, Sink& sink) {
+    // Checked before anything else, price and quantity included: an
+    // instrument this engine does not trade is not a malformed order, it is
+    // an order sent to the wrong venue, and saying so is more useful than
+    // reporting whichever other field happens to also be wrong.
+    if (!knows_instrument(cmd.instrument_id)) {
+        sink(OrderRejected{
+            .event_sequence = next_event_sequence_++,
+            .command_sequence = cmd.command_sequence,
+            .account_id = cmd.account_id,
+            .client_order_id = cmd.client_order_id,
+            .instrument_id = cmd.instrument_id,
+            .reason = RejectReason::InvalidInstrument,
+        });
+        return;
+    }
+    if (cmd.price <= 0) {
+        sink(OrderRejected{
+            .event_sequence = next_event_sequence_++,
+            .command_sequence = cmd.command_sequence,
+            .account_id = cmd.account_id,
+            .client_order_id = cmd.client_order_id,
+            .instrument_id = cmd.instrument_id,
+            .reason = RejectReason::InvalidPrice,
+        });
+        return;
+    }
+    if (cmd.quantity == 0) {
+        sink(OrderRejected{
+            .event_sequence = next_event_sequence_++,
+            .command_sequence = cmd.command_sequence,
+            .account_id = cmd.account_id,
+            .client_order_id = cmd.client_order_id,
+            .instrument_id = cmd.instrument_id,
+            .reason = RejectReason::InvalidQuantity,
+        });
+        return;
+    }
+
+    // Checked against the clock as it stands, so an order the next tick
+    // would expire on arrival is refused rather than accepted and then
+    // cancelled, and an expiry on an order that can never rest is a
+    // mistake worth reporting rather than ignoring.
+    const bool expiry_ok = cmd.time_in_force == TimeInForce::GTD ? cmd.expire_at > clock_ : cmd.expire_at == 0;
+    if (!expiry_ok) {
+        sink(OrderRejected{
+            .event_sequence = next_event_sequence_++,
+            .command_sequence = cmd.command_sequence,
+            .account_id = cmd.account_id,
+            .client_order_id = cmd.client_order_id,
+            .instrument_id = cmd.instrument_id,
+            .reason = RejectReason::InvalidExpiry,
+        });
+        return;
+    }
+
+    // Both ways round: a stop needs a usable stop price, and a stop price on
+    // anything else is a client's mistake worth telling it about.
+    const bool stop_ok = cmd.order_type == OrderType::StopLimit ? valid_stop(cmd) : cmd.stop_price == 0;
+    if (!stop_ok) {
+        sink(OrderRejected{
+            .event_sequence = next_event_sequence_++,
+            .command_sequence = cmd.command_sequence,
+            .account_id = cmd.account_id,
+            .client_order_id = cmd.client_order_id,
+            .instrument_id = cmd.instrument_id,
+            .reason = RejectReason::InvalidStopPrice,
+        });
+        return;
+    }
+
+    // An immediate order in a call could only ever be discarded, since
+    // nothing trades until the uncross; better to say so.
+    const bool immediate = cmd.time_in_force == TimeInForce::IOC || cmd.time_in_force == TimeInForce::FOK;
+    if (immediate && book_for(cmd.instrument_id).trading_phase() == TradingPhase::Call) {
+        sink(OrderRejected{
+            .event_sequence = next_event_sequence_++,
+            .command_sequence = cmd.command_sequence,
+            .account_id = cmd.account_id,
+            .client_order_id = cmd.client_order_id,
+            .instrument_id = cmd.instrument_id,
+            .reason = RejectReason::InvalidDuringCall,
+        });
+        return;
+    }
+
+    const LiveKey key{cmd.account_id, cmd.client_order_id};
+    if (orders_.contains(key)) {
+        sink(OrderRejected{
+            .event_sequence = next_event_sequence_++,
+            .command_sequence = cmd.command_sequence,
+            .account_id = cmd.account_id,
+            .client_order_id = cmd.client_order_id,
+            .instrument_id = cmd.instrument_id,
+            .reason = RejectReason::DuplicateOrderId,
+        });
+        return;
+    }
+
+    if (cmd.time_in_force == TimeInForce::FOK) {
+        const Quantity available = crossable_quantity(cmd.instrument_id, cmd.side, cmd.price, cmd.quantity);
+        if (available < cmd.quantity) {
+            // No OrderAccepted, no book mutation: FOK either fills
+            // completely or never touches the book at all.
+            sink(OrderRejected{
+                .event_sequence = next_event_sequence_++,
+                .command_sequence = cmd.command_sequence,
+                .account_id = cmd.account_id,
+                .client_order_id = cmd.client_order_id,
+                .instrument_id = cmd.instrument_id,
+                .reason = RejectReason::InsufficientLiquidity,
+            });
+            return;
+        }
+    }
+
+    if (cmd.order_type == OrderType::StopLimit) {
+        accept_stop(cmd, sink);
+        return;
+    }
+    accept_and_match(cmd, sink);
+}
+
+template <class Sink>
+void MatchingEngine::accept_and_match(const NewOrderCommand& cmd, Sink& sink) {
+    ExchangeRestingOrder order = accept(cmd, sink);
+    match_and_rest(order, cmd.command_sequence, sink);
+    rest_remainder_if_applicable(order, cmd.expire_at, sink);
+}
+
+template <class Sink>
+void MatchingEngine::accept_stop(const NewOrderCommand& cmd, Sink& sink) {
+    const ExchangeRestingOrder order = accept(cmd, sink);
+    std::unique_ptr<MatchingBook>& stops = stop_books_[slot_of_id_[cmd.instrument_id]];
+    if (stops == nullptr) {
+        stops = std::make_unique<MatchingBook>(0, MatchingBook::kMinBandTicks);
+    }
+    // Filed on the side whose best price is the next to trigger; see the
+    // class comment.
+    const MatchingBook::Handle handle = stops->add(BookOrder{
+        .exchange_order_id = order.exchange_order_id,
+        .client_order_id = order.client_order_id,
+        .account_id = order.account_id,
+        .price = cmd.stop_price,
+        .remaining_quantity = order.remaining_quantity,
+        .side = order.side == Side::Buy ? Side::Sell : Side::Buy,
+        .time_in_force = order.time_in_force,
+    });
+    orders_.insert_or_assign(LiveKey{order.account_id, order.client_order_id},
+                             OrderRef{
+                                 .original_quantity = order.original_quantity,
+                                 .order_sequence = order.order_sequence | kPendingStop,
+                                 .handle = handle,
+                                 .instrument_id = order.instrument_id,
+                             });
+    stop_limit_prices_.emplace(order.exchange_order_id, order.price);
+}
+
+template <class Sink>
+ExchangeRestingOrder MatchingEngine::accept(const NewOrderCommand& cmd, Sink& sink) {
+    const ExchangeOrderId exchange_order_id = next_exchange_order_id_;
+    next_exchange_order_id_ += exchange_order_id_stride_;
+    ExchangeRestingOrder order{
+        .exchange_order_id = exchange_order_id,
+        .client_order_id = cmd.client_order_id,
+        .account_id = cmd.account_id,
+        .price = cmd.price,
+        .original_quantity = cmd.quantity,
+        .remaining_quantity = cmd.quantity,
+        .order_sequence = next_priority_++,
+        .instrument_id = cmd.instrument_id,
+        .side = cmd.side,
+        .time_in_force = cmd.time_in_force,
+    };
+
+    sink(OrderAccepted{
+        .event_sequence = next_event_sequence_++,
+        .command_sequence = cmd.command_sequence,
+        .account_id = cmd.account_id,
+        .client_order_id = cmd.client_order_id,
+        .exchange_order_id = exchange_order_id,
+        .instrument_id = cmd.instrument_id,
+        .side = cmd.side,
+        .price = cmd.price,
+        .quantity = cmd.quantity,
+        .order_type = cmd.order_type,
+        .time_in_force = cmd.time_in_force,
+    });
+    return order;
+}
+
+template <class Sink>
+void MatchingEngine::process_cancel(const CancelOrderCommand& cmd, Sink& sink) {
+    // Ahead of the order-id lookup, so a cancel naming an instrument this
+    // engine does not trade reports that rather than UnknownOrderId -- which
+    // would be true but would send the client looking in the wrong place.
+    if (!knows_instrument(cmd.instrument_id)) {
+        sink(OrderRejected{
+            .event_sequence = next_event_sequence_++,
+            .command_sequence = cmd.command_sequence,
+            .account_id = cmd.account_id,
+            .client_order_id = cmd.client_order_id,
+            .instrument_id = cmd.instrument_id,
+            .reason = RejectReason::InvalidInstrument,
+        });
+        return;
+    }
+
+    const LiveKey key{cmd.account_id, cmd.client_order_id};
+    const OrderRef* const ref = orders_.find(key);
+    if (ref == nullptr || ref->instrument_id != cmd.instrument_id) {
+        sink(OrderRejected{
+            .event_sequence = next_event_sequence_++,
+            .command_sequence = cmd.command_sequence,
+            .account_id = cmd.account_id,
+            .client_order_id = cmd.client_order_id,
+            .instrument_id = cmd.instrument_id,
+            .reason = RejectReason::UnknownOrderId,
+        });
+        return;
+    }
+    if (is_pending_stop(*ref)) {
+        cancel_pending_stop(cmd, *ref, sink);
+        return;
+    }
+
+    const MatchingBook::Handle handle = ref->handle;
+    orders_.erase(ref);
+    const BookOrder removed = book_for(cmd.instrument_id).remove_at(handle);
+    disarm_expiry(removed);
+
+    sink(OrderCancelled{
+        .event_sequence = next_event_sequence_++,
+        .command_sequence = cmd.command_sequence,
+        .account_id = cmd.account_id,
+        .client_order_id = cmd.client_order_id,
+        .exchange_order_id = removed.exchange_order_id,
+        .instrument_id = cmd.instrument_id,
+    });
+    sink(BookOrderRemoved{
+        .event_sequence = next_event_sequence_++,
+        .instrument_id = cmd.instrument_id,
+        .exchange_order_id = removed.exchange_order_id,
+        .side = removed.side,
+        .price = removed.price,
+    });
+}
+
+template <class Sink>
+void MatchingEngine::process_replace(const ReplaceOrderCommand& cmd, Sink& sink) {
+    if (!knows_instrument(cmd.instrument_id)) {
+        sink(OrderRejected{
+            .event_sequence = next_event_sequence_++,
+            .command_sequence = cmd.command_sequence,
+            .account_id = cmd.account_id,
+            .client_order_id = cmd.original_client_order_id,
+            .instrument_id = cmd.instrument_id,
+            .reason = RejectReason::InvalidInstrument,
+        });
+        return;
+    }
+    if (cmd.new_price <= 0 || cmd.new_quantity == 0) {
+        sink(OrderRejected{
+            .event_sequence = next_event_sequence_++,
+            .command_sequence = cmd.command_sequence,
+            .account_id = cmd.account_id,
+            .client_order_id = cmd.original_client_order_id,
+            .instrument_id = cmd.instrument_id,
+            .reason = RejectReason::InvalidReplacement,
+        });
+        return;
+    }
+
+    const LiveKey original_key{cmd.account_id, cmd.original_client_order_id};
+    const OrderRef* const found = orders_.find(original_key);
+    if (found == nullptr || found->instrument_id != cmd.instrument_id) {
+        sink(OrderRejected{
+            .event_sequence = next_event_sequence_++,
+            .command_sequence = cmd.command_sequence,
+            .account_id = cmd.account_id,
+            .client_order_id = cmd.original_client_order_id,
+            .instrument_id = cmd.instrument_id,
+            .reason = RejectReason::UnknownOrderId,
+        });
+        return;
+    }
+    if (is_pending_stop(*found)) {
+        sink(OrderRejected{
+            .event_sequence = next_event_sequence_++,
+            .command_sequence = cmd.command_sequence,
+            .account_id = cmd.account_id,
+            .client_order_id = cmd.original_client_order_id,
+            .instrument_id = cmd.instrument_id,
+            .reason = RejectReason::InvalidReplacement,
+        });
+        return;
+    }
+
+    // A copy, not the pointer: the table moves entries on every insert and
+    // erase, and both paths below do one.
+    const OrderRef ref = *found;
+    MatchingBook& book = book_for(cmd.instrument_id);
+    // A copy, read before the book is mutated: the priority-losing path
+    // below destroys the order it came from.
+    const BookOrder resting = book.at(ref.handle);
+    const ExchangeOrderId old_exchange_order_id = resting.exchange_order_id;
+    const Side old_side = resting.side;
+    const Price old_price = resting.price;
+    const TimeInForce old_time_in_force = resting.time_in_force;
+
+    // Priority-preserving path: same price, quantity unchanged or decreased.
+    // A price change or a quantity *increase* falls through to the
+    // cancel-plus-new path below (see the class-level policy comment in
+    // matching_engine.hpp).
+    const bool preserves_priority = cmd.new_price == old_price && cmd.new_quantity <= resting.remaining_quantity;
+
+    if (preserves_priority) {
+        book.reduce_at(ref.handle, cmd.new_quantity);
+        book.set_client_order_id_at(ref.handle, cmd.new_client_order_id);
+        // Same order, same place in the queue, addressable under its new
+        // client order id: the entry is re-keyed, not rebuilt.
+        orders_.erase(found);
+        orders_.insert_or_assign(LiveKey{cmd.account_id, cmd.new_client_order_id}, ref);
+
+        sink(OrderReplaced{
+            .event_sequence = next_event_sequence_++,
+            .command_sequence = cmd.command_sequence,
+            .account_id = cmd.account_id,
+            .original_client_order_id = cmd.original_client_order_id,
+            .new_client_order_id = cmd.new_client_order_id,
+            .exchange_order_id = old_exchange_order_id,
+            .instrument_id = cmd.instrument_id,
+            .new_price = cmd.new_price,
+            .new_quantity = cmd.new_quantity,
+        });
+        sink(BookOrderReduced{
+            .event_sequence = next_event_sequence_++,
+            .instrument_id = cmd.instrument_id,
+            .exchange_order_id = old_exchange_order_id,
+            .side = old_side,
+            .price = old_price,
+            .new_remaining_quantity = cmd.new_quantity,
+        });
+        return;
+    }
+
+    // Priority-losing path: cancel-plus-new. The old order vanishes from the
+    // book and a freshly-id'd order re-enters the ordinary matching path, so
+    // a reprice into a crossing price trades immediately just like any other
+    // aggressive new order.
+    book.remove_at(ref.handle);
+    orders_.erase(found);
+    const Timestamp old_expire_at = disarm_expiry(resting);
+
+    const ExchangeOrderId new_exchange_order_id = next_exchange_order_id_;
+    next_exchange_order_id_ += exchange_order_id_stride_;
+    sink(OrderReplaced{
+        .event_sequence = next_event_sequence_++,
+        .command_sequence = cmd.command_sequence,
+        .account_id = cmd.account_id,
+        .original_client_order_id = cmd.original_client_order_id,
+        .new_client_order_id = cmd.new_client_order_id,
+        .exchange_order_id = new_exchange_order_id,
+        .instrument_id = cmd.instrument_id,
+        .new_price = cmd.new_price,
+        .new_quantity = cmd.new_quantity,
+    });
+    sink(BookOrderRemoved{
+        .event_sequence = next_event_sequence_++,
+        .instrument_id = cmd.instrument_id,
+        .exchange_order_id = old_exchange_order_id,
+        .side = old_side,
+        .price = old_price,
+    });
+
+    ExchangeRestingOrder new_order{
+        .exchange_order_id = new_exchange_order_id,
+        .client_order_id = cmd.new_client_order_id,
+        .account_id = cmd.account_id,
+        .price = cmd.new_price,
+        .original_quantity = cmd.new_quantity,
+        .remaining_quantity = cmd.new_quantity,
+        .order_sequence = next_priority_++,
+        .instrument_id = cmd.instrument_id,
+        .side = old_side,
+        .time_in_force = old_time_in_force,
+    };
+    match_and_rest(new_order, cmd.command_sequence, sink);
+    rest_remainder_if_applicable(new_order, old_expire_at, sink);
+}
+
+template <class Sink>
+void MatchingEngine::process_mass_quote(const MassQuoteCommand& cmd, Sink& sink) {
+    if (!knows_instrument(cmd.instrument_id)) {
+        reject_quote(cmd, RejectReason::InvalidInstrument, sink);
+        return;
+    }
+    // Before anything is sized from it: every array below holds one
+    // element per level.
+    if (cmd.entries.size() > kMaxQuoteEntries) {
+        reject_quote(cmd, RejectReason::InvalidQuote, sink);
+        return;
+    }
+
+    // The quote being replaced: every level of the last one that still
+    // rests as the order it became. Copied out whole, since every path
+    // below moves directory entries and some destroy book orders.
+    struct Standing {
+        ClientOrderId client_order_id;
+        OrderRef ref;
+        BookOrder order;
+        bool paired;
+    };
+    const QuoteKey quote_key{cmd.account_id, cmd.instrument_id};
+    MatchingBook& book = book_for(cmd.instrument_id);
+    std::array<Standing, kMaxQuoteEntries> standing{};
+    std::size_t standing_count = 0;
+    if (const auto it = quotes_.find(quote_key); it != quotes_.end()) {
+        for (const QuotedLevel& level : it->second) {
+            if (const OrderRef* ref = find_quoted(quote_key, level)) {
+                standing[standing_count++] = Standing{
+                    .client_order_id = level.client_order_id,
+                    .ref = *ref,
+                    .order = book.at(ref->handle),
+                    .paired = false,
+                };
+            }
+        }
+    }
+    const auto is_standing = [&](ClientOrderId client_order_id) {
+        return std::any_of(standing.begin(), standing.begin() + static_cast<std::ptrdiff_t>(standing_count),
+                           [&](const Standing& s) { return s.client_order_id == client_order_id; });
+    };
+
+    // Every level is checked before any is acted on, so a bad one rejects
+    // the quote while the book is still untouched. Each level is reported
+    // under its own reason, and the sound ones under InvalidQuote -- they
+    // were refused only for the company they kept. An id live as one of
+    // the levels being replaced is fine: it is cancelled or re-keyed before
+    // anything new takes it.
+    std::array<RejectReason, kMaxQuoteEntries> problems{};
+    bool rejected = false;
+    for (std::size_t i = 0; i < cmd.entries.size(); ++i) {
+        const QuoteEntry& entry = cmd.entries[i];
+        RejectReason problem = RejectReason::None;
+        if (entry.price <= 0) {
+            problem = RejectReason::InvalidPrice;
+        } else if (entry.quantity == 0) {
+            problem = RejectReason::InvalidQuantity;
+        } else if (std::any_of(cmd.entries.begin(), cmd.entries.begin() + static_cast<std::ptrdiff_t>(i),
+                               [&](const QuoteEntry& e) { return e.client_order_id == entry.client_order_id; })) {
+            problem = RejectReason::InvalidQuote;
+        } else if (orders_.contains(LiveKey{cmd.account_id, entry.client_order_id}) &&
+                   !is_standing(entry.client_order_id)) {
+            problem = RejectReason::DuplicateOrderId;
+        }
+        problems[i] = problem;
+        rejected = rejected || problem != RejectReason::None;
+    }
+    if (rejected) {
+        for (std::size_t i = 0; i < cmd.entries.size(); ++i) {
+            sink(OrderRejected{
+                .event_sequence = next_event_sequence_++,
+                .command_sequence = cmd.command_sequence,
+                .account_id = cmd.account_id,
+                .client_order_id = cmd.entries[i].client_order_id,
+                .instrument_id = cmd.instrument_id,
+                .reason = problems[i] == RejectReason::None ? RejectReason::InvalidQuote : problems[i],
+            });
+        }
+        return;
+    }
+
+    // Pair each level with a standing one it can replace without losing
+    // priority: same side, same price, no more quantity than is left. The
+    // first that fits is taken -- two standing levels at one price is a
+    // quote that was entered that way, and either keeps its place.
+    constexpr std::size_t kUnpaired = kMaxQuoteEntries;
+    std::array<std::size_t, kMaxQuoteEntries> paired_with{};
+    for (std::size_t i = 0; i < cmd.entries.size(); ++i) {
+        const QuoteEntry& entry = cmd.entries[i];
+        paired_with[i] = kUnpaired;
+        for (std::size_t s = 0; s < standing_count; ++s) {
+            Standing& candidate = standing[s];
+            if (!candidate.paired && candidate.order.side == entry.side && candidate.order.price == entry.price &&
+                entry.quantity <= candidate.order.remaining_quantity) {
+                candidate.paired = true;
+                paired_with[i] = s;
+                break;
+            }
+        }
+    }
+
+    // 1. Standing levels nothing replaces.
+    for (std::size_t s = 0; s < standing_count; ++s) {
+        const Standing& level = standing[s];
+        if (level.paired) {
+            continue;
+        }
+        orders_.erase(LiveKey{cmd.account_id, level.client_order_id});
+        book.remove_at(level.ref.handle);
+        disarm_expiry(level.order);
+        sink(OrderCancelled{
+            .event_sequence = next_event_sequence_++,
+            .command_sequence = cmd.command_sequence,
+            .account_id = cmd.account_id,
+            .client_order_id = level.client_order_id,
+            .exchange_order_id = level.order.exchange_order_id,
+            .instrument_id = cmd.instrument_id,
+        });
+        sink(BookOrderRemoved{
+            .event_sequence = next_event_sequence_++,
+            .instrument_id = cmd.instrument_id,
+            .exchange_order_id = level.order.exchange_order_id,
+            .side = level.order.side,
+            .price = level.order.price,
+        });
+    }
+
+    // 2. Paired levels, edited in place. Every old key goes before any new
+    // one is written, since a level may take the id another pair is giving
+    // up.
+    for (std::size_t i = 0; i < cmd.entries.size(); ++i) {
+        if (paired_with[i] != kUnpaired) {
+            orders_.erase(LiveKey{cmd.account_id, standing[paired_with[i]].client_order_id});
+        }
+    }
+    for (std::size_t i = 0; i < cmd.entries.size(); ++i) {
+        if (paired_with[i] == kUnpaired) {
+            continue;
+        }
+        const QuoteEntry& entry = cmd.entries[i];
+        const Standing& level = standing[paired_with[i]];
+        book.reduce_at(level.ref.handle, entry.quantity);
+        book.set_client_order_id_at(level.ref.handle, entry.client_order_id);
+        orders_.insert_or_assign(LiveKey{cmd.account_id, entry.client_order_id}, level.ref);
+        sink(OrderReplaced{
+            .event_sequence = next_event_sequence_++,
+            .command_sequence = cmd.command_sequence,
+            .account_id = cmd.account_id,
+            .original_client_order_id = level.client_order_id,
+            .new_client_order_id = entry.client_order_id,
+            .exchange_order_id = level.order.exchange_order_id,
+            .instrument_id = cmd.instrument_id,
+            .new_price = entry.price,
+            .new_quantity = entry.quantity,
+        });
+        sink(BookOrderReduced{
+            .event_sequence = next_event_sequence_++,
+            .instrument_id = cmd.instrument_id,
+            .exchange_order_id = level.order.exchange_order_id,
+            .side = level.order.side,
+            .price = level.order.price,
+            .new_remaining_quantity = entry.quantity,
+        });
+    }
+
+    // 3. New levels, and the record of what this quote now is. A new level
+    // is recorded even if it traded away on entry; find_quoted() will not
+    // find it, which is the same as not being recorded. clear() rather
+    // than a fresh vector keeps a steady requote from allocating.
+    if (cmd.entries.empty()) {
+        quotes_.erase(quote_key);
+        return;
+    }
+    std::vector<QuotedLevel>& levels = quotes_[quote_key];
+    levels.clear();
+    for (std::size_t i = 0; i < cmd.entries.size(); ++i) {
+        const QuoteEntry& entry = cmd.entries[i];
+        if (paired_with[i] != kUnpaired) {
+            levels.push_back(QuotedLevel{entry.client_order_id, standing[paired_with[i]].ref.order_sequence});
+            continue;
+        }
+        levels.push_back(QuotedLevel{entry.client_order_id, next_priority_});
+        accept_and_match(
+            NewOrderCommand{
+                .command_sequence = cmd.command_sequence,
+                .account_id = cmd.account_id,
+                .client_order_id = entry.client_order_id,
+                .instrument_id = cmd.instrument_id,
+                .side = entry.side,
+                .price = entry.price,
+                .quantity = entry.quantity,
+                .order_type = OrderType::Limit,
+                .time_in_force = TimeInForce::GTC,
+            },
+            sink);
+    }
+}
+
+template <class Sink>
+void MatchingEngine::process_mass_cancel(const MassCancelCommand& cmd, Sink& sink) {
+    ++commands_seen_;
+    std::size_t left = cmd.max_orders == 0 ? std::numeric_limits<std::size_t>::max() : cmd.max_orders;
+    if (cmd.instrument_id.has_value()) {
+        if (!knows_instrument(*cmd.instrument_id)) {
+            sink(OrderRejected{
+                .event_sequence = next_event_sequence_++,
+                .command_sequence = cmd.command_sequence,
+                .account_id = cmd.account_id,
+                .client_order_id = 0,
+                .instrument_id = *cmd.instrument_id,
+                .reason = RejectReason::InvalidInstrument,
+            });
+            return;
+        }
+        mass_cancel_book(cmd, *cmd.instrument_id, slot_of_id_[*cmd.instrument_id], left, sink);
+        return;
+    }
+    // In instrument id order, like by_id_, so the cancels come out in an
+    // order that means something to whoever reads them.
+    const auto books = books_of_account_.find(cmd.account_id);
+    if (books == books_of_account_.end()) {
+        return;
+    }
+    for (const auto& [instrument_id, slot] : books->second) {
+        if (left == 0) {
+            break;
+        }
+        mass_cancel_book(cmd, instrument_id, slot, left, sink);
+    }
+}
+
+template <class Sink>
+void MatchingEngine::mass_cancel_book(const MassCancelCommand& cmd, InstrumentId instrument_id, std::uint32_t slot,
+                                      std::size_t& left, Sink& sink) {
+    const ExchangeOrderId before = cmd.before_exchange_order_id != 0 ? cmd.before_exchange_order_id
+                                                                       : std::numeric_limits<ExchangeOrderId>::max();
+    const std::size_t removed = books_[slot].remove_account_orders(
+        cmd.account_id, cmd.side,
+        [&](const BookOrder& order) {
+            orders_.erase(LiveKey{cmd.account_id, order.client_order_id});
+            disarm_expiry(order);
+            sink(OrderCancelled{
+                .event_sequence = next_event_sequence_++,
+                .command_sequence = cmd.command_sequence,
+                .account_id = cmd.account_id,
+                .client_order_id = order.client_order_id,
+                .exchange_order_id = order.exchange_order_id,
+                .instrument_id = instrument_id,
+            });
+            sink(BookOrderRemoved{
+                .event_sequence = next_event_sequence_++,
+                .instrument_id = instrument_id,
+                .exchange_order_id = order.exchange_order_id,
+                .side = order.side,
+                .price = order.price,
+            });
+        },
+        left, before);
+    left -= removed;
+    // Then the account's stops, which were never on the book and so have
+    // no BookOrderRemoved to report. Filed on the opposite side, so the
+    // filter is too.
+    std::size_t stops_removed = 0;
+    if (MatchingBook* stops = stop_books_[slot].get(); stops != nullptr && left > 0) {
+        const std::optional<Side> filed =
+            cmd.side.has_value() ? std::optional<Side>(*cmd.side == Side::Buy ? Side::Sell : Side::Buy) : std::nullopt;
+        stops_removed = stops->remove_account_orders(
+            cmd.account_id, filed,
+            [&](const BookOrder& order) {
+                orders_.erase(LiveKey{cmd.account_id, order.client_order_id});
+                stop_limit_prices_.erase(order.exchange_order_id);
+                sink(OrderCancelled{
+                    .event_sequence = next_event_sequence_++,
+                    .command_sequence = cmd.command_sequence,
+                    .account_id = cmd.account_id,
+                    .client_order_id = order.client_order_id,
+                    .exchange_order_id = order.exchange_order_id,
+                    .instrument_id = instrument_id,
+                });
+            },
+            left, before);
+        left -= stops_removed;
+    }
+    if (removed > 0 || stops_removed > 0) {
+        note_book(slot);
+    }
+}
+
+template <class Sink>
+void MatchingEngine::process_clock_tick(const ClockTickCommand& cmd, Sink& sink) {
+    ++commands_seen_;
+    if (cmd.now <= clock_) {
+        return;
+    }
+    clock_ = cmd.now;
+    // The wheel hands back each due order's slot and handle, already
+    // forgotten on its side, and the rest is an ordinary cancel: the same
+    // remove_at() a CancelOrderCommand ends in, with the directory entry
+    // and the expiry map entry going with it.
+    expiries_.advance(clock_, [&](const ExpiryTimer& timer, Timestamp) {
+        const BookOrder removed = books_[timer.slot].remove_at(timer.handle);
+        orders_.erase(LiveKey{removed.account_id, removed.client_order_id});
+        expiry_of_.erase(removed.exchange_order_id);
+        const InstrumentId instrument_id = activity_[timer.slot].instrument_id;
+        sink(OrderCancelled{
+            .event_sequence = next_event_sequence_++,
+            .command_sequence = cmd.command_sequence,
+            .account_id = removed.account_id,
+            .client_order_id = removed.client_order_id,
+            .exchange_order_id = removed.exchange_order_id,
+            .instrument_id = instrument_id,
+        });
+        sink(BookOrderRemoved{
+            .event_sequence = next_event_sequence_++,
+            .instrument_id = instrument_id,
+            .exchange_order_id = removed.exchange_order_id,
+            .side = removed.side,
+            .price = removed.price,
+        });
+        note_book(timer.slot);
+    });
+}
+
+template <class Sink>
+void MatchingEngine::process_trading_phase(const TradingPhaseCommand& cmd, Sink& sink) {
+    if (!knows_instrument(cmd.instrument_id)) {
+        sink(OrderRejected{
+            .event_sequence = next_event_sequence_++,
+            .command_sequence = cmd.command_sequence,
+            .account_id = 0,
+            .client_order_id = 0,
+            .instrument_id = cmd.instrument_id,
+            .reason = RejectReason::InvalidInstrument,
+        });
+        return;
+    }
+    MatchingBook& book = book_for(cmd.instrument_id);
+    if (book.trading_phase() == cmd.phase) {
+        return;
+    }
+    book.set_trading_phase(cmd.phase);
+    if (cmd.phase == TradingPhase::Continuous) {
+        uncross(cmd.instrument_id, cmd.command_sequence, sink);
+    }
+}
+
+template <class Sink>
+void MatchingEngine::uncross(InstrumentId instrument_id, CommandSequence command_sequence, Sink& sink) {
+    const std::uint32_t slot = slot_of_id_[instrument_id];
+    MatchingBook& book = books_[slot];
+    const BookActivity& activity = activity_[slot];
+    const std::optional<Equilibrium> equilibrium =
+        book.equilibrium(activity.has_traded ? std::optional<Price>(activity.last_trade_price) : std::nullopt);
+    if (!equilibrium.has_value()) {
+        return;
+    }
+    const Price price = equilibrium->price;
+    const Side aggressor_side = equilibrium->imbalance < 0 ? Side::Sell : Side::Buy;
+
+    // The fronts of both sides are, at every step, the best-priced oldest
+    // orders left, and the equilibrium volume is no more than either side
+    // has at the equilibrium price or better -- so every order filled here
+    // was willing to trade at `price`, and the loop never runs dry.
+    Quantity left = equilibrium->volume;
+    while (left > 0) {
+        const BookOrder bid = *book.front_of_best(Side::Buy);
+        const BookOrder ask = *book.front_of_best(Side::Sell);
+        const Quantity trade_qty = std::min({left, bid.remaining_quantity, ask.remaining_quantity});
+        left -= trade_qty;
+        sink(TradeExecuted{
+            .event_sequence = next_event_sequence_++,
+            .command_sequence = command_sequence,
+            .instrument_id = instrument_id,
+            .price = price,
+            .quantity = trade_qty,
+            .aggressor_side = aggressor_side,
+            .buyer =
+                TradeCounterparty{
+                    .account_id = bid.account_id,
+                    .client_order_id = bid.client_order_id,
+                    .exchange_order_id = bid.exchange_order_id,
+                    .remaining_quantity = bid.remaining_quantity - trade_qty,
+                },
+            .seller =
+                TradeCounterparty{
+                    .account_id = ask.account_id,
+                    .client_order_id = ask.client_order_id,
+                    .exchange_order_id = ask.exchange_order_id,
+                    .remaining_quantity = ask.remaining_quantity - trade_qty,
+                },
+        });
+        fill_front(book, bid, bid.remaining_quantity - trade_qty, instrument_id, sink);
+        fill_front(book, ask, ask.remaining_quantity - trade_qty, instrument_id, sink);
+    }
+    note_trades(instrument_id, price, price, price, command_sequence);
+}
+
+template <class Sink>
+void MatchingEngine::cancel_pending_stop(const CancelOrderCommand& cmd, const OrderRef& ref, Sink& sink) {
+    const BookOrder removed = stop_books_[slot_of_id_[cmd.instrument_id]]->remove_at(ref.handle);
+    orders_.erase(&ref);
+    stop_limit_prices_.erase(removed.exchange_order_id);
+    sink(OrderCancelled{
+        .event_sequence = next_event_sequence_++,
+        .command_sequence = cmd.command_sequence,
+        .account_id = cmd.account_id,
+        .client_order_id = cmd.client_order_id,
+        .exchange_order_id = removed.exchange_order_id,
+        .instrument_id = cmd.instrument_id,
+    });
+}
+
+template <class Sink>
+void MatchingEngine::release_triggered_stops(Sink& sink) {
+    const std::uint32_t slot = triggers_.slot;
+    MatchingBook& stops = *stop_books_[slot];
+    const InstrumentId instrument_id = activity_[slot].instrument_id;
+    // triggers_ is re-read every time round: each release can trade, and
+    // match_and_rest() widens it by whatever that trade reached.
+    for (;;) {
+        // Buy stops first, from the lowest stop price up, while a trade has
+        // printed at or above them; then sell stops, from the highest down,
+        // while one has printed at or below. Each is the front of its
+        // filing side, so this stops at the first stop price not reached.
+        Side filed = Side::Sell;
+        std::optional<BookOrder> stop = stops.front_of_best(Side::Sell);
+        if (!stop.has_value() || stop->price > triggers_.high) {
+            filed = Side::Buy;
+            stop = stops.front_of_best(Side::Buy);
+            if (!stop.has_value() || stop->price < triggers_.low) {
+                break;
+            }
+        }
+        stops.remove_front(filed);
+        const LiveKey key{stop->account_id, stop->client_order_id};
+        const std::uint64_t order_sequence = orders_.find(key)->order_sequence & ~kPendingStop;
+        orders_.erase(key);
+        const auto limit = stop_limit_prices_.find(stop->exchange_order_id);
+        const Price limit_price = limit->second;
+        stop_limit_prices_.erase(limit);
+
+        // The limit order the stop was all along, entered now: same ids,
+        // same priority number, its own price.
+        ExchangeRestingOrder order{
+            .exchange_order_id = stop->exchange_order_id,
+            .client_order_id = stop->client_order_id,
+            .account_id = stop->account_id,
+            .price = limit_price,
+            .original_quantity = stop->remaining_quantity,
+            .remaining_quantity = stop->remaining_quantity,
+            .order_sequence = order_sequence,
+            .instrument_id = instrument_id,
+            .side = filed == Side::Sell ? Side::Buy : Side::Sell,
+            .time_in_force = stop->time_in_force,
+        };
+        match_and_rest(order, triggers_.command_sequence, sink);
+        rest_remainder_if_applicable(order, 0, sink);
+    }
+    triggers_.armed = false;
+    // The command that armed this has already had its bookkeeping; what
+    // the releases did to the book has not.
+    note_book(slot);
+}
+
+} // namespace mdh::exchange
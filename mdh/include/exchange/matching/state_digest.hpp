@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+
+#include "common/types.hpp"
+#include "exchange/core/types.hpp"
+#include "exchange/matching/resting_order.hpp"
+
+// The pieces of the rolling state hash: a digest per resting order, and a
+// weight per instrument to combine book digests with.
+//
+// A book's digest is the sum, mod 2^64, of its orders' digests. Addition
+// rather than XOR because a sum can be updated by subtracting the old digest
+// and adding the new one whatever else the book holds, and because two equal
+// digests do not cancel -- not that two live orders can share one, since
+// every digest covers the exchange order id. Order-independent on purpose:
+// the book can keep it current in O(1) from inside add() and remove_at(),
+// with no walk of the queue.
+//
+// Being a set hash, it cannot see queue order directly. It does not need to:
+// exchange order ids are handed out in increasing order and an order keeps
+// its id for as long as it keeps its place, so within a price level the
+// queue is always in id order, and the set of orders determines it.
+//
+// The engine's digest is each book's digest times its instrument's weight,
+// summed. The weight is odd, so it is a bijection mod 2^64 and a change in
+// any one book always changes the total; and it differs per instrument, so
+// the same orders filed under two different instruments hash differently.
+//
+// None of this is cryptographic. It is a cheap, stable fingerprint for
+// comparing two engines that should be in the same state -- a primary and
+// a replica, or a run and its replay -- not a defence against anyone
+// choosing orders to collide.
+namespace mdh::exchange {
+
+namespace state_digest_detail {
+
+// SplitMix64's finaliser: every input bit reaches every output bit.
+[[nodiscard]] constexpr std::uint64_t mix(std::uint64_t x) {
+    x ^= x >> 30U;
+    x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 27U;
+    x *= 0x94D049BB133111EBULL;
+    x ^= x >> 31U;
+    return x;
+}
+
+} // namespace state_digest_detail
+
+// Every field the book holds for an order, chained through the mixer so
+// that no two fields can trade values without changing the result. The two
+// enums share a word; they are a byte each.
+[[nodiscard]] constexpr std::uint64_t order_digest(const BookOrder& order) {
+    using state_digest_detail::mix;
+    std::uint64_t h = mix(order.exchange_order_id);
+    h = mix(h ^ order.client_order_id);
+    h = mix(h ^ order.account_id);
+    h = mix(h ^ static_cast<std::uint64_t>(order.price));
+    h = mix(h ^ order.remaining_quantity);
+    h = mix(h ^ ((static_cast<std::uint64_t>(order.side) << 8U) | static_cast<std::uint64_t>(order.time_in_force)));
+    return h;
+}
+
+[[nodiscard]] constexpr std::uint64_t instrument_weight(InstrumentId instrument_id) {
+    return state_digest_detail::mix(0x5EEDULL + instrument_id) | 1U;
+}
+
+} // namespace mdh::exchange
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <vector>
 
 #include "common/types.hpp"
@@ -14,13 +15,36 @@
 // identical input. Instruments are sorted by ascending id, and each side's
 // orders come out in the book's own price-then-queue order, which is already
 // deterministic. An instrument with nothing resting is left out entirely
-// rather than reported as an empty pair of vectors.
+// rather than reported as an empty pair of vectors. Pending stop orders
+// count as something: they are state a replay has to reproduce.
 namespace mdh::exchange {
 
+// When one resting GTD order expires. Kept beside the orders rather than in
+// ExchangeRestingOrder, which every command is built into on its way to the
+// book and which fits 64 bytes only without it.
+struct OrderExpiry {
+    ExchangeOrderId exchange_order_id;
+    Timestamp expire_at;
+
+    bool operator==(const OrderExpiry&) const = default;
+};
+
+// A stop order waiting for a trade to release it: the limit order it will
+// become, and the price that releases it.
+struct PendingStopOrder {
+    ExchangeRestingOrder order;
+    Price stop_price;
+
+    bool operator==(const PendingStopOrder&) const = default;
+};
+
 struct InstrumentBookSnapshot {
     InstrumentId instrument_id;
     std::vector<ExchangeRestingOrder> bids; // best-to-worst price, FIFO within a level
     std::vector<ExchangeRestingOrder> asks; // best-to-worst price, FIFO within a level
+    std::vector<OrderExpiry> expiries{};    // the GTD orders among them, ascending by exchange_order_id
+    std::vector<PendingStopOrder> stops{};  // in the order they would be released; see MatchingEngine
+    TradingPhase phase = TradingPhase::Continuous; // a book in call keeps its entry even when empty
 
     bool operator==(const InstrumentBookSnapshot&) const = default;
 };
@@ -31,4 +55,33 @@ struct EngineStateSnapshot {
     bool operator==(const EngineStateSnapshot&) const = default;
 };
 
+// The books that changed between two points in an engine's life, each in
+// full, as MatchingEngine::snapshot_changes() produces them. Applied in
+// order to the snapshot the first one started from, they give exactly the
+// snapshot the engine would have produced at the last one's point -- which
+// is what lets a writer keep a full image current by copying only the
+// books that moved.
+//
+// A changed book is reported whole rather than as a list of order edits:
+// a book's own order is price-then-queue, and rebuilding that from edits
+// would mean reimplementing the book. A book left with nothing resting
+// and in continuous trading comes out with both sides and its stops empty,
+// which is how the change says "gone".
+struct EngineStateChanges {
+    // One more than the previous call's, starting from 1, so a consumer can
+    // tell it has missed one.
+    std::uint64_t epoch = 0;
+    // How many commands the engine had processed when these were taken:
+    // the point in the command stream the resulting snapshot describes.
+    std::uint64_t commands = 0;
+    std::vector<InstrumentBookSnapshot> books{}; // sorted ascending by instrument_id
+
+    bool operator==(const EngineStateChanges&) const = default;
+};
+
+// Replaces, inserts or -- for a book reported empty -- drops each changed
+// book in `snapshot`, keeping it sorted and free of empty instruments just
+// as MatchingEngine::snapshot() would. Linear in the two sizes together.
+void apply_changes(EngineStateSnapshot& snapshot, const EngineStateChanges& changes);
+
 } // namespace mdh::exchange
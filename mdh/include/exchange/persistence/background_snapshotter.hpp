@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stop_token>
+#include <thread>
+
+#include "common/spsc_queue.hpp"
+#include "common/thread_placement.hpp"
+#include "exchange/matching/matching_engine.hpp"
+#include "exchange/matching/state_snapshot.hpp"
+
+// Keeps a full engine state snapshot current on a thread of its own, so
+// that taking one no longer stops matching for as long as it takes to copy
+// every resting order.
+//
+// The matching thread calls capture() between commands. That takes the
+// engine's snapshot_changes() -- only the books that moved since the last
+// capture -- and queues them; this class's own thread applies them, in
+// order, to the image it holds and hands the result to `on_snapshot`. Each
+// image is exactly what MatchingEngine::snapshot() would have returned at
+// the moment of its capture, because a capture is taken at a command
+// boundary on the only thread that ever touches the engine: there is no
+// point at which a half-applied command could be copied.
+//
+// This is the epoch form of a background snapshot rather than copy-on-write:
+// the matching thread still copies each changed book once per epoch, but
+// only those, and everything downstream of the copy -- merging, hashing,
+// encoding, writing -- is off the matching thread. A book that changes in
+// every epoch is copied whole in every epoch; for that book this is no
+// cheaper than snapshot().
+//
+// ── Threads ────────────────────────────────────────────────────────────────
+// capture() is the single producer and must only be called from the thread
+// that runs the engine. `on_snapshot` runs on this class's thread. The
+// thread is started in the constructor and joined in stop() or the
+// destructor, after it has applied everything already captured.
+namespace mdh::exchange::persistence {
+
+struct BackgroundSnapshotterOptions {
+    // Captures taken but not yet applied. A capture that finds this full
+    // declines and leaves the changes with the engine, so a slow writer
+    // makes the next image later and larger, never wrong.
+    std::size_t queue_capacity = 64;
+
+    // Called on the snapshot thread after each capture is applied, with the
+    // full image and the changes that produced it -- which tells it the
+    // epoch and how many commands the image covers. Null just keeps the
+    // image current.
+    std::function<void(const EngineStateSnapshot&, const EngineStateChanges&)> on_snapshot;
+
+    // Where the snapshot thread ("mdh-snapshot") runs -- see
+    // thread_placement.hpp. Usually somewhere other than the matching core.
+    ThreadPlacement placement{};
+};
+
+class BackgroundSnapshotter {
+public:
+    explicit BackgroundSnapshotter(BackgroundSnapshotterOptions options = {});
+
+    // Calls stop().
+    ~BackgroundSnapshotter();
+
+    BackgroundSnapshotter(const BackgroundSnapshotter&) = delete;
+    BackgroundSnapshotter& operator=(const BackgroundSnapshotter&) = delete;
+    BackgroundSnapshotter(BackgroundSnapshotter&&) = delete;
+    BackgroundSnapshotter& operator=(BackgroundSnapshotter&&) = delete;
+
+    // Engine thread only, between commands. Hands every change since the
+    // last capture to the snapshot thread and returns true -- including
+    // when there were none, which queues nothing. Returns false, taking
+    // nothing from the engine, if the queue is full; the changes are still
+    // there for the next call.
+    bool capture(MatchingEngine& engine);
+
+    // Applies whatever has been captured, then joins the snapshot thread.
+    // Safe to call more than once.
+    void stop();
+
+    // The image as of the last capture applied. Only safe after stop(), for
+    // the same reason as MatchingPipeline::snapshot(): the snapshot thread
+    // writes it.
+    [[nodiscard]] const EngineStateSnapshot& image() const { return image_; }
+
+    // Safe from any thread.
+    [[nodiscard]] std::uint64_t snapshots_applied() const { return applied_.load(std::memory_order_relaxed); }
+    [[nodiscard]] std::uint64_t captures_declined() const { return declined_.load(std::memory_order_relaxed); }
+
+private:
+    void run(std::stop_token token);
+
+    BackgroundSnapshotterOptions options_;
+    SpscQueue<EngineStateChanges> queue_;
+    EngineStateSnapshot image_; // snapshot thread only while running
+    std::atomic<std::uint64_t> applied_{0};
+    std::atomic<std::uint64_t> declined_{0};
+    std::jthread thread_; // last: it must see a fully built *this
+};
+
+} // namespace mdh::exchange::persistence
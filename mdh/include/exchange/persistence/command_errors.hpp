@@ -13,6 +13,8 @@ enum class CommandDecodeError {
     InvalidSide,
     InvalidOrderType,
     InvalidTimeInForce,
+    InvalidFlags,        // a mass cancel's flags set an unknown bit, or an absent field was non-zero
+    InvalidTradingPhase,
 };
 
 [[nodiscard]] constexpr std::string_view to_string(CommandDecodeError e) {
@@ -25,6 +27,8 @@ enum class CommandDecodeError {
         case CommandDecodeError::InvalidSide:        return "InvalidSide";
         case CommandDecodeError::InvalidOrderType:   return "InvalidOrderType";
         case CommandDecodeError::InvalidTimeInForce: return "InvalidTimeInForce";
+        case CommandDecodeError::InvalidFlags:       return "InvalidFlags";
+        case CommandDecodeError::InvalidTradingPhase: return "InvalidTradingPhase";
     }
     return "UnknownCommandDecodeError";
 }
@@ -28,6 +28,8 @@ namespace mdh::exchange::persistence {
 // itself carries no timestamp (the matching engine's determinism rule
 // forbids one being captured inside the matcher), so the journal format
 // doesn't invent one that doesn't exist in the domain type it's recording.
+// Time the engine does act on -- a ClockTick -- is a command's payload, and
+// a NewOrder's expiry is one of its fields.
 inline constexpr std::size_t HEADER_SIZE = 12;
 
 enum class CommandMessageType : std::uint8_t {
@@ -45,8 +47,23 @@ enum class CommandMessageType : std::uint8_t {
     // predate this type reject cleanly as InvalidMessageType instead of
     // misparsing.
     RegisterInstrument = 4,
+    // The one variable-length frame: a fixed prefix and then one fixed-size
+    // entry per quote level, as many as payload_size makes room for.
+    MassQuote = 5,
+    MassCancel = 6,
+    ClockTick = 7,
+    TradingPhase = 8,
 };
 
+// A mass cancel's optional filters travel as a flags byte plus fields that
+// are always present, so the frame stays fixed-size; a field whose flag is
+// clear must be zero, which keeps exactly one encoding per command.
+inline constexpr std::uint8_t MASS_CANCEL_HAS_INSTRUMENT = 0x01;
+inline constexpr std::uint8_t MASS_CANCEL_HAS_SIDE = 0x02;
+
+inline constexpr std::size_t MASS_QUOTE_PREFIX_SIZE = 8 + 4;         // account_id + instrument_id
+inline constexpr std::size_t MASS_QUOTE_ENTRY_SIZE = 8 + 1 + 8 + 8;  // client_order_id + side + price + quantity
+
 struct CommandHeader {
     CommandMessageType type;
     std::uint16_t payload_size;
@@ -60,9 +77,10 @@ struct CommandHeader {
 [[nodiscard]] constexpr std::size_t payload_size_for(CommandMessageType type) {
     switch (type) {
         // account_id(8) + client_order_id(8) + instrument_id(4) + side(1) +
-        // price(8) + quantity(8) + order_type(1) + time_in_force(1)
+        // price(8) + quantity(8) + order_type(1) + time_in_force(1) +
+        // expire_at(8) + stop_price(8)
         case CommandMessageType::NewOrder:
-            return 8 + 8 + 4 + 1 + 8 + 8 + 1 + 1; // 39
+            return 8 + 8 + 4 + 1 + 8 + 8 + 1 + 1 + 8 + 8; // 55
         // account_id(8) + client_order_id(8) + instrument_id(4)
         case CommandMessageType::CancelOrder:
             return 8 + 8 + 4; // 20
@@ -73,10 +91,29 @@ struct CommandHeader {
         // instrument_id(4)
         case CommandMessageType::RegisterInstrument:
             return 4;
+        // account_id(8) + instrument_id(4), before any entries: the size of
+        // a mass quote with none. mass_quote_payload_size() covers the rest.
+        case CommandMessageType::MassQuote:
+            return MASS_QUOTE_PREFIX_SIZE;
+        // account_id(8) + flags(1) + instrument_id(4) + side(1) +
+        // max_orders(4), 0 for no limit + before_exchange_order_id(8), 0 for
+        // no bound
+        case CommandMessageType::MassCancel:
+            return 8 + 1 + 4 + 1 + 4 + 8; // 26
+        // now(8)
+        case CommandMessageType::ClockTick:
+            return 8;
+        // instrument_id(4) + phase(1)
+        case CommandMessageType::TradingPhase:
+            return 4 + 1; // 5
     }
     return 0;
 }
 
+[[nodiscard]] constexpr std::size_t mass_quote_payload_size(std::size_t entries) {
+    return MASS_QUOTE_PREFIX_SIZE + entries * MASS_QUOTE_ENTRY_SIZE;
+}
+
 // The decoded form of a RegisterInstrument frame. Deliberately not an
 // alternative of ExchangeCommand: it is not something a client can send, it
 // mutates no book, and it produces no event -- keeping it out of that
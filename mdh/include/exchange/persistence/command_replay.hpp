@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <span>
 #include <string>
 #include <vector>
@@ -25,6 +26,21 @@ struct CommandReplayOptions {
     // this call site later without changing
     // run_command_replay()'s signature.
     bool stop_on_decode_error = true;
+
+    // Records the engine's state_hash() after every this-many commands, so
+    // that a replay can be checked against the run it reproduces -- or two
+    // replicas against each other -- at points along the way rather than
+    // only at the end, and a divergence located to within this many
+    // commands. Zero records none.
+    std::size_t hash_every_commands = 0;
+};
+
+// MatchingEngine::state_hash() as it stood after `commands` commands.
+struct StateHashCheckpoint {
+    std::uint64_t commands = 0;
+    std::uint64_t state_hash = 0;
+
+    bool operator==(const StateHashCheckpoint&) const = default;
 };
 
 struct CommandReplayOutcome {
@@ -38,6 +54,7 @@ struct CommandReplayOutcome {
     std::vector<ExchangeEvent> events; // every event emitted, across all commands, in order
     std::size_t commands_processed = 0;
     std::size_t instruments_registered = 0;
+    std::vector<StateHashCheckpoint> state_hashes; // per CommandReplayOptions::hash_every_commands
     bool stopped_early = false;
     std::string stop_reason;
 };
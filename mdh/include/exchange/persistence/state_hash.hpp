@@ -15,4 +15,12 @@ namespace mdh::exchange::persistence {
 
 [[nodiscard]] std::uint64_t hash_state_snapshot(const EngineStateSnapshot& snapshot);
 
+// The value MatchingEngine::state_hash() would have had in the state this
+// snapshot records, computed from scratch. The engine keeps that one current
+// as it goes; this is the slow way round, for checking the fast one and for
+// comparing a live engine against a snapshot taken elsewhere. A different
+// function from hash_state_snapshot() with a different value: that one
+// covers every field, this one what the books hold (see state_hash()).
+[[nodiscard]] std::uint64_t rolling_state_hash(const EngineStateSnapshot& snapshot);
+
 } // namespace mdh::exchange::persistence
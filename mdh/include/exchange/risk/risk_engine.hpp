@@ -1,5 +1,7 @@
 #pragma once
 
+#include <span>
+
 #include "common/types.hpp"
 #include "exchange/core/commands.hpp"
 #include "exchange/core/types.hpp"
@@ -19,6 +21,12 @@
 // balance check, though the size cap still applies to the new quantity. With
 // no open hold for the original id there is nothing to credit, so this class
 // passes and leaves the unknown-order rejection to the matching engine.
+//
+// A mass quote is checked as a whole, against the quote it replaces: every
+// standing level is either cancelled or replaced, and either releases its
+// hold in full, so the new quote's total -- cash for its bids, position for
+// its offers -- has to fit in what is available plus what those holds
+// free. The size cap applies per level, as it would to the orders they are.
 namespace mdh::exchange::risk {
 
 struct RiskLimits {
@@ -37,6 +45,10 @@ public:
     // resulting event. This only decides yes or no.
     [[nodiscard]] RejectReason check(const NewOrderCommand& command, const ledger::Ledger& ledger) const;
     [[nodiscard]] RejectReason check(const ReplaceOrderCommand& command, const ledger::Ledger& ledger) const;
+    // `standing` is the client order ids of the quote being replaced --
+    // MatchingEngine::live_quotes().
+    [[nodiscard]] RejectReason check(const MassQuoteCommand& command, const ledger::Ledger& ledger,
+                                     std::span<const ClientOrderId> standing) const;
 
 private:
     RiskLimits limits_;
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <concepts>
+#include <type_traits>
+#include <variant>
+
 #include "exchange/core/commands.hpp"
 #include "exchange/core/event_sink.hpp"
 #include "exchange/ledger/ledger.hpp"
@@ -41,17 +45,58 @@ public:
     RiskGatedEngine(MatchingEngine& engine, ledger::Ledger& ledger, RiskLimits limits = {});
 
     // Same signature as MatchingEngine::process() -- see class-level
-    // comment. NewOrderCommand and ReplaceOrderCommand are risk-checked
-    // before the matching engine sees them (CancelOrderCommand is not --
-    // see RiskEngine); a failed check emits OrderRejected via
-    // reject_new_order()/reject_replace_order() and never calls process().
+    // comment. NewOrderCommand, ReplaceOrderCommand and MassQuoteCommand
+    // are risk-checked before the matching engine sees them
+    // (neither cancel command is -- see RiskEngine); a failed check emits
+    // OrderRejected via reject_new_order()/reject_replace_order()/
+    // reject_mass_quote() and never calls process().
     // Every event actually emitted by the underlying MatchingEngine is fed
     // to `ledger` before being forwarded to `sink`, so a caller observing
     // `sink` sees ledger state that is already consistent with the event
     // just received.
+    //
+    // Templated on the sink like MatchingEngine::process(): the ledger
+    // update and the caller's sink are one inlined call per event rather
+    // than a std::function wrapping another. The EventSink overload is the
+    // same code, compiled once in the .cpp.
     void process(const ExchangeCommand& command, const EventSink& sink);
 
+    template <ExchangeEventSink Sink>
+        requires(!std::same_as<std::remove_cvref_t<Sink>, EventSink>)
+    void process(const ExchangeCommand& command, Sink&& sink) {
+        process_gated(command, sink);
+    }
+
 private:
+    // The pre-trade half: RejectReason::None if `command` may go on to the
+    // matching engine, otherwise why it may not. Not templated, because it
+    // emits nothing -- only the rejection it leads to does.
+    [[nodiscard]] RejectReason pre_trade_check(const ExchangeCommand& command) const;
+
+    template <class Sink>
+    void process_gated(const ExchangeCommand& command, Sink& sink) {
+        if (const RejectReason reason = pre_trade_check(command); reason != RejectReason::None) {
+            // Rejected before ever reaching process(): no OrderAccepted was
+            // emitted, so Ledger has nothing to reserve or release. The
+            // engine emits the rejection so event numbering stays gapless.
+            // Only new orders, replaces and mass quotes are ever checked, so
+            // nothing else can arrive here.
+            if (const auto* new_order = std::get_if<NewOrderCommand>(&command)) {
+                engine_.reject_new_order(*new_order, reason, sink);
+            } else if (const auto* replace = std::get_if<ReplaceOrderCommand>(&command)) {
+                engine_.reject_replace_order(*replace, reason, sink);
+            } else if (const auto* quote = std::get_if<MassQuoteCommand>(&command)) {
+                engine_.reject_mass_quote(*quote, reason, sink);
+            }
+            return;
+        }
+
+        engine_.process(command, [this, &sink](const ExchangeEvent& event) {
+            ledger_.apply(event);
+            sink(event);
+        });
+    }
+
     MatchingEngine& engine_;
     ledger::Ledger& ledger_;
     RiskEngine risk_;
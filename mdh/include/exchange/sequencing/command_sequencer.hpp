@@ -18,9 +18,10 @@
 // where the distinction properly lives; here, callers build an ordinary
 // command with any placeholder value and sequence() overwrites it.
 //
-// Single writer only, like the SPSC queue: the plain non-atomic counter
-// below depends on it, and the only intended caller is the pipeline's
-// submit(), which is producer-thread-only for the same reason.
+// Single writer only: the plain non-atomic counter below depends on it.
+// MatchingPipeline calls it on its matching thread, as each command is
+// dequeued; ShardedMatchingPipeline calls it in its producer-only submit(),
+// since it needs the number to route by before any shard sees the command.
 namespace mdh::exchange::sequencing {
 
 class CommandSequencer {
@@ -30,6 +31,11 @@ public:
     // monotonically increasing counter, then returns it.
     [[nodiscard]] ExchangeCommand sequence(ExchangeCommand command);
 
+    // The same, stamping `command` where it lies -- for a caller that is
+    // already holding it in place, such as a queue slot being consumed,
+    // and has no reason to move it out and back.
+    void sequence_in_place(ExchangeCommand& command);
+
     // The value the *next* call to sequence() will assign -- introspection
     // only (e.g. for a test asserting how many commands a sequencer has
     // handed out), never itself an authoritative sequence number.
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "common/event_ring.hpp"
+#include "common/thread_placement.hpp"
+#include "common/wait_strategy.hpp"
+
+// The far side of the matching thread: what it produces, handed to the
+// threads that act on it, with the matching thread's part reduced to
+// writing a ring slot.
+//
+// An EventFanout owns an EventRing and one thread per handler. Each handler
+// runs on its own thread, sees every published element in order, and
+// declares which other handlers must have finished with an element first --
+// nothing else orders them, so independent handlers run side by side on
+// separate cores and a slow one holds up only those declared after it. The
+// producer -- the matching thread -- claims a slot, fills it, and publishes
+// once per command; see EventRing for what happens when a handler falls a
+// whole ring behind.
+//
+// Handlers are added before start(). stop() lets every handler finish
+// everything published so far, then joins them: call it once the producer
+// has stopped, and what the producer published is guaranteed to have been
+// handled. MatchingPipeline::stop() followed by EventFanout::stop() is that
+// order.
+namespace mdh::exchange::sequencing {
+
+struct EventFanoutOptions {
+    // Ring slots. A power of two; rounded up to one. Sized for the worst lag
+    // of the slowest handler, since a full ring stalls the producer.
+    std::size_t capacity = 4096;
+
+    // How each handler's thread waits for the next element -- see
+    // WaitPolicy. Park by default: these threads are off the matching path,
+    // and an idle exchange should leave them asleep.
+    WaitPolicy wait = WaitPolicy::Park;
+};
+
+template <typename T>
+class EventFanout {
+public:
+    using Handler = std::function<void(const T&)>;
+
+    explicit EventFanout(const EventFanoutOptions& options = {}) : options_(options), ring_(options.capacity) {}
+
+    // Calls stop().
+    ~EventFanout() { stop(); }
+
+    EventFanout(const EventFanout&) = delete;
+    EventFanout& operator=(const EventFanout&) = delete;
+
+    // Before start() only. `name` names the thread, "mdh-<name>"; `after`
+    // lists handlers, by the id this returned for them, that see each
+    // element first.
+    std::size_t add_handler(std::string name, Handler handler, std::initializer_list<std::size_t> after = {},
+                            ThreadPlacement placement = {}) {
+        const std::size_t id = ring_.add_consumer(after, options_.wait);
+        handlers_.push_back(HandlerThread{.name = "mdh-" + std::move(name),
+                                          .handler = std::move(handler),
+                                          .placement = std::move(placement),
+                                          .thread = {}});
+        return id;
+    }
+
+    void start() {
+        for (std::size_t id = 0; id < handlers_.size(); ++id) {
+            handlers_[id].thread = std::jthread([this, id] { run(id); });
+        }
+    }
+
+    // Producer thread only -- see EventRing::claim() and publish().
+    [[nodiscard]] T& claim() { return ring_.claim(); }
+    void publish() { ring_.publish(); }
+
+    // Drains, then joins. Idempotent. The producer must be done publishing.
+    void stop() {
+        stopping_.store(true, std::memory_order_release);
+        ring_.notify_all(); // a parked handler must wake to see it
+        for (auto& handler : handlers_) {
+            if (handler.thread.joinable()) {
+                handler.thread.join();
+            }
+        }
+    }
+
+    [[nodiscard]] std::size_t published() const { return ring_.published(); }
+    [[nodiscard]] std::size_t handled(std::size_t id) const { return ring_.cursor(id); }
+    [[nodiscard]] std::size_t producer_stalls() const { return ring_.stalls(); }
+
+private:
+    // Up to this many elements per cursor advance, as MatchingPipeline's
+    // kDrainBatch: one release store and one round of wake-ups for a burst.
+    static constexpr std::size_t kHandleBatch = 64;
+
+    struct HandlerThread {
+        std::string name;
+        Handler handler;
+        ThreadPlacement placement;
+        std::jthread thread;
+    };
+
+    void run(std::size_t id) {
+        HandlerThread& self = handlers_[id];
+        place_current_thread(self.name, self.placement);
+        const auto stopping = [this] { return stopping_.load(std::memory_order_acquire); };
+        while (true) {
+            if (ring_.consume(id, kHandleBatch, self.handler) > 0) {
+                continue;
+            }
+            // Only once stop() is called is the published count final, and
+            // only the consumer's own cursor reaching it means drained: an
+            // upstream handler may still be working through the tail.
+            if (stopping() && ring_.caught_up(id)) {
+                break;
+            }
+            ring_.wait(id, [&] { return stopping(); });
+            if (stopping() && !ring_.caught_up(id)) {
+                std::this_thread::yield(); // draining behind an upstream handler that is still at work
+            }
+        }
+    }
+
+    EventFanoutOptions options_;
+    EventRing<T> ring_;
+    std::vector<HandlerThread> handlers_;
+    std::atomic<bool> stopping_{false};
+};
+
+} // namespace mdh::exchange::sequencing
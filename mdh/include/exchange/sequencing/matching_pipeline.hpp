@@ -4,11 +4,16 @@
 #include <chrono>
 #include <cstddef>
 #include <functional>
+#include <span>
 #include <stop_token>
 #include <thread>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
-#include "common/spsc_queue.hpp"
+#include "common/mpsc_queue.hpp"
+#include "common/thread_placement.hpp"
+#include "common/wait_strategy.hpp"
 #include "exchange/core/commands.hpp"
 #include "exchange/core/event_sink.hpp"
 #include "exchange/matching/matching_engine.hpp"
@@ -16,8 +21,8 @@
 #include "exchange/sequencing/command_sequencer.hpp"
 
 // The sequencer and matching thread: everything between "commands arrive
-// somehow" and the deterministic, single-threaded matching engine. It uses
-// SpscQueue unchanged.
+// somehow" and the deterministic, single-threaded matching engine. Commands
+// cross from their producers to the matching thread on an MpscQueue.
 //
 // ── Why this is not a DroppingQueue ───────────────────────────────────────
 // Market data can afford to drop a frame -- downstream it shows up as a
@@ -28,13 +33,23 @@
 //
 // So submit() reports a full queue as an explicit `false` instead of
 // swallowing it. Turning that into a client-facing "busy, retry" reply is
-// the gateway's business; this class stops at "was this command sequenced
-// and queued, yes or no."
+// the gateway's business; this class stops at "was this command queued,
+// yes or no."
 //
 // ── Threads ───────────────────────────────────────────────────────────────
-// One producer, one consumer, exactly as SpscQueue requires. submit() must
-// be called from a single thread: the sequencer's counter is a plain
-// non-atomic relying on that, the same way the queue's own head index does.
+// Any number of producers, one consumer. submit() is safe from any thread
+// and takes no lock: a producer claims its slot in the queue with a
+// compare-and-swap it retries only when another producer won that slot (see
+// MpscQueue), so the gateway's reader threads can all submit at once, none
+// waits on another, and a full queue is reported at once.
+//
+// The sequencer runs on the consumer side, as each command is dequeued. The
+// order in which producers claimed slots is the order the matching thread
+// pops them, so numbering them there gives exactly the gapless, submission-
+// ordered stream numbering them in submit() did -- without an atomic
+// counter, and without a producer ever consuming a number for a command the
+// queue then turned away. CommandSequencer keeps its single-writer contract;
+// the writer is now the matching thread.
 //
 // The matching thread is started in the constructor and joined in stop() or
 // the destructor. It is the only consumer and the only thread that ever
@@ -46,6 +61,13 @@
 // no buffering or thread-hopping on the way out -- a caller that needs
 // events on another thread must arrange that itself, for instance by having
 // its sink push onto a queue of its own.
+//
+// ── Sink and processor types ──────────────────────────────────────────────
+// BasicMatchingPipeline takes both as template parameters, so a caller that
+// names its own types gets the whole chain -- processor, risk, engine, sink
+// -- compiled into one matching loop with no type-erased call per event
+// (see event_sink.hpp). MatchingPipeline is the std::function form every
+// caller used before, and is compiled once in matching_pipeline.cpp.
 namespace mdh::exchange::sequencing {
 
 struct MatchingPipelineOptions {
@@ -55,58 +77,93 @@ struct MatchingPipelineOptions {
     // rejected. Empty means an engine that rejects everything, which is the
     // right default for a class whose job is transport: a caller that has
     // not said what it trades has not finished configuring it.
-    std::vector<InstrumentId> instruments;
+    std::vector<InstrumentId> instruments{};
 
     // Passed to the engine -- see kDefaultExpectedRestingOrders for what it
     // buys and what guessing low costs.
     std::size_t expected_resting_orders = MatchingEngine::kDefaultExpectedRestingOrders;
 
+    // What the matching thread does when the queue is empty -- see
+    // WaitPolicy. SpinThenYield keeps a core busy but answers quickly; Park
+    // costs a futex wake on the first command after a lull but leaves an
+    // idle exchange idle.
+    WaitPolicy idle_wait = WaitPolicy::SpinThenYield;
+
+    // Where the matching thread runs -- see thread_placement.hpp. It names
+    // itself "mdh-matching" either way; the default leaves cores and
+    // scheduling to the OS.
+    ThreadPlacement placement{};
+
     // An artificial pause after each command, so a test can exercise
     // submit()'s backpressure path deterministically instead of hoping the
     // OS scheduler produces a slow enough consumer. Zero by default.
     std::chrono::microseconds matching_delay{0};
 };
 
-class MatchingPipeline {
+// The processor a BasicMatchingPipeline uses when given none: call its own
+// engine directly.
+struct DirectToEngine {};
+
+template <ExchangeEventSink Sink, class ProcessorT = DirectToEngine>
+class BasicMatchingPipeline {
 public:
     // A stand-in for calling the engine directly on the matching thread, so
     // a caller can wrap it with extra behaviour -- RiskGatedEngine, which
     // adds risk checks and ledger updates -- without changing any of the
-    // threading or queueing guarantees here. It has the same signature as
-    // both engines' own process(), so either adapts with a forwarding
-    // lambda.
-    using Processor = std::function<void(const ExchangeCommand&, const EventSink&)>;
+    // threading or queueing guarantees here. It is called as
+    // `processor(command, sink)`, the same shape as both engines' own
+    // process(), so either adapts with a forwarding lambda.
+    using Processor = ProcessorT;
 
     // If `processor` is supplied it runs on the matching thread for every
-    // command dequeued, in place of the engine. Null means call the engine
-    // directly.
-    explicit MatchingPipeline(EventSink sink, const MatchingPipelineOptions& options = {},
-                               Processor processor = nullptr);
+    // command dequeued, in place of the engine. DirectToEngine, or a null
+    // std::function, means call the engine directly.
+    explicit BasicMatchingPipeline(Sink sink, const MatchingPipelineOptions& options = {}, Processor processor = {})
+        : sink_(std::move(sink)), queue_(options.queue_capacity),
+          engine_(std::span<const InstrumentId>(options.instruments), options.expected_resting_orders),
+          processor_(std::move(processor)), idle_wait_(options.idle_wait), options_(options) {
+        matching_thread_ = std::jthread([this] { run(); });
+    }
 
     // Asks the matching thread to drain and stop, then joins it.
-    ~MatchingPipeline();
-
-    MatchingPipeline(const MatchingPipeline&) = delete;
-    MatchingPipeline& operator=(const MatchingPipeline&) = delete;
-    MatchingPipeline(MatchingPipeline&&) = delete;
-    MatchingPipeline& operator=(MatchingPipeline&&) = delete;
-
-    // Producer side only. Gives `command` its authoritative sequence number
-    // and queues it for the matching thread. Returns false, having sequenced
-    // and processed nothing, if the queue is full -- see the class comment
-    // on why that is a rejection rather than a silent drop.
-    [[nodiscard]] bool submit(ExchangeCommand command);
+    ~BasicMatchingPipeline() { stop(); }
+
+    BasicMatchingPipeline(const BasicMatchingPipeline&) = delete;
+    BasicMatchingPipeline& operator=(const BasicMatchingPipeline&) = delete;
+    BasicMatchingPipeline(BasicMatchingPipeline&&) = delete;
+    BasicMatchingPipeline& operator=(BasicMatchingPipeline&&) = delete;
+
+    // Any thread. Queues `command` for the matching thread, which gives it
+    // its authoritative sequence number when it dequeues it. Returns false,
+    // having queued nothing, if the queue is full -- see the class comment
+    // on why that is a rejection rather than a silent drop. A rejected
+    // command never reaches the sequencer, so it leaves no gap in the
+    // sequence stream.
+    [[nodiscard]] bool submit(ExchangeCommand command) {
+        if (queue_.try_push(std::move(command))) {
+            idle_wait_.notify(); // free unless the matching thread may be parked
+            return true;
+        }
+        commands_rejected_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
 
     // Asks the matching thread to stop once it has processed everything
     // already queued -- never mid-drain -- then joins it. Safe to call more
     // than once, including from the destructor. Separate from the destructor
     // so a caller can shut down and still call snapshot() afterwards.
-    void stop();
+    void stop() {
+        stop_source_.request_stop();
+        idle_wait_.notify(); // a parked matching thread must wake to see the stop
+        if (matching_thread_.joinable()) {
+            matching_thread_.join();
+        }
+    }
 
     // Only safe after stop() has returned. Joining the matching thread is
     // what makes reading the engine from another thread safe; calling this
     // while it still runs is a data race, unguarded at runtime, just as
-    // SpscQueue does not check its own single-producer contract.
+    // MpscQueue does not check its own single-consumer contract.
     [[nodiscard]] EngineStateSnapshot snapshot() const { return engine_.snapshot(); }
 
     // Best-effort introspection, safe from any thread, with the same caveat
@@ -118,19 +175,74 @@ public:
     }
     [[nodiscard]] std::size_t commands_rejected() const { return commands_rejected_.load(std::memory_order_relaxed); }
 
+    // How many times the matching thread has gone to sleep waiting for
+    // work. Always 0 unless idle_wait is Park.
+    [[nodiscard]] std::size_t idle_parks() const { return idle_wait_.park_count(); }
+
 private:
-    EventSink sink_;
-    CommandSequencer sequencer_; // producer thread only
-    SpscQueue<ExchangeCommand> queue_;
+    // Commands are taken off the queue in batches of up to kDrainBatch and
+    // processed where they lie in their slots, so a burst costs one release
+    // of the queue's head for the whole batch and no move of each command
+    // out of the queue. The batch is small enough that a producer waiting on
+    // a full queue sees room again promptly.
+    static constexpr std::size_t kDrainBatch = 64;
+
+    void run() {
+        place_current_thread("mdh-matching", options_.placement);
+        const auto token = stop_source_.get_token();
+        while (true) {
+            const std::size_t drained = queue_.consume(kDrainBatch, [this](ExchangeCommand& command) {
+                if (options_.matching_delay.count() > 0) {
+                    std::this_thread::sleep_for(options_.matching_delay); // simulated slow matching core, see MatchingPipelineOptions
+                }
+                sequencer_.sequence_in_place(command);
+                process_one(command);
+            });
+            if (drained == 0) {
+                if (token.stop_requested()) {
+                    break; // stop requested and the queue is now empty: drain complete
+                }
+                idle_wait_.wait_until([&] { return queue_.size() > 0 || token.stop_requested(); });
+                continue;
+            }
+            commands_processed_.fetch_add(drained, std::memory_order_relaxed);
+        }
+    }
+
+    void process_one(const ExchangeCommand& command) {
+        if constexpr (std::is_same_v<Processor, DirectToEngine>) {
+            engine_.process(command, sink_);
+        } else {
+            if constexpr (std::is_constructible_v<bool, const Processor&>) {
+                if (!processor_) {
+                    engine_.process(command, sink_); // a null std::function: the pre-template default
+                    return;
+                }
+            }
+            processor_(command, sink_);
+        }
+    }
+
+    Sink sink_;
+    CommandSequencer sequencer_; // matching thread only, like engine_
+    MpscQueue<ExchangeCommand> queue_;
     MatchingEngine engine_; // matching thread only while running; see snapshot()
-    Processor processor_;   // matching thread only, like engine_
+    [[no_unique_address]] Processor processor_; // matching thread only, like engine_
+    WaitStrategy idle_wait_;                    // the matching thread waits, submit() and stop() notify
 
     std::atomic<std::size_t> commands_processed_{0}; // matching thread writes
-    std::atomic<std::size_t> commands_rejected_{0};  // producer thread writes
+    std::atomic<std::size_t> commands_rejected_{0};  // any producer writes
 
     MatchingPipelineOptions options_;
     std::stop_source stop_source_;
     std::jthread matching_thread_; // last: it must see a fully built *this
 };
 
+// The type-erased form: any sink, any processor, at one indirect call
+// each. What every caller used before BasicMatchingPipeline existed.
+using MatchingPipeline =
+    BasicMatchingPipeline<EventSink, std::function<void(const ExchangeCommand&, const EventSink&)>>;
+
+extern template class BasicMatchingPipeline<EventSink, std::function<void(const ExchangeCommand&, const EventSink&)>>;
+
 } // namespace mdh::exchange::sequencing
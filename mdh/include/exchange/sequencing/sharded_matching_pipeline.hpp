@@ -0,0 +1,212 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+#include "common/spsc_queue.hpp"
+#include "common/wait_strategy.hpp"
+#include "exchange/core/commands.hpp"
+#include "exchange/core/event_sink.hpp"
+#include "exchange/core/events.hpp"
+#include "exchange/matching/matching_engine.hpp"
+#include "exchange/matching/state_snapshot.hpp"
+#include "exchange/sequencing/command_sequencer.hpp"
+
+// MatchingPipeline split across several matching threads, one per shard,
+// each owning a disjoint slice of the instrument universe.
+//
+// A book only ever needs its own instrument's commands, so nothing stops
+// two books being matched on two cores at once -- except that everything
+// downstream was built on one gapless, ordered event stream. This class
+// keeps that stream exactly as it was and parallelises only what sits
+// behind it.
+//
+// ── Shape ─────────────────────────────────────────────────────────────────
+//
+//   submit() ──► CommandSequencer ──┬─► [SpscQueue] ─► shard 0: engine ─► [outbox] ─┐
+//   (producer)   one global order   ├─► [SpscQueue] ─► shard 1: engine ─► [outbox] ─┼─► merge ─► sink
+//                                   └─► [route queue: which shard, in order] ───────┘
+//
+// An instrument's shard is its id modulo the shard count, fixed for the
+// pipeline's lifetime. Each shard's engine is built with only its own
+// instruments, so a command naming an instrument nobody trades is still
+// rejected the ordinary way, by whichever shard its id maps to.
+//
+// ── Why the merge is deterministic ────────────────────────────────────────
+// The producer sequences every command once, globally, exactly as
+// MatchingPipeline does, and records which shard it sent each one to on a
+// route queue. The merge thread walks that route queue in order and takes
+// the next batch of events from the named shard's outbox. A shard handles
+// its own commands in order, so its outbox is in order too, and the merged
+// stream comes out in global command order however the shards happen to
+// interleave in time.
+//
+// Each shard's engine numbers its own events, so the merge thread restamps
+// event_sequence from one counter of its own. The sink sees the same
+// gapless sequence a single engine would give it.
+//
+// Exchange order ids are numbered per shard from disjoint spaces (see
+// ExchangeOrderIdSpace): deterministic for a given shard
+// count, and identical to MatchingPipeline's with one shard. Replaying a
+// journal through a pipeline with the same shard count therefore ends in
+// the same snapshot and the same state hash.
+//
+// ── What a shard does not see ─────────────────────────────────────────────
+// Live orders are keyed on (account, client order id) per engine, so a
+// client order id reused by one account on two instruments is a duplicate
+// only if both instruments share a shard. MatchingPipeline, and this class
+// with one shard, reject the second with DuplicateOrderId; with more, the
+// same two commands may both rest. This is the one way the two pipelines
+// differ, and it is deliberate: only the shard knows when an order dies
+// (filled, cancelled, expired), so a universe-wide check made at submit()
+// would either never forget an id or need a round trip back from every
+// shard before each NewOrder. A caller that needs the check across the
+// whole universe has to make it before submit(), or run one shard.
+// test_sharded_matching_pipeline.cpp pins the behaviour down.
+//
+// A MassCancelCommand that names no instrument, and a ClockTickCommand, are
+// the commands every shard has to see. Each is sequenced once and handed to
+// each shard in turn, with one route per shard; the merge counts it as
+// processed only after the last. The cancels either one causes therefore
+// arrive shard by shard, rather than in the single pass one engine would
+// make -- the same set of events, in an order that is still fixed for a
+// given shard count.
+//
+// There is no Processor hook. RiskGatedEngine holds one ledger per account
+// across every instrument, and checking it from several threads at once
+// reopens the double-spend race ledger.hpp describes. Risk-gated flow stays
+// on MatchingPipeline until the ledger itself is partitioned.
+//
+// ── Threads ───────────────────────────────────────────────────────────────
+// One producer, as with MatchingPipeline: submit() is single-threaded. One
+// thread per shard, plus one merge thread, which is the only thread that
+// ever calls the sink.
+//
+// Every one of them waits with a WaitStrategy of its own, all on the one
+// idle_wait policy. A shard waits for a command or for room in its outbox,
+// so submit() and the merge wake it; the merge waits for a route or for the
+// batch a route names, so submit() and the shards wake it. stop() wakes
+// them all.
+namespace mdh::exchange::sequencing {
+
+struct ShardedMatchingPipelineOptions {
+    // Zero is treated as one.
+    std::size_t shard_count = 1;
+
+    // Per shard. The route queue is sized to match all of them together.
+    std::size_t queue_capacity = 1024;
+
+    // The whole universe; each shard takes the instruments that map to it.
+    std::vector<InstrumentId> instruments{};
+
+    // Across every shard, divided between them in proportion to how many
+    // instruments each one holds.
+    std::size_t expected_resting_orders = MatchingEngine::kDefaultExpectedRestingOrders;
+
+    // What every shard thread and the merge thread do with nothing to take
+    // -- see MatchingPipelineOptions::idle_wait. Park matters more here than
+    // there: a pipeline of n shards left spinning idle holds n + 1 cores.
+    WaitPolicy idle_wait = WaitPolicy::SpinThenYield;
+};
+
+class ShardedMatchingPipeline {
+public:
+    explicit ShardedMatchingPipeline(EventSink sink, const ShardedMatchingPipelineOptions& options = {});
+
+    // Drains and stops every thread.
+    ~ShardedMatchingPipeline();
+
+    ShardedMatchingPipeline(const ShardedMatchingPipeline&) = delete;
+    ShardedMatchingPipeline& operator=(const ShardedMatchingPipeline&) = delete;
+    ShardedMatchingPipeline(ShardedMatchingPipeline&&) = delete;
+    ShardedMatchingPipeline& operator=(ShardedMatchingPipeline&&) = delete;
+
+    [[nodiscard]] static std::size_t shard_of(InstrumentId instrument_id, std::size_t shard_count) {
+        return static_cast<std::size_t>(instrument_id) % shard_count;
+    }
+
+    // Producer side only, with MatchingPipeline::submit()'s contract: false
+    // means nothing was sequenced or queued. That happens when the target
+    // shard's queue is full, even if the others have room -- and for a
+    // mass cancel of every instrument, when any shard's queue is. Such a
+    // mass cancel's max_orders applies in each shard separately, and so
+    // does its before_exchange_order_id -- which, since each shard hands
+    // out its own ids, only bounds a shard exactly if it came from that
+    // shard's engine.
+    [[nodiscard]] bool submit(ExchangeCommand command);
+
+    // Stops once every queued command has been matched and every event
+    // delivered. Safe to call more than once.
+    void stop();
+
+    // Only safe after stop() has returned. The shards' snapshots merged
+    // into one, instruments in ascending id order as ever.
+    [[nodiscard]] EngineStateSnapshot snapshot() const;
+
+    [[nodiscard]] std::size_t shard_count() const { return shards_.size(); }
+
+    // The value the next submit() will assign -- what a caller writing a
+    // journal alongside this pipeline records as the command's sequence.
+    [[nodiscard]] CommandSequence next_sequence() const { return sequencer_.next_sequence(); }
+
+    // Commands whose events have all reached the sink.
+    [[nodiscard]] std::size_t commands_processed() const {
+        return commands_processed_.load(std::memory_order_acquire);
+    }
+    [[nodiscard]] std::size_t commands_rejected() const { return commands_rejected_.load(std::memory_order_relaxed); }
+
+    // How many times a shard thread or the merge thread has gone to sleep
+    // waiting, all of them together. Always 0 unless idle_wait is Park.
+    [[nodiscard]] std::size_t idle_parks() const;
+
+private:
+    // One command's worth of events, as a shard hands them to the merge.
+    using EventBatch = std::vector<ExchangeEvent>;
+
+    struct Shard {
+        Shard(std::span<const InstrumentId> universe, std::size_t expected_resting_orders,
+              ExchangeOrderIdSpace id_space, std::size_t queue_capacity, WaitPolicy idle_wait);
+
+        SpscQueue<ExchangeCommand> inbox;  // producer -> shard
+        SpscQueue<EventBatch> outbox;      // shard -> merge
+        // Emptied batches going back the other way, so a shard in steady
+        // state reuses a handful of vectors instead of allocating one per
+        // command.
+        SpscQueue<EventBatch> spare;       // merge -> shard
+        MatchingEngine engine;             // its thread only while running
+        WaitStrategy wait;                 // its thread waits, submit(), the merge and stop() notify
+        std::jthread thread;
+    };
+
+    // submit() for the one command every shard must run: a mass cancel
+    // naming no instrument. See the class comment.
+    [[nodiscard]] bool broadcast(ExchangeCommand command);
+
+    void run_shard(Shard& shard, std::stop_token token);
+    void run_merge(std::stop_token token);
+
+    EventSink sink_;
+    CommandSequencer sequencer_; // producer thread only
+    std::vector<std::unique_ptr<Shard>> shards_;
+    // Which shard each sequenced command went to, in sequence order. A
+    // command sent to several shards has one route per shard, all but the
+    // last marked kRouteContinues.
+    SpscQueue<std::uint32_t> routes_;
+    static constexpr std::uint32_t kRouteContinues = 0x8000'0000u;
+    WaitStrategy merge_wait_; // the merge thread waits, submit(), the shards and stop() notify
+
+    EventSequence next_event_sequence_ = 1; // merge thread only
+    std::atomic<std::size_t> commands_processed_{0};
+    std::atomic<std::size_t> commands_rejected_{0};
+
+    std::stop_source stop_source_;
+    std::jthread merge_thread_; // last: it must see a fully built *this
+};
+
+} // namespace mdh::exchange::sequencing
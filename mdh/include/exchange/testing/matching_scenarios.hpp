@@ -2,6 +2,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <variant>
 #include <vector>
 
 #include "common/types.hpp"
@@ -11,8 +12,8 @@
 
 // The small amount of scaffolding every matching-engine benchmark and the
 // stress harness both need -- command builders, a shared
-// discard sink, and book-seeding helpers -- in one place instead of copied
-// into each benchmark file.
+// discard sink, an event-collecting sink for tests, and book-seeding
+// helpers -- in one place instead of copied into each file.
 //
 // Header-only and test/benchmark-only. Nothing under src/ or apps/ includes
 // this, and it changes no production behaviour: everything here drives
@@ -36,6 +37,59 @@ namespace mdh::exchange::testing {
     return sink;
 }
 
+// The opposite of discard_events(): keeps every event it is handed, in
+// order, for a test to look through afterwards. at<T>() insists on the
+// event type at one position, so a test that expects "accepted, then
+// traded" fails right at the first event that is something else; of<T>()
+// and count<T>() pick out one type wherever it falls.
+class CollectingSink {
+public:
+    EventSink sink() {
+        return [this](const ExchangeEvent& ev) { events.push_back(ev); };
+    }
+
+    template <class T>
+    [[nodiscard]] const T& at(std::size_t index) const {
+        return std::get<T>(events.at(index));
+    }
+
+    template <class T>
+    [[nodiscard]] std::size_t count() const {
+        std::size_t n = 0;
+        for (const auto& ev : events) {
+            n += std::holds_alternative<T>(ev) ? 1 : 0;
+        }
+        return n;
+    }
+
+    // Every event of type T, in the order they arrived.
+    template <class T>
+    [[nodiscard]] std::vector<T> of() const {
+        std::vector<T> out;
+        for (const auto& ev : events) {
+            if (const auto* typed = std::get_if<T>(&ev)) {
+                out.push_back(*typed);
+            }
+        }
+        return out;
+    }
+
+    // The client order id of every OrderCancelled, in the order they were
+    // cancelled -- which is what a mass cancel or an expiry sweep is tested
+    // on.
+    [[nodiscard]] std::vector<ClientOrderId> cancelled_ids() const {
+        std::vector<ClientOrderId> ids;
+        for (const auto& ev : events) {
+            if (const auto* cancelled = std::get_if<OrderCancelled>(&ev)) {
+                ids.push_back(cancelled->client_order_id);
+            }
+        }
+        return ids;
+    }
+
+    std::vector<ExchangeEvent> events;
+};
+
 // MatchingEngine rejects commands on instruments it was not told about, so
 // every test and benchmark has to state its universe. Single-instrument
 // callers pass their own id directly (`MatchingEngine engine{kInstrument}`);
@@ -63,7 +117,8 @@ struct SequentialIds {
 [[nodiscard]] inline NewOrderCommand new_order(CommandSequence command_sequence, AccountId account_id,
                                                 ClientOrderId client_order_id, InstrumentId instrument_id, Side side,
                                                 Price price, Quantity quantity,
-                                                TimeInForce time_in_force = TimeInForce::GTC) {
+                                                TimeInForce time_in_force = TimeInForce::GTC,
+                                                Timestamp expire_at = 0) {
     return NewOrderCommand{
         .command_sequence = command_sequence,
         .account_id = account_id,
@@ -74,9 +129,23 @@ struct SequentialIds {
         .quantity = quantity,
         .order_type = OrderType::Limit,
         .time_in_force = time_in_force,
+        .expire_at = expire_at,
     };
 }
 
+// A stop-limit order: held off the book until a trade prints at
+// `stop_price` or through it, then entered as a limit order at `price`.
+[[nodiscard]] inline NewOrderCommand stop_limit_order(CommandSequence command_sequence, AccountId account_id,
+                                                       ClientOrderId client_order_id, InstrumentId instrument_id,
+                                                       Side side, Price stop_price, Price price, Quantity quantity,
+                                                       TimeInForce time_in_force = TimeInForce::GTC) {
+    NewOrderCommand command =
+        new_order(command_sequence, account_id, client_order_id, instrument_id, side, price, quantity, time_in_force);
+    command.order_type = OrderType::StopLimit;
+    command.stop_price = stop_price;
+    return command;
+}
+
 [[nodiscard]] inline CancelOrderCommand cancel_order(CommandSequence command_sequence, AccountId account_id,
                                                       ClientOrderId client_order_id, InstrumentId instrument_id) {
     return CancelOrderCommand{
@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <deque>
 #include <limits>
 #include <map>
 #include <optional>
@@ -214,6 +215,13 @@ struct WorkloadMix {
     [[nodiscard]] static WorkloadMix realistic() { return WorkloadMix{}; }
     [[nodiscard]] static WorkloadMix all_resting() { return WorkloadMix{100, 0, 0, 0, 0}; }
     [[nodiscard]] static WorkloadMix all_crossing() { return WorkloadMix{0, 100, 0, 0, 0}; }
+    // For a drifting market. The realistic mix only holds its depth steady
+    // because its crossing flow keeps eating the same band of prices; once
+    // the mid moves, liquidity left behind is never crossed again, and the
+    // book grows without bound unless cancels take up the slack. Three more
+    // points of cancels is where, measured at half a tick of drift per ten
+    // operations, depth holds at a few hundred orders instead of climbing.
+    [[nodiscard]] static WorkloadMix trending() { return WorkloadMix{37, 25, 28, 5, 5}; }
 };
 
 struct WorkloadConfig {
@@ -261,6 +269,18 @@ struct WorkloadConfig {
     // and non-zero for the stress harness, where re-touching dead ids is
     // exactly the interesting case.
     unsigned stale_reference_pct = 0;
+    // How far every instrument's reference mid moves per thousand
+    // operations, in ticks; negative drifts down. Zero keeps the market
+    // flat, which is what every recorded baseline assumes. A trending
+    // market is what walks a book out of whatever band its ladder first
+    // anchored on, so this is the knob that exercises re-centering.
+    //
+    // A drifting workload also cancels differently: in a trending market a
+    // quote is pulled because the price has moved away from it, so each
+    // cancel takes the oldest live order rather than a random one. Random
+    // cancels would leave a trail of orders stretching all the way back to
+    // the starting price, which no real book carries.
+    Price drift_ticks_per_thousand_operations = 0;
     WorkloadMix mix{};
 
     // The instruments this workload trades, numbered 1..instrument_count.
@@ -347,6 +367,11 @@ struct Workload {
     std::vector<ExchangeEvent> events;
     const EventSink sink = [&events](const ExchangeEvent& event) { events.push_back(event); };
 
+    // Every order that has rested, oldest first, for a drifting workload's
+    // cancels. Entries for orders that have since gone are skipped lazily.
+    const bool drifting = config.drift_ticks_per_thousand_operations != 0;
+    std::deque<ExchangeOrderId> arrivals;
+
     // A short ring of recently-retired order references, so the stress
     // harness can aim commands at ids the engine has already forgotten.
     struct RetiredRef {
@@ -381,7 +406,9 @@ struct Workload {
         std::visit(
             [&](const auto& cmd) {
                 using T = std::decay_t<decltype(cmd)>;
-                owner_account = cmd.account_id;
+                if constexpr (!std::is_same_v<T, ClockTickCommand> && !std::is_same_v<T, TradingPhaseCommand>) {
+                    owner_account = cmd.account_id;
+                }
                 if constexpr (std::is_same_v<T, NewOrderCommand>) {
                     owner_client_order_id = cmd.client_order_id;
                 } else if constexpr (std::is_same_v<T, ReplaceOrderCommand>) {
@@ -404,6 +431,9 @@ struct Workload {
                         live.set_client_order_id(ev.exchange_order_id, ev.new_client_order_id);
                     } else if constexpr (std::is_same_v<T, BookOrderAdded>) {
                         depth.on_added(ev.instrument_id, ev.side, ev.price);
+                        if (drifting) {
+                            arrivals.push_back(ev.exchange_order_id);
+                        }
                         live.insert(LiveOrderRecord{
                             .exchange_order_id = ev.exchange_order_id,
                             .client_order_id = owner_client_order_id,
@@ -434,8 +464,11 @@ struct Workload {
     const auto account_of = [&](std::uint64_t draw) {
         return static_cast<AccountId>(1 + draw % config.account_count);
     };
+    // Only ever moves during the operation phase; the seed book is built
+    // around the starting mid.
+    Price drift = 0;
     const auto mid_of = [&](InstrumentId instrument_id) {
-        return config.base_price + static_cast<Price>(instrument_id - 1) * config.instrument_price_offset;
+        return config.base_price + static_cast<Price>(instrument_id - 1) * config.instrument_price_offset + drift;
     };
 
     // A price that cannot cross: strictly inside its own side relative to
@@ -501,6 +534,7 @@ struct Workload {
     const unsigned replace_edge = cancel_edge + mix.replace_pct;
 
     for (std::size_t op = 0; op < config.operation_count; ++op) {
+        drift = static_cast<Price>(op) * config.drift_ticks_per_thousand_operations / 1'000;
         const auto roll = static_cast<unsigned>(rng.below(100));
         const InstrumentId instrument_id = instrument_of(rng.next());
         const Side side = (rng.next() & 1U) != 0 ? Side::Buy : Side::Sell;
@@ -549,6 +583,14 @@ struct Workload {
                 target_client_order_id = ref.client_order_id;
                 target_instrument = ref.instrument_id;
                 ++workload.counts.stale_references;
+            } else if (drifting) {
+                while (live.find(arrivals.front()) == nullptr) {
+                    arrivals.pop_front();
+                }
+                const LiveOrderRecord& record = *live.find(arrivals.front());
+                target_account = record.account_id;
+                target_client_order_id = record.client_order_id;
+                target_instrument = record.instrument_id;
             } else {
                 const auto& record = live.at(rng.below(live.size()));
                 target_account = record.account_id;
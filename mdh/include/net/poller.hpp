@@ -0,0 +1,84 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace mdh::net {
+
+// One readiness report from Poller::wait(): which registration it is for,
+// by the key it was added with, and what that descriptor is ready for.
+struct PollEvent {
+    std::uint64_t key = 0;
+    bool readable = false;
+    bool writable = false;
+    bool hangup = false; // peer closed, or the descriptor errored -- a read will say which
+};
+
+// RAII wrapper over an edge-triggered Linux epoll set, plus the one thing
+// an event loop needs besides its sockets: a way for another thread to
+// interrupt wait(). That is an eventfd registered alongside them, which
+// wait() drains itself and never reports.
+//
+// ── Edge-triggered ────────────────────────────────────────────────────────
+// Descriptors are added with EPOLLET unless asked otherwise (see add()), so
+// wait() reports a descriptor when it *becomes* ready, not for as long as it
+// stays ready. The caller's half of that bargain is to read until the socket
+// says WouldBlock before waiting again -- or to remember it still has work
+// there, since no further event will come until new data arrives. In
+// return, a socket with a full send buffer costs nothing until it drains,
+// and one readiness event is never delivered to a loop twice.
+//
+// Linux only, like the rest of the epoll API. Elsewhere is_open() is false
+// and every operation fails; a caller wanting portability checks is_open()
+// and falls back to something else (see OrderEntryGatewayOptions::
+// io_threads).
+//
+// Not copyable (owns two fds); not movable either, since a registration
+// made from another thread holds on to it.
+class Poller {
+public:
+    // The most events one wait() reports. The rest stay queued in the
+    // kernel for the next call, so this bounds a stack array, not what a
+    // loop can be told about.
+    static constexpr std::size_t kMaxEvents = 256;
+
+    Poller();
+    ~Poller();
+
+    Poller(const Poller&) = delete;
+    Poller& operator=(const Poller&) = delete;
+
+    [[nodiscard]] bool is_open() const { return epoll_fd_ >= 0 && wake_fd_ >= 0; }
+
+    // Watches `fd` for readability and, if `writable`, writability,
+    // reporting it under `key`. Safe from any thread, including while
+    // another is inside wait(). Returns false on failure. `edge_triggered`
+    // false is for a descriptor whose owner cannot tell when it has drained
+    // it -- a listening TcpSocket, whose accept() reports "none pending" and
+    // failure alike -- and is then reported on every wait() until it has.
+    [[nodiscard]] bool add(int fd, std::uint64_t key, bool writable, bool edge_triggered = true);
+
+    // Stops watching `fd`. Closing the fd has the same effect; this is for
+    // a descriptor that stays open after its owner is done with it.
+    void remove(int fd);
+
+    // Waits up to `timeout` (negative waits indefinitely, zero not at all)
+    // for readiness, filling `out` with up to out.size() events -- at most
+    // kMaxEvents of them per call. Returns how many were written. A wake()
+    // ends the wait early and counts for nothing in the result -- zero
+    // events is a normal return.
+    std::size_t wait(std::span<PollEvent> out, std::chrono::milliseconds timeout);
+
+    // Any thread. Makes the current wait() return, or the next one if none
+    // is in progress. Wakes coalesce: several before the loop gets round to
+    // waiting cost it one early return.
+    void wake();
+
+private:
+    int epoll_fd_ = -1;
+    int wake_fd_ = -1;
+};
+
+} // namespace mdh::net
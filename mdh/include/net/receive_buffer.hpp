@@ -0,0 +1,98 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace mdh::net {
+
+// The bytes a stream reader has received but not yet framed, kept so that
+// framing costs time linear in the bytes received.
+//
+// TCP hands over bytes, not messages, so a reader accumulates them until a
+// whole frame is there. The obvious buffer -- a std::vector appended to at
+// the back and erased from the front after every frame -- moves everything
+// still buffered on every frame taken: a read() that brought in a few
+// hundred small frames moves the rest of them a few hundred times over, and
+// that is quadratic in the size of the read.
+//
+// Here the front is a cursor instead. consume() only advances it; the bytes
+// behind it are dead, and are reclaimed by compacting -- one memmove of
+// whatever is still unconsumed down to the start -- only when a write needs
+// room at the back. A reader that frames everything it can after each read
+// is left with less than one frame unconsumed, so each compaction moves at
+// most one partial frame, and an empty buffer is reset to the start for
+// free.
+//
+// writable()/commit() let a reader receive straight into the buffer, and
+// readable() is always one contiguous span, so a decoder frames directly off
+// it with no copy and no wraparound to stitch. The storage grows only when a
+// single frame will not fit in it, so after the first few reads it stays the
+// same size for the life of the connection.
+//
+// One thread at a time; nothing here is synchronised.
+class ReceiveBuffer {
+public:
+    explicit ReceiveBuffer(std::size_t initial_capacity = 4096) : storage_(std::max<std::size_t>(initial_capacity, 1)) {}
+
+    // Everything received and not yet consumed, oldest first.
+    [[nodiscard]] std::span<const std::byte> readable() const {
+        return std::span<const std::byte>(storage_).subspan(head_, tail_ - head_);
+    }
+    [[nodiscard]] std::size_t size() const { return tail_ - head_; }
+    [[nodiscard]] bool empty() const { return head_ == tail_; }
+    [[nodiscard]] std::size_t capacity() const { return storage_.size(); }
+
+    // Drops the oldest `n` bytes, which must all have been readable.
+    void consume(std::size_t n) {
+        head_ += n;
+        if (head_ == tail_) {
+            head_ = tail_ = 0;
+        }
+    }
+
+    // Free space at the back, at least `at_least` bytes of it -- compacting
+    // first if that makes the room, growing otherwise. Whatever is written
+    // there is added by commit(). Invalidates earlier readable() spans.
+    [[nodiscard]] std::span<std::byte> writable(std::size_t at_least = 1) {
+        if (storage_.size() - tail_ < at_least) {
+            make_room(at_least);
+        }
+        return std::span<std::byte>(storage_).subspan(tail_);
+    }
+
+    // Adds the first `n` bytes of the last writable() span.
+    void commit(std::size_t n) { tail_ += n; }
+
+    // writable() and commit() around a copy of `bytes`.
+    void append(std::span<const std::byte> bytes) {
+        if (bytes.empty()) {
+            return;
+        }
+        std::memcpy(writable(bytes.size()).data(), bytes.data(), bytes.size());
+        commit(bytes.size());
+    }
+
+private:
+    void make_room(std::size_t at_least) {
+        const std::size_t live = tail_ - head_;
+        if (storage_.size() - live >= at_least) {
+            std::memmove(storage_.data(), storage_.data() + head_, live);
+        } else {
+            std::vector<std::byte> grown(std::max(2 * storage_.size(), live + at_least));
+            std::memcpy(grown.data(), storage_.data() + head_, live);
+            storage_ = std::move(grown);
+        }
+        head_ = 0;
+        tail_ = live;
+    }
+
+    std::vector<std::byte> storage_;
+    std::size_t head_ = 0; // first unconsumed byte
+    std::size_t tail_ = 0; // one past the last received byte
+};
+
+} // namespace mdh::net
@@ -63,6 +63,13 @@ public:
     // stop_token instead.
     [[nodiscard]] std::optional<TcpSocket> accept();
 
+    // Server side. Takes ownership of `fd`, a connection accepted somewhere
+    // other than accept() -- by an io_uring multishot accept (net::Uring),
+    // which hands back bare descriptors -- and gives it what accept() gives
+    // its own: Nagle off. Blocking mode is left as it came; a Linux accept
+    // never inherits O_NONBLOCK, and io_uring is Linux-only.
+    [[nodiscard]] static TcpSocket adopt(int fd);
+
     // Client side. Connects to host:port. `host` must be an IPv4
     // dotted-decimal literal (e.g. "127.0.0.1") -- no DNS resolution, same
     // restriction and rationale as UdpSocket::send_to(). Returns false on
@@ -101,6 +108,26 @@ public:
     // Returns std::nullopt on error.
     [[nodiscard]] std::optional<std::size_t> write(std::span<const std::byte> data);
 
+    // What a transfer on a non-blocking socket did. read() and write()
+    // fold "nothing to do right now" into their std::nullopt along with
+    // real failure, which is all a blocking caller needs; an event loop has
+    // to tell the two apart, since one means wait for readiness and the
+    // other means the connection is finished.
+    enum class IoStatus : std::uint8_t {
+        Done,       // moved `bytes` -- for try_read(), 0 is end of stream
+        WouldBlock, // EWOULDBLOCK/EAGAIN: nothing moved, try again on the next readiness event
+        Failed,     // any other error, or a closed socket
+    };
+    struct IoResult {
+        IoStatus status = IoStatus::Failed;
+        std::size_t bytes = 0;
+    };
+
+    // read() and write() for a non-blocking socket, with the outcome spelled
+    // out as above. EINTR is retried rather than reported.
+    [[nodiscard]] IoResult try_read(std::span<std::byte> buf);
+    [[nodiscard]] IoResult try_write(std::span<const std::byte> data);
+
     // Puts the socket into non-blocking mode -- same semantics as
     // UdpSocket::set_non_blocking(). Applies to whichever operation this
     // socket is later used for: accept() on a listening socket, or
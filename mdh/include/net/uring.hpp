@@ -0,0 +1,127 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+
+namespace mdh::net {
+
+// One completion from Uring::for_each_completion(): the user_data the
+// operation was queued with, its result -- bytes moved, a new descriptor, or
+// a negated errno -- and the kernel's flags.
+struct UringCompletion {
+    std::uint64_t user_data = 0;
+    std::int32_t res = 0;
+    std::uint32_t flags = 0;
+
+    // A multishot operation is still armed and will complete again. Once a
+    // completion comes without this, the operation is over and must be
+    // queued afresh if it is still wanted.
+    [[nodiscard]] bool more() const;
+
+    // The provided buffer a multishot recv filled, by id, if it used one.
+    [[nodiscard]] std::optional<std::uint16_t> buffer() const;
+};
+
+// A Linux io_uring instance driven through the raw system calls -- no
+// liburing -- and cut down to what a socket event loop needs:
+//
+//   accept_multishot()  one submission that completes once per accepted
+//                       connection, for as long as it stays armed
+//   recv_multishot()    likewise once per chunk received, each into a
+//                       buffer the kernel picks from this ring's provided
+//                       buffer ring, so no read is ever posted per socket
+//                       and no buffer is tied up by an idle one
+//   send()              one send; any number queued are submitted together
+//
+// Nothing reaches the kernel until submit_and_wait(), which submits every
+// queued operation and waits for completions in the same io_uring_enter()
+// call -- the one system call per turn of an event loop, however many
+// sockets it served. for_each_completion() then reads them straight out of
+// the shared completion ring, with no system call at all.
+//
+// ── Waking from another thread ────────────────────────────────────────────
+// The ring keeps an eventfd read queued at all times. wake() writes the
+// eventfd, that read completes, and submit_and_wait() returns; the
+// completion is consumed here, re-queued, and never reported.
+//
+// ── Support ──────────────────────────────────────────────────────────────
+// Needs Linux 6.0 or later: multishot recv arrived then, and so did
+// IORING_SETUP_SINGLE_ISSUER, which setup asks for and which therefore doubles
+// as the version check. An older kernel, a seccomp policy or container
+// runtime that blocks io_uring, or a failed buffer-ring registration all
+// leave is_open() false, and a caller falls back to something else (see
+// OrderEntryGatewayOptions::io_backend). Elsewhere than Linux it never opens.
+//
+// Single-threaded: the thread that first submits owns the ring, except for
+// wake(), which any thread may call. Not copyable or movable.
+class Uring {
+public:
+    // `entries` submission slots (a power of two; rounded up by the kernel),
+    // and `buffer_count` provided buffers of `buffer_size` bytes each for
+    // recv_multishot() to fill, `buffer_count` a power of two up to 32768.
+    Uring(unsigned entries, unsigned buffer_count, std::size_t buffer_size);
+    ~Uring();
+
+    Uring(const Uring&) = delete;
+    Uring& operator=(const Uring&) = delete;
+
+    [[nodiscard]] bool is_open() const;
+
+    // Queue one operation each, reported under `user_data`. Never fail for
+    // want of room -- a full submission queue is submitted first -- only on a
+    // closed ring. `data` must stay put until the send completes.
+    bool accept_multishot(int listen_fd, std::uint64_t user_data);
+    bool recv_multishot(int fd, std::uint64_t user_data);
+    bool send(int fd, std::span<const std::byte> data, std::uint64_t user_data);
+
+    // Submits everything queued, then waits until at least one completion
+    // is ready, `timeout` passes (negative waits indefinitely, zero not at
+    // all), or wake() is called. One io_uring_enter().
+    void submit_and_wait(std::chrono::milliseconds timeout);
+
+    // Calls fn(const UringCompletion&) for every completion ready now, in
+    // order, and hands their slots back. Returns how many. `fn` may queue
+    // more operations; they go with the next submit_and_wait().
+    template <typename Fn>
+    std::size_t for_each_completion(Fn&& fn) {
+        std::size_t seen = 0;
+        UringCompletion completion;
+        while (next_completion(completion)) {
+            if (!is_wake(completion)) {
+                fn(static_cast<const UringCompletion&>(completion));
+            }
+            ++seen;
+        }
+        return seen;
+    }
+
+    // The bytes a recv completion delivered into provided buffer `id`, and
+    // handing that buffer back for the kernel to fill again. Every buffer a
+    // completion names must be recycled, once its bytes have been copied out
+    // or are no longer needed, or the kernel runs out and multishot recvs end
+    // with -ENOBUFS.
+    [[nodiscard]] std::span<const std::byte> buffer(std::uint16_t id, std::size_t length) const;
+    void recycle(std::uint16_t id);
+
+    // Any thread. Ends the current submit_and_wait(), or the next one.
+    void wake();
+
+    // io_uring_enter() calls made so far -- the ring's system calls, for a
+    // caller counting what its I/O costs. Owner thread only.
+    [[nodiscard]] std::uint64_t enters() const { return enters_; }
+
+private:
+    struct State; // the mapped rings and registered buffers; Linux headers stay in uring.cpp
+
+    bool next_completion(UringCompletion& out);
+    bool is_wake(const UringCompletion& completion);
+
+    std::unique_ptr<State> state_;
+    std::uint64_t enters_ = 0;
+};
+
+} // namespace mdh::net
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <span>
 #include <variant>
 
@@ -13,7 +14,9 @@ namespace mdh::protocol::order_entry {
 // the type byte isn't one of the known MessageType enumerators. Does NOT
 // validate `payload_size` against `type` -- that needs payload_size_for(),
 // which requires a type already known to be valid, so it happens in
-// decode_message() instead.
+// decode_message() instead. A MassQuote's payload_size is whatever its
+// entries make it, so a reader framing off this header needs nothing more
+// to know how many bytes to wait for.
 [[nodiscard]] std::variant<Header, DecodeError> decode_header(std::span<const std::byte> data);
 
 // Decodes a full frame: `data` must contain exactly the header bytes
@@ -24,4 +27,35 @@ namespace mdh::protocol::order_entry {
 // how many payload bytes to wait for before calling this.
 [[nodiscard]] std::variant<Message, DecodeError> decode_message(std::span<const std::byte> data);
 
+// Frames `data` as a stream reader has it: decodes every whole frame from
+// the front, in order, passing each decode_message() result to
+// `on_frame(std::variant<Message, DecodeError>&&)`, and stops at the first
+// frame not yet complete. Returns how many bytes that took, for the caller
+// to drop from its buffer in one go once the whole span is framed -- not
+// frame by frame, which would move the rest of the buffer once per frame.
+//
+// A header that does not decode -- too few bytes yet, or a bad type byte --
+// stops framing just like a partial payload: a length-prefixed stream
+// cannot tell the two apart, so either way the reader waits for more. A
+// payload that does not decode under a good header is still a whole frame,
+// passed on as its DecodeError and skipped over.
+template <typename OnFrame>
+std::size_t decode_frames(std::span<const std::byte> data, OnFrame&& on_frame) {
+    std::size_t offset = 0;
+    while (true) {
+        const std::span<const std::byte> rest = data.subspan(offset);
+        const auto header_result = decode_header(rest);
+        const auto* header = std::get_if<Header>(&header_result);
+        if (header == nullptr) {
+            return offset;
+        }
+        const std::size_t frame_size = HEADER_SIZE + header->payload_size;
+        if (rest.size() < frame_size) {
+            return offset;
+        }
+        offset += frame_size;
+        on_frame(decode_message(rest.first(frame_size)));
+    }
+}
+
 } // namespace mdh::protocol::order_entry
@@ -13,6 +13,7 @@ enum class DecodeError {
     InvalidOrderType,
     InvalidTimeInForce,
     InvalidRejectReason,
+    InvalidFlags,        // a MassCancel's flags set an unknown bit, or an absent field was non-zero
 };
 
 [[nodiscard]] constexpr std::string_view to_string(DecodeError e) {
@@ -25,6 +26,7 @@ enum class DecodeError {
         case DecodeError::InvalidOrderType:    return "InvalidOrderType";
         case DecodeError::InvalidTimeInForce:  return "InvalidTimeInForce";
         case DecodeError::InvalidRejectReason: return "InvalidRejectReason";
+        case DecodeError::InvalidFlags:        return "InvalidFlags";
     }
     return "UnknownDecodeError";
 }
@@ -1,14 +1,17 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <optional>
 #include <variant>
+#include <vector>
 
 #include "common/types.hpp"
 #include "exchange/core/types.hpp"
 
 // The order-entry wire format: a two-way TCP stream between one client and
 // the gateway, carrying client requests (NewOrder, CancelOrder,
-// ReplaceOrder) and gateway responses (Accepted, Rejected, Cancelled,
+// ReplaceOrder, MassQuote, MassCancel) and gateway responses (Accepted, Rejected, Cancelled,
 // Replaced, TradeReport). It resembles what the industry calls OUCH.
 //
 // protocol/messages.hpp is the other half: one-way, UDP, market data only,
@@ -38,6 +41,8 @@ enum class MessageType : std::uint8_t {
     NewOrder = 1,
     CancelOrder = 2,
     ReplaceOrder = 3,
+    MassQuote = 4,
+    MassCancel = 5,
 
     // Gateway -> client.
     Accepted = 10,
@@ -63,6 +68,11 @@ struct NewOrder {
     Quantity quantity;
     exchange::OrderType order_type;
     exchange::TimeInForce time_in_force;
+    // GTD only, zero otherwise; see exchange::NewOrderCommand::expire_at.
+    // Nanoseconds since the Unix epoch.
+    Timestamp expire_at = 0;
+    // StopLimit only, zero otherwise; see exchange::NewOrderCommand::stop_price.
+    Price stop_price = 0;
 
     bool operator==(const NewOrder&) const = default;
 };
@@ -88,6 +98,43 @@ struct ReplaceOrder {
     bool operator==(const ReplaceOrder&) const = default;
 };
 
+// One level of a MassQuote; see exchange::QuoteEntry.
+struct MassQuoteEntry {
+    exchange::ClientOrderId client_order_id;
+    Side side;
+    Price price;
+    Quantity quantity;
+
+    bool operator==(const MassQuoteEntry&) const = default;
+};
+
+// The one variable-length message: a fixed prefix, then `entries` back to
+// back. There is no count field -- payload_size already says how many
+// entries follow, and a second copy of that could only disagree with it.
+// At most exchange::kMaxQuoteEntries of them; see mass_quote_payload_size().
+struct MassQuote {
+    exchange::AccountId account_id;
+    InstrumentId instrument_id;
+    std::vector<MassQuoteEntry> entries;
+
+    bool operator==(const MassQuote&) const = default;
+};
+
+// Cancels every resting order of the account, optionally only on one
+// instrument and/or one side; see exchange::MassCancelCommand. The optional
+// fields go on the wire as a flags byte plus fields that are always there,
+// zero when absent, so the frame stays fixed-size like every other request.
+struct MassCancel {
+    exchange::AccountId account_id;
+    std::optional<InstrumentId> instrument_id;
+    std::optional<Side> side;
+
+    bool operator==(const MassCancel&) const = default;
+};
+
+inline constexpr std::uint8_t MASS_CANCEL_HAS_INSTRUMENT = 0x01;
+inline constexpr std::uint8_t MASS_CANCEL_HAS_SIDE = 0x02;
+
 // ── Gateway -> client ───────────────────────────────────────────────────────
 
 struct Accepted {
@@ -152,17 +199,23 @@ struct TradeReport {
     bool operator==(const TradeReport&) const = default;
 };
 
-using Message = std::variant<NewOrder, CancelOrder, ReplaceOrder, Accepted, Rejected, Cancelled, Replaced,
-                              TradeReport>;
+using Message = std::variant<NewOrder, CancelOrder, ReplaceOrder, MassQuote, MassCancel, Accepted, Rejected,
+                              Cancelled, Replaced, TradeReport>;
+
+inline constexpr std::size_t MASS_QUOTE_PREFIX_SIZE = 8 + 4;         // account_id + instrument_id
+inline constexpr std::size_t MASS_QUOTE_ENTRY_SIZE = 8 + 1 + 8 + 8;  // client_order_id + side + price + quantity
 
 // Fixed on-wire payload size (bytes, not counting the header) for each known
-// message type -- all order-entry message types are fixed-size, same as
-// every message type in protocol/messages.hpp.
+// message type. Every type but MassQuote is fixed-size, same as every
+// message type in protocol/messages.hpp; for MassQuote this is the size of
+// one with no entries, and mass_quote_payload_size() gives the rest.
 [[nodiscard]] constexpr std::size_t payload_size_for(MessageType type) {
     switch (type) {
-        case MessageType::NewOrder:     return 8 + 8 + 4 + 1 + 8 + 8 + 1 + 1; // 39
+        case MessageType::NewOrder:     return 8 + 8 + 4 + 1 + 8 + 8 + 1 + 1 + 8 + 8; // 55
         case MessageType::CancelOrder:  return 8 + 8 + 4;                    // 20
         case MessageType::ReplaceOrder: return 8 + 8 + 8 + 4 + 8 + 8;        // 44
+        case MessageType::MassQuote:    return MASS_QUOTE_PREFIX_SIZE;       // 12, plus 25 per entry
+        case MessageType::MassCancel:   return 8 + 1 + 4 + 1;                // 14
         case MessageType::Accepted:     return 8 + 8 + 8 + 4 + 1 + 8 + 8 + 1 + 1; // 47
         case MessageType::Rejected:     return 8 + 8 + 4 + 1;                // 21
         case MessageType::Cancelled:    return 8 + 8 + 8 + 4;                // 28
@@ -172,4 +225,11 @@ using Message = std::variant<NewOrder, CancelOrder, ReplaceOrder, Accepted, Reje
     return 0;
 }
 
+[[nodiscard]] constexpr std::size_t mass_quote_payload_size(std::size_t entries) {
+    return MASS_QUOTE_PREFIX_SIZE + entries * MASS_QUOTE_ENTRY_SIZE;
+}
+
+// kMaxQuoteEntries is what keeps a MassQuote frame inside the header's u16.
+static_assert(mass_quote_payload_size(exchange::kMaxQuoteEntries) <= 0xFFFF);
+
 } // namespace mdh::protocol::order_entry
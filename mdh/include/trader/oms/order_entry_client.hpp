@@ -8,6 +8,7 @@
 #include <thread>
 #include <vector>
 
+#include "net/receive_buffer.hpp"
 #include "net/tcp_socket.hpp"
 #include "protocol/order_entry/messages.hpp"
 
@@ -89,7 +90,7 @@ private:
     net::TcpSocket socket_;
     std::mutex write_mutex_;
     MessageSink sink_;
-    std::vector<std::byte> read_buffer_; // reader-thread-only
+    net::ReceiveBuffer read_buffer_; // reader-thread-only
     std::jthread reader_thread_;
     std::atomic<bool> connected_{false};
 };
@@ -10,6 +10,7 @@
 #include <unordered_map>
 #include <vector>
 
+#include "common/thread_placement.hpp"
 #include "common/types.hpp"
 #include "exchange/core/types.hpp"
 #include "exchange/gateway/order_entry_gateway.hpp"
@@ -99,6 +100,11 @@ struct UiGatewayOptions {
     // whole dashboard with no separate web server. Empty serves nothing,
     // which is what the tests want: they only exercise the JSON API.
     std::string static_files_dir;
+
+    // Where the market-data receiver thread ("mdh-md-recv") runs -- see
+    // thread_placement.hpp. The HTTP server's threads belong to cpp-httplib
+    // and are left alone.
+    ThreadPlacement market_data_placement;
 };
 
 // One order-book price level, JSON-shaped identically for both
@@ -0,0 +1,116 @@
+#include "common/thread_placement.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <string>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace mdh {
+
+namespace {
+
+constexpr std::array<std::string_view, kThreadRoleCount> kRoleNames = {
+    "matching", "accept", "reader", "writer", "snapshot", "market_data", "routing", "publishing", "io",
+};
+
+// Linux keeps sixteen bytes of thread name including the terminator, and
+// pthread_setname_np() refuses a longer one outright rather than truncating.
+constexpr std::size_t kMaxThreadName = 15;
+
+std::optional<int> parse_cpu(std::string_view text) {
+    int value = 0;
+    const auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (ec != std::errc{} || end != text.data() + text.size() || value < 0) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+} // namespace
+
+PlacementOutcome place_current_thread(std::string_view name, const ThreadPlacement& placement) {
+    PlacementOutcome outcome;
+    const std::string truncated(name.substr(0, kMaxThreadName));
+
+#if defined(__linux__)
+    outcome.named = pthread_setname_np(pthread_self(), truncated.c_str()) == 0;
+
+    outcome.pinned = true;
+    if (!placement.cpus.empty()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        bool any = false;
+        for (const int cpu : placement.cpus) {
+            if (cpu >= 0 && cpu < CPU_SETSIZE) {
+                CPU_SET(cpu, &set);
+                any = true;
+            }
+        }
+        outcome.pinned = any && pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+    }
+
+    outcome.realtime = true;
+    if (placement.realtime_priority > 0) {
+        sched_param param{};
+        param.sched_priority = std::clamp(placement.realtime_priority, sched_get_priority_min(SCHED_FIFO),
+                                          sched_get_priority_max(SCHED_FIFO));
+        outcome.realtime = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+    }
+#else
+    // No portable way to name, pin or raise a thread; report what was asked
+    // for and not done.
+    outcome.named = false;
+    outcome.pinned = placement.cpus.empty();
+    outcome.realtime = placement.realtime_priority <= 0;
+#endif
+    return outcome;
+}
+
+std::string_view thread_role_name(ThreadRole role) { return kRoleNames[static_cast<std::size_t>(role)]; }
+
+std::optional<ThreadRole> thread_role_from_name(std::string_view name) {
+    for (std::size_t i = 0; i < kRoleNames.size(); ++i) {
+        if (kRoleNames[i] == name) {
+            return static_cast<ThreadRole>(i);
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<std::vector<int>> parse_cpu_list(std::string_view text) {
+    std::vector<int> cpus;
+    while (true) {
+        const std::size_t comma = text.find(',');
+        const std::string_view item = text.substr(0, comma);
+        const std::size_t dash = item.find('-');
+        if (dash == std::string_view::npos) {
+            const auto cpu = parse_cpu(item);
+            if (!cpu) {
+                return std::nullopt;
+            }
+            cpus.push_back(*cpu);
+        } else {
+            const auto first = parse_cpu(item.substr(0, dash));
+            const auto last = parse_cpu(item.substr(dash + 1));
+            if (!first || !last || *last < *first) {
+                return std::nullopt;
+            }
+            for (int cpu = *first; cpu <= *last; ++cpu) {
+                cpus.push_back(cpu);
+            }
+        }
+        if (comma == std::string_view::npos) {
+            break;
+        }
+        text.remove_prefix(comma + 1);
+    }
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return cpus;
+}
+
+} // namespace mdh
@@ -2,13 +2,18 @@
 
 #include <algorithm>
 #include <array>
+#include <cerrno>
 #include <chrono>
 #include <iterator>
+#include <list>
 #include <optional>
 #include <span>
+#include <string>
 #include <thread>
 #include <type_traits>
+#include <utility>
 #include <variant>
+#include <vector>
 
 #include "protocol/order_entry/decoder.hpp"
 #include "protocol/order_entry/encoder.hpp"
@@ -24,44 +29,214 @@ using namespace std::chrono_literals;
 // framing, just applied to idle-polling instead of simulated slowness).
 // accept_loop() has no better option (TcpSocket::accept() has no blocking-
 // with-wakeup primitive to offer it -- see tcp_socket.hpp's own
-// shutdown()/accept() caveat), but connection_writer_loop() below now uses
-// this only as a wait_for() safety-net timeout, not its primary wake
-// mechanism -- see Connection::wake_cv's doc comment.
+// shutdown()/accept() caveat). connection_writer_loop() no longer polls at
+// all -- see Connection::wake's doc comment.
 constexpr auto kPollInterval = 1ms;
+
+// Messages a writer takes off one outbound queue per visit. This is about
+// how often it hands freed slots back to the routing thread, not about the
+// socket: what a write() carries is write_flush_bytes' business.
+constexpr std::size_t kWriterBatch = 32;
+
+// Room in a writer thread's write_buffer past write_flush_bytes, for the
+// report that crosses it. Reports are tens of bytes; this only has to keep
+// the buffer from ever growing after its first reserve().
+constexpr std::size_t kWriteHeadroom = 1024;
+
+// How long stop() lets writer threads write out what they have staged
+// before it shuts their sockets down regardless. Only a client that has
+// stopped reading uses any of it.
+constexpr auto kWriterFlushTimeout = 100ms;
+
+// An I/O thread's per-turn limits, so that no one connection -- or burst of
+// connects -- keeps the others on its loop waiting. A connection cut off at
+// kReadsPerTurn is read again on the loop's next turn (see
+// Connection::input_pending); the listener is level-triggered, so cut-off
+// accepts are simply reported again.
+constexpr std::size_t kReadsPerTurn = 16;
+constexpr std::size_t kAcceptBatch = 64;
+
+// Bytes asked of one read(): a reader thread's, straight into its
+// connection's read buffer, or an I/O thread's, into the chunk every
+// connection on its loop shares.
+constexpr std::size_t kReadChunk = 4096;
+
+// The listener's key in loop 0's poller. Every other key is a Connection's
+// address, which is never null.
+constexpr std::uint64_t kListenerKey = 0;
+
+// An io_uring loop's user_data: the Connection's address, whose low bits are
+// always clear, with the operation in them. The listener's accept is
+// kListenerKey, as under epoll.
+constexpr std::uint64_t kRecvOp = 1;
+constexpr std::uint64_t kSendOp = 2;
+constexpr std::uint64_t kOpMask = 3;
+
+// Each io_uring loop's ring: submission slots, and the provided buffers its
+// multishot recvs land in -- kUringBuffers of kUringBufferSize, shared by
+// every connection on the loop, so idle sessions hold no receive memory and
+// the total stays put however many connect. A buffer is handed back as soon
+// as handle_input() has copied it out, so they run short only if one turn's
+// completions outnumber them, and a recv that finds none is simply armed
+// again.
+constexpr unsigned kUringEntries = 1024;
+constexpr unsigned kUringBuffers = 256;
+constexpr std::size_t kUringBufferSize = 4096;
+
+// Adds to one of the io_stats() counters. Each has a single writer (see
+// Connection::reads), so a relaxed load and store will do where fetch_add
+// would be a locked instruction on every read and write.
+void count(std::atomic<std::uint64_t>& counter, std::uint64_t n = 1) {
+    counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
 } // namespace
 
 OrderEntryGateway::OrderEntryGateway(std::uint16_t port, const OrderEntryGatewayOptions& options)
     : port_(port), options_(options),
       engine_(std::span<const InstrumentId>(options.instruments), options.expected_resting_orders),
       risk_gated_engine_(engine_, ledger_, options_.risk_limits),
-      pipeline_(
-          EventSink{[this](const ExchangeEvent& event) { route_event(event); }},
-          sequencing::MatchingPipelineOptions{.queue_capacity = options_.matching_queue_capacity},
-          sequencing::MatchingPipeline::Processor{[this](const ExchangeCommand& command, const EventSink& sink) {
-              risk_gated_engine_.process(command, sink);
-          }}) {}
+      snapshotter_(options.snapshot_every_commands == 0
+                       ? nullptr
+                       : std::make_unique<persistence::BackgroundSnapshotter>(
+                             persistence::BackgroundSnapshotterOptions{
+                                 .on_snapshot = options.on_snapshot,
+                                 .placement = options.placement[ThreadRole::Snapshot]})),
+      events_(make_event_fanout()),
+      pipeline_(RouteEvent{this},
+                sequencing::MatchingPipelineOptions{.queue_capacity = options_.matching_queue_capacity,
+                                                    .idle_wait = options_.matching_wait,
+                                                    .placement = options_.placement[ThreadRole::Matching]},
+                RiskGated{this}) {}
 
 OrderEntryGateway::~OrderEntryGateway() { stop(); }
 
+std::unique_ptr<sequencing::EventFanout<OrderEntryGateway::RoutedEvent>> OrderEntryGateway::make_event_fanout() {
+    if (options_.event_ring_capacity == 0) {
+        return nullptr;
+    }
+    auto fanout = std::make_unique<sequencing::EventFanout<RoutedEvent>>(
+        sequencing::EventFanoutOptions{.capacity = options_.event_ring_capacity, .wait = options_.event_wait});
+    // Independent of each other: neither is declared after the other, so a
+    // slow extra_event_sink never holds up a report, nor the reverse.
+    fanout->add_handler(
+        "routing", [this](const RoutedEvent& routed) { route_reports(routed); }, {},
+        options_.placement[ThreadRole::Routing]);
+    if (options_.extra_event_sink) {
+        fanout->add_handler(
+            "publishing", [this](const RoutedEvent& routed) { publish_event(routed); }, {},
+            options_.placement[ThreadRole::Publishing]);
+    }
+    fanout->start();
+    return fanout;
+}
+
 bool OrderEntryGateway::start() {
     if (!listener_.listen(port_, options_.accept_backlog)) {
         return false;
     }
     listener_.set_non_blocking(); // accept_loop() must never block in accept() -- see its own doc comment
+
+    // Whatever was asked for and can be had here, falling back a step at a
+    // time rather than not serving at all.
+    backend_ = GatewayIoBackend::Threads;
+    if (options_.io_threads > 0 && options_.io_backend != GatewayIoBackend::Threads) {
+        if (options_.io_backend == GatewayIoBackend::IoUring && make_io_loops(GatewayIoBackend::IoUring)) {
+            backend_ = GatewayIoBackend::IoUring;
+        } else if (make_io_loops(GatewayIoBackend::Epoll)) {
+            backend_ = GatewayIoBackend::Epoll;
+        }
+    }
+    if (backend_ != GatewayIoBackend::Threads) {
+        for (auto& loop : io_loops_) {
+            loop->thread = std::jthread([this, raw = loop.get()] {
+                if (backend_ == GatewayIoBackend::IoUring) {
+                    uring_loop(*raw);
+                } else {
+                    io_loop(*raw);
+                }
+            });
+        }
+        return true;
+    }
+
     accept_thread_ = std::jthread([this] { accept_loop(); });
     return true;
 }
 
+bool OrderEntryGateway::make_io_loops(GatewayIoBackend backend) {
+    for (std::size_t i = 0; i < options_.io_threads; ++i) {
+        auto loop = std::make_unique<IoLoop>(i);
+        if (backend == GatewayIoBackend::IoUring) {
+            loop->ring = std::make_unique<net::Uring>(kUringEntries, kUringBuffers, kUringBufferSize);
+            if (!loop->ring->is_open()) {
+                io_loops_.clear();
+                return false;
+            }
+        } else {
+            loop->poller = std::make_unique<net::Poller>();
+            if (!loop->poller->is_open()) {
+                io_loops_.clear();
+                return false;
+            }
+        }
+        io_loops_.push_back(std::move(loop));
+    }
+    // Level-triggered, unlike the connections: TcpSocket::accept() cannot
+    // tell "none pending" from a failure, so loop 0 cannot know it has
+    // accepted everything, and must be told again if it has not. A ring's
+    // listener is armed by its loop instead, since only that thread submits.
+    if (backend == GatewayIoBackend::Epoll &&
+        !io_loops_.front()->poller->add(listener_.raw_fd(), kListenerKey, false, /*edge_triggered=*/false)) {
+        io_loops_.clear();
+        return false;
+    }
+    return true;
+}
+
 void OrderEntryGateway::stop() {
     stop_source_.request_stop();
+    for (auto& loop : io_loops_) {
+        loop->wake();
+    }
+    for (auto& loop : io_loops_) {
+        if (loop->thread.joinable()) {
+            loop->thread.join();
+        }
+    }
     if (accept_thread_.joinable()) {
         accept_thread_.join();
     }
 
     std::lock_guard<std::mutex> lock(connections_mutex_);
+
+    // Writer threads first, sockets still open: each writes out what it has
+    // staged and exits (see connection_writer_loop()). The deadline is for a
+    // client that stopped reading, whose writer is stuck in write() until
+    // the shutdown below.
     for (auto& conn : connections_) {
+        if (conn->loop == nullptr) {
+            conn->wake.notify();
+        }
+    }
+    const auto deadline = std::chrono::steady_clock::now() + kWriterFlushTimeout;
+    for (auto& conn : connections_) {
+        while (conn->loop == nullptr && !conn->writer_finished.load(std::memory_order_acquire) &&
+               std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(kPollInterval);
+        }
+    }
+
+    for (auto& conn : connections_) {
+        if (conn->loop != nullptr) {
+            // Its I/O thread has exited, so this thread is the only one left
+            // to close it -- the same close its reader thread would have done.
+            if (!conn->closed.load(std::memory_order_acquire)) {
+                close_connection(*conn);
+            }
+            continue;
+        }
         conn->socket.shutdown(); // unblocks a blocked read() on this connection's reader thread
-        conn->wake_cv.notify_all(); // unblocks a writer thread waiting in connection_writer_loop()'s wait_for()
+        conn->wake.notify(); // unblocks a writer thread waiting in connection_writer_loop()
     }
     for (auto& conn : connections_) {
         if (conn->reader_thread.joinable()) {
@@ -73,6 +248,19 @@ void OrderEntryGateway::stop() {
     }
 
     pipeline_.stop();
+    if (events_) {
+        events_->stop(); // matching has drained, so everything it published is now routed and published
+    }
+
+    if (snapshotter_) {
+        // Matching has drained, so this thread is now the engine's only
+        // user and may capture the last of it. A full queue only means the
+        // snapshot thread is still applying earlier captures; it empties.
+        while (!snapshotter_->capture(engine_)) {
+            std::this_thread::sleep_for(kPollInterval);
+        }
+        snapshotter_->stop();
+    }
 }
 
 std::size_t OrderEntryGateway::connection_count() const {
@@ -80,108 +268,482 @@ std::size_t OrderEntryGateway::connection_count() const {
     return connections_.size();
 }
 
+GatewayIoStats OrderEntryGateway::io_stats() const {
+    GatewayIoStats stats;
+    for (const auto& loop : io_loops_) {
+        stats.syscalls += loop->syscalls.load(std::memory_order_relaxed);
+    }
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+    for (const auto& conn : connections_) {
+        stats.syscalls += conn->reads.load(std::memory_order_relaxed) + conn->writes.load(std::memory_order_relaxed);
+        stats.messages_in += conn->messages_in.load(std::memory_order_relaxed);
+        stats.messages_out += conn->messages_out.load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
 bool OrderEntryGateway::submit_command(ExchangeCommand command) {
-    std::lock_guard<std::mutex> lock(submit_mutex_);
     return pipeline_.submit(std::move(command));
 }
 
+std::size_t OrderEntryGateway::submit_phase(TradingPhase phase, std::size_t next) {
+    std::size_t submitted = 0;
+    for (; next < options_.instruments.size(); ++next, ++submitted) {
+        if (!submit_command(TradingPhaseCommand{
+                .command_sequence = 0, .instrument_id = options_.instruments[next], .phase = phase})) {
+            break;
+        }
+    }
+    return submitted;
+}
+
 // ── The six pieces ───────────────────────────────────────────────────────
 
+OrderEntryGateway::Schedule OrderEntryGateway::make_schedule() const {
+    const auto now = std::chrono::steady_clock::now();
+    return Schedule{.next_tick = now,
+                    .next_call = now + options_.auction_interval,
+                    .call_ends = now + options_.auction_interval,
+                    .phase = TradingPhase::Continuous,
+                    .phase_sent = options_.instruments.size()};
+}
+
+void OrderEntryGateway::run_schedule(Schedule& schedule) {
+    // Steady clock for when to tick, system clock for what the tick
+    // says: a wall clock stepped back by NTP must not stop the ticks,
+    // and the engine ignores any that would move its clock backwards.
+    if (options_.clock_tick_interval.count() > 0 && std::chrono::steady_clock::now() >= schedule.next_tick) {
+        schedule.next_tick = std::chrono::steady_clock::now() + options_.clock_tick_interval;
+        const auto since_epoch = std::chrono::system_clock::now().time_since_epoch();
+        (void)submit_command(ClockTickCommand{
+            .command_sequence = 0,
+            .now = static_cast<Timestamp>(std::chrono::duration_cast<std::chrono::nanoseconds>(since_epoch).count()),
+        });
+    }
+    if (options_.auction_interval.count() > 0) {
+        const auto now = std::chrono::steady_clock::now();
+        if (schedule.phase_sent == options_.instruments.size()) {
+            if (schedule.phase == TradingPhase::Continuous && now >= schedule.next_call) {
+                schedule.phase = TradingPhase::Call;
+                schedule.phase_sent = 0;
+                schedule.call_ends = now + options_.auction_call_duration;
+                schedule.next_call = now + options_.auction_interval;
+            } else if (schedule.phase == TradingPhase::Call && now >= schedule.call_ends) {
+                schedule.phase = TradingPhase::Continuous;
+                schedule.phase_sent = 0;
+            }
+        }
+        schedule.phase_sent += submit_phase(schedule.phase, schedule.phase_sent);
+    }
+}
+
 void OrderEntryGateway::accept_loop() {
+    place_current_thread("mdh-accept", options_.placement[ThreadRole::GatewayAccept]);
     const auto token = stop_source_.get_token();
+    Schedule schedule = make_schedule();
     while (!token.stop_requested()) {
+        run_schedule(schedule);
+
         auto sock = listener_.accept();
         if (!sock) {
             std::this_thread::sleep_for(kPollInterval); // nothing pending -- the expected common case, not an error
             continue;
         }
+        adopt_connection(std::move(*sock));
+    }
+}
 
-        auto conn =
-            std::make_unique<Connection>(next_session_id_++, std::move(*sock), options_.outbound_queue_capacity);
-        Connection* conn_ptr = conn.get();
+void OrderEntryGateway::adopt_connection(net::TcpSocket socket) {
+    auto conn = std::make_unique<Connection>(next_session_id_++, std::move(socket), options_.outbound_queue_capacity,
+                                             options_.writer_wait);
+    Connection* conn_ptr = conn.get();
+    if (!io_loops_.empty()) {
+        conn_ptr->loop = io_loops_[conn_ptr->session_id % io_loops_.size()].get();
+    }
+    if (backend_ == GatewayIoBackend::Epoll) {
+        conn_ptr->socket.set_non_blocking(); // io_uring waits for the socket itself, blocking or not
+    }
+    {
+        std::lock_guard<std::mutex> lock(connections_mutex_);
+        connections_.push_back(std::move(conn));
+    }
+
+    if (backend_ == GatewayIoBackend::IoUring) {
+        // Armed by its own loop, the only thread that submits to that ring,
+        // and from then on serviced by it. Bytes the client has already
+        // sent are simply the first recv's.
+        IoLoop& loop = *conn_ptr->loop;
         {
-            std::lock_guard<std::mutex> lock(connections_mutex_);
-            connections_.push_back(std::move(conn));
+            std::lock_guard<std::mutex> lock(loop.ready_mutex);
+            loop.arriving.push_back(conn_ptr);
         }
-
-        conn_ptr->reader_thread = std::jthread([this, conn_ptr] { connection_reader_loop(*conn_ptr); });
-        conn_ptr->writer_thread = std::jthread(
-            [this, conn_ptr] { connection_writer_loop(*conn_ptr, stop_source_.get_token()); });
+        if (!loop.wake_pending.exchange(true, std::memory_order_acq_rel)) {
+            loop.wake();
+        }
+        return;
     }
+    if (conn_ptr->loop != nullptr) {
+        // Registered last, once the connection is in the list stop() walks:
+        // from here its loop may be servicing it. Bytes the client sent
+        // before this are reported straight away, as is writability -- an
+        // edge-triggered registration reports the state it finds.
+        if (!conn_ptr->loop->poller->add(conn_ptr->socket.raw_fd(), reinterpret_cast<std::uintptr_t>(conn_ptr),
+                                         true)) {
+            close_connection(*conn_ptr);
+        }
+        return;
+    }
+    conn_ptr->reader_thread = std::jthread([this, conn_ptr] { connection_reader_loop(*conn_ptr); });
+    conn_ptr->writer_thread =
+        std::jthread([this, conn_ptr] { connection_writer_loop(*conn_ptr, stop_source_.get_token()); });
 }
 
-void OrderEntryGateway::connection_reader_loop(Connection& conn) {
-    using namespace protocol::order_entry;
+void OrderEntryGateway::io_loop(IoLoop& loop) {
+    place_current_thread("mdh-io-" + std::to_string(loop.index), options_.placement[ThreadRole::GatewayIo]);
+    const auto token = stop_source_.get_token();
+    const bool runs_schedule = loop.index == 0 && has_schedule();
+    Schedule schedule = make_schedule();
 
-    std::array<std::byte, 4096> chunk{};
-    while (true) {
-        auto n = conn.socket.read(chunk);
-        if (!n || *n == 0) {
-            break; // error, peer EOF, or this socket was shutdown() by stop() -- connection is done either way
+    std::array<net::PollEvent, net::Poller::kMaxEvents> events{};
+    std::array<std::byte, kReadChunk> chunk{}; // every connection on this loop reads through it in turn
+    std::vector<Connection*> unread;     // cut off at kReadsPerTurn last turn
+    std::vector<Connection*> still_unread;
+    std::vector<Connection*> ready;
+    while (!token.stop_requested()) {
+        if (runs_schedule) {
+            run_schedule(schedule);
         }
-        conn.read_buffer.insert(conn.read_buffer.end(), chunk.begin(),
-                                 chunk.begin() + static_cast<std::ptrdiff_t>(*n));
-
-        // Drain every complete frame currently sitting in read_buffer
-        // before going back to read() for more -- a single read() can
-        // return several small messages concatenated together, not just
-        // one (see tcp_socket.hpp's own doc comment on TCP having no
-        // atomic-message boundary).
-        while (true) {
-            auto header_result = decode_header(conn.read_buffer);
-            if (std::holds_alternative<DecodeError>(header_result)) {
-                break; // not enough bytes yet for a header, or a malformed type byte -- wait for more data either way
+        submit_deferred(loop);
+
+        // Never sleep on a connection that may still hold unread bytes: no
+        // edge will announce them. Nor for long with a cancel deferred.
+        const bool polling = runs_schedule || !loop.deferred.empty();
+        const auto timeout = !unread.empty() ? 0ms : polling ? kPollInterval : -1ms;
+        const std::size_t n =
+            loop.poller->wait(events, std::chrono::duration_cast<std::chrono::milliseconds>(timeout));
+        count(loop.syscalls);
+        for (std::size_t i = 0; i < n; ++i) {
+            const net::PollEvent& event = events[i];
+            if (event.key == kListenerKey) {
+                accept_ready();
+                continue;
+            }
+            auto& conn = *reinterpret_cast<Connection*>(static_cast<std::uintptr_t>(event.key));
+            if (conn.closed.load(std::memory_order_acquire)) {
+                continue;
+            }
+            if (event.writable) {
+                write_ready(conn);
             }
-            const auto& header = std::get<Header>(header_result);
-            const std::size_t frame_size = HEADER_SIZE + header.payload_size;
-            if (conn.read_buffer.size() < frame_size) {
-                break; // header decoded, but the full payload hasn't arrived yet
+            if ((event.readable || event.hangup) && !conn.input_pending && read_ready(conn, chunk)) {
+                conn.input_pending = true;
+                still_unread.push_back(&conn);
             }
+        }
+        for (Connection* conn : unread) {
+            conn->input_pending = false;
+            if (!conn->closed.load(std::memory_order_acquire) && read_ready(*conn, chunk)) {
+                conn->input_pending = true;
+                still_unread.push_back(conn);
+            }
+        }
+        unread.swap(still_unread);
+        still_unread.clear();
+
+        // Cleared before the list is taken, so a producer that pushes after
+        // the swap sees it clear and wakes the loop again -- see wake_writer().
+        loop.wake_pending.store(false, std::memory_order_release);
+        {
+            std::lock_guard<std::mutex> lock(loop.ready_mutex);
+            ready.swap(loop.ready);
+        }
+        for (Connection* conn : ready) {
+            conn->output_scheduled.exchange(false, std::memory_order_acq_rel);
+            write_ready(*conn);
+        }
+        ready.clear();
+    }
+    // stop() stops the pipeline only once every loop has exited, so what
+    // is still deferred can wait for room here, as a reader thread would.
+    for (submit_deferred(loop); !loop.deferred.empty(); submit_deferred(loop)) {
+        std::this_thread::sleep_for(kPollInterval);
+    }
+}
+
+void OrderEntryGateway::uring_loop(IoLoop& loop) {
+    place_current_thread("mdh-io-" + std::to_string(loop.index), options_.placement[ThreadRole::GatewayIo]);
+    const auto token = stop_source_.get_token();
+    const bool runs_schedule = loop.index == 0 && has_schedule();
+    Schedule schedule = make_schedule();
+    net::Uring& ring = *loop.ring;
 
-            auto message_result = decode_message(std::span(conn.read_buffer).first(frame_size));
-            conn.read_buffer.erase(conn.read_buffer.begin(),
-                                    conn.read_buffer.begin() + static_cast<std::ptrdiff_t>(frame_size));
-            if (std::holds_alternative<DecodeError>(message_result)) {
-                continue; // malformed payload for an otherwise well-formed header -- drop just this one frame
+    if (loop.index == 0) {
+        (void)ring.accept_multishot(listener_.raw_fd(), kListenerKey);
+    }
+    auto complete = [this, &loop](const net::UringCompletion& completion) { uring_complete(loop, completion); };
+    std::vector<Connection*> arriving;
+    std::vector<Connection*> ready;
+    while (!token.stop_requested()) {
+        if (runs_schedule) {
+            run_schedule(schedule);
+        }
+        submit_deferred(loop);
+
+        // Cleared before either list is taken, so a producer that pushes
+        // after the swap sees it clear and wakes the loop again -- see
+        // wake_writer().
+        loop.wake_pending.store(false, std::memory_order_release);
+        {
+            std::lock_guard<std::mutex> lock(loop.ready_mutex);
+            arriving.swap(loop.arriving);
+            ready.swap(loop.ready);
+        }
+        for (Connection* conn : arriving) {
+            loop.connections.push_back(conn);
+            if (ring.recv_multishot(conn->socket.raw_fd(), reinterpret_cast<std::uintptr_t>(conn) | kRecvOp)) {
+                ++loop.in_flight;
             }
-            const Message& message = std::get<Message>(message_result);
-
-            auto command = to_command(message);
-            if (!command) {
-                // Decoded fine but isn't a valid client request (e.g. a
-                // gateway -> client type arriving from a client) -- silently
-                // ignored rather than disconnecting the client, since this
-                // protocol has no NAK/error-response message type (see
-                // messages.hpp) to report it with. It is also not something
-                // this session can bind on: identity comes from real
-                // requests only.
-                continue;
+        }
+        arriving.clear();
+        for (Connection* conn : ready) {
+            conn->output_scheduled.exchange(false, std::memory_order_acq_rel);
+            uring_send(loop, *conn);
+        }
+        ready.clear();
+
+        // Every recv re-armed, send queued and connection armed above goes
+        // in with this one call, which then waits for whatever comes next.
+        ring.submit_and_wait(runs_schedule || !loop.deferred.empty() ? kPollInterval : -1ms);
+        ring.for_each_completion(complete);
+        loop.syscalls.store(ring.enters(), std::memory_order_relaxed);
+    }
+
+    // Every operation still with the kernel points at a Connection, and a
+    // send at its write_buffer, both of which stop() is about to hand over
+    // and eventually free. Shutting the sockets down ends each recv and
+    // send promptly; the loop waits for all of them to come back. The
+    // deadline only guards against a kernel that never answers.
+    for (Connection* conn : loop.connections) {
+        conn->socket.shutdown();
+    }
+    const auto deadline = std::chrono::steady_clock::now() + 1s;
+    while (loop.in_flight > 0 && std::chrono::steady_clock::now() < deadline) {
+        ring.submit_and_wait(10ms);
+        ring.for_each_completion(complete);
+    }
+    loop.syscalls.store(ring.enters(), std::memory_order_relaxed);
+    // stop() stops the pipeline only once every loop has exited, so what
+    // is still deferred can wait for room here, as a reader thread would.
+    for (submit_deferred(loop); !loop.deferred.empty(); submit_deferred(loop)) {
+        std::this_thread::sleep_for(kPollInterval);
+    }
+}
+
+void OrderEntryGateway::uring_complete(IoLoop& loop, const net::UringCompletion& completion) {
+    net::Uring& ring = *loop.ring;
+    const bool stopping = stop_source_.stop_requested();
+    if (completion.user_data == kListenerKey) {
+        if (completion.res >= 0) {
+            adopt_connection(net::TcpSocket::adopt(completion.res));
+        }
+        if (!completion.more() && !stopping) {
+            (void)ring.accept_multishot(listener_.raw_fd(), kListenerKey);
+        }
+        return;
+    }
+
+    auto& conn = *reinterpret_cast<Connection*>(static_cast<std::uintptr_t>(completion.user_data & ~kOpMask));
+    if ((completion.user_data & kOpMask) == kSendOp) {
+        --loop.in_flight;
+        conn.send_in_flight = false;
+        if (completion.res <= 0) {
+            if (!conn.closed.load(std::memory_order_acquire)) {
+                close_connection(conn);
             }
+            return;
+        }
+        conn.write_offset += static_cast<std::size_t>(completion.res);
+        uring_send(loop, conn);
+        return;
+    }
 
-            // Every client request carries account_id (see messages.hpp).
-            // The first one binds this session; every later one must agree
-            // with it. account_id.has_value() is what lets that check stay
-            // on this thread's own field instead of taking sessions_mutex_
-            // for every single message.
-            const AccountId account_id = std::visit([](const auto& m) { return m.account_id; }, message);
-            if (!conn.account_id.has_value()) {
-                bind_session(conn, account_id);
-            } else if (*conn.account_id != account_id) {
-                reject_account_mismatch(conn, *command);
-                continue;
+    if (const auto buffer = completion.buffer()) {
+        if (completion.res > 0 && !conn.closed.load(std::memory_order_acquire)) {
+            const auto bytes = ring.buffer(*buffer, static_cast<std::size_t>(completion.res));
+            conn.read_buffer.append(bytes);
+            handle_input(conn);
+        }
+        ring.recycle(*buffer);
+    }
+    // -ENOBUFS is the one error that is not the connection's: every buffer
+    // was taken this turn. The recv has ended and is armed again below.
+    const bool finished = completion.res == 0 || (completion.res < 0 && completion.res != -ENOBUFS);
+    if (finished && !conn.closed.load(std::memory_order_acquire)) {
+        close_connection(conn);
+    }
+    if (!completion.more()) {
+        --loop.in_flight;
+        if (!conn.closed.load(std::memory_order_acquire) && !stopping &&
+            ring.recv_multishot(conn.socket.raw_fd(), reinterpret_cast<std::uintptr_t>(&conn) | kRecvOp)) {
+            ++loop.in_flight;
+        }
+    }
+}
+
+void OrderEntryGateway::uring_send(IoLoop& loop, Connection& conn) {
+    using namespace protocol::order_entry;
+
+    if (conn.send_in_flight || conn.closed.load(std::memory_order_acquire)) {
+        return; // the send's completion calls back here for whatever has been queued since
+    }
+    if (conn.write_offset == conn.write_buffer.size()) {
+        if (!refill_write_buffer(conn)) {
+            return;
+        }
+    }
+    if (loop.ring->send(conn.socket.raw_fd(), std::span(conn.write_buffer).subspan(conn.write_offset),
+                        reinterpret_cast<std::uintptr_t>(&conn) | kSendOp)) {
+        conn.send_in_flight = true;
+        ++loop.in_flight;
+    }
+}
+
+void OrderEntryGateway::accept_ready() {
+    for (std::size_t i = 0; i < kAcceptBatch; ++i) {
+        auto sock = listener_.accept();
+        if (!sock) {
+            return; // nothing pending, or a failure the level-triggered listener will report again
+        }
+        adopt_connection(std::move(*sock));
+    }
+}
+
+bool OrderEntryGateway::read_ready(Connection& conn, std::span<std::byte> chunk) {
+    for (std::size_t i = 0; i < kReadsPerTurn; ++i) {
+        const auto result = conn.socket.try_read(chunk);
+        count(conn.reads);
+        if (result.status == net::TcpSocket::IoStatus::WouldBlock) {
+            return false; // drained -- the next edge brings more
+        }
+        if (result.status == net::TcpSocket::IoStatus::Failed || result.bytes == 0) {
+            close_connection(conn);
+            return false;
+        }
+        conn.read_buffer.append(chunk.first(result.bytes));
+        handle_input(conn);
+    }
+    return true;
+}
+
+void OrderEntryGateway::write_ready(Connection& conn) {
+    while (!conn.closed.load(std::memory_order_acquire)) {
+        if (conn.write_offset < conn.write_buffer.size()) {
+            const auto result = conn.socket.try_write(std::span(conn.write_buffer).subspan(conn.write_offset));
+            count(conn.writes);
+            if (result.status == net::TcpSocket::IoStatus::WouldBlock) {
+                return; // the socket is full; its next writability edge brings this connection back
+            }
+            if (result.status == net::TcpSocket::IoStatus::Failed || result.bytes == 0) {
+                close_connection(conn);
+                return;
             }
+            conn.write_offset += result.bytes;
+            continue;
+        }
+        if (!refill_write_buffer(conn)) {
+            return;
+        }
+    }
+}
 
-            claim_order_ownership(conn, account_id, message);
-            (void)submit_command(std::move(*command));
+bool OrderEntryGateway::refill_write_buffer(Connection& conn) {
+    using namespace protocol::order_entry;
+
+    conn.write_buffer.clear();
+    conn.write_offset = 0;
+    auto stage = [&conn](const Message& message) { encode_message(message, conn.write_buffer); };
+    const std::size_t flush_bytes = std::max<std::size_t>(options_.write_flush_bytes, 1);
+    while (conn.write_buffer.size() < flush_bytes && drain_output(conn, stage) > 0) {
+    }
+    return !conn.write_buffer.empty();
+}
+
+void OrderEntryGateway::connection_reader_loop(Connection& conn) {
+    using namespace protocol::order_entry;
+    place_current_thread("mdh-rd-" + std::to_string(conn.session_id),
+                         options_.placement[ThreadRole::GatewayReader]);
+
+    // Straight into the read buffer: this thread has the connection to
+    // itself, so there is no shared chunk to copy out of.
+    while (true) {
+        auto n = conn.socket.read(conn.read_buffer.writable(kReadChunk));
+        count(conn.reads);
+        if (!n || *n == 0) {
+            break; // error, peer EOF, or this socket was shutdown() by stop() -- connection is done either way
         }
+        conn.read_buffer.commit(*n);
+        handle_input(conn);
     }
 
     // Peer EOF, a read error, or stop()'s shutdown() -- either way this
     // session is over, and nothing should route to it anymore.
+    close_connection(conn);
+}
+
+void OrderEntryGateway::handle_input(Connection& conn) {
+    using namespace protocol::order_entry;
+
+    // Every complete frame in read_buffer, before going back to read() for
+    // more -- a single read() can return several small messages
+    // concatenated together, not just one (see tcp_socket.hpp's own doc
+    // comment on TCP having no atomic-message boundary). Framed in place,
+    // and only then dropped from the buffer, all at once.
+    auto on_frame = [&](std::variant<Message, DecodeError>&& result) {
+        count(conn.messages_in);
+        const auto* message = std::get_if<Message>(&result);
+        if (message == nullptr) {
+            return; // malformed payload for an otherwise well-formed header -- drop just this one frame
+        }
+
+        auto command = to_command(*message);
+        if (!command) {
+            // Decoded fine but isn't a valid client request (e.g. a
+            // gateway -> client type arriving from a client) -- silently
+            // ignored rather than disconnecting the client, since this
+            // protocol has no NAK/error-response message type (see
+            // messages.hpp) to report it with. It is also not something
+            // this session can bind on: identity comes from real
+            // requests only.
+            return;
+        }
+
+        // Every client request carries account_id (see messages.hpp).
+        // The first one binds this session; every later one must agree
+        // with it. account_id.has_value() is what lets that check stay
+        // on this thread's own field instead of taking sessions_mutex_
+        // for every single message.
+        const AccountId account_id = std::visit([](const auto& m) { return m.account_id; }, *message);
+        if (!conn.account_id.has_value()) {
+            bind_session(conn, account_id);
+        } else if (*conn.account_id != account_id) {
+            reject_account_mismatch(conn, *command);
+            return;
+        }
+
+        claim_order_ownership(conn, account_id, *message);
+        (void)submit_command(std::move(*command));
+    };
+    conn.read_buffer.consume(decode_frames(conn.read_buffer.readable(), on_frame));
+}
+
+void OrderEntryGateway::close_connection(Connection& conn) {
     conn.closed.store(true, std::memory_order_release);
     unbind_session(conn);
-    conn.socket.shutdown();       // this connection's writer may be blocked mid-write() on a dead socket
-    conn.wake_cv.notify_all();    // and if it isn't, wake it so it observes conn.closed instead of lingering until stop()
+    if (conn.loop != nullptr && conn.loop->poller) {
+        conn.loop->poller->remove(conn.socket.raw_fd()); // before shutdown(), which would otherwise report a hangup
+    }
+    conn.socket.shutdown(); // this connection's writer may be blocked mid-write() on a dead socket
+    wake_writer(conn);      // and if it isn't, wake it so it observes conn.closed instead of lingering until stop()
 }
 
 void OrderEntryGateway::bind_session(Connection& conn, AccountId account_id) {
@@ -195,13 +757,13 @@ void OrderEntryGateway::bind_session(Connection& conn, AccountId account_id) {
         // cannot end up behind a live one (see Connection::replay_backlog).
         if (auto pending = pending_reports_.find(account_id); pending != pending_reports_.end()) {
             std::lock_guard<std::mutex> replay_lock(conn.replay_mutex);
-            conn.replay_backlog.assign(std::make_move_iterator(pending->second.begin()),
-                                        std::make_move_iterator(pending->second.end()));
+            conn.output_pending.fetch_add(pending->second.size(), std::memory_order_release);
+            conn.replay_backlog = std::move(pending->second);
             pending_reports_.erase(pending);
         }
     }
     conn.account_id = account_id;
-    conn.wake_cv.notify_one(); // there may now be a backlog to write out
+    wake_writer(conn); // there may now be a backlog to write out
 }
 
 void OrderEntryGateway::unbind_session(Connection& conn) {
@@ -209,24 +771,119 @@ void OrderEntryGateway::unbind_session(Connection& conn) {
         return; // never sent a valid request, so it was never in any of the maps below
     }
 
-    std::lock_guard<std::mutex> lock(sessions_mutex_);
-    if (auto sessions = account_sessions_.find(*conn.account_id); sessions != account_sessions_.end()) {
-        auto& bound = sessions->second;
-        bound.erase(std::remove(bound.begin(), bound.end(), &conn), bound.end());
-        if (bound.empty()) {
-            account_sessions_.erase(sessions);
+    bool last_session = false;
+    {
+        std::lock_guard<std::mutex> lock(sessions_mutex_);
+        if (auto sessions = account_sessions_.find(*conn.account_id); sessions != account_sessions_.end()) {
+            auto& bound = sessions->second;
+            bound.erase(std::remove(bound.begin(), bound.end(), &conn), bound.end());
+            if (bound.empty()) {
+                account_sessions_.erase(sessions);
+                last_session = true;
+            }
+        }
+
+        // Only the ids this session owns, found through its own list rather
+        // than by scanning order_owner_ -- every other session's entries are
+        // untouched, and sessions_mutex_, which the routing thread also
+        // needs, is held for this session's orders and no more.
+        // Without cancel-on-disconnect the orders themselves stay in the
+        // book; it's only the record of *which session* to report them to
+        // that goes away, after which route_reports() falls back to the
+        // account's other sessions.
+        for (const OrderKey& key : conn.owned_orders) {
+            order_owner_.erase(key);
         }
+        conn.owned_orders.clear();
+    }
+
+    if (!last_session || !options_.cancel_on_disconnect) {
+        return;
+    }
+
+    // Submitted after sessions_mutex_ is released: retrying a full queue
+    // while holding it would block the routing thread, and through the
+    // event ring the matching thread, which is the only thing that can
+    // drain that queue. The cost of the gap is that a session
+    // binding to this account at the same instant may have an order it
+    // just placed cancelled too -- reported to it like any other cancel,
+    // never lost. A kill switch that was silently dropped would be worse,
+    // so a full queue is retried rather than given up on.
+    const MassCancelCommand cancel{
+        .command_sequence = 0,
+        .account_id = *conn.account_id,
+        .instrument_id = std::nullopt,
+        .side = std::nullopt,
+        .max_orders = options_.mass_cancel_batch,
+    };
+    if (submit_command(cancel)) {
+        return;
+    }
+    if (conn.loop != nullptr && !stop_source_.stop_requested()) {
+        // On the connection's I/O thread, which every other connection on
+        // its loop is waiting for: the loop retries it on its next turns
+        // instead. Only a session that bound ever gets here, and only its
+        // own loop reads for it, so this is that loop's thread.
+        conn.loop->deferred.emplace_back(cancel);
+        return;
+    }
+    // A reader thread, which serves no one else, or stop() once the loops
+    // have exited; stop() only stops the pipeline after both are done.
+    while (!submit_command(cancel)) {
+        std::this_thread::sleep_for(kPollInterval);
+    }
+}
+
+void OrderEntryGateway::submit_deferred(IoLoop& loop) {
+    std::size_t sent = 0;
+    while (sent < loop.deferred.size() && submit_command(loop.deferred[sent])) {
+        ++sent;
+    }
+    loop.deferred.erase(loop.deferred.begin(), loop.deferred.begin() + static_cast<std::ptrdiff_t>(sent));
+}
+
+void OrderEntryGateway::continue_mass_cancel(const ExchangeCommand& command, std::size_t cancelled) {
+    // Rests the queue was full for go first, so each account's slices stay
+    // in order. A full queue means at least a queue's worth of commands is
+    // still to come, each followed by this, so whatever is left here is
+    // submitted before the queue can run dry -- and so before stop() can
+    // see it drained.
+    while (!unfinished_mass_cancels_.empty() && submit_command(unfinished_mass_cancels_.front())) {
+        unfinished_mass_cancels_.pop_front();
+    }
+    const auto* cancel = std::get_if<MassCancelCommand>(&command);
+    if (cancel == nullptr || cancel->max_orders == 0 || cancelled < cancel->max_orders) {
+        return;
+    }
+    // A whole batch may have left more behind. Resubmitted from here, on
+    // the matching thread, rather than looped over in place, so that it
+    // queues behind every command that arrived meanwhile and is sequenced
+    // and journaled as one of its own. At worst the last rest finds nothing.
+    // The commands queued meanwhile may enter orders for this account too --
+    // a session reconnecting to it, say -- so the rest carries the id the
+    // next order entered will get, read here on the matching thread straight
+    // after the first batch, and every later batch leaves newer ones alone.
+    MassCancelCommand rest = *cancel;
+    rest.command_sequence = 0;
+    if (rest.before_exchange_order_id == 0) {
+        rest.before_exchange_order_id = engine_.next_exchange_order_id();
+    }
+    if (!unfinished_mass_cancels_.empty() || !submit_command(rest)) {
+        unfinished_mass_cancels_.push_back(rest);
+    }
+}
+
+void OrderEntryGateway::claim_owner(const OrderKey& key, Connection& conn) {
+    auto [owner, inserted] = order_owner_.try_emplace(key);
+    if (inserted) {
+        owner->second = Owner{.conn = &conn, .entry = conn.owned_orders.insert(conn.owned_orders.end(), key)};
     }
+}
 
-    // A linear scan rather than a per-connection index of the ids it owns:
-    // it runs once per disconnect, on that session's own reader thread,
-    // over a map bounded by the exchange's live orders -- the matching
-    // thread never pays for it. The orders themselves stay in the book
-    // (there is no cancel-on-disconnect here); it's only the record of
-    // *which session* to report them to that goes away, after which
-    // route_event() falls back to the account's other sessions.
-    for (auto it = order_owner_.begin(); it != order_owner_.end();) {
-        it = (it->second == &conn) ? order_owner_.erase(it) : std::next(it);
+void OrderEntryGateway::release_owner(const OrderKey& key) {
+    if (auto owner = order_owner_.find(key); owner != order_owner_.end()) {
+        owner->second.conn->owned_orders.erase(owner->second.entry);
+        order_owner_.erase(owner);
     }
 }
 
@@ -237,32 +894,76 @@ void OrderEntryGateway::reject_account_mismatch(Connection& conn, const Exchange
     // this session is bound to, so the rejection mirrors the request that
     // caused it -- the same convention MatchingEngine follows when it
     // rejects a command. A replace is reported under its original id, also
-    // matching what the engine does for every other replace rejection.
-    const Rejected rejection = std::visit(
-        [](const auto& cmd) {
+    // matching what the engine does for every other replace rejection. A
+    // mass quote gets one per level, or one under id 0 if it has none --
+    // again what the engine would have sent. A mass cancel names no order,
+    // so it is answered under id 0, like the engine's rejection of one.
+    std::vector<ClientOrderId> client_order_ids;
+    std::visit(
+        [&client_order_ids](const auto& cmd) {
             using T = std::decay_t<decltype(cmd)>;
-            Rejected rejected{
-                .account_id = cmd.account_id,
-                .client_order_id = 0,
-                .instrument_id = cmd.instrument_id,
-                .reason = RejectReason::AccountMismatch,
-            };
             if constexpr (std::is_same_v<T, ReplaceOrderCommand>) {
-                rejected.client_order_id = cmd.original_client_order_id;
+                client_order_ids.push_back(cmd.original_client_order_id);
+            } else if constexpr (std::is_same_v<T, MassQuoteCommand>) {
+                for (const QuoteEntry& entry : cmd.entries) {
+                    client_order_ids.push_back(entry.client_order_id);
+                }
+                if (client_order_ids.empty()) {
+                    client_order_ids.push_back(0);
+                }
+            } else if constexpr (std::is_same_v<T, MassCancelCommand>) {
+                client_order_ids.push_back(0);
+            } else if constexpr (!std::is_same_v<T, ClockTickCommand> && !std::is_same_v<T, TradingPhaseCommand>) {
+                client_order_ids.push_back(cmd.client_order_id);
+            }
+        },
+        command);
+    // A clock tick or a phase change is the gateway's own and belongs to no
+    // account, so it is never what this is called for; it still has to
+    // compile.
+    const AccountId account_id = std::visit(
+        [](const auto& cmd) -> AccountId {
+            using T = std::decay_t<decltype(cmd)>;
+            if constexpr (std::is_same_v<T, ClockTickCommand> || std::is_same_v<T, TradingPhaseCommand>) {
+                return 0;
             } else {
-                rejected.client_order_id = cmd.client_order_id;
+                return cmd.account_id;
+            }
+        },
+        command);
+    const InstrumentId instrument_id = std::visit(
+        [](const auto& cmd) -> InstrumentId {
+            using T = std::decay_t<decltype(cmd)>;
+            if constexpr (std::is_same_v<T, MassCancelCommand>) {
+                return cmd.instrument_id.value_or(0);
+            } else if constexpr (std::is_same_v<T, ClockTickCommand>) {
+                return 0;
+            } else {
+                return cmd.instrument_id;
             }
-            return rejected;
         },
         command);
 
     // session_outbound, not outbound: this thread is that queue's single
-    // producer, whereas outbound's is the matching thread (see
+    // producer, whereas outbound's is the routing thread (see
     // Connection::session_outbound). A full queue drops the rejection for
-    // the same reason route_event() drops a report -- the client isn't
+    // the same reason route_reports() drops a report -- the client isn't
     // reading.
-    if (conn.session_outbound.try_push(Message{rejection})) {
-        conn.wake_cv.notify_one();
+    conn.output_pending.fetch_add(client_order_ids.size(), std::memory_order_release);
+    std::size_t queued = 0;
+    for (const ClientOrderId client_order_id : client_order_ids) {
+        queued += conn.session_outbound.try_push(Message{Rejected{
+                      .account_id = account_id,
+                      .client_order_id = client_order_id,
+                      .instrument_id = instrument_id,
+                      .reason = RejectReason::AccountMismatch,
+                  }})
+                      ? 1
+                      : 0;
+    }
+    conn.output_pending.fetch_sub(client_order_ids.size() - queued, std::memory_order_relaxed);
+    if (queued > 0) {
+        wake_writer(conn);
     }
 }
 
@@ -275,15 +976,24 @@ void OrderEntryGateway::claim_order_ownership(Connection& conn, AccountId accoun
         [&](const auto& m) {
             using T = std::decay_t<decltype(m)>;
             if constexpr (std::is_same_v<T, NewOrder> || std::is_same_v<T, CancelOrder>) {
-                order_owner_.try_emplace(OrderKey{account_id, m.client_order_id}, &conn);
+                claim_owner(OrderKey{account_id, m.client_order_id}, conn);
             } else if constexpr (std::is_same_v<T, ReplaceOrder>) {
                 // Only the original id: that's what the engine reports a
                 // failed replace under, so this is what sends the ack back
                 // to whoever asked for it. The new id inherits ownership
                 // from the original if (and only if) the replace actually
                 // succeeds -- see update_order_ownership().
-                order_owner_.try_emplace(OrderKey{account_id, m.original_client_order_id}, &conn);
+                claim_owner(OrderKey{account_id, m.original_client_order_id}, conn);
+            } else if constexpr (std::is_same_v<T, MassQuote>) {
+                // Every level is a new order or a replace under its own
+                // id, so each is claimed as one would be. The levels it
+                // cancels or replaces keep whichever owner they had.
+                for (const MassQuoteEntry& entry : m.entries) {
+                    claim_owner(OrderKey{account_id, entry.client_order_id}, conn);
+                }
             }
+            // A MassCancel claims nothing: each order it cancels is reported
+            // to whoever owns that order already.
         },
         message);
     // First writer wins while the order remains live. A second session of
@@ -295,66 +1005,175 @@ void OrderEntryGateway::claim_order_ownership(Connection& conn, AccountId accoun
 
 void OrderEntryGateway::connection_writer_loop(Connection& conn, std::stop_token token) {
     using namespace protocol::order_entry;
+    place_current_thread("mdh-wr-" + std::to_string(conn.session_id),
+                         options_.placement[ThreadRole::GatewayWriter]);
 
-    // Reports retained while this session's account had nobody connected,
-    // handed over by bind_session(). Drained before anything else so a
-    // reconnecting client reads its history before whatever happens next.
-    auto next_backlog_message = [&conn]() -> std::optional<Message> {
-        std::lock_guard<std::mutex> lock(conn.replay_mutex);
-        if (conn.replay_backlog.empty()) {
-            return std::nullopt;
+    // One encode buffer for the life of the connection, reserved up front
+    // for a whole flush so that no report ever allocates. A failed write
+    // poisons the rest of the batch being consumed: consume() cannot stop
+    // early, and the connection is finished anyway.
+    const std::size_t flush_bytes = std::max<std::size_t>(options_.write_flush_bytes, 1);
+    const auto linger = options_.write_linger;
+    std::vector<std::byte>& buf = conn.write_buffer;
+    buf.reserve(flush_bytes + kWriteHeadroom);
+    std::chrono::steady_clock::time_point gathered_since; // when the first report now in buf went in
+    bool write_failed = false;
+    auto flush = [&] {
+        std::size_t written = 0;
+        while (written < buf.size()) {
+            auto n = conn.socket.write(std::span(buf).subspan(written));
+            count(conn.writes);
+            if (!n || *n == 0) {
+                write_failed = true; // write error, or a 0-byte write on a live socket -- either way, this connection is done
+                break;
+            }
+            written += *n;
         }
-        Message message = std::move(conn.replay_backlog.front());
-        conn.replay_backlog.erase(conn.replay_backlog.begin());
-        return message;
+        buf.clear();
     };
-    auto has_work = [&conn] {
-        std::lock_guard<std::mutex> lock(conn.replay_mutex);
-        return !conn.replay_backlog.empty() || conn.session_outbound.size() > 0 || conn.outbound.size() > 0;
+    auto stage = [&](const Message& message) {
+        if (write_failed) {
+            return;
+        }
+        if (buf.empty() && linger.count() > 0) {
+            gathered_since = std::chrono::steady_clock::now();
+        }
+        encode_message(message, buf);
+        if (buf.size() >= flush_bytes) {
+            flush();
+        }
+    };
+    auto lingered = [&] { return std::chrono::steady_clock::now() - gathered_since >= linger; };
+    // Every producer of anything this checks calls wake_writer() after
+    // publishing it -- route_reports() via deliver(), the reader thread,
+    // bind_session(), close, stop() -- so no wake-up is lost.
+    auto woken = [&] {
+        return token.stop_requested() || conn.closed.load(std::memory_order_acquire) || has_output(conn);
     };
 
     while (!token.stop_requested() && !conn.closed.load(std::memory_order_acquire)) {
-        auto message = next_backlog_message();
-        if (!message) {
-            message = conn.session_outbound.try_pop(); // the gateway's own replies, e.g. an account mismatch
-        }
-        if (!message) {
-            message = conn.outbound.try_pop();
-        }
-        if (!message) {
-            // wait_for()'s predicate is re-checked immediately, before ever
-            // actually sleeping -- so a notify_one() (route_event() below)
-            // or notify_all() (stop(), above) that already happened before
-            // this wait began is never lost, only redundant with this
-            // re-check. kPollInterval is a safety-net timeout only, not the
-            // expected wake path -- see this class's own kPollInterval doc
-            // comment.
-            std::unique_lock<std::mutex> lock(conn.wake_mutex);
-            conn.wake_cv.wait_for(lock, kPollInterval, [&] {
-                return token.stop_requested() || conn.closed.load(std::memory_order_acquire) || has_work();
-            });
+        const std::size_t staged = drain_output(conn, stage);
+        if (write_failed) {
+            break;
+        }
+        if (staged > 0) {
+            // More may be queued behind this batch: gather that too, unless
+            // a linger is set and already up.
+            if (linger.count() == 0 || !lingered()) {
+                continue;
+            }
+        } else if (!buf.empty() && linger.count() > 0 && !lingered()) {
+            // Dry with output gathered: give the routing thread the rest of
+            // the linger to queue more, then drain again. The same wait as
+            // below, only cut short at the deadline.
+            conn.wake.wait_until(woken, gathered_since + linger);
+            continue;
+        }
+        if (!buf.empty()) {
+            flush();
+            if (write_failed) {
+                break;
+            }
             continue;
         }
+        conn.wake.wait_until(woken);
+    }
 
-        std::vector<std::byte> buf;
-        encode_message(*message, buf);
+    // What is staged here has already left its queue, so nothing else will
+    // ever send it: written out before exiting rather than dropped with the
+    // buffer. stop() holds the socket open for this (see writer_finished);
+    // a closed connection's socket is already shut down, and the write
+    // fails at once.
+    if (!write_failed && !buf.empty()) {
+        flush();
+    }
+    conn.writer_finished.store(true, std::memory_order_release);
+}
 
-        std::size_t written = 0;
-        while (written < buf.size()) {
-            auto n = conn.socket.write(std::span(buf).subspan(written));
-            if (!n || *n == 0) {
-                return; // write error, or a 0-byte write on a live socket -- either way, this connection is done
-            }
-            written += *n;
+template <typename Send>
+std::size_t OrderEntryGateway::drain_output(Connection& conn, Send&& send) {
+    using namespace protocol::order_entry;
+
+    // Reports retained while this session's account had nobody connected,
+    // handed over by bind_session(). Drained before anything else so a
+    // reconnecting client reads its history before whatever happens next.
+    std::optional<Message> backlog;
+    {
+        std::lock_guard<std::mutex> lock(conn.replay_mutex);
+        if (!conn.replay_backlog.empty()) {
+            backlog = std::move(conn.replay_backlog.front());
+            conn.replay_backlog.pop_front();
         }
     }
+    if (backlog) {
+        conn.output_pending.fetch_sub(1, std::memory_order_relaxed);
+        send(static_cast<const Message&>(*backlog));
+        count(conn.messages_out);
+        return 1;
+    }
+    std::size_t sent = conn.session_outbound.consume(kWriterBatch, send); // the gateway's own replies, e.g. an account mismatch
+    if (sent == 0) {
+        sent = conn.outbound.consume(kWriterBatch, send);
+    }
+    conn.output_pending.fetch_sub(sent, std::memory_order_relaxed);
+    count(conn.messages_out, sent);
+    return sent;
+}
+
+bool OrderEntryGateway::has_output(Connection& conn) {
+    return conn.output_pending.load(std::memory_order_acquire) > 0;
+}
+
+void OrderEntryGateway::wake_writer(Connection& conn) {
+    if (conn.loop == nullptr) {
+        conn.wake.notify(); // a fence and a load, unless the writer is parked -- see WaitStrategy
+        return;
+    }
+    // Already on the ready list, and not yet taken off it: the loop will
+    // drain whatever was just queued along with the rest.
+    if (conn.output_scheduled.exchange(true, std::memory_order_acq_rel)) {
+        return;
+    }
+    IoLoop& loop = *conn.loop;
+    {
+        std::lock_guard<std::mutex> lock(loop.ready_mutex);
+        loop.ready.push_back(&conn);
+    }
+    if (!loop.wake_pending.exchange(true, std::memory_order_acq_rel)) {
+        loop.wake();
+    }
 }
 
 void OrderEntryGateway::route_event(const ExchangeEvent& event) {
+    // The ledger belongs to the matching thread, so the one thing routing
+    // needs from it is read here, as the event is produced -- which is also
+    // the moment the answer is about.
+    const auto* rejected = std::get_if<OrderRejected>(&event);
+    if (std::holds_alternative<OrderCancelled>(event)) {
+        ++cancelled_in_command_; // see continue_mass_cancel()
+    }
+    const bool hold_remains =
+        rejected != nullptr && ledger_.find_hold(rejected->account_id, rejected->client_order_id).has_value();
+
+    if (events_) {
+        RoutedEvent& slot = events_->claim(); // published with the rest of this command's events, in after_command()
+        slot.event = event;
+        slot.hold_remains = hold_remains;
+        return;
+    }
+    const RoutedEvent routed{.event = event, .hold_remains = hold_remains};
+    publish_event(routed);
+    route_reports(routed);
+}
+
+void OrderEntryGateway::publish_event(const RoutedEvent& routed) {
     if (options_.extra_event_sink) {
-        options_.extra_event_sink(event); // e.g. market-data publishing -- see its own doc comment
+        options_.extra_event_sink(routed.event); // e.g. market-data publishing -- see its own doc comment
     }
+}
 
+void OrderEntryGateway::route_reports(const RoutedEvent& routed) {
+    const ExchangeEvent& event = routed.event;
     auto reports = to_execution_reports(event);
     if (reports.empty()) {
         return; // e.g. a Book* event -- see to_execution_reports()'s own doc comment
@@ -364,14 +1183,14 @@ void OrderEntryGateway::route_event(const ExchangeEvent& event) {
     for (auto& [key, message] : reports) {
         // 1. The session that submitted this order, if it's still here.
         if (auto owner = order_owner_.find(key);
-            owner != order_owner_.end() && !owner->second->closed.load(std::memory_order_acquire)) {
-            deliver(*owner->second, std::move(message));
+            owner != order_owner_.end() && !owner->second.conn->closed.load(std::memory_order_acquire)) {
+            deliver(*owner->second.conn, std::move(message));
             continue;
         }
 
         // 2. Otherwise one other live session of the account. Reached
         // when the owning session disconnected but left a resting order
-        // behind (nothing cancels orders on disconnect), or when the
+        // behind (and cancel_on_disconnect is off), or when the
         // command came from submit_command() rather than a socket at all.
         auto sessions = account_sessions_.find(key.account_id);
         if (sessions != account_sessions_.end()) {
@@ -400,29 +1219,28 @@ void OrderEntryGateway::route_event(const ExchangeEvent& event) {
         pending.push_back(std::move(message));
     }
 
-    update_order_ownership(event);
+    update_order_ownership(routed);
 }
 
 void OrderEntryGateway::deliver(Connection& conn, protocol::order_entry::Message message) {
     // A full outbound queue means that connection's writer thread has
-    // fallen behind; dropped here rather than blocking (this function runs
-    // on the matching thread, see class-level comment on why it must not
-    // block) -- there is no synchronous caller here to hand a rejection
+    // fallen behind; dropped here rather than blocking (a routing thread
+    // that waited would fill the event ring and stall matching, see the
+    // class comment) -- there is no synchronous caller here to hand a rejection
     // back to the way MatchingPipeline::submit() can. Deliberately *not*
     // retained in pending_reports_ either: that exists for an account with
     // nobody listening, not for a client that is connected and not reading.
+    conn.output_pending.fetch_add(1, std::memory_order_release);
     if (conn.outbound.try_push(std::move(message))) {
-        // No lock needed here -- see Connection::wake_cv's doc comment on
-        // why a notification racing ahead of the writer thread starting
-        // its wait is never lost, only redundant with that wait's own
-        // predicate re-check.
-        conn.wake_cv.notify_one();
+        wake_writer(conn);
+    } else {
+        conn.output_pending.fetch_sub(1, std::memory_order_relaxed);
     }
 }
 
-void OrderEntryGateway::update_order_ownership(const ExchangeEvent& event) {
+void OrderEntryGateway::update_order_ownership(const RoutedEvent& routed) {
     std::visit(
-        [this](const auto& ev) {
+        [this, &routed](const auto& ev) {
             using T = std::decay_t<decltype(ev)>;
             if constexpr (std::is_same_v<T, OrderRejected>) {
                 // A rejection normally means nothing is live under this id,
@@ -432,22 +1250,29 @@ void OrderEntryGateway::update_order_ownership(const ExchangeEvent& event) {
                 // risk-rejected replace): those still have a ledger hold,
                 // so ownership must stay with whoever placed the live
                 // order. A risk-rejected *new* order never opened a hold,
-                // so find_hold is empty and we erase as before.
-                if (!ledger_.find_hold(ev.account_id, ev.client_order_id).has_value()) {
-                    order_owner_.erase(OrderKey{ev.account_id, ev.client_order_id});
+                // so find_hold is empty and we erase as before. The
+                // ledger was asked on the matching thread -- see
+                // route_event().
+                if (!routed.hold_remains) {
+                    release_owner(OrderKey{ev.account_id, ev.client_order_id});
                 }
             } else if constexpr (std::is_same_v<T, OrderCancelled>) {
-                order_owner_.erase(OrderKey{ev.account_id, ev.client_order_id});
+                release_owner(OrderKey{ev.account_id, ev.client_order_id});
             } else if constexpr (std::is_same_v<T, OrderReplaced>) {
                 // The order lives on under a new id, so its owner follows
                 // it there -- claim_order_ownership() deliberately doesn't
                 // register the new id up front, since a rejected replace
                 // would then leave behind a record of an order that never
-                // existed.
+                // existed. The owning session's list entry is relabelled
+                // in place rather than replaced, so it keeps its position.
                 const OrderKey original{ev.account_id, ev.original_client_order_id};
                 if (auto owner = order_owner_.find(original); owner != order_owner_.end()) {
-                    order_owner_[OrderKey{ev.account_id, ev.new_client_order_id}] = owner->second;
-                    order_owner_.erase(original);
+                    const OrderKey renamed{ev.account_id, ev.new_client_order_id};
+                    const Owner moved = owner->second;
+                    order_owner_.erase(owner);
+                    release_owner(renamed); // a stale record under the new id would otherwise leak its list entry
+                    *moved.entry = renamed;
+                    order_owner_.insert_or_assign(renamed, moved);
                 }
             } else if constexpr (std::is_same_v<T, TradeExecuted>) {
                 // Mirrors the engine erasing a fully-filled order from its
@@ -455,7 +1280,7 @@ void OrderEntryGateway::update_order_ownership(const ExchangeEvent& event) {
                 // leaves the order, and this record, in place.
                 for (const auto& side : {ev.buyer, ev.seller}) {
                     if (side.remaining_quantity == 0) {
-                        order_owner_.erase(OrderKey{side.account_id, side.client_order_id});
+                        release_owner(OrderKey{side.account_id, side.client_order_id});
                     }
                 }
             }
@@ -463,13 +1288,13 @@ void OrderEntryGateway::update_order_ownership(const ExchangeEvent& event) {
             // the former's record was made when the command was submitted,
             // the latter are anonymous.
         },
-        event);
+        routed.event);
 }
 
-std::optional<ExchangeCommand> OrderEntryGateway::to_command(const protocol::order_entry::Message& message) {
+std::optional<ExchangeCommand> OrderEntryGateway::to_command(const protocol::order_entry::Message& message) const {
     using namespace protocol::order_entry;
     return std::visit(
-        [](const auto& msg) -> std::optional<ExchangeCommand> {
+        [this](const auto& msg) -> std::optional<ExchangeCommand> {
             using T = std::decay_t<decltype(msg)>;
             if constexpr (std::is_same_v<T, NewOrder>) {
                 return ExchangeCommand{NewOrderCommand{
@@ -482,6 +1307,8 @@ std::optional<ExchangeCommand> OrderEntryGateway::to_command(const protocol::ord
                     .quantity = msg.quantity,
                     .order_type = msg.order_type,
                     .time_in_force = msg.time_in_force,
+                    .expire_at = msg.expire_at,
+                    .stop_price = msg.stop_price,
                 }};
             } else if constexpr (std::is_same_v<T, CancelOrder>) {
                 return ExchangeCommand{CancelOrderCommand{
@@ -500,6 +1327,31 @@ std::optional<ExchangeCommand> OrderEntryGateway::to_command(const protocol::ord
                     .new_price = msg.new_price,
                     .new_quantity = msg.new_quantity,
                 }};
+            } else if constexpr (std::is_same_v<T, MassQuote>) {
+                MassQuoteCommand command{
+                    .command_sequence = 0,
+                    .account_id = msg.account_id,
+                    .instrument_id = msg.instrument_id,
+                    .entries = {},
+                };
+                command.entries.reserve(msg.entries.size());
+                for (const MassQuoteEntry& entry : msg.entries) {
+                    command.entries.push_back(QuoteEntry{
+                        .client_order_id = entry.client_order_id,
+                        .side = entry.side,
+                        .price = entry.price,
+                        .quantity = entry.quantity,
+                    });
+                }
+                return ExchangeCommand{std::move(command)};
+            } else if constexpr (std::is_same_v<T, MassCancel>) {
+                return ExchangeCommand{MassCancelCommand{
+                    .command_sequence = 0,
+                    .account_id = msg.account_id,
+                    .instrument_id = msg.instrument_id,
+                    .side = msg.side,
+                    .max_orders = options_.mass_cancel_batch,
+                }};
             } else {
                 // Accepted/Rejected/Cancelled/Replaced/TradeReport: gateway
                 // -> client message types, never valid as a client request.
@@ -509,79 +1361,78 @@ std::optional<ExchangeCommand> OrderEntryGateway::to_command(const protocol::ord
         message);
 }
 
-std::vector<std::pair<OrderEntryGateway::OrderKey, protocol::order_entry::Message>>
-OrderEntryGateway::to_execution_reports(const ExchangeEvent& event) {
+OrderEntryGateway::ExecutionReports OrderEntryGateway::to_execution_reports(const ExchangeEvent& event) {
     using namespace protocol::order_entry;
-    std::vector<std::pair<OrderKey, Message>> reports;
+    ExecutionReports reports;
 
     std::visit(
         [&reports](const auto& ev) {
             using T = std::decay_t<decltype(ev)>;
             if constexpr (std::is_same_v<T, OrderAccepted>) {
-                reports.emplace_back(OrderKey{ev.account_id, ev.client_order_id},
-                                      Message{Accepted{
-                                          .account_id = ev.account_id,
-                                          .client_order_id = ev.client_order_id,
-                                          .exchange_order_id = ev.exchange_order_id,
-                                          .instrument_id = ev.instrument_id,
-                                          .side = ev.side,
-                                          .price = ev.price,
-                                          .quantity = ev.quantity,
-                                          .order_type = ev.order_type,
-                                          .time_in_force = ev.time_in_force,
-                                      }});
+                reports.push(OrderKey{ev.account_id, ev.client_order_id},
+                               Message{Accepted{
+                                   .account_id = ev.account_id,
+                                   .client_order_id = ev.client_order_id,
+                                   .exchange_order_id = ev.exchange_order_id,
+                                   .instrument_id = ev.instrument_id,
+                                   .side = ev.side,
+                                   .price = ev.price,
+                                   .quantity = ev.quantity,
+                                   .order_type = ev.order_type,
+                                   .time_in_force = ev.time_in_force,
+                               }});
             } else if constexpr (std::is_same_v<T, OrderRejected>) {
-                reports.emplace_back(OrderKey{ev.account_id, ev.client_order_id},
-                                      Message{Rejected{
-                                          .account_id = ev.account_id,
-                                          .client_order_id = ev.client_order_id,
-                                          .instrument_id = ev.instrument_id,
-                                          .reason = ev.reason,
-                                      }});
+                reports.push(OrderKey{ev.account_id, ev.client_order_id},
+                               Message{Rejected{
+                                   .account_id = ev.account_id,
+                                   .client_order_id = ev.client_order_id,
+                                   .instrument_id = ev.instrument_id,
+                                   .reason = ev.reason,
+                               }});
             } else if constexpr (std::is_same_v<T, OrderCancelled>) {
-                reports.emplace_back(OrderKey{ev.account_id, ev.client_order_id},
-                                      Message{Cancelled{
-                                          .account_id = ev.account_id,
-                                          .client_order_id = ev.client_order_id,
-                                          .exchange_order_id = ev.exchange_order_id,
-                                          .instrument_id = ev.instrument_id,
-                                      }});
+                reports.push(OrderKey{ev.account_id, ev.client_order_id},
+                               Message{Cancelled{
+                                   .account_id = ev.account_id,
+                                   .client_order_id = ev.client_order_id,
+                                   .exchange_order_id = ev.exchange_order_id,
+                                   .instrument_id = ev.instrument_id,
+                               }});
             } else if constexpr (std::is_same_v<T, OrderReplaced>) {
                 // Keyed on the *original* id: that's the one the requesting
                 // session claimed when it submitted the replace (see
                 // claim_order_ownership()); the new id only takes ownership
                 // over once this event has been routed.
-                reports.emplace_back(OrderKey{ev.account_id, ev.original_client_order_id},
-                                      Message{Replaced{
-                                          .account_id = ev.account_id,
-                                          .original_client_order_id = ev.original_client_order_id,
-                                          .new_client_order_id = ev.new_client_order_id,
-                                          .exchange_order_id = ev.exchange_order_id,
-                                          .instrument_id = ev.instrument_id,
-                                          .new_price = ev.new_price,
-                                          .new_quantity = ev.new_quantity,
-                                      }});
+                reports.push(OrderKey{ev.account_id, ev.original_client_order_id},
+                               Message{Replaced{
+                                   .account_id = ev.account_id,
+                                   .original_client_order_id = ev.original_client_order_id,
+                                   .new_client_order_id = ev.new_client_order_id,
+                                   .exchange_order_id = ev.exchange_order_id,
+                                   .instrument_id = ev.instrument_id,
+                                   .new_price = ev.new_price,
+                                   .new_quantity = ev.new_quantity,
+                               }});
             } else if constexpr (std::is_same_v<T, TradeExecuted>) {
-                reports.emplace_back(OrderKey{ev.buyer.account_id, ev.buyer.client_order_id},
-                                      Message{TradeReport{
-                                          .account_id = ev.buyer.account_id,
-                                          .client_order_id = ev.buyer.client_order_id,
-                                          .exchange_order_id = ev.buyer.exchange_order_id,
-                                          .instrument_id = ev.instrument_id,
-                                          .price = ev.price,
-                                          .quantity = ev.quantity,
-                                          .remaining_quantity = ev.buyer.remaining_quantity,
-                                      }});
-                reports.emplace_back(OrderKey{ev.seller.account_id, ev.seller.client_order_id},
-                                      Message{TradeReport{
-                                          .account_id = ev.seller.account_id,
-                                          .client_order_id = ev.seller.client_order_id,
-                                          .exchange_order_id = ev.seller.exchange_order_id,
-                                          .instrument_id = ev.instrument_id,
-                                          .price = ev.price,
-                                          .quantity = ev.quantity,
-                                          .remaining_quantity = ev.seller.remaining_quantity,
-                                      }});
+                reports.push(OrderKey{ev.buyer.account_id, ev.buyer.client_order_id},
+                               Message{TradeReport{
+                                   .account_id = ev.buyer.account_id,
+                                   .client_order_id = ev.buyer.client_order_id,
+                                   .exchange_order_id = ev.buyer.exchange_order_id,
+                                   .instrument_id = ev.instrument_id,
+                                   .price = ev.price,
+                                   .quantity = ev.quantity,
+                                   .remaining_quantity = ev.buyer.remaining_quantity,
+                               }});
+                reports.push(OrderKey{ev.seller.account_id, ev.seller.client_order_id},
+                               Message{TradeReport{
+                                   .account_id = ev.seller.account_id,
+                                   .client_order_id = ev.seller.client_order_id,
+                                   .exchange_order_id = ev.seller.exchange_order_id,
+                                   .instrument_id = ev.instrument_id,
+                                   .price = ev.price,
+                                   .quantity = ev.quantity,
+                                   .remaining_quantity = ev.seller.remaining_quantity,
+                               }});
             }
             // BookOrderAdded/BookOrderReduced/BookOrderRemoved: intentionally
             // no-op -- see this function's own doc comment.
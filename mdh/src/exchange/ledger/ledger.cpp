@@ -117,7 +117,7 @@ void Ledger::settle_leg(const TradeCounterparty& leg, Side side, InstrumentId in
 }
 
 void Ledger::on_order_accepted(const OrderAccepted& event) {
-    if (event.time_in_force != TimeInForce::GTC) {
+    if (event.time_in_force != TimeInForce::GTC && event.time_in_force != TimeInForce::GTD) {
         return; // IOC/FOK: never reserved, see class-level comment
     }
     open_hold(event.account_id, event.client_order_id, event.instrument_id, event.side, event.price, event.quantity);
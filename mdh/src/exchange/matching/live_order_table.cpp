@@ -0,0 +1,112 @@
+#include "exchange/matching/live_order_table.hpp"
+
+#include <utility>
+
+namespace mdh::exchange {
+namespace {
+
+// Smallest capacity that holds `entries` at the load bound. Never zero, so
+// that home_of() always has a slot to land in once something is inserted.
+std::size_t capacity_for(std::size_t entries, std::size_t numerator, std::size_t denominator) {
+    const std::size_t capacity = (entries * denominator + numerator - 1) / numerator;
+    return capacity < 8 ? 8 : capacity;
+}
+
+} // namespace
+
+LiveOrderTable::LiveOrderTable(std::size_t expected_entries) { reserve(expected_entries); }
+
+void LiveOrderTable::reserve(std::size_t entries) {
+    if (entries <= max_size_ && capacity_ != 0) {
+        return;
+    }
+    rehash(capacity_for(entries, kLoadNumerator, kLoadDenominator));
+}
+
+void LiveOrderTable::insert_or_assign(const LiveKey& key, const OrderRef& ref) {
+    if (OrderRef* existing = find(key)) {
+        *existing = ref;
+        return;
+    }
+    if (size_ >= max_size_) {
+        rehash(capacity_ * 2);
+    }
+    Entry entry{key, ref};
+    // A run too long to record is a sign of too little room, not of a bad
+    // key, so the cure is the same as for load: more slots. place() hands
+    // back whichever entry it could not seat, and that one goes in next.
+    while (!place(entry)) {
+        rehash(capacity_ * 2);
+    }
+    ++size_;
+}
+
+bool LiveOrderTable::place(Entry& entry) {
+    std::size_t index = home_of(entry.key);
+    std::uint8_t distance = 1;
+    for (;;) {
+        const std::uint8_t here = distance_[index];
+        if (here == kEmpty) {
+            entries_[index] = entry;
+            distance_[index] = distance;
+            return true;
+        }
+        // Robin Hood: whichever of the two is further from home keeps the
+        // slot, and the other carries on. That is what bounds a lookup --
+        // every slot an entry passes holds something at least as far out.
+        if (here < distance) {
+            std::swap(entries_[index], entry);
+            distance_[index] = distance;
+            distance = here;
+        }
+        if (distance == kMaxDistance) {
+            return false;
+        }
+        ++distance;
+        index = next(index);
+    }
+}
+
+void LiveOrderTable::erase_at(std::size_t index) {
+    // Backward shift: pull each following entry that is not already at home
+    // one slot closer to it, until an empty slot or an entry at home. The
+    // table then looks exactly as if the erased key had never been inserted,
+    // so there is nothing left behind for lookups to step over.
+    for (std::size_t following = next(index); distance_[following] > 1; following = next(following)) {
+        entries_[index] = entries_[following];
+        distance_[index] = static_cast<std::uint8_t>(distance_[following] - 1);
+        index = following;
+    }
+    distance_[index] = kEmpty;
+    --size_;
+}
+
+void LiveOrderTable::rehash(std::size_t capacity) {
+    std::unique_ptr<Entry[]> entries = std::move(entries_);
+    std::vector<std::uint8_t> distance = std::move(distance_);
+    const std::size_t old_capacity = capacity_;
+
+    for (;;) {
+        capacity_ = capacity;
+        max_size_ = capacity / kLoadDenominator * kLoadNumerator +
+                    capacity % kLoadDenominator * kLoadNumerator / kLoadDenominator;
+        entries_ = std::make_unique_for_overwrite<Entry[]>(capacity);
+        distance_.assign(capacity, kEmpty);
+
+        bool placed_all = true;
+        for (std::size_t i = 0; i < old_capacity && placed_all; ++i) {
+            if (distance[i] != kEmpty) {
+                Entry entry = entries[i];
+                placed_all = place(entry);
+            }
+        }
+        if (placed_all) {
+            return;
+        }
+        // Only reachable with a hash that clusters far worse than this one
+        // does; start over from the old array with twice the room.
+        capacity *= 2;
+    }
+}
+
+} // namespace mdh::exchange
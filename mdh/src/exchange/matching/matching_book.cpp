@@ -1,5 +1,6 @@
 #include "exchange/matching/matching_book.hpp"
 
+#include <algorithm>
 #include <bit>
 #include <cstddef>
 #include <utility>
@@ -7,8 +8,8 @@
 namespace mdh::exchange {
 namespace {
 
-// This book allocates one node size from its pool: 48 bytes for an overflow
-// map node (a Price, a two-index LevelSlot, and the tree's own links). Orders
+// This book allocates one node size from its pool: 64 bytes for an overflow
+// map node (a Price, a LevelSlot, and the tree's own links). Orders
 // live in the slab and in-band levels in the ladder, so neither reaches the
 // allocator one element at a time.
 //
@@ -18,7 +19,7 @@ namespace {
 // its fixed pools, sending anything larger to an adhoc fallback list whose
 // deallocate is a linear scan -- which turns a book that cancels as fast as
 // it rests into quadratic time. 1024 therefore pools blocks up to 256 bytes,
-// well clear of the 48-byte map node, while still leaving genuinely large
+// well clear of the 64-byte map node, while still leaving genuinely large
 // allocations to the upstream allocator where they belong.
 // bench_matching_memory is the guard: if a node ever stops being pooled,
 // allocations per operation jump straight back up.
@@ -50,32 +51,67 @@ constexpr std::size_t kMaxBlocksPerChunk = 4096;
 // ── SideIndex: a tick ladder over a band, plus a map for the rest ──────────
 
 MatchingBook::SideIndex::SideIndex(Side side, std::uint32_t band_ticks, std::pmr::memory_resource* resource)
-    : side_(side), band_ticks_(band_ticks), overflow_(resource) {}
+    : side_(side), initial_band_(band_ticks), preferred_band_(band_ticks), overflow_(resource) {}
 
 void MatchingBook::SideIndex::anchor(Price price) {
     // Centred, because a book grows in both directions from wherever it
     // starts and there is no reason to guess which way it will go first.
     base_ = price - static_cast<Price>(band_ticks_ / 2);
     anchored_ = true;
-    if (ladder_ == nullptr) {
-        // Uninitialised on purpose: see the class comment. The bitmap is
-        // what makes a level's contents meaningful, and it is zeroed.
-        ladder_ = std::make_unique_for_overwrite<LevelSlot[]>(band_ticks_);
-        occupancy_.assign(words_for(band_ticks_), 0);
-        mid_summary_.assign(words_for(static_cast<std::uint32_t>(occupancy_.size())), 0);
+    rebasing_ = false;
+}
+
+void MatchingBook::SideIndex::materialise(std::uint32_t band_ticks) {
+    band_ticks_ = band_ticks;
+    // Uninitialised on purpose: see the class comment. The bitmap is what
+    // makes a level's contents meaningful, and it is zeroed.
+    ladder_ = std::make_unique_for_overwrite<LevelSlot[]>(band_ticks_);
+    occupancy_.assign(words_for(band_ticks_), 0);
+    mid_summary_.assign(words_for(static_cast<std::uint32_t>(occupancy_.size())), 0);
+    summary_ = 0;
+    laddered_levels_ = 0;
+    anchored_ = false;
+    rebasing_ = false;
+    if (overflow_.empty()) {
+        // The next insert anchors it, as a new book's first order always has.
+        return;
+    }
+    // Levels that rested while there was no ladder, or that a narrower one
+    // pushed out. Centring on the best puts the touch mid-band, which is
+    // where maintain() wants it, and everything the band now covers moves in.
+    anchor(best_price());
+    const Price end = base_ + static_cast<Price>(band_ticks_);
+    for (auto level = overflow_.lower_bound(base_); level != overflow_.end() && level->first < end;) {
+        admit(level++);
     }
 }
 
-void MatchingBook::SideIndex::set_occupied(std::uint32_t tick) {
-    const std::uint32_t word = tick >> 6U;
-    occupancy_[word] |= 1ULL << (tick & 63U);
+void MatchingBook::SideIndex::release() {
+    while (laddered_levels_ != 0) {
+        evict(price_of(lowest_occupied()));
+    }
+    // Swapped out rather than cleared: clear() keeps the capacity, and
+    // giving the memory back is the point.
+    ladder_.reset();
+    std::vector<std::uint64_t>().swap(occupancy_);
+    std::vector<std::uint64_t>().swap(mid_summary_);
+    band_ticks_ = 0;
+    anchored_ = false;
+    rebasing_ = false;
+}
+
+void MatchingBook::SideIndex::set_occupied(std::uint32_t slot) {
+    ++laddered_levels_;
+    const std::uint32_t word = slot >> 6U;
+    occupancy_[word] |= 1ULL << (slot & 63U);
     mid_summary_[word >> 6U] |= 1ULL << (word & 63U);
     summary_ |= 1ULL << (word >> 6U);
 }
 
-void MatchingBook::SideIndex::clear_occupied(std::uint32_t tick) {
-    const std::uint32_t word = tick >> 6U;
-    occupancy_[word] &= ~(1ULL << (tick & 63U));
+void MatchingBook::SideIndex::clear_occupied(std::uint32_t slot) {
+    --laddered_levels_;
+    const std::uint32_t word = slot >> 6U;
+    occupancy_[word] &= ~(1ULL << (slot & 63U));
     if (occupancy_[word] != 0) {
         return;
     }
@@ -88,11 +124,11 @@ void MatchingBook::SideIndex::clear_occupied(std::uint32_t tick) {
     }
 }
 
-bool MatchingBook::SideIndex::is_occupied(std::uint32_t tick) const {
-    return (occupancy_[tick >> 6U] & (1ULL << (tick & 63U))) != 0;
+bool MatchingBook::SideIndex::is_occupied(std::uint32_t slot) const {
+    return (occupancy_[slot >> 6U] & (1ULL << (slot & 63U))) != 0;
 }
 
-std::uint32_t MatchingBook::SideIndex::highest_occupied() const {
+std::uint32_t MatchingBook::SideIndex::highest_set() const {
     if (summary_ == 0) {
         return band_ticks_;
     }
@@ -101,7 +137,7 @@ std::uint32_t MatchingBook::SideIndex::highest_occupied() const {
     return (word << 6U) | highest_bit(occupancy_[word]);
 }
 
-std::uint32_t MatchingBook::SideIndex::lowest_occupied() const {
+std::uint32_t MatchingBook::SideIndex::lowest_set() const {
     if (summary_ == 0) {
         return band_ticks_;
     }
@@ -110,14 +146,14 @@ std::uint32_t MatchingBook::SideIndex::lowest_occupied() const {
     return (word << 6U) | lowest_bit(occupancy_[word]);
 }
 
-std::uint32_t MatchingBook::SideIndex::highest_occupied_below(std::uint32_t tick) const {
-    if (summary_ == 0 || tick == 0) {
+std::uint32_t MatchingBook::SideIndex::highest_set_below(std::uint32_t slot) const {
+    if (summary_ == 0 || slot == 0) {
         return band_ticks_;
     }
     // Within the starting word first: the common case when levels are dense
     // is that the answer is a few bits away and no summary is consulted.
-    std::uint32_t word = tick >> 6U;
-    if (const std::uint64_t rest = occupancy_[word] & mask_below(tick & 63U); rest != 0) {
+    std::uint32_t word = slot >> 6U;
+    if (const std::uint64_t rest = occupancy_[word] & mask_below(slot & 63U); rest != 0) {
         return (word << 6U) | highest_bit(rest);
     }
     // Then the next non-empty word below, found through the two summary
@@ -136,12 +172,12 @@ std::uint32_t MatchingBook::SideIndex::highest_occupied_below(std::uint32_t tick
     return (word << 6U) | highest_bit(occupancy_[word]);
 }
 
-std::uint32_t MatchingBook::SideIndex::lowest_occupied_above(std::uint32_t tick) const {
-    if (summary_ == 0 || tick + 1U >= band_ticks_) {
+std::uint32_t MatchingBook::SideIndex::lowest_set_above(std::uint32_t slot) const {
+    if (summary_ == 0 || slot + 1U >= band_ticks_) {
         return band_ticks_;
     }
-    std::uint32_t word = tick >> 6U;
-    if (const std::uint64_t rest = occupancy_[word] & mask_above(tick & 63U); rest != 0) {
+    std::uint32_t word = slot >> 6U;
+    if (const std::uint64_t rest = occupancy_[word] & mask_above(slot & 63U); rest != 0) {
         return (word << 6U) | lowest_bit(rest);
     }
     std::uint32_t mid = word >> 6U;
@@ -158,29 +194,100 @@ std::uint32_t MatchingBook::SideIndex::lowest_occupied_above(std::uint32_t tick)
     return (word << 6U) | lowest_bit(occupancy_[word]);
 }
 
+// ── Tick order over the ring ────────────────────────────────────────────────
+//
+// Tick 0 is the base, at slot slot_of(base_), and ticks ascend through the
+// slots from there, wrapping past the end of the array. So the band in
+// price order is slots [origin, band) followed by slots [0, origin), and
+// every search by tick below is the slot search over whichever of those two
+// runs it needs, in the right order.
+
+std::uint32_t MatchingBook::SideIndex::highest_occupied() const {
+    if (summary_ == 0) {
+        return band_ticks_;
+    }
+    // The top of the band is the wrapped run, [0, origin).
+    std::uint32_t slot = highest_set_below(slot_of(base_));
+    if (slot == band_ticks_) {
+        // Nothing there, so whatever is highest overall is in [origin, band).
+        slot = highest_set();
+    }
+    return slot == band_ticks_ ? band_ticks_ : tick_of_slot(slot);
+}
+
+std::uint32_t MatchingBook::SideIndex::lowest_occupied() const {
+    // Also what keeps a side with no ladder at all away from the bitmap.
+    if (summary_ == 0) {
+        return band_ticks_;
+    }
+    const std::uint32_t origin = slot_of(base_);
+    std::uint32_t slot = is_occupied(origin) ? origin : lowest_set_above(origin);
+    if (slot == band_ticks_) {
+        slot = lowest_set();
+    }
+    return slot == band_ticks_ ? band_ticks_ : tick_of_slot(slot);
+}
+
+std::uint32_t MatchingBook::SideIndex::highest_occupied_below(std::uint32_t tick) const {
+    if (summary_ == 0 || tick == 0) {
+        return band_ticks_;
+    }
+    const std::uint32_t origin = slot_of(base_);
+    const std::uint32_t slot = slot_of(price_of(tick));
+    const std::uint32_t below = highest_set_below(slot);
+    if (slot > origin) {
+        // Ticks [0, tick) are the unwrapped slots [origin, slot).
+        return below != band_ticks_ && below >= origin ? tick_of_slot(below) : band_ticks_;
+    }
+    // Wrapped: [0, slot) holds the higher ticks, then [origin, band).
+    if (below != band_ticks_) {
+        return tick_of_slot(below);
+    }
+    const std::uint32_t highest = highest_set();
+    return highest != band_ticks_ && highest >= origin ? tick_of_slot(highest) : band_ticks_;
+}
+
+std::uint32_t MatchingBook::SideIndex::lowest_occupied_above(std::uint32_t tick) const {
+    if (summary_ == 0 || tick + 1U >= band_ticks_) {
+        return band_ticks_;
+    }
+    const std::uint32_t origin = slot_of(base_);
+    const std::uint32_t slot = slot_of(price_of(tick));
+    const std::uint32_t above = lowest_set_above(slot);
+    if (slot < origin) {
+        // Ticks past `tick` are the slots (slot, origin).
+        return above < origin ? tick_of_slot(above) : band_ticks_;
+    }
+    // Slots (slot, band) first, then the wrapped run [0, origin).
+    if (above != band_ticks_) {
+        return tick_of_slot(above);
+    }
+    const std::uint32_t lowest = lowest_set();
+    return lowest < origin ? tick_of_slot(lowest) : band_ticks_;
+}
+
 MatchingBook::LevelSlot& MatchingBook::SideIndex::level_for(Price price) {
     // A side with nothing in it has no reason to keep its old base, so an
     // emptied book re-anchors here rather than spending the rest of its life
-    // in the overflow map. This is not a sliding band: nothing that is
-    // already resting ever moves.
-    if (band_ticks_ != 0 && (!anchored_ || empty())) {
+    // in the overflow map.
+    if (has_ladder() && (!anchored_ || empty())) {
         anchor(price);
     }
     if (!in_band(price)) {
         return overflow_[price];
     }
-    const std::uint32_t tick = tick_of(price);
-    if (!is_occupied(tick)) {
-        set_occupied(tick);
-        ladder_[tick] = LevelSlot{};
+    const std::uint32_t slot = slot_of(price);
+    if (!is_occupied(slot)) {
+        set_occupied(slot);
+        ladder_[slot] = LevelSlot{};
     }
-    return ladder_[tick];
+    return ladder_[slot];
 }
 
 MatchingBook::LevelSlot* MatchingBook::SideIndex::find_level(Price price) {
     if (in_band(price)) {
-        const std::uint32_t tick = tick_of(price);
-        return is_occupied(tick) ? &ladder_[tick] : nullptr;
+        const std::uint32_t slot = slot_of(price);
+        return is_occupied(slot) ? &ladder_[slot] : nullptr;
     }
     auto it = overflow_.find(price);
     return it == overflow_.end() ? nullptr : &it->second;
@@ -188,7 +295,7 @@ MatchingBook::LevelSlot* MatchingBook::SideIndex::find_level(Price price) {
 
 void MatchingBook::SideIndex::erase_level(Price price) {
     if (in_band(price)) {
-        clear_occupied(tick_of(price));
+        clear_occupied(slot_of(price));
         return;
     }
     overflow_.erase(price);
@@ -217,11 +324,135 @@ MatchingBook::LevelSlot& MatchingBook::SideIndex::level_at(Price price) {
 
 const MatchingBook::LevelSlot& MatchingBook::SideIndex::level_at(Price price) const {
     if (in_band(price)) {
-        return ladder_[tick_of(price)];
+        return ladder_[slot_of(price)];
     }
     return overflow_.find(price)->second;
 }
 
+// ── Re-centering ───────────────────────────────────────────────────────────
+
+void MatchingBook::SideIndex::maintain(Price touched) {
+    if (rebasing_) {
+        rebase_step();
+        return;
+    }
+    // The touched price is the cheap filter: most operations land near the
+    // middle of the band, and only one that does not is worth the best-price
+    // lookup that decides whether the touch itself has wandered off.
+    if (!anchored_ || centred(touched) || empty()) {
+        return;
+    }
+    const Price best = best_price();
+    if (centred(best)) {
+        return;
+    }
+    rebase_target_ = best - static_cast<Price>(band_ticks_ / 2);
+    rebasing_ = true;
+    // Levels already spilled past the band when the touch needs it to move
+    // mean the side spans more prices than the band holds, and re-centring
+    // alone will not fix that. A book drawing on a LadderBudget widens into
+    // this when the budget allows; one with a fixed band ignores it.
+    if (!overflow_.empty()) {
+        preferred_band_ = std::max(preferred_band_, std::min(band_ticks_ * 2, kMaxBandTicks));
+    }
+    ++rebase_counters_.rebases;
+    rebase_step();
+}
+
+void MatchingBook::SideIndex::rebase_step() {
+    if (empty()) {
+        // Nothing to carry over; the next insert re-anchors from scratch.
+        rebasing_ = false;
+        return;
+    }
+    const std::uint32_t moved = rebase_target_ > base_ ? slide_up() : slide_down();
+    rebase_counters_.levels_migrated += moved;
+    rebasing_ = base_ != rebase_target_;
+}
+
+std::uint32_t MatchingBook::SideIndex::slide_up() {
+    // Moving the base up uncovers prices at the top of the band and drops
+    // them at the bottom. Each pass finds the next of each -- the lowest
+    // ladder level, which leaves once the base passes it, and the lowest map
+    // level above the band, which enters once the top reaches it -- and
+    // jumps the base to whichever comes first.
+    // A pass moves at most two levels, one out and one in, so it only
+    // starts if both fit.
+    const auto band = static_cast<Price>(band_ticks_);
+    std::uint32_t moved = 0;
+    while (base_ < rebase_target_ && moved + 2 <= kRebaseLevelsPerStep) {
+        Price next_base = rebase_target_;
+        const std::uint32_t lowest = lowest_occupied();
+        if (lowest != band_ticks_) {
+            next_base = std::min(next_base, price_of(lowest) + 1);
+        }
+        const auto entering = overflow_.lower_bound(base_ + band);
+        if (entering != overflow_.end()) {
+            next_base = std::min(next_base, entering->first - band + 1);
+        }
+        if (lowest != band_ticks_ && price_of(lowest) < next_base) {
+            evict(price_of(lowest));
+            ++moved;
+        }
+        base_ = next_base;
+        if (entering != overflow_.end() && entering->first < base_ + band) {
+            admit(entering);
+            ++moved;
+        }
+    }
+    return moved;
+}
+
+std::uint32_t MatchingBook::SideIndex::slide_down() {
+    // The mirror image: the highest ladder level leaves once the top of the
+    // band drops below it, and the highest map level below the band enters
+    // once the base reaches it.
+    // A pass moves at most two levels, one out and one in, so it only
+    // starts if both fit.
+    const auto band = static_cast<Price>(band_ticks_);
+    std::uint32_t moved = 0;
+    while (base_ > rebase_target_ && moved + 2 <= kRebaseLevelsPerStep) {
+        Price next_base = rebase_target_;
+        const std::uint32_t highest = highest_occupied();
+        if (highest != band_ticks_) {
+            next_base = std::max(next_base, price_of(highest) - band);
+        }
+        auto entering = overflow_.lower_bound(base_);
+        const bool has_entering = entering != overflow_.begin();
+        if (has_entering) {
+            entering = std::prev(entering);
+            next_base = std::max(next_base, entering->first);
+        }
+        if (highest != band_ticks_ && price_of(highest) >= next_base + band) {
+            evict(price_of(highest));
+            ++moved;
+        }
+        base_ = next_base;
+        if (has_entering && entering->first >= base_) {
+            admit(entering);
+            ++moved;
+        }
+    }
+    return moved;
+}
+
+void MatchingBook::SideIndex::evict(Price price) {
+    // The slot does not depend on the base, so this is correct on either
+    // side of the base moving.
+    const std::uint32_t slot = slot_of(price);
+    overflow_.emplace(price, ladder_[slot]);
+    clear_occupied(slot);
+}
+
+void MatchingBook::SideIndex::admit(std::pmr::map<Price, LevelSlot>::iterator level) {
+    // Its slot is free: it is the slot of a price that has just left the
+    // band, or of one that nothing occupied.
+    const std::uint32_t slot = slot_of(level->first);
+    ladder_[slot] = level->second;
+    set_occupied(slot);
+    overflow_.erase(level);
+}
+
 std::uint32_t MatchingBook::band_for(std::size_t instrument_count, std::size_t byte_budget) {
     if (instrument_count == 0) {
         return kMaxBandTicks;
@@ -288,88 +519,259 @@ std::optional<Price> MatchingBook::SideIndex::next_price(Price price) const {
 
 // ── MatchingBook ───────────────────────────────────────────────────────────
 
-MatchingBook::MatchingBook(std::size_t expected_resting_orders, std::uint32_t band_ticks)
+MatchingBook::MatchingBook(std::size_t expected_resting_orders, std::uint32_t band_ticks, LadderBudget* budget)
     : pool_(std::make_unique<std::pmr::unsynchronized_pool_resource>(
           std::pmr::pool_options{.max_blocks_per_chunk = kMaxBlocksPerChunk,
                                  .largest_required_pool_block = kLargestPooledBlock})),
+      budget_(budget),
       bids_(Side::Buy, band_ticks, pool_.get()),
       asks_(Side::Sell, band_ticks, pool_.get()) {
-    slab_.reserve(expected_resting_orders);
+    hot_.reserve(expected_resting_orders);
+    cold_.reserve(expected_resting_orders);
+    account_links_.reserve(expected_resting_orders);
 }
 
 std::uint32_t MatchingBook::acquire_slot(const BookOrder& order) {
+    const ColdOrder cold{
+        .exchange_order_id = order.exchange_order_id,
+        .client_order_id = order.client_order_id,
+        .account_id = order.account_id,
+        .price = order.price,
+        .side = order.side,
+        .time_in_force = order.time_in_force,
+    };
     if (free_head_ != kNil) {
         const std::uint32_t slot = free_head_;
-        free_head_ = slab_[slot].next;
-        slab_[slot].order = order;
+        free_head_ = hot_[slot].next;
+        hot_[slot].remaining_quantity = order.remaining_quantity;
+        cold_[slot] = cold;
         return slot;
     }
-    slab_.push_back(SlabOrder{.order = order, .next = kNil, .prev = kNil});
-    return static_cast<std::uint32_t>(slab_.size() - 1);
+    // All three arrays grow together and before any is appended to, so a
+    // growth that fails leaves them the same length -- an append after that
+    // cannot throw, and arrays one apart would pair the wrong halves.
+    if (hot_.size() == hot_.capacity()) {
+        const std::size_t grown = std::max<std::size_t>(16, hot_.size() * 2);
+        account_links_.reserve(grown);
+        cold_.reserve(grown);
+        hot_.reserve(grown);
+    }
+    account_links_.push_back(AccountLink{.next = kNil, .prev = kNil, .chain = kNil});
+    cold_.push_back(cold);
+    hot_.push_back(HotOrder{.remaining_quantity = order.remaining_quantity, .next = kNil, .prev = kNil});
+    return static_cast<std::uint32_t>(hot_.size() - 1);
 }
 
 void MatchingBook::release_slot(std::uint32_t slot) {
-    slab_[slot].next = free_head_;
+    hot_[slot].next = free_head_;
     free_head_ = slot;
 }
 
 void MatchingBook::link_back(LevelSlot& level, std::uint32_t slot) {
-    slab_[slot].next = kNil;
-    slab_[slot].prev = level.tail;
+    hot_[slot].next = kNil;
+    hot_[slot].prev = level.tail;
     if (level.tail == kNil) {
         level.head = slot;
     } else {
-        slab_[level.tail].next = slot;
+        hot_[level.tail].next = slot;
     }
     level.tail = slot;
+    level.total_quantity += hot_[slot].remaining_quantity;
+    ++level.order_count;
 }
 
 void MatchingBook::unlink(LevelSlot& level, std::uint32_t slot) {
-    const std::uint32_t next = slab_[slot].next;
-    const std::uint32_t prev = slab_[slot].prev;
+    const std::uint32_t next = hot_[slot].next;
+    const std::uint32_t prev = hot_[slot].prev;
     if (prev == kNil) {
         level.head = next;
     } else {
-        slab_[prev].next = next;
+        hot_[prev].next = next;
     }
     if (next == kNil) {
         level.tail = prev;
     } else {
-        slab_[next].prev = prev;
+        hot_[next].prev = prev;
+    }
+    level.total_quantity -= hot_[slot].remaining_quantity;
+    --level.order_count;
+}
+
+void MatchingBook::adjust_quantity(LevelSlot& level, std::uint32_t slot, Quantity new_remaining_quantity) {
+    Quantity& remaining = hot_[slot].remaining_quantity;
+    level.total_quantity = level.total_quantity - remaining + new_remaining_quantity;
+    remaining = new_remaining_quantity;
+}
+
+void MatchingBook::link_account(std::uint32_t slot, AccountId account_id) {
+    auto found = chain_of_account_.find(account_id);
+    if (found == chain_of_account_.end()) {
+        // The chain before the map entry naming it, so neither can be left
+        // pointing at something that failed to allocate.
+        account_chains_.emplace_back();
+        found = chain_of_account_.emplace(account_id, static_cast<std::uint32_t>(account_chains_.size() - 1)).first;
+        new_accounts_.push_back(account_id);
+    }
+    AccountChain& chain = account_chains_[found->second];
+    account_links_[slot] = AccountLink{.next = kNil, .prev = chain.tail, .chain = found->second};
+    if (chain.tail == kNil) {
+        chain.head = slot;
+    } else {
+        account_links_[chain.tail].next = slot;
+    }
+    chain.tail = slot;
+    ++chain.count;
+}
+
+void MatchingBook::unlink_account(std::uint32_t slot) {
+    const AccountLink link = account_links_[slot];
+    AccountChain& chain = account_chains_[link.chain];
+    if (link.prev == kNil) {
+        chain.head = link.next;
+    } else {
+        account_links_[link.prev].next = link.next;
     }
+    if (link.next == kNil) {
+        chain.tail = link.prev;
+    } else {
+        account_links_[link.next].prev = link.prev;
+    }
+    --chain.count;
+}
+
+std::size_t MatchingBook::account_order_count(AccountId account_id) const {
+    const auto found = chain_of_account_.find(account_id);
+    return found == chain_of_account_.end() ? 0 : account_chains_[found->second].count;
 }
 
 MatchingBook::Handle MatchingBook::add(const BookOrder& order) {
     // Before the level lookup, so that a slab growth that fails cannot leave
-    // a freshly-inserted empty level behind it.
+    // a freshly-inserted empty level behind it. The account's chain comes
+    // second for the same reason: the slot it links must already exist.
     const std::uint32_t slot = acquire_slot(order);
-    link_back(side_of(order.side).level_for(order.price), slot);
+    link_account(slot, order.account_id);
+    ++version_;
+    digest_ += order_digest(order);
+    SideIndex& side = side_of(order.side);
+    if (!side.has_ladder()) {
+        materialise(side);
+    }
+    link_back(side.level_for(order.price), slot);
+    side.maintain(order.price);
+    if (budget_ != nullptr && side.has_ladder() && side.preferred_band() > side.band_ticks()) {
+        widen(side);
+    }
     return Handle{.slot = slot};
 }
 
+void MatchingBook::materialise(SideIndex& side) {
+    std::uint32_t band = side.preferred_band();
+    if (band == 0 || side.level_count() > kMaxLevelsMovedAtOnce) {
+        return;
+    }
+    if (budget_ != nullptr) {
+        const std::size_t room =
+            budget_->bytes_in_use < budget_->byte_limit ? budget_->byte_limit - budget_->bytes_in_use : 0;
+        while (band >= kMinBandTicks && SideIndex::ladder_bytes(band) > room) {
+            band /= 2;
+        }
+        if (band < kMinBandTicks) {
+            ++budget_->refusals;
+            return;
+        }
+        budget_->bytes_in_use += SideIndex::ladder_bytes(band);
+        ++budget_->materialised;
+    }
+    side.materialise(band);
+}
+
+void MatchingBook::widen(SideIndex& side) {
+    const std::uint32_t band = side.preferred_band();
+    const std::size_t extra = SideIndex::ladder_bytes(band) - SideIndex::ladder_bytes(side.band_ticks());
+    if (side.level_count() > kMaxLevelsMovedAtOnce || budget_->bytes_in_use + extra > budget_->byte_limit) {
+        // Tried again on the next insert: a budget that is short now may
+        // not be once an idle book gives its ladder back.
+        return;
+    }
+    budget_->bytes_in_use += extra;
+    ++budget_->widened;
+    side.release();
+    side.materialise(band);
+}
+
+void MatchingBook::release(SideIndex& side) {
+    if (!side.has_ladder() || side.level_count() > kMaxLevelsMovedAtOnce) {
+        return;
+    }
+    if (budget_ != nullptr) {
+        budget_->bytes_in_use -= SideIndex::ladder_bytes(side.band_ticks());
+        ++budget_->reclaimed;
+    }
+    side.release();
+}
+
+void MatchingBook::release_ladders() {
+    release(bids_);
+    release(asks_);
+    bids_.reset_preferred_band();
+    asks_.reset_preferred_band();
+}
+
 BookOrder MatchingBook::remove_at(Handle handle) {
     // The order knows its own side and price, so the handle no longer has to
     // carry them -- which is the whole reason it fits in four bytes.
-    const BookOrder removed = slab_[handle.slot].order;
+    const BookOrder removed = assemble(handle.slot);
+    ++version_;
+    digest_ -= order_digest(removed);
     SideIndex& side = side_of(removed.side);
     LevelSlot& level = *side.find_level(removed.price);
     unlink(level, handle.slot);
+    unlink_account(handle.slot);
     if (level.head == kNil) {
         side.erase_level(removed.price);
     }
     release_slot(handle.slot);
+    side.maintain(removed.price);
     return removed;
 }
 
 void MatchingBook::reduce_at(Handle handle, Quantity new_remaining_quantity) {
-    slab_[handle.slot].order.remaining_quantity = new_remaining_quantity;
+    ++version_;
+    rehash_quantity(handle.slot, new_remaining_quantity);
+    const ColdOrder& order = cold_[handle.slot];
+    adjust_quantity(*side_of(order.side).find_level(order.price), handle.slot, new_remaining_quantity);
 }
 
 void MatchingBook::set_client_order_id_at(Handle handle, ClientOrderId new_client_order_id) {
-    slab_[handle.slot].order.client_order_id = new_client_order_id;
+    ++version_;
+    BookOrder order = assemble(handle.slot);
+    digest_ -= order_digest(order);
+    order.client_order_id = new_client_order_id;
+    digest_ += order_digest(order);
+    cold_[handle.slot].client_order_id = new_client_order_id;
+}
+
+void MatchingBook::rehash_quantity(std::uint32_t slot, Quantity new_remaining_quantity) {
+    BookOrder order = assemble(slot);
+    digest_ -= order_digest(order);
+    order.remaining_quantity = new_remaining_quantity;
+    digest_ += order_digest(order);
 }
 
-const BookOrder& MatchingBook::at(Handle handle) const { return slab_[handle.slot].order; }
+BookOrder MatchingBook::at(Handle handle) const { return assemble(handle.slot); }
+
+BookOrder MatchingBook::assemble(std::uint32_t slot) const {
+    const ColdOrder& cold = cold_[slot];
+    return BookOrder{
+        .exchange_order_id = cold.exchange_order_id,
+        .client_order_id = cold.client_order_id,
+        .account_id = cold.account_id,
+        .price = cold.price,
+        .remaining_quantity = hot_[slot].remaining_quantity,
+        .side = cold.side,
+        .time_in_force = cold.time_in_force,
+    };
+}
 
 std::optional<Price> MatchingBook::best_bid_price() const {
     if (bids_.empty()) {
@@ -385,29 +787,48 @@ std::optional<Price> MatchingBook::best_ask_price() const {
     return asks_.best_price();
 }
 
-const BookOrder* MatchingBook::front_of_best(Side book_side) const {
+std::optional<BookOrder> MatchingBook::front_of_best(Side book_side) const {
     const SideIndex& side = side_of(book_side);
     if (side.empty()) {
-        return nullptr;
+        return std::nullopt;
     }
-    return &slab_[side.level_at(side.best_price()).head].order;
+    const std::uint32_t head = side.level_at(side.best_price()).head;
+    // The order behind the front is the next one a sweep will take, and
+    // nothing about reaching it depends on this one's fields -- only on its
+    // link, which is in the line already being read. Asking for both halves
+    // now overlaps their misses with this fill's events. When the front is
+    // the last at its level, the next order is at another level and unknown
+    // here, so there is nothing to ask for.
+    const std::uint32_t next = hot_[head].next;
+    if (next != kNil) {
+        __builtin_prefetch(&hot_[next]);
+        __builtin_prefetch(&cold_[next]);
+    }
+    return assemble(head);
 }
 
 void MatchingBook::reduce_front(Side book_side, Quantity new_remaining_quantity) {
+    ++version_;
     SideIndex& side = side_of(book_side);
-    slab_[side.level_at(side.best_price()).head].order.remaining_quantity = new_remaining_quantity;
+    LevelSlot& level = side.level_at(side.best_price());
+    rehash_quantity(level.head, new_remaining_quantity);
+    adjust_quantity(level, level.head, new_remaining_quantity);
 }
 
 void MatchingBook::remove_front(Side book_side) {
+    ++version_;
     SideIndex& side = side_of(book_side);
     const Price price = side.best_price();
     LevelSlot& level = side.level_at(price);
     const std::uint32_t head = level.head;
+    digest_ -= order_digest(assemble(head));
     unlink(level, head);
+    unlink_account(head);
     release_slot(head);
     if (level.head == kNil) {
         side.erase_level(price);
     }
+    side.maintain(price);
 }
 
 Quantity MatchingBook::crossable_quantity(Side book_side, Price price, Quantity quantity) const {
@@ -422,16 +843,113 @@ Quantity MatchingBook::crossable_quantity(Side book_side, Price price, Quantity
         if (bids ? price > *level_price : price < *level_price) {
             break;
         }
-        for (std::uint32_t slot = side.level_at(*level_price).head; slot != kNil; slot = slab_[slot].next) {
-            total += slab_[slot].order.remaining_quantity;
-            if (total >= quantity) {
-                return total;
-            }
+        total += side.level_at(*level_price).total_quantity;
+        if (total >= quantity) {
+            return total;
         }
     }
     return total;
 }
 
+std::size_t MatchingBook::depth(Side book_side, std::span<LevelDepth> out) const {
+    const SideIndex& side = side_of(book_side);
+    if (side.empty() || out.empty()) {
+        return 0;
+    }
+    std::size_t written = 0;
+    for (std::optional<Price> level_price = side.best_price(); level_price.has_value() && written < out.size();
+         level_price = side.next_price(*level_price)) {
+        const LevelSlot& level = side.level_at(*level_price);
+        out[written++] = LevelDepth{
+            .price = *level_price,
+            .quantity = level.total_quantity,
+            .order_count = level.order_count,
+        };
+    }
+    return written;
+}
+
+std::optional<Equilibrium> MatchingBook::equilibrium(std::optional<Price> reference) const {
+    const std::optional<Price> best_bid = best_bid_price();
+    const std::optional<Price> best_ask = best_ask_price();
+    if (!best_bid.has_value() || !best_ask.has_value() || *best_bid < *best_ask) {
+        return std::nullopt;
+    }
+
+    // The crossed levels of each side, lowest price first. Bids are walked
+    // best first, so theirs come out highest first and are read backwards.
+    std::vector<std::pair<Price, Quantity>> bids;
+    std::vector<std::pair<Price, Quantity>> asks;
+    Quantity bid_total = 0;
+    for (std::optional<Price> price = best_bid; price.has_value() && *price >= *best_ask;
+         price = bids_.next_price(*price)) {
+        bids.emplace_back(*price, bids_.level_at(*price).total_quantity);
+        bid_total += bids.back().second;
+    }
+    for (std::optional<Price> price = best_ask; price.has_value() && *price <= *best_bid;
+         price = asks_.next_price(*price)) {
+        asks.emplace_back(*price, asks_.level_at(*price).total_quantity);
+    }
+
+    // Every price either side has a crossed level at, lowest first. At
+    // each, sells willing are the asks at or below it and buys willing are
+    // the bids at or above it: everything crossed less the bids below it.
+    struct Candidate {
+        Price price;
+        std::int64_t imbalance;
+    };
+    std::vector<Candidate> tied;
+    Quantity best_volume = 0;
+    Quantity best_spread = 0;
+    Quantity sells = 0;
+    Quantity bids_below = 0;
+    auto bid = bids.rbegin();
+    auto ask = asks.begin();
+    while (bid != bids.rend() || ask != asks.end()) {
+        const Price price = bid == bids.rend()   ? ask->first
+                            : ask == asks.end() ? bid->first
+                                                : std::min(bid->first, ask->first);
+        if (ask != asks.end() && ask->first == price) {
+            sells += ask->second;
+            ++ask;
+        }
+        const Quantity buys = bid_total - bids_below;
+        if (bid != bids.rend() && bid->first == price) {
+            bids_below += bid->second;
+            ++bid;
+        }
+        const Quantity volume = std::min(buys, sells);
+        const Quantity spread = buys > sells ? buys - sells : sells - buys;
+        if (volume > best_volume || (volume == best_volume && spread < best_spread)) {
+            tied.clear();
+        } else if (volume < best_volume || spread > best_spread) {
+            continue;
+        }
+        best_volume = volume;
+        best_spread = spread;
+        tied.push_back(Candidate{price, static_cast<std::int64_t>(buys) - static_cast<std::int64_t>(sells)});
+    }
+
+    const bool all_buyers_over =
+        std::all_of(tied.begin(), tied.end(), [](const Candidate& c) { return c.imbalance > 0; });
+    const bool all_sellers_over =
+        std::all_of(tied.begin(), tied.end(), [](const Candidate& c) { return c.imbalance < 0; });
+    const Candidate* chosen = &tied.front();
+    if (all_buyers_over) {
+        chosen = &tied.back();
+    } else if (!all_sellers_over) {
+        const Price anchor = reference.value_or(*best_ask + (*best_bid - *best_ask) / 2);
+        for (const Candidate& candidate : tied) {
+            const Price distance = candidate.price > anchor ? candidate.price - anchor : anchor - candidate.price;
+            const Price chosen_distance = chosen->price > anchor ? chosen->price - anchor : anchor - chosen->price;
+            if (distance < chosen_distance) {
+                chosen = &candidate;
+            }
+        }
+    }
+    return Equilibrium{.price = chosen->price, .volume = best_volume, .imbalance = chosen->imbalance};
+}
+
 std::vector<BookOrder> MatchingBook::all_of(Side book_side) const {
     const SideIndex& side = side_of(book_side);
     std::vector<BookOrder> result;
@@ -440,8 +958,8 @@ std::vector<BookOrder> MatchingBook::all_of(Side book_side) const {
     }
     for (std::optional<Price> level_price = side.best_price(); level_price.has_value();
          level_price = side.next_price(*level_price)) {
-        for (std::uint32_t slot = side.level_at(*level_price).head; slot != kNil; slot = slab_[slot].next) {
-            result.push_back(slab_[slot].order);
+        for (std::uint32_t slot = side.level_at(*level_price).head; slot != kNil; slot = hot_[slot].next) {
+            result.push_back(assemble(slot));
         }
     }
     return result;
@@ -455,4 +973,10 @@ std::size_t MatchingBook::out_of_band_levels() const {
     return bids_.overflow_levels() + asks_.overflow_levels();
 }
 
+LadderRebaseCounters MatchingBook::rebase_counters() const {
+    LadderRebaseCounters total = bids_.rebase_counters();
+    total += asks_.rebase_counters();
+    return total;
+}
+
 } // namespace mdh::exchange
@@ -2,26 +2,28 @@
 
 #include <algorithm>
 #include <cstddef>
-#include <type_traits>
-#include <variant>
+#include <utility>
 
 namespace mdh::exchange {
 namespace {
 
-// orders_ allocates one node per resting order. The bound is set well above
-// that node's actual size for the reason given in matching_book.cpp: libc++
-// only pools blocks up to a quarter of this value, and a node that misses
-// the pool lands in an adhoc list whose deallocate is a linear scan.
-constexpr std::size_t kLargestPooledBlock = 1024;
-constexpr std::size_t kMaxBlocksPerChunk = 4096;
+// The band a new book asks for: its even share of the budget, floored at
+// the narrowest ladder worth having. The floor is what lets a large
+// universe use ladders at all -- an even split gives each book nothing,
+// but only the active ones ever ask -- and the budget, not this, is what
+// stops them all asking at once.
+std::uint32_t start_band(std::size_t instrument_count, std::size_t byte_budget) {
+    return std::max(MatchingBook::band_for(instrument_count, byte_budget), MatchingBook::kMinBandTicks);
+}
 
 } // namespace
 
-MatchingEngine::MatchingEngine(std::span<const InstrumentId> universe, std::size_t expected_resting_orders)
-    : pool_(std::make_unique<std::pmr::unsynchronized_pool_resource>(
-          std::pmr::pool_options{.max_blocks_per_chunk = kMaxBlocksPerChunk,
-                                 .largest_required_pool_block = kLargestPooledBlock})),
-      orders_(pool_.get()) {
+MatchingEngine::MatchingEngine(std::span<const InstrumentId> universe, std::size_t expected_resting_orders,
+                               ExchangeOrderIdSpace id_space, LadderPolicy ladders)
+    : ladder_policy_(ladders),
+      ladder_budget_(std::make_unique<LadderBudget>(LadderBudget{.byte_limit = ladders.byte_budget})),
+      orders_(expected_resting_orders), next_exchange_order_id_(id_space.first),
+      exchange_order_id_stride_(id_space.stride == 0 ? 1 : id_space.stride) {
     // Size the id table once from the widest id rather than letting
     // register_instrument() grow it per instrument, and reserve the books so
     // registration does not move them repeatedly. Both are just avoided
@@ -46,19 +48,21 @@ MatchingEngine::MatchingEngine(std::span<const InstrumentId> universe, std::size
         // that every book in it gets the same band -- registering them one
         // at a time and re-deriving as the count grew would give the first
         // instruments a wider ladder than the last for no reason.
-        band_ticks_ = MatchingBook::band_for(universe.size(), kLadderByteBudget);
+        band_ticks_ = start_band(universe.size(), ladders.byte_budget);
     }
     books_.reserve(universe.size());
+    stop_books_.reserve(universe.size());
+    activity_.reserve(universe.size());
     by_id_.reserve(universe.size());
     for (const InstrumentId instrument_id : universe) {
         register_instrument(instrument_id);
     }
-
-    orders_.reserve(expected_resting_orders);
 }
 
-MatchingEngine::MatchingEngine(std::initializer_list<InstrumentId> universe, std::size_t expected_resting_orders)
-    : MatchingEngine(std::span<const InstrumentId>(universe.begin(), universe.size()), expected_resting_orders) {}
+MatchingEngine::MatchingEngine(std::initializer_list<InstrumentId> universe, std::size_t expected_resting_orders,
+                               ExchangeOrderIdSpace id_space, LadderPolicy ladders)
+    : MatchingEngine(std::span<const InstrumentId>(universe.begin(), universe.size()), expected_resting_orders,
+                     id_space, ladders) {}
 
 bool MatchingEngine::register_instrument(InstrumentId instrument_id) {
     if (instrument_id > kMaxInstrumentId || knows_instrument(instrument_id)) {
@@ -72,8 +76,10 @@ bool MatchingEngine::register_instrument(InstrumentId instrument_id) {
     // Never widens: a universe that keeps growing past what it was sized for
     // narrows the band for the books still to come, which is the only part
     // of the budget still unspent.
-    band_ticks_ = std::min(band_ticks_, MatchingBook::band_for(books_.size() + 1, kLadderByteBudget));
-    books_.emplace_back(expected_orders_per_book_, band_ticks_);
+    band_ticks_ = std::min(band_ticks_, start_band(books_.size() + 1, ladder_policy_.byte_budget));
+    books_.emplace_back(expected_orders_per_book_, band_ticks_, ladder_budget_.get());
+    stop_books_.emplace_back();
+    activity_.push_back(BookActivity{.last_command = commands_seen_, .instrument_id = instrument_id});
     slot_of_id_[instrument_id] = slot;
 
     // Kept sorted on insert so snapshot() can walk it directly. Registration
@@ -85,10 +91,28 @@ bool MatchingEngine::register_instrument(InstrumentId instrument_id) {
     return true;
 }
 
+void MatchingEngine::index_new_accounts(std::uint32_t slot) {
+    const std::pair<InstrumentId, std::uint32_t> entry{activity_[slot].instrument_id, slot};
+    auto file = [&](AccountId account_id) {
+        // Sorted like by_id_, and once per book even for an account new to
+        // both the book and its stop book. An account is new to a book once,
+        // so this runs per account and book, never per order.
+        auto& books = books_of_account_[account_id];
+        const auto at = std::lower_bound(books.begin(), books.end(), entry);
+        if (at == books.end() || *at != entry) {
+            books.insert(at, entry);
+        }
+    };
+    books_[slot].take_new_accounts(file);
+    if (MatchingBook* stops = stop_books_[slot].get(); stops != nullptr) {
+        stops->take_new_accounts(file);
+    }
+}
+
 ExchangeRestingOrder MatchingEngine::compose(const BookOrder& order, InstrumentId instrument_id) const {
     // Every order on a book has an entry here: the two are written and
     // erased together at every mutation point in this engine.
-    const OrderRef& ref = orders_.at(LiveKey{order.account_id, order.client_order_id});
+    const OrderRef& ref = *orders_.find(LiveKey{order.account_id, order.client_order_id});
     return ExchangeRestingOrder{
         .exchange_order_id = order.exchange_order_id,
         .client_order_id = order.client_order_id,
@@ -111,475 +135,172 @@ std::size_t MatchingEngine::out_of_band_levels() const {
     return total;
 }
 
+LadderRebaseCounters MatchingEngine::ladder_rebase_counters() const {
+    LadderRebaseCounters total;
+    for (const MatchingBook& book : books_) {
+        total += book.rebase_counters();
+    }
+    return total;
+}
+
+std::size_t MatchingEngine::aggregated_depth(InstrumentId instrument_id, Side book_side,
+                                             std::span<LevelDepth> out) const {
+    if (!knows_instrument(instrument_id)) {
+        return 0;
+    }
+    return book_for(instrument_id).depth(book_side, out);
+}
+
+bool MatchingEngine::valid_stop(const NewOrderCommand& cmd) const {
+    if (cmd.stop_price <= 0 || cmd.time_in_force != TimeInForce::GTC) {
+        return false;
+    }
+    const BookActivity& activity = activity_[slot_of_id_[cmd.instrument_id]];
+    if (!activity.has_traded) {
+        return true;
+    }
+    return cmd.side == Side::Buy ? cmd.stop_price > activity.last_trade_price
+                                 : cmd.stop_price < activity.last_trade_price;
+}
+
+InstrumentBookSnapshot MatchingEngine::snapshot_book(std::uint32_t slot) const {
+    const InstrumentId instrument_id = activity_[slot].instrument_id;
+    const MatchingBook& book = books_[slot];
+    const auto compose_all = [&](const std::vector<BookOrder>& orders) {
+        std::vector<ExchangeRestingOrder> composed;
+        composed.reserve(orders.size());
+        for (const BookOrder& order : orders) {
+            composed.push_back(compose(order, instrument_id));
+        }
+        return composed;
+    };
+    InstrumentBookSnapshot snap{
+        .instrument_id = instrument_id,
+        .bids = compose_all(book.all_bids()),
+        .asks = compose_all(book.all_asks()),
+        .phase = book.trading_phase(),
+    };
+    for (const auto* side : {&snap.bids, &snap.asks}) {
+        for (const ExchangeRestingOrder& order : *side) {
+            if (order.time_in_force == TimeInForce::GTD) {
+                snap.expiries.push_back(OrderExpiry{
+                    .exchange_order_id = order.exchange_order_id,
+                    .expire_at = expiries_.expires_at(expiry_of_.at(order.exchange_order_id)),
+                });
+            }
+        }
+    }
+    std::sort(snap.expiries.begin(), snap.expiries.end(),
+              [](const OrderExpiry& a, const OrderExpiry& b) { return a.exchange_order_id < b.exchange_order_id; });
+
+    // Buy stops are filed on the stop book's asks and sell stops on its
+    // bids, so reading asks then bids is release order.
+    if (const MatchingBook* stops = stop_books_[slot].get(); stops != nullptr) {
+        for (const auto& filed : {stops->all_asks(), stops->all_bids()}) {
+            for (const BookOrder& order : filed) {
+                const OrderRef& ref = *orders_.find(LiveKey{order.account_id, order.client_order_id});
+                snap.stops.push_back(PendingStopOrder{
+                    .order =
+                        ExchangeRestingOrder{
+                            .exchange_order_id = order.exchange_order_id,
+                            .client_order_id = order.client_order_id,
+                            .account_id = order.account_id,
+                            .price = stop_limit_prices_.at(order.exchange_order_id),
+                            .original_quantity = ref.original_quantity,
+                            .remaining_quantity = order.remaining_quantity,
+                            .order_sequence = ref.order_sequence & ~kPendingStop,
+                            .instrument_id = instrument_id,
+                            .side = order.side == Side::Buy ? Side::Sell : Side::Buy,
+                            .time_in_force = order.time_in_force,
+                        },
+                    .stop_price = order.price,
+                });
+            }
+        }
+    }
+    return snap;
+}
+
 EngineStateSnapshot MatchingEngine::snapshot() const {
     EngineStateSnapshot snap;
     snap.instruments.reserve(by_id_.size());
     for (const auto& [instrument_id, slot] : by_id_) {
-        const MatchingBook& book = books_[slot];
-        const auto compose_all = [&](const std::vector<BookOrder>& orders) {
-            std::vector<ExchangeRestingOrder> composed;
-            composed.reserve(orders.size());
-            for (const BookOrder& order : orders) {
-                composed.push_back(compose(order, instrument_id));
-            }
-            return composed;
-        };
-        auto bids = compose_all(book.all_bids());
-        auto asks = compose_all(book.all_asks());
-        if (bids.empty() && asks.empty()) {
+        InstrumentBookSnapshot book = snapshot_book(slot);
+        if (book.bids.empty() && book.asks.empty() && book.stops.empty() &&
+            book.phase == TradingPhase::Continuous) {
             // Every registered instrument has a book from the moment the
             // engine is constructed, whether or not anything ever traded on
             // it, and a book keeps its entry after its last order leaves.
             // Either way an instrument with nothing resting carries no
             // meaningful state, so it is omitted rather than reported as an
             // empty pair of vectors -- which is also what keeps the snapshot
-            // comparable between two engines configured differently.
+            // comparable between two engines configured differently. A
+            // book in call is the exception: its phase is state a replay has
+            // to agree on even before its first order arrives.
             continue;
         }
-        snap.instruments.push_back(InstrumentBookSnapshot{
-            .instrument_id = instrument_id,
-            .bids = std::move(bids),
-            .asks = std::move(asks),
-        });
+        snap.instruments.push_back(std::move(book));
     }
     return snap;
 }
 
-void MatchingEngine::process(const ExchangeCommand& command, const EventSink& sink) {
-    std::visit(
-        [&](const auto& cmd) {
-            using T = std::decay_t<decltype(cmd)>;
-            if constexpr (std::is_same_v<T, NewOrderCommand>) {
-                process_new_order(cmd, sink);
-            } else if constexpr (std::is_same_v<T, CancelOrderCommand>) {
-                process_cancel(cmd, sink);
-            } else if constexpr (std::is_same_v<T, ReplaceOrderCommand>) {
-                process_replace(cmd, sink);
-            }
-        },
-        command);
-}
-
-void MatchingEngine::reject_new_order(const NewOrderCommand& command, RejectReason reason, const EventSink& sink) {
-    sink(OrderRejected{
-        .event_sequence = next_event_sequence_++,
-        .command_sequence = command.command_sequence,
-        .account_id = command.account_id,
-        .client_order_id = command.client_order_id,
-        .instrument_id = command.instrument_id,
-        .reason = reason,
+EngineStateChanges MatchingEngine::snapshot_changes() {
+    EngineStateChanges changes{.epoch = ++snapshot_epoch_, .commands = commands_seen_};
+    // By id, which is the order apply_changes() merges in. The list is the
+    // books touched in one epoch, so sorting it is cheap next to copying them.
+    std::sort(dirty_books_.begin(), dirty_books_.end(), [this](std::uint32_t a, std::uint32_t b) {
+        return activity_[a].instrument_id < activity_[b].instrument_id;
     });
-}
-
-void MatchingEngine::reject_replace_order(const ReplaceOrderCommand& command, RejectReason reason,
-                                           const EventSink& sink) {
-    sink(OrderRejected{
-        .event_sequence = next_event_sequence_++,
-        .command_sequence = command.command_sequence,
-        .account_id = command.account_id,
-        .client_order_id = command.original_client_order_id,
-        .instrument_id = command.instrument_id,
-        .reason = reason,
-    });
-}
-
-Quantity MatchingEngine::crossable_quantity(InstrumentId instrument_id, Side incoming_side, Price price,
-                                             Quantity quantity) const {
-    const Side contra_side = incoming_side == Side::Buy ? Side::Sell : Side::Buy;
-    return book_for(instrument_id).crossable_quantity(contra_side, price, quantity);
-}
-
-void MatchingEngine::match_and_rest(ExchangeRestingOrder& incoming, CommandSequence command_sequence,
-                                     const EventSink& sink) {
-    MatchingBook& book = book_for(incoming.instrument_id);
-    const Side contra_side = incoming.side == Side::Buy ? Side::Sell : Side::Buy;
-
-    while (incoming.remaining_quantity > 0) {
-        const BookOrder* contra = book.front_of_best(contra_side);
-        if (contra == nullptr) {
-            break;
-        }
-        const bool crosses = incoming.side == Side::Buy ? incoming.price >= contra->price : incoming.price <= contra->price;
-        if (!crosses) {
-            break;
-        }
-
-        // Everything this iteration still needs once the book has been
-        // mutated, read out while `contra` is guaranteed to be valid: the
-        // full-fill branch below calls remove_front(), which destroys the
-        // order this points at.
-        const AccountId contra_account_id = contra->account_id;
-        const ClientOrderId contra_client_order_id = contra->client_order_id;
-        const ExchangeOrderId contra_exchange_order_id = contra->exchange_order_id;
-        const Side contra_order_side = contra->side;
-        const Price contra_price = contra->price;
-
-        const Quantity trade_qty = std::min(incoming.remaining_quantity, contra->remaining_quantity);
-        incoming.remaining_quantity -= trade_qty;
-        const Quantity contra_remaining_after = contra->remaining_quantity - trade_qty;
-
-        const TradeCounterparty aggressor_cp{
-            .account_id = incoming.account_id,
-            .client_order_id = incoming.client_order_id,
-            .exchange_order_id = incoming.exchange_order_id,
-            .remaining_quantity = incoming.remaining_quantity,
-        };
-        const TradeCounterparty resting_cp{
-            .account_id = contra_account_id,
-            .client_order_id = contra_client_order_id,
-            .exchange_order_id = contra_exchange_order_id,
-            .remaining_quantity = contra_remaining_after,
-        };
-
-        // Price-time priority convention: a trade executes at the resting
-        // (passive) order's price, never the incoming (aggressive) order's
-        // price -- the resting order is the one that already committed to a
-        // price by sitting on the book.
-        sink(TradeExecuted{
-            .event_sequence = next_event_sequence_++,
-            .command_sequence = command_sequence,
-            .instrument_id = incoming.instrument_id,
-            .price = contra_price,
-            .quantity = trade_qty,
-            .aggressor_side = incoming.side,
-            .buyer = incoming.side == Side::Buy ? aggressor_cp : resting_cp,
-            .seller = incoming.side == Side::Buy ? resting_cp : aggressor_cp,
-        });
-
-        if (contra_remaining_after == 0) {
-            book.remove_front(contra_side);
-            orders_.erase(LiveKey{contra_account_id, contra_client_order_id});
-            sink(BookOrderRemoved{
-                .event_sequence = next_event_sequence_++,
-                .instrument_id = incoming.instrument_id,
-                .exchange_order_id = contra_exchange_order_id,
-                .side = contra_order_side,
-                .price = contra_price,
-            });
-        } else {
-            book.reduce_front(contra_side, contra_remaining_after);
-            sink(BookOrderReduced{
-                .event_sequence = next_event_sequence_++,
-                .instrument_id = incoming.instrument_id,
-                .exchange_order_id = contra_exchange_order_id,
-                .side = contra_order_side,
-                .price = contra_price,
-                .new_remaining_quantity = contra_remaining_after,
-            });
-        }
+    changes.books.reserve(dirty_books_.size());
+    for (const std::uint32_t slot : dirty_books_) {
+        BookActivity& activity = activity_[slot];
+        activity.dirty = false;
+        // A book can be dirty and unchanged -- an order added and then taken
+        // out again -- but its version has still moved, so it is reported;
+        // telling the two apart would mean comparing the orders themselves.
+        activity.snapshot_version = book_version(slot);
+        changes.books.push_back(snapshot_book(slot));
     }
+    dirty_books_.clear();
+    return changes;
 }
 
-void MatchingEngine::rest_remainder_if_applicable(const ExchangeRestingOrder& order, const EventSink& sink) {
-    if (order.time_in_force != TimeInForce::GTC || order.remaining_quantity == 0) {
-        // IOC/FOK: any remainder is discarded silently -- never accepted as
-        // resting, so there is nothing to announce.
-        return;
-    }
-    const MatchingBook::Handle handle = book_for(order.instrument_id).add(BookOrder{
-        .exchange_order_id = order.exchange_order_id,
-        .client_order_id = order.client_order_id,
-        .account_id = order.account_id,
-        .price = order.price,
-        .remaining_quantity = order.remaining_quantity,
-        .side = order.side,
-        .time_in_force = order.time_in_force,
-    });
-    orders_.insert_or_assign(LiveKey{order.account_id, order.client_order_id},
-                             OrderRef{
-                                 .original_quantity = order.original_quantity,
-                                 .order_sequence = order.order_sequence,
-                                 .handle = handle,
-                                 .instrument_id = order.instrument_id,
-                             });
-    sink(BookOrderAdded{
-        .event_sequence = next_event_sequence_++,
-        .instrument_id = order.instrument_id,
-        .exchange_order_id = order.exchange_order_id,
-        .side = order.side,
-        .price = order.price,
-        .quantity = order.remaining_quantity,
-    });
-}
-
-void MatchingEngine::process_new_order(const NewOrderCommand& cmd, const EventSink& sink) {
-    // Checked before anything else, price and quantity included: an
-    // instrument this engine does not trade is not a malformed order, it is
-    // an order sent to the wrong venue, and saying so is more useful than
-    // reporting whichever other field happens to also be wrong.
-    if (!knows_instrument(cmd.instrument_id)) {
-        sink(OrderRejected{
-            .event_sequence = next_event_sequence_++,
-            .command_sequence = cmd.command_sequence,
-            .account_id = cmd.account_id,
-            .client_order_id = cmd.client_order_id,
-            .instrument_id = cmd.instrument_id,
-            .reason = RejectReason::InvalidInstrument,
-        });
-        return;
-    }
-    if (cmd.price <= 0) {
-        sink(OrderRejected{
-            .event_sequence = next_event_sequence_++,
-            .command_sequence = cmd.command_sequence,
-            .account_id = cmd.account_id,
-            .client_order_id = cmd.client_order_id,
-            .instrument_id = cmd.instrument_id,
-            .reason = RejectReason::InvalidPrice,
-        });
-        return;
-    }
-    if (cmd.quantity == 0) {
-        sink(OrderRejected{
-            .event_sequence = next_event_sequence_++,
-            .command_sequence = cmd.command_sequence,
-            .account_id = cmd.account_id,
-            .client_order_id = cmd.client_order_id,
-            .instrument_id = cmd.instrument_id,
-            .reason = RejectReason::InvalidQuantity,
-        });
-        return;
-    }
-
-    const LiveKey key{cmd.account_id, cmd.client_order_id};
-    if (orders_.contains(key)) {
-        sink(OrderRejected{
-            .event_sequence = next_event_sequence_++,
-            .command_sequence = cmd.command_sequence,
-            .account_id = cmd.account_id,
-            .client_order_id = cmd.client_order_id,
-            .instrument_id = cmd.instrument_id,
-            .reason = RejectReason::DuplicateOrderId,
-        });
-        return;
-    }
+void MatchingEngine::process(const ExchangeCommand& command, const EventSink& sink) { process_command(command, sink); }
 
-    if (cmd.time_in_force == TimeInForce::FOK) {
-        const Quantity available = crossable_quantity(cmd.instrument_id, cmd.side, cmd.price, cmd.quantity);
-        if (available < cmd.quantity) {
-            // No OrderAccepted, no book mutation: FOK either fills
-            // completely or never touches the book at all.
-            sink(OrderRejected{
-                .event_sequence = next_event_sequence_++,
-                .command_sequence = cmd.command_sequence,
-                .account_id = cmd.account_id,
-                .client_order_id = cmd.client_order_id,
-                .instrument_id = cmd.instrument_id,
-                .reason = RejectReason::InsufficientLiquidity,
-            });
-            return;
-        }
+void MatchingEngine::process_batch(std::span<const ExchangeCommand> commands, EventBuffer& out) {
+    // A lambda rather than the buffer itself, so the matching templates see
+    // one calling convention -- sink(event) -- whichever output they are
+    // building. It inlines away.
+    const auto append = [&out](const auto& event) { out.append(event); };
+    for (const ExchangeCommand& command : commands) {
+        process_command(command, append);
+        out.end_command();
     }
-
-    const ExchangeOrderId exchange_order_id = next_exchange_order_id_++;
-    ExchangeRestingOrder order{
-        .exchange_order_id = exchange_order_id,
-        .client_order_id = cmd.client_order_id,
-        .account_id = cmd.account_id,
-        .price = cmd.price,
-        .original_quantity = cmd.quantity,
-        .remaining_quantity = cmd.quantity,
-        .order_sequence = next_priority_++,
-        .instrument_id = cmd.instrument_id,
-        .side = cmd.side,
-        .time_in_force = cmd.time_in_force,
-    };
-
-    sink(OrderAccepted{
-        .event_sequence = next_event_sequence_++,
-        .command_sequence = cmd.command_sequence,
-        .account_id = cmd.account_id,
-        .client_order_id = cmd.client_order_id,
-        .exchange_order_id = exchange_order_id,
-        .instrument_id = cmd.instrument_id,
-        .side = cmd.side,
-        .price = cmd.price,
-        .quantity = cmd.quantity,
-        .order_type = cmd.order_type,
-        .time_in_force = cmd.time_in_force,
-    });
-
-    match_and_rest(order, cmd.command_sequence, sink);
-    rest_remainder_if_applicable(order, sink);
 }
 
-void MatchingEngine::process_cancel(const CancelOrderCommand& cmd, const EventSink& sink) {
-    // Ahead of the order-id lookup, so a cancel naming an instrument this
-    // engine does not trade reports that rather than UnknownOrderId -- which
-    // would be true but would send the client looking in the wrong place.
-    if (!knows_instrument(cmd.instrument_id)) {
-        sink(OrderRejected{
-            .event_sequence = next_event_sequence_++,
-            .command_sequence = cmd.command_sequence,
-            .account_id = cmd.account_id,
-            .client_order_id = cmd.client_order_id,
-            .instrument_id = cmd.instrument_id,
-            .reason = RejectReason::InvalidInstrument,
-        });
-        return;
+std::size_t MatchingEngine::live_quotes(AccountId account_id, InstrumentId instrument_id,
+                                       std::span<ClientOrderId> out) const {
+    const QuoteKey key{account_id, instrument_id};
+    const auto it = quotes_.find(key);
+    if (it == quotes_.end()) {
+        return 0;
     }
-
-    const LiveKey key{cmd.account_id, cmd.client_order_id};
-    auto it = orders_.find(key);
-    if (it == orders_.end() || it->second.instrument_id != cmd.instrument_id) {
-        sink(OrderRejected{
-            .event_sequence = next_event_sequence_++,
-            .command_sequence = cmd.command_sequence,
-            .account_id = cmd.account_id,
-            .client_order_id = cmd.client_order_id,
-            .instrument_id = cmd.instrument_id,
-            .reason = RejectReason::UnknownOrderId,
-        });
-        return;
+    std::size_t written = 0;
+    for (const QuotedLevel& level : it->second) {
+        if (written == out.size()) {
+            break;
+        }
+        if (find_quoted(key, level) != nullptr) {
+            out[written++] = level.client_order_id;
+        }
     }
-
-    const MatchingBook::Handle handle = it->second.handle;
-    orders_.erase(it);
-    const BookOrder removed = book_for(cmd.instrument_id).remove_at(handle);
-
-    sink(OrderCancelled{
-        .event_sequence = next_event_sequence_++,
-        .command_sequence = cmd.command_sequence,
-        .account_id = cmd.account_id,
-        .client_order_id = cmd.client_order_id,
-        .exchange_order_id = removed.exchange_order_id,
-        .instrument_id = cmd.instrument_id,
-    });
-    sink(BookOrderRemoved{
-        .event_sequence = next_event_sequence_++,
-        .instrument_id = cmd.instrument_id,
-        .exchange_order_id = removed.exchange_order_id,
-        .side = removed.side,
-        .price = removed.price,
-    });
+    return written;
 }
 
-void MatchingEngine::process_replace(const ReplaceOrderCommand& cmd, const EventSink& sink) {
-    if (!knows_instrument(cmd.instrument_id)) {
-        sink(OrderRejected{
-            .event_sequence = next_event_sequence_++,
-            .command_sequence = cmd.command_sequence,
-            .account_id = cmd.account_id,
-            .client_order_id = cmd.original_client_order_id,
-            .instrument_id = cmd.instrument_id,
-            .reason = RejectReason::InvalidInstrument,
-        });
-        return;
-    }
-    if (cmd.new_price <= 0 || cmd.new_quantity == 0) {
-        sink(OrderRejected{
-            .event_sequence = next_event_sequence_++,
-            .command_sequence = cmd.command_sequence,
-            .account_id = cmd.account_id,
-            .client_order_id = cmd.original_client_order_id,
-            .instrument_id = cmd.instrument_id,
-            .reason = RejectReason::InvalidReplacement,
-        });
-        return;
-    }
-
-    const LiveKey original_key{cmd.account_id, cmd.original_client_order_id};
-    auto it = orders_.find(original_key);
-    if (it == orders_.end() || it->second.instrument_id != cmd.instrument_id) {
-        sink(OrderRejected{
-            .event_sequence = next_event_sequence_++,
-            .command_sequence = cmd.command_sequence,
-            .account_id = cmd.account_id,
-            .client_order_id = cmd.original_client_order_id,
-            .instrument_id = cmd.instrument_id,
-            .reason = RejectReason::UnknownOrderId,
-        });
-        return;
-    }
-
-    const OrderRef ref = it->second;
-    MatchingBook& book = book_for(cmd.instrument_id);
-    // Read out everything wanted after the book is mutated, while the
-    // reference is still known good -- the priority-losing path below
-    // destroys the order it points at.
-    const BookOrder& resting = book.at(ref.handle);
-    const ExchangeOrderId old_exchange_order_id = resting.exchange_order_id;
-    const Side old_side = resting.side;
-    const Price old_price = resting.price;
-    const TimeInForce old_time_in_force = resting.time_in_force;
-
-    // Priority-preserving path: same price, quantity unchanged or decreased.
-    // A price change or a quantity *increase* falls through to the
-    // cancel-plus-new path below (see the class-level policy comment in
-    // matching_engine.hpp).
-    const bool preserves_priority = cmd.new_price == old_price && cmd.new_quantity <= resting.remaining_quantity;
-
-    if (preserves_priority) {
-        book.reduce_at(ref.handle, cmd.new_quantity);
-        book.set_client_order_id_at(ref.handle, cmd.new_client_order_id);
-        // Same order, same place in the queue, addressable under its new
-        // client order id: the entry is re-keyed, not rebuilt.
-        orders_.erase(it);
-        orders_.insert_or_assign(LiveKey{cmd.account_id, cmd.new_client_order_id}, ref);
-
-        sink(OrderReplaced{
-            .event_sequence = next_event_sequence_++,
-            .command_sequence = cmd.command_sequence,
-            .account_id = cmd.account_id,
-            .original_client_order_id = cmd.original_client_order_id,
-            .new_client_order_id = cmd.new_client_order_id,
-            .exchange_order_id = old_exchange_order_id,
-            .instrument_id = cmd.instrument_id,
-            .new_price = cmd.new_price,
-            .new_quantity = cmd.new_quantity,
-        });
-        sink(BookOrderReduced{
-            .event_sequence = next_event_sequence_++,
-            .instrument_id = cmd.instrument_id,
-            .exchange_order_id = old_exchange_order_id,
-            .side = old_side,
-            .price = old_price,
-            .new_remaining_quantity = cmd.new_quantity,
-        });
-        return;
-    }
-
-    // Priority-losing path: cancel-plus-new. The old order vanishes from the
-    // book and a freshly-id'd order re-enters the ordinary matching path, so
-    // a reprice into a crossing price trades immediately just like any other
-    // aggressive new order.
-    book.remove_at(ref.handle);
-    orders_.erase(it);
-
-    const ExchangeOrderId new_exchange_order_id = next_exchange_order_id_++;
-    sink(OrderReplaced{
-        .event_sequence = next_event_sequence_++,
-        .command_sequence = cmd.command_sequence,
-        .account_id = cmd.account_id,
-        .original_client_order_id = cmd.original_client_order_id,
-        .new_client_order_id = cmd.new_client_order_id,
-        .exchange_order_id = new_exchange_order_id,
-        .instrument_id = cmd.instrument_id,
-        .new_price = cmd.new_price,
-        .new_quantity = cmd.new_quantity,
-    });
-    sink(BookOrderRemoved{
-        .event_sequence = next_event_sequence_++,
-        .instrument_id = cmd.instrument_id,
-        .exchange_order_id = old_exchange_order_id,
-        .side = old_side,
-        .price = old_price,
-    });
-
-    ExchangeRestingOrder new_order{
-        .exchange_order_id = new_exchange_order_id,
-        .client_order_id = cmd.new_client_order_id,
-        .account_id = cmd.account_id,
-        .price = cmd.new_price,
-        .original_quantity = cmd.new_quantity,
-        .remaining_quantity = cmd.new_quantity,
-        .order_sequence = next_priority_++,
-        .instrument_id = cmd.instrument_id,
-        .side = old_side,
-        .time_in_force = old_time_in_force,
-    };
-    match_and_rest(new_order, cmd.command_sequence, sink);
-    rest_remainder_if_applicable(new_order, sink);
+Quantity MatchingEngine::crossable_quantity(InstrumentId instrument_id, Side incoming_side, Price price,
+                                             Quantity quantity) const {
+    const Side contra_side = incoming_side == Side::Buy ? Side::Sell : Side::Buy;
+    return book_for(instrument_id).crossable_quantity(contra_side, price, quantity);
 }
 
 } // namespace mdh::exchange
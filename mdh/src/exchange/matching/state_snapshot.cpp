@@ -0,0 +1,37 @@
+#include "exchange/matching/state_snapshot.hpp"
+
+#include <cstddef>
+#include <utility>
+
+namespace mdh::exchange {
+
+void apply_changes(EngineStateSnapshot& snapshot, const EngineStateChanges& changes) {
+    if (changes.books.empty()) {
+        return;
+    }
+    // A merge of two lists sorted by instrument id into a third, rather than
+    // a search-and-insert per change: one change per book would otherwise
+    // shift the tail of the vector once each.
+    std::vector<InstrumentBookSnapshot> merged;
+    merged.reserve(snapshot.instruments.size() + changes.books.size());
+    std::size_t kept = 0;
+    for (const InstrumentBookSnapshot& changed : changes.books) {
+        while (kept < snapshot.instruments.size() &&
+               snapshot.instruments[kept].instrument_id < changed.instrument_id) {
+            merged.push_back(std::move(snapshot.instruments[kept++]));
+        }
+        if (kept < snapshot.instruments.size() && snapshot.instruments[kept].instrument_id == changed.instrument_id) {
+            ++kept; // superseded
+        }
+        if (!changed.bids.empty() || !changed.asks.empty() || !changed.stops.empty() ||
+            changed.phase != TradingPhase::Continuous) {
+            merged.push_back(changed);
+        }
+    }
+    while (kept < snapshot.instruments.size()) {
+        merged.push_back(std::move(snapshot.instruments[kept++]));
+    }
+    snapshot.instruments = std::move(merged);
+}
+
+} // namespace mdh::exchange
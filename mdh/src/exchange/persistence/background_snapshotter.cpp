@@ -0,0 +1,63 @@
+#include "exchange/persistence/background_snapshotter.hpp"
+
+#include <chrono>
+#include <utility>
+
+namespace mdh::exchange::persistence {
+
+namespace {
+using namespace std::chrono_literals;
+// How long the snapshot thread sleeps when it finds nothing to apply. It is
+// the latency of a snapshot, not of matching, so it can afford to be long
+// enough not to spin a core; the matching thread never waits on it.
+constexpr auto kIdleInterval = 1ms;
+} // namespace
+
+BackgroundSnapshotter::BackgroundSnapshotter(BackgroundSnapshotterOptions options)
+    : options_(std::move(options)), queue_(options_.queue_capacity),
+      thread_([this](std::stop_token token) { run(std::move(token)); }) {}
+
+BackgroundSnapshotter::~BackgroundSnapshotter() { stop(); }
+
+bool BackgroundSnapshotter::capture(MatchingEngine& engine) {
+    if (!engine.has_snapshot_changes()) {
+        return true;
+    }
+    // Checked before taking the changes, not after: snapshot_changes()
+    // forgets what it returns, so changes taken and then refused by the
+    // queue would be lost to every later image. Race-free because this is
+    // the only producer.
+    if (queue_.size() >= queue_.capacity()) {
+        declined_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return queue_.try_push(engine.snapshot_changes());
+}
+
+void BackgroundSnapshotter::stop() {
+    thread_.request_stop();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void BackgroundSnapshotter::run(std::stop_token token) {
+    place_current_thread("mdh-snapshot", options_.placement);
+    while (true) {
+        auto changes = queue_.try_pop();
+        if (!changes) {
+            if (token.stop_requested()) {
+                break; // stop requested and nothing left to apply
+            }
+            std::this_thread::sleep_for(kIdleInterval);
+            continue;
+        }
+        apply_changes(image_, *changes);
+        if (options_.on_snapshot) {
+            options_.on_snapshot(image_, *changes);
+        }
+        applied_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+} // namespace mdh::exchange::persistence
@@ -1,5 +1,7 @@
 #include "exchange/persistence/command_decoder.hpp"
 
+#include <utility>
+
 #include "common/byte_io.hpp"
 
 namespace mdh::exchange::persistence {
@@ -12,6 +14,10 @@ namespace {
         case static_cast<std::uint8_t>(CommandMessageType::CancelOrder):
         case static_cast<std::uint8_t>(CommandMessageType::ReplaceOrder):
         case static_cast<std::uint8_t>(CommandMessageType::RegisterInstrument):
+        case static_cast<std::uint8_t>(CommandMessageType::MassQuote):
+        case static_cast<std::uint8_t>(CommandMessageType::MassCancel):
+        case static_cast<std::uint8_t>(CommandMessageType::ClockTick):
+        case static_cast<std::uint8_t>(CommandMessageType::TradingPhase):
             return true;
         default:
             return false;
@@ -22,19 +28,33 @@ namespace {
     return raw == static_cast<std::uint8_t>(Side::Buy) || raw == static_cast<std::uint8_t>(Side::Sell);
 }
 
-[[nodiscard]] bool is_valid_order_type(std::uint8_t raw) { return raw == static_cast<std::uint8_t>(OrderType::Limit); }
+[[nodiscard]] bool is_valid_order_type(std::uint8_t raw) {
+    return raw == static_cast<std::uint8_t>(OrderType::Limit) || raw == static_cast<std::uint8_t>(OrderType::StopLimit);
+}
 
 [[nodiscard]] bool is_valid_time_in_force(std::uint8_t raw) {
     switch (raw) {
         case static_cast<std::uint8_t>(TimeInForce::GTC):
         case static_cast<std::uint8_t>(TimeInForce::IOC):
         case static_cast<std::uint8_t>(TimeInForce::FOK):
+        case static_cast<std::uint8_t>(TimeInForce::GTD):
             return true;
         default:
             return false;
     }
 }
 
+// The fixed size, or for a mass quote its prefix plus whole entries. The
+// journal holds whatever the engine was given, so unlike the order-entry
+// decoder this does not cap the count: a frame the u16 can describe is one
+// that was written.
+[[nodiscard]] bool is_valid_payload_size(CommandMessageType type, std::size_t payload_size) {
+    if (type != CommandMessageType::MassQuote) {
+        return payload_size == payload_size_for(type);
+    }
+    return payload_size >= MASS_QUOTE_PREFIX_SIZE && (payload_size - MASS_QUOTE_PREFIX_SIZE) % MASS_QUOTE_ENTRY_SIZE == 0;
+}
+
 } // namespace
 
 std::variant<CommandHeader, CommandDecodeError> decode_command_header(std::span<const std::byte> data) {
@@ -72,8 +92,7 @@ DecodedFrame decode_journal_frame(std::span<const std::byte> data) {
     }
     const CommandHeader& header = std::get<CommandHeader>(header_result);
 
-    const std::size_t expected_payload = payload_size_for(header.type);
-    if (header.payload_size != expected_payload) {
+    if (!is_valid_payload_size(header.type, header.payload_size)) {
         return CommandDecodeError::InvalidMessageSize;
     }
     if (data.size() < HEADER_SIZE + header.payload_size) {
@@ -92,8 +111,10 @@ DecodedFrame decode_journal_frame(std::span<const std::byte> data) {
             auto quantity = r.get_u64();
             auto order_type_raw = r.get_u8();
             auto tif_raw = r.get_u8();
+            auto expire_at = r.get_u64();
+            auto stop_price = r.get_i64();
             if (!account_id || !client_order_id || !instrument_id || !side_raw || !price || !quantity ||
-                !order_type_raw || !tif_raw) {
+                !order_type_raw || !tif_raw || !expire_at || !stop_price) {
                 return CommandDecodeError::TruncatedPayload;
             }
             if (!is_valid_side(*side_raw)) {
@@ -115,6 +136,8 @@ DecodedFrame decode_journal_frame(std::span<const std::byte> data) {
                 .quantity = *quantity,
                 .order_type = static_cast<OrderType>(*order_type_raw),
                 .time_in_force = static_cast<TimeInForce>(*tif_raw),
+                .expire_at = *expire_at,
+                .stop_price = *stop_price,
             }};
         }
         case CommandMessageType::CancelOrder: {
@@ -152,6 +175,94 @@ DecodedFrame decode_journal_frame(std::span<const std::byte> data) {
                 .new_quantity = *new_quantity,
             }};
         }
+        case CommandMessageType::MassQuote: {
+            auto account_id = r.get_u64();
+            auto instrument_id = r.get_u32();
+            if (!account_id || !instrument_id) {
+                return CommandDecodeError::TruncatedPayload;
+            }
+            MassQuoteCommand quote{
+                .command_sequence = header.command_sequence,
+                .account_id = *account_id,
+                .instrument_id = *instrument_id,
+                .entries = {},
+            };
+            const std::size_t count = (header.payload_size - MASS_QUOTE_PREFIX_SIZE) / MASS_QUOTE_ENTRY_SIZE;
+            quote.entries.reserve(count);
+            for (std::size_t i = 0; i < count; ++i) {
+                auto client_order_id = r.get_u64();
+                auto side_raw = r.get_u8();
+                auto price = r.get_i64();
+                auto quantity = r.get_u64();
+                if (!client_order_id || !side_raw || !price || !quantity) {
+                    return CommandDecodeError::TruncatedPayload;
+                }
+                if (!is_valid_side(*side_raw)) {
+                    return CommandDecodeError::InvalidSide;
+                }
+                quote.entries.push_back(QuoteEntry{
+                    .client_order_id = *client_order_id,
+                    .side = static_cast<Side>(*side_raw),
+                    .price = *price,
+                    .quantity = *quantity,
+                });
+            }
+            return ExchangeCommand{std::move(quote)};
+        }
+        case CommandMessageType::MassCancel: {
+            auto account_id = r.get_u64();
+            auto flags = r.get_u8();
+            auto instrument_id = r.get_u32();
+            auto side_raw = r.get_u8();
+            auto max_orders = r.get_u32();
+            auto before_exchange_order_id = r.get_u64();
+            if (!account_id || !flags || !instrument_id || !side_raw || !max_orders || !before_exchange_order_id) {
+                return CommandDecodeError::TruncatedPayload;
+            }
+            const bool has_instrument = (*flags & MASS_CANCEL_HAS_INSTRUMENT) != 0;
+            const bool has_side = (*flags & MASS_CANCEL_HAS_SIDE) != 0;
+            if ((*flags & ~(MASS_CANCEL_HAS_INSTRUMENT | MASS_CANCEL_HAS_SIDE)) != 0 ||
+                (!has_instrument && *instrument_id != 0) || (!has_side && *side_raw != 0)) {
+                return CommandDecodeError::InvalidFlags;
+            }
+            if (has_side && !is_valid_side(*side_raw)) {
+                return CommandDecodeError::InvalidSide;
+            }
+            MassCancelCommand cancel{
+                .command_sequence = header.command_sequence,
+                .account_id = *account_id,
+                .instrument_id = std::nullopt,
+                .side = std::nullopt,
+                .max_orders = *max_orders,
+                .before_exchange_order_id = *before_exchange_order_id,
+            };
+            if (has_instrument) cancel.instrument_id = *instrument_id;
+            if (has_side) cancel.side = static_cast<Side>(*side_raw);
+            return ExchangeCommand{cancel};
+        }
+        case CommandMessageType::ClockTick: {
+            auto now = r.get_u64();
+            if (!now) {
+                return CommandDecodeError::TruncatedPayload;
+            }
+            return ExchangeCommand{ClockTickCommand{.command_sequence = header.command_sequence, .now = *now}};
+        }
+        case CommandMessageType::TradingPhase: {
+            auto instrument_id = r.get_u32();
+            auto phase_raw = r.get_u8();
+            if (!instrument_id || !phase_raw) {
+                return CommandDecodeError::TruncatedPayload;
+            }
+            if (*phase_raw != static_cast<std::uint8_t>(TradingPhase::Continuous) &&
+                *phase_raw != static_cast<std::uint8_t>(TradingPhase::Call)) {
+                return CommandDecodeError::InvalidTradingPhase;
+            }
+            return ExchangeCommand{TradingPhaseCommand{
+                .command_sequence = header.command_sequence,
+                .instrument_id = *instrument_id,
+                .phase = static_cast<TradingPhase>(*phase_raw),
+            }};
+        }
         case CommandMessageType::RegisterInstrument: {
             auto instrument_id = r.get_u32();
             if (!instrument_id) {
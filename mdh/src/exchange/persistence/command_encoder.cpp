@@ -40,6 +40,8 @@ void encode_command(const ExchangeCommand& command, std::vector<std::byte>& out)
                 io::put_u64(out, cmd.quantity);
                 put_order_type(out, cmd.order_type);
                 put_time_in_force(out, cmd.time_in_force);
+                io::put_u64(out, cmd.expire_at);
+                io::put_i64(out, cmd.stop_price);
             } else if constexpr (std::is_same_v<T, CancelOrderCommand>) {
                 put_header(out, CommandMessageType::CancelOrder, cmd.command_sequence,
                            static_cast<std::uint16_t>(payload_size_for(CommandMessageType::CancelOrder)));
@@ -55,6 +57,38 @@ void encode_command(const ExchangeCommand& command, std::vector<std::byte>& out)
                 io::put_u32(out, cmd.instrument_id);
                 io::put_i64(out, cmd.new_price);
                 io::put_u64(out, cmd.new_quantity);
+            } else if constexpr (std::is_same_v<T, MassQuoteCommand>) {
+                put_header(out, CommandMessageType::MassQuote, cmd.command_sequence,
+                           static_cast<std::uint16_t>(mass_quote_payload_size(cmd.entries.size())));
+                io::put_u64(out, cmd.account_id);
+                io::put_u32(out, cmd.instrument_id);
+                for (const QuoteEntry& entry : cmd.entries) {
+                    io::put_u64(out, entry.client_order_id);
+                    put_side(out, entry.side);
+                    io::put_i64(out, entry.price);
+                    io::put_u64(out, entry.quantity);
+                }
+            } else if constexpr (std::is_same_v<T, MassCancelCommand>) {
+                put_header(out, CommandMessageType::MassCancel, cmd.command_sequence,
+                           static_cast<std::uint16_t>(payload_size_for(CommandMessageType::MassCancel)));
+                std::uint8_t flags = 0;
+                if (cmd.instrument_id) flags |= MASS_CANCEL_HAS_INSTRUMENT;
+                if (cmd.side) flags |= MASS_CANCEL_HAS_SIDE;
+                io::put_u64(out, cmd.account_id);
+                io::put_u8(out, flags);
+                io::put_u32(out, cmd.instrument_id.value_or(0));
+                io::put_u8(out, cmd.side ? static_cast<std::uint8_t>(*cmd.side) : 0);
+                io::put_u32(out, cmd.max_orders);
+                io::put_u64(out, cmd.before_exchange_order_id);
+            } else if constexpr (std::is_same_v<T, ClockTickCommand>) {
+                put_header(out, CommandMessageType::ClockTick, cmd.command_sequence,
+                           static_cast<std::uint16_t>(payload_size_for(CommandMessageType::ClockTick)));
+                io::put_u64(out, cmd.now);
+            } else if constexpr (std::is_same_v<T, TradingPhaseCommand>) {
+                put_header(out, CommandMessageType::TradingPhase, cmd.command_sequence,
+                           static_cast<std::uint16_t>(payload_size_for(CommandMessageType::TradingPhase)));
+                io::put_u32(out, cmd.instrument_id);
+                io::put_u8(out, static_cast<std::uint8_t>(cmd.phase));
             }
         },
         command);
@@ -44,6 +44,12 @@ CommandReplayOutcome run_command_replay(const std::string& journal_path, const C
 
         outcome.engine.process(std::get<ExchangeCommand>(*frame), sink);
         ++outcome.commands_processed;
+        if (options.hash_every_commands != 0 && outcome.commands_processed % options.hash_every_commands == 0) {
+            outcome.state_hashes.push_back(StateHashCheckpoint{
+                .commands = outcome.engine.commands_processed(),
+                .state_hash = outcome.engine.state_hash(),
+            });
+        }
     }
 
     return outcome;
@@ -3,6 +3,7 @@
 #include <vector>
 
 #include "common/byte_io.hpp"
+#include "exchange/matching/state_digest.hpp"
 
 namespace mdh::exchange::persistence {
 
@@ -52,8 +53,41 @@ std::uint64_t hash_state_snapshot(const EngineStateSnapshot& snapshot) {
         for (const auto& order : instrument.asks) {
             put_order(buf, order);
         }
+        io::put_u64(buf, instrument.expiries.size());
+        for (const auto& expiry : instrument.expiries) {
+            io::put_u64(buf, expiry.exchange_order_id);
+            io::put_u64(buf, expiry.expire_at);
+        }
+        io::put_u64(buf, instrument.stops.size());
+        for (const auto& stop : instrument.stops) {
+            put_order(buf, stop.order);
+            io::put_i64(buf, stop.stop_price);
+        }
+        io::put_u8(buf, static_cast<std::uint8_t>(instrument.phase));
     }
     return fnv1a(buf);
 }
 
+std::uint64_t rolling_state_hash(const EngineStateSnapshot& snapshot) {
+    std::uint64_t hash = 0;
+    for (const auto& instrument : snapshot.instruments) {
+        std::uint64_t book_digest = 0;
+        for (const auto* side : {&instrument.bids, &instrument.asks}) {
+            for (const auto& order : *side) {
+                book_digest += order_digest(BookOrder{
+                    .exchange_order_id = order.exchange_order_id,
+                    .client_order_id = order.client_order_id,
+                    .account_id = order.account_id,
+                    .price = order.price,
+                    .remaining_quantity = order.remaining_quantity,
+                    .side = order.side,
+                    .time_in_force = order.time_in_force,
+                });
+            }
+        }
+        hash += instrument_weight(instrument.instrument_id) * book_digest;
+    }
+    return hash;
+}
+
 } // namespace mdh::exchange::persistence
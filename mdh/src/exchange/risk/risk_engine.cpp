@@ -53,4 +53,42 @@ RejectReason RiskEngine::check(const ReplaceOrderCommand& command, const ledger:
     return RejectReason::None;
 }
 
+RejectReason RiskEngine::check(const MassQuoteCommand& command, const ledger::Ledger& ledger,
+                               std::span<const ClientOrderId> standing) const {
+    ledger::Balance cash_required = 0;
+    Quantity position_required = 0;
+    for (const QuoteEntry& entry : command.entries) {
+        if (entry.quantity > limits_.max_order_quantity) {
+            return RejectReason::OrderTooLarge;
+        }
+        if (entry.side == Side::Buy) {
+            cash_required += static_cast<ledger::Balance>(entry.quantity) * entry.price;
+        } else {
+            position_required += entry.quantity;
+        }
+    }
+
+    ledger::Balance cash_released = 0;
+    Quantity position_released = 0;
+    for (const ClientOrderId client_order_id : standing) {
+        const auto hold = ledger.find_hold(command.account_id, client_order_id);
+        if (!hold.has_value()) {
+            continue;
+        }
+        if (hold->side == Side::Buy) {
+            cash_released += static_cast<ledger::Balance>(hold->remaining) * hold->limit_price;
+        } else {
+            position_released += hold->remaining;
+        }
+    }
+
+    if (cash_required > ledger.available_cash(command.account_id) + cash_released) {
+        return RejectReason::InsufficientFunds;
+    }
+    if (position_required > ledger.available_position(command.account_id, command.instrument_id) + position_released) {
+        return RejectReason::InsufficientPosition;
+    }
+    return RejectReason::None;
+}
+
 } // namespace mdh::exchange::risk
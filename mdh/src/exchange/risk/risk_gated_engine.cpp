@@ -1,5 +1,6 @@
 #include "exchange/risk/risk_gated_engine.hpp"
 
+#include <array>
 #include <variant>
 
 namespace mdh::exchange::risk {
@@ -7,7 +8,9 @@ namespace mdh::exchange::risk {
 RiskGatedEngine::RiskGatedEngine(MatchingEngine& engine, ledger::Ledger& ledger, RiskLimits limits)
     : engine_(engine), ledger_(ledger), risk_(limits) {}
 
-void RiskGatedEngine::process(const ExchangeCommand& command, const EventSink& sink) {
+void RiskGatedEngine::process(const ExchangeCommand& command, const EventSink& sink) { process_gated(command, sink); }
+
+RejectReason RiskGatedEngine::pre_trade_check(const ExchangeCommand& command) const {
     if (const auto* new_order = std::get_if<NewOrderCommand>(&command)) {
         // Ahead of the risk check, because risk would answer the wrong
         // question about an instrument the exchange does not trade: a sell
@@ -16,37 +19,28 @@ void RiskGatedEngine::process(const ExchangeCommand& command, const EventSink& s
         // problem the client could fix. MatchingEngine::process_new_order
         // makes the same check for callers that skip this class.
         if (!engine_.knows_instrument(new_order->instrument_id)) {
-            engine_.reject_new_order(*new_order, RejectReason::InvalidInstrument, sink);
-            return;
-        }
-        const RejectReason reason = risk_.check(*new_order, ledger_);
-        if (reason != RejectReason::None) {
-            // Rejected before ever reaching process(): no OrderAccepted was
-            // emitted, so Ledger has nothing to reserve for this command --
-            // reject_new_order() only emits the event, using MatchingEngine's
-            // own event_sequence counter so numbering stays globally gapless.
-            engine_.reject_new_order(*new_order, reason, sink);
-            return;
+            return RejectReason::InvalidInstrument;
         }
-    } else if (const auto* replace = std::get_if<ReplaceOrderCommand>(&command)) {
+        return risk_.check(*new_order, ledger_);
+    }
+    if (const auto* replace = std::get_if<ReplaceOrderCommand>(&command)) {
         if (!engine_.knows_instrument(replace->instrument_id)) {
-            engine_.reject_replace_order(*replace, RejectReason::InvalidInstrument, sink);
-            return;
+            return RejectReason::InvalidInstrument;
         }
-        const RejectReason reason = risk_.check(*replace, ledger_);
-        if (reason != RejectReason::None) {
-            // Same pre-process rejection as NewOrder: the resting order and
-            // its hold are left exactly as they were. Ledger only mutates
-            // on events from a successful process() path.
-            engine_.reject_replace_order(*replace, reason, sink);
-            return;
+        // A failed replace leaves the resting order and its hold exactly as
+        // they were. Ledger only mutates on events from a successful
+        // process() path.
+        return risk_.check(*replace, ledger_);
+    }
+    if (const auto* quote = std::get_if<MassQuoteCommand>(&command)) {
+        if (!engine_.knows_instrument(quote->instrument_id)) {
+            return RejectReason::InvalidInstrument;
         }
+        std::array<ClientOrderId, kMaxQuoteEntries> standing{};
+        const std::size_t count = engine_.live_quotes(quote->account_id, quote->instrument_id, standing);
+        return risk_.check(*quote, ledger_, std::span<const ClientOrderId>(standing.data(), count));
     }
-
-    engine_.process(command, [this, &sink](const ExchangeEvent& event) {
-        ledger_.apply(event);
-        sink(event);
-    });
+    return RejectReason::None;
 }
 
 } // namespace mdh::exchange::risk
@@ -5,9 +5,13 @@
 namespace mdh::exchange::sequencing {
 
 ExchangeCommand CommandSequencer::sequence(ExchangeCommand command) {
+    sequence_in_place(command);
+    return command;
+}
+
+void CommandSequencer::sequence_in_place(ExchangeCommand& command) {
     const CommandSequence assigned = next_sequence_++;
     std::visit([assigned](auto& cmd) { cmd.command_sequence = assigned; }, command);
-    return command;
 }
 
 } // namespace mdh::exchange::sequencing
@@ -0,0 +1,221 @@
+#include "exchange/sequencing/sharded_matching_pipeline.hpp"
+
+#include <algorithm>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace mdh::exchange::sequencing {
+
+ShardedMatchingPipeline::Shard::Shard(std::span<const InstrumentId> universe, std::size_t expected_resting_orders,
+                                      ExchangeOrderIdSpace id_space, std::size_t queue_capacity,
+                                      WaitPolicy idle_wait)
+    : inbox(queue_capacity), outbox(queue_capacity), spare(queue_capacity),
+      engine(universe, expected_resting_orders, id_space), wait(idle_wait) {}
+
+ShardedMatchingPipeline::ShardedMatchingPipeline(EventSink sink, const ShardedMatchingPipelineOptions& options)
+    : sink_(std::move(sink)), routes_(std::max<std::size_t>(options.shard_count, 1) * options.queue_capacity),
+      merge_wait_(options.idle_wait) {
+    const std::size_t shard_count = std::max<std::size_t>(options.shard_count, 1);
+
+    std::vector<std::vector<InstrumentId>> universes(shard_count);
+    for (const InstrumentId instrument_id : options.instruments) {
+        universes[shard_of(instrument_id, shard_count)].push_back(instrument_id);
+    }
+
+    shards_.reserve(shard_count);
+    for (std::size_t k = 0; k < shard_count; ++k) {
+        // Each shard's share of the expected depth follows its share of the
+        // universe, the same even split MatchingEngine makes between books.
+        const std::size_t expected =
+            options.instruments.empty()
+                ? 0
+                : options.expected_resting_orders * universes[k].size() / options.instruments.size();
+        shards_.push_back(std::make_unique<Shard>(
+            universes[k], expected,
+            ExchangeOrderIdSpace{.first = k + 1, .stride = shard_count}, options.queue_capacity,
+            options.idle_wait));
+    }
+
+    // Threads only once every shard exists: none of them may observe a
+    // half-built vector.
+    const auto token = stop_source_.get_token();
+    for (auto& shard : shards_) {
+        shard->thread = std::jthread([this, &shard = *shard, token] { run_shard(shard, token); });
+    }
+    merge_thread_ = std::jthread([this, token] { run_merge(token); });
+}
+
+ShardedMatchingPipeline::~ShardedMatchingPipeline() { stop(); }
+
+void ShardedMatchingPipeline::stop() {
+    stop_source_.request_stop();
+    // A parked thread must wake to see the stop.
+    for (auto& shard : shards_) {
+        shard->wait.notify();
+    }
+    merge_wait_.notify();
+    // Shards first: the merge can only finish once every command routed to
+    // it has produced its batch, and a shard stops only with its inbox
+    // empty.
+    for (auto& shard : shards_) {
+        if (shard->thread.joinable()) {
+            shard->thread.join();
+        }
+    }
+    if (merge_thread_.joinable()) {
+        merge_thread_.join();
+    }
+}
+
+bool ShardedMatchingPipeline::submit(ExchangeCommand command) {
+    if (const auto* cancel = std::get_if<MassCancelCommand>(&command); cancel && !cancel->instrument_id) {
+        return broadcast(std::move(command));
+    }
+    if (std::holds_alternative<ClockTickCommand>(command)) {
+        return broadcast(std::move(command));
+    }
+
+    const InstrumentId instrument_id = std::visit(
+        [](const auto& cmd) -> InstrumentId {
+            using T = std::decay_t<decltype(cmd)>;
+            if constexpr (std::is_same_v<T, MassCancelCommand>) {
+                return *cmd.instrument_id; // the instrument-less one went to broadcast() above
+            } else if constexpr (std::is_same_v<T, ClockTickCommand>) {
+                return 0; // went to broadcast() above
+            } else {
+                return cmd.instrument_id;
+            }
+        },
+        command);
+    const std::size_t target = shard_of(instrument_id, shards_.size());
+    Shard& shard = *shards_[target];
+
+    // Both checked before sequencing, for MatchingPipeline::submit()'s
+    // reason: a command that is not queued must not consume a sequence
+    // number. Race-free for the same reason too -- only this thread ever
+    // adds to either queue.
+    if (shard.inbox.size() >= shard.inbox.capacity() || routes_.size() >= routes_.capacity()) {
+        commands_rejected_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // Neither push can fail after the check above. Which goes first does
+    // not matter: a merge that reads the route early simply waits for the
+    // batch.
+    (void)routes_.try_push(static_cast<std::uint32_t>(target));
+    (void)shard.inbox.try_push(sequencer_.sequence(std::move(command)));
+    shard.wait.notify();
+    merge_wait_.notify();
+    return true;
+}
+
+bool ShardedMatchingPipeline::broadcast(ExchangeCommand command) {
+    // All or nothing, checked up front for the same reason as submit():
+    // a command some shards ran and others never saw would be half a kill
+    // switch.
+    if (routes_.capacity() - routes_.size() < shards_.size() ||
+        std::any_of(shards_.begin(), shards_.end(),
+                    [](const auto& shard) { return shard->inbox.size() >= shard->inbox.capacity(); })) {
+        commands_rejected_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    const ExchangeCommand sequenced = sequencer_.sequence(std::move(command));
+    for (std::size_t k = 0; k < shards_.size(); ++k) {
+        const bool last = k + 1 == shards_.size();
+        (void)routes_.try_push(static_cast<std::uint32_t>(k) | (last ? 0u : kRouteContinues));
+        (void)shards_[k]->inbox.try_push(sequenced);
+        shards_[k]->wait.notify();
+    }
+    merge_wait_.notify();
+    return true;
+}
+
+void ShardedMatchingPipeline::run_shard(Shard& shard, std::stop_token token) {
+    while (true) {
+        auto command = shard.inbox.try_pop();
+        if (!command) {
+            if (token.stop_requested()) {
+                break;
+            }
+            shard.wait.wait_until([&] { return shard.inbox.size() > 0 || token.stop_requested(); });
+            continue;
+        }
+
+        EventBatch batch;
+        if (auto recycled = shard.spare.try_pop()) {
+            batch = std::move(*recycled);
+        }
+        shard.engine.process(*command, [&batch](const ExchangeEvent& event) { batch.push_back(event); });
+
+        // The merge drains every outbox it has routes for, so a full one
+        // only ever means this shard has run ahead; waiting here is the
+        // backpressure, and it cannot deadlock. Wait for room first rather
+        // than retrying try_push(): it takes its argument by value, so a
+        // refused push would already have moved the batch away. Only this
+        // thread adds to the outbox, so room seen here stays room.
+        shard.wait.wait_until([&] { return shard.outbox.size() < shard.outbox.capacity(); });
+        (void)shard.outbox.try_push(std::move(batch));
+        merge_wait_.notify();
+    }
+}
+
+void ShardedMatchingPipeline::run_merge(std::stop_token token) {
+    while (true) {
+        const auto route = routes_.try_pop();
+        if (!route) {
+            if (token.stop_requested()) {
+                break; // every route popped, so every batch delivered
+            }
+            merge_wait_.wait_until([&] { return routes_.size() > 0 || token.stop_requested(); });
+            continue;
+        }
+
+        Shard& shard = *shards_[*route & ~kRouteContinues];
+        std::optional<EventBatch> batch = shard.outbox.try_pop();
+        while (!batch) {
+            merge_wait_.wait_until([&] { return shard.outbox.size() > 0; });
+            batch = shard.outbox.try_pop();
+        }
+        shard.wait.notify(); // a shard with a full outbox waits for exactly this
+
+        for (ExchangeEvent& event : *batch) {
+            std::visit([this](auto& ev) { ev.event_sequence = next_event_sequence_++; }, event);
+            sink_(event);
+        }
+        if ((*route & kRouteContinues) == 0) {
+            commands_processed_.fetch_add(1, std::memory_order_release);
+        }
+
+        batch->clear();
+        (void)shard.spare.try_push(std::move(*batch)); // a full spare queue just lets this one go
+    }
+}
+
+std::size_t ShardedMatchingPipeline::idle_parks() const {
+    std::size_t parks = merge_wait_.park_count();
+    for (const auto& shard : shards_) {
+        parks += shard->wait.park_count();
+    }
+    return parks;
+}
+
+EngineStateSnapshot ShardedMatchingPipeline::snapshot() const {
+    EngineStateSnapshot merged;
+    for (const auto& shard : shards_) {
+        EngineStateSnapshot part = shard->engine.snapshot();
+        for (InstrumentBookSnapshot& instrument : part.instruments) {
+            merged.instruments.push_back(std::move(instrument));
+        }
+    }
+    // Shards are disjoint, so this is a sort rather than a merge of equals.
+    std::sort(merged.instruments.begin(), merged.instruments.end(),
+              [](const InstrumentBookSnapshot& a, const InstrumentBookSnapshot& b) {
+                  return a.instrument_id < b.instrument_id;
+              });
+    return merged;
+}
+
+} // namespace mdh::exchange::sequencing
@@ -0,0 +1,109 @@
+#include "net/poller.hpp"
+
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#endif
+
+namespace mdh::net {
+
+#if defined(__linux__)
+
+namespace {
+// The eventfd's registration key. Every other key is the caller's, and the
+// gateway's are Connection pointers and the listener's 0 -- never this.
+constexpr std::uint64_t kWakeKey = ~std::uint64_t{0};
+} // namespace
+
+Poller::Poller()
+    : epoll_fd_(::epoll_create1(EPOLL_CLOEXEC)), wake_fd_(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {
+    if (!is_open()) {
+        return;
+    }
+    // Level-triggered, unlike everything else here: wait() drains it
+    // whenever it fires, so either way it is reported once per round of
+    // wake()s, and level-triggered cannot lose one that lands mid-drain.
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = kWakeKey;
+    ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &event);
+}
+
+Poller::~Poller() {
+    if (wake_fd_ >= 0) {
+        ::close(wake_fd_);
+    }
+    if (epoll_fd_ >= 0) {
+        ::close(epoll_fd_);
+    }
+}
+
+bool Poller::add(int fd, std::uint64_t key, bool writable, bool edge_triggered) {
+    if (!is_open()) {
+        return false;
+    }
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLRDHUP | (edge_triggered ? EPOLLET : 0u) | (writable ? EPOLLOUT : 0u);
+    event.data.u64 = key;
+    return ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) == 0;
+}
+
+void Poller::remove(int fd) {
+    if (is_open()) {
+        ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+    }
+}
+
+std::size_t Poller::wait(std::span<PollEvent> out, std::chrono::milliseconds timeout) {
+    if (!is_open() || out.empty()) {
+        return 0;
+    }
+    std::array<epoll_event, kMaxEvents> raw{};
+    const int max = static_cast<int>(std::min(out.size(), raw.size()));
+    const int ready = ::epoll_wait(epoll_fd_, raw.data(), max, static_cast<int>(timeout.count()));
+    if (ready <= 0) {
+        return 0; // timed out, or EINTR -- a caller loops on wait() anyway
+    }
+
+    std::size_t reported = 0;
+    for (int i = 0; i < ready; ++i) {
+        const epoll_event& event = raw[static_cast<std::size_t>(i)];
+        if (event.data.u64 == kWakeKey) {
+            std::uint64_t count = 0;
+            (void)::read(wake_fd_, &count, sizeof(count)); // resets it; EAGAIN just means another drain got there first
+            continue;
+        }
+        out[reported++] = PollEvent{
+            .key = event.data.u64,
+            .readable = (event.events & EPOLLIN) != 0,
+            .writable = (event.events & EPOLLOUT) != 0,
+            .hangup = (event.events & (EPOLLHUP | EPOLLRDHUP | EPOLLERR)) != 0,
+        };
+    }
+    return reported;
+}
+
+void Poller::wake() {
+    if (wake_fd_ >= 0) {
+        const std::uint64_t one = 1;
+        (void)::write(wake_fd_, &one, sizeof(one));
+    }
+}
+
+#else // not Linux: no epoll. is_open() is false and every call below fails.
+
+Poller::Poller() = default;
+Poller::~Poller() = default;
+bool Poller::add(int, std::uint64_t, bool, bool) { return false; }
+void Poller::remove(int) {}
+std::size_t Poller::wait(std::span<PollEvent>, std::chrono::milliseconds) { return 0; }
+void Poller::wake() {}
+
+#endif
+
+} // namespace mdh::net
@@ -7,6 +7,7 @@
 #include <sys/socket.h>
 #include <unistd.h>
 
+#include <cerrno>
 #include <cstring>
 #include <utility>
 
@@ -105,6 +106,13 @@ std::optional<TcpSocket> TcpSocket::accept() {
     return TcpSocket(val);
 }
 
+TcpSocket TcpSocket::adopt(int fd) {
+    if (fd >= 0) {
+        disable_nagle(fd);
+    }
+    return TcpSocket(fd);
+}
+
 bool TcpSocket::connect(const std::string& host, std::uint16_t port) {
     if (!is_open()) {
         return false;
@@ -160,6 +168,45 @@ std::optional<std::size_t> TcpSocket::write(std::span<const std::byte> data) {
     return val;
 }
 
+TcpSocket::IoResult TcpSocket::try_read(std::span<std::byte> buf) {
+    while (is_open()) {
+        const auto val = ::read(fd_, buf.data(), buf.size());
+        if (val >= 0) {
+            return IoResult{.status = IoStatus::Done, .bytes = static_cast<std::size_t>(val)};
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return IoResult{.status = IoStatus::WouldBlock};
+        }
+        if (errno != EINTR) {
+            break;
+        }
+    }
+    return IoResult{.status = IoStatus::Failed};
+}
+
+TcpSocket::IoResult TcpSocket::try_write(std::span<const std::byte> data) {
+    while (is_open()) {
+        // send() rather than write() for MSG_NOSIGNAL where there is one: a
+        // peer that has gone away must fail this call, not raise SIGPIPE in
+        // a process whose event loop serves everyone else's sessions too.
+#if defined(MSG_NOSIGNAL)
+        const auto val = ::send(fd_, data.data(), data.size(), MSG_NOSIGNAL);
+#else
+        const auto val = ::send(fd_, data.data(), data.size(), 0);
+#endif
+        if (val >= 0) {
+            return IoResult{.status = IoStatus::Done, .bytes = static_cast<std::size_t>(val)};
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return IoResult{.status = IoStatus::WouldBlock};
+        }
+        if (errno != EINTR) {
+            break;
+        }
+    }
+    return IoResult{.status = IoStatus::Failed};
+}
+
 void TcpSocket::set_non_blocking() {
     if (!is_open()) {
         return;
@@ -13,6 +13,11 @@ namespace {
 
 using FrameResult = std::variant<protocol::Event, protocol::DecodeError>;
 
+// Frames the consumer takes off the queue per visit: enough that a burst
+// releases the queue's slots once rather than frame by frame, few enough
+// that a producer facing a full queue sees room again promptly.
+constexpr std::size_t kConsumeBatch = 64;
+
 } // namespace
 
 UdpListenResult run_udp_listen(std::uint16_t port, const replay::ReplayOptions& options,
@@ -78,21 +83,29 @@ UdpListenResult run_udp_listen(std::uint16_t port, const replay::ReplayOptions&
         const auto token = stop_source.get_token();
         SequenceValidator validator;
 
-        while (true) {
-            auto item = queue.try_pop();
-            if (!item) {
+        // Frames are applied in place, a batch at a time (see
+        // SpscQueue::consume()). A stop-worthy error ends the run partway
+        // through a batch; the rest of it is released unapplied, as the
+        // frames still queued behind it always were.
+        bool stopped = false;
+        while (!stopped) {
+            const std::size_t drained = queue.consume(kConsumeBatch, [&](const FrameResult& item) {
+                if (stopped) {
+                    return;
+                }
+                if (listen_options.consumer_delay.count() > 0) {
+                    std::this_thread::sleep_for(listen_options.consumer_delay); // simulated slow consumer, see UdpListenOptions
+                }
+                if (replay::apply_frame_result(item, validator, options, result.outcome)) {
+                    stop_source.request_stop(); // stop-worthy error: tell the producer too
+                    stopped = true;
+                }
+            });
+            if (drained == 0) {
                 if (token.stop_requested()) {
                     break; // stop was requested and the queue is now empty: nothing more is coming
                 }
                 std::this_thread::yield();
-                continue;
-            }
-            if (listen_options.consumer_delay.count() > 0) {
-                std::this_thread::sleep_for(listen_options.consumer_delay); // simulated slow consumer, see UdpListenOptions
-            }
-            if (replay::apply_frame_result(*item, validator, options, result.outcome)) {
-                stop_source.request_stop(); // stop-worthy error: tell the producer too
-                break;
             }
         }
     });
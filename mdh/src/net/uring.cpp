@@ -0,0 +1,430 @@
+#include "net/uring.hpp"
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#endif
+
+// Headers older than Linux 6.0 lack multishot recv; build the stub then, the
+// same as off Linux, rather than a ring that could never open.
+#if defined(__linux__) && defined(IORING_RECV_MULTISHOT)
+#define MDH_NET_HAVE_URING 1
+#include <linux/time_types.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <cstring>
+#endif
+
+namespace mdh::net {
+
+#if defined(MDH_NET_HAVE_URING)
+
+namespace {
+
+// The wake eventfd read's user_data. Callers' are theirs to choose; the
+// gateway's are Connection pointers with a tag in the low bits, never this.
+constexpr std::uint64_t kWakeData = ~std::uint64_t{0};
+
+// The one provided buffer group every recv_multishot() draws from.
+constexpr std::uint16_t kBufferGroup = 0;
+
+int setup(unsigned entries, io_uring_params& params) {
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+}
+
+int enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags, void* arg, std::size_t arg_size) {
+    return static_cast<int>(::syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, arg, arg_size));
+}
+
+int register_op(int fd, unsigned opcode, void* arg, unsigned count) {
+    return static_cast<int>(::syscall(__NR_io_uring_register, fd, opcode, arg, count));
+}
+
+// The rings' head and tail indices are shared with the kernel, which
+// publishes and consumes with its own barriers; these are our half.
+std::uint32_t load_acquire(std::uint32_t* index) {
+    return std::atomic_ref<std::uint32_t>(*index).load(std::memory_order_acquire);
+}
+
+void store_release(std::uint32_t* index, std::uint32_t value) {
+    std::atomic_ref<std::uint32_t>(*index).store(value, std::memory_order_release);
+}
+
+void store_release(std::uint16_t* index, std::uint16_t value) {
+    std::atomic_ref<std::uint16_t>(*index).store(value, std::memory_order_release);
+}
+
+} // namespace
+
+struct Uring::State {
+    int ring_fd = -1;
+    int wake_fd = -1;
+    bool enabled = false; // set up disabled; the first submit_and_wait() enables it, which makes its thread the owner
+
+    // The submission and completion rings, mapped from the kernel. With
+    // IORING_FEAT_SINGLE_MMAP, which open() insists on, both live in the
+    // one mapping.
+    void* sq_map = nullptr;
+    std::size_t sq_map_size = 0;
+    io_uring_sqe* sqes = nullptr;
+    std::size_t sqes_size = 0;
+
+    std::uint32_t* sq_head = nullptr;
+    std::uint32_t* sq_tail = nullptr;
+    std::uint32_t sq_mask = 0;
+    std::uint32_t sq_entries = 0;
+    std::uint32_t sq_local_tail = 0; // queued here, not yet published to the kernel
+
+    std::uint32_t* cq_head = nullptr;
+    std::uint32_t* cq_tail = nullptr;
+    std::uint32_t cq_mask = 0;
+    io_uring_cqe* cqes = nullptr;
+
+    // The provided buffer ring: buffer_count descriptors the kernel takes
+    // recv buffers from, over one block of buffer_count * buffer_size bytes.
+    io_uring_buf_ring* buffer_ring = nullptr;
+    std::size_t buffer_ring_size = 0;
+    bool buffer_ring_registered = false;
+    std::uint16_t buffer_mask = 0;
+    std::uint16_t buffer_local_tail = 0;
+    std::size_t buffer_size = 0;
+    std::unique_ptr<std::byte[]> buffers;
+
+    std::uint64_t wake_value = 0; // the eventfd read's destination
+
+    io_uring_sqe* next_sqe(std::uint64_t& enters) {
+        if (sq_local_tail - load_acquire(sq_head) == sq_entries) {
+            flush(enters); // full: hand the kernel what is queued and reuse the slots it has consumed
+            if (sq_local_tail - load_acquire(sq_head) == sq_entries) {
+                return nullptr;
+            }
+        }
+        io_uring_sqe* sqe = &sqes[sq_local_tail & sq_mask];
+        std::memset(sqe, 0, sizeof(*sqe));
+        ++sq_local_tail;
+        return sqe;
+    }
+
+    // Publishes every queued entry and returns how many the kernel has yet
+    // to consume -- the to_submit of the next io_uring_enter().
+    unsigned publish() {
+        store_release(sq_tail, sq_local_tail);
+        return sq_local_tail - load_acquire(sq_head);
+    }
+
+    void enable() {
+        if (!enabled) {
+            (void)register_op(ring_fd, IORING_REGISTER_ENABLE_RINGS, nullptr, 0);
+            enabled = true;
+        }
+    }
+
+    void flush(std::uint64_t& enters) {
+        enable();
+        const unsigned pending = publish();
+        if (pending > 0) {
+            ++enters;
+            (void)enter(ring_fd, pending, 0, 0, nullptr, 0);
+        }
+    }
+
+    void queue_wake_read(std::uint64_t& enters) {
+        if (io_uring_sqe* sqe = next_sqe(enters)) {
+            sqe->opcode = IORING_OP_READ;
+            sqe->fd = wake_fd;
+            sqe->addr = reinterpret_cast<std::uintptr_t>(&wake_value);
+            sqe->len = sizeof(wake_value);
+            sqe->user_data = kWakeData;
+        }
+    }
+
+    void add_buffer(std::uint16_t id) {
+        // Not buffer_ring->bufs: the header declares it as a flexible array
+        // member, which C++ builds with an empty struct ahead of it and so
+        // puts 8 bytes in, where the kernel has it at 0.
+        io_uring_buf& slot = reinterpret_cast<io_uring_buf*>(buffer_ring)[buffer_local_tail & buffer_mask];
+        slot.addr = reinterpret_cast<std::uintptr_t>(buffers.get() + static_cast<std::size_t>(id) * buffer_size);
+        slot.len = static_cast<std::uint32_t>(buffer_size);
+        slot.bid = id;
+        ++buffer_local_tail;
+    }
+
+    bool open(unsigned entries, unsigned buffer_count, std::size_t size) {
+        // Single issuer lets the kernel skip locking the ring for
+        // submissions; cooperative task running skips an interrupt per
+        // completion, which is safe because the owner only ever looks for
+        // them from inside io_uring_enter(). Disabled until the owning
+        // thread's first submit, so that thread, not this one, owns it.
+        io_uring_params params{};
+        params.flags = IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_COOP_TASKRUN | IORING_SETUP_R_DISABLED;
+        ring_fd = setup(entries, params);
+        if (ring_fd < 0) {
+            return false; // pre-6.0 (unknown flag), io_uring disabled, or seccomp says no
+        }
+        if ((params.features & IORING_FEAT_SINGLE_MMAP) == 0 || (params.features & IORING_FEAT_EXT_ARG) == 0 ||
+            (params.features & IORING_FEAT_NODROP) == 0) {
+            return false;
+        }
+
+        sq_map_size = std::max(params.sq_off.array + params.sq_entries * sizeof(std::uint32_t),
+                               params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+        sq_map = ::mmap(nullptr, sq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd,
+                        IORING_OFF_SQ_RING);
+        if (sq_map == MAP_FAILED) {
+            sq_map = nullptr;
+            return false;
+        }
+        sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqe_map =
+            ::mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+        if (sqe_map == MAP_FAILED) {
+            return false;
+        }
+        sqes = static_cast<io_uring_sqe*>(sqe_map);
+
+        auto* base = static_cast<std::byte*>(sq_map);
+        sq_head = reinterpret_cast<std::uint32_t*>(base + params.sq_off.head);
+        sq_tail = reinterpret_cast<std::uint32_t*>(base + params.sq_off.tail);
+        sq_mask = *reinterpret_cast<std::uint32_t*>(base + params.sq_off.ring_mask);
+        sq_entries = *reinterpret_cast<std::uint32_t*>(base + params.sq_off.ring_entries);
+        sq_local_tail = *sq_tail;
+        // The indirection array maps ring slots to sqes; identity, once.
+        auto* array = reinterpret_cast<std::uint32_t*>(base + params.sq_off.array);
+        for (std::uint32_t i = 0; i < sq_entries; ++i) {
+            array[i] = i;
+        }
+        cq_head = reinterpret_cast<std::uint32_t*>(base + params.cq_off.head);
+        cq_tail = reinterpret_cast<std::uint32_t*>(base + params.cq_off.tail);
+        cq_mask = *reinterpret_cast<std::uint32_t*>(base + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(base + params.cq_off.cqes);
+
+        if (buffer_count == 0 || buffer_count > 32768 || (buffer_count & (buffer_count - 1)) != 0 || size == 0) {
+            return false;
+        }
+        buffer_ring_size = buffer_count * sizeof(io_uring_buf);
+        void* ring_memory =
+            ::mmap(nullptr, buffer_ring_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (ring_memory == MAP_FAILED) {
+            return false;
+        }
+        buffer_ring = static_cast<io_uring_buf_ring*>(ring_memory);
+        buffer_mask = static_cast<std::uint16_t>(buffer_count - 1);
+        buffer_size = size;
+        buffers = std::make_unique<std::byte[]>(buffer_count * size);
+        // Filled before it is registered: the kernel pins these pages as it
+        // registers them, and a page not yet written could be pinned as the
+        // shared zero page, leaving every later write here unseen.
+        for (unsigned id = 0; id < buffer_count; ++id) {
+            add_buffer(static_cast<std::uint16_t>(id));
+        }
+        store_release(&buffer_ring->tail, buffer_local_tail);
+        io_uring_buf_reg reg{};
+        reg.ring_addr = reinterpret_cast<std::uintptr_t>(buffer_ring);
+        reg.ring_entries = buffer_count;
+        reg.bgid = kBufferGroup;
+        if (register_op(ring_fd, IORING_REGISTER_PBUF_RING, &reg, 1) != 0) {
+            return false;
+        }
+        buffer_ring_registered = true;
+
+        // Blocking, unlike Poller's: io_uring answers a read of a
+        // non-blocking file with -EAGAIN rather than waiting on it.
+        wake_fd = ::eventfd(0, EFD_CLOEXEC);
+        return wake_fd >= 0;
+    }
+
+    ~State() {
+        if (buffer_ring_registered) {
+            io_uring_buf_reg reg{};
+            reg.bgid = kBufferGroup;
+            (void)register_op(ring_fd, IORING_UNREGISTER_PBUF_RING, &reg, 1);
+        }
+        if (sqes != nullptr) {
+            ::munmap(sqes, sqes_size);
+        }
+        if (sq_map != nullptr) {
+            ::munmap(sq_map, sq_map_size);
+        }
+        if (ring_fd >= 0) {
+            ::close(ring_fd);
+        }
+        if (buffer_ring != nullptr) {
+            ::munmap(buffer_ring, buffer_ring_size);
+        }
+        if (wake_fd >= 0) {
+            ::close(wake_fd);
+        }
+    }
+};
+
+bool UringCompletion::more() const { return (flags & IORING_CQE_F_MORE) != 0; }
+
+std::optional<std::uint16_t> UringCompletion::buffer() const {
+    if ((flags & IORING_CQE_F_BUFFER) == 0) {
+        return std::nullopt;
+    }
+    return static_cast<std::uint16_t>(flags >> IORING_CQE_BUFFER_SHIFT);
+}
+
+Uring::Uring(unsigned entries, unsigned buffer_count, std::size_t buffer_size) : state_(std::make_unique<State>()) {
+    if (!state_->open(entries, buffer_count, buffer_size)) {
+        state_.reset();
+        return;
+    }
+    state_->queue_wake_read(enters_);
+}
+
+Uring::~Uring() = default;
+
+bool Uring::is_open() const { return state_ != nullptr; }
+
+bool Uring::accept_multishot(int listen_fd, std::uint64_t user_data) {
+    io_uring_sqe* sqe = state_ ? state_->next_sqe(enters_) : nullptr;
+    if (sqe == nullptr) {
+        return false;
+    }
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = listen_fd;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_CLOEXEC;
+    sqe->user_data = user_data;
+    return true;
+}
+
+bool Uring::recv_multishot(int fd, std::uint64_t user_data) {
+    io_uring_sqe* sqe = state_ ? state_->next_sqe(enters_) : nullptr;
+    if (sqe == nullptr) {
+        return false;
+    }
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = kBufferGroup;
+    sqe->user_data = user_data;
+    return true;
+}
+
+bool Uring::send(int fd, std::span<const std::byte> data, std::uint64_t user_data) {
+    io_uring_sqe* sqe = state_ ? state_->next_sqe(enters_) : nullptr;
+    if (sqe == nullptr) {
+        return false;
+    }
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<std::uintptr_t>(data.data());
+    sqe->len = static_cast<std::uint32_t>(data.size());
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = user_data;
+    return true;
+}
+
+void Uring::submit_and_wait(std::chrono::milliseconds timeout) {
+    if (!state_) {
+        return;
+    }
+    State& state = *state_;
+    state.enable();
+    const unsigned pending = state.publish();
+    // Completions already waiting need no waiting for, and with nothing to
+    // submit either, no system call at all.
+    const bool ready = load_acquire(state.cq_tail) != *state.cq_head;
+    if (ready || timeout.count() == 0) {
+        if (pending > 0) {
+            ++enters_;
+            (void)enter(state.ring_fd, pending, 0, 0, nullptr, 0);
+        }
+        return;
+    }
+
+    __kernel_timespec ts{};
+    io_uring_getevents_arg arg{};
+    arg.sigmask_sz = _NSIG / 8;
+    unsigned flags = IORING_ENTER_GETEVENTS;
+    if (timeout.count() > 0) {
+        ts.tv_sec = timeout.count() / 1000;
+        ts.tv_nsec = (timeout.count() % 1000) * 1'000'000;
+        arg.ts = reinterpret_cast<std::uintptr_t>(&ts);
+        flags |= IORING_ENTER_EXT_ARG;
+    }
+    ++enters_;
+    // -ETIME on timeout and -EINTR on a signal both just return; a caller
+    // loops on this anyway.
+    if ((flags & IORING_ENTER_EXT_ARG) != 0) {
+        (void)enter(state.ring_fd, pending, 1, flags, &arg, sizeof(arg));
+    } else {
+        (void)enter(state.ring_fd, pending, 1, flags, nullptr, 0);
+    }
+}
+
+bool Uring::next_completion(UringCompletion& out) {
+    if (!state_) {
+        return false;
+    }
+    State& state = *state_;
+    const std::uint32_t head = *state.cq_head; // only this thread moves it
+    if (head == load_acquire(state.cq_tail)) {
+        return false;
+    }
+    const io_uring_cqe& cqe = state.cqes[head & state.cq_mask];
+    out = UringCompletion{.user_data = cqe.user_data, .res = cqe.res, .flags = cqe.flags};
+    store_release(state.cq_head, head + 1);
+    return true;
+}
+
+bool Uring::is_wake(const UringCompletion& completion) {
+    if (completion.user_data != kWakeData) {
+        return false;
+    }
+    state_->queue_wake_read(enters_); // consumed the count; listen for the next wake()
+    return true;
+}
+
+std::span<const std::byte> Uring::buffer(std::uint16_t id, std::size_t length) const {
+    return {state_->buffers.get() + static_cast<std::size_t>(id) * state_->buffer_size, length};
+}
+
+void Uring::recycle(std::uint16_t id) {
+    if (!state_) {
+        return;
+    }
+    state_->add_buffer(id);
+    store_release(&state_->buffer_ring->tail, state_->buffer_local_tail);
+}
+
+void Uring::wake() {
+    if (state_) {
+        const std::uint64_t one = 1;
+        (void)::write(state_->wake_fd, &one, sizeof(one));
+    }
+}
+
+#else // no io_uring: is_open() is false and every call below fails.
+
+struct Uring::State {};
+
+bool UringCompletion::more() const { return false; }
+std::optional<std::uint16_t> UringCompletion::buffer() const { return std::nullopt; }
+
+Uring::Uring(unsigned, unsigned, std::size_t) {}
+Uring::~Uring() = default;
+bool Uring::is_open() const { return false; }
+bool Uring::accept_multishot(int, std::uint64_t) { return false; }
+bool Uring::recv_multishot(int, std::uint64_t) { return false; }
+bool Uring::send(int, std::span<const std::byte>, std::uint64_t) { return false; }
+void Uring::submit_and_wait(std::chrono::milliseconds) {}
+bool Uring::next_completion(UringCompletion&) { return false; }
+bool Uring::is_wake(const UringCompletion&) { return false; }
+std::span<const std::byte> Uring::buffer(std::uint16_t, std::size_t) const { return {}; }
+void Uring::recycle(std::uint16_t) {}
+void Uring::wake() {}
+
+#endif
+
+} // namespace mdh::net
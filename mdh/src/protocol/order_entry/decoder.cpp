@@ -11,6 +11,8 @@ namespace {
         case static_cast<std::uint8_t>(MessageType::NewOrder):
         case static_cast<std::uint8_t>(MessageType::CancelOrder):
         case static_cast<std::uint8_t>(MessageType::ReplaceOrder):
+        case static_cast<std::uint8_t>(MessageType::MassQuote):
+        case static_cast<std::uint8_t>(MessageType::MassCancel):
         case static_cast<std::uint8_t>(MessageType::Accepted):
         case static_cast<std::uint8_t>(MessageType::Rejected):
         case static_cast<std::uint8_t>(MessageType::Cancelled):
@@ -29,6 +31,7 @@ namespace {
 [[nodiscard]] bool is_valid_order_type(std::uint8_t raw) {
     switch (static_cast<exchange::OrderType>(raw)) {
         case exchange::OrderType::Limit:
+        case exchange::OrderType::StopLimit:
             return true;
     }
     return false;
@@ -39,6 +42,7 @@ namespace {
         case exchange::TimeInForce::GTC:
         case exchange::TimeInForce::IOC:
         case exchange::TimeInForce::FOK:
+        case exchange::TimeInForce::GTD:
             return true;
     }
     return false;
@@ -59,11 +63,29 @@ namespace {
         case exchange::RejectReason::InsufficientPosition:
         case exchange::RejectReason::OrderTooLarge:
         case exchange::RejectReason::AccountMismatch:
+        case exchange::RejectReason::InvalidQuote:
+        case exchange::RejectReason::InvalidExpiry:
+        case exchange::RejectReason::InvalidStopPrice:
+        case exchange::RejectReason::InvalidDuringCall:
             return true;
     }
     return false;
 }
 
+// Whether `payload_size` is one a frame of `type` can have: the fixed size,
+// or for a MassQuote, its prefix plus a whole number of entries, no more
+// than kMaxQuoteEntries of them.
+[[nodiscard]] bool is_valid_payload_size(MessageType type, std::size_t payload_size) {
+    if (type != MessageType::MassQuote) {
+        return payload_size == payload_size_for(type);
+    }
+    if (payload_size < MASS_QUOTE_PREFIX_SIZE) {
+        return false;
+    }
+    const std::size_t entry_bytes = payload_size - MASS_QUOTE_PREFIX_SIZE;
+    return entry_bytes % MASS_QUOTE_ENTRY_SIZE == 0 && entry_bytes / MASS_QUOTE_ENTRY_SIZE <= exchange::kMaxQuoteEntries;
+}
+
 } // namespace
 
 std::variant<Header, DecodeError> decode_header(std::span<const std::byte> data) {
@@ -95,8 +117,7 @@ std::variant<Message, DecodeError> decode_message(std::span<const std::byte> dat
     }
     const Header& header = std::get<Header>(header_result);
 
-    const std::size_t expected_payload = payload_size_for(header.type);
-    if (header.payload_size != expected_payload) {
+    if (!is_valid_payload_size(header.type, header.payload_size)) {
         return DecodeError::InvalidMessageSize;
     }
     if (data.size() < HEADER_SIZE + header.payload_size) {
@@ -115,8 +136,10 @@ std::variant<Message, DecodeError> decode_message(std::span<const std::byte> dat
             auto quantity = r.get_u64();
             auto order_type_raw = r.get_u8();
             auto tif_raw = r.get_u8();
+            auto expire_at = r.get_u64();
+            auto stop_price = r.get_i64();
             if (!account_id || !client_order_id || !instrument_id || !side_raw || !price || !quantity ||
-                !order_type_raw || !tif_raw) {
+                !order_type_raw || !tif_raw || !expire_at || !stop_price) {
                 return DecodeError::TruncatedPayload;
             }
             if (!is_valid_side(*side_raw)) {
@@ -137,6 +160,8 @@ std::variant<Message, DecodeError> decode_message(std::span<const std::byte> dat
                 .quantity = *quantity,
                 .order_type = static_cast<exchange::OrderType>(*order_type_raw),
                 .time_in_force = static_cast<exchange::TimeInForce>(*tif_raw),
+                .expire_at = *expire_at,
+                .stop_price = *stop_price,
             };
         }
         case MessageType::CancelOrder: {
@@ -172,6 +197,61 @@ std::variant<Message, DecodeError> decode_message(std::span<const std::byte> dat
                 .new_quantity = *new_quantity,
             };
         }
+        case MessageType::MassQuote: {
+            auto account_id = r.get_u64();
+            auto instrument_id = r.get_u32();
+            if (!account_id || !instrument_id) {
+                return DecodeError::TruncatedPayload;
+            }
+            MassQuote quote{
+                .account_id = *account_id,
+                .instrument_id = *instrument_id,
+                .entries = {},
+            };
+            const std::size_t count = (header.payload_size - MASS_QUOTE_PREFIX_SIZE) / MASS_QUOTE_ENTRY_SIZE;
+            quote.entries.reserve(count);
+            for (std::size_t i = 0; i < count; ++i) {
+                auto client_order_id = r.get_u64();
+                auto side_raw = r.get_u8();
+                auto price = r.get_i64();
+                auto quantity = r.get_u64();
+                if (!client_order_id || !side_raw || !price || !quantity) {
+                    return DecodeError::TruncatedPayload;
+                }
+                if (!is_valid_side(*side_raw)) {
+                    return DecodeError::InvalidSide;
+                }
+                quote.entries.push_back(MassQuoteEntry{
+                    .client_order_id = *client_order_id,
+                    .side = static_cast<Side>(*side_raw),
+                    .price = *price,
+                    .quantity = *quantity,
+                });
+            }
+            return quote;
+        }
+        case MessageType::MassCancel: {
+            auto account_id = r.get_u64();
+            auto flags = r.get_u8();
+            auto instrument_id = r.get_u32();
+            auto side_raw = r.get_u8();
+            if (!account_id || !flags || !instrument_id || !side_raw) {
+                return DecodeError::TruncatedPayload;
+            }
+            const bool has_instrument = (*flags & MASS_CANCEL_HAS_INSTRUMENT) != 0;
+            const bool has_side = (*flags & MASS_CANCEL_HAS_SIDE) != 0;
+            if ((*flags & ~(MASS_CANCEL_HAS_INSTRUMENT | MASS_CANCEL_HAS_SIDE)) != 0 ||
+                (!has_instrument && *instrument_id != 0) || (!has_side && *side_raw != 0)) {
+                return DecodeError::InvalidFlags;
+            }
+            if (has_side && !is_valid_side(*side_raw)) {
+                return DecodeError::InvalidSide;
+            }
+            MassCancel cancel{.account_id = *account_id, .instrument_id = std::nullopt, .side = std::nullopt};
+            if (has_instrument) cancel.instrument_id = *instrument_id;
+            if (has_side) cancel.side = static_cast<Side>(*side_raw);
+            return cancel;
+        }
         case MessageType::Accepted: {
             auto account_id = r.get_u64();
             auto client_order_id = r.get_u64();
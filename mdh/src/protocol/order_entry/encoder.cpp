@@ -45,6 +45,8 @@ void encode_message(const Message& message, std::vector<std::byte>& out) {
                 io::put_u64(out, msg.quantity);
                 put_order_type(out, msg.order_type);
                 put_time_in_force(out, msg.time_in_force);
+                io::put_u64(out, msg.expire_at);
+                io::put_i64(out, msg.stop_price);
             } else if constexpr (std::is_same_v<T, CancelOrder>) {
                 put_header(out, MessageType::CancelOrder,
                            static_cast<std::uint16_t>(payload_size_for(MessageType::CancelOrder)));
@@ -60,6 +62,27 @@ void encode_message(const Message& message, std::vector<std::byte>& out) {
                 io::put_u32(out, msg.instrument_id);
                 io::put_i64(out, msg.new_price);
                 io::put_u64(out, msg.new_quantity);
+            } else if constexpr (std::is_same_v<T, MassQuote>) {
+                put_header(out, MessageType::MassQuote,
+                           static_cast<std::uint16_t>(mass_quote_payload_size(msg.entries.size())));
+                io::put_u64(out, msg.account_id);
+                io::put_u32(out, msg.instrument_id);
+                for (const MassQuoteEntry& entry : msg.entries) {
+                    io::put_u64(out, entry.client_order_id);
+                    put_side(out, entry.side);
+                    io::put_i64(out, entry.price);
+                    io::put_u64(out, entry.quantity);
+                }
+            } else if constexpr (std::is_same_v<T, MassCancel>) {
+                put_header(out, MessageType::MassCancel,
+                           static_cast<std::uint16_t>(payload_size_for(MessageType::MassCancel)));
+                std::uint8_t flags = 0;
+                if (msg.instrument_id) flags |= MASS_CANCEL_HAS_INSTRUMENT;
+                if (msg.side) flags |= MASS_CANCEL_HAS_SIDE;
+                io::put_u64(out, msg.account_id);
+                io::put_u8(out, flags);
+                io::put_u32(out, msg.instrument_id.value_or(0));
+                io::put_u8(out, msg.side ? static_cast<std::uint8_t>(*msg.side) : 0);
             } else if constexpr (std::is_same_v<T, Accepted>) {
                 put_header(out, MessageType::Accepted,
                            static_cast<std::uint16_t>(payload_size_for(MessageType::Accepted)));
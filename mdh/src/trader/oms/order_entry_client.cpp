@@ -1,6 +1,5 @@
 #include "trader/oms/order_entry_client.hpp"
 
-#include <array>
 #include <span>
 #include <utility>
 #include <variant>
@@ -10,6 +9,13 @@
 
 namespace mdh::trader::oms {
 
+namespace {
+
+// Bytes asked of one read(), straight into read_buffer_.
+constexpr std::size_t kReadChunk = 4096;
+
+} // namespace
+
 OrderEntryClient::OrderEntryClient(MessageSink sink) : sink_(std::move(sink)) {}
 
 OrderEntryClient::~OrderEntryClient() { disconnect(); }
@@ -49,34 +55,22 @@ void OrderEntryClient::disconnect() {
 void OrderEntryClient::reader_loop() {
     using namespace protocol::order_entry;
 
-    std::array<std::byte, 4096> chunk{};
     while (true) {
-        auto n = socket_.read(chunk);
+        auto n = socket_.read(read_buffer_.writable(kReadChunk));
         if (!n || *n == 0) {
             break; // error, peer EOF, or shutdown() from disconnect() -- this session is done either way
         }
-        read_buffer_.insert(read_buffer_.end(), chunk.begin(), chunk.begin() + static_cast<std::ptrdiff_t>(*n));
+        read_buffer_.commit(*n);
 
-        while (true) {
-            auto header_result = decode_header(read_buffer_);
-            const auto* header = std::get_if<Header>(&header_result);
-            if (!header) {
-                break; // not enough bytes yet for a header, or a malformed type byte -- wait for more data either way
-            }
-            const std::size_t frame_size = HEADER_SIZE + header->payload_size;
-            if (read_buffer_.size() < frame_size) {
-                break; // header decoded, but the full payload hasn't arrived yet
-            }
-
-            auto message_result = decode_message(std::span(read_buffer_).first(frame_size));
-            read_buffer_.erase(read_buffer_.begin(), read_buffer_.begin() + static_cast<std::ptrdiff_t>(frame_size));
-            if (const auto* message = std::get_if<Message>(&message_result)) {
+        // A malformed payload under an otherwise well-formed header drops
+        // just this one frame and keeps reading -- same policy as the
+        // gateway's own handle_input().
+        auto on_frame = [this](std::variant<Message, DecodeError>&& result) {
+            if (const auto* message = std::get_if<Message>(&result)) {
                 sink_(*message);
             }
-            // A malformed payload under an otherwise well-formed header
-            // drops just this one frame and keeps reading -- same policy as
-            // the gateway's own connection_reader_loop().
-        }
+        };
+        read_buffer_.consume(decode_frames(read_buffer_.readable(), on_frame));
     }
     connected_.store(false, std::memory_order_relaxed);
 }
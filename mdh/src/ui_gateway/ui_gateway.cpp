@@ -321,6 +321,7 @@ void UiGateway::broadcast_book(InstrumentId instrument_id) {
 }
 
 void UiGateway::market_data_loop(std::stop_token token, net::UdpReceiver receiver) {
+    place_current_thread("mdh-md-recv", options_.market_data_placement);
     SequenceValidator validator;
     const replay::ReplayOptions options{};
 
@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "exchange/persistence/background_snapshotter.hpp"
+#include "exchange/persistence/state_hash.hpp"
+#include "exchange/testing/matching_scenarios.hpp"
+
+using namespace mdh;
+using namespace mdh::exchange;
+using namespace mdh::exchange::persistence;
+
+namespace {
+
+namespace mt = mdh::exchange::testing;
+
+// Rests one order on each of `instruments`, at a price that differs per
+// call so that every round really changes every book it touches.
+void rest_one_each(MatchingEngine& engine, mt::SequentialIds& ids, const std::vector<InstrumentId>& instruments,
+                   Price price) {
+    for (const InstrumentId instrument_id : instruments) {
+        engine.process(ExchangeCommand{mt::new_order(ids.take_command_sequence(), /*account_id=*/1,
+                                                     ids.take_client_order_id(), instrument_id, Side::Buy, price,
+                                                     /*quantity=*/1)},
+                       mt::discard_events());
+    }
+}
+
+} // namespace
+
+// Every image the snapshot thread produces is the engine's state at the
+// capture that produced it: recorded by hash on the engine side at capture
+// time, compared on the snapshot side when the image arrives.
+TEST(BackgroundSnapshotter, EachImageIsTheEngineStateAtItsCapture) {
+    MatchingEngine engine(mt::instrument_universe(6));
+    mt::SequentialIds ids;
+
+    std::mutex mutex;
+    std::map<std::uint64_t, std::uint64_t> image_hashes; // epoch -> hash
+    BackgroundSnapshotter snapshotter(BackgroundSnapshotterOptions{
+        .on_snapshot =
+            [&](const EngineStateSnapshot& image, const EngineStateChanges& changes) {
+                std::lock_guard<std::mutex> lock(mutex);
+                image_hashes[changes.epoch] = hash_state_snapshot(image);
+            },
+    });
+
+    std::vector<std::uint64_t> expected_hashes;
+    for (Price round = 1; round <= 40; ++round) {
+        // A different subset of books each round: 1, 2 or 3 of them.
+        std::vector<InstrumentId> touched;
+        for (InstrumentId instrument_id = 1; instrument_id <= 6; ++instrument_id) {
+            if ((instrument_id + static_cast<InstrumentId>(round)) % 3 == 0) {
+                touched.push_back(instrument_id);
+            }
+        }
+        rest_one_each(engine, ids, touched, 100 + round);
+        ASSERT_TRUE(snapshotter.capture(engine));
+        expected_hashes.push_back(hash_state_snapshot(engine.snapshot()));
+    }
+    snapshotter.stop();
+
+    EXPECT_EQ(snapshotter.snapshots_applied(), expected_hashes.size());
+    EXPECT_EQ(snapshotter.captures_declined(), 0u);
+    ASSERT_EQ(image_hashes.size(), expected_hashes.size());
+    for (std::size_t i = 0; i < expected_hashes.size(); ++i) {
+        EXPECT_EQ(image_hashes[i + 1], expected_hashes[i]) << "epoch " << i + 1;
+    }
+    EXPECT_EQ(snapshotter.image(), engine.snapshot());
+}
+
+TEST(BackgroundSnapshotter, ACaptureWithNothingChangedQueuesNothing) {
+    MatchingEngine engine{1};
+    BackgroundSnapshotter snapshotter;
+    EXPECT_TRUE(snapshotter.capture(engine));
+    EXPECT_TRUE(snapshotter.capture(engine));
+    snapshotter.stop();
+    EXPECT_EQ(snapshotter.snapshots_applied(), 0u);
+    EXPECT_TRUE(snapshotter.image().instruments.empty());
+}
+
+// A writer that falls behind must not lose changes: a declined capture
+// leaves them with the engine, and the next capture that fits carries them.
+TEST(BackgroundSnapshotter, AFullQueueDeclinesAndKeepsTheChangesForLater) {
+    MatchingEngine engine(mt::instrument_universe(3));
+    mt::SequentialIds ids;
+
+    std::atomic<bool> release{false};
+    BackgroundSnapshotter snapshotter(BackgroundSnapshotterOptions{
+        .queue_capacity = 1,
+        .on_snapshot =
+            [&](const EngineStateSnapshot&, const EngineStateChanges&) {
+                while (!release.load(std::memory_order_acquire)) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            },
+    });
+
+    // The first capture is popped and blocks in on_snapshot; keep capturing
+    // until one is declined, which means the queue behind it is full.
+    rest_one_each(engine, ids, {1}, 100);
+    ASSERT_TRUE(snapshotter.capture(engine));
+    bool declined = false;
+    for (Price price = 101; price < 10'000 && !declined; ++price) {
+        rest_one_each(engine, ids, {2}, price);
+        declined = !snapshotter.capture(engine);
+    }
+    ASSERT_TRUE(declined);
+    EXPECT_GE(snapshotter.captures_declined(), 1u);
+    EXPECT_TRUE(engine.has_snapshot_changes()) << "a declined capture must leave the changes with the engine";
+
+    rest_one_each(engine, ids, {3}, 100);
+    release.store(true, std::memory_order_release);
+    while (!snapshotter.capture(engine)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    snapshotter.stop();
+
+    EXPECT_EQ(snapshotter.image(), engine.snapshot());
+    EXPECT_EQ(snapshotter.image().instruments.size(), 3u);
+}
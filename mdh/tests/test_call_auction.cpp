@@ -0,0 +1,340 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <variant>
+#include <vector>
+
+#include "exchange/matching/matching_book.hpp"
+#include "exchange/matching/matching_engine.hpp"
+#include "exchange/persistence/command_decoder.hpp"
+#include "exchange/persistence/command_encoder.hpp"
+#include "exchange/persistence/state_hash.hpp"
+#include "exchange/risk/risk_gated_engine.hpp"
+#include "exchange/testing/matching_scenarios.hpp"
+
+namespace mdh::exchange {
+namespace {
+
+using testing::CollectingSink;
+using testing::new_order;
+using testing::stop_limit_order;
+
+constexpr InstrumentId kFirst = 1;
+constexpr InstrumentId kSecond = 2;
+constexpr AccountId kBuyer = 100;
+constexpr AccountId kSeller = 200;
+
+TradingPhaseCommand phase(CommandSequence seq, TradingPhase to, InstrumentId instrument = kFirst) {
+    return TradingPhaseCommand{.command_sequence = seq, .instrument_id = instrument, .phase = to};
+}
+
+BookOrder book_order(ExchangeOrderId id, Side side, Price price, Quantity qty) {
+    return BookOrder{
+        .exchange_order_id = id,
+        .client_order_id = id,
+        .account_id = 1,
+        .price = price,
+        .remaining_quantity = qty,
+        .side = side,
+        .time_in_force = TimeInForce::GTC,
+    };
+}
+
+[[nodiscard]] std::optional<OrderRejected> rejection(const CollectingSink& out) {
+    for (const auto& ev : out.events) {
+        if (const auto* rejected = std::get_if<OrderRejected>(&ev)) {
+            return *rejected;
+        }
+    }
+    return std::nullopt;
+}
+
+// The book the uncross tests share. At 99 four sell and sixteen buy; at 100
+// ten and sixteen; at 101 thirteen and eleven; at 102 thirteen and five. So
+// 101 trades the most, eleven, and leaves two sellers over.
+//
+//   bids  102 x 5 (1)   101 x 6 (2)   100 x 5 (3)
+//   asks   99 x 4 (1)   100 x 6 (2)   101 x 3 (3)
+void seed_crossed(MatchingEngine& engine, CommandSequence& seq, CollectingSink& out) {
+    engine.process(phase(++seq, TradingPhase::Call), out.sink());
+    engine.process(new_order(++seq, kBuyer, 1, kFirst, Side::Buy, 102, 5), out.sink());
+    engine.process(new_order(++seq, kBuyer, 2, kFirst, Side::Buy, 101, 6), out.sink());
+    engine.process(new_order(++seq, kBuyer, 3, kFirst, Side::Buy, 100, 5), out.sink());
+    engine.process(new_order(++seq, kSeller, 1, kFirst, Side::Sell, 99, 4), out.sink());
+    engine.process(new_order(++seq, kSeller, 2, kFirst, Side::Sell, 100, 6), out.sink());
+    engine.process(new_order(++seq, kSeller, 3, kFirst, Side::Sell, 101, 3), out.sink());
+}
+
+TEST(CallAuction, OrdersThatCrossRestWithoutTradingDuringACall) {
+    MatchingEngine engine{kFirst};
+    CommandSequence seq = 0;
+    CollectingSink out;
+    seed_crossed(engine, seq, out);
+
+    EXPECT_EQ(out.count<TradeExecuted>(), 0u);
+    EXPECT_EQ(out.count<BookOrderAdded>(), 6u);
+    const EngineStateSnapshot snapshot = engine.snapshot();
+    ASSERT_EQ(snapshot.instruments.size(), 1u);
+    EXPECT_EQ(snapshot.instruments[0].phase, TradingPhase::Call);
+    EXPECT_EQ(snapshot.instruments[0].bids.front().price, 102);
+    EXPECT_EQ(snapshot.instruments[0].asks.front().price, 99);
+}
+
+TEST(CallAuction, ImmediateOrdersAreRejectedDuringACall) {
+    MatchingEngine engine{kFirst};
+    CollectingSink setup;
+    engine.process(new_order(1, kSeller, 1, kFirst, Side::Sell, 100, 5), setup.sink());
+    engine.process(phase(2, TradingPhase::Call), setup.sink());
+
+    for (const TimeInForce tif : {TimeInForce::IOC, TimeInForce::FOK}) {
+        CollectingSink out;
+        engine.process(new_order(3, kBuyer, 1, kFirst, Side::Buy, 100, 5, tif), out.sink());
+        ASSERT_EQ(out.events.size(), 1u);
+        ASSERT_TRUE(rejection(out).has_value());
+        EXPECT_EQ(rejection(out)->reason, RejectReason::InvalidDuringCall);
+    }
+
+    // The same order back in continuous trading fills as usual.
+    engine.process(phase(4, TradingPhase::Continuous), setup.sink());
+    CollectingSink out;
+    engine.process(new_order(5, kBuyer, 1, kFirst, Side::Buy, 100, 5, TimeInForce::IOC), out.sink());
+    EXPECT_EQ(out.count<TradeExecuted>(), 1u);
+}
+
+TEST(CallAuction, APhaseCommandForAnUnknownInstrumentOrTheCurrentPhaseChangesNothing) {
+    MatchingEngine engine{kFirst};
+    CollectingSink unknown;
+    engine.process(phase(1, TradingPhase::Call, kSecond), unknown.sink());
+    ASSERT_TRUE(rejection(unknown).has_value());
+    EXPECT_EQ(rejection(unknown)->reason, RejectReason::InvalidInstrument);
+    EXPECT_EQ(rejection(unknown)->account_id, 0u);
+    EXPECT_EQ(rejection(unknown)->client_order_id, 0u);
+
+    CollectingSink same;
+    engine.process(phase(2, TradingPhase::Continuous), same.sink());
+    EXPECT_TRUE(same.events.empty());
+    EXPECT_FALSE(engine.has_snapshot_changes());
+}
+
+TEST(CallAuction, UncrossingFillsEveryMatchedOrderAtOnePriceInPriorityOrder) {
+    MatchingEngine engine{kFirst};
+    CommandSequence seq = 0;
+    CollectingSink setup;
+    seed_crossed(engine, seq, setup);
+
+    CollectingSink out;
+    engine.process(phase(++seq, TradingPhase::Continuous), out.sink());
+    const std::vector<TradeExecuted> trades = out.of<TradeExecuted>();
+    ASSERT_EQ(trades.size(), 4u);
+    std::vector<Quantity> quantities;
+    for (const TradeExecuted& trade : trades) {
+        EXPECT_EQ(trade.price, 101);
+        EXPECT_EQ(trade.command_sequence, seq);
+        EXPECT_EQ(trade.aggressor_side, Side::Sell); // sellers left over
+        quantities.push_back(trade.quantity);
+    }
+    EXPECT_EQ(quantities, (std::vector<Quantity>{4, 1, 5, 1}));
+    // Highest bid against lowest ask first, and time priority within them.
+    EXPECT_EQ(trades[0].buyer.client_order_id, 1u);
+    EXPECT_EQ(trades[0].seller.client_order_id, 1u);
+    EXPECT_EQ(trades[1].buyer.remaining_quantity, 0u);
+    EXPECT_EQ(trades[2].buyer.client_order_id, 2u);
+    EXPECT_EQ(trades[2].seller.remaining_quantity, 0u);
+    // The marginal ask trades one of its three and keeps its place.
+    EXPECT_EQ(trades[3].seller.client_order_id, 3u);
+    EXPECT_EQ(trades[3].seller.remaining_quantity, 2u);
+    EXPECT_EQ(out.count<BookOrderRemoved>(), 4u);
+    EXPECT_EQ(out.count<BookOrderReduced>(), 4u);
+
+    const EngineStateSnapshot snapshot = engine.snapshot();
+    ASSERT_EQ(snapshot.instruments.size(), 1u);
+    const InstrumentBookSnapshot& book = snapshot.instruments[0];
+    EXPECT_EQ(book.phase, TradingPhase::Continuous);
+    ASSERT_EQ(book.bids.size(), 1u);
+    ASSERT_EQ(book.asks.size(), 1u);
+    EXPECT_EQ(book.bids[0].price, 100);
+    EXPECT_EQ(book.asks[0].price, 101);
+    EXPECT_EQ(book.asks[0].remaining_quantity, 2u);
+    EXPECT_EQ(engine.state_hash(), persistence::rolling_state_hash(snapshot));
+}
+
+TEST(CallAuction, TheUncrossReleasesTheStopsItsPriceReaches) {
+    MatchingEngine engine{kFirst};
+    CommandSequence seq = 0;
+    CollectingSink setup;
+    seed_crossed(engine, seq, setup);
+    engine.process(stop_limit_order(++seq, kBuyer, 4, kFirst, Side::Buy, /*stop_price=*/101, 101, 2), setup.sink());
+    ASSERT_EQ(engine.pending_stops(), 1u);
+
+    CollectingSink out;
+    engine.process(phase(++seq, TradingPhase::Continuous), out.sink());
+    EXPECT_EQ(engine.pending_stops(), 0u);
+    // Released into a continuous book, the stop takes the two the marginal
+    // ask had left, at its price.
+    const std::vector<TradeExecuted> trades = out.of<TradeExecuted>();
+    ASSERT_EQ(trades.size(), 5u);
+    EXPECT_EQ(trades.back().buyer.client_order_id, 4u);
+    EXPECT_EQ(trades.back().quantity, 2u);
+    EXPECT_EQ(trades.back().price, 101);
+    EXPECT_EQ(trades.back().aggressor_side, Side::Buy);
+}
+
+TEST(CallAuction, EquilibriumPrefersVolumeThenBalance) {
+    MatchingBook book;
+    EXPECT_EQ(book.equilibrium(std::nullopt), std::nullopt);
+    book.add(book_order(1, Side::Buy, 100, 5));
+    book.add(book_order(2, Side::Sell, 101, 5));
+    EXPECT_EQ(book.equilibrium(std::nullopt), std::nullopt); // not crossed
+
+    // The uncross tests' book, straight onto a MatchingBook.
+    MatchingBook crossed;
+    crossed.add(book_order(1, Side::Buy, 102, 5));
+    crossed.add(book_order(2, Side::Buy, 101, 6));
+    crossed.add(book_order(3, Side::Buy, 100, 5));
+    crossed.add(book_order(4, Side::Sell, 99, 4));
+    crossed.add(book_order(5, Side::Sell, 100, 6));
+    crossed.add(book_order(6, Side::Sell, 101, 3));
+    EXPECT_EQ(crossed.equilibrium(std::nullopt), (Equilibrium{.price = 101, .volume = 11, .imbalance = -2}));
+
+    // At 100 and 101 alike, ten trade; 101 leaves three over, 100 four.
+    MatchingBook balance;
+    balance.add(book_order(1, Side::Buy, 101, 10));
+    balance.add(book_order(2, Side::Buy, 100, 4));
+    balance.add(book_order(3, Side::Sell, 100, 10));
+    balance.add(book_order(4, Side::Sell, 101, 3));
+    EXPECT_EQ(balance.equilibrium(std::nullopt), (Equilibrium{.price = 101, .volume = 10, .imbalance = -3}));
+}
+
+TEST(CallAuction, EquilibriumTiesBreakOnPressureThenOnTheReferencePrice) {
+    // Buyers over at every price that trades the most: the highest.
+    MatchingBook buyers;
+    buyers.add(book_order(1, Side::Buy, 103, 8));
+    buyers.add(book_order(2, Side::Sell, 100, 5));
+    EXPECT_EQ(buyers.equilibrium(std::nullopt), (Equilibrium{.price = 103, .volume = 5, .imbalance = 3}));
+
+    // Sellers over at every one: the lowest.
+    MatchingBook sellers;
+    sellers.add(book_order(1, Side::Buy, 103, 5));
+    sellers.add(book_order(2, Side::Sell, 100, 8));
+    EXPECT_EQ(sellers.equilibrium(std::nullopt), (Equilibrium{.price = 100, .volume = 5, .imbalance = -3}));
+
+    // Balanced at both: nearest the reference, or the midpoint without one,
+    // the lower price when two are as near.
+    MatchingBook balanced;
+    balanced.add(book_order(1, Side::Buy, 103, 5));
+    balanced.add(book_order(2, Side::Sell, 100, 5));
+    EXPECT_EQ(balanced.equilibrium(110)->price, 103);
+    EXPECT_EQ(balanced.equilibrium(90)->price, 100);
+    EXPECT_EQ(balanced.equilibrium(102)->price, 103);
+    EXPECT_EQ(balanced.equilibrium(std::nullopt)->price, 100); // midpoint 101
+
+    MatchingBook even;
+    even.add(book_order(1, Side::Buy, 102, 5));
+    even.add(book_order(2, Side::Sell, 100, 5));
+    EXPECT_EQ(even.equilibrium(101)->price, 100);
+    EXPECT_EQ(even.equilibrium(std::nullopt)->price, 100);
+}
+
+TEST(CallAuction, ThePhaseIsPartOfTheSnapshotAndItsChanges) {
+    MatchingEngine engine{kFirst, kSecond};
+    CollectingSink out;
+    (void)engine.snapshot_changes();
+    const std::uint64_t continuous_hash = persistence::hash_state_snapshot(engine.snapshot());
+
+    // An empty book in call is still reported: its phase is state.
+    engine.process(phase(1, TradingPhase::Call), out.sink());
+    const EngineStateChanges changes = engine.snapshot_changes();
+    ASSERT_EQ(changes.books.size(), 1u);
+    EXPECT_EQ(changes.books[0].phase, TradingPhase::Call);
+    const EngineStateSnapshot snapshot = engine.snapshot();
+    ASSERT_EQ(snapshot.instruments.size(), 1u);
+    EXPECT_EQ(snapshot.instruments[0], changes.books[0]);
+    EXPECT_NE(persistence::hash_state_snapshot(snapshot), continuous_hash);
+
+    EngineStateSnapshot rebuilt;
+    apply_changes(rebuilt, changes);
+    EXPECT_EQ(rebuilt, snapshot);
+
+    // And back again is how the change says "gone".
+    engine.process(phase(2, TradingPhase::Continuous), out.sink());
+    apply_changes(rebuilt, engine.snapshot_changes());
+    EXPECT_EQ(rebuilt, engine.snapshot());
+    EXPECT_TRUE(rebuilt.instruments.empty());
+}
+
+TEST(CallAuction, ReplayingTheJournalUncrossesTheSameWay) {
+    std::vector<ExchangeCommand> commands{
+        phase(1, TradingPhase::Call),
+        new_order(2, kBuyer, 1, kFirst, Side::Buy, 102, 5),
+        new_order(3, kSeller, 1, kFirst, Side::Sell, 99, 3),
+        new_order(4, kSeller, 2, kFirst, Side::Sell, 101, 4),
+        new_order(5, kBuyer, 2, kFirst, Side::Buy, 100, 2),
+        phase(6, TradingPhase::Continuous),
+        phase(7, TradingPhase::Call),
+        new_order(8, kSeller, 3, kFirst, Side::Sell, 100, 1),
+    };
+    std::vector<std::byte> journal;
+    for (const auto& command : commands) {
+        persistence::encode_command(command, journal);
+    }
+
+    MatchingEngine live{kFirst};
+    CollectingSink live_out;
+    for (const auto& command : commands) {
+        live.process(command, live_out.sink());
+    }
+
+    MatchingEngine replayed{kFirst};
+    CollectingSink replay_out;
+    std::size_t offset = 0;
+    while (offset < journal.size()) {
+        const auto header = persistence::decode_command_header(std::span(journal).subspan(offset));
+        ASSERT_TRUE(std::holds_alternative<persistence::CommandHeader>(header));
+        const std::size_t frame_size = persistence::HEADER_SIZE + std::get<persistence::CommandHeader>(header).payload_size;
+        const auto frame = persistence::decode_journal_frame(std::span(journal).subspan(offset, frame_size));
+        const auto* command = std::get_if<ExchangeCommand>(&frame);
+        ASSERT_NE(command, nullptr);
+        replayed.process(*command, replay_out.sink());
+        offset += frame_size;
+    }
+
+    EXPECT_EQ(replay_out.events, live_out.events);
+    EXPECT_EQ(replayed.snapshot(), live.snapshot());
+    EXPECT_EQ(replayed.state_hash(), live.state_hash());
+    EXPECT_EQ(live_out.of<TradeExecuted>().size(), 2u);
+    EXPECT_EQ(live.snapshot().instruments[0].phase, TradingPhase::Call);
+}
+
+// A resting bid can trade below its own limit in an uncross, which
+// continuous matching never does to a resting order; the ledger releases its
+// hold at the limit and settles at the auction price.
+TEST(CallAuction, TheLedgerSettlesARestingBidAtTheAuctionPrice) {
+    MatchingEngine engine{kFirst};
+    ledger::Ledger ledger;
+    ledger.deposit_cash(kBuyer, 10'000);
+    ledger.deposit_position(kSeller, kFirst, 20);
+    risk::RiskGatedEngine gated(engine, ledger);
+
+    CollectingSink out;
+    gated.process(phase(1, TradingPhase::Call), out.sink());
+    gated.process(new_order(2, kBuyer, 1, kFirst, Side::Buy, 105, 10), out.sink());
+    gated.process(new_order(3, kSeller, 1, kFirst, Side::Sell, 95, 10), out.sink());
+    gated.process(new_order(4, kSeller, 2, kFirst, Side::Sell, 95, 10), out.sink());
+    ASSERT_EQ(out.count<OrderRejected>(), 0u);
+    EXPECT_EQ(ledger.available_cash(kBuyer), 10'000 - 1'050);
+
+    // Sellers are over at every price that trades ten, so the lowest.
+    gated.process(phase(5, TradingPhase::Continuous), out.sink());
+    const std::vector<TradeExecuted> trades = out.of<TradeExecuted>();
+    ASSERT_EQ(trades.size(), 1u);
+    EXPECT_EQ(trades[0].price, 95);
+    EXPECT_EQ(ledger.balances(kBuyer).cash_total, 10'000 - 950);
+    EXPECT_EQ(ledger.available_cash(kBuyer), 10'000 - 950);
+    EXPECT_EQ(ledger.balances(kSeller).cash_total, 950);
+    EXPECT_EQ(ledger.available_position(kSeller, kFirst), 0u);
+}
+
+} // namespace
+} // namespace mdh::exchange
@@ -134,6 +134,103 @@ TEST(CommandCodec, ReplaceOrderCommandRoundTrips) {
     EXPECT_EQ(std::get<ReplaceOrderCommand>(decoded), original);
 }
 
+TEST(CommandCodec, MassQuoteCommandRoundTrips) {
+    MassQuoteCommand original{
+        .command_sequence = 9,
+        .account_id = 100,
+        .instrument_id = 7,
+        .entries =
+            {
+                QuoteEntry{.client_order_id = 1, .side = Side::Buy, .price = 9900, .quantity = 4},
+                QuoteEntry{.client_order_id = 2, .side = Side::Sell, .price = -5, .quantity = 6},
+            },
+    };
+    std::vector<std::byte> bytes;
+    encode_command(ExchangeCommand{original}, bytes);
+    EXPECT_EQ(bytes.size(), HEADER_SIZE + mass_quote_payload_size(2));
+
+    ExchangeCommand decoded = decode_or_fail(bytes);
+    ASSERT_TRUE(std::holds_alternative<MassQuoteCommand>(decoded));
+    EXPECT_EQ(std::get<MassQuoteCommand>(decoded), original);
+
+    const MassQuoteCommand withdrawn{.command_sequence = 10, .account_id = 100, .instrument_id = 7, .entries = {}};
+    bytes.clear();
+    encode_command(ExchangeCommand{withdrawn}, bytes);
+    EXPECT_EQ(std::get<MassQuoteCommand>(decode_or_fail(bytes)), withdrawn);
+}
+
+// Each of the four filter combinations, so an absent field is shown to come
+// back absent rather than as a zero, with and without a batch limit and an
+// id bound.
+TEST(CommandCodec, MassCancelCommandRoundTripsWithAndWithoutFilters) {
+    for (const auto instrument : {std::optional<InstrumentId>{}, std::optional<InstrumentId>{7}}) {
+        for (const auto side : {std::optional<Side>{}, std::optional<Side>{Side::Sell}}) {
+            const MassCancelCommand original{.command_sequence = 11,
+                                             .account_id = 100,
+                                             .instrument_id = instrument,
+                                             .side = side,
+                                             .max_orders = instrument.has_value() ? 0U : 1024U,
+                                             .before_exchange_order_id = side.has_value() ? 0U : 0x0102030405060708U};
+            std::vector<std::byte> bytes;
+            encode_command(ExchangeCommand{original}, bytes);
+            EXPECT_EQ(bytes.size(), HEADER_SIZE + payload_size_for(CommandMessageType::MassCancel));
+
+            ExchangeCommand decoded = decode_or_fail(bytes);
+            ASSERT_TRUE(std::holds_alternative<MassCancelCommand>(decoded));
+            EXPECT_EQ(std::get<MassCancelCommand>(decoded), original);
+        }
+    }
+}
+
+TEST(CommandCodec, ClockTickAndGoodTillDateOrderRoundTrip) {
+    const ClockTickCommand tick{.command_sequence = 12, .now = 1'700'000'000'123'456'789ULL};
+    std::vector<std::byte> bytes;
+    encode_command(ExchangeCommand{tick}, bytes);
+    EXPECT_EQ(bytes.size(), HEADER_SIZE + payload_size_for(CommandMessageType::ClockTick));
+    EXPECT_EQ(std::get<ClockTickCommand>(decode_or_fail(bytes)), tick);
+
+    const NewOrderCommand day_order{.command_sequence = 13,
+                                    .account_id = 100,
+                                    .client_order_id = 7,
+                                    .instrument_id = 1,
+                                    .side = Side::Buy,
+                                    .price = 250000,
+                                    .quantity = 10,
+                                    .order_type = OrderType::Limit,
+                                    .time_in_force = TimeInForce::GTD,
+                                    .expire_at = 1'700'003'600'000'000'000ULL};
+    bytes.clear();
+    encode_command(ExchangeCommand{day_order}, bytes);
+    EXPECT_EQ(std::get<NewOrderCommand>(decode_or_fail(bytes)), day_order);
+}
+
+TEST(CommandCodec, StopLimitOrderRoundTrip) {
+    const NewOrderCommand stop{.command_sequence = 14,
+                               .account_id = 100,
+                               .client_order_id = 8,
+                               .instrument_id = 1,
+                               .side = Side::Sell,
+                               .price = 249000,
+                               .quantity = 10,
+                               .order_type = OrderType::StopLimit,
+                               .time_in_force = TimeInForce::GTC,
+                               .stop_price = 249500};
+    std::vector<std::byte> bytes;
+    encode_command(ExchangeCommand{stop}, bytes);
+    EXPECT_EQ(bytes.size(), HEADER_SIZE + payload_size_for(CommandMessageType::NewOrder));
+    EXPECT_EQ(std::get<NewOrderCommand>(decode_or_fail(bytes)), stop);
+}
+
+TEST(CommandCodec, TradingPhaseRoundTrip) {
+    for (const TradingPhase phase : {TradingPhase::Call, TradingPhase::Continuous}) {
+        const TradingPhaseCommand original{.command_sequence = 15, .instrument_id = 3, .phase = phase};
+        std::vector<std::byte> bytes;
+        encode_command(ExchangeCommand{original}, bytes);
+        EXPECT_EQ(bytes.size(), HEADER_SIZE + payload_size_for(CommandMessageType::TradingPhase));
+        EXPECT_EQ(std::get<TradingPhaseCommand>(decode_or_fail(bytes)), original);
+    }
+}
+
 TEST(CommandCodec, MultipleCommandsConcatenateCleanly) {
     std::vector<std::byte> bytes;
     encode_command(ExchangeCommand{NewOrderCommand{.command_sequence = 1,
@@ -84,14 +84,15 @@ TEST(CommandDecodeErrors, InvalidSideByteIsRejected) {
 
 TEST(CommandDecodeErrors, InvalidOrderTypeByteIsRejected) {
     auto bytes = valid_new_order_bytes();
-    // order_type is the second-to-last payload byte.
-    bytes[bytes.size() - 2] = std::byte{99}; // no OrderType enumerator has this value
+    // order_type comes just before time_in_force, the 8-byte expiry and the
+    // 8-byte stop price.
+    bytes[bytes.size() - 18] = std::byte{99}; // no OrderType enumerator has this value
     EXPECT_EQ(decode_expect_error(bytes), CommandDecodeError::InvalidOrderType);
 }
 
 TEST(CommandDecodeErrors, InvalidTimeInForceByteIsRejected) {
     auto bytes = valid_new_order_bytes();
-    bytes.back() = std::byte{99}; // no TimeInForce enumerator has this value
+    bytes[bytes.size() - 17] = std::byte{99}; // no TimeInForce enumerator has this value
     EXPECT_EQ(decode_expect_error(bytes), CommandDecodeError::InvalidTimeInForce);
 }
 
@@ -117,3 +118,52 @@ TEST(CommandDecodeErrors, TruncatedRegisterInstrumentPayloadIsRejected) {
     bytes.resize(bytes.size() - 1);
     EXPECT_EQ(decode_expect_error(bytes), CommandDecodeError::TruncatedPayload);
 }
+
+TEST(CommandDecodeErrors, MassQuoteSizeThatSplitsAnEntryIsRejected) {
+    std::vector<std::byte> bytes;
+    encode_command(ExchangeCommand{MassQuoteCommand{
+                       .command_sequence = 1,
+                       .account_id = 1,
+                       .instrument_id = 1,
+                       .entries = {QuoteEntry{.client_order_id = 1, .side = Side::Buy, .price = 100, .quantity = 5}},
+                   }},
+                   bytes);
+    // payload_size is the u16 at offset 2.
+    const std::size_t short_by_one = mass_quote_payload_size(1) - 1;
+    bytes[2] = static_cast<std::byte>(short_by_one >> 8U);
+    bytes[3] = static_cast<std::byte>(short_by_one & 0xFFU);
+    EXPECT_EQ(decode_expect_error(bytes), CommandDecodeError::InvalidMessageSize);
+}
+
+// MassCancel payload layout (offsets from the start of the frame,
+// HEADER_SIZE == 12): account_id(8)@12 flags(1)@20 instrument_id(4)@21
+// side(1)@25 max_orders(4)@26 before_exchange_order_id(8)@30.
+TEST(CommandDecodeErrors, MassCancelWithUnknownFlagsOrStrayFieldsIsRejected) {
+    std::vector<std::byte> bytes;
+    encode_command(ExchangeCommand{MassCancelCommand{
+                       .command_sequence = 1, .account_id = 1, .instrument_id = std::nullopt, .side = std::nullopt}},
+                   bytes);
+
+    auto unknown_flag = bytes;
+    unknown_flag[20] = std::byte{0x04};
+    EXPECT_EQ(decode_expect_error(unknown_flag), CommandDecodeError::InvalidFlags);
+
+    auto stray_instrument = bytes;
+    stray_instrument[24] = std::byte{3}; // flag clear, field non-zero
+    EXPECT_EQ(decode_expect_error(stray_instrument), CommandDecodeError::InvalidFlags);
+
+    auto bad_side = bytes;
+    bad_side[20] = std::byte{MASS_CANCEL_HAS_SIDE};
+    bad_side[25] = std::byte{7};
+    EXPECT_EQ(decode_expect_error(bad_side), CommandDecodeError::InvalidSide);
+}
+
+// TradingPhase payload layout: instrument_id(4)@12 phase(1)@16.
+TEST(CommandDecodeErrors, UnknownTradingPhaseIsRejected) {
+    std::vector<std::byte> bytes;
+    encode_command(
+        ExchangeCommand{TradingPhaseCommand{.command_sequence = 1, .instrument_id = 1, .phase = TradingPhase::Call}},
+        bytes);
+    bytes[16] = std::byte{2};
+    EXPECT_EQ(decode_expect_error(bytes), CommandDecodeError::InvalidTradingPhase);
+}
@@ -0,0 +1,194 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "common/event_ring.hpp"
+#include "exchange/sequencing/event_fanout.hpp"
+
+using namespace mdh;
+using namespace mdh::exchange::sequencing;
+
+namespace {
+
+// Reads everything consumer `id` can see right now.
+std::vector<int> drain(EventRing<int>& ring, std::size_t id) {
+    std::vector<int> seen;
+    ring.consume(id, 1'000, [&seen](const int& v) { seen.push_back(v); });
+    return seen;
+}
+
+void push(EventRing<int>& ring, int value) { ring.claim() = value; }
+
+} // namespace
+
+TEST(EventRing, CapacityRoundsUpToPowerOfTwo) {
+    EXPECT_EQ(EventRing<int>(0).capacity(), 1u);
+    EXPECT_EQ(EventRing<int>(4).capacity(), 4u);
+    EXPECT_EQ(EventRing<int>(5).capacity(), 8u);
+}
+
+TEST(EventRing, NothingIsVisibleUntilPublished) {
+    EventRing<int> ring(8);
+    const std::size_t consumer = ring.add_consumer();
+    push(ring, 1);
+    push(ring, 2);
+    EXPECT_TRUE(drain(ring, consumer).empty());
+    EXPECT_TRUE(ring.caught_up(consumer));
+
+    ring.publish();
+    EXPECT_FALSE(ring.caught_up(consumer));
+    EXPECT_EQ(drain(ring, consumer), (std::vector<int>{1, 2}));
+    EXPECT_TRUE(ring.caught_up(consumer));
+}
+
+TEST(EventRing, EveryConsumerSeesEveryElementAtItsOwnPace) {
+    EventRing<int> ring(8);
+    const std::size_t fast = ring.add_consumer();
+    const std::size_t slow = ring.add_consumer();
+    for (int i = 1; i <= 3; ++i) {
+        push(ring, i);
+    }
+    ring.publish();
+
+    EXPECT_EQ(drain(ring, fast), (std::vector<int>{1, 2, 3}));
+    push(ring, 4);
+    ring.publish();
+    EXPECT_EQ(drain(ring, fast), (std::vector<int>{4}));
+    EXPECT_EQ(drain(ring, slow), (std::vector<int>{1, 2, 3, 4})); // nothing was taken away from it
+}
+
+TEST(EventRing, ConsumeStopsAtMax) {
+    EventRing<int> ring(8);
+    const std::size_t consumer = ring.add_consumer();
+    for (int i = 1; i <= 5; ++i) {
+        push(ring, i);
+    }
+    ring.publish();
+    std::vector<int> seen;
+    EXPECT_EQ(ring.consume(consumer, 2, [&seen](const int& v) { seen.push_back(v); }), 2u);
+    EXPECT_EQ(ring.cursor(consumer), 2u);
+    EXPECT_EQ(drain(ring, consumer), (std::vector<int>{3, 4, 5}));
+}
+
+TEST(EventRing, ADownstreamConsumerNeverPassesItsUpstream) {
+    EventRing<int> ring(8);
+    const std::size_t journal = ring.add_consumer();
+    const std::size_t reports = ring.add_consumer({journal});
+    for (int i = 1; i <= 4; ++i) {
+        push(ring, i);
+    }
+    ring.publish();
+
+    EXPECT_TRUE(drain(ring, reports).empty()); // published, but the journal has not had them yet
+    ring.consume(journal, 3, [](const int&) {});
+    EXPECT_EQ(drain(ring, reports), (std::vector<int>{1, 2, 3}));
+    drain(ring, journal);
+    EXPECT_EQ(drain(ring, reports), (std::vector<int>{4}));
+}
+
+// A slot is reused only once the slowest consumer has passed it. Single
+// threaded, so the producer's wait is driven from a second thread that
+// consumes only once the producer is known to be stuck.
+TEST(EventRing, AFullRingWaitsForTheSlowestConsumerRatherThanOverwrite) {
+    EventRing<int> ring(4);
+    const std::size_t fast = ring.add_consumer();
+    const std::size_t slow = ring.add_consumer();
+    for (int i = 1; i <= 4; ++i) {
+        push(ring, i);
+    }
+    ring.publish();
+    EXPECT_EQ(drain(ring, fast).size(), 4u);
+
+    std::jthread unblock([&] {
+        while (ring.stalls() == 0) {
+            std::this_thread::yield();
+        }
+        EXPECT_EQ(drain(ring, slow), (std::vector<int>{1, 2, 3, 4})); // still the first lap's values
+    });
+    push(ring, 5); // waits until `slow` frees slot 0
+    ring.publish();
+    unblock.join();
+
+    EXPECT_GE(ring.stalls(), 1u);
+    EXPECT_EQ(drain(ring, fast), (std::vector<int>{5}));
+    EXPECT_EQ(drain(ring, slow), (std::vector<int>{5}));
+}
+
+// More claims than slots without a publish in between: the ring publishes
+// the run itself rather than wait for consumers that cannot see it.
+TEST(EventRing, AnUnpublishedRunLongerThanTheRingPublishesItself) {
+    EventRing<int> ring(4);
+    const std::size_t consumer = ring.add_consumer();
+    std::vector<int> seen;
+    std::atomic<bool> done{false};
+    std::jthread reader([&] {
+        while (!done.load(std::memory_order_acquire) || !ring.caught_up(consumer)) {
+            ring.consume(consumer, 64, [&seen](const int& v) { seen.push_back(v); });
+        }
+    });
+    for (int i = 0; i < 10; ++i) {
+        push(ring, i);
+    }
+    ring.publish();
+    done.store(true, std::memory_order_release);
+    reader.join();
+    EXPECT_EQ(seen, (std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+}
+
+// ── EventFanout: the same, with a thread per handler ─────────────────────
+//
+// As with the queues' concurrent tests, run under ThreadSanitizer
+// (MDH_ENABLE_TSAN) to check the cursors' acquire/release pairs. The ring
+// is small so the producer keeps catching up with the slowest handler.
+
+TEST(EventFanout, EveryHandlerSeesEveryEventInOrderAndDownstreamNeverLeads) {
+    constexpr int kEvents = 100'000;
+    for (const WaitPolicy wait : {WaitPolicy::SpinThenYield, WaitPolicy::Park}) {
+        EventFanout<int> fanout(EventFanoutOptions{.capacity = 64, .wait = wait});
+        std::atomic<int> journaled{0};
+        int journal_next = 0;
+        int report_next = 0;
+        int market_data_next = 0;
+        const std::size_t journal = fanout.add_handler("journal", [&](const int& v) {
+            EXPECT_EQ(v, journal_next++);
+            journaled.store(v + 1, std::memory_order_release);
+        });
+        fanout.add_handler(
+            "reports",
+            [&](const int& v) {
+                EXPECT_EQ(v, report_next++);
+                EXPECT_LT(v, journaled.load(std::memory_order_acquire)); // never ahead of the journal
+            },
+            {journal});
+        fanout.add_handler("market-data", [&](const int& v) { EXPECT_EQ(v, market_data_next++); });
+        fanout.start();
+
+        for (int i = 0; i < kEvents; ++i) {
+            fanout.claim() = i;
+            if (i % 3 == 2) {
+                fanout.publish(); // a few events per "command", as the matching thread publishes
+            }
+        }
+        fanout.publish();
+        fanout.stop(); // drains every handler
+
+        EXPECT_EQ(journal_next, kEvents);
+        EXPECT_EQ(report_next, kEvents);
+        EXPECT_EQ(market_data_next, kEvents);
+        EXPECT_EQ(fanout.published(), static_cast<std::size_t>(kEvents));
+    }
+}
+
+TEST(EventFanout, StopWithNothingPublishedWakesParkedHandlers) {
+    EventFanout<int> fanout(EventFanoutOptions{.capacity = 8, .wait = WaitPolicy::Park});
+    std::atomic<int> calls{0};
+    fanout.add_handler("idle", [&](const int&) { calls.fetch_add(1); });
+    fanout.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20)); // long enough to park
+    fanout.stop();
+    EXPECT_EQ(calls.load(), 0);
+}
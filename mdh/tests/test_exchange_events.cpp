@@ -153,13 +153,24 @@ TEST(ExchangeEvents, RejectReasonToStringCoversEveryEnumerator) {
     EXPECT_EQ(to_string(RejectReason::InsufficientPosition), "InsufficientPosition");
     EXPECT_EQ(to_string(RejectReason::OrderTooLarge), "OrderTooLarge");
     EXPECT_EQ(to_string(RejectReason::AccountMismatch), "AccountMismatch");
+    EXPECT_EQ(to_string(RejectReason::InvalidQuote), "InvalidQuote");
+    EXPECT_EQ(to_string(RejectReason::InvalidExpiry), "InvalidExpiry");
+    EXPECT_EQ(to_string(RejectReason::InvalidStopPrice), "InvalidStopPrice");
+    EXPECT_EQ(to_string(RejectReason::InvalidDuringCall), "InvalidDuringCall");
 }
 
 TEST(ExchangeEvents, OrderTypeAndTimeInForceToString) {
     EXPECT_EQ(to_string(OrderType::Limit), "Limit");
+    EXPECT_EQ(to_string(OrderType::StopLimit), "StopLimit");
     EXPECT_EQ(to_string(TimeInForce::GTC), "GTC");
     EXPECT_EQ(to_string(TimeInForce::IOC), "IOC");
     EXPECT_EQ(to_string(TimeInForce::FOK), "FOK");
+    EXPECT_EQ(to_string(TimeInForce::GTD), "GTD");
+}
+
+TEST(ExchangeEvents, TradingPhaseToString) {
+    EXPECT_EQ(to_string(TradingPhase::Continuous), "Continuous");
+    EXPECT_EQ(to_string(TradingPhase::Call), "Call");
 }
 
 TEST(EventSink, CollectsMultipleEventsEmittedForOneCommand) {
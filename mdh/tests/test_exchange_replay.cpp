@@ -114,6 +114,28 @@ TEST(ExchangeReplay, SameJournalProducesIdenticalFinalStateAcrossTwoRuns) {
     EXPECT_TRUE(any_resting_orders);
 }
 
+// The checkpoints are what a replica would compare against the primary's
+// along the way: one per N commands, agreeing across runs, with the last one
+// the final state's hash.
+TEST(ExchangeReplay, StateHashCheckpointsAgreeAcrossRunsAndEndAtTheFinalState) {
+    TempFile tmp("mdh_test_exchange_replay_checkpoints.bin");
+    write_mixed_journal(tmp.path());
+
+    const CommandReplayOptions every_three{.hash_every_commands = 3};
+    CommandReplayOutcome run1 = run_command_replay(tmp.path(), every_three);
+    CommandReplayOutcome run2 = run_command_replay(tmp.path(), every_three);
+
+    ASSERT_EQ(run1.state_hashes.size(), 3u);
+    EXPECT_EQ(run1.state_hashes[0].commands, 3u);
+    EXPECT_EQ(run1.state_hashes[2].commands, 9u);
+    EXPECT_EQ(run1.state_hashes, run2.state_hashes);
+    EXPECT_NE(run1.state_hashes[0].state_hash, run1.state_hashes[1].state_hash);
+    EXPECT_EQ(run1.state_hashes.back().state_hash, run1.engine.state_hash());
+    EXPECT_EQ(run1.engine.state_hash(), rolling_state_hash(run1.engine.snapshot()));
+
+    EXPECT_TRUE(run_command_replay(tmp.path()).state_hashes.empty()) << "off unless asked for";
+}
+
 TEST(ExchangeReplay, FinalStateMatchesHandComputedExpectation) {
     // Cross-checks the replay driver against manual bookkeeping of
     // write_mixed_journal()'s effects, so the determinism tests above are
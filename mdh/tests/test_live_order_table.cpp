@@ -0,0 +1,163 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "exchange/matching/live_order_table.hpp"
+#include "exchange/testing/matching_workload.hpp"
+
+namespace mdh::exchange {
+namespace {
+
+namespace mt = mdh::exchange::testing;
+
+OrderRef make_ref(std::uint64_t n) {
+    return OrderRef{
+        .original_quantity = n,
+        .order_sequence = n * 3,
+        .handle = MatchingBook::Handle{static_cast<std::uint32_t>(n)},
+        .instrument_id = static_cast<InstrumentId>(n % 7),
+    };
+}
+
+void expect_ref(const OrderRef* ref, std::uint64_t n) {
+    ASSERT_NE(ref, nullptr);
+    EXPECT_EQ(ref->original_quantity, n);
+    EXPECT_EQ(ref->order_sequence, n * 3);
+    EXPECT_EQ(ref->handle.slot, static_cast<std::uint32_t>(n));
+    EXPECT_EQ(ref->instrument_id, static_cast<InstrumentId>(n % 7));
+}
+
+TEST(LiveOrderTable, InsertFindAndEraseOneKey) {
+    LiveOrderTable table;
+    EXPECT_TRUE(table.empty());
+    EXPECT_EQ(table.find(LiveKey{1, 1}), nullptr);
+
+    table.insert_or_assign(LiveKey{1, 1}, make_ref(10));
+    EXPECT_EQ(table.size(), 1u);
+    EXPECT_TRUE(table.contains(LiveKey{1, 1}));
+    expect_ref(table.find(LiveKey{1, 1}), 10);
+
+    EXPECT_TRUE(table.erase(LiveKey{1, 1}));
+    EXPECT_FALSE(table.erase(LiveKey{1, 1}));
+    EXPECT_TRUE(table.empty());
+    EXPECT_EQ(table.find(LiveKey{1, 1}), nullptr);
+}
+
+TEST(LiveOrderTable, TheSameClientOrderIdUnderTwoAccountsIsTwoKeys) {
+    LiveOrderTable table;
+    table.insert_or_assign(LiveKey{1, 5}, make_ref(1));
+    table.insert_or_assign(LiveKey{2, 5}, make_ref(2));
+
+    EXPECT_EQ(table.size(), 2u);
+    expect_ref(table.find(LiveKey{1, 5}), 1);
+    expect_ref(table.find(LiveKey{2, 5}), 2);
+}
+
+TEST(LiveOrderTable, InsertingALiveKeyOverwritesItsValue) {
+    LiveOrderTable table;
+    table.insert_or_assign(LiveKey{1, 1}, make_ref(1));
+    table.insert_or_assign(LiveKey{1, 1}, make_ref(2));
+
+    EXPECT_EQ(table.size(), 1u);
+    expect_ref(table.find(LiveKey{1, 1}), 2);
+}
+
+TEST(LiveOrderTable, ExpectedEntriesFitWithoutGrowing) {
+    constexpr std::size_t kExpected = 100'000;
+    LiveOrderTable table(kExpected);
+    const std::size_t capacity = table.capacity();
+    // Sized to the load bound, not rounded up to a power of two.
+    EXPECT_GE(capacity, kExpected);
+    EXPECT_LT(capacity, kExpected * 5 / 4);
+
+    for (std::uint64_t i = 0; i < kExpected; ++i) {
+        table.insert_or_assign(LiveKey{i % 16, i}, make_ref(i));
+    }
+    EXPECT_EQ(table.capacity(), capacity);
+    for (std::uint64_t i = 0; i < kExpected; ++i) {
+        expect_ref(table.find(LiveKey{i % 16, i}), i);
+    }
+}
+
+TEST(LiveOrderTable, GrowingPastTheReserveKeepsEveryEntry) {
+    LiveOrderTable table(4);
+    constexpr std::uint64_t kCount = 10'000;
+    for (std::uint64_t i = 0; i < kCount; ++i) {
+        table.insert_or_assign(LiveKey{7, i}, make_ref(i));
+    }
+    EXPECT_EQ(table.size(), kCount);
+    EXPECT_GE(table.capacity(), kCount);
+    for (std::uint64_t i = 0; i < kCount; ++i) {
+        expect_ref(table.find(LiveKey{7, i}), i);
+    }
+    EXPECT_EQ(table.find(LiveKey{7, kCount}), nullptr);
+}
+
+// A table that rests and cancels at the same rate forever -- which is what
+// order flow is -- must keep finding everything with no tombstones to go
+// stale. Backward-shift deletion is the part most likely to be subtly wrong,
+// so this drives it against a reference map with a small table, where runs
+// are long and wrap past the end of the array.
+TEST(LiveOrderTable, RandomChurnMatchesAReferenceMap) {
+    LiveOrderTable table(64);
+    std::unordered_map<std::uint64_t, std::uint64_t> reference; // client order id -> value
+    std::vector<std::uint64_t> live;
+    mt::SplitMix64 rng(0x1DE0'77AB'1E5EEDULL);
+
+    std::uint64_t next_id = 1;
+    for (int op = 0; op < 200'000; ++op) {
+        const std::uint64_t roll = rng.below(100);
+        if (roll < 45 || live.empty()) {
+            // Sizes wander between empty-ish and above the reserve.
+            const std::uint64_t id = next_id++;
+            const std::uint64_t value = rng.next() >> 8U;
+            table.insert_or_assign(LiveKey{id % 3, id}, make_ref(value));
+            reference[id] = value;
+            live.push_back(id);
+        } else if (roll < 90) {
+            const std::size_t at = rng.below(live.size());
+            const std::uint64_t id = live[at];
+            live[at] = live.back();
+            live.pop_back();
+            // Both ways the engine erases: by key, and through what find()
+            // just returned.
+            if ((op & 1) == 0) {
+                ASSERT_TRUE(table.erase(LiveKey{id % 3, id}));
+            } else {
+                const OrderRef* found = table.find(LiveKey{id % 3, id});
+                ASSERT_NE(found, nullptr);
+                table.erase(found);
+            }
+            reference.erase(id);
+        } else if (roll < 95) {
+            const std::uint64_t id = live[rng.below(live.size())];
+            const std::uint64_t value = rng.next() >> 8U;
+            table.insert_or_assign(LiveKey{id % 3, id}, make_ref(value));
+            reference[id] = value;
+        } else {
+            // A key that was never inserted, or one that was and is gone.
+            const std::uint64_t id = rng.below(next_id + 16);
+            const bool is_live = reference.contains(id);
+            ASSERT_EQ(table.contains(LiveKey{id % 3, id}), is_live);
+        }
+        ASSERT_EQ(table.size(), reference.size());
+
+        if (op % 20'000 == 0) {
+            for (const auto& [id, value] : reference) {
+                expect_ref(table.find(LiveKey{id % 3, id}), value);
+            }
+        }
+    }
+    for (const auto& [id, value] : reference) {
+        expect_ref(table.find(LiveKey{id % 3, id}), value);
+    }
+    for (const std::uint64_t id : live) {
+        ASSERT_TRUE(table.erase(LiveKey{id % 3, id}));
+    }
+    EXPECT_TRUE(table.empty());
+}
+
+} // namespace
+} // namespace mdh::exchange
@@ -0,0 +1,346 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <variant>
+#include <vector>
+
+#include "exchange/matching/matching_book.hpp"
+#include "exchange/matching/matching_engine.hpp"
+#include "exchange/persistence/state_hash.hpp"
+#include "exchange/risk/risk_gated_engine.hpp"
+#include "exchange/testing/matching_scenarios.hpp"
+
+namespace mdh::exchange {
+namespace {
+
+using testing::CollectingSink;
+using testing::new_order;
+using testing::stop_limit_order;
+
+constexpr InstrumentId kFirst = 1;
+constexpr InstrumentId kSecond = 2;
+constexpr AccountId kMaker = 100;
+constexpr AccountId kOther = 200;
+
+MassCancelCommand mass_cancel(CommandSequence seq, AccountId account, std::optional<InstrumentId> instrument = {},
+                              std::optional<Side> side = {}) {
+    return MassCancelCommand{
+        .command_sequence = seq,
+        .account_id = account,
+        .instrument_id = instrument,
+        .side = side,
+    };
+}
+
+// Two books, each with the maker on both sides and one order from somebody
+// else resting alongside. Client ids 1..6 are the maker's, in entry order.
+void seed(MatchingEngine& engine) {
+    CollectingSink setup;
+    engine.process(new_order(1, kMaker, 1, kFirst, Side::Buy, 99, 10), setup.sink());
+    engine.process(new_order(2, kMaker, 2, kSecond, Side::Sell, 201, 10), setup.sink());
+    engine.process(new_order(3, kMaker, 3, kFirst, Side::Sell, 101, 10), setup.sink());
+    engine.process(new_order(4, kOther, 1, kFirst, Side::Buy, 99, 10), setup.sink());
+    engine.process(new_order(5, kMaker, 4, kSecond, Side::Buy, 199, 10), setup.sink());
+    engine.process(new_order(6, kMaker, 5, kFirst, Side::Buy, 98, 10), setup.sink());
+    engine.process(new_order(7, kOther, 2, kSecond, Side::Sell, 202, 10), setup.sink());
+    engine.process(new_order(8, kMaker, 6, kSecond, Side::Sell, 203, 10), setup.sink());
+    ASSERT_EQ(setup.count<OrderRejected>(), 0u);
+}
+
+TEST(MassCancel, CancelsEveryOrderOfTheAccountInstrumentByInstrumentOldestFirst) {
+    MatchingEngine engine{kFirst, kSecond};
+    seed(engine);
+
+    CollectingSink out;
+    engine.process(mass_cancel(9, kMaker), out.sink());
+
+    EXPECT_EQ(out.cancelled_ids(), (std::vector<ClientOrderId>{1, 3, 5, 2, 4, 6}));
+    EXPECT_EQ(out.count<BookOrderRemoved>(), 6u);
+    for (std::size_t i = 0; i < out.events.size(); i += 2) {
+        ASSERT_TRUE(std::holds_alternative<OrderCancelled>(out.events[i]));
+        ASSERT_TRUE(std::holds_alternative<BookOrderRemoved>(out.events[i + 1]));
+        EXPECT_EQ(out.at<OrderCancelled>(i).command_sequence, 9u);
+        EXPECT_EQ(out.at<OrderCancelled>(i).account_id, kMaker);
+    }
+
+    // The other account's orders are untouched.
+    const EngineStateSnapshot snapshot = engine.snapshot();
+    ASSERT_EQ(snapshot.instruments.size(), 2u);
+    ASSERT_EQ(snapshot.instruments[0].bids.size(), 1u);
+    EXPECT_EQ(snapshot.instruments[0].bids[0].account_id, kOther);
+    EXPECT_TRUE(snapshot.instruments[0].asks.empty());
+    EXPECT_TRUE(snapshot.instruments[1].bids.empty());
+    ASSERT_EQ(snapshot.instruments[1].asks.size(), 1u);
+    EXPECT_EQ(snapshot.instruments[1].asks[0].price, 202);
+}
+
+TEST(MassCancel, NarrowsToOneInstrumentAndOneSide) {
+    MatchingEngine engine{kFirst, kSecond};
+    seed(engine);
+
+    CollectingSink bids_on_first;
+    engine.process(mass_cancel(9, kMaker, kFirst, Side::Buy), bids_on_first.sink());
+    EXPECT_EQ(bids_on_first.cancelled_ids(), (std::vector<ClientOrderId>{1, 5}));
+
+    CollectingSink asks_anywhere;
+    engine.process(mass_cancel(10, kMaker, std::nullopt, Side::Sell), asks_anywhere.sink());
+    EXPECT_EQ(asks_anywhere.cancelled_ids(), (std::vector<ClientOrderId>{3, 2, 6}));
+
+    CollectingSink second;
+    engine.process(mass_cancel(11, kMaker, kSecond), second.sink());
+    EXPECT_EQ(second.cancelled_ids(), (std::vector<ClientOrderId>{4}));
+}
+
+// Nothing to cancel is not an error: the command is a kill switch, and a
+// kill switch pulled twice has simply already worked.
+TEST(MassCancel, AnAccountWithNothingRestingProducesNoEvents) {
+    MatchingEngine engine{kFirst, kSecond};
+    seed(engine);
+
+    CollectingSink first;
+    engine.process(mass_cancel(9, kMaker), first.sink());
+    ASSERT_FALSE(first.events.empty());
+
+    CollectingSink again;
+    engine.process(mass_cancel(10, kMaker), again.sink());
+    engine.process(mass_cancel(11, 999), again.sink());
+    EXPECT_TRUE(again.events.empty());
+    EXPECT_EQ(engine.commands_processed(), 11u);
+}
+
+TEST(MassCancel, AnUnknownInstrumentIsRejectedUnderIdZero) {
+    MatchingEngine engine{kFirst, kSecond};
+    seed(engine);
+
+    CollectingSink out;
+    engine.process(mass_cancel(9, kMaker, 7), out.sink());
+    ASSERT_EQ(out.events.size(), 1u);
+    EXPECT_EQ(out.at<OrderRejected>(0).client_order_id, 0u);
+    EXPECT_EQ(out.at<OrderRejected>(0).instrument_id, 7u);
+    EXPECT_EQ(out.at<OrderRejected>(0).reason, RejectReason::InvalidInstrument);
+}
+
+// The cancelled orders leave the live-order directory too, so their ids are
+// free for new orders straight away.
+TEST(MassCancel, CancelledIdsMayBeReused) {
+    MatchingEngine engine{kFirst, kSecond};
+    seed(engine);
+
+    CollectingSink out;
+    engine.process(mass_cancel(9, kMaker), out.sink());
+    engine.process(new_order(10, kMaker, 1, kSecond, Side::Buy, 150, 5), out.sink());
+    EXPECT_EQ(out.count<OrderRejected>(), 0u);
+
+    CollectingSink cancel_one;
+    engine.process(CancelOrderCommand{.command_sequence = 11, .account_id = kMaker, .client_order_id = 3,
+                                      .instrument_id = kFirst},
+                   cancel_one.sink());
+    ASSERT_EQ(cancel_one.events.size(), 1u);
+    EXPECT_EQ(cancel_one.at<OrderRejected>(0).reason, RejectReason::UnknownOrderId);
+}
+
+TEST(MassCancel, TheRollingStateHashFollowsEveryBookItTouches) {
+    MatchingEngine engine{kFirst, kSecond};
+    seed(engine);
+    const std::uint64_t before = engine.state_hash();
+
+    CollectingSink out;
+    engine.process(mass_cancel(9, kMaker), out.sink());
+    EXPECT_NE(engine.state_hash(), before);
+    EXPECT_EQ(engine.state_hash(), persistence::rolling_state_hash(engine.snapshot()));
+}
+
+TEST(MassCancel, QuoteLevelsItCancelsLeaveTheQuote) {
+    MatchingEngine engine{kFirst};
+    CollectingSink out;
+    engine.process(MassQuoteCommand{.command_sequence = 1,
+                                    .account_id = kMaker,
+                                    .instrument_id = kFirst,
+                                    .entries = {QuoteEntry{.client_order_id = 1, .side = Side::Buy, .price = 99,
+                                                           .quantity = 10},
+                                                QuoteEntry{.client_order_id = 2, .side = Side::Sell, .price = 101,
+                                                           .quantity = 10}}},
+                   out.sink());
+    engine.process(mass_cancel(2, kMaker, kFirst, Side::Buy), out.sink());
+
+    std::array<ClientOrderId, kMaxQuoteEntries> ids{};
+    ASSERT_EQ(engine.live_quotes(kMaker, kFirst, ids), 1u);
+    EXPECT_EQ(ids[0], 2u);
+}
+
+// ── The book's per-account chains ─────────────────────────────────────────
+
+TEST(MassCancel, TheBookKeepsEachAccountsOrdersChainedAcrossAddsAndRemovals) {
+    MatchingBook book;
+    auto order = [](ExchangeOrderId id, AccountId account, Side side, Price price) {
+        return BookOrder{.exchange_order_id = id,
+                         .client_order_id = id,
+                         .account_id = account,
+                         .price = price,
+                         .remaining_quantity = 1,
+                         .side = side,
+                         .time_in_force = TimeInForce::GTC};
+    };
+    const auto a = book.add(order(1, kMaker, Side::Buy, 10));
+    (void)book.add(order(2, kOther, Side::Buy, 10));
+    (void)book.add(order(3, kMaker, Side::Sell, 12));
+    (void)book.add(order(4, kMaker, Side::Buy, 9));
+    EXPECT_EQ(book.account_order_count(kMaker), 3u);
+    EXPECT_EQ(book.account_order_count(kOther), 1u);
+
+    (void)book.remove_at(a);
+    EXPECT_EQ(book.account_order_count(kMaker), 2u);
+
+    std::vector<ExchangeOrderId> removed;
+    EXPECT_EQ(book.remove_account_orders(kMaker, Side::Sell,
+                                         [&](const BookOrder& o) { removed.push_back(o.exchange_order_id); }),
+              1u);
+    EXPECT_EQ(book.remove_account_orders(kMaker, std::nullopt,
+                                         [&](const BookOrder& o) { removed.push_back(o.exchange_order_id); }),
+              1u);
+    EXPECT_EQ(removed, (std::vector<ExchangeOrderId>{3, 4}));
+    EXPECT_EQ(book.account_order_count(kMaker), 0u);
+    EXPECT_EQ(book.account_order_count(kOther), 1u);
+    EXPECT_EQ(book.all_bids().size() + book.all_asks().size(), 1u);
+}
+
+// ── In batches ────────────────────────────────────────────────────────────
+
+// The same cancels, in the same order, whatever the batch: each command
+// stops at max_orders, and sending it again until one comes up short
+// finishes the job. A batch that divides the orders exactly costs one more
+// command, which finds nothing.
+TEST(MassCancel, MaxOrdersCutsItIntoBatchesThatTogetherCancelTheSameOrders) {
+    for (const std::uint32_t batch : {1U, 3U, 4U, 6U}) {
+        MatchingEngine engine{kFirst, kSecond};
+        seed(engine);
+
+        std::vector<ClientOrderId> cancelled;
+        std::vector<std::size_t> sizes;
+        CommandSequence seq = 9;
+        while (true) {
+            MassCancelCommand cmd = mass_cancel(seq, kMaker);
+            cmd.max_orders = batch;
+            CollectingSink out;
+            engine.process(cmd, out.sink());
+            for (const OrderCancelled& ev : out.of<OrderCancelled>()) {
+                EXPECT_EQ(ev.command_sequence, seq);
+                cancelled.push_back(ev.client_order_id);
+            }
+            sizes.push_back(out.count<OrderCancelled>());
+            ++seq;
+            if (sizes.back() < batch) {
+                break;
+            }
+        }
+        EXPECT_EQ(cancelled, (std::vector<ClientOrderId>{1, 3, 5, 2, 4, 6})) << "batch " << batch;
+        EXPECT_EQ(sizes.size(), std::size_t{6} / batch + 1) << "batch " << batch;
+    }
+}
+
+// What the gateway's later batches carry: the id the engine would have
+// given the next order as the first batch finished. An order entered
+// between batches has that id or a higher one and is left resting, while a
+// stop entered before the first and released between them keeps its older
+// id and is still cancelled -- behind the new order in the account's
+// chain, so the bound has to pass over orders rather than end the walk.
+TEST(MassCancel, LaterBatchesLeaveAnOrderEnteredAfterTheFirst) {
+    MatchingEngine engine{kFirst};
+    CollectingSink setup;
+    engine.process(new_order(1, kMaker, 1, kFirst, Side::Buy, 99, 10), setup.sink());
+    engine.process(new_order(2, kMaker, 2, kFirst, Side::Buy, 98, 10), setup.sink());
+    engine.process(stop_limit_order(3, kMaker, 3, kFirst, Side::Buy, /*stop_price=*/105, 100, 5), setup.sink());
+    ASSERT_EQ(setup.count<OrderRejected>(), 0u);
+
+    MassCancelCommand cmd = mass_cancel(4, kMaker);
+    cmd.max_orders = 1;
+    CollectingSink first;
+    engine.process(cmd, first.sink());
+    ASSERT_EQ(first.cancelled_ids(), (std::vector<ClientOrderId>{1}));
+    cmd.before_exchange_order_id = engine.next_exchange_order_id();
+
+    // Between the batches: a new order, then a trade at 105 that releases
+    // the stop onto the book at 100.
+    engine.process(new_order(5, kMaker, 4, kFirst, Side::Buy, 97, 10), setup.sink());
+    engine.process(new_order(6, kOther, 1, kFirst, Side::Sell, 105, 1), setup.sink());
+    engine.process(new_order(7, kOther, 2, kFirst, Side::Buy, 105, 1), setup.sink());
+    ASSERT_EQ(setup.count<TradeExecuted>(), 1u);
+    ASSERT_EQ(engine.pending_stops(), 0u);
+
+    std::vector<ClientOrderId> cancelled;
+    for (cmd.command_sequence = 8;; ++cmd.command_sequence) {
+        CollectingSink out;
+        engine.process(cmd, out.sink());
+        for (const ClientOrderId id : out.cancelled_ids()) {
+            cancelled.push_back(id);
+        }
+        if (out.count<OrderCancelled>() < cmd.max_orders) {
+            break;
+        }
+    }
+    EXPECT_EQ(cancelled, (std::vector<ClientOrderId>{2, 3}));
+
+    // Still resting, for an unbounded mass cancel to find.
+    CollectingSink rest;
+    engine.process(mass_cancel(++cmd.command_sequence, kMaker), rest.sink());
+    EXPECT_EQ(rest.cancelled_ids(), (std::vector<ClientOrderId>{4}));
+}
+
+// Without an instrument, a mass cancel visits only the books the engine has
+// seen the account rest in. That has to include a book whose order came
+// from a released stop and one where the account has nothing but a stop.
+TEST(MassCancel, FindsTheAccountOnEveryBookHoweverItsOrdersGotThere) {
+    constexpr InstrumentId kThird = 3;
+    MatchingEngine engine{kFirst, kSecond, kThird};
+    CollectingSink setup;
+    auto stop = [](CommandSequence seq, ClientOrderId client_id, InstrumentId instrument, Price stop_price,
+                   Price limit_price) {
+        return stop_limit_order(seq, kMaker, client_id, instrument, Side::Buy, stop_price, limit_price, 5);
+    };
+    engine.process(new_order(1, kOther, 1, kFirst, Side::Buy, 99, 10), setup.sink());
+    engine.process(stop(2, 1, kSecond, 200, 190), setup.sink());
+    engine.process(stop(3, 2, kThird, 300, 310), setup.sink());
+    // A trade at 200 on the second book releases the maker's stop there,
+    // which rests at 190.
+    engine.process(new_order(4, kOther, 2, kSecond, Side::Sell, 200, 1), setup.sink());
+    engine.process(new_order(5, kOther, 3, kSecond, Side::Buy, 200, 1), setup.sink());
+    ASSERT_EQ(setup.count<OrderRejected>(), 0u);
+    ASSERT_EQ(setup.count<TradeExecuted>(), 1u);
+
+    CollectingSink out;
+    engine.process(mass_cancel(6, kMaker), out.sink());
+    EXPECT_EQ(out.cancelled_ids(), (std::vector<ClientOrderId>{1, 2}));
+    EXPECT_EQ(out.at<OrderCancelled>(0).instrument_id, kSecond);
+    EXPECT_EQ(out.at<OrderCancelled>(2).instrument_id, kThird);
+    EXPECT_EQ(out.count<BookOrderRemoved>(), 1u); // the stop on the third book was never on it
+}
+
+// ── Through the risk gate ─────────────────────────────────────────────────
+
+TEST(MassCancel, ReleasesEveryHoldThroughTheRiskGate) {
+    MatchingEngine engine{kFirst, kSecond};
+    ledger::Ledger ledger;
+    ledger.deposit_cash(kMaker, 10'000);
+    ledger.deposit_position(kMaker, kFirst, 10);
+    risk::RiskGatedEngine gated(engine, ledger);
+
+    CollectingSink out;
+    gated.process(new_order(1, kMaker, 1, kFirst, Side::Buy, 99, 10), out.sink());
+    gated.process(new_order(2, kMaker, 2, kSecond, Side::Buy, 199, 10), out.sink());
+    gated.process(new_order(3, kMaker, 3, kFirst, Side::Sell, 101, 10), out.sink());
+    ASSERT_EQ(out.count<OrderRejected>(), 0u);
+    EXPECT_EQ(ledger.available_cash(kMaker), 10'000 - 990 - 1'990);
+    EXPECT_EQ(ledger.available_position(kMaker, kFirst), 0u);
+
+    gated.process(mass_cancel(4, kMaker), out.sink());
+    EXPECT_EQ(ledger.available_cash(kMaker), 10'000);
+    EXPECT_EQ(ledger.available_position(kMaker, kFirst), 10u);
+    EXPECT_FALSE(ledger.find_hold(kMaker, 1).has_value());
+    EXPECT_FALSE(ledger.find_hold(kMaker, 3).has_value());
+}
+
+} // namespace
+} // namespace mdh::exchange
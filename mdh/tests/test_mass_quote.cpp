@@ -0,0 +1,318 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstddef>
+#include <variant>
+#include <vector>
+
+#include "exchange/matching/matching_engine.hpp"
+#include "exchange/persistence/state_hash.hpp"
+#include "exchange/risk/risk_gated_engine.hpp"
+#include "exchange/testing/matching_scenarios.hpp"
+
+namespace mdh::exchange {
+namespace {
+
+using testing::CollectingSink;
+using testing::new_order;
+
+constexpr InstrumentId kInstrument = 1;
+constexpr AccountId kMaker = 100;
+constexpr AccountId kTaker = 200;
+
+QuoteEntry bid(ClientOrderId client_id, Price price, Quantity qty) {
+    return QuoteEntry{.client_order_id = client_id, .side = Side::Buy, .price = price, .quantity = qty};
+}
+
+QuoteEntry ask(ClientOrderId client_id, Price price, Quantity qty) {
+    return QuoteEntry{.client_order_id = client_id, .side = Side::Sell, .price = price, .quantity = qty};
+}
+
+MassQuoteCommand quote(CommandSequence seq, std::vector<QuoteEntry> entries, AccountId account = kMaker) {
+    return MassQuoteCommand{
+        .command_sequence = seq,
+        .account_id = account,
+        .instrument_id = kInstrument,
+        .entries = std::move(entries),
+    };
+}
+
+template <class T>
+bool holds(const ExchangeEvent& ev) {
+    return std::holds_alternative<T>(ev);
+}
+
+std::vector<ClientOrderId> live_quotes(const MatchingEngine& engine, AccountId account = kMaker) {
+    std::array<ClientOrderId, kMaxQuoteEntries> ids{};
+    const std::size_t n = engine.live_quotes(account, kInstrument, ids);
+    return {ids.begin(), ids.begin() + static_cast<std::ptrdiff_t>(n)};
+}
+
+TEST(MassQuote, AFirstQuoteEntersEveryLevelAsAGtcOrder) {
+    MatchingEngine engine{kInstrument};
+    CollectingSink out;
+    engine.process(quote(1, {bid(1, 99, 10), bid(2, 98, 20), ask(3, 101, 10), ask(4, 102, 20)}), out.sink());
+
+    EXPECT_EQ(out.count<OrderAccepted>(), 4u);
+    EXPECT_EQ(out.count<BookOrderAdded>(), 4u);
+    for (std::size_t i = 0; i < out.events.size(); i += 2) {
+        ASSERT_TRUE(holds<OrderAccepted>(out.events[i]));
+        EXPECT_EQ(out.at<OrderAccepted>(i).command_sequence, 1u);
+        EXPECT_EQ(out.at<OrderAccepted>(i).time_in_force, TimeInForce::GTC);
+    }
+
+    const EngineStateSnapshot snapshot = engine.snapshot();
+    ASSERT_EQ(snapshot.instruments.size(), 1u);
+    EXPECT_EQ(snapshot.instruments[0].bids.size(), 2u);
+    EXPECT_EQ(snapshot.instruments[0].asks.size(), 2u);
+    EXPECT_EQ(live_quotes(engine), (std::vector<ClientOrderId>{1, 2, 3, 4}));
+}
+
+// The point of the command: a level that only shrinks keeps its place in
+// the queue, exactly as a priority-preserving replace would, and one that
+// moves is cancelled and re-entered -- all in one command.
+TEST(MassQuote, ARequotePairsLevelsInPlaceCancelsTheRestAndEntersTheNew) {
+    MatchingEngine engine{kInstrument};
+    CollectingSink setup;
+    engine.process(quote(1, {bid(1, 99, 10), ask(2, 101, 10)}), setup.sink());
+    const ExchangeOrderId bid_exchange_id = setup.at<OrderAccepted>(0).exchange_order_id;
+    // Someone else joins the bid behind the quote.
+    engine.process(new_order(2, kTaker, 1, kInstrument, Side::Buy, 99, 5), setup.sink());
+
+    CollectingSink out;
+    engine.process(quote(3, {bid(11, 99, 8), ask(12, 102, 10)}), out.sink());
+
+    // Cancels first, then the in-place edit, then the new level.
+    ASSERT_EQ(out.events.size(), 6u);
+    ASSERT_TRUE(holds<OrderCancelled>(out.events[0]));
+    EXPECT_EQ(out.at<OrderCancelled>(0).client_order_id, 2u);
+    EXPECT_TRUE(holds<BookOrderRemoved>(out.events[1]));
+    ASSERT_TRUE(holds<OrderReplaced>(out.events[2]));
+    const auto& replaced = out.at<OrderReplaced>(2);
+    EXPECT_EQ(replaced.original_client_order_id, 1u);
+    EXPECT_EQ(replaced.new_client_order_id, 11u);
+    EXPECT_EQ(replaced.exchange_order_id, bid_exchange_id);
+    EXPECT_EQ(replaced.new_quantity, 8u);
+    ASSERT_TRUE(holds<BookOrderReduced>(out.events[3]));
+    EXPECT_EQ(out.at<BookOrderReduced>(3).new_remaining_quantity, 8u);
+    ASSERT_TRUE(holds<OrderAccepted>(out.events[4]));
+    EXPECT_EQ(out.at<OrderAccepted>(4).client_order_id, 12u);
+    EXPECT_EQ(out.at<OrderAccepted>(4).price, 102);
+    EXPECT_TRUE(holds<BookOrderAdded>(out.events[5]));
+
+    // Still first in the queue at 99: a seller hitting 8 fills the quote,
+    // not the order that joined behind it.
+    CollectingSink hit;
+    engine.process(new_order(4, kTaker, 2, kInstrument, Side::Sell, 99, 8), hit.sink());
+    ASSERT_TRUE(holds<TradeExecuted>(hit.events[1]));
+    EXPECT_EQ(hit.at<TradeExecuted>(1).buyer.account_id, kMaker);
+    EXPECT_EQ(hit.at<TradeExecuted>(1).buyer.client_order_id, 11u);
+}
+
+TEST(MassQuote, AnIdTheOldQuoteIsGivingUpMayBeReusedByAnotherLevel) {
+    MatchingEngine engine{kInstrument};
+    CollectingSink out;
+    engine.process(quote(1, {bid(1, 99, 10), bid(2, 98, 10)}), out.sink());
+    // The two ids swap levels: each pair re-keys onto an id the other is
+    // still holding when the command starts.
+    engine.process(quote(2, {bid(2, 99, 10), bid(1, 98, 10)}), out.sink());
+
+    EXPECT_EQ(out.count<OrderReplaced>(), 2u);
+    EXPECT_EQ(out.count<OrderRejected>(), 0u);
+    EXPECT_EQ(live_quotes(engine), (std::vector<ClientOrderId>{2, 1}));
+
+    CollectingSink cancel;
+    engine.process(CancelOrderCommand{.command_sequence = 3, .account_id = kMaker, .client_order_id = 2,
+                                      .instrument_id = kInstrument},
+                   cancel.sink());
+    ASSERT_TRUE(holds<BookOrderRemoved>(cancel.events.at(1)));
+    EXPECT_EQ(cancel.at<BookOrderRemoved>(1).price, 99);
+}
+
+TEST(MassQuote, ALevelThatGrowsIsReenteredBehindTheQueue) {
+    MatchingEngine engine{kInstrument};
+    CollectingSink out;
+    engine.process(quote(1, {bid(1, 99, 10)}), out.sink());
+    CollectingSink requote;
+    engine.process(quote(2, {bid(2, 99, 15)}), requote.sink());
+
+    ASSERT_EQ(requote.events.size(), 4u);
+    EXPECT_TRUE(holds<OrderCancelled>(requote.events[0]));
+    EXPECT_TRUE(holds<BookOrderRemoved>(requote.events[1]));
+    EXPECT_TRUE(holds<OrderAccepted>(requote.events[2]));
+    EXPECT_TRUE(holds<BookOrderAdded>(requote.events[3]));
+}
+
+TEST(MassQuote, OneBadLevelRejectsTheWholeQuoteAndLeavesTheOldOneResting) {
+    MatchingEngine engine{kInstrument};
+    CollectingSink setup;
+    engine.process(quote(1, {bid(1, 99, 10), ask(2, 101, 10)}), setup.sink());
+    engine.process(new_order(2, kMaker, 50, kInstrument, Side::Buy, 90, 1), setup.sink());
+    const EngineStateSnapshot before = engine.snapshot();
+
+    CollectingSink bad_price;
+    engine.process(quote(3, {bid(11, 99, 10), ask(12, 0, 10)}), bad_price.sink());
+    ASSERT_EQ(bad_price.events.size(), 2u);
+    EXPECT_EQ(bad_price.at<OrderRejected>(0).reason, RejectReason::InvalidQuote);
+    EXPECT_EQ(bad_price.at<OrderRejected>(1).reason, RejectReason::InvalidPrice);
+    EXPECT_EQ(bad_price.at<OrderRejected>(1).client_order_id, 12u);
+
+    // An id the account already has live outside the quote.
+    CollectingSink duplicate;
+    engine.process(quote(4, {bid(50, 99, 10)}), duplicate.sink());
+    ASSERT_EQ(duplicate.events.size(), 1u);
+    EXPECT_EQ(duplicate.at<OrderRejected>(0).reason, RejectReason::DuplicateOrderId);
+
+    // The same id twice within the quote.
+    CollectingSink repeated;
+    engine.process(quote(5, {bid(11, 99, 10), ask(11, 101, 10)}), repeated.sink());
+    ASSERT_EQ(repeated.events.size(), 2u);
+    EXPECT_EQ(repeated.at<OrderRejected>(1).reason, RejectReason::InvalidQuote);
+
+    std::vector<QuoteEntry> too_many;
+    for (ClientOrderId id = 100; id < 100 + kMaxQuoteEntries + 1; ++id) {
+        too_many.push_back(bid(id, 80, 1));
+    }
+    CollectingSink oversized;
+    engine.process(quote(6, too_many), oversized.sink());
+    EXPECT_EQ(oversized.count<OrderRejected>(), kMaxQuoteEntries + 1);
+    EXPECT_EQ(oversized.at<OrderRejected>(0).reason, RejectReason::InvalidQuote);
+
+    EXPECT_EQ(engine.snapshot(), before);
+    EXPECT_EQ(live_quotes(engine), (std::vector<ClientOrderId>{1, 2}));
+}
+
+TEST(MassQuote, AnEmptyQuoteWithdrawsEveryLevelAndNothingElse) {
+    MatchingEngine engine{kInstrument};
+    CollectingSink setup;
+    engine.process(quote(1, {bid(1, 99, 10), ask(2, 101, 10)}), setup.sink());
+    engine.process(new_order(2, kMaker, 50, kInstrument, Side::Buy, 90, 1), setup.sink());
+
+    CollectingSink out;
+    engine.process(quote(3, {}), out.sink());
+    EXPECT_EQ(out.count<OrderCancelled>(), 2u);
+    EXPECT_EQ(out.count<BookOrderRemoved>(), 2u);
+    EXPECT_TRUE(live_quotes(engine).empty());
+
+    const EngineStateSnapshot snapshot = engine.snapshot();
+    ASSERT_EQ(snapshot.instruments.size(), 1u);
+    ASSERT_EQ(snapshot.instruments[0].bids.size(), 1u);
+    EXPECT_EQ(snapshot.instruments[0].bids[0].client_order_id, 50u); // an ordinary order is never a quote
+
+    // Nothing left to withdraw, and nothing reported for it.
+    CollectingSink again;
+    engine.process(quote(4, {}), again.sink());
+    EXPECT_TRUE(again.events.empty());
+}
+
+// A level that is filled, cancelled, or replaced away leaves the quote. Its
+// id may then come back as an ordinary order, which a requote must neither
+// cancel nor take over.
+TEST(MassQuote, LevelsThatLeftTheBookAnotherWayAreNoLongerPartOfTheQuote) {
+    MatchingEngine engine{kInstrument};
+    CollectingSink setup;
+    engine.process(quote(1, {bid(1, 99, 10), ask(2, 101, 10)}), setup.sink());
+    engine.process(new_order(2, kTaker, 1, kInstrument, Side::Sell, 99, 10), setup.sink()); // fills quote level 1
+    engine.process(new_order(3, kMaker, 1, kInstrument, Side::Buy, 95, 3), setup.sink()); // id 1 is now an ordinary order
+    EXPECT_EQ(live_quotes(engine), (std::vector<ClientOrderId>{2}));
+
+    CollectingSink reuse;
+    engine.process(quote(4, {bid(1, 99, 10)}), reuse.sink());
+    ASSERT_EQ(reuse.events.size(), 1u);
+    EXPECT_EQ(reuse.at<OrderRejected>(0).reason, RejectReason::DuplicateOrderId);
+
+    CollectingSink out;
+    engine.process(quote(5, {}), out.sink());
+    ASSERT_EQ(out.events.size(), 2u);
+    EXPECT_EQ(out.at<OrderCancelled>(0).client_order_id, 2u);
+    const EngineStateSnapshot snapshot = engine.snapshot();
+    ASSERT_EQ(snapshot.instruments[0].bids.size(), 1u);
+    EXPECT_EQ(snapshot.instruments[0].bids[0].price, 95);
+}
+
+TEST(MassQuote, ANewLevelThatCrossesTradesOnEntry) {
+    MatchingEngine engine{kInstrument};
+    CollectingSink setup;
+    engine.process(new_order(1, kTaker, 1, kInstrument, Side::Sell, 100, 4), setup.sink());
+
+    CollectingSink out;
+    engine.process(quote(2, {bid(1, 100, 10)}), out.sink());
+    ASSERT_TRUE(holds<OrderAccepted>(out.events[0]));
+    ASSERT_TRUE(holds<TradeExecuted>(out.events[1]));
+    EXPECT_EQ(out.at<TradeExecuted>(1).quantity, 4u);
+    ASSERT_TRUE(holds<BookOrderAdded>(out.events.back()));
+    EXPECT_EQ(out.at<BookOrderAdded>(out.events.size() - 1).quantity, 6u);
+}
+
+TEST(MassQuote, AnUnknownInstrumentIsRejectedPerLevelOrOnceIfThereAreNone) {
+    MatchingEngine engine{kInstrument};
+    MassQuoteCommand elsewhere = quote(1, {bid(1, 99, 10), ask(2, 101, 10)});
+    elsewhere.instrument_id = 9;
+    CollectingSink out;
+    engine.process(elsewhere, out.sink());
+    ASSERT_EQ(out.events.size(), 2u);
+    EXPECT_EQ(out.at<OrderRejected>(1).reason, RejectReason::InvalidInstrument);
+
+    elsewhere.entries.clear();
+    CollectingSink empty;
+    engine.process(elsewhere, empty.sink());
+    ASSERT_EQ(empty.events.size(), 1u);
+    EXPECT_EQ(empty.at<OrderRejected>(0).client_order_id, 0u);
+}
+
+// The rolling hash is kept by the books, so a command that touches many
+// levels at once must leave it where a snapshot of the same state puts it.
+TEST(MassQuote, TheRollingStateHashFollowsARequote) {
+    MatchingEngine engine{kInstrument};
+    CollectingSink out;
+    engine.process(quote(1, {bid(1, 99, 10), bid(2, 98, 10), ask(3, 101, 10)}), out.sink());
+    engine.process(quote(2, {bid(4, 99, 5), ask(5, 100, 10), ask(6, 103, 1)}), out.sink());
+    EXPECT_EQ(engine.state_hash(), persistence::rolling_state_hash(engine.snapshot()));
+}
+
+// ── Through the risk gate ─────────────────────────────────────────────────
+
+TEST(MassQuote, RiskCreditsTheHoldsOfTheQuoteBeingReplaced) {
+    MatchingEngine engine{kInstrument};
+    ledger::Ledger ledger;
+    ledger.deposit_cash(kMaker, 2'000);
+    ledger.deposit_position(kMaker, kInstrument, 10);
+    risk::RiskGatedEngine gated(engine, ledger);
+
+    CollectingSink first;
+    gated.process(quote(1, {bid(1, 100, 20), ask(2, 110, 10)}), first.sink());
+    ASSERT_EQ(first.count<OrderRejected>(), 0u);
+    EXPECT_EQ(ledger.available_cash(kMaker), 0);
+    EXPECT_EQ(ledger.available_position(kMaker, kInstrument), 0u);
+
+    // Every unit of cash and position is already reserved, by the quote
+    // this one replaces -- which releases it.
+    CollectingSink second;
+    gated.process(quote(2, {bid(3, 99, 20), ask(4, 111, 10)}), second.sink());
+    EXPECT_EQ(second.count<OrderRejected>(), 0u);
+    EXPECT_EQ(ledger.available_cash(kMaker), 2'000 - 99 * 20);
+    EXPECT_EQ(ledger.available_position(kMaker, kInstrument), 0u);
+    EXPECT_FALSE(ledger.find_hold(kMaker, 1).has_value());
+}
+
+TEST(MassQuote, RiskRejectsTheWholeQuoteWhenItCannotBeFunded) {
+    MatchingEngine engine{kInstrument};
+    ledger::Ledger ledger;
+    ledger.deposit_cash(kMaker, 1'000);
+    risk::RiskGatedEngine gated(engine, ledger);
+
+    CollectingSink out;
+    gated.process(quote(1, {bid(1, 100, 5), bid(2, 99, 6)}), out.sink());
+    ASSERT_EQ(out.events.size(), 2u);
+    EXPECT_EQ(out.at<OrderRejected>(0).reason, RejectReason::InsufficientFunds);
+    EXPECT_EQ(out.at<OrderRejected>(1).reason, RejectReason::InsufficientFunds);
+    EXPECT_TRUE(engine.snapshot().instruments.empty());
+
+    CollectingSink shortfall;
+    gated.process(quote(2, {ask(3, 100, 1)}), shortfall.sink());
+    ASSERT_EQ(shortfall.events.size(), 1u);
+    EXPECT_EQ(shortfall.at<OrderRejected>(0).reason, RejectReason::InsufficientPosition);
+}
+
+} // namespace
+} // namespace mdh::exchange
@@ -1,5 +1,10 @@
 #include <gtest/gtest.h>
 
+#include <array>
+#include <optional>
+#include <span>
+#include <vector>
+
 #include "exchange/matching/matching_book.hpp"
 #include "exchange/matching/matching_engine.hpp" // for the ladder budget the band table below is derived from
 
@@ -34,13 +39,13 @@ TEST(MatchingBook, FifoOrderWithinOneLevel) {
     book.add(make_order(2, Side::Buy, 100, 7));
     book.add(make_order(3, Side::Buy, 100, 9));
 
-    const BookOrder* front = book.front_of_best(Side::Buy);
-    ASSERT_NE(front, nullptr);
+    std::optional<BookOrder> front = book.front_of_best(Side::Buy);
+    ASSERT_TRUE(front.has_value());
     EXPECT_EQ(front->exchange_order_id, 1u); // first-added is first in FIFO
 
     book.remove_front(Side::Buy);
     front = book.front_of_best(Side::Buy);
-    ASSERT_NE(front, nullptr);
+    ASSERT_TRUE(front.has_value());
     EXPECT_EQ(front->exchange_order_id, 2u);
 }
 
@@ -148,6 +153,27 @@ TEST(MatchingBook, SlotFreedOnOneSideIsReusableOnTheOther) {
     ASSERT_EQ(book.all_asks().size(), 1u);
 }
 
+// An order is split across two arrays by slot, so a recycled slot has to
+// come back with both halves from its new order -- a stale quantity with
+// fresh ids, or the reverse, would still look like a plausible order.
+TEST(MatchingBook, RecycledSlotReadsBackEveryFieldOfItsNewOrder) {
+    MatchingBook book;
+    const auto gone = book.add(make_order(1, Side::Buy, 100, 5, /*client_order_id=*/11, /*account_id=*/21));
+    book.add(make_order(2, Side::Buy, 100, 6, /*client_order_id=*/12, /*account_id=*/22));
+    book.remove_at(gone);
+
+    BookOrder incoming = make_order(3, Side::Sell, 105, 9, /*client_order_id=*/13, /*account_id=*/23);
+    incoming.time_in_force = TimeInForce::IOC;
+    const auto reused = book.add(incoming);
+    ASSERT_EQ(reused.slot, gone.slot);
+    EXPECT_EQ(book.at(reused), incoming);
+
+    const std::optional<BookOrder> front = book.front_of_best(Side::Sell);
+    ASSERT_TRUE(front.has_value());
+    EXPECT_EQ(*front, incoming);
+    EXPECT_EQ(book.all_bids(), std::vector<BookOrder>{make_order(2, Side::Buy, 100, 6, 12, 22)});
+}
+
 TEST(MatchingBook, EmptyLevelIsClearedAfterLastOrderRemoved) {
     MatchingBook book;
     const auto only = book.add(make_order(1, Side::Buy, 100, 5));
@@ -173,8 +199,8 @@ TEST(MatchingBook, ReduceInPlacePreservesFifoPosition) {
     EXPECT_EQ(book.at(first).remaining_quantity, 2u);
 
     // Still first in FIFO despite the mutation.
-    const BookOrder* front = book.front_of_best(Side::Buy);
-    ASSERT_NE(front, nullptr);
+    const std::optional<BookOrder> front = book.front_of_best(Side::Buy);
+    ASSERT_TRUE(front.has_value());
     EXPECT_EQ(front->exchange_order_id, 1u);
 }
 
@@ -188,8 +214,8 @@ TEST(MatchingBook, SetClientOrderIdUpdatesInPlaceWithoutChangingFifoPosition) {
     EXPECT_EQ(book.at(first).exchange_order_id, 1u); // exchange_order_id never changes
 
     // Still first in FIFO despite the mutation.
-    const BookOrder* front = book.front_of_best(Side::Buy);
-    ASSERT_NE(front, nullptr);
+    const std::optional<BookOrder> front = book.front_of_best(Side::Buy);
+    ASSERT_TRUE(front.has_value());
     EXPECT_EQ(front->exchange_order_id, 1u);
 }
 
@@ -211,8 +237,8 @@ TEST(MatchingBook, AllBidsOrderedByPricePriorityThenFifo) {
 
 TEST(MatchingBook, FrontOfBestOnEmptySideReturnsNullptr) {
     MatchingBook book;
-    EXPECT_EQ(book.front_of_best(Side::Buy), nullptr);
-    EXPECT_EQ(book.front_of_best(Side::Sell), nullptr);
+    EXPECT_FALSE(book.front_of_best(Side::Buy).has_value());
+    EXPECT_FALSE(book.front_of_best(Side::Sell).has_value());
 }
 
 // ── The ladder's band, and what happens outside it ─────────────────────────
@@ -229,17 +255,22 @@ constexpr Price kBandHigh = kAnchor + kHalfBand - 1;
 
 TEST(MatchingBook, PricesInsideTheBandUseTheLadderAndPricesOutsideDoNot) {
     MatchingBook book;
+    // Both sides anchored on kAnchor with the touch there, so neither band
+    // has any reason to move: each edge is tested on the side where it is
+    // the far end of the book, not its touch.
     book.add(make_order(1, Side::Buy, kAnchor, 1));
+    book.add(make_order(2, Side::Sell, kAnchor, 1));
     EXPECT_EQ(book.out_of_band_levels(), 0u);
 
     // Both edges are in band; one tick past either is not.
-    book.add(make_order(2, Side::Buy, kBandLow, 1));
-    book.add(make_order(3, Side::Buy, kBandHigh, 1));
+    book.add(make_order(3, Side::Buy, kBandLow, 1));
+    book.add(make_order(4, Side::Sell, kBandHigh, 1));
     EXPECT_EQ(book.out_of_band_levels(), 0u);
 
-    book.add(make_order(4, Side::Buy, kBandLow - 1, 1));
-    book.add(make_order(5, Side::Buy, kBandHigh + 1, 1));
+    book.add(make_order(5, Side::Buy, kBandLow - 1, 1));
+    book.add(make_order(6, Side::Sell, kBandHigh + 1, 1));
     EXPECT_EQ(book.out_of_band_levels(), 2u);
+    EXPECT_EQ(book.rebase_counters().rebases, 0u);
 }
 
 TEST(MatchingBook, BestPriceIsCorrectWhenTheTouchIsOutOfBand) {
@@ -255,8 +286,8 @@ TEST(MatchingBook, BestPriceIsCorrectWhenTheTouchIsOutOfBand) {
     EXPECT_EQ(book.best_bid_price(), kBandHigh + 500);
     EXPECT_EQ(book.best_ask_price(), kAnchor - kHalfBand - 500);
 
-    const BookOrder* bid = book.front_of_best(Side::Buy);
-    ASSERT_NE(bid, nullptr);
+    const std::optional<BookOrder> bid = book.front_of_best(Side::Buy);
+    ASSERT_TRUE(bid.has_value());
     EXPECT_EQ(bid->exchange_order_id, 3u);
 }
 
@@ -316,29 +347,206 @@ TEST(MatchingBook, CrossableQuantityStopsAtThePriceBoundAcrossTheBandEdge) {
     EXPECT_EQ(book.crossable_quantity(Side::Buy, kBandHigh + 1'000, 1'000), 0u);
 }
 
+// ── Level totals and aggregated depth ──────────────────────────────────────
+//
+// Each level carries its own quantity and order count, kept in step by
+// every operation that changes what rests there. These check the totals
+// through depth() after each kind of change, in band and out of it, since
+// the two indexes hold their levels in different places.
+
+TEST(MatchingBook, LevelTotalsFollowEveryChangeInBandAndOutOfIt) {
+    for (const Price price : {kAnchor, kBandHigh + 100}) {
+        MatchingBook book;
+        // Anchors the ladder near kAnchor and sits ahead of the level under
+        // test, so that level is the second one depth() reports.
+        book.add(make_order(1, Side::Sell, kAnchor - 5, 1));
+        const Price at = price;
+        const auto first = book.add(make_order(2, Side::Sell, at, 10));
+        const auto second = book.add(make_order(3, Side::Sell, at, 20));
+        book.add(make_order(4, Side::Sell, at, 30));
+
+        std::array<LevelDepth, 4> levels{};
+        ASSERT_EQ(book.depth(Side::Sell, levels), 2u);
+        EXPECT_EQ(levels[1], (LevelDepth{.price = at, .quantity = 60, .order_count = 3}));
+
+        book.reduce_at(second, 5); // 20 -> 5
+        ASSERT_EQ(book.depth(Side::Sell, levels), 2u);
+        EXPECT_EQ(levels[1], (LevelDepth{.price = at, .quantity = 45, .order_count = 3}));
+
+        book.remove_at(first);
+        ASSERT_EQ(book.depth(Side::Sell, levels), 2u);
+        EXPECT_EQ(levels[1], (LevelDepth{.price = at, .quantity = 35, .order_count = 2}));
+
+        // Take the level ahead away, so the front operations act on the
+        // one under test.
+        book.remove_front(Side::Sell);
+        book.reduce_front(Side::Sell, 2); // order 3: 5 -> 2
+        ASSERT_EQ(book.depth(Side::Sell, levels), 1u);
+        EXPECT_EQ(levels[0], (LevelDepth{.price = at, .quantity = 32, .order_count = 2}));
+
+        book.remove_front(Side::Sell);
+        ASSERT_EQ(book.depth(Side::Sell, levels), 1u);
+        EXPECT_EQ(levels[0], (LevelDepth{.price = at, .quantity = 30, .order_count = 1}));
+
+        book.remove_front(Side::Sell);
+        EXPECT_EQ(book.depth(Side::Sell, levels), 0u);
+    }
+}
+
+TEST(MatchingBook, ALevelEmptiedAndRefilledStartsItsTotalsFromZero) {
+    MatchingBook book;
+    book.add(make_order(1, Side::Buy, kAnchor, 100));
+    const auto gone = book.add(make_order(2, Side::Buy, kAnchor - 1, 7));
+    book.remove_at(gone);
+    book.add(make_order(3, Side::Buy, kAnchor - 1, 4));
+
+    std::array<LevelDepth, 2> levels{};
+    ASSERT_EQ(book.depth(Side::Buy, levels), 2u);
+    EXPECT_EQ(levels[1], (LevelDepth{.price = kAnchor - 1, .quantity = 4, .order_count = 1}));
+}
+
+TEST(MatchingBook, DepthIsBestFirstAndStopsAtTheCallersSpan) {
+    MatchingBook book;
+    book.add(make_order(1, Side::Buy, kAnchor, 10));
+    book.add(make_order(2, Side::Buy, kBandHigh + 100, 1)); // out of band, best
+    book.add(make_order(3, Side::Buy, kAnchor, 5));
+    book.add(make_order(4, Side::Buy, kBandLow - 100, 3));  // out of band, worst
+    book.add(make_order(5, Side::Sell, kBandHigh + 200, 8));
+
+    std::array<LevelDepth, 8> all{};
+    ASSERT_EQ(book.depth(Side::Buy, all), 3u);
+    EXPECT_EQ(all[0], (LevelDepth{.price = kBandHigh + 100, .quantity = 1, .order_count = 1}));
+    EXPECT_EQ(all[1], (LevelDepth{.price = kAnchor, .quantity = 15, .order_count = 2}));
+    EXPECT_EQ(all[2], (LevelDepth{.price = kBandLow - 100, .quantity = 3, .order_count = 1}));
+
+    std::array<LevelDepth, 2> top{};
+    ASSERT_EQ(book.depth(Side::Buy, top), 2u);
+    EXPECT_EQ(top[1].price, kAnchor);
+
+    EXPECT_EQ(book.depth(Side::Buy, std::span<LevelDepth>{}), 0u);
+    ASSERT_EQ(book.depth(Side::Sell, all), 1u);
+    EXPECT_EQ(all[0].quantity, 8u);
+}
+
+TEST(MatchingBook, CrossableQuantityCountsWholeLevelsOfManySmallOrders) {
+    MatchingBook book;
+    ExchangeOrderId id = 1;
+    for (Price price = kAnchor; price < kAnchor + 4; ++price) {
+        for (int i = 0; i < 50; ++i) {
+            book.add(make_order(id++, Side::Sell, price, 2));
+        }
+    }
+    // Each level is 100; the bound is what stops the sum, not the orders.
+    EXPECT_EQ(book.crossable_quantity(Side::Sell, kAnchor + 1, 1'000), 200u);
+    EXPECT_EQ(book.crossable_quantity(Side::Sell, kAnchor + 3, 1'000), 400u);
+    // Covered partway through the second level: reported at level granularity.
+    EXPECT_EQ(book.crossable_quantity(Side::Sell, kAnchor + 3, 150), 200u);
+}
+
 TEST(MatchingBook, AnEmptiedSideReanchorsItsLadderSomewhereElse) {
     MatchingBook book;
     const auto first = book.add(make_order(1, Side::Buy, kAnchor, 1));
+    book.remove_at(first);
+    ASSERT_FALSE(book.best_bid_price().has_value());
 
-    // Far enough away that the old band cannot reach: without re-anchoring
-    // this order would spend its life in the overflow map.
+    // Far enough away that the old band cannot reach. With nothing resting
+    // the old base has nothing to protect, so the side simply anchors again:
+    // no rebase, and nothing to migrate.
     const Price elsewhere = kAnchor + 10 * MatchingBook::kMaxBandTicks;
     book.add(make_order(2, Side::Buy, elsewhere, 1));
-    EXPECT_EQ(book.out_of_band_levels(), 1u);
-
-    // Emptying the ladder is not enough on its own -- the side still holds
-    // the out-of-band order, so the base stays where it is.
-    book.remove_at(first);
+    EXPECT_EQ(book.out_of_band_levels(), 0u);
     EXPECT_EQ(book.best_bid_price(), elsewhere);
+    EXPECT_EQ(book.rebase_counters().rebases, 0u);
+}
+
+// ── Re-centering ───────────────────────────────────────────────────────────
+
+TEST(MatchingBook, ATouchThatLeavesTheBandPullsTheLadderAfterIt) {
+    MatchingBook book;
+    book.add(make_order(1, Side::Buy, kAnchor, 1));
+
+    // A new best bid ten bands up. The band re-centres on it, which leaves
+    // the old level behind in the map instead of the new one.
+    const Price elsewhere = kAnchor + 10 * MatchingBook::kMaxBandTicks;
+    book.add(make_order(2, Side::Buy, elsewhere, 1));
+    EXPECT_EQ(book.rebase_counters().rebases, 1u);
+    EXPECT_EQ(book.rebase_counters().levels_migrated, 2u); // one out, one in
     EXPECT_EQ(book.out_of_band_levels(), 1u);
 
-    // With nothing resting at all, the old base has nothing to protect.
+    const auto all = book.all_bids();
+    ASSERT_EQ(all.size(), 2u);
+    EXPECT_EQ(all[0].exchange_order_id, 2u);
+    EXPECT_EQ(all[1].exchange_order_id, 1u);
+
+    // And it is the old level that is gone when cancelled.
     book.remove_front(Side::Buy);
-    ASSERT_FALSE(book.best_bid_price().has_value());
+    EXPECT_EQ(book.best_bid_price(), kAnchor);
+}
 
-    book.add(make_order(3, Side::Buy, elsewhere, 1));
-    EXPECT_EQ(book.out_of_band_levels(), 0u);
-    EXPECT_EQ(book.best_bid_price(), elsewhere);
+TEST(MatchingBook, ATouchInsideTheMiddleHalfOfTheBandLeavesItAlone) {
+    MatchingBook book;
+    book.add(make_order(1, Side::Sell, kAnchor, 1));
+    // A quarter band either way is the edge of where the ladder is content.
+    book.add(make_order(2, Side::Sell, kAnchor - kHalfBand / 2, 1));
+    book.add(make_order(3, Side::Sell, kAnchor + kHalfBand / 2, 1));
+    EXPECT_EQ(book.rebase_counters().rebases, 0u);
+
+    // One tick further and the touch is close enough to the edge to move.
+    // Centring on it puts the far end of the book just out of reach.
+    book.add(make_order(4, Side::Sell, kAnchor - kHalfBand / 2 - 1, 1));
+    EXPECT_EQ(book.rebase_counters().rebases, 1u);
+    EXPECT_EQ(book.out_of_band_levels(), 1u);
+    EXPECT_EQ(book.all_asks().back().exchange_order_id, 3u);
+}
+
+TEST(MatchingBook, ARebaseMovesABoundedNumberOfLevelsPerOperation) {
+    MatchingBook book;
+    constexpr Price kLevels = 100;
+    for (Price i = 0; i < kLevels; ++i) {
+        book.add(make_order(static_cast<ExchangeOrderId>(i + 1), Side::Buy, kAnchor - i, 1));
+    }
+    ASSERT_EQ(book.rebase_counters().rebases, 0u);
+
+    // Every one of those levels has to leave the ladder for the new touch,
+    // which is far more than one operation may move.
+    const Price elsewhere = kAnchor + 10 * MatchingBook::kMaxBandTicks;
+    ExchangeOrderId id = 1'000;
+    std::uint64_t migrated = 0;
+    std::size_t operations = 0;
+    do {
+        book.add(make_order(id++, Side::Buy, elsewhere, 1));
+        const std::uint64_t now = book.rebase_counters().levels_migrated;
+        EXPECT_LE(now - migrated, MatchingBook::kRebaseLevelsPerStep);
+        migrated = now;
+        ++operations;
+        // Whatever point the rebase has reached, the book reads the same.
+        ASSERT_EQ(book.best_bid_price(), elsewhere);
+        ASSERT_EQ(book.all_bids().size(), static_cast<std::size_t>(kLevels) + operations);
+    } while (book.out_of_band_levels() < static_cast<std::size_t>(kLevels) && operations < 1'000);
+
+    EXPECT_EQ(book.out_of_band_levels(), static_cast<std::size_t>(kLevels));
+    EXPECT_GT(operations, 1u) << "the whole rebase ran inside one operation";
+    EXPECT_EQ(book.rebase_counters().rebases, 1u);
+    EXPECT_EQ(book.all_bids().back().exchange_order_id, static_cast<ExchangeOrderId>(kLevels));
+}
+
+TEST(MatchingBook, ADriftingBookStaysInItsLadder) {
+    // A bid book that keeps a hundred levels and walks upwards one tick per
+    // order, far past its first band: the oldest level is cancelled as each
+    // new one arrives, as a trending market's would be. Nothing is left
+    // behind, so the band should carry every level with it.
+    MatchingBook book;
+    std::vector<MatchingBook::Handle> handles;
+    const Price distance = 5 * MatchingBook::kMaxBandTicks;
+    for (Price step = 0; step < distance; ++step) {
+        handles.push_back(book.add(make_order(static_cast<ExchangeOrderId>(step + 1), Side::Buy, kAnchor + step, 1)));
+        if (handles.size() > 100) {
+            book.remove_at(handles[handles.size() - 101]);
+        }
+        ASSERT_EQ(book.out_of_band_levels(), 0u) << "at step " << step;
+    }
+    EXPECT_GE(book.rebase_counters().rebases, 10u);
+    EXPECT_EQ(book.best_bid_price(), kAnchor + distance - 1);
 }
 
 TEST(MatchingBook, ABookWithNoLadderBehavesTheSameOnTheMapAlone) {
@@ -363,6 +571,125 @@ TEST(MatchingBook, ABookWithNoLadderBehavesTheSameOnTheMapAlone) {
     EXPECT_EQ(all[2].exchange_order_id, 3u);
 }
 
+// ── Ladders drawn from a shared budget ─────────────────────────────────────
+
+// What a ladder of `band` ticks costs one side: a LevelSlot per tick.
+constexpr std::size_t ladder_bytes(std::uint32_t band) { return std::size_t{band} * 24; }
+
+TEST(MatchingBook, ALadderIsAllocatedOnItsSidesFirstOrderAndNotBefore) {
+    LadderBudget budget{.byte_limit = ladder_bytes(MatchingBook::kMaxBandTicks) * 4};
+    MatchingBook book(/*expected_resting_orders=*/0, MatchingBook::kMinBandTicks, &budget);
+    EXPECT_FALSE(book.has_ladder());
+    EXPECT_EQ(budget.bytes_in_use, 0u);
+
+    book.add(make_order(1, Side::Buy, kAnchor, 1));
+    EXPECT_TRUE(book.has_ladder());
+    EXPECT_EQ(book.ladder_band_ticks(), MatchingBook::kMinBandTicks);
+    EXPECT_EQ(budget.bytes_in_use, ladder_bytes(MatchingBook::kMinBandTicks)) << "only the side that was used";
+
+    book.add(make_order(2, Side::Sell, kAnchor + 1, 1));
+    EXPECT_EQ(budget.bytes_in_use, 2 * ladder_bytes(MatchingBook::kMinBandTicks));
+    EXPECT_EQ(budget.materialised, 2u);
+    EXPECT_EQ(book.out_of_band_levels(), 0u);
+}
+
+TEST(MatchingBook, ReleasingLaddersKeepsEveryOrderAndGivesTheBytesBack) {
+    LadderBudget budget{.byte_limit = ladder_bytes(MatchingBook::kMaxBandTicks) * 4};
+    MatchingBook book(/*expected_resting_orders=*/0, MatchingBook::kMinBandTicks, &budget);
+    // Two in band and one past the edge on the bid side, one ask.
+    book.add(make_order(1, Side::Buy, kAnchor, 5));
+    book.add(make_order(2, Side::Buy, kAnchor - 10, 6));
+    book.add(make_order(3, Side::Buy, kAnchor - MatchingBook::kMinBandTicks, 7));
+    const auto ask = book.add(make_order(4, Side::Sell, kAnchor + 5, 8));
+    ASSERT_EQ(book.out_of_band_levels(), 1u);
+    const auto bids = book.all_bids();
+
+    book.release_ladders();
+    EXPECT_FALSE(book.has_ladder());
+    EXPECT_EQ(budget.bytes_in_use, 0u);
+    EXPECT_EQ(budget.reclaimed, 2u);
+    // Every level is in the map now, and nothing else about the book moved.
+    EXPECT_EQ(book.out_of_band_levels(), 4u);
+    const auto after = book.all_bids();
+    ASSERT_EQ(after.size(), bids.size());
+    for (std::size_t i = 0; i < bids.size(); ++i) {
+        EXPECT_EQ(after[i].exchange_order_id, bids[i].exchange_order_id);
+        EXPECT_EQ(after[i].remaining_quantity, bids[i].remaining_quantity);
+    }
+    EXPECT_EQ(book.best_ask_price(), kAnchor + 5);
+    EXPECT_EQ(book.crossable_quantity(Side::Buy, kAnchor - 10, 1'000), 11u);
+    EXPECT_EQ(book.at(ask).remaining_quantity, 8u);
+
+    // The next order brings the ladder back, centred on the best level and
+    // holding every level it covers.
+    book.add(make_order(5, Side::Buy, kAnchor - 1, 9));
+    EXPECT_TRUE(book.has_ladder());
+    EXPECT_EQ(book.out_of_band_levels(), 2u) << "the far bid, and the ask whose side is still without one";
+    EXPECT_EQ(book.all_bids().size(), 4u);
+    EXPECT_EQ(book.best_bid_price(), kAnchor);
+    book.remove_at(ask);
+    EXPECT_FALSE(book.best_ask_price().has_value());
+}
+
+TEST(MatchingBook, ASpentBudgetLeavesTheNextBookOnTheMapUntilItHasRoom) {
+    LadderBudget budget{.byte_limit = ladder_bytes(MatchingBook::kMinBandTicks)};
+    MatchingBook first(/*expected_resting_orders=*/0, MatchingBook::kMinBandTicks, &budget);
+    MatchingBook second(/*expected_resting_orders=*/0, MatchingBook::kMinBandTicks, &budget);
+
+    first.add(make_order(1, Side::Buy, kAnchor, 1));
+    second.add(make_order(2, Side::Buy, kAnchor, 1));
+    second.add(make_order(3, Side::Buy, kAnchor - 1, 1));
+    EXPECT_TRUE(first.has_ladder());
+    EXPECT_FALSE(second.has_ladder());
+    EXPECT_EQ(budget.refusals, 2u);
+    EXPECT_EQ(second.out_of_band_levels(), 2u);
+    EXPECT_EQ(second.best_bid_price(), kAnchor);
+
+    first.release_ladders();
+    second.add(make_order(4, Side::Buy, kAnchor - 2, 1));
+    EXPECT_TRUE(second.has_ladder());
+    EXPECT_EQ(second.out_of_band_levels(), 0u) << "the levels that rested without a ladder moved into it";
+    EXPECT_EQ(budget.bytes_in_use, ladder_bytes(MatchingBook::kMinBandTicks));
+}
+
+TEST(MatchingBook, AShortBudgetGivesANarrowerBandRatherThanNone) {
+    LadderBudget budget{.byte_limit = ladder_bytes(3 * MatchingBook::kMinBandTicks)};
+    MatchingBook book(/*expected_resting_orders=*/0, 4 * MatchingBook::kMinBandTicks, &budget);
+    book.add(make_order(1, Side::Buy, kAnchor, 1));
+    // Bands are powers of two, so three bands' worth buys two.
+    EXPECT_EQ(book.ladder_band_ticks(), 2 * MatchingBook::kMinBandTicks);
+    EXPECT_EQ(budget.bytes_in_use, ladder_bytes(2 * MatchingBook::kMinBandTicks));
+}
+
+TEST(MatchingBook, ASideThatSpillsPastItsBandWidensIntoTheBudget) {
+    LadderBudget budget{.byte_limit = ladder_bytes(MatchingBook::kMaxBandTicks) * 2};
+    MatchingBook book(/*expected_resting_orders=*/0, MatchingBook::kMinBandTicks, &budget);
+    constexpr Price kHalf = MatchingBook::kMinBandTicks / 2;
+    book.add(make_order(1, Side::Buy, kAnchor, 1));
+    book.add(make_order(2, Side::Buy, kAnchor - kHalf - 100, 1)); // below the band
+    ASSERT_EQ(book.out_of_band_levels(), 1u);
+
+    // A new touch near the top of the band has to re-centre it, and the
+    // level already spilled off the bottom says the band is too narrow for
+    // where this side trades.
+    book.add(make_order(3, Side::Buy, kAnchor + kHalf - 200, 1));
+    EXPECT_EQ(budget.widened, 1u);
+    EXPECT_EQ(book.ladder_band_ticks(), 2 * MatchingBook::kMinBandTicks);
+    EXPECT_EQ(book.out_of_band_levels(), 0u);
+    EXPECT_EQ(budget.bytes_in_use, ladder_bytes(2 * MatchingBook::kMinBandTicks));
+
+    const auto all = book.all_bids();
+    ASSERT_EQ(all.size(), 3u);
+    EXPECT_EQ(all[0].exchange_order_id, 3u);
+    EXPECT_EQ(all[1].exchange_order_id, 1u);
+    EXPECT_EQ(all[2].exchange_order_id, 2u);
+
+    // Going quiet puts the side back where it started.
+    book.release_ladders();
+    book.add(make_order(4, Side::Buy, kAnchor, 1));
+    EXPECT_EQ(book.ladder_band_ticks(), MatchingBook::kMinBandTicks);
+}
+
 TEST(MatchingBook, BandNarrowsWithTheInstrumentCountAndThenStops) {
     constexpr std::size_t kBudget = MatchingEngine::kLadderByteBudget;
     // A universe of one gets the widest band the book will index, not the
@@ -379,5 +706,71 @@ TEST(MatchingBook, BandNarrowsWithTheInstrumentCountAndThenStops) {
     EXPECT_EQ(MatchingBook::band_for(100, kBudget), 4'096u);
 }
 
+// ── State digest ───────────────────────────────────────────────────────────
+
+// The digest a book should have: every order it holds, summed from scratch.
+std::uint64_t recomputed_digest(const MatchingBook& book) {
+    std::uint64_t digest = 0;
+    for (const BookOrder& order : book.all_bids()) {
+        digest += order_digest(order);
+    }
+    for (const BookOrder& order : book.all_asks()) {
+        digest += order_digest(order);
+    }
+    return digest;
+}
+
+TEST(MatchingBook, StateDigestFollowsEveryKindOfChange) {
+    MatchingBook book;
+    EXPECT_EQ(book.state_digest(), 0u);
+
+    const auto bid = book.add(make_order(1, Side::Buy, 100, 10, /*client_order_id=*/1));
+    book.add(make_order(2, Side::Buy, 100, 20, /*client_order_id=*/2));
+    const auto ask = book.add(make_order(3, Side::Sell, 105, 30, /*client_order_id=*/3));
+    book.add(make_order(4, Side::Sell, 106, 40, /*client_order_id=*/4));
+    EXPECT_EQ(book.state_digest(), recomputed_digest(book));
+
+    book.reduce_at(bid, 4);
+    EXPECT_EQ(book.state_digest(), recomputed_digest(book));
+    book.set_client_order_id_at(bid, 11);
+    EXPECT_EQ(book.state_digest(), recomputed_digest(book));
+    book.reduce_front(Side::Sell, 7);
+    EXPECT_EQ(book.state_digest(), recomputed_digest(book));
+    book.remove_front(Side::Buy);
+    EXPECT_EQ(book.state_digest(), recomputed_digest(book));
+    book.remove_at(ask);
+    EXPECT_EQ(book.state_digest(), recomputed_digest(book));
+
+    book.remove_front(Side::Buy);
+    book.remove_front(Side::Sell);
+    EXPECT_EQ(book.state_digest(), 0u) << "an empty book hashes like a new one";
+}
+
+// The digest describes the orders, not the book's history: the ladder
+// moving, or being released, does not touch it, and two books that reach
+// the same orders by different routes agree.
+TEST(MatchingBook, StateDigestDependsOnlyOnTheOrdersHeld) {
+    LadderBudget budget{.byte_limit = std::size_t{1} << 20U};
+    MatchingBook direct(0, MatchingBook::kMinBandTicks, &budget);
+    MatchingBook roundabout(0, MatchingBook::kMinBandTicks, &budget);
+
+    direct.add(make_order(1, Side::Buy, 1'000, 5));
+    direct.add(make_order(9, Side::Sell, 1'010, 5));
+
+    roundabout.add(make_order(1, Side::Buy, 1'000, 8));
+    roundabout.add(make_order(2, Side::Buy, 1'000 + 3 * MatchingBook::kMinBandTicks, 1)); // drags the ladder up
+    roundabout.add(make_order(9, Side::Sell, 1'010, 5));
+    roundabout.remove_front(Side::Buy);
+    roundabout.reduce_front(Side::Buy, 5);
+    roundabout.release_ladders();
+
+    EXPECT_EQ(roundabout.all_bids(), direct.all_bids());
+    EXPECT_EQ(roundabout.state_digest(), direct.state_digest());
+
+    // And one field apart is a different digest.
+    roundabout.reduce_front(Side::Sell, 4);
+    EXPECT_NE(roundabout.state_digest(), direct.state_digest());
+}
+
 } // namespace
 } // namespace mdh::exchange
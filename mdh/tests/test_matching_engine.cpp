@@ -1,9 +1,12 @@
 #include <gtest/gtest.h>
 
+#include <type_traits>
+#include <utility>
 #include <variant>
 #include <vector>
 
 #include "exchange/matching/matching_engine.hpp"
+#include "exchange/persistence/state_hash.hpp"
 
 namespace mdh::exchange {
 namespace {
@@ -680,5 +683,283 @@ TEST(MatchingEngine, AnInstrumentRegisteredAfterTheFactAcceptsOrders) {
     EXPECT_TRUE(holds<BookOrderAdded>(accepted.events[1]));
 }
 
+// ── Incremental snapshots ──────────────────────────────────────────────────
+
+TEST(MatchingEngine, SnapshotChangesReportsOnlyTheBooksThatChanged) {
+    MatchingEngine engine{1, 2, 3};
+    CollectingSink out;
+    const auto on = [](NewOrderCommand order, InstrumentId instrument_id) {
+        order.instrument_id = instrument_id;
+        return order;
+    };
+    engine.process(on(new_order(1, 100, 1, Side::Buy, 100, 5), 1), out.sink());
+    engine.process(on(new_order(2, 100, 2, Side::Sell, 200, 5), 3), out.sink());
+    EXPECT_TRUE(engine.has_snapshot_changes());
+
+    const EngineStateChanges first = engine.snapshot_changes();
+    EXPECT_EQ(first.epoch, 1u);
+    EXPECT_EQ(first.commands, 2u);
+    ASSERT_EQ(first.books.size(), 2u);
+    EXPECT_EQ(first.books[0].instrument_id, 1u);
+    EXPECT_EQ(first.books[1].instrument_id, 3u);
+    EXPECT_FALSE(engine.has_snapshot_changes());
+
+    // A rejected order changes no book, so there is nothing to report.
+    engine.process(on(new_order(3, 100, 1, Side::Buy, 100, 5), 3), out.sink());
+    EXPECT_FALSE(engine.has_snapshot_changes()) << "a duplicate client order id rests nothing";
+
+    // Emptying a book reports it with both sides empty, which is how the
+    // change says the instrument is gone.
+    auto cancel = cancel_order(4, 100, 2);
+    cancel.instrument_id = 3;
+    engine.process(cancel, out.sink());
+    const EngineStateChanges second = engine.snapshot_changes();
+    EXPECT_EQ(second.epoch, 2u);
+    ASSERT_EQ(second.books.size(), 1u);
+    EXPECT_EQ(second.books[0].instrument_id, 3u);
+    EXPECT_TRUE(second.books[0].bids.empty());
+    EXPECT_TRUE(second.books[0].asks.empty());
+
+    EngineStateSnapshot image;
+    apply_changes(image, first);
+    apply_changes(image, second);
+    EXPECT_EQ(image, engine.snapshot());
+}
+
+TEST(MatchingEngine, ApplyingEveryRoundOfChangesRebuildsTheFullSnapshot) {
+    const std::vector<InstrumentId> universe{1, 2, 3, 4, 5, 6, 7, 8};
+    MatchingEngine engine(universe);
+    CollectingSink out;
+    EngineStateSnapshot image;
+
+    // A deterministic mix of resting, crossing and cancelling across the
+    // universe, with a capture every few commands so that some rounds
+    // touch one book, some several and some none.
+    std::uint64_t state = 0x5EED;
+    const auto next = [&state](std::uint64_t bound) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return (state >> 33U) % bound;
+    };
+    std::vector<std::pair<InstrumentId, ClientOrderId>> live;
+    CommandSequence sequence = 1;
+    for (ClientOrderId client_order_id = 1; client_order_id <= 3'000; ++client_order_id) {
+        if (!live.empty() && next(3) == 0) {
+            const std::size_t at = next(live.size());
+            auto cancel = cancel_order(sequence++, 100, live[at].second);
+            cancel.instrument_id = live[at].first;
+            engine.process(cancel, out.sink());
+            live[at] = live.back();
+            live.pop_back();
+        } else {
+            auto order = new_order(sequence++, 100, client_order_id, next(2) == 0 ? Side::Buy : Side::Sell,
+                                   100 + static_cast<Price>(next(20)), 1 + next(9));
+            order.instrument_id = universe[next(universe.size())];
+            engine.process(order, out.sink());
+            live.emplace_back(order.instrument_id, client_order_id);
+        }
+        if (next(7) == 0) {
+            apply_changes(image, engine.snapshot_changes());
+            ASSERT_EQ(image, engine.snapshot()) << "after command " << sequence - 1;
+        }
+    }
+    apply_changes(image, engine.snapshot_changes());
+    EXPECT_EQ(image, engine.snapshot());
+}
+
+// ── Rolling state hash ─────────────────────────────────────────────────────
+
+// The hash the engine keeps as it goes must be the one a snapshot taken at
+// the same point works out from scratch, after every command -- fills,
+// partial fills, both kinds of replace, cancels and rejections included.
+TEST(MatchingEngine, StateHashMatchesTheSnapshotAfterEveryCommand) {
+    const std::vector<InstrumentId> universe{1, 2, 3, 4};
+    MatchingEngine engine(universe);
+    MatchingEngine twin(universe);
+    CollectingSink out;
+    EXPECT_EQ(engine.state_hash(), 0u);
+
+    std::uint64_t state = 0xC0FFEE;
+    const auto next = [&state](std::uint64_t bound) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return (state >> 33U) % bound;
+    };
+    std::vector<std::pair<InstrumentId, ClientOrderId>> sent;
+    ClientOrderId next_client_order_id = 1;
+    for (CommandSequence sequence = 1; sequence <= 2'000; ++sequence) {
+        ExchangeCommand command;
+        const std::uint64_t roll = next(10);
+        if (roll < 5 || sent.empty()) {
+            auto order = new_order(sequence, 100 + next(3), next_client_order_id++,
+                                   next(2) == 0 ? Side::Buy : Side::Sell, 100 + static_cast<Price>(next(10)),
+                                   1 + next(9), next(8) == 0 ? TimeInForce::IOC : TimeInForce::GTC);
+            order.instrument_id = universe[next(universe.size())];
+            sent.emplace_back(order.instrument_id, order.client_order_id);
+            command = order;
+        } else {
+            // Aimed at something sent earlier, which may long since have
+            // traded away: the rejections are part of the stream too.
+            const auto [instrument_id, client_order_id] = sent[next(sent.size())];
+            const AccountId account = 100 + (client_order_id % 3 == 0 ? 0 : next(3));
+            if (roll < 7) {
+                auto cancel = cancel_order(sequence, account, client_order_id);
+                cancel.instrument_id = instrument_id;
+                command = cancel;
+            } else {
+                auto replace = replace_order(sequence, account, client_order_id, next_client_order_id++,
+                                             100 + static_cast<Price>(next(10)), 1 + next(9));
+                replace.instrument_id = instrument_id;
+                sent.emplace_back(instrument_id, replace.new_client_order_id);
+                command = replace;
+            }
+        }
+        engine.process(command, out.sink());
+        twin.process(command, out.sink());
+        ASSERT_EQ(engine.state_hash(), persistence::rolling_state_hash(engine.snapshot())) << "command " << sequence;
+        ASSERT_EQ(engine.state_hash(), twin.state_hash());
+        ASSERT_EQ(engine.commands_processed(), sequence);
+    }
+    EXPECT_NE(engine.state_hash(), 0u);
+}
+
+TEST(MatchingEngine, StateHashTellsApartTheSameOrdersOnDifferentInstruments) {
+    MatchingEngine first{1, 2};
+    MatchingEngine second{1, 2};
+    CollectingSink out;
+    auto on_one = new_order(1, 100, 1, Side::Buy, 100, 5);
+    on_one.instrument_id = 1;
+    auto on_two = on_one;
+    on_two.instrument_id = 2;
+    first.process(on_one, out.sink());
+    second.process(on_two, out.sink());
+    EXPECT_NE(first.state_hash(), second.state_hash());
+}
+
+// ── Ladder budget ──────────────────────────────────────────────────────────
+
+TEST(MatchingEngine, AnIdleInstrumentGivesItsLadderBackAndKeepsItsOrders) {
+    constexpr InstrumentId kQuiet = 1;
+    constexpr InstrumentId kBusy = 2;
+    MatchingEngine engine({kQuiet, kBusy}, MatchingEngine::kDefaultExpectedRestingOrders, {},
+                          LadderPolicy{.idle_commands = 16});
+    EXPECT_EQ(engine.ladder_budget().bytes_in_use, 0u) << "nothing is allocated for an instrument until it trades";
+
+    CollectingSink out;
+    engine.process(new_order(1, 100, 1, Side::Buy, 100, 5), out.sink());
+    EXPECT_EQ(engine.ladder_budget().materialised, 1u);
+    const std::size_t one_ladder = engine.ladder_budget().bytes_in_use;
+    EXPECT_GT(one_ladder, 0u);
+
+    // Traffic on another instrument only. Each command advances the idle
+    // clock; a few dozen is well past the threshold.
+    CommandSequence sequence = 2;
+    for (ClientOrderId client_order_id = 1; client_order_id <= 40; ++client_order_id) {
+        auto order = new_order(sequence++, 200, client_order_id, Side::Sell, 300, 1);
+        order.instrument_id = kBusy;
+        engine.process(order, out.sink());
+        auto cancel = cancel_order(sequence++, 200, client_order_id);
+        cancel.instrument_id = kBusy;
+        engine.process(cancel, out.sink());
+    }
+    EXPECT_EQ(engine.ladder_budget().reclaimed, 1u);
+    EXPECT_EQ(engine.ladder_budget().bytes_in_use, one_ladder) << "the busy instrument's ladder, and only that";
+
+    // The quiet instrument's order is where it was: still cancellable, and
+    // still matchable by what arrives next.
+    CollectingSink fill;
+    engine.process(new_order(sequence++, 300, 1, Side::Sell, 100, 2), fill.sink());
+    ASSERT_EQ(fill.events.size(), 3u);
+    EXPECT_EQ(fill.at<TradeExecuted>(1).quantity, 2u);
+    CollectingSink cancelled;
+    engine.process(cancel_order(sequence++, 100, 1), cancelled.sink());
+    ASSERT_EQ(cancelled.events.size(), 2u);
+    EXPECT_TRUE(holds<OrderCancelled>(cancelled.events[0]));
+    EXPECT_EQ(cancelled.at<BookOrderRemoved>(1).price, 100);
+}
+
+// ── process_batch ──────────────────────────────────────────────────────────
+
+TEST(MatchingEngine, ProcessBatchDelimitsEachCommandsEvents) {
+    MatchingEngine engine{kInstrument};
+    const std::vector<ExchangeCommand> commands{
+        new_order(1, 100, 1, Side::Sell, 100, 5),
+        new_order(2, 200, 1, Side::Buy, 100, 5),
+        cancel_order(3, 100, 1), // already filled
+    };
+
+    EventBuffer buffer;
+    engine.process_batch(commands, buffer);
+
+    ASSERT_EQ(buffer.command_count(), 3u);
+    ASSERT_EQ(buffer.events_of(0).size(), 2u);
+    EXPECT_TRUE(holds<BookOrderAdded>(buffer.events_of(0)[1]));
+    ASSERT_EQ(buffer.events_of(1).size(), 3u);
+    EXPECT_TRUE(holds<TradeExecuted>(buffer.events_of(1)[1]));
+    EXPECT_TRUE(holds<BookOrderRemoved>(buffer.events_of(1)[2]));
+    ASSERT_EQ(buffer.events_of(2).size(), 1u);
+    EXPECT_EQ(std::get<OrderRejected>(buffer.events_of(2)[0]).reason, RejectReason::UnknownOrderId);
+
+    // One sequence across the whole batch, exactly as process() numbers it.
+    EventSequence expected = 1;
+    for (const ExchangeEvent& event : buffer.events()) {
+        EXPECT_EQ(std::visit([](const auto& ev) { return ev.event_sequence; }, event), expected++);
+    }
+}
+
+TEST(MatchingEngine, ProcessBatchAppendsAndAReusedBufferKeepsItsMemory) {
+    MatchingEngine engine{kInstrument};
+    EventBuffer buffer(/*expected_events=*/16, /*expected_commands=*/4);
+
+    const std::vector<ExchangeCommand> first{new_order(1, 100, 1, Side::Buy, 100, 5)};
+    const std::vector<ExchangeCommand> second{new_order(2, 100, 2, Side::Buy, 99, 5)};
+    engine.process_batch(first, buffer);
+    engine.process_batch(second, buffer);
+    EXPECT_EQ(buffer.command_count(), 2u);
+    EXPECT_EQ(buffer.size(), 4u);
+
+    const ExchangeEvent* arena = buffer.events().data();
+    buffer.clear();
+    EXPECT_TRUE(buffer.empty());
+    engine.process_batch(std::vector<ExchangeCommand>{cancel_order(3, 100, 1)}, buffer);
+    EXPECT_EQ(buffer.size(), 2u);
+    EXPECT_EQ(buffer.events().data(), arena);
+}
+
+// ── Typed sinks ────────────────────────────────────────────────────────────
+
+// A sink the engine knows the type of is called with each event's own
+// struct -- no variant built at the call -- and sees exactly the stream an
+// EventSink would.
+TEST(MatchingEngine, ATypedSinkSeesConcreteEventsAndTheSameStreamAsAnEventSink) {
+    const std::vector<ExchangeCommand> commands{
+        new_order(1, 100, 1, Side::Sell, 100, 5),
+        new_order(2, 100, 2, Side::Sell, 101, 5),
+        new_order(3, 200, 1, Side::Buy, 101, 7),
+        cancel_order(4, 100, 2),
+    };
+
+    MatchingEngine erased{kInstrument};
+    CollectingSink expected;
+    for (const auto& command : commands) {
+        erased.process(command, expected.sink());
+    }
+
+    MatchingEngine typed{kInstrument};
+    std::vector<ExchangeEvent> actual;
+    std::size_t trades = 0;
+    const auto sink = [&](const auto& event) {
+        if constexpr (std::is_same_v<std::decay_t<decltype(event)>, TradeExecuted>) {
+            ++trades;
+        }
+        actual.emplace_back(event);
+    };
+    for (const auto& command : commands) {
+        typed.process(command, sink);
+    }
+
+    EXPECT_EQ(actual, expected.events);
+    EXPECT_EQ(trades, 2u);
+    EXPECT_EQ(typed.snapshot(), erased.snapshot());
+}
+
 } // namespace
 } // namespace mdh::exchange
@@ -56,11 +56,13 @@
 #include <gtest/gtest.h>
 
 #include <algorithm>
+#include <array>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <map>
 #include <optional>
+#include <span>
 #include <unordered_map>
 #include <utility>
 #include <variant>
@@ -182,7 +184,20 @@ public:
             absorb(command, event, outcome);
         }
 
-        std::visit([&](const auto& cmd) { check_command(cmd, events, outcome); }, command);
+        // The generated workloads never quote, mass-cancel, tick the clock
+        // or change a book's phase, so there is no per-command rule here for
+        // any of them: their events are many orders' at once, and
+        // test_mass_quote.cpp, test_mass_cancel.cpp, test_order_expiry.cpp
+        // and test_call_auction.cpp check them on their own.
+        std::visit(
+            [&](const auto& cmd) {
+                using T = std::decay_t<decltype(cmd)>;
+                if constexpr (!std::is_same_v<T, MassQuoteCommand> && !std::is_same_v<T, MassCancelCommand> &&
+                              !std::is_same_v<T, ClockTickCommand> && !std::is_same_v<T, TradingPhaseCommand>) {
+                    check_command(cmd, events, outcome);
+                }
+            },
+            command);
     }
 
     // Full cross-check of the harness's model against the engine's own
@@ -235,6 +250,9 @@ private:
                 using T = std::decay_t<decltype(cmd)>;
                 if constexpr (std::is_same_v<T, ReplaceOrderCommand>) {
                     return cmd.new_client_order_id;
+                } else if constexpr (std::is_same_v<T, MassQuoteCommand> || std::is_same_v<T, MassCancelCommand> ||
+                                     std::is_same_v<T, ClockTickCommand> || std::is_same_v<T, TradingPhaseCommand>) {
+                    return 0; // never generated; see on_command()
                 } else {
                     return cmd.client_order_id;
                 }
@@ -242,6 +260,19 @@ private:
             command);
     }
 
+    static AccountId owner_account_id(const ExchangeCommand& command) {
+        return std::visit(
+            [](const auto& cmd) -> AccountId {
+                using T = std::decay_t<decltype(cmd)>;
+                if constexpr (std::is_same_v<T, ClockTickCommand> || std::is_same_v<T, TradingPhaseCommand>) {
+                    return 0; // never generated; see on_command()
+                } else {
+                    return cmd.account_id;
+                }
+            },
+            command);
+    }
+
     void absorb(const ExchangeCommand& command, const ExchangeEvent& event, Outcome& outcome) {
         std::visit(
             [&](const auto& ev) {
@@ -282,8 +313,7 @@ private:
                     EXPECT_FALSE(live_.contains(ev.exchange_order_id))
                         << "two live orders must never share an exchange_order_id";
                     live_[ev.exchange_order_id] =
-                        ShadowOrder{owner_client_order_id(command),
-                                    std::visit([](const auto& cmd) { return cmd.account_id; }, command),
+                        ShadowOrder{owner_client_order_id(command), owner_account_id(command),
                                     ev.instrument_id, ev.side, ev.price, ev.quantity};
                 } else if constexpr (std::is_same_v<T, BookOrderReduced>) {
                     auto it = live_.find(ev.exchange_order_id);
@@ -362,13 +392,17 @@ private:
                 EXPECT_FALSE(outcome.added) << "IOC must never rest";
                 break;
             case TimeInForce::GTC:
+            case TimeInForce::GTD:
+                // A GTD order rests exactly as a GTC one does; only a later
+                // ClockTickCommand tells them apart, and the harness never
+                // generates one (see on_command()).
                 if (outcome.aggressor_filled < cmd.quantity) {
-                    EXPECT_TRUE(outcome.added) << "a GTC remainder must rest on the book";
+                    EXPECT_TRUE(outcome.added) << "a GTC or GTD remainder must rest on the book";
                     EXPECT_EQ(outcome.added_quantity, cmd.quantity - outcome.aggressor_filled);
                     EXPECT_EQ(outcome.added_price, cmd.price);
                     EXPECT_EQ(outcome.added_side, cmd.side);
                 } else {
-                    EXPECT_FALSE(outcome.added) << "a fully filled GTC order has no remainder to rest";
+                    EXPECT_FALSE(outcome.added) << "a fully filled GTC or GTD order has no remainder to rest";
                 }
                 break;
         }
@@ -554,6 +588,102 @@ TEST(MatchingEngineStress, ReplayingTheSameCommandsProducesIdenticalEventsAndSta
     EXPECT_FALSE(first.second.instruments.empty()) << "the replay left nothing resting -- this asserts nothing";
 }
 
+// process_batch() shares process()'s matching code but not its delivery, so
+// what is checked is that the delivery change is invisible: the same events
+// in the same order with the same sequence numbers, split per command where
+// the sink would have seen each command begin. Batches are deliberately
+// uneven and the buffer is reused across them, which is how a caller keeps
+// it allocation-free.
+TEST(MatchingEngineStress, BatchedEmissionMatchesPerEventDeliveryExactly) {
+    mt::WorkloadConfig config;
+    config.seed = 0x2468ACE013579BDFULL;
+    config.operation_count = stress_operations(/*optimised=*/200'000, /*debug=*/20'000);
+    config.instrument_count = 3;
+    config.initial_orders_per_side = 300;
+    config.stale_reference_pct = 10;
+    const auto workload = mt::generate_workload(config);
+
+    MatchingEngine per_event(workload.config.instruments());
+    std::vector<ExchangeEvent> expected;
+    std::vector<std::size_t> expected_per_command;
+    const EventSink sink = [&expected](const ExchangeEvent& event) { expected.push_back(event); };
+
+    MatchingEngine batched(workload.config.instruments());
+    std::vector<ExchangeEvent> actual;
+    EventBuffer buffer;
+
+    std::size_t command_index = 0;
+    for (const auto* phase : {&workload.seed, &workload.operations}) {
+        for (const ExchangeCommand& command : *phase) {
+            const std::size_t before = expected.size();
+            per_event.process(command, sink);
+            expected_per_command.push_back(expected.size() - before);
+        }
+
+        const std::span<const ExchangeCommand> commands(*phase);
+        for (std::size_t offset = 0, batch = 1; offset < commands.size(); offset += batch, batch = batch * 3 % 97 + 1) {
+            const auto chunk = commands.subspan(offset, std::min(batch, commands.size() - offset));
+            buffer.clear();
+            batched.process_batch(chunk, buffer);
+            ASSERT_EQ(buffer.command_count(), chunk.size());
+            for (std::size_t i = 0; i < chunk.size(); ++i) {
+                ASSERT_EQ(buffer.events_of(i).size(), expected_per_command[command_index++]);
+            }
+            actual.insert(actual.end(), buffer.events().begin(), buffer.events().end());
+        }
+    }
+
+    ASSERT_EQ(actual.size(), expected.size());
+    EXPECT_TRUE(actual == expected) << "batched emission diverged from per-event delivery";
+    EXPECT_TRUE(batched.snapshot() == per_event.snapshot());
+}
+
+// ── A trending market ─────────────────────────────────────────────────────
+
+TEST(MatchingEngineStress, ADriftingMarketKeepsItsBooksInTheLadder) {
+    // Every mid walking up a tick per twenty operations: over the run each
+    // touch travels well past the band it first anchored in. Without
+    // re-centering every level created after the first half-band of drift
+    // would land in the map; with it, only what the market leaves behind
+    // far from the touch should.
+    mt::WorkloadConfig config;
+    config.seed = 0x0D21F7ED0D21F7EDULL;
+    config.operation_count = stress_operations(/*optimised=*/600'000, /*debug=*/200'000);
+    config.instrument_count = 2;
+    config.initial_orders_per_side = 500;
+    config.drift_ticks_per_thousand_operations = 50;
+    config.mix = mt::WorkloadMix::trending();
+    const auto workload = mt::generate_workload(config);
+
+    MatchingEngine engine(config.instruments());
+    mt::replay(engine, workload.seed, mt::discard_events());
+    std::array<LevelDepth, 1> touch{};
+    ASSERT_EQ(engine.aggregated_depth(1, Side::Buy, touch), 1U);
+    const Price start = touch[0].price;
+
+    std::size_t worst = 0;
+    std::size_t index = 0;
+    for (const auto& command : workload.operations) {
+        engine.process(command, mt::discard_events());
+        if (++index % 1'000 == 0) {
+            worst = std::max(worst, engine.out_of_band_levels());
+        }
+    }
+    ASSERT_EQ(engine.aggregated_depth(1, Side::Buy, touch), 1U);
+    const Price travelled = touch[0].price - start;
+
+    std::printf("[ drift     ] touch moved %lld ticks; %llu rebases, %llu levels migrated; at most %zu of %zu "
+                "levels out of band\n",
+                static_cast<long long>(travelled),
+                static_cast<unsigned long long>(engine.ladder_rebase_counters().rebases),
+                static_cast<unsigned long long>(engine.ladder_rebase_counters().levels_migrated), worst,
+                workload.bid_levels_at_end + workload.ask_levels_at_end);
+    ASSERT_GT(travelled, static_cast<Price>(engine.ladder_band_ticks()))
+        << "the market never left its first band -- this asserts nothing";
+    EXPECT_GT(engine.ladder_rebase_counters().rebases, 0U);
+    EXPECT_LE(worst, 16U);
+}
+
 // ── MatchingBook against an independent reference model ────────────────────
 
 // Empty price levels are invisible through MatchingEngine::snapshot() but
@@ -567,7 +697,10 @@ TEST(MatchingEngineStress, ReplayingTheSameCommandsProducesIdenticalEventsAndSta
 // whether they land in the ladder or in the out-of-band map: a spread inside
 // `band_ticks` never leaves the ladder, while a wider one keeps both indexes
 // non-empty and makes every best-price and every walk a merge of the two.
-void check_price_level_lifecycle(Price spread, std::uint32_t band_ticks) {
+// `drift` moves the whole spread that many ticks per operation, so the
+// touch walks away from wherever the ladder first anchored and the band has
+// to re-centre to follow it, with levels left behind at every distance.
+void check_price_level_lifecycle(Price spread, std::uint32_t band_ticks, Price drift = 0) {
     const std::size_t operations = stress_operations(/*optimised=*/400'000, /*debug=*/40'000);
 
     MatchingBook book(/*expected_resting_orders=*/0, band_ticks);
@@ -629,6 +762,25 @@ void check_price_level_lifecycle(Price spread, std::uint32_t band_ticks) {
         }
         return flat;
     };
+    const auto aggregate = [](const auto& levels) {
+        std::vector<LevelDepth> depth;
+        for (const auto& [price, level] : levels) {
+            Quantity quantity = 0;
+            for (const BookOrder& order : level) {
+                quantity += order.remaining_quantity;
+            }
+            depth.push_back(LevelDepth{.price = price,
+                                       .quantity = quantity,
+                                       .order_count = static_cast<std::uint32_t>(level.size())});
+        }
+        return depth;
+    };
+    std::vector<LevelDepth> depth_buffer;
+    const auto book_depth = [&](Side side, std::size_t levels) {
+        depth_buffer.resize(levels + 1); // one spare: a book deeper than the model shows up as a size mismatch
+        depth_buffer.resize(book.depth(side, depth_buffer));
+        return depth_buffer;
+    };
 
     mt::SplitMix64 rng(0xFEEDFACECAFEB00BULL);
     ExchangeOrderId next_id = 1;
@@ -637,7 +789,8 @@ void check_price_level_lifecycle(Price spread, std::uint32_t band_ticks) {
         const auto choice = live_ids.empty() ? 0U : static_cast<unsigned>(rng.below(100));
         if (choice < 45) {
             const Side side = (rng.next() & 1U) != 0 ? Side::Buy : Side::Sell;
-            const auto price = static_cast<Price>(1'000 + rng.below(static_cast<std::uint64_t>(spread)));
+            const auto price = static_cast<Price>(1'000'000 + drift * static_cast<Price>(op) +
+                                                  static_cast<Price>(rng.below(static_cast<std::uint64_t>(spread))));
             const BookOrder order{
                 .exchange_order_id = next_id,
                 .client_order_id = next_id,
@@ -703,6 +856,10 @@ void check_price_level_lifecycle(Price spread, std::uint32_t band_ticks) {
         if (op % 512 == 0) {
             ASSERT_TRUE(book.all_bids() == flatten(reference_bids)) << "at operation " << op;
             ASSERT_TRUE(book.all_asks() == flatten(reference_asks)) << "at operation " << op;
+            ASSERT_TRUE(book_depth(Side::Buy, reference_bids.size()) == aggregate(reference_bids))
+                << "at operation " << op;
+            ASSERT_TRUE(book_depth(Side::Sell, reference_asks.size()) == aggregate(reference_asks))
+                << "at operation " << op;
         }
     }
 
@@ -720,6 +877,14 @@ TEST(MatchingBookStress, PriceLevelLifecycleMatchesReferenceModelAcrossTheBandEd
     check_price_level_lifecycle(/*spread=*/5 * MatchingBook::kMaxBandTicks, MatchingBook::kMaxBandTicks);
 }
 
+TEST(MatchingBookStress, PriceLevelLifecycleMatchesReferenceModelWhileTheLadderFollowsADrift) {
+    // Upwards, and then separately downwards, a tick every operation: each
+    // run crosses dozens of bands, so the ladder re-centres over and over with orders
+    // left resting on both sides of every edge it moves.
+    check_price_level_lifecycle(/*spread=*/1'024, MatchingBook::kMaxBandTicks, /*drift=*/1);
+    check_price_level_lifecycle(/*spread=*/1'024, MatchingBook::kMaxBandTicks, /*drift=*/-1);
+}
+
 TEST(MatchingBookStress, PriceLevelLifecycleMatchesReferenceModelWithNoLadder) {
     // What a universe too large to afford a ladder runs on.
     check_price_level_lifecycle(/*spread=*/1'024, /*band_ticks=*/0);
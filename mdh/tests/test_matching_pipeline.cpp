@@ -181,6 +181,29 @@ TEST(MatchingPipeline, SubmitRejectsWithoutDroppingWhenQueueIsFull) {
     EXPECT_EQ(pipeline.commands_processed(), static_cast<std::size_t>(accepted));
 }
 
+// A parked matching thread must be woken by each submit() and by stop(),
+// or this test would hang rather than fail: nothing else clears the flag it
+// sleeps on.
+TEST(MatchingPipeline, ParkedMatchingThreadWakesForEachSubmissionAndForStop) {
+    ThreadSafeCollectingSink out;
+    MatchingPipelineOptions options;
+    options.instruments = instruments_from_zero(3);
+    options.idle_wait = WaitPolicy::Park;
+    MatchingPipeline pipeline(out.sink(), options);
+
+    for (int i = 0; i < 3; ++i) {
+        // Idle again after the previous command: asleep once more.
+        ASSERT_TRUE(wait_until([&] { return pipeline.idle_parks() >= static_cast<std::size_t>(i) + 1; }));
+        ASSERT_TRUE(pipeline.submit(
+            new_order(100, static_cast<ClientOrderId>(i), static_cast<InstrumentId>(i), Side::Buy, 100, 1)));
+        ASSERT_TRUE(wait_until([&] { return pipeline.commands_processed() == static_cast<std::size_t>(i) + 1; }));
+    }
+
+    ASSERT_TRUE(wait_until([&] { return pipeline.idle_parks() >= 4; }));
+    pipeline.stop(); // returns only if the parked thread woke to see the stop
+    EXPECT_EQ(pipeline.commands_processed(), 3u);
+}
+
 TEST(MatchingPipeline, CustomProcessorIsInvokedInsteadOfBareEngine) {
     ThreadSafeCollectingSink out;
     std::atomic<int> processor_calls{0};
@@ -221,14 +244,43 @@ TEST(MatchingPipeline, CustomProcessorIsInvokedInsteadOfBareEngine) {
     EXPECT_TRUE(snapshot.instruments.empty());
 }
 
+// The templated form with a sink and no processor, neither of them a
+// std::function: the matching thread calls the engine, and the engine calls
+// the sink, directly.
+TEST(MatchingPipeline, TypedSinkAndDefaultProcessorNeedNoStdFunction) {
+    struct CountingSink {
+        std::size_t* accepted;
+        std::size_t* total;
+        void operator()(const ExchangeEvent& event) const {
+            *accepted += holds<OrderAccepted>(event) ? 1 : 0;
+            ++*total;
+        }
+    };
+    static_assert(ExchangeEventSink<CountingSink>);
+
+    // Read only after stop() has joined the matching thread.
+    std::size_t accepted = 0;
+    std::size_t total = 0;
+    BasicMatchingPipeline<CountingSink> pipeline(CountingSink{&accepted, &total},
+                                                 MatchingPipelineOptions{.instruments = {1}});
+    ASSERT_TRUE(pipeline.submit(new_order(100, 1, /*instrument=*/1, Side::Sell, 100, 10)));
+    ASSERT_TRUE(pipeline.submit(new_order(200, 1, /*instrument=*/1, Side::Buy, 100, 4)));
+    pipeline.stop();
+
+    EXPECT_EQ(accepted, 2u);
+    EXPECT_EQ(total, 5u); // Accepted + Added, then Accepted + Trade + Reduced
+    ASSERT_EQ(pipeline.snapshot().instruments.size(), 1u);
+    EXPECT_EQ(pipeline.snapshot().instruments[0].asks.at(0).remaining_quantity, 6u);
+}
+
 // ── Real concurrency ──────────────────────────────────────────────────────
 //
 // Everything above submits from the test's own (single) thread, which never
 // exercises the actual reason MatchingPipeline exists: a dedicated producer
-// thread racing a dedicated matching thread across the same SpscQueue this
+// thread racing a dedicated matching thread across the same queue this
 // class owns. Run under ThreadSanitizer (MDH_ENABLE_TSAN) to check the
 // memory-ordering claims in this class's own doc comment, the same way
-// SpscQueue's concurrent tests do (test_spsc_queue.cpp).
+// the queues' own concurrent tests do (test_mpsc_queue.cpp).
 TEST(MatchingPipeline, ConcurrentProducerThreadCommandsAllProcessedExactlyOnce) {
     ThreadSafeCollectingSink out;
     constexpr int kCount = 20'000;
@@ -293,4 +345,51 @@ TEST(MatchingPipeline, ConcurrentProducerThreadCommandsAllProcessedExactlyOnce)
     EXPECT_EQ(accepted_count, kCount);
 }
 
+// What the gateway does with one reader thread per connection: several
+// threads submitting at once with no lock of their own. The sequence
+// numbers are assigned on the matching thread, so they must still come out
+// gapless and in the order the matching thread saw the commands, and each
+// producer's own commands must keep the order it submitted them in.
+TEST(MatchingPipeline, ConcurrentProducersNeedNoLockAndGetGaplessPerProducerOrderedSequences) {
+    ThreadSafeCollectingSink out;
+    constexpr int kProducers = 4;
+    constexpr int kPerProducer = 2'000;
+    MatchingPipelineOptions options;
+    options.instruments = instruments_from_zero(1);
+    options.queue_capacity = 32;
+    MatchingPipeline pipeline(out.sink(), options);
+
+    {
+        std::vector<std::jthread> producers;
+        for (int p = 0; p < kProducers; ++p) {
+            producers.emplace_back([&pipeline, p] {
+                for (int i = 0; i < kPerProducer; ++i) {
+                    // One account per producer, bids at one price, so nothing
+                    // crosses and every command is accepted.
+                    while (!pipeline.submit(new_order(static_cast<AccountId>(100 + p), static_cast<ClientOrderId>(i),
+                                                      /*instrument=*/0, Side::Buy, 100, 1))) {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+    }
+    pipeline.stop();
+    ASSERT_EQ(pipeline.commands_processed(), static_cast<std::size_t>(kProducers * kPerProducer));
+
+    CommandSequence expected_sequence = 1;
+    std::vector<ClientOrderId> next_client_id(kProducers, 0);
+    for (const auto& ev : out.events()) {
+        if (!std::holds_alternative<OrderAccepted>(ev)) {
+            continue;
+        }
+        const auto& accepted = std::get<OrderAccepted>(ev);
+        ASSERT_EQ(accepted.command_sequence, expected_sequence++);
+        auto& next = next_client_id[static_cast<std::size_t>(accepted.account_id - 100)];
+        ASSERT_EQ(accepted.client_order_id, next);
+        ++next;
+    }
+    EXPECT_EQ(expected_sequence, static_cast<CommandSequence>(kProducers * kPerProducer) + 1);
+}
+
 } // namespace mdh::exchange::sequencing
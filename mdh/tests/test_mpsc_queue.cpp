@@ -0,0 +1,209 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "common/mpsc_queue.hpp"
+
+using namespace mdh;
+
+TEST(MpscQueue, CapacityRoundsUpToPowerOfTwo) {
+    EXPECT_EQ(MpscQueue<int>(0).capacity(), 2u); // one slot cannot tell filled from free; see the constructor
+    EXPECT_EQ(MpscQueue<int>(1).capacity(), 2u);
+    EXPECT_EQ(MpscQueue<int>(4).capacity(), 4u);
+    EXPECT_EQ(MpscQueue<int>(5).capacity(), 8u);
+}
+
+TEST(MpscQueue, TryPopReturnsNulloptWhenEmpty) {
+    MpscQueue<int> q(4);
+    EXPECT_FALSE(q.try_pop().has_value());
+}
+
+TEST(MpscQueue, TryPushFailsWhenFullThenSucceedsAfterPop) {
+    MpscQueue<int> q(4);
+    for (int i = 1; i <= 4; ++i) {
+        EXPECT_TRUE(q.try_push(i));
+    }
+    EXPECT_FALSE(q.try_push(5)); // one producer: the full check is exact, as SpscQueue's is
+    EXPECT_EQ(q.size(), 4u);
+
+    auto popped = q.try_pop();
+    ASSERT_TRUE(popped.has_value());
+    EXPECT_EQ(*popped, 1);
+    EXPECT_TRUE(q.try_push(5));
+}
+
+TEST(MpscQueue, FifoOrderAndHighWaterMarkAcrossWraparound) {
+    MpscQueue<int> q(4);
+    for (int cycle = 0; cycle < 10; ++cycle) {
+        ASSERT_TRUE(q.try_push(cycle * 10 + 1));
+        ASSERT_TRUE(q.try_push(cycle * 10 + 2));
+        ASSERT_TRUE(q.try_push(cycle * 10 + 3));
+        EXPECT_EQ(*q.try_pop(), cycle * 10 + 1);
+        EXPECT_EQ(*q.try_pop(), cycle * 10 + 2);
+        EXPECT_EQ(*q.try_pop(), cycle * 10 + 3);
+    }
+    EXPECT_EQ(q.size(), 0u);
+    EXPECT_EQ(q.high_water_mark(), 3u); // peak occupancy, not total pushes
+}
+
+TEST(MpscQueue, DestructorCleansUpElementsStillInQueue) {
+    auto tracker = std::make_shared<int>(42);
+    {
+        MpscQueue<std::shared_ptr<int>> q(4);
+        ASSERT_TRUE(q.try_push(tracker));
+        ASSERT_TRUE(q.try_push(tracker));
+        auto popped = q.try_pop(); // moves one out, so the destructor must skip its slot
+        EXPECT_EQ(tracker.use_count(), 3);
+    }
+    EXPECT_EQ(tracker.use_count(), 1);
+}
+
+TEST(MpscQueue, ConsumeStopsAtMaxAndReleasesEverySlotItTook) {
+    MpscQueue<std::unique_ptr<int>> q(4);
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < 4; ++i) {
+            ASSERT_TRUE(q.try_emplace(std::make_unique<int>(round * 4 + i)));
+        }
+        EXPECT_FALSE(q.try_push(nullptr));
+
+        std::vector<int> seen;
+        EXPECT_EQ(q.consume(3, [&seen](std::unique_ptr<int>& v) { seen.push_back(*v); }), 3u);
+        EXPECT_EQ(q.consume(3, [&seen](std::unique_ptr<int>& v) { seen.push_back(*v); }), 1u);
+        EXPECT_EQ(q.consume(3, [&seen](std::unique_ptr<int>&) { seen.push_back(-1); }), 0u);
+        EXPECT_EQ(seen, (std::vector<int>{round * 4, round * 4 + 1, round * 4 + 2, round * 4 + 3}));
+        EXPECT_EQ(q.size(), 0u);
+    }
+}
+
+// ── Real concurrency ──────────────────────────────────────────────────────
+//
+// The reason this queue exists: several producers claiming slots at once.
+// As with SpscQueue's concurrent tests, run under ThreadSanitizer
+// (MDH_ENABLE_TSAN) to check the slot sequences' acquire/release pairs. The
+// queue is small so producers keep racing each other for the last free
+// slots and losing the CAS, which is the path a single-threaded test cannot
+// reach.
+
+TEST(MpscQueue, ConcurrentProducersEachKeepTheirOwnOrderAndNothingIsLost) {
+    constexpr int kProducers = 4;
+    constexpr int kPerProducer = 50'000;
+    MpscQueue<std::unique_ptr<int>> q(16);
+
+    // Each value encodes its producer and that producer's running count, so
+    // the consumer can check per-producer order without any shared state.
+    std::vector<int> next_expected(kProducers, 0);
+    int consumed = 0;
+    {
+        std::vector<std::jthread> producers;
+        for (int p = 0; p < kProducers; ++p) {
+            producers.emplace_back([&q, p] {
+                for (int i = 0; i < kPerProducer; ++i) {
+                    while (!q.try_push(std::make_unique<int>(p * kPerProducer + i))) {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+        std::jthread consumer([&] {
+            while (consumed < kProducers * kPerProducer) {
+                if (auto v = q.try_pop()) {
+                    const int producer = **v / kPerProducer;
+                    EXPECT_EQ(**v % kPerProducer, next_expected[static_cast<std::size_t>(producer)]);
+                    ++next_expected[static_cast<std::size_t>(producer)];
+                    ++consumed;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    EXPECT_EQ(consumed, kProducers * kPerProducer);
+    for (const int count : next_expected) {
+        EXPECT_EQ(count, kPerProducer);
+    }
+    EXPECT_LE(q.high_water_mark(), q.capacity());
+}
+
+// Every accepted push is popped exactly once, and a rejected one leaves no
+// trace: producers here never retry, so accepted + rejected must account
+// for every attempt and the consumer must see exactly the accepted ones.
+TEST(MpscQueue, ConcurrentRejectionsAreExactlyTheValuesNeverPopped) {
+    constexpr int kProducers = 4;
+    constexpr int kAttempts = 50'000;
+    MpscQueue<int> q(8);
+
+    std::atomic<int> accepted{0};
+    std::atomic<bool> producers_done{false};
+    long long popped_sum = 0;
+    int popped = 0;
+    std::atomic<long long> accepted_sum{0};
+    {
+        std::jthread consumer([&] {
+            while (true) {
+                if (auto v = q.try_pop()) {
+                    popped_sum += *v;
+                    ++popped;
+                } else if (producers_done.load(std::memory_order_acquire) && q.size() == 0) {
+                    break;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+        {
+            std::vector<std::jthread> producers;
+            for (int p = 0; p < kProducers; ++p) {
+                producers.emplace_back([&, p] {
+                    for (int i = 0; i < kAttempts; ++i) {
+                        const int value = p * kAttempts + i;
+                        if (q.try_push(value)) {
+                            accepted.fetch_add(1, std::memory_order_relaxed);
+                            accepted_sum.fetch_add(value, std::memory_order_relaxed);
+                        }
+                    }
+                });
+            }
+        }
+        producers_done.store(true, std::memory_order_release);
+    }
+
+    EXPECT_GT(accepted.load(), 0);
+    EXPECT_EQ(popped, accepted.load());
+    EXPECT_EQ(popped_sum, accepted_sum.load());
+}
+
+// Producers racing for the last free slot of a queue nobody is draining:
+// exactly one gets it and every other push fails at once. A producer that
+// claimed a position before knowing it was free would wait here for a
+// consumer that never comes.
+TEST(MpscQueue, RacingForTheLastSlotOfAStalledQueueNeverWaits) {
+    constexpr int kProducers = 8;
+    for (int round = 0; round < 200; ++round) {
+        MpscQueue<int> q(4);
+        for (int i = 0; i < 3; ++i) {
+            ASSERT_TRUE(q.try_push(i));
+        }
+        std::atomic<int> accepted{0};
+        std::atomic<bool> go{false};
+        {
+            std::vector<std::jthread> producers;
+            for (int p = 0; p < kProducers; ++p) {
+                producers.emplace_back([&, p] {
+                    while (!go.load(std::memory_order_acquire)) {
+                    }
+                    if (q.try_push(100 + p)) {
+                        accepted.fetch_add(1, std::memory_order_relaxed);
+                    }
+                });
+            }
+            go.store(true, std::memory_order_release);
+        }
+        EXPECT_EQ(accepted.load(), 1);
+        EXPECT_EQ(q.size(), 4u);
+        EXPECT_FALSE(q.try_push(-1));
+    }
+}
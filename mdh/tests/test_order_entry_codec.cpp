@@ -5,6 +5,7 @@
 
 using namespace mdh;
 using namespace mdh::protocol::order_entry;
+using mdh::exchange::ClientOrderId;
 using mdh::exchange::OrderType;
 using mdh::exchange::RejectReason;
 using mdh::exchange::TimeInForce;
@@ -42,10 +43,10 @@ TEST(OrderEntryCodec, WireBytesAreBigEndian) {
     encode_message(Message{msg}, bytes);
 
     // Header: type (1 byte) then payload_size (u16 big-endian). NewOrder's
-    // payload_size is 39 (0x0027).
+    // payload_size is 55 (0x0037).
     EXPECT_EQ(std::to_integer<std::uint8_t>(bytes[0]), static_cast<std::uint8_t>(MessageType::NewOrder));
     EXPECT_EQ(std::to_integer<std::uint8_t>(bytes[1]), 0x00);
-    EXPECT_EQ(std::to_integer<std::uint8_t>(bytes[2]), 0x27);
+    EXPECT_EQ(std::to_integer<std::uint8_t>(bytes[2]), 0x37);
 
     // account_id is the first payload field, right after the 3-byte header
     // -> offset 3, 8 bytes, big-endian (most-significant byte first).
@@ -75,6 +76,49 @@ TEST(OrderEntryCodec, NewOrder) {
     EXPECT_EQ(std::get<NewOrder>(decoded), original);
 }
 
+// The expiry is the one field only a GTD order sets, and the last but one
+// on the wire, so a full-width value shows it is neither dropped nor
+// shifted.
+TEST(OrderEntryCodec, NewOrderGoodTillDateCarriesItsExpiry) {
+    NewOrder original{
+        .account_id = 100,
+        .client_order_id = 8,
+        .instrument_id = 1,
+        .side = Side::Sell,
+        .price = 250000,
+        .quantity = 10,
+        .order_type = OrderType::Limit,
+        .time_in_force = TimeInForce::GTD,
+        .expire_at = 0xFEDCBA9876543210ULL,
+    };
+
+    std::vector<std::byte> bytes;
+    encode_message(Message{original}, bytes);
+    EXPECT_EQ(std::to_integer<std::uint8_t>(bytes[bytes.size() - 9]), 0x10);
+    EXPECT_EQ(std::get<NewOrder>(decode_or_fail(bytes)), original);
+}
+
+// Likewise the stop price, which closes the frame. Negative, so a sign
+// mangled on the way through would show.
+TEST(OrderEntryCodec, NewOrderStopLimitCarriesItsStopPrice) {
+    NewOrder original{
+        .account_id = 100,
+        .client_order_id = 9,
+        .instrument_id = 1,
+        .side = Side::Buy,
+        .price = 250100,
+        .quantity = 10,
+        .order_type = OrderType::StopLimit,
+        .time_in_force = TimeInForce::GTC,
+        .stop_price = -250000,
+    };
+
+    std::vector<std::byte> bytes;
+    encode_message(Message{original}, bytes);
+    EXPECT_EQ(bytes.size(), HEADER_SIZE + payload_size_for(MessageType::NewOrder));
+    EXPECT_EQ(std::get<NewOrder>(decode_or_fail(bytes)), original);
+}
+
 TEST(OrderEntryCodec, NewOrderNegativePrice) {
     // Same rationale as ProtocolRoundtrip.AddOrderNegativePrice: the codec
     // must round-trip the full int64_t range; validating that a price makes
@@ -126,6 +170,56 @@ TEST(OrderEntryCodec, ReplaceOrder) {
     EXPECT_EQ(std::get<ReplaceOrder>(decoded), original);
 }
 
+TEST(OrderEntryCodec, MassQuote) {
+    MassQuote original{
+        .account_id = 100,
+        .instrument_id = 1,
+        .entries =
+            {
+                MassQuoteEntry{.client_order_id = 11, .side = Side::Buy, .price = 4999, .quantity = 10},
+                MassQuoteEntry{.client_order_id = 12, .side = Side::Sell, .price = 5001, .quantity = 20},
+                MassQuoteEntry{.client_order_id = 13, .side = Side::Sell, .price = 5002, .quantity = 30},
+            },
+    };
+
+    std::vector<std::byte> bytes;
+    encode_message(Message{original}, bytes);
+    EXPECT_EQ(bytes.size(), HEADER_SIZE + mass_quote_payload_size(3));
+
+    Message decoded = decode_or_fail(bytes);
+    ASSERT_TRUE(std::holds_alternative<MassQuote>(decoded));
+    EXPECT_EQ(std::get<MassQuote>(decoded), original);
+}
+
+// No entries is a quote withdrawn, not a malformed frame.
+TEST(OrderEntryCodec, MassQuoteWithNoEntries) {
+    MassQuote original{.account_id = 100, .instrument_id = 1, .entries = {}};
+
+    std::vector<std::byte> bytes;
+    encode_message(Message{original}, bytes);
+    EXPECT_EQ(bytes.size(), HEADER_SIZE + payload_size_for(MessageType::MassQuote));
+
+    Message decoded = decode_or_fail(bytes);
+    ASSERT_TRUE(std::holds_alternative<MassQuote>(decoded));
+    EXPECT_EQ(std::get<MassQuote>(decoded), original);
+}
+
+TEST(OrderEntryCodec, MassCancel) {
+    for (const auto instrument : {std::optional<InstrumentId>{}, std::optional<InstrumentId>{3}}) {
+        for (const auto side : {std::optional<Side>{}, std::optional<Side>{Side::Buy}}) {
+            const MassCancel original{.account_id = 100, .instrument_id = instrument, .side = side};
+
+            std::vector<std::byte> bytes;
+            encode_message(Message{original}, bytes);
+            EXPECT_EQ(bytes.size(), HEADER_SIZE + payload_size_for(MessageType::MassCancel));
+
+            Message decoded = decode_or_fail(bytes);
+            ASSERT_TRUE(std::holds_alternative<MassCancel>(decoded));
+            EXPECT_EQ(std::get<MassCancel>(decoded), original);
+        }
+    }
+}
+
 TEST(OrderEntryCodec, Accepted) {
     Accepted original{
         .account_id = 100,
@@ -261,3 +355,26 @@ TEST(OrderEntryCodec, MultipleMessagesConcatenateCleanly) {
     Message second = decode_or_fail(std::span(bytes).subspan(first_len));
     ASSERT_TRUE(std::holds_alternative<CancelOrder>(second));
 }
+
+TEST(OrderEntryCodec, DecodeFramesTakesEveryWholeFrameAndStopsAtAPartialOne) {
+    // What a stream reader has after one read(): a run of frames, the last
+    // of them cut short.
+    std::vector<std::byte> stream;
+    for (ClientOrderId id = 1; id <= 3; ++id) {
+        encode_message(Message{CancelOrder{.account_id = 7, .client_order_id = id, .instrument_id = 1}}, stream);
+    }
+    const std::size_t whole = stream.size();
+    encode_message(Message{CancelOrder{.account_id = 7, .client_order_id = 4, .instrument_id = 1}}, stream);
+    stream.resize(stream.size() - 1);
+
+    std::vector<ClientOrderId> seen;
+    const std::size_t framed = decode_frames(stream, [&](std::variant<Message, DecodeError>&& result) {
+        ASSERT_TRUE(std::holds_alternative<Message>(result));
+        seen.push_back(std::get<CancelOrder>(std::get<Message>(result)).client_order_id);
+    });
+    EXPECT_EQ(framed, whole);
+    EXPECT_EQ(seen, (std::vector<ClientOrderId>{1, 2, 3}));
+
+    // Nothing whole at all -- not even a header -- frames nothing.
+    EXPECT_EQ(decode_frames(std::span(stream).first(2), [](auto&&) { ADD_FAILURE(); }), 0u);
+}
@@ -22,8 +22,8 @@ DecodeError decode_expect_error(std::span<const std::byte> bytes) {
 
 // NewOrder payload layout (offsets relative to the start of the frame,
 // HEADER_SIZE == 3): account_id(8)@3 client_order_id(8)@11 instrument_id(4)@19
-// side(1)@23 price(8)@24 quantity(8)@32 order_type(1)@40 time_in_force(1)@41.
-// Total frame size 42.
+// side(1)@23 price(8)@24 quantity(8)@32 order_type(1)@40 time_in_force(1)@41
+// expire_at(8)@42. Total frame size 50.
 std::vector<std::byte> valid_new_order_bytes() {
     std::vector<std::byte> bytes;
     encode_message(Message{NewOrder{.account_id = 1,
@@ -48,6 +48,24 @@ std::vector<std::byte> valid_rejected_bytes() {
     return bytes;
 }
 
+// MassQuote payload layout: account_id(8)@3 instrument_id(4)@11, then per
+// entry client_order_id(8) side(1) price(8) quantity(8) -- the first entry's
+// side at offset 23.
+std::vector<std::byte> valid_mass_quote_bytes(std::size_t entries) {
+    MassQuote quote{.account_id = 1, .instrument_id = 1, .entries = {}};
+    for (std::size_t i = 0; i < entries; ++i) {
+        quote.entries.push_back(MassQuoteEntry{.client_order_id = i + 1, .side = Side::Buy, .price = 100, .quantity = 5});
+    }
+    std::vector<std::byte> bytes;
+    encode_message(Message{quote}, bytes);
+    return bytes;
+}
+
+void set_payload_size(std::vector<std::byte>& bytes, std::size_t payload_size) {
+    bytes[1] = static_cast<std::byte>(payload_size >> 8U);
+    bytes[2] = static_cast<std::byte>(payload_size & 0xFFU);
+}
+
 } // namespace
 
 TEST(OrderEntryDecoderErrors, EmptyBufferIsTruncatedHeader) {
@@ -90,13 +108,13 @@ TEST(OrderEntryDecoderErrors, InvalidSideByteIsRejected) {
 
 TEST(OrderEntryDecoderErrors, InvalidOrderTypeByteIsRejected) {
     auto bytes = valid_new_order_bytes();
-    bytes[40] = std::byte{99}; // OrderType only defines Limit(0)
+    bytes[40] = std::byte{99}; // OrderType only defines Limit(0) and StopLimit(1)
     EXPECT_EQ(decode_expect_error(bytes), DecodeError::InvalidOrderType);
 }
 
 TEST(OrderEntryDecoderErrors, InvalidTimeInForceByteIsRejected) {
     auto bytes = valid_new_order_bytes();
-    bytes.back() = std::byte{99}; // time_in_force is the frame's last byte
+    bytes[41] = std::byte{99}; // time_in_force, just ahead of the expiry
     EXPECT_EQ(decode_expect_error(bytes), DecodeError::InvalidTimeInForce);
 }
 
@@ -117,3 +135,66 @@ TEST(OrderEntryDecoderErrors, TrailingBytesBeyondPayloadAreIgnoredNotRejected) {
     auto result = decode_message(bytes);
     ASSERT_TRUE(std::holds_alternative<Message>(result));
 }
+
+// The one variable-size frame: its payload_size must be the prefix plus a
+// whole number of entries, and no more entries than a quote may carry.
+TEST(OrderEntryDecoderErrors, MassQuoteSizeThatSplitsAnEntryIsRejected) {
+    auto bytes = valid_mass_quote_bytes(2);
+    set_payload_size(bytes, mass_quote_payload_size(2) - 1);
+    EXPECT_EQ(decode_expect_error(bytes), DecodeError::InvalidMessageSize);
+
+    set_payload_size(bytes, MASS_QUOTE_PREFIX_SIZE - 1);
+    EXPECT_EQ(decode_expect_error(bytes), DecodeError::InvalidMessageSize);
+}
+
+TEST(OrderEntryDecoderErrors, MassQuoteWithTooManyEntriesIsRejected) {
+    EXPECT_EQ(decode_expect_error(valid_mass_quote_bytes(exchange::kMaxQuoteEntries + 1)),
+              DecodeError::InvalidMessageSize);
+    EXPECT_TRUE(std::holds_alternative<Message>(decode_message(valid_mass_quote_bytes(exchange::kMaxQuoteEntries))));
+}
+
+TEST(OrderEntryDecoderErrors, MassQuoteEntryWithAnInvalidSideIsRejected) {
+    auto bytes = valid_mass_quote_bytes(2);
+    bytes[23 + MASS_QUOTE_ENTRY_SIZE] = std::byte{7}; // the second entry's side
+    EXPECT_EQ(decode_expect_error(bytes), DecodeError::InvalidSide);
+}
+
+// MassCancel payload layout: account_id(8)@3 flags(1)@11 instrument_id(4)@12
+// side(1)@16. Each filter is present only if its flag says so, and an absent
+// one must be zero, so there is exactly one encoding per request.
+TEST(OrderEntryDecoderErrors, MassCancelWithUnknownFlagsOrStrayFieldsIsRejected) {
+    std::vector<std::byte> bytes;
+    encode_message(Message{MassCancel{.account_id = 1, .instrument_id = std::nullopt, .side = std::nullopt}}, bytes);
+
+    auto unknown_flag = bytes;
+    unknown_flag[11] = std::byte{0x80};
+    EXPECT_EQ(decode_expect_error(unknown_flag), DecodeError::InvalidFlags);
+
+    auto stray_side = bytes;
+    stray_side[16] = std::byte{static_cast<std::uint8_t>(Side::Sell)};
+    EXPECT_EQ(decode_expect_error(stray_side), DecodeError::InvalidFlags);
+
+    auto bad_side = bytes;
+    bad_side[11] = std::byte{MASS_CANCEL_HAS_SIDE};
+    bad_side[16] = std::byte{7};
+    EXPECT_EQ(decode_expect_error(bad_side), DecodeError::InvalidSide);
+}
+
+TEST(OrderEntryDecoderErrors, DecodeFramesPassesOnAMalformedPayloadAndKeepsFraming) {
+    // Three NewOrders back to back, the middle one with an invalid side: its
+    // header still says where it ends, so the third is framed regardless.
+    std::vector<std::byte> stream;
+    for (int i = 0; i < 3; ++i) {
+        auto frame = valid_new_order_bytes();
+        if (i == 1) {
+            frame[23] = std::byte{0x7F};
+        }
+        stream.insert(stream.end(), frame.begin(), frame.end());
+    }
+    std::vector<bool> decoded;
+    const std::size_t framed = decode_frames(stream, [&](std::variant<Message, DecodeError>&& result) {
+        decoded.push_back(std::holds_alternative<Message>(result));
+    });
+    EXPECT_EQ(framed, stream.size());
+    EXPECT_EQ(decoded, (std::vector<bool>{true, false, true}));
+}
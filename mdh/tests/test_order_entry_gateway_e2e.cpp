@@ -1,7 +1,9 @@
 #include <gtest/gtest.h>
 
 #include <array>
+#include <atomic>
 #include <chrono>
+#include <filesystem>
 #include <mutex>
 #include <optional>
 #include <span>
@@ -254,6 +256,119 @@ TEST(OrderEntryGatewayE2e, ReplaceOrderRoundTripsToAReplacedResponse) {
     EXPECT_EQ(replaced->new_quantity, 8u);
 }
 
+// One MassQuote frame in, one ordinary per-level report out for each level
+// it touched -- the client manages its ladder with one message, but still
+// tracks every level by the same Accepted/Replaced/Cancelled it would get
+// had it sent the individual orders itself.
+TEST(OrderEntryGatewayE2e, MassQuoteRoundTripsToPerLevelResponses) {
+    RunningGateway server;
+    ASSERT_TRUE(server.started());
+    constexpr AccountId kMaker = 30;
+    server.gateway().deposit_cash(kMaker, 1'000'000);
+    server.gateway().deposit_position(kMaker, kInstrument, 1'000);
+
+    TestClient client;
+    ASSERT_TRUE(client.connect_to(server.port()));
+
+    client.send(Message{MassQuote{
+        .account_id = kMaker,
+        .instrument_id = kInstrument,
+        .entries =
+            {
+                MassQuoteEntry{.client_order_id = 1, .side = Side::Buy, .price = 99, .quantity = 10},
+                MassQuoteEntry{.client_order_id = 2, .side = Side::Sell, .price = 101, .quantity = 10},
+            },
+    }});
+    for (ClientOrderId expected : {ClientOrderId{1}, ClientOrderId{2}}) {
+        auto response = client.receive();
+        ASSERT_TRUE(response.has_value());
+        const auto* accepted = std::get_if<Accepted>(&*response);
+        ASSERT_NE(accepted, nullptr);
+        EXPECT_EQ(accepted->client_order_id, expected);
+    }
+
+    // Keeps the bid (renamed, and shrunk in place), withdraws the offer, and
+    // adds a second bid: cancels first, then replacements, then new levels.
+    client.send(Message{MassQuote{
+        .account_id = kMaker,
+        .instrument_id = kInstrument,
+        .entries =
+            {
+                MassQuoteEntry{.client_order_id = 3, .side = Side::Buy, .price = 99, .quantity = 6},
+                MassQuoteEntry{.client_order_id = 4, .side = Side::Buy, .price = 98, .quantity = 5},
+            },
+    }});
+
+    auto first = client.receive();
+    ASSERT_TRUE(first.has_value());
+    const auto* cancelled = std::get_if<Cancelled>(&*first);
+    ASSERT_NE(cancelled, nullptr);
+    EXPECT_EQ(cancelled->client_order_id, 2u);
+
+    auto second = client.receive();
+    ASSERT_TRUE(second.has_value());
+    const auto* replaced = std::get_if<Replaced>(&*second);
+    ASSERT_NE(replaced, nullptr);
+    EXPECT_EQ(replaced->original_client_order_id, 1u);
+    EXPECT_EQ(replaced->new_client_order_id, 3u);
+    EXPECT_EQ(replaced->new_price, 99);
+    EXPECT_EQ(replaced->new_quantity, 6u);
+
+    auto third = client.receive();
+    ASSERT_TRUE(third.has_value());
+    const auto* accepted = std::get_if<Accepted>(&*third);
+    ASSERT_NE(accepted, nullptr);
+    EXPECT_EQ(accepted->client_order_id, 4u);
+    EXPECT_EQ(accepted->price, 98);
+
+    // The renamed level is an ordinary order from here on.
+    client.send(Message{CancelOrder{.account_id = kMaker, .client_order_id = 3, .instrument_id = kInstrument}});
+    auto cancel_response = client.receive();
+    ASSERT_TRUE(cancel_response.has_value());
+    ASSERT_NE(std::get_if<Cancelled>(&*cancel_response), nullptr);
+}
+
+// One MassCancel frame in, one Cancelled out per order, each routed as a
+// single cancel of that order would be. Another account's order at the
+// same price is left alone.
+TEST(OrderEntryGatewayE2e, MassCancelRoundTripsToOneCancelledPerOrder) {
+    RunningGateway server;
+    ASSERT_TRUE(server.started());
+    constexpr AccountId kMaker = 31;
+    constexpr AccountId kOther = 32;
+    server.gateway().deposit_cash(kMaker, 1'000'000);
+    server.gateway().deposit_position(kMaker, kInstrument, 1'000);
+    server.gateway().deposit_cash(kOther, 1'000'000);
+
+    TestClient maker;
+    TestClient other;
+    ASSERT_TRUE(maker.connect_to(server.port()));
+    ASSERT_TRUE(other.connect_to(server.port()));
+    maker.send(Message{new_order(kMaker, /*client_id=*/1, Side::Buy, /*price=*/99, /*qty=*/10)});
+    maker.send(Message{new_order(kMaker, /*client_id=*/2, Side::Sell, /*price=*/101, /*qty=*/10)});
+    other.send(Message{new_order(kOther, /*client_id=*/1, Side::Buy, /*price=*/99, /*qty=*/10)});
+    ASSERT_TRUE(maker.receive().has_value());
+    ASSERT_TRUE(maker.receive().has_value());
+    ASSERT_TRUE(other.receive().has_value());
+
+    maker.send(Message{MassCancel{.account_id = kMaker, .instrument_id = std::nullopt, .side = std::nullopt}});
+    for (ClientOrderId expected : {ClientOrderId{1}, ClientOrderId{2}}) {
+        auto response = maker.receive();
+        ASSERT_TRUE(response.has_value());
+        const auto* cancelled = std::get_if<Cancelled>(&*response);
+        ASSERT_NE(cancelled, nullptr);
+        EXPECT_EQ(cancelled->client_order_id, expected);
+    }
+    EXPECT_FALSE(other.receive(kQuietTimeout).has_value());
+
+    server.gateway().stop();
+    const EngineStateSnapshot snapshot = server.gateway().snapshot();
+    ASSERT_EQ(snapshot.instruments.size(), 1u);
+    ASSERT_EQ(snapshot.instruments[0].bids.size(), 1u);
+    EXPECT_EQ(snapshot.instruments[0].bids[0].account_id, kOther);
+    EXPECT_TRUE(snapshot.instruments[0].asks.empty());
+}
+
 TEST(OrderEntryGatewayE2e, CrossingOrdersFromTwoConnectionsEachGetTheirOwnTradeReport) {
     RunningGateway server;
     ASSERT_TRUE(server.started());
@@ -315,6 +430,113 @@ TEST(OrderEntryGatewayE2e, CrossingOrdersFromTwoConnectionsEachGetTheirOwnTradeR
     EXPECT_TRUE(snapshot.instruments.empty()); // both orders fully filled -- nothing left resting
 }
 
+// ── Execution reports per event ────────────────────────────────────────────
+// The router builds each event's reports in a fixed buffer of two -- a
+// trade's buyer and seller -- rather than a vector. These pin down what
+// fills it: both slots even when one account is on both sides, one for
+// anything that is not a trade, and never more than two however many levels
+// an order sweeps.
+
+TEST(OrderEntryGatewayE2e, ASelfTradeReportsBothSidesToTheOneAccount) {
+    RunningGateway server;
+    ASSERT_TRUE(server.started());
+    constexpr AccountId kAccount = 8;
+    server.gateway().deposit_cash(kAccount, 1'000'000);
+    server.gateway().deposit_position(kAccount, kInstrument, 100);
+
+    TestClient client;
+    ASSERT_TRUE(client.connect_to(server.port()));
+    client.send(Message{new_order(kAccount, /*client_id=*/1, Side::Sell, /*price=*/100, /*qty=*/10)});
+    client.send(Message{new_order(kAccount, /*client_id=*/2, Side::Buy, /*price=*/100, /*qty=*/10)});
+
+    std::vector<Message> received;
+    for (int i = 0; i < 4; ++i) {
+        auto message = client.receive();
+        ASSERT_TRUE(message.has_value()) << "message " << i;
+        received.push_back(std::move(*message));
+    }
+    ASSERT_NE(std::get_if<Accepted>(&received[0]), nullptr);
+    ASSERT_NE(std::get_if<Accepted>(&received[1]), nullptr);
+
+    // One TradeExecuted, two reports, one per order -- buyer first.
+    const auto* buy = std::get_if<TradeReport>(&received[2]);
+    const auto* sell = std::get_if<TradeReport>(&received[3]);
+    ASSERT_NE(buy, nullptr);
+    ASSERT_NE(sell, nullptr);
+    EXPECT_EQ(buy->account_id, kAccount);
+    EXPECT_EQ(buy->client_order_id, 2u);
+    EXPECT_EQ(sell->account_id, kAccount);
+    EXPECT_EQ(sell->client_order_id, 1u);
+    EXPECT_EQ(buy->quantity, 10u);
+    EXPECT_EQ(sell->quantity, 10u);
+    EXPECT_NE(buy->exchange_order_id, sell->exchange_order_id);
+    EXPECT_FALSE(client.receive(50ms).has_value());
+}
+
+TEST(OrderEntryGatewayE2e, ARejectIsOneReport) {
+    RunningGateway server;
+    ASSERT_TRUE(server.started());
+
+    TestClient client;
+    ASSERT_TRUE(client.connect_to(server.port()));
+    client.send(Message{new_order(/*account=*/9, /*client_id=*/1, Side::Buy, /*price=*/100, /*qty=*/10)});
+
+    auto response = client.receive();
+    ASSERT_TRUE(response.has_value());
+    const auto* rejected = std::get_if<Rejected>(&*response);
+    ASSERT_NE(rejected, nullptr);
+    EXPECT_EQ(rejected->client_order_id, 1u);
+    EXPECT_FALSE(client.receive(50ms).has_value());
+}
+
+TEST(OrderEntryGatewayE2e, AMultiLevelSweepIsTwoReportsPerFillAtEveryLevel) {
+    RunningGateway server;
+    ASSERT_TRUE(server.started());
+    constexpr AccountId kMaker = 10;
+    constexpr AccountId kTaker = 11;
+    server.gateway().deposit_position(kMaker, kInstrument, 100);
+    server.gateway().deposit_cash(kTaker, 1'000'000);
+
+    TestClient maker;
+    TestClient taker;
+    ASSERT_TRUE(maker.connect_to(server.port()));
+    ASSERT_TRUE(taker.connect_to(server.port()));
+
+    // Two asks of 5 at each of four prices, 100 to 103.
+    constexpr ClientOrderId kAsks = 8;
+    for (ClientOrderId id = 1; id <= kAsks; ++id) {
+        maker.send(Message{new_order(kMaker, id, Side::Sell, /*price=*/100 + static_cast<Price>((id - 1) / 2), /*qty=*/5)});
+    }
+    for (ClientOrderId id = 1; id <= kAsks; ++id) {
+        const auto accepted = maker.receive();
+        ASSERT_TRUE(accepted.has_value());
+        ASSERT_NE(std::get_if<Accepted>(&*accepted), nullptr);
+    }
+
+    // One bid through all four levels: eight trades in one command.
+    taker.send(Message{new_order(kTaker, /*client_id=*/1, Side::Buy, /*price=*/103, /*qty=*/5 * kAsks)});
+    const auto taker_accepted = taker.receive();
+    ASSERT_TRUE(taker_accepted.has_value());
+    ASSERT_NE(std::get_if<Accepted>(&*taker_accepted), nullptr);
+    for (ClientOrderId i = 0; i < kAsks; ++i) {
+        const auto taker_fill = taker.receive();
+        const auto maker_fill = maker.receive();
+        ASSERT_TRUE(taker_fill.has_value()) << "fill " << i;
+        ASSERT_TRUE(maker_fill.has_value()) << "fill " << i;
+        const auto* bought = std::get_if<TradeReport>(&*taker_fill);
+        const auto* sold = std::get_if<TradeReport>(&*maker_fill);
+        ASSERT_NE(bought, nullptr);
+        ASSERT_NE(sold, nullptr);
+        EXPECT_EQ(bought->price, 100 + static_cast<Price>(i / 2));
+        EXPECT_EQ(bought->remaining_quantity, 5 * (kAsks - i - 1));
+        EXPECT_EQ(sold->client_order_id, i + 1);
+        EXPECT_EQ(sold->price, bought->price);
+        EXPECT_EQ(sold->remaining_quantity, 0u);
+    }
+    EXPECT_FALSE(taker.receive(50ms).has_value());
+    EXPECT_FALSE(maker.receive(50ms).has_value());
+}
+
 // ── Sessions ───────────────────────────────────────────────────────────────
 // One connection is one session, an account may have several of them, and a
 // private execution report belongs to the session that originated the order
@@ -456,7 +678,7 @@ TEST(OrderEntryGatewayE2e, FillOnAnOrderWhoseSessionDisconnectedGoesToASurviving
     ASSERT_TRUE(seller_watching.receive().has_value());
 
     // The session that placed the resting order goes away -- but the order
-    // itself stays in the book (nothing cancels orders on disconnect).
+    // itself stays in the book (cancel_on_disconnect is off by default).
     seller_placing.disconnect();
     std::this_thread::sleep_for(100ms); // let the gateway's reader thread observe the EOF and unbind
 
@@ -523,6 +745,70 @@ TEST(OrderEntryGatewayE2e, ReportsForAnAccountWithNoLiveSessionAreReplayedToTheN
     EXPECT_EQ(std::get<Accepted>(*accepted).client_order_id, 2u);
 }
 
+// With cancel_on_disconnect, an account's orders outlive any one of its
+// sessions but not the last: losing the placing session leaves the order
+// resting for the surviving one, and losing that one cancels everything.
+// Nobody is left to hear the cancels, so they wait for the next session.
+TEST(OrderEntryGatewayE2e, CancelOnDisconnectCancelsOnlyWhenTheAccountsLastSessionGoes) {
+    OrderEntryGatewayOptions options;
+    options.cancel_on_disconnect = true;
+    RunningGateway server(options);
+    ASSERT_TRUE(server.started());
+    constexpr AccountId kSeller = 27;
+    constexpr AccountId kBuyer = 28;
+    server.gateway().deposit_position(kSeller, kInstrument, 100);
+    server.gateway().deposit_cash(kBuyer, 1'000'000);
+
+    TestClient buyer;
+    ASSERT_TRUE(buyer.connect_to(server.port()));
+    {
+        TestClient placing;
+        TestClient watching;
+        ASSERT_TRUE(placing.connect_to(server.port()));
+        ASSERT_TRUE(watching.connect_to(server.port()));
+        placing.send(Message{new_order(kSeller, /*client_id=*/1, Side::Sell, /*price=*/100, /*qty=*/10)});
+        ASSERT_TRUE(placing.receive().has_value());
+        watching.send(Message{new_order(kSeller, /*client_id=*/2, Side::Sell, /*price=*/110, /*qty=*/10)});
+        ASSERT_TRUE(watching.receive().has_value());
+
+        placing.disconnect();
+        std::this_thread::sleep_for(100ms);
+
+        // Still resting: the account has a session left.
+        buyer.send(Message{new_order(kBuyer, /*client_id=*/1, Side::Buy, /*price=*/100, /*qty=*/4)});
+        ASSERT_TRUE(buyer.receive().has_value()); // Accepted
+        auto fill = buyer.receive();
+        ASSERT_TRUE(fill.has_value());
+        ASSERT_NE(std::get_if<TradeReport>(&*fill), nullptr);
+        auto watched = watching.receive();
+        ASSERT_TRUE(watched.has_value());
+        ASSERT_NE(std::get_if<TradeReport>(&*watched), nullptr);
+    } // the last kSeller session goes
+    std::this_thread::sleep_for(100ms);
+
+    // Nothing left to trade against.
+    buyer.send(Message{new_order(kBuyer, /*client_id=*/2, Side::Buy, /*price=*/110, /*qty=*/1)});
+    auto rests = buyer.receive();
+    ASSERT_TRUE(rests.has_value());
+    ASSERT_NE(std::get_if<Accepted>(&*rests), nullptr);
+    EXPECT_FALSE(buyer.receive(kQuietTimeout).has_value());
+
+    // The seller comes back to the cancels, ahead of its own request's reply.
+    TestClient reconnected;
+    ASSERT_TRUE(reconnected.connect_to(server.port()));
+    reconnected.send(Message{CancelOrder{.account_id = kSeller, .client_order_id = 9, .instrument_id = kInstrument}});
+    for (ClientOrderId expected : {ClientOrderId{1}, ClientOrderId{2}}) {
+        auto retained = reconnected.receive();
+        ASSERT_TRUE(retained.has_value());
+        const auto* cancelled = std::get_if<Cancelled>(&*retained);
+        ASSERT_NE(cancelled, nullptr);
+        EXPECT_EQ(cancelled->client_order_id, expected);
+    }
+    auto unknown = reconnected.receive();
+    ASSERT_TRUE(unknown.has_value());
+    ASSERT_NE(std::get_if<Rejected>(&*unknown), nullptr);
+}
+
 TEST(OrderEntryGatewayE2e, ExtraEventSinkObservesEveryEventIncludingAnonymousBookEvents) {
     std::mutex mutex;
     std::vector<ExchangeEvent> observed;
@@ -567,3 +853,547 @@ TEST(OrderEntryGatewayE2e, ExtraEventSinkObservesEveryEventIncludingAnonymousBoo
     EXPECT_TRUE(saw_order_accepted);
     EXPECT_TRUE(saw_book_order_added);
 }
+
+// The routing and publishing threads read the event ring independently, so
+// an extra_event_sink that stops dead delays no report: the Accepted must
+// arrive while the sink is still stuck on the very first event.
+TEST(OrderEntryGatewayE2e, AStalledExtraEventSinkDelaysNoExecutionReport) {
+    std::atomic<bool> release{false};
+    std::atomic<std::size_t> observed{0};
+    OrderEntryGatewayOptions options;
+    options.extra_event_sink = [&](const ExchangeEvent&) {
+        while (!release.load(std::memory_order_acquire)) {
+            std::this_thread::sleep_for(1ms);
+        }
+        observed.fetch_add(1, std::memory_order_relaxed);
+    };
+
+    RunningGateway server(options);
+    ASSERT_TRUE(server.started());
+    server.gateway().deposit_cash(/*account_id=*/7, /*amount=*/1'000'000);
+
+    TestClient client;
+    ASSERT_TRUE(client.connect_to(server.port()));
+    client.send(Message{new_order(/*account=*/7, /*client_id=*/1, Side::Buy, /*price=*/100, /*qty=*/10)});
+    auto response = client.receive();
+    EXPECT_EQ(observed.load(), 0u);
+    release.store(true, std::memory_order_release);
+    ASSERT_TRUE(response.has_value());
+    EXPECT_NE(std::get_if<Accepted>(&*response), nullptr);
+
+    server.gateway().stop(); // drains the ring, so the sink has now seen everything
+    EXPECT_EQ(observed.load(), 2u); // OrderAccepted and BookOrderAdded
+}
+
+// event_ring_capacity = 0: no ring and no routing or publishing threads,
+// the matching thread does both itself. Same reports, same sink.
+TEST(OrderEntryGatewayE2e, WithoutAnEventRingTheMatchingThreadRoutesAndPublishes) {
+    std::atomic<std::size_t> observed{0};
+    OrderEntryGatewayOptions options;
+    options.event_ring_capacity = 0;
+    options.extra_event_sink = [&](const ExchangeEvent&) { observed.fetch_add(1, std::memory_order_relaxed); };
+
+    RunningGateway server(options);
+    ASSERT_TRUE(server.started());
+    server.gateway().deposit_cash(/*account_id=*/7, /*amount=*/1'000'000);
+
+    TestClient client;
+    ASSERT_TRUE(client.connect_to(server.port()));
+    client.send(Message{new_order(/*account=*/7, /*client_id=*/1, Side::Buy, /*price=*/100, /*qty=*/10)});
+    auto response = client.receive();
+    ASSERT_TRUE(response.has_value());
+    EXPECT_NE(std::get_if<Accepted>(&*response), nullptr);
+    EXPECT_EQ(observed.load(), 2u); // synchronous: published before the report was even queued
+}
+
+TEST(OrderEntryGatewayE2e, PeriodicSnapshotsEndAtTheStateTheGatewayStoppedIn) {
+    std::mutex mutex;
+    std::vector<std::uint64_t> epochs;
+    EngineStateSnapshot last_image;
+    OrderEntryGatewayOptions options;
+    options.snapshot_every_commands = 2;
+    options.on_snapshot = [&](const EngineStateSnapshot& image, const EngineStateChanges& changes) {
+        std::lock_guard<std::mutex> lock(mutex);
+        epochs.push_back(changes.epoch);
+        last_image = image;
+    };
+
+    RunningGateway server(options);
+    ASSERT_TRUE(server.started());
+    server.gateway().deposit_cash(/*account_id=*/8, /*amount=*/1'000'000);
+
+    TestClient client;
+    ASSERT_TRUE(client.connect_to(server.port()));
+    for (ClientOrderId client_order_id = 1; client_order_id <= 5; ++client_order_id) {
+        client.send(Message{new_order(/*account=*/8, client_order_id, Side::Buy, /*price=*/100 + client_order_id, 1)});
+        ASSERT_TRUE(client.receive().has_value());
+    }
+    client.send(Message{CancelOrder{.account_id = 8, .client_order_id = 2, .instrument_id = kInstrument}});
+    ASSERT_TRUE(client.receive().has_value());
+
+    // stop() takes the last capture after matching drains, so the final
+    // image is the final state whatever the period left over.
+    server.gateway().stop();
+    std::lock_guard<std::mutex> lock(mutex);
+    ASSERT_FALSE(epochs.empty());
+    for (std::size_t i = 0; i < epochs.size(); ++i) {
+        EXPECT_EQ(epochs[i], i + 1) << "an epoch was skipped";
+    }
+    EXPECT_EQ(server.gateway().snapshots_taken(), epochs.size());
+    EXPECT_EQ(last_image, server.gateway().snapshot());
+    ASSERT_EQ(last_image.instruments.size(), 1u);
+    EXPECT_EQ(last_image.instruments[0].bids.size(), 4u);
+}
+
+// ── io_threads: the same sessions, served by event loops ───────────────────
+//
+// Everything above runs with a reader and a writer thread per connection.
+// These run the parts that differ under epoll -- accepting, reading to
+// WouldBlock, writing on writability, closing from the loop -- over the same
+// Connection state machine, and then the same again under io_uring, where
+// multishot accept and recv and batched sends stand in for all of that.
+
+namespace {
+
+// Threads in this process right now, from /proc. Linux only, like epoll.
+std::size_t thread_count() {
+    std::size_t count = 0;
+    for ([[maybe_unused]] const auto& entry : std::filesystem::directory_iterator("/proc/self/task")) {
+        ++count;
+    }
+    return count;
+}
+
+OrderEntryGatewayOptions with_io_threads(std::size_t io_threads) {
+    OrderEntryGatewayOptions options;
+    options.io_threads = io_threads;
+    // Room for every test's connects at once: past the backlog, a SYN is
+    // dropped and retried a second later, which a burst of connects from one
+    // thread reaches before the accepting loop gets a core.
+    options.accept_backlog = 128;
+    return options;
+}
+
+OrderEntryGatewayOptions with_io_uring(std::size_t io_threads) {
+    OrderEntryGatewayOptions options = with_io_threads(io_threads);
+    options.io_backend = GatewayIoBackend::IoUring;
+    return options;
+}
+
+// Each of the scenarios below runs once per backend. A gateway that could
+// not have the backend asked for falls back and still serves, so that is
+// skipped rather than failed: there is nothing of the backend to test.
+bool got_backend(RunningGateway& server, const OrderEntryGatewayOptions& options) {
+    return server.gateway().io_backend() == options.io_backend;
+}
+
+void expect_many_sessions_on_fixed_threads(OrderEntryGatewayOptions options) {
+    RunningGateway server(options);
+    ASSERT_TRUE(server.started());
+    if (!got_backend(server, options)) {
+        GTEST_SKIP() << "backend unavailable here; the gateway fell back";
+    }
+    constexpr std::size_t kSessions = 40;
+    for (AccountId account = 1; account <= kSessions; ++account) {
+        server.gateway().deposit_cash(account, 1'000'000);
+        server.gateway().deposit_position(account, kInstrument, 100);
+    }
+
+    const std::size_t threads_before = thread_count();
+    std::vector<TestClient> clients(kSessions);
+    for (auto& client : clients) {
+        ASSERT_TRUE(client.connect_to(server.port()));
+    }
+    // Consecutive sessions land on different loops, so each cross below
+    // routes a report to both of them.
+    for (std::size_t i = 0; i < kSessions; ++i) {
+        const auto account = static_cast<AccountId>(i + 1);
+        const Side side = i % 2 == 0 ? Side::Sell : Side::Buy;
+        clients[i].send(Message{new_order(account, /*client_id=*/1, side, /*price=*/100, /*qty=*/1)});
+        auto accepted = clients[i].receive();
+        ASSERT_TRUE(accepted.has_value());
+        ASSERT_NE(std::get_if<Accepted>(&*accepted), nullptr);
+        if (side == Side::Buy) {
+            for (std::size_t party : {i - 1, i}) {
+                auto trade = clients[party].receive();
+                ASSERT_TRUE(trade.has_value());
+                const auto* report = std::get_if<TradeReport>(&*trade);
+                ASSERT_NE(report, nullptr);
+                EXPECT_EQ(report->account_id, party + 1);
+            }
+        }
+    }
+
+    EXPECT_EQ(thread_count(), threads_before); // no thread per connection
+    EXPECT_EQ(server.gateway().connection_count(), kSessions);
+}
+
+void expect_pipelined_burst_answered(OrderEntryGatewayOptions options) {
+    options.matching_queue_capacity = 4096;
+    options.outbound_queue_capacity = 4096;
+    RunningGateway server(options);
+    ASSERT_TRUE(server.started());
+    if (!got_backend(server, options)) {
+        GTEST_SKIP() << "backend unavailable here; the gateway fell back";
+    }
+    server.gateway().deposit_cash(/*account_id=*/1, /*amount=*/1'000'000'000);
+
+    constexpr ClientOrderId kOrders = 2'000;
+    std::vector<std::byte> burst;
+    for (ClientOrderId id = 1; id <= kOrders; ++id) {
+        encode_message(Message{new_order(/*account=*/1, id, Side::Buy, /*price=*/100, /*qty=*/1)}, burst);
+    }
+    TcpSocket raw;
+    ASSERT_TRUE(raw.connect("127.0.0.1", server.port()));
+    std::size_t written = 0;
+    while (written < burst.size()) {
+        auto n = raw.write(std::span(burst).subspan(written));
+        ASSERT_TRUE(n.has_value());
+        written += *n;
+    }
+
+    // Read back on the same socket, blocking, with a deadline on the whole.
+    std::vector<std::byte> inbound;
+    ClientOrderId next = 1;
+    const auto deadline = std::chrono::steady_clock::now() + 10s;
+    raw.set_non_blocking();
+    while (next <= kOrders && std::chrono::steady_clock::now() < deadline) {
+        std::array<std::byte, 4096> chunk{};
+        const auto n = raw.try_read(chunk);
+        if (n.status != TcpSocket::IoStatus::Done || n.bytes == 0) {
+            std::this_thread::sleep_for(1ms);
+            continue;
+        }
+        inbound.insert(inbound.end(), chunk.begin(), chunk.begin() + static_cast<std::ptrdiff_t>(n.bytes));
+        while (true) {
+            auto header = decode_header(inbound);
+            if (!std::holds_alternative<Header>(header) ||
+                inbound.size() < HEADER_SIZE + std::get<Header>(header).payload_size) {
+                break;
+            }
+            const std::size_t frame = HEADER_SIZE + std::get<Header>(header).payload_size;
+            auto message = decode_message(std::span(inbound).first(frame));
+            inbound.erase(inbound.begin(), inbound.begin() + static_cast<std::ptrdiff_t>(frame));
+            ASSERT_TRUE(std::holds_alternative<Message>(message));
+            const auto* accepted = std::get_if<Accepted>(&std::get<Message>(message));
+            ASSERT_NE(accepted, nullptr);
+            EXPECT_EQ(accepted->client_order_id, next++); // every one, in order
+        }
+    }
+    EXPECT_EQ(next, kOrders + 1);
+}
+
+void expect_disconnect_unbinds_and_replays(OrderEntryGatewayOptions options) {
+    RunningGateway server(options);
+    ASSERT_TRUE(server.started());
+    if (!got_backend(server, options)) {
+        GTEST_SKIP() << "backend unavailable here; the gateway fell back";
+    }
+    constexpr AccountId kSeller = 25;
+    constexpr AccountId kBuyer = 26;
+    server.gateway().deposit_position(kSeller, kInstrument, 100);
+    server.gateway().deposit_cash(kBuyer, 1'000'000);
+
+    {
+        TestClient seller;
+        ASSERT_TRUE(seller.connect_to(server.port()));
+        seller.send(Message{new_order(kSeller, /*client_id=*/1, Side::Sell, /*price=*/100, /*qty=*/10)});
+        ASSERT_TRUE(seller.receive().has_value());
+    }
+    std::this_thread::sleep_for(100ms);
+
+    TestClient buyer;
+    ASSERT_TRUE(buyer.connect_to(server.port()));
+    buyer.send(Message{new_order(kBuyer, /*client_id=*/1, Side::Buy, /*price=*/100, /*qty=*/10)});
+    ASSERT_TRUE(buyer.receive().has_value()); // Accepted
+    ASSERT_TRUE(buyer.receive().has_value()); // TradeReport
+
+    buyer.send(Message{new_order(kSeller, /*client_id=*/2, Side::Sell, /*price=*/100, /*qty=*/1)});
+    auto mismatch = buyer.receive();
+    ASSERT_TRUE(mismatch.has_value());
+    const auto* rejected = std::get_if<Rejected>(&*mismatch);
+    ASSERT_NE(rejected, nullptr);
+    EXPECT_EQ(rejected->reason, RejectReason::AccountMismatch);
+
+    TestClient reconnected;
+    ASSERT_TRUE(reconnected.connect_to(server.port()));
+    reconnected.send(Message{new_order(kSeller, /*client_id=*/3, Side::Buy, /*price=*/10, /*qty=*/1)});
+    auto retained = reconnected.receive();
+    ASSERT_TRUE(retained.has_value());
+    const auto* trade = std::get_if<TradeReport>(&*retained);
+    ASSERT_NE(trade, nullptr);
+    EXPECT_EQ(trade->client_order_id, 1u);
+    auto accepted = reconnected.receive();
+    ASSERT_TRUE(accepted.has_value());
+    EXPECT_NE(std::get_if<Accepted>(&*accepted), nullptr);
+}
+
+} // namespace
+
+TEST(OrderEntryGatewayE2e, WithIoThreadsManySessionsAreServedByAFixedSetOfThreads) {
+#if !defined(__linux__)
+    GTEST_SKIP() << "epoll is Linux only";
+#endif
+    expect_many_sessions_on_fixed_threads(with_io_threads(2));
+}
+
+// A burst bigger than one loop turn reads (kReadsPerTurn chunks), sent
+// before reading anything back: the loop must come back for the rest
+// without a new edge, and write the replies out as the socket takes them.
+TEST(OrderEntryGatewayE2e, WithIoThreadsABurstOfPipelinedOrdersIsAnsweredInFull) {
+#if !defined(__linux__)
+    GTEST_SKIP() << "epoll is Linux only";
+#endif
+    expect_pipelined_burst_answered(with_io_threads(1));
+}
+
+// Closing happens on the loop: a disconnect unbinds the session, so the
+// account's next fill is retained and replayed to the session that binds
+// next, and a mismatched account is still refused.
+TEST(OrderEntryGatewayE2e, WithIoThreadsADisconnectUnbindsAndRetainedReportsReplay) {
+#if !defined(__linux__)
+    GTEST_SKIP() << "epoll is Linux only";
+#endif
+    expect_disconnect_unbinds_and_replays(with_io_threads(2));
+}
+
+// Sessions accepted on loop 0's multishot accept and handed to the loop
+// that owns them, and reports crossing between the two rings.
+TEST(OrderEntryGatewayE2e, WithIoUringManySessionsAreServedByAFixedSetOfThreads) {
+    expect_many_sessions_on_fixed_threads(with_io_uring(2));
+}
+
+// A burst that takes many provided buffers at once, and replies queued
+// faster than one send at a time drains them.
+TEST(OrderEntryGatewayE2e, WithIoUringABurstOfPipelinedOrdersIsAnsweredInFull) {
+    expect_pipelined_burst_answered(with_io_uring(1));
+}
+
+// End of stream arrives as a recv completion, and closes from the loop.
+TEST(OrderEntryGatewayE2e, WithIoUringADisconnectUnbindsAndRetainedReportsReplay) {
+    expect_disconnect_unbinds_and_replays(with_io_uring(2));
+}
+
+// io_stats() counts every message each way, whichever backend serves them,
+// and some system calls to do it -- what bench_gateway_connections divides.
+TEST(OrderEntryGatewayE2e, IoStatsCountMessagesEachWayUnderEveryBackend) {
+    for (const GatewayIoBackend backend :
+         {GatewayIoBackend::Threads, GatewayIoBackend::Epoll, GatewayIoBackend::IoUring}) {
+        OrderEntryGatewayOptions options = with_io_threads(1);
+        options.io_backend = backend;
+        RunningGateway server(options);
+        ASSERT_TRUE(server.started());
+        server.gateway().deposit_cash(/*account_id=*/1, /*amount=*/1'000'000);
+
+        TestClient client;
+        ASSERT_TRUE(client.connect_to(server.port()));
+        constexpr ClientOrderId kOrders = 5;
+        for (ClientOrderId id = 1; id <= kOrders; ++id) {
+            client.send(Message{new_order(/*account=*/1, id, Side::Buy, /*price=*/100, /*qty=*/1)});
+            ASSERT_TRUE(client.receive().has_value());
+        }
+        const GatewayIoStats stats = server.gateway().io_stats();
+        EXPECT_EQ(stats.messages_in, kOrders) << static_cast<int>(server.gateway().io_backend());
+        EXPECT_EQ(stats.messages_out, kOrders) << static_cast<int>(server.gateway().io_backend());
+        EXPECT_GT(stats.syscalls, 0u);
+        EXPECT_GT(stats.syscalls_per_message(), 0.0);
+    }
+}
+
+// Mass cancels go in batches of mass_cancel_batch, the matching thread
+// queueing the rest of each behind whatever came in meanwhile, and a
+// disconnect on an I/O thread hands its cancel over without waiting for
+// room. Either way every order goes, oldest first: a client's own kill
+// switch, answered to it, and the cancel-on-disconnect after it, retained
+// for the next session.
+TEST(OrderEntryGatewayE2e, MassCancelsGoInBatchesUnderEveryBackend) {
+    constexpr AccountId kSeller = 29;
+    for (const GatewayIoBackend backend :
+         {GatewayIoBackend::Threads, GatewayIoBackend::Epoll, GatewayIoBackend::IoUring}) {
+        OrderEntryGatewayOptions options = with_io_threads(1);
+        options.io_backend = backend;
+        options.cancel_on_disconnect = true;
+        options.mass_cancel_batch = 2;
+        RunningGateway server(options);
+        ASSERT_TRUE(server.started());
+        server.gateway().deposit_position(kSeller, kInstrument, 100);
+        const int served_by = static_cast<int>(server.gateway().io_backend());
+
+        constexpr ClientOrderId kOrders = 5;
+        {
+            TestClient seller;
+            ASSERT_TRUE(seller.connect_to(server.port()));
+            for (ClientOrderId id = 1; id <= kOrders; ++id) {
+                seller.send(Message{new_order(kSeller, id, Side::Sell, /*price=*/100 + static_cast<Price>(id), 1)});
+                ASSERT_TRUE(seller.receive().has_value());
+            }
+            seller.send(Message{MassCancel{.account_id = kSeller, .instrument_id = std::nullopt, .side = std::nullopt}});
+            for (ClientOrderId id = 1; id <= kOrders; ++id) {
+                auto reply = seller.receive();
+                ASSERT_TRUE(reply.has_value()) << served_by;
+                const auto* cancelled = std::get_if<Cancelled>(&*reply);
+                ASSERT_NE(cancelled, nullptr) << served_by;
+                EXPECT_EQ(cancelled->client_order_id, id) << served_by;
+            }
+            for (ClientOrderId id = kOrders + 1; id <= 2 * kOrders; ++id) {
+                seller.send(Message{new_order(kSeller, id, Side::Sell, /*price=*/100 + static_cast<Price>(id), 1)});
+                ASSERT_TRUE(seller.receive().has_value());
+            }
+        }
+        std::this_thread::sleep_for(100ms);
+
+        TestClient reconnected;
+        ASSERT_TRUE(reconnected.connect_to(server.port()));
+        reconnected.send(Message{CancelOrder{.account_id = kSeller, .client_order_id = 99, .instrument_id = kInstrument}});
+        for (ClientOrderId id = kOrders + 1; id <= 2 * kOrders; ++id) {
+            auto retained = reconnected.receive();
+            ASSERT_TRUE(retained.has_value()) << served_by;
+            const auto* cancelled = std::get_if<Cancelled>(&*retained);
+            ASSERT_NE(cancelled, nullptr) << served_by;
+            EXPECT_EQ(cancelled->client_order_id, id) << served_by;
+        }
+        auto unknown = reconnected.receive();
+        ASSERT_TRUE(unknown.has_value()) << served_by;
+        EXPECT_NE(std::get_if<Rejected>(&*unknown), nullptr) << served_by;
+    }
+}
+
+// ── Coalesced writes ───────────────────────────────────────────────────────
+//
+// A writer encodes reports into one buffer per connection and writes them
+// together (write_flush_bytes, write_linger). Whatever it gathers, a client
+// must read exactly the frames it would have read one write() apiece.
+
+namespace {
+
+struct FillBurst {
+    std::vector<TradeReport> maker_fills;
+    std::vector<TradeReport> taker_fills;
+    GatewayIoStats during{}; // io_stats() gained over the burst alone
+};
+
+// kOrders single-lot asks from one account, resting, then one bid from
+// another that takes them all: a burst of kOrders fills to each connection.
+constexpr ClientOrderId kBurstOrders = 200;
+
+FillBurst run_fill_burst(RunningGateway& server) {
+    constexpr AccountId kMaker = 1;
+    constexpr AccountId kTaker = 2;
+    server.gateway().deposit_position(kMaker, kInstrument, kBurstOrders);
+    server.gateway().deposit_cash(kTaker, 1'000'000);
+
+    FillBurst burst;
+    TestClient maker;
+    TestClient taker;
+    if (!maker.connect_to(server.port()) || !taker.connect_to(server.port())) {
+        ADD_FAILURE() << "connect failed";
+        return burst;
+    }
+    for (ClientOrderId id = 1; id <= kBurstOrders; ++id) {
+        maker.send(Message{new_order(kMaker, id, Side::Sell, /*price=*/100, /*qty=*/1)});
+    }
+    for (ClientOrderId id = 1; id <= kBurstOrders; ++id) {
+        if (!maker.receive().has_value()) {
+            ADD_FAILURE() << "Accepted " << id << " never came";
+            return burst;
+        }
+    }
+
+    const GatewayIoStats before = server.gateway().io_stats();
+    taker.send(Message{new_order(kTaker, /*client_id=*/1, Side::Buy, /*price=*/100, /*qty=*/kBurstOrders)});
+    auto collect = [](TestClient& client, std::vector<TradeReport>& fills) {
+        while (fills.size() < kBurstOrders) {
+            const auto message = client.receive();
+            if (!message) {
+                return;
+            }
+            if (const auto* fill = std::get_if<TradeReport>(&*message)) {
+                fills.push_back(*fill);
+            }
+        }
+    };
+    collect(maker, burst.maker_fills);
+    collect(taker, burst.taker_fills);
+    const GatewayIoStats after = server.gateway().io_stats();
+    burst.during = {.syscalls = after.syscalls - before.syscalls,
+                    .messages_in = after.messages_in - before.messages_in,
+                    .messages_out = after.messages_out - before.messages_out};
+    return burst;
+}
+
+// Every fill, once each, in the order the asks rested -- however the writes
+// fell.
+void expect_fill_burst_whole_and_in_order(const FillBurst& burst) {
+    ASSERT_EQ(burst.maker_fills.size(), kBurstOrders);
+    ASSERT_EQ(burst.taker_fills.size(), kBurstOrders);
+    for (ClientOrderId i = 0; i < kBurstOrders; ++i) {
+        EXPECT_EQ(burst.maker_fills[i].client_order_id, i + 1);
+        EXPECT_EQ(burst.maker_fills[i].quantity, 1u);
+        EXPECT_EQ(burst.taker_fills[i].remaining_quantity, kBurstOrders - i - 1);
+    }
+}
+
+} // namespace
+
+TEST(OrderEntryGatewayE2e, AFillBurstArrivesWholeAndInOrderWhateverTheFlushSize) {
+    // 1 writes every report alone; 64 splits the burst into writes of a
+    // report or two, cutting across frames; the default gathers it whole.
+    for (const GatewayIoBackend backend : {GatewayIoBackend::Threads, GatewayIoBackend::Epoll}) {
+        for (const std::size_t flush_bytes : {std::size_t{1}, std::size_t{64}, OrderEntryGatewayOptions{}.write_flush_bytes}) {
+            SCOPED_TRACE(testing::Message() << "backend " << static_cast<int>(backend) << ", flush " << flush_bytes);
+            OrderEntryGatewayOptions options = with_io_threads(backend == GatewayIoBackend::Threads ? 0 : 1);
+            options.io_backend = backend;
+            options.write_flush_bytes = flush_bytes;
+            RunningGateway server(options);
+            ASSERT_TRUE(server.started());
+            expect_fill_burst_whole_and_in_order(run_fill_burst(server));
+        }
+    }
+}
+
+TEST(OrderEntryGatewayE2e, AWriterThreadWithALingerWritesAFillBurstInAFewSystemCalls) {
+    // One write() per report, as before output was coalesced...
+    OrderEntryGatewayOptions one_each;
+    one_each.write_flush_bytes = 1;
+    RunningGateway uncoalesced(one_each);
+    ASSERT_TRUE(uncoalesced.started());
+    const FillBurst each = run_fill_burst(uncoalesced);
+    expect_fill_burst_whole_and_in_order(each);
+    EXPECT_GE(each.during.syscalls, 2 * kBurstOrders);
+
+    // ...against a writer given long enough for the whole burst to be
+    // routed before it writes: a handful, whatever the scheduler does.
+    OrderEntryGatewayOptions lingering;
+    lingering.write_linger = 20ms;
+    RunningGateway coalesced(lingering);
+    ASSERT_TRUE(coalesced.started());
+    const FillBurst gathered = run_fill_burst(coalesced);
+    expect_fill_burst_whole_and_in_order(gathered);
+    EXPECT_GE(gathered.during.messages_out, 2 * kBurstOrders);
+    EXPECT_LE(gathered.during.syscalls, 10u);
+}
+
+TEST(OrderEntryGatewayE2e, StopWritesOutWhatAWriterHadStagedInItsLinger) {
+    // A linger far longer than the test, so the Accepted sits staged in the
+    // writer's buffer until stop() -- which must see it written, not
+    // dropped with the buffer. Parked, so the linger is a timed sleep that
+    // stop() has to wake.
+    OrderEntryGatewayOptions options;
+    options.write_linger = 60s;
+    options.writer_wait = WaitPolicy::Park;
+    RunningGateway server(options);
+    ASSERT_TRUE(server.started());
+    server.gateway().deposit_cash(/*account_id=*/1, /*amount=*/1'000'000);
+
+    TestClient client;
+    ASSERT_TRUE(client.connect_to(server.port()));
+    client.send(Message{new_order(/*account=*/1, /*client_id=*/1, Side::Buy, /*price=*/100, /*qty=*/10)});
+    EXPECT_FALSE(client.receive(50ms).has_value()); // still lingering
+
+    const auto start = std::chrono::steady_clock::now();
+    server.gateway().stop();
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 10s);
+    const auto accepted = client.receive();
+    ASSERT_TRUE(accepted.has_value());
+    EXPECT_NE(std::get_if<Accepted>(&*accepted), nullptr);
+}
@@ -0,0 +1,238 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <variant>
+#include <vector>
+
+#include "exchange/matching/matching_engine.hpp"
+#include "exchange/persistence/command_decoder.hpp"
+#include "exchange/persistence/command_encoder.hpp"
+#include "exchange/persistence/state_hash.hpp"
+#include "exchange/risk/risk_gated_engine.hpp"
+#include "exchange/testing/matching_scenarios.hpp"
+
+namespace mdh::exchange {
+namespace {
+
+using testing::CollectingSink;
+using testing::new_order;
+
+constexpr InstrumentId kFirst = 1;
+constexpr InstrumentId kSecond = 2;
+constexpr AccountId kMaker = 100;
+constexpr AccountId kTaker = 200;
+constexpr Timestamp kMs = 1'000'000;
+
+NewOrderCommand gtd(CommandSequence seq, ClientOrderId client_id, InstrumentId instrument, Side side, Price price,
+                    Timestamp expire_at) {
+    return new_order(seq, kMaker, client_id, instrument, side, price, 10, TimeInForce::GTD, expire_at);
+}
+
+ClockTickCommand tick(CommandSequence seq, Timestamp now) { return ClockTickCommand{.command_sequence = seq, .now = now}; }
+
+TEST(OrderExpiry, AGoodTillDateOrderIsCancelledByTheFirstTickThatReachesItsExpiry) {
+    MatchingEngine engine{kFirst};
+    CollectingSink out;
+    engine.process(tick(1, 10 * kMs), out.sink());
+    engine.process(gtd(2, 1, kFirst, Side::Buy, 99, 20 * kMs), out.sink());
+    ASSERT_EQ(out.count<BookOrderAdded>(), 1u);
+    EXPECT_EQ(engine.pending_expiries(), 1u);
+
+    CollectingSink early;
+    engine.process(tick(3, 20 * kMs - 1), early.sink());
+    EXPECT_TRUE(early.events.empty());
+
+    CollectingSink due;
+    engine.process(tick(4, 20 * kMs), due.sink());
+    ASSERT_EQ(due.events.size(), 2u);
+    EXPECT_EQ(due.at<OrderCancelled>(0).command_sequence, 4u);
+    EXPECT_EQ(due.at<OrderCancelled>(0).account_id, kMaker);
+    EXPECT_EQ(due.at<OrderCancelled>(0).client_order_id, 1u);
+    EXPECT_EQ(due.at<OrderCancelled>(0).instrument_id, kFirst);
+    EXPECT_EQ(due.at<BookOrderRemoved>(1).price, 99);
+    EXPECT_EQ(engine.pending_expiries(), 0u);
+    EXPECT_TRUE(engine.snapshot().instruments.empty());
+    EXPECT_EQ(engine.clock(), 20 * kMs);
+    EXPECT_EQ(engine.commands_processed(), 4u);
+}
+
+// One tick a whole session late still expires everything due, earliest
+// first, across books -- the end-of-day sweep, as one command.
+TEST(OrderExpiry, OneLateTickExpiresEverythingDueEarliestFirst) {
+    MatchingEngine engine{kFirst, kSecond};
+    CollectingSink out;
+    engine.process(gtd(1, 1, kFirst, Side::Buy, 99, 30 * kMs), out.sink());
+    engine.process(gtd(2, 2, kSecond, Side::Sell, 201, 10 * kMs), out.sink());
+    engine.process(gtd(3, 3, kFirst, Side::Sell, 101, 3'600'000 * kMs), out.sink());
+    engine.process(gtd(4, 4, kSecond, Side::Buy, 199, 20 * kMs), out.sink());
+    engine.process(new_order(5, kMaker, 5, kFirst, Side::Buy, 98, 10), out.sink());
+
+    CollectingSink sweep;
+    engine.process(tick(6, 60'000 * kMs), sweep.sink());
+    EXPECT_EQ(sweep.cancelled_ids(), (std::vector<ClientOrderId>{2, 4, 1}));
+    EXPECT_EQ(engine.pending_expiries(), 1u);
+    EXPECT_EQ(engine.state_hash(), persistence::rolling_state_hash(engine.snapshot()));
+
+    CollectingSink later;
+    engine.process(tick(7, 3'600'000 * kMs), later.sink());
+    EXPECT_EQ(later.cancelled_ids(), (std::vector<ClientOrderId>{3}));
+}
+
+TEST(OrderExpiry, AnExpiryInThePastOrOnAnythingButGtdIsRejected) {
+    MatchingEngine engine{kFirst};
+    CollectingSink out;
+    engine.process(tick(1, 50 * kMs), out.sink());
+    engine.process(gtd(2, 1, kFirst, Side::Buy, 99, 50 * kMs), out.sink());
+    engine.process(gtd(3, 2, kFirst, Side::Buy, 99, 0), out.sink());
+    engine.process(new_order(4, kMaker, 3, kFirst, Side::Buy, 99, 10, TimeInForce::GTC, 60 * kMs), out.sink());
+    engine.process(new_order(5, kMaker, 4, kFirst, Side::Buy, 99, 10, TimeInForce::IOC, 60 * kMs), out.sink());
+
+    ASSERT_EQ(out.events.size(), 4u);
+    for (std::size_t i = 0; i < out.events.size(); ++i) {
+        EXPECT_EQ(out.at<OrderRejected>(i).reason, RejectReason::InvalidExpiry);
+    }
+    EXPECT_EQ(engine.pending_expiries(), 0u);
+}
+
+TEST(OrderExpiry, TheClockNeverMovesBackwards) {
+    MatchingEngine engine{kFirst};
+    CollectingSink out;
+    engine.process(tick(1, 100 * kMs), out.sink());
+    engine.process(tick(2, 40 * kMs), out.sink());
+    EXPECT_EQ(engine.clock(), 100 * kMs);
+
+    // Still judged against the later time.
+    engine.process(gtd(3, 1, kFirst, Side::Buy, 99, 80 * kMs), out.sink());
+    ASSERT_EQ(out.events.size(), 1u);
+    EXPECT_EQ(out.at<OrderRejected>(0).reason, RejectReason::InvalidExpiry);
+}
+
+// Every way an order can leave the book before its expiry takes its timer
+// with it, so the tick that would have expired it finds nothing to do.
+TEST(OrderExpiry, EveryOtherWayOffTheBookDisarmsTheTimer) {
+    MatchingEngine engine{kFirst};
+    CollectingSink out;
+    engine.process(gtd(1, 1, kFirst, Side::Sell, 101, 10 * kMs), out.sink()); // filled
+    engine.process(gtd(2, 2, kFirst, Side::Buy, 95, 10 * kMs), out.sink());  // cancelled
+    engine.process(gtd(3, 3, kFirst, Side::Buy, 94, 10 * kMs), out.sink());  // mass cancelled
+    engine.process(gtd(4, 4, kFirst, Side::Buy, 93, 10 * kMs), out.sink());  // mass cancelled
+    ASSERT_EQ(engine.pending_expiries(), 4u);
+
+    engine.process(new_order(5, kTaker, 1, kFirst, Side::Buy, 101, 10), out.sink());
+    engine.process(CancelOrderCommand{.command_sequence = 6, .account_id = kMaker, .client_order_id = 2,
+                                      .instrument_id = kFirst},
+                   out.sink());
+    engine.process(MassCancelCommand{.command_sequence = 7, .account_id = kMaker, .instrument_id = kFirst,
+                                     .side = std::nullopt},
+                   out.sink());
+    EXPECT_EQ(engine.pending_expiries(), 0u);
+
+    CollectingSink due;
+    engine.process(tick(8, 10 * kMs), due.sink());
+    EXPECT_TRUE(due.events.empty());
+}
+
+TEST(OrderExpiry, APartFillLeavesTheTimerArmed) {
+    MatchingEngine engine{kFirst};
+    CollectingSink out;
+    engine.process(gtd(1, 1, kFirst, Side::Sell, 101, 10 * kMs), out.sink());
+    engine.process(new_order(2, kTaker, 1, kFirst, Side::Buy, 101, 4), out.sink());
+    ASSERT_EQ(out.count<TradeExecuted>(), 1u);
+
+    CollectingSink due;
+    engine.process(tick(3, 10 * kMs), due.sink());
+    EXPECT_EQ(due.cancelled_ids(), (std::vector<ClientOrderId>{1}));
+}
+
+// A replace that keeps priority leaves the order -- and its timer -- where
+// they are; one that loses it re-enters the order under a new exchange id
+// with the expiry it had. Either way the order expires when it would have.
+TEST(OrderExpiry, AReplacedOrderKeepsItsExpiry) {
+    MatchingEngine engine{kFirst};
+    CollectingSink out;
+    engine.process(gtd(1, 1, kFirst, Side::Buy, 99, 10 * kMs), out.sink());
+    engine.process(gtd(2, 2, kFirst, Side::Buy, 98, 10 * kMs), out.sink());
+    engine.process(ReplaceOrderCommand{.command_sequence = 3, .account_id = kMaker, .original_client_order_id = 1,
+                                       .new_client_order_id = 11, .instrument_id = kFirst, .new_price = 99,
+                                       .new_quantity = 5},
+                   out.sink());
+    engine.process(ReplaceOrderCommand{.command_sequence = 4, .account_id = kMaker, .original_client_order_id = 2,
+                                       .new_client_order_id = 12, .instrument_id = kFirst, .new_price = 97,
+                                       .new_quantity = 10},
+                   out.sink());
+    ASSERT_EQ(out.count<OrderRejected>(), 0u);
+    EXPECT_EQ(engine.pending_expiries(), 2u);
+
+    const EngineStateSnapshot snapshot = engine.snapshot();
+    ASSERT_EQ(snapshot.instruments.size(), 1u);
+    ASSERT_EQ(snapshot.instruments[0].expiries.size(), 2u);
+    EXPECT_EQ(snapshot.instruments[0].expiries[0].expire_at, 10 * kMs);
+    EXPECT_EQ(snapshot.instruments[0].expiries[1].expire_at, 10 * kMs);
+
+    CollectingSink due;
+    engine.process(tick(5, 10 * kMs), due.sink());
+    EXPECT_EQ(due.cancelled_ids(), (std::vector<ClientOrderId>{11, 12}));
+}
+
+// The journal carries the ticks, so a replay of it expires the same orders
+// under the same commands, without ever reading a clock.
+TEST(OrderExpiry, ReplayingTheJournalExpiresTheSameOrdersAtTheSamePoint) {
+    const std::vector<ExchangeCommand> commands{
+        tick(1, 5 * kMs),
+        gtd(2, 1, kFirst, Side::Buy, 99, 12 * kMs),
+        gtd(3, 2, kSecond, Side::Sell, 201, 8 * kMs),
+        new_order(4, kTaker, 1, kFirst, Side::Sell, 99, 3),
+        tick(5, 9 * kMs),
+        gtd(6, 3, kFirst, Side::Sell, 105, 40 * kMs),
+        tick(7, 15 * kMs),
+    };
+    std::vector<std::byte> journal;
+    for (const auto& command : commands) {
+        persistence::encode_command(command, journal);
+    }
+
+    MatchingEngine live{kFirst, kSecond};
+    CollectingSink live_out;
+    for (const auto& command : commands) {
+        live.process(command, live_out.sink());
+    }
+
+    MatchingEngine replayed{kFirst, kSecond};
+    CollectingSink replay_out;
+    std::size_t offset = 0;
+    while (offset < journal.size()) {
+        const auto header = persistence::decode_command_header(std::span(journal).subspan(offset));
+        ASSERT_TRUE(std::holds_alternative<persistence::CommandHeader>(header));
+        const std::size_t frame_size = persistence::HEADER_SIZE + std::get<persistence::CommandHeader>(header).payload_size;
+        const auto frame = persistence::decode_journal_frame(std::span(journal).subspan(offset, frame_size));
+        const auto* command = std::get_if<ExchangeCommand>(&frame);
+        ASSERT_NE(command, nullptr);
+        replayed.process(*command, replay_out.sink());
+        offset += frame_size;
+    }
+
+    EXPECT_EQ(replay_out.events, live_out.events);
+    EXPECT_EQ(replayed.snapshot(), live.snapshot());
+    EXPECT_EQ(live_out.cancelled_ids(), (std::vector<ClientOrderId>{2, 1}));
+}
+
+TEST(OrderExpiry, AnExpiryReleasesTheHoldThroughTheRiskGate) {
+    MatchingEngine engine{kFirst};
+    ledger::Ledger ledger;
+    ledger.deposit_cash(kMaker, 10'000);
+    risk::RiskGatedEngine gated(engine, ledger);
+
+    CollectingSink out;
+    gated.process(gtd(1, 1, kFirst, Side::Buy, 99, 10 * kMs), out.sink());
+    ASSERT_EQ(out.count<OrderRejected>(), 0u);
+    EXPECT_EQ(ledger.available_cash(kMaker), 10'000 - 990);
+
+    gated.process(tick(2, 10 * kMs), out.sink());
+    EXPECT_EQ(ledger.available_cash(kMaker), 10'000);
+    EXPECT_FALSE(ledger.find_hold(kMaker, 1).has_value());
+}
+
+} // namespace
+} // namespace mdh::exchange
@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstring>
+#include <span>
+#include <vector>
+
+#include "net/receive_buffer.hpp"
+
+using namespace mdh::net;
+
+namespace {
+
+std::vector<std::byte> bytes(std::size_t n, unsigned first = 0) {
+    std::vector<std::byte> out(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        out[i] = std::byte(static_cast<unsigned char>(first + i));
+    }
+    return out;
+}
+
+bool same(std::span<const std::byte> a, std::span<const std::byte> b) {
+    return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size()) == 0;
+}
+
+} // namespace
+
+TEST(ReceiveBuffer, AppendedBytesAreReadableInOrderUntilConsumed) {
+    ReceiveBuffer buffer(16);
+    const auto first = bytes(5, 0);
+    const auto second = bytes(4, 5);
+    buffer.append(first);
+    buffer.append(second);
+    EXPECT_TRUE(same(buffer.readable(), bytes(9, 0)));
+
+    buffer.consume(3);
+    EXPECT_EQ(buffer.size(), 6u);
+    EXPECT_TRUE(same(buffer.readable(), bytes(6, 3)));
+}
+
+TEST(ReceiveBuffer, ConsumingEverythingStartsOverAtTheFront) {
+    ReceiveBuffer buffer(16);
+    buffer.append(bytes(10));
+    buffer.consume(10);
+    EXPECT_TRUE(buffer.empty());
+    // The whole capacity is free again without anything having moved.
+    EXPECT_EQ(buffer.writable().size(), 16u);
+}
+
+TEST(ReceiveBuffer, RoomAtTheBackIsMadeByCompactingBeforeGrowing) {
+    ReceiveBuffer buffer(16);
+    buffer.append(bytes(12, 0));
+    buffer.consume(10); // two bytes left of a partial frame, at the back
+    buffer.append(bytes(8, 12));
+    EXPECT_EQ(buffer.capacity(), 16u); // the two moved to the front; no new storage
+    EXPECT_TRUE(same(buffer.readable(), [] {
+        auto expected = bytes(2, 10);
+        const auto rest = bytes(8, 12);
+        expected.insert(expected.end(), rest.begin(), rest.end());
+        return expected;
+    }()));
+}
+
+TEST(ReceiveBuffer, GrowsOnlyForMoreThanItCanHold) {
+    ReceiveBuffer buffer(16);
+    buffer.append(bytes(10, 0));
+    buffer.append(bytes(30, 10)); // one frame bigger than the whole buffer
+    EXPECT_GE(buffer.capacity(), 40u);
+    EXPECT_TRUE(same(buffer.readable(), bytes(40, 0)));
+}
+
+TEST(ReceiveBuffer, WritableThenCommitReceivesInPlace) {
+    ReceiveBuffer buffer(16);
+    buffer.append(bytes(3, 0));
+    auto space = buffer.writable(8);
+    ASSERT_GE(space.size(), 8u);
+    const auto incoming = bytes(5, 3);
+    std::memcpy(space.data(), incoming.data(), incoming.size());
+    buffer.commit(incoming.size()); // as a read() that filled less than it was offered
+    EXPECT_TRUE(same(buffer.readable(), bytes(8, 0)));
+}
@@ -386,4 +386,44 @@ TEST(RiskGatedEngine, ReplaceOnAnUnknownInstrumentIsRejectedBeforeRisk) {
     EXPECT_EQ(ledger.balances(kBuyer).cash_reserved, 0);
 }
 
+// A sink of a type the gated engine can see replaces both std::function
+// hops -- the caller's and the ledger-applying wrapper -- without changing
+// what comes out or what the ledger ends up holding. The second buy is
+// risk-rejected, so the pre-trade path is covered as well as matching.
+TEST(RiskGatedEngine, ATypedSinkGetsTheSameEventsAndLedgerAsAnEventSink) {
+    const auto run = [](auto&& sink) {
+        MatchingEngine engine{kInstrument};
+        ledger::Ledger ledger;
+        ledger.deposit_cash(kBuyer, 1'500);
+        ledger.deposit_position(kSeller, kInstrument, 50);
+        RiskGatedEngine gated(engine, ledger);
+        gated.process(NewOrderCommand{.command_sequence = 1,
+                                       .account_id = kSeller,
+                                       .client_order_id = 1,
+                                       .instrument_id = kInstrument,
+                                       .side = Side::Sell,
+                                       .price = 100,
+                                       .quantity = 10,
+                                       .order_type = OrderType::Limit,
+                                       .time_in_force = TimeInForce::GTC},
+                      sink);
+        gated.process(buy(2, 1, 100, 4), sink);
+        gated.process(buy(3, 2, 100, 20), sink); // 2,000 against 1,100 left
+        return ledger.balances(kBuyer);
+    };
+
+    CollectingSink erased;
+    const auto erased_balances = run(erased.sink());
+
+    std::vector<ExchangeEvent> typed;
+    const auto typed_balances = run([&typed](const ExchangeEvent& event) { typed.push_back(event); });
+
+    EXPECT_EQ(typed, erased.events);
+    ASSERT_TRUE(holds<OrderRejected>(typed.back()));
+    EXPECT_EQ(std::get<OrderRejected>(typed.back()).reason, RejectReason::InsufficientFunds);
+    EXPECT_EQ(typed_balances.cash_total, erased_balances.cash_total);
+    EXPECT_EQ(typed_balances.cash_reserved, erased_balances.cash_reserved);
+    EXPECT_EQ(typed_balances.position_total, erased_balances.position_total);
+}
+
 } // namespace mdh::exchange::risk
@@ -0,0 +1,406 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <set>
+#include <string>
+#include <thread>
+#include <variant>
+#include <vector>
+
+#include "exchange/persistence/command_journal_reader.hpp"
+#include "exchange/persistence/command_journal_writer.hpp"
+#include "exchange/persistence/state_hash.hpp"
+#include "exchange/sequencing/matching_pipeline.hpp"
+#include "exchange/sequencing/sharded_matching_pipeline.hpp"
+#include "exchange/testing/matching_workload.hpp"
+
+namespace mdh::exchange::sequencing {
+namespace {
+
+using exchange::testing::generate_workload;
+using exchange::testing::Workload;
+using exchange::testing::WorkloadConfig;
+using namespace std::chrono_literals;
+
+// The merge thread is the only one that calls the sink, and every test
+// reads what it collected only after stop() has joined that thread -- so,
+// unlike test_matching_pipeline.cpp's sink, this one needs no lock.
+struct Collected {
+    std::vector<ExchangeEvent> events;
+
+    EventSink sink() {
+        return [this](const ExchangeEvent& event) { events.push_back(event); };
+    }
+};
+
+[[nodiscard]] Workload mixed_workload(std::uint32_t instruments, std::size_t operations) {
+    WorkloadConfig config;
+    config.instrument_count = instruments;
+    config.initial_orders_per_side = 64;
+    config.operation_count = operations;
+    return generate_workload(config);
+}
+
+// submit() refuses rather than blocks when a shard's queue is full, so a
+// test pushing more than a queue's worth retries until it gets in.
+template <class Pipeline>
+void submit_all(Pipeline& pipeline, const std::vector<ExchangeCommand>& commands) {
+    for (const auto& command : commands) {
+        while (!pipeline.submit(command)) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+[[nodiscard]] CommandSequence command_sequence_of(const ExchangeEvent& event) {
+    return std::visit(
+        [](const auto& ev) -> CommandSequence {
+            if constexpr (requires { ev.command_sequence; }) {
+                return ev.command_sequence;
+            } else {
+                return 0;
+            }
+        },
+        event);
+}
+
+// For the few tests that watch the threads before stop(): a short bounded
+// poll, as in test_matching_pipeline.cpp.
+template <class Pred>
+bool wait_until(Pred pred, std::chrono::milliseconds timeout = 2s) {
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (pred()) {
+            return true;
+        }
+        std::this_thread::sleep_for(1ms);
+    }
+    return pred();
+}
+
+class TempFile {
+public:
+    explicit TempFile(std::string name) : path_(std::move(name)) {}
+    ~TempFile() { std::remove(path_.c_str()); }
+    [[nodiscard]] const std::string& path() const { return path_; }
+
+private:
+    std::string path_;
+};
+
+} // namespace
+
+// With one shard there is nothing to merge, and the output has to be the
+// unsharded pipeline's exactly -- events, exchange order ids, state.
+TEST(ShardedMatchingPipeline, OneShardReproducesMatchingPipelineExactly) {
+    const Workload workload = mixed_workload(4, 4'000);
+    const auto instruments = workload.config.instruments();
+
+    Collected plain;
+    MatchingPipeline reference(plain.sink(), MatchingPipelineOptions{.instruments = instruments});
+    submit_all(reference, workload.seed);
+    submit_all(reference, workload.operations);
+    reference.stop();
+
+    Collected sharded;
+    ShardedMatchingPipeline pipeline(sharded.sink(),
+                                     ShardedMatchingPipelineOptions{.shard_count = 1, .instruments = instruments});
+    submit_all(pipeline, workload.seed);
+    submit_all(pipeline, workload.operations);
+    pipeline.stop();
+
+    EXPECT_EQ(sharded.events, plain.events);
+    EXPECT_EQ(pipeline.snapshot(), reference.snapshot());
+}
+
+TEST(ShardedMatchingPipeline, MergedStreamIsInCommandOrderWithGaplessEventSequence) {
+    const Workload workload = mixed_workload(8, 4'000);
+
+    Collected out;
+    ShardedMatchingPipeline pipeline(
+        out.sink(), ShardedMatchingPipelineOptions{.shard_count = 4, .instruments = workload.config.instruments()});
+    submit_all(pipeline, workload.seed);
+    submit_all(pipeline, workload.operations);
+    pipeline.stop();
+
+    EXPECT_EQ(pipeline.commands_processed(), workload.seed.size() + workload.operations.size());
+    ASSERT_FALSE(out.events.empty());
+
+    EventSequence expected_event = 1;
+    CommandSequence last_command = 0;
+    for (const auto& event : out.events) {
+        EXPECT_EQ(std::visit([](const auto& ev) { return ev.event_sequence; }, event), expected_event++);
+        // Book events carry no command sequence; every other event must
+        // never go backwards, whichever shard produced it.
+        if (const CommandSequence command = command_sequence_of(event); command != 0) {
+            EXPECT_GE(command, last_command);
+            last_command = command;
+        }
+    }
+}
+
+TEST(ShardedMatchingPipeline, SameCommandsAndShardCountEndInTheSameStateHash) {
+    const Workload workload = mixed_workload(8, 6'000);
+    const ShardedMatchingPipelineOptions options{.shard_count = 3, .instruments = workload.config.instruments()};
+
+    const auto run = [&] {
+        Collected out;
+        ShardedMatchingPipeline pipeline(out.sink(), options);
+        submit_all(pipeline, workload.seed);
+        submit_all(pipeline, workload.operations);
+        pipeline.stop();
+        return std::make_pair(std::move(out.events), pipeline.snapshot());
+    };
+
+    const auto [first_events, first_state] = run();
+    const auto [second_events, second_state] = run();
+    EXPECT_EQ(first_events, second_events);
+    EXPECT_EQ(first_state, second_state);
+    EXPECT_EQ(persistence::hash_state_snapshot(first_state), persistence::hash_state_snapshot(second_state));
+}
+
+// The journal records commands as sequenced, so feeding it back through a
+// pipeline with the same shard count has to land on the same state.
+TEST(ShardedMatchingPipeline, ReplayingItsJournalReproducesTheStateHash) {
+    const TempFile journal("test_sharded_matching_pipeline.journal");
+    const Workload workload = mixed_workload(6, 3'000);
+    const auto instruments = workload.config.instruments();
+    const ShardedMatchingPipelineOptions options{.shard_count = 2, .instruments = instruments};
+
+    std::uint64_t live_hash = 0;
+    {
+        persistence::CommandJournalWriter writer(journal.path(), instruments);
+        ASSERT_TRUE(writer.is_open());
+        Collected out;
+        ShardedMatchingPipeline pipeline(out.sink(), options);
+        for (const auto* phase : {&workload.seed, &workload.operations}) {
+            for (ExchangeCommand command : *phase) {
+                const CommandSequence assigned = pipeline.next_sequence();
+                while (!pipeline.submit(command)) {
+                    std::this_thread::yield();
+                }
+                std::visit([assigned](auto& cmd) { cmd.command_sequence = assigned; }, command);
+                writer.write(command);
+            }
+        }
+        pipeline.stop();
+        live_hash = persistence::hash_state_snapshot(pipeline.snapshot());
+    }
+
+    persistence::CommandJournalReader reader(journal.path());
+    ASSERT_TRUE(reader.is_open());
+    Collected out;
+    ShardedMatchingPipeline replayed(out.sink(), options);
+    while (auto frame = reader.next()) {
+        ASSERT_FALSE(std::holds_alternative<persistence::CommandDecodeError>(*frame));
+        if (const auto* command = std::get_if<ExchangeCommand>(&*frame)) {
+            while (!replayed.submit(*command)) {
+                std::this_thread::yield();
+            }
+        }
+    }
+    replayed.stop();
+
+    EXPECT_EQ(persistence::hash_state_snapshot(replayed.snapshot()), live_hash);
+}
+
+TEST(ShardedMatchingPipeline, ShardsNeverHandOutTheSameExchangeOrderId) {
+    Collected out;
+    ShardedMatchingPipeline pipeline(out.sink(),
+                                     ShardedMatchingPipelineOptions{.shard_count = 4, .instruments = {0, 1, 2, 3}});
+    ClientOrderId client_order_id = 1;
+    for (int round = 0; round < 16; ++round) {
+        for (InstrumentId instrument = 0; instrument < 4; ++instrument) {
+            ASSERT_TRUE(pipeline.submit(exchange::testing::new_order(0, 7, client_order_id++, instrument, Side::Buy,
+                                                                      100 + round, 1)));
+        }
+    }
+    pipeline.stop();
+
+    std::set<ExchangeOrderId> seen;
+    for (const auto& event : out.events) {
+        if (const auto* accepted = std::get_if<OrderAccepted>(&event)) {
+            EXPECT_TRUE(seen.insert(accepted->exchange_order_id).second);
+        }
+    }
+    EXPECT_EQ(seen.size(), 64u);
+}
+
+TEST(ShardedMatchingPipeline, AnInstrumentOutsideTheUniverseIsStillRejected) {
+    Collected out;
+    ShardedMatchingPipeline pipeline(out.sink(),
+                                     ShardedMatchingPipelineOptions{.shard_count = 2, .instruments = {1, 2}});
+    ASSERT_TRUE(pipeline.submit(exchange::testing::new_order(0, 1, 1, /*instrument=*/5, Side::Buy, 100, 1)));
+    pipeline.stop();
+
+    ASSERT_EQ(out.events.size(), 1u);
+    const auto* rejected = std::get_if<OrderRejected>(&out.events[0]);
+    ASSERT_NE(rejected, nullptr);
+    EXPECT_EQ(rejected->reason, RejectReason::InvalidInstrument);
+}
+
+// Duplicate client order ids are caught per engine, so per shard: an id an
+// account reuses on two instruments is refused only when both map to the
+// same shard, as it always is by MatchingPipeline. Pinned here because it is
+// the one place the sharded pipeline does not behave like the unsharded one
+// -- see "What a shard does not see" in the class comment.
+TEST(ShardedMatchingPipeline, AReusedClientOrderIdIsADuplicateOnlyWithinOneShard) {
+    const auto reuse_on = [](InstrumentId first, InstrumentId second) {
+        return std::vector<ExchangeCommand>{
+            exchange::testing::new_order(0, /*account=*/7, /*client_order_id=*/1, first, Side::Buy, 100, 1),
+            exchange::testing::new_order(0, /*account=*/7, /*client_order_id=*/1, second, Side::Buy, 100, 1),
+        };
+    };
+    const auto second_rejection = [](const std::vector<ExchangeEvent>& events) {
+        std::size_t rejected = 0;
+        for (const auto& event : events) {
+            if (const auto* ev = std::get_if<OrderRejected>(&event)) {
+                EXPECT_EQ(ev->reason, RejectReason::DuplicateOrderId);
+                ++rejected;
+            }
+        }
+        return rejected;
+    };
+
+    Collected plain;
+    MatchingPipeline reference(plain.sink(), MatchingPipelineOptions{.instruments = {1, 2, 3}});
+    submit_all(reference, reuse_on(1, 2));
+    reference.stop();
+    EXPECT_EQ(second_rejection(plain.events), 1u);
+
+    // 1 and 2 land on different shards of two: both orders rest.
+    Collected split;
+    ShardedMatchingPipeline across(split.sink(),
+                                   ShardedMatchingPipelineOptions{.shard_count = 2, .instruments = {1, 2, 3}});
+    submit_all(across, reuse_on(1, 2));
+    across.stop();
+    EXPECT_EQ(second_rejection(split.events), 0u);
+
+    // 1 and 3 share shard 1: refused, as unsharded.
+    Collected together;
+    ShardedMatchingPipeline within(together.sink(),
+                                   ShardedMatchingPipelineOptions{.shard_count = 2, .instruments = {1, 2, 3}});
+    submit_all(within, reuse_on(1, 3));
+    within.stop();
+    EXPECT_EQ(second_rejection(together.events), 1u);
+}
+
+// A mass cancel naming no instrument is the one command every shard runs.
+// It is still one command: one sequence number, counted once, and every
+// event it causes carries that sequence, gaplessly numbered.
+TEST(ShardedMatchingPipeline, AMassCancelOfEveryInstrumentReachesEveryShardAsOneCommand) {
+    Collected out;
+    ShardedMatchingPipeline pipeline(
+        out.sink(), ShardedMatchingPipelineOptions{.shard_count = 3, .instruments = {1, 2, 3, 4}});
+    std::vector<ExchangeCommand> commands;
+    for (InstrumentId instrument = 1; instrument <= 4; ++instrument) {
+        commands.emplace_back(exchange::testing::new_order(0, /*account=*/7, instrument, instrument, Side::Buy, 100, 1));
+    }
+    commands.emplace_back(exchange::testing::new_order(0, /*account=*/8, 1, /*instrument=*/2, Side::Buy, 100, 1));
+    commands.emplace_back(MassCancelCommand{
+        .command_sequence = 0, .account_id = 7, .instrument_id = std::nullopt, .side = std::nullopt});
+    submit_all(pipeline, commands);
+    pipeline.stop();
+
+    EXPECT_EQ(pipeline.commands_processed(), commands.size());
+    std::set<ClientOrderId> cancelled;
+    for (std::size_t i = 0; i < out.events.size(); ++i) {
+        EXPECT_EQ(std::visit([](const auto& ev) { return ev.event_sequence; }, out.events[i]), i + 1);
+        if (const auto* ev = std::get_if<OrderCancelled>(&out.events[i])) {
+            EXPECT_EQ(ev->account_id, 7u);
+            EXPECT_EQ(ev->command_sequence, commands.size());
+            cancelled.insert(ev->client_order_id);
+        }
+    }
+    EXPECT_EQ(cancelled, (std::set<ClientOrderId>{1, 2, 3, 4}));
+
+    const EngineStateSnapshot snapshot = pipeline.snapshot();
+    std::size_t resting = 0;
+    for (const auto& instrument : snapshot.instruments) {
+        resting += instrument.bids.size() + instrument.asks.size();
+    }
+    EXPECT_EQ(resting, 1u);
+}
+
+// A clock tick is the other command every shard runs: each engine keeps its
+// own expiry wheel, and the one tick expires whatever is due on all of them.
+TEST(ShardedMatchingPipeline, AClockTickExpiresGoodTillDateOrdersOnEveryShard) {
+    Collected out;
+    ShardedMatchingPipeline pipeline(
+        out.sink(), ShardedMatchingPipelineOptions{.shard_count = 3, .instruments = {1, 2, 3, 4}});
+    std::vector<ExchangeCommand> commands;
+    for (InstrumentId instrument = 1; instrument <= 4; ++instrument) {
+        NewOrderCommand order = exchange::testing::new_order(0, /*account=*/7, instrument, instrument, Side::Buy, 100, 1);
+        order.time_in_force = TimeInForce::GTD;
+        order.expire_at = 5'000'000;
+        commands.emplace_back(order);
+    }
+    commands.emplace_back(ClockTickCommand{.command_sequence = 0, .now = 5'000'000});
+    submit_all(pipeline, commands);
+    pipeline.stop();
+
+    EXPECT_EQ(pipeline.commands_processed(), commands.size());
+    std::set<ClientOrderId> expired;
+    for (const auto& event : out.events) {
+        if (const auto* ev = std::get_if<OrderCancelled>(&event)) {
+            EXPECT_EQ(ev->command_sequence, commands.size());
+            expired.insert(ev->client_order_id);
+        }
+    }
+    EXPECT_EQ(expired, (std::set<ClientOrderId>{1, 2, 3, 4}));
+    EXPECT_TRUE(pipeline.snapshot().instruments.empty());
+}
+
+// ── Idle threads ──────────────────────────────────────────────────────────
+
+// Two shards and the merge, all parked: each command must wake its shard
+// and the merge, and stop() every one of them, or this test would hang
+// rather than fail -- nothing else clears the flags they sleep on.
+TEST(ShardedMatchingPipeline, ParkedThreadsWakeForEachSubmissionAndForStop) {
+    Collected out;
+    ShardedMatchingPipeline pipeline(
+        out.sink(),
+        ShardedMatchingPipelineOptions{.shard_count = 2, .instruments = {1, 2}, .idle_wait = WaitPolicy::Park});
+
+    // Every thread asleep before the first command; after each, at least
+    // its shard and the merge asleep again before the next.
+    std::size_t asleep = 3;
+    for (InstrumentId instrument = 1; instrument <= 2; ++instrument) {
+        ASSERT_TRUE(wait_until([&] { return pipeline.idle_parks() >= asleep; }));
+        asleep = pipeline.idle_parks() + 2;
+        ASSERT_TRUE(pipeline.submit(exchange::testing::new_order(0, 1, instrument, instrument, Side::Buy, 100, 1)));
+        ASSERT_TRUE(wait_until([&] { return pipeline.commands_processed() == instrument; }));
+    }
+    ASSERT_TRUE(wait_until([&] { return pipeline.idle_parks() >= asleep; }));
+
+    pipeline.stop(); // returns only if every parked thread woke to see the stop
+    EXPECT_EQ(out.events.size(), 4u); // OrderAccepted and BookOrderAdded, twice
+}
+
+// Queues of four, so that shards fill their outboxes and the merge waits on
+// batches not yet made: every wait the threads have, parked through, with
+// the same stream at the end as spinning gives.
+TEST(ShardedMatchingPipeline, ParkingChangesNothingButHowTheThreadsWait) {
+    const Workload workload = mixed_workload(8, 4'000);
+    const auto run = [&](WaitPolicy idle_wait) {
+        Collected out;
+        ShardedMatchingPipeline pipeline(out.sink(), ShardedMatchingPipelineOptions{
+                                                         .shard_count = 3,
+                                                         .queue_capacity = 4,
+                                                         .instruments = workload.config.instruments(),
+                                                         .idle_wait = idle_wait,
+                                                     });
+        submit_all(pipeline, workload.seed);
+        submit_all(pipeline, workload.operations);
+        pipeline.stop();
+        return std::make_pair(std::move(out.events), pipeline.snapshot());
+    };
+
+    const auto [spun_events, spun_state] = run(WaitPolicy::SpinThenYield);
+    const auto [parked_events, parked_state] = run(WaitPolicy::Park);
+    EXPECT_EQ(parked_events, spun_events);
+    EXPECT_EQ(parked_state, spun_state);
+}
+
+} // namespace mdh::exchange::sequencing
@@ -2,6 +2,7 @@
 
 #include <memory>
 #include <thread>
+#include <utility>
 #include <vector>
 
 #include "common/spsc_queue.hpp"
@@ -139,6 +140,78 @@ TEST(SpscQueue, DestructorCleansUpElementsStillInQueue) {
     EXPECT_EQ(tracker.use_count(), 1); // both copies released; no leak, no double-destroy crash
 }
 
+TEST(SpscQueue, HighWaterMarkStaysExactWhileProducerReadsACachedTail) {
+    // The producer reloads the consumer's index only when its cached copy
+    // says the queue is full or a new peak is being set -- this walks both
+    // sides of that, several laps round a small queue.
+    SpscQueue<int> q(8);
+    for (int lap = 0; lap < 5; ++lap) {
+        for (int i = 0; i < 3; ++i) {
+            ASSERT_TRUE(q.try_push(i));
+        }
+        for (int i = 0; i < 3; ++i) {
+            ASSERT_TRUE(q.try_pop().has_value());
+        }
+    }
+    EXPECT_EQ(q.high_water_mark(), 3u);
+    for (int i = 0; i < 5; ++i) {
+        ASSERT_TRUE(q.try_push(i));
+    }
+    EXPECT_EQ(q.high_water_mark(), 5u);
+}
+
+TEST(SpscQueue, TryEmplaceConstructsInPlaceAndFailsWhenFull) {
+    SpscQueue<std::pair<int, std::unique_ptr<int>>> q(2);
+    ASSERT_TRUE(q.try_emplace(1, std::make_unique<int>(10)));
+    ASSERT_TRUE(q.try_emplace(2, nullptr));
+    EXPECT_FALSE(q.try_emplace(3, nullptr));
+
+    auto first = q.try_pop();
+    ASSERT_TRUE(first.has_value());
+    EXPECT_EQ(first->first, 1);
+    EXPECT_EQ(*first->second, 10);
+}
+
+TEST(SpscQueue, ConsumeHandsOverUpToMaxInFifoOrderAcrossWraparound) {
+    SpscQueue<int> q(4);
+    std::vector<int> seen;
+    auto collect = [&seen](int& value) { seen.push_back(value); };
+
+    EXPECT_EQ(q.consume(8, collect), 0u); // empty
+
+    int next = 0;
+    for (int lap = 0; lap < 3; ++lap) {
+        while (q.try_push(next)) {
+            ++next;
+        }
+        EXPECT_EQ(q.consume(3, collect), 3u); // stops at max with one left behind
+        EXPECT_EQ(q.size(), 1u);
+        EXPECT_EQ(q.consume(8, collect), 1u); // then takes only what is there
+    }
+    ASSERT_EQ(seen.size(), static_cast<std::size_t>(next));
+    for (int i = 0; i < next; ++i) {
+        EXPECT_EQ(seen[static_cast<std::size_t>(i)], i);
+    }
+}
+
+TEST(SpscQueue, ConsumeLetsTheCallbackMoveFromTheSlotAndDestroysWhatIsLeft) {
+    auto tracker = std::make_shared<int>(7);
+    SpscQueue<std::shared_ptr<int>> q(4);
+    ASSERT_TRUE(q.try_push(tracker));
+    ASSERT_TRUE(q.try_push(tracker));
+    EXPECT_EQ(tracker.use_count(), 3);
+
+    std::shared_ptr<int> taken;
+    EXPECT_EQ(q.consume(2, [&taken](std::shared_ptr<int>& slot) {
+        if (!taken) {
+            taken = std::move(slot); // the first is moved out; the second is left for consume() to destroy
+        }
+    }),
+              2u);
+    EXPECT_EQ(tracker.use_count(), 2); // tracker + taken: the one left in its slot was destroyed, not leaked
+    EXPECT_EQ(q.size(), 0u);
+}
+
 // ── Real concurrency (as opposed to the single-threaded tests above) ──────
 //
 // Everything above exercises try_push/try_pop from one thread, which never
@@ -187,6 +260,36 @@ TEST(SpscQueue, ConcurrentProducerConsumerPreservesFifoOrderAndCount) {
     }
 }
 
+TEST(SpscQueue, ConcurrentProducerBatchConsumerPreservesFifoOrderAndCount) {
+    constexpr int kCount = 1'000'000;
+    SpscQueue<int> q(64);
+
+    std::vector<int> received;
+    received.reserve(kCount);
+
+    {
+        std::jthread producer([&] {
+            for (int i = 0; i < kCount; ++i) {
+                while (!q.try_emplace(i)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+        std::jthread consumer([&] {
+            while (received.size() < static_cast<std::size_t>(kCount)) {
+                if (q.consume(16, [&received](int& v) { received.push_back(v); }) == 0) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    ASSERT_EQ(received.size(), static_cast<std::size_t>(kCount));
+    for (int i = 0; i < kCount; ++i) {
+        ASSERT_EQ(received[static_cast<std::size_t>(i)], i) << "FIFO order violated at index " << i;
+    }
+}
+
 TEST(SpscQueue, ConcurrentProducerConsumerWithMoveOnlyElements) {
     constexpr int kCount = 200'000;
     SpscQueue<std::unique_ptr<int>> q(32);
@@ -0,0 +1,352 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <variant>
+#include <vector>
+
+#include "exchange/matching/matching_engine.hpp"
+#include "exchange/persistence/command_decoder.hpp"
+#include "exchange/persistence/command_encoder.hpp"
+#include "exchange/persistence/state_hash.hpp"
+#include "exchange/risk/risk_gated_engine.hpp"
+#include "exchange/testing/matching_scenarios.hpp"
+
+namespace mdh::exchange {
+namespace {
+
+using testing::CollectingSink;
+using testing::new_order;
+using testing::stop_limit_order;
+
+constexpr InstrumentId kFirst = 1;
+constexpr InstrumentId kSecond = 2;
+constexpr AccountId kMaker = 100;
+constexpr AccountId kTaker = 200;
+constexpr AccountId kStopper = 300;
+
+NewOrderCommand stop(CommandSequence seq, ClientOrderId client_id, InstrumentId instrument, Side side,
+                     Price stop_price, Price limit_price, Quantity qty, TimeInForce tif = TimeInForce::GTC) {
+    return stop_limit_order(seq, kStopper, client_id, instrument, side, stop_price, limit_price, qty, tif);
+}
+
+// The best price resting on one side of kFirst's book, read from a snapshot
+// (whose sides are best first).
+std::optional<Price> best(const MatchingEngine& engine, Side side) {
+    for (const auto& book : engine.snapshot().instruments) {
+        const auto& orders = side == Side::Buy ? book.bids : book.asks;
+        if (book.instrument_id == kFirst && !orders.empty()) {
+            return orders.front().price;
+        }
+    }
+    return std::nullopt;
+}
+
+[[nodiscard]] std::vector<Price> trade_prices(const CollectingSink& out) {
+    std::vector<Price> prices;
+    for (const TradeExecuted& trade : out.of<TradeExecuted>()) {
+        prices.push_back(trade.price);
+    }
+    return prices;
+}
+
+[[nodiscard]] std::vector<ExchangeOrderId> added_ids(const CollectingSink& out) {
+    std::vector<ExchangeOrderId> ids;
+    for (const BookOrderAdded& added : out.of<BookOrderAdded>()) {
+        ids.push_back(added.exchange_order_id);
+    }
+    return ids;
+}
+
+[[nodiscard]] std::optional<RejectReason> rejection(const CollectingSink& out) {
+    for (const auto& ev : out.events) {
+        if (const auto* rejected = std::get_if<OrderRejected>(&ev)) {
+            return rejected->reason;
+        }
+    }
+    return std::nullopt;
+}
+
+TEST(StopOrders, ABuyStopWaitsOffTheBookUntilATradeReachesItsStopPrice) {
+    MatchingEngine engine{kFirst};
+    CollectingSink out;
+    engine.process(new_order(1, kMaker, 1, kFirst, Side::Sell, 101, 10), out.sink());
+    engine.process(stop(2, 1, kFirst, Side::Buy, 101, 102, 4), out.sink());
+    EXPECT_EQ(out.count<OrderAccepted>(), 2u);
+    EXPECT_EQ(out.count<BookOrderAdded>(), 1u); // the maker's only
+    EXPECT_EQ(engine.pending_stops(), 1u);
+    EXPECT_EQ(best(engine, Side::Buy), std::nullopt);
+
+    // A trade below the stop price leaves it where it is.
+    engine.process(new_order(3, kMaker, 2, kFirst, Side::Buy, 100, 1), out.sink());
+    CollectingSink below;
+    engine.process(new_order(4, kTaker, 1, kFirst, Side::Sell, 100, 1), below.sink());
+    EXPECT_EQ(trade_prices(below), (std::vector<Price>{100}));
+    EXPECT_EQ(engine.pending_stops(), 1u);
+
+    CollectingSink reached;
+    engine.process(new_order(5, kTaker, 2, kFirst, Side::Buy, 101, 1), reached.sink());
+    EXPECT_EQ(trade_prices(reached), (std::vector<Price>{101, 101}));
+    EXPECT_EQ(engine.pending_stops(), 0u);
+    const TradeExecuted* released = nullptr;
+    for (const auto& ev : reached.events) {
+        if (const auto* trade = std::get_if<TradeExecuted>(&ev)) released = trade;
+    }
+    ASSERT_NE(released, nullptr);
+    EXPECT_EQ(released->command_sequence, 5u);
+    EXPECT_EQ(released->buyer.account_id, kStopper);
+    EXPECT_EQ(released->buyer.client_order_id, 1u);
+    EXPECT_EQ(released->quantity, 4u);
+    EXPECT_EQ(best(engine, Side::Sell), std::optional<Price>(101));
+}
+
+// Before a book's first trade any stop price is accepted, so one trade can
+// reach stops on both sides: buy stops go first, lowest stop price first,
+// then sell stops, highest first, each price in arrival order.
+TEST(StopOrders, TriggeredStopsEnterBuysLowestFirstThenSellsHighestFirst) {
+    MatchingEngine engine{kFirst};
+    CollectingSink out;
+    engine.process(stop(1, 1, kFirst, Side::Buy, 100, 90, 1), out.sink());
+    engine.process(stop(2, 2, kFirst, Side::Buy, 99, 90, 1), out.sink());
+    engine.process(stop(3, 3, kFirst, Side::Buy, 100, 90, 1), out.sink());
+    engine.process(stop(4, 4, kFirst, Side::Sell, 101, 110, 1), out.sink());
+    engine.process(stop(5, 5, kFirst, Side::Sell, 102, 110, 1), out.sink());
+    engine.process(stop(6, 6, kFirst, Side::Buy, 101, 90, 1), out.sink()); // not reached
+    engine.process(new_order(7, kMaker, 1, kFirst, Side::Sell, 100, 1), out.sink());
+
+    CollectingSink trade;
+    engine.process(new_order(8, kTaker, 1, kFirst, Side::Buy, 100, 1), trade.sink());
+    // Exchange order ids follow acceptance, so they match the client ids.
+    EXPECT_EQ(added_ids(trade), (std::vector<ExchangeOrderId>{2, 1, 3, 5, 4}));
+    EXPECT_EQ(engine.pending_stops(), 1u);
+    EXPECT_EQ(best(engine, Side::Buy), std::optional<Price>(90));
+    EXPECT_EQ(best(engine, Side::Sell), std::optional<Price>(110));
+}
+
+// A released stop that trades can reach further stops, all within the
+// command that started it.
+TEST(StopOrders, AReleasedStopsOwnTradesCascadeIntoFurtherStops) {
+    MatchingEngine engine{kFirst};
+    CollectingSink out;
+    engine.process(new_order(1, kMaker, 1, kFirst, Side::Sell, 101, 1), out.sink());
+    engine.process(new_order(2, kMaker, 2, kFirst, Side::Sell, 102, 1), out.sink());
+    engine.process(new_order(3, kMaker, 3, kFirst, Side::Sell, 103, 1), out.sink());
+    engine.process(stop(4, 1, kFirst, Side::Buy, 101, 102, 1), out.sink());
+    engine.process(stop(5, 2, kFirst, Side::Buy, 102, 103, 1), out.sink());
+
+    CollectingSink trade;
+    engine.process(new_order(6, kTaker, 1, kFirst, Side::Buy, 101, 1), trade.sink());
+    EXPECT_EQ(trade_prices(trade), (std::vector<Price>{101, 102, 103}));
+    for (const auto& ev : trade.events) {
+        if (const auto* executed = std::get_if<TradeExecuted>(&ev)) {
+            EXPECT_EQ(executed->command_sequence, 6u);
+        }
+    }
+    EXPECT_EQ(engine.pending_stops(), 0u);
+    EXPECT_EQ(best(engine, Side::Sell), std::nullopt);
+}
+
+// One order sweeping several levels reaches every stop priced anywhere in
+// the range it traded through, not only at its last price.
+TEST(StopOrders, ASweepReachesEveryStopInTheRangeItTradedThrough) {
+    MatchingEngine engine{kFirst};
+    CollectingSink out;
+    engine.process(new_order(1, kMaker, 1, kFirst, Side::Buy, 103, 1), out.sink());
+    engine.process(new_order(2, kMaker, 2, kFirst, Side::Buy, 102, 1), out.sink());
+    engine.process(new_order(3, kMaker, 3, kFirst, Side::Buy, 101, 1), out.sink());
+    engine.process(stop(4, 1, kFirst, Side::Sell, 102, 120, 1), out.sink());
+    engine.process(stop(5, 2, kFirst, Side::Sell, 100, 120, 1), out.sink());
+
+    CollectingSink sweep;
+    engine.process(new_order(6, kTaker, 1, kFirst, Side::Sell, 101, 3), sweep.sink());
+    EXPECT_EQ(trade_prices(sweep), (std::vector<Price>{103, 102, 101}));
+    EXPECT_EQ(added_ids(sweep), (std::vector<ExchangeOrderId>{4})); // the stop at 102
+    EXPECT_EQ(engine.pending_stops(), 1u);
+}
+
+TEST(StopOrders, AnUnusableStopPriceIsRejected) {
+    MatchingEngine engine{kFirst};
+    CollectingSink out;
+    engine.process(new_order(1, kMaker, 1, kFirst, Side::Sell, 100, 1), out.sink());
+    engine.process(new_order(2, kTaker, 1, kFirst, Side::Buy, 100, 1), out.sink()); // last trade 100
+
+    const auto reason = [&](const NewOrderCommand& cmd) {
+        CollectingSink sink;
+        engine.process(cmd, sink.sink());
+        return rejection(sink);
+    };
+    EXPECT_EQ(reason(stop(3, 1, kFirst, Side::Buy, 0, 101, 1)), RejectReason::InvalidStopPrice);
+    EXPECT_EQ(reason(stop(4, 2, kFirst, Side::Buy, 100, 101, 1)), RejectReason::InvalidStopPrice);
+    EXPECT_EQ(reason(stop(5, 3, kFirst, Side::Sell, 100, 99, 1)), RejectReason::InvalidStopPrice);
+    EXPECT_EQ(reason(stop(6, 4, kFirst, Side::Buy, 101, 101, 1, TimeInForce::IOC)), RejectReason::InvalidStopPrice);
+    NewOrderCommand limit_with_stop = new_order(7, kStopper, 5, kFirst, Side::Buy, 99, 1);
+    limit_with_stop.stop_price = 101;
+    EXPECT_EQ(reason(limit_with_stop), RejectReason::InvalidStopPrice);
+
+    EXPECT_EQ(reason(stop(8, 6, kFirst, Side::Buy, 101, 101, 1)), std::nullopt);
+    EXPECT_EQ(reason(stop(9, 7, kFirst, Side::Sell, 99, 99, 1)), std::nullopt);
+    // A pending stop's id is as taken as a resting order's.
+    EXPECT_EQ(reason(new_order(10, kStopper, 6, kFirst, Side::Buy, 90, 1)), RejectReason::DuplicateOrderId);
+    EXPECT_EQ(engine.pending_stops(), 2u);
+}
+
+TEST(StopOrders, CancellingAPendingStopReportsOnlyOrderCancelled) {
+    MatchingEngine engine{kFirst, kSecond};
+    CollectingSink out;
+    engine.process(stop(1, 1, kFirst, Side::Buy, 105, 106, 1), out.sink());
+
+    CollectingSink wrong_book;
+    engine.process(CancelOrderCommand{.command_sequence = 2,
+                                      .account_id = kStopper,
+                                      .client_order_id = 1,
+                                      .instrument_id = kSecond},
+                   wrong_book.sink());
+    EXPECT_EQ(rejection(wrong_book), RejectReason::UnknownOrderId);
+
+    CollectingSink replace;
+    engine.process(ReplaceOrderCommand{.command_sequence = 2,
+                                       .account_id = kStopper,
+                                       .original_client_order_id = 1,
+                                       .new_client_order_id = 2,
+                                       .instrument_id = kFirst,
+                                       .new_price = 107,
+                                       .new_quantity = 1},
+                   replace.sink());
+    EXPECT_EQ(rejection(replace), RejectReason::InvalidReplacement);
+    EXPECT_EQ(engine.pending_stops(), 1u);
+
+    CollectingSink cancel;
+    engine.process(CancelOrderCommand{.command_sequence = 3,
+                                      .account_id = kStopper,
+                                      .client_order_id = 1,
+                                      .instrument_id = kFirst},
+                   cancel.sink());
+    ASSERT_EQ(cancel.events.size(), 1u);
+    EXPECT_EQ(std::get<OrderCancelled>(cancel.events[0]).client_order_id, 1u);
+    EXPECT_EQ(engine.pending_stops(), 0u);
+
+    // Gone for good: a trade through its stop price finds nothing.
+    engine.process(new_order(4, kMaker, 1, kFirst, Side::Sell, 105, 1), out.sink());
+    CollectingSink trade;
+    engine.process(new_order(5, kTaker, 1, kFirst, Side::Buy, 105, 1), trade.sink());
+    EXPECT_EQ(trade_prices(trade), (std::vector<Price>{105}));
+    EXPECT_EQ(best(engine, Side::Buy), std::nullopt);
+}
+
+TEST(StopOrders, AMassCancelTakesTheAccountsStopsOnTheNamedSide) {
+    MatchingEngine engine{kFirst};
+    CollectingSink out;
+    engine.process(stop(1, 1, kFirst, Side::Buy, 105, 106, 1), out.sink());
+    engine.process(stop(2, 2, kFirst, Side::Sell, 95, 94, 1), out.sink());
+    engine.process(new_order(3, kStopper, 3, kFirst, Side::Buy, 90, 1), out.sink());
+
+    CollectingSink buys;
+    engine.process(MassCancelCommand{.command_sequence = 4,
+                                     .account_id = kStopper,
+                                     .instrument_id = kFirst,
+                                     .side = Side::Buy},
+                   buys.sink());
+    EXPECT_EQ(buys.count<OrderCancelled>(), 2u);
+    EXPECT_EQ(buys.count<BookOrderRemoved>(), 1u); // the resting bid; the stop was never on the book
+    EXPECT_EQ(engine.pending_stops(), 1u);
+
+    CollectingSink rest;
+    engine.process(MassCancelCommand{.command_sequence = 5,
+                                     .account_id = kStopper,
+                                     .instrument_id = std::nullopt,
+                                     .side = std::nullopt},
+                   rest.sink());
+    ASSERT_EQ(rest.events.size(), 1u);
+    EXPECT_EQ(std::get<OrderCancelled>(rest.events[0]).client_order_id, 2u);
+    EXPECT_EQ(engine.pending_stops(), 0u);
+    EXPECT_TRUE(engine.snapshot().instruments.empty());
+}
+
+TEST(StopOrders, PendingStopsAppearInSnapshotsAndTheirChanges) {
+    MatchingEngine engine{kFirst};
+    CollectingSink out;
+    (void)engine.snapshot_changes();
+    engine.process(stop(1, 1, kFirst, Side::Buy, 105, 106, 7), out.sink());
+
+    const EngineStateChanges changes = engine.snapshot_changes();
+    ASSERT_EQ(changes.books.size(), 1u);
+    const EngineStateSnapshot snapshot = engine.snapshot();
+    ASSERT_EQ(snapshot.instruments.size(), 1u);
+    const InstrumentBookSnapshot& book = snapshot.instruments[0];
+    EXPECT_TRUE(book.bids.empty());
+    EXPECT_TRUE(book.asks.empty());
+    ASSERT_EQ(book.stops.size(), 1u);
+    EXPECT_EQ(book.stops[0].stop_price, 105);
+    EXPECT_EQ(book.stops[0].order.side, Side::Buy);
+    EXPECT_EQ(book.stops[0].order.price, 106);
+    EXPECT_EQ(book.stops[0].order.remaining_quantity, 7u);
+    EXPECT_EQ(changes.books[0], book);
+    // The books, and so the rolling hash, hold nothing yet.
+    EXPECT_EQ(engine.state_hash(), persistence::rolling_state_hash(snapshot));
+}
+
+TEST(StopOrders, ReplayingTheJournalReleasesTheSameStopsAtTheSamePoint) {
+    const std::vector<ExchangeCommand> commands{
+        new_order(1, kMaker, 1, kFirst, Side::Sell, 101, 5),
+        new_order(2, kMaker, 2, kFirst, Side::Sell, 102, 5),
+        stop(3, 1, kFirst, Side::Buy, 101, 102, 6),
+        stop(4, 2, kFirst, Side::Sell, 98, 97, 2),
+        new_order(5, kTaker, 1, kFirst, Side::Buy, 101, 1),
+        stop(6, 3, kFirst, Side::Buy, 103, 104, 1),
+    };
+    std::vector<std::byte> journal;
+    for (const auto& command : commands) {
+        persistence::encode_command(command, journal);
+    }
+
+    MatchingEngine live{kFirst};
+    CollectingSink live_out;
+    for (const auto& command : commands) {
+        live.process(command, live_out.sink());
+    }
+
+    MatchingEngine replayed{kFirst};
+    CollectingSink replay_out;
+    std::size_t offset = 0;
+    while (offset < journal.size()) {
+        const auto header = persistence::decode_command_header(std::span(journal).subspan(offset));
+        ASSERT_TRUE(std::holds_alternative<persistence::CommandHeader>(header));
+        const std::size_t frame_size = persistence::HEADER_SIZE + std::get<persistence::CommandHeader>(header).payload_size;
+        const auto frame = persistence::decode_journal_frame(std::span(journal).subspan(offset, frame_size));
+        const auto* command = std::get_if<ExchangeCommand>(&frame);
+        ASSERT_NE(command, nullptr);
+        replayed.process(*command, replay_out.sink());
+        offset += frame_size;
+    }
+
+    EXPECT_EQ(replay_out.events, live_out.events);
+    EXPECT_EQ(replayed.snapshot(), live.snapshot());
+    EXPECT_EQ(persistence::hash_state_snapshot(replayed.snapshot()), persistence::hash_state_snapshot(live.snapshot()));
+    EXPECT_EQ(live.pending_stops(), 2u);
+    EXPECT_EQ(trade_prices(live_out), (std::vector<Price>{101, 101, 102}));
+}
+
+// The hold opens when the stop is accepted, at its limit price, and closes
+// when it is cancelled -- the same as any other order's.
+TEST(StopOrders, AStopHoldsFundsFromAcceptanceThroughTheRiskGate) {
+    MatchingEngine engine{kFirst};
+    ledger::Ledger ledger;
+    ledger.deposit_cash(kStopper, 10'000);
+    risk::RiskGatedEngine gated(engine, ledger);
+
+    CollectingSink out;
+    gated.process(stop(1, 1, kFirst, Side::Buy, 105, 106, 10), out.sink());
+    ASSERT_EQ(out.count<OrderRejected>(), 0u);
+    EXPECT_EQ(ledger.available_cash(kStopper), 10'000 - 1'060);
+
+    gated.process(CancelOrderCommand{.command_sequence = 2,
+                                     .account_id = kStopper,
+                                     .client_order_id = 1,
+                                     .instrument_id = kFirst},
+                  out.sink());
+    EXPECT_EQ(ledger.available_cash(kStopper), 10'000);
+}
+
+} // namespace
+} // namespace mdh::exchange
@@ -177,3 +177,37 @@ TEST(TcpSocket, MoveTransfersOwnership) {
     // destroy", which the destructor's fd_ >= 0 check guarantees -- same
     // convention as UdpSocket's own MoveTransfersOwnership test.
 }
+
+// read() answers std::nullopt for both of the first two cases below; an
+// event loop needs them told apart, and the third -- end of stream -- told
+// apart from both.
+TEST(TcpSocket, TryReadTellsWouldBlockFromDataFromEndOfStream) {
+    TcpSocket listener;
+    ASSERT_TRUE(listener.listen(0));
+    TcpSocket client;
+    ASSERT_TRUE(client.connect("127.0.0.1", *listener.local_port()));
+    auto server_conn = listener.accept();
+    ASSERT_TRUE(server_conn.has_value());
+    server_conn->set_non_blocking();
+
+    std::array<std::byte, 64> buf{};
+    EXPECT_EQ(server_conn->try_read(buf).status, TcpSocket::IoStatus::WouldBlock);
+
+    const std::array<std::byte, 3> payload = {std::byte{1}, std::byte{2}, std::byte{3}};
+    const auto written = server_conn->try_write(payload);
+    EXPECT_EQ(written.status, TcpSocket::IoStatus::Done);
+    EXPECT_EQ(written.bytes, payload.size());
+    ASSERT_TRUE(client.write(payload).has_value());
+    std::this_thread::sleep_for(std::chrono::milliseconds(20)); // loopback delivery
+    const auto read = server_conn->try_read(buf);
+    EXPECT_EQ(read.status, TcpSocket::IoStatus::Done);
+    EXPECT_EQ(read.bytes, payload.size());
+
+    std::array<std::byte, 64> client_buf{};
+    ASSERT_TRUE(client.read(client_buf).has_value()); // unread bytes would make the close a reset, not an EOF
+    client = TcpSocket{}; // peer EOF
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    const auto eof = server_conn->try_read(buf);
+    EXPECT_EQ(eof.status, TcpSocket::IoStatus::Done);
+    EXPECT_EQ(eof.bytes, 0u);
+}
@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+
+#include "common/thread_placement.hpp"
+
+using namespace mdh;
+
+TEST(ThreadPlacement, ParsesCpuListsAsSortedDistinctCores) {
+    EXPECT_EQ(parse_cpu_list("3"), (std::vector<int>{3}));
+    EXPECT_EQ(parse_cpu_list("0,2"), (std::vector<int>{0, 2}));
+    EXPECT_EQ(parse_cpu_list("4-7"), (std::vector<int>{4, 5, 6, 7}));
+    EXPECT_EQ(parse_cpu_list("6,0,4-6"), (std::vector<int>{0, 4, 5, 6}));
+}
+
+TEST(ThreadPlacement, RejectsMalformedCpuLists) {
+    for (const char* bad : {"", ",", "1,", "a", "-1", "3-1", "1-", "1--2", "2 ", "1;2"}) {
+        EXPECT_FALSE(parse_cpu_list(bad).has_value()) << '"' << bad << '"';
+    }
+}
+
+TEST(ThreadPlacement, RoleNamesRoundTrip) {
+    for (std::size_t i = 0; i < kThreadRoleCount; ++i) {
+        const auto role = static_cast<ThreadRole>(i);
+        EXPECT_EQ(thread_role_from_name(thread_role_name(role)), role);
+    }
+    EXPECT_EQ(thread_role_name(ThreadRole::Matching), "matching");
+    EXPECT_FALSE(thread_role_from_name("Matching").has_value());
+    EXPECT_FALSE(thread_role_from_name("").has_value());
+}
+
+// Each case runs on a thread of its own: placement is permanent for the
+// thread it is applied to, and the test runner's own thread should come out
+// of this file as it went in.
+
+TEST(ThreadPlacement, DefaultPlacementOnlyNamesTheThreadAndCutsLongNames) {
+    std::string name;
+    PlacementOutcome outcome;
+    std::jthread([&] {
+        outcome = place_current_thread("mdh-a-name-well-past-fifteen", ThreadPlacement{});
+        char buffer[16] = {};
+        pthread_getname_np(pthread_self(), buffer, sizeof(buffer));
+        name = buffer;
+    }).join();
+    EXPECT_TRUE(outcome.named);
+    EXPECT_TRUE(outcome.pinned);   // nothing asked for
+    EXPECT_TRUE(outcome.realtime); // nothing asked for
+    EXPECT_EQ(name, "mdh-a-name-well");
+}
+
+TEST(ThreadPlacement, PinsToTheRequestedCore) {
+    // Core 0 is the one core every machine running this has -- unless this
+    // process's own cpuset excludes it, in which case there is nothing to test.
+    cpu_set_t allowed;
+    ASSERT_EQ(sched_getaffinity(0, sizeof(allowed), &allowed), 0);
+    if (!CPU_ISSET(0, &allowed)) {
+        GTEST_SKIP() << "core 0 is outside this process's cpuset";
+    }
+
+    PlacementOutcome outcome;
+    int cores_after = 0;
+    std::jthread([&] {
+        outcome = place_current_thread("mdh-pin-test", ThreadPlacement{.cpus = {0}});
+        cpu_set_t set;
+        pthread_getaffinity_np(pthread_self(), sizeof(set), &set);
+        cores_after = CPU_COUNT(&set);
+    }).join();
+    EXPECT_TRUE(outcome.pinned);
+    EXPECT_EQ(cores_after, 1);
+}
+
+TEST(ThreadPlacement, ACoreThatDoesNotExistIsReportedNotFatal) {
+    PlacementOutcome outcome;
+    std::jthread([&] { outcome = place_current_thread("mdh-bad-pin", ThreadPlacement{.cpus = {1000}}); }).join();
+    EXPECT_TRUE(outcome.named);
+    EXPECT_FALSE(outcome.pinned);
+}
+
+// Whether SCHED_FIFO is granted depends on the privileges the tests run
+// with, so only the outcome's agreement with the thread's actual policy is
+// checked. The thread does nothing afterwards: a realtime thread that spun
+// here could starve the runner on a single core.
+TEST(ThreadPlacement, RealtimeOutcomeMatchesTheThreadsPolicy) {
+    PlacementOutcome outcome;
+    int policy = -1;
+    sched_param param{};
+    std::jthread([&] {
+        outcome = place_current_thread("mdh-fifo-test", ThreadPlacement{.realtime_priority = 10});
+        pthread_getschedparam(pthread_self(), &policy, &param);
+    }).join();
+    if (outcome.realtime) {
+        EXPECT_EQ(policy, SCHED_FIFO);
+        EXPECT_EQ(param.sched_priority, 10);
+    } else {
+        EXPECT_NE(policy, SCHED_FIFO);
+    }
+}
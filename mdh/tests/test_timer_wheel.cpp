@@ -0,0 +1,145 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "common/timer_wheel.hpp"
+
+namespace mdh {
+namespace {
+
+using Wheel = TimerWheel<int>;
+
+struct Fired {
+    std::vector<std::pair<int, Timestamp>> timers;
+
+    auto fire() {
+        return [this](const int& payload, Timestamp at) { timers.emplace_back(payload, at); };
+    }
+
+    [[nodiscard]] std::vector<int> payloads() const {
+        std::vector<int> out;
+        for (const auto& [payload, at] : timers) out.push_back(payload);
+        return out;
+    }
+};
+
+TEST(TimerWheel, FiresOnTheFirstTickAtOrAfterTheDeadlineAndNeverBefore) {
+    Wheel wheel(10);
+    (void)wheel.schedule(25, 1); // due at tick 3, i.e. time 30
+    (void)wheel.schedule(30, 2); // due at tick 3 exactly
+
+    Fired fired;
+    EXPECT_EQ(wheel.advance(29, fired.fire()), 0u);
+    EXPECT_EQ(wheel.advance(30, fired.fire()), 2u);
+    EXPECT_EQ(fired.payloads(), (std::vector<int>{1, 2}));
+    EXPECT_EQ(fired.timers[0].second, 25u); // the exact time, not the tick
+    EXPECT_TRUE(wheel.empty());
+}
+
+TEST(TimerWheel, CancelledTimersNeverFireAndTheirNodesAreReused) {
+    Wheel wheel(1);
+    const Wheel::TimerId a = wheel.schedule(100, 1);
+    const Wheel::TimerId b = wheel.schedule(70'000, 2); // level 2
+    (void)wheel.schedule(100, 3);
+    wheel.cancel(a);
+    wheel.cancel(b);
+    EXPECT_EQ(wheel.size(), 1u);
+    EXPECT_EQ(wheel.schedule(200, 4), b); // last freed, first reused
+
+    Fired fired;
+    (void)wheel.advance(100'000, fired.fire());
+    EXPECT_EQ(fired.payloads(), (std::vector<int>{3, 4}));
+}
+
+// Deadlines spread over every level and the overflow list, reached in one
+// jump: each has to cascade down level by level and still come out in
+// deadline order.
+TEST(TimerWheel, OneLongAdvanceCascadesEveryLevelInDeadlineOrder) {
+    Wheel wheel(1);
+    const std::vector<Timestamp> deadlines{5, 300, 70'000, 17'000'000, 5'000'000'000ULL, 9'000'000'000ULL};
+    for (std::size_t i = deadlines.size(); i-- > 0;) {
+        (void)wheel.schedule(deadlines[i], static_cast<int>(i));
+    }
+
+    Fired fired;
+    EXPECT_EQ(wheel.advance(10'000'000'000ULL, fired.fire()), deadlines.size());
+    EXPECT_EQ(fired.payloads(), (std::vector<int>{0, 1, 2, 3, 4, 5}));
+}
+
+TEST(TimerWheel, ATimeAlreadyReachedFiresAtTheNextTick) {
+    Wheel wheel(10);
+    Fired fired;
+    (void)wheel.advance(1'000, fired.fire());
+    (void)wheel.schedule(500, 1);
+    EXPECT_EQ(wheel.advance(1'005, fired.fire()), 0u);
+    EXPECT_EQ(wheel.advance(1'010, fired.fire()), 1u);
+}
+
+TEST(TimerWheel, MovingBackwardsDoesNothing) {
+    Wheel wheel(1);
+    (void)wheel.schedule(50, 1);
+    Fired fired;
+    (void)wheel.advance(40, fired.fire());
+    EXPECT_EQ(wheel.advance(10, fired.fire()), 0u);
+    EXPECT_EQ(wheel.advance(50, fired.fire()), 1u);
+}
+
+// Against a model that knows nothing about levels: a timer is due once the
+// wheel's tick has reached its deadline rounded up, and each advance fires
+// exactly the due timers still pending, in nondecreasing deadline order.
+// Advances are a mix of small steps and jumps across whole levels, starting
+// from far enough out that the overflow list is used too.
+TEST(TimerWheel, MatchesAReferenceModelUnderRandomOperations) {
+    constexpr Timestamp kTick = 7;
+    Wheel wheel(kTick);
+    std::mt19937_64 rng(20240611);
+    std::map<Wheel::TimerId, std::pair<int, Timestamp>> pending;
+    Timestamp now = 0;
+    int next_payload = 0;
+    const auto deadline_tick = [](Timestamp at) { return at / kTick + (at % kTick != 0 ? 1 : 0); };
+
+    for (int step = 0; step < 20'000; ++step) {
+        const std::uint64_t roll = rng() % 100;
+        if (roll < 55) {
+            const std::uint64_t span = std::uint64_t{1} << (rng() % 42);
+            const Timestamp at = now + 1 + rng() % span;
+            const int payload = next_payload++;
+            pending[wheel.schedule(at, payload)] = {payload, at};
+        } else if (roll < 70 && !pending.empty()) {
+            auto it = pending.begin();
+            std::advance(it, static_cast<std::ptrdiff_t>(rng() % pending.size()));
+            wheel.cancel(it->first);
+            pending.erase(it);
+        } else {
+            const std::uint64_t span = std::uint64_t{1} << (rng() % 40);
+            now += rng() % span;
+            std::vector<int> expected;
+            for (auto it = pending.begin(); it != pending.end();) {
+                if (deadline_tick(it->second.second) <= now / kTick) {
+                    expected.push_back(it->second.first);
+                    it = pending.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            Fired fired;
+            ASSERT_EQ(wheel.advance(now, fired.fire()), expected.size());
+            for (std::size_t i = 1; i < fired.timers.size(); ++i) {
+                ASSERT_LE(deadline_tick(fired.timers[i - 1].second), deadline_tick(fired.timers[i].second));
+            }
+            std::vector<int> got = fired.payloads();
+            std::sort(got.begin(), got.end());
+            std::sort(expected.begin(), expected.end());
+            ASSERT_EQ(got, expected);
+        }
+        ASSERT_EQ(wheel.size(), pending.size());
+    }
+}
+
+} // namespace
+} // namespace mdh
@@ -0,0 +1,177 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "net/tcp_socket.hpp"
+#include "net/uring.hpp"
+
+using namespace mdh::net;
+using namespace std::chrono_literals;
+
+// The io_uring instance under the gateway's io_uring event loops. Needs
+// Linux 6.0 or later with io_uring allowed; elsewhere the ring never opens
+// and these have nothing to check.
+
+namespace {
+
+constexpr unsigned kEntries = 64;
+constexpr unsigned kBuffers = 8;
+constexpr std::size_t kBufferSize = 64;
+
+// Waits, a bounded number of times, until `want` completions have been
+// collected.
+std::vector<UringCompletion> collect(Uring& ring, std::size_t want) {
+    std::vector<UringCompletion> seen;
+    for (int attempt = 0; attempt < 100 && seen.size() < want; ++attempt) {
+        ring.submit_and_wait(100ms);
+        ring.for_each_completion([&](const UringCompletion& completion) { seen.push_back(completion); });
+    }
+    return seen;
+}
+
+} // namespace
+
+TEST(Uring, MultishotAcceptReportsEveryConnectionFromOneSubmission) {
+    Uring ring(kEntries, kBuffers, kBufferSize);
+    if (!ring.is_open()) {
+        GTEST_SKIP() << "no io_uring here";
+    }
+    TcpSocket listener;
+    ASSERT_TRUE(listener.listen(0));
+    listener.set_non_blocking(); // as the gateway's is
+    constexpr std::uint64_t kAccept = 5;
+    ASSERT_TRUE(ring.accept_multishot(listener.raw_fd(), kAccept));
+
+    std::array<TcpSocket, 3> clients;
+    for (auto& client : clients) {
+        ASSERT_TRUE(client.connect("127.0.0.1", *listener.local_port()));
+    }
+    const auto seen = collect(ring, clients.size());
+    ASSERT_EQ(seen.size(), clients.size());
+    for (const auto& completion : seen) {
+        EXPECT_EQ(completion.user_data, kAccept);
+        ASSERT_GE(completion.res, 0);
+        EXPECT_TRUE(completion.more()); // still armed for the next one
+        (void)TcpSocket::adopt(completion.res); // and closed again
+    }
+}
+
+TEST(Uring, MultishotRecvFillsProvidedBuffersUntilEndOfStream) {
+    Uring ring(kEntries, kBuffers, kBufferSize);
+    if (!ring.is_open()) {
+        GTEST_SKIP() << "no io_uring here";
+    }
+    TcpSocket listener;
+    ASSERT_TRUE(listener.listen(0));
+    TcpSocket client;
+    ASSERT_TRUE(client.connect("127.0.0.1", *listener.local_port()));
+    auto server = listener.accept();
+    ASSERT_TRUE(server.has_value());
+    constexpr std::uint64_t kRecv = 9;
+    ASSERT_TRUE(ring.recv_multishot(server->raw_fd(), kRecv));
+
+    // More chunks than there are buffers: handing each back keeps the recv
+    // going on the same submission.
+    std::string received;
+    for (int chunk = 0; chunk < 3 * static_cast<int>(kBuffers); ++chunk) {
+        const std::string text = "chunk-" + std::to_string(chunk) + ";";
+        ASSERT_TRUE(client.write(std::as_bytes(std::span(text))).has_value());
+        const std::size_t before = received.size();
+        for (int attempt = 0; attempt < 100 && received.size() < before + text.size(); ++attempt) {
+            ring.submit_and_wait(100ms);
+            ring.for_each_completion([&](const UringCompletion& completion) {
+                ASSERT_EQ(completion.user_data, kRecv);
+                ASSERT_GT(completion.res, 0);
+                EXPECT_TRUE(completion.more());
+                const auto id = completion.buffer();
+                ASSERT_TRUE(id.has_value());
+                const auto bytes = ring.buffer(*id, static_cast<std::size_t>(completion.res));
+                received.append(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+                ring.recycle(*id);
+            });
+        }
+    }
+    std::string expected;
+    for (int chunk = 0; chunk < 3 * static_cast<int>(kBuffers); ++chunk) {
+        expected += "chunk-" + std::to_string(chunk) + ";";
+    }
+    EXPECT_EQ(received, expected);
+
+    client = TcpSocket{};
+    const auto end = collect(ring, 1);
+    ASSERT_EQ(end.size(), 1u);
+    EXPECT_EQ(end[0].res, 0); // end of stream, and the recv is over
+    EXPECT_FALSE(end[0].more());
+}
+
+TEST(Uring, QueuedSendsGoInTogetherWithOneEnter) {
+    Uring ring(kEntries, kBuffers, kBufferSize);
+    if (!ring.is_open()) {
+        GTEST_SKIP() << "no io_uring here";
+    }
+    TcpSocket listener;
+    ASSERT_TRUE(listener.listen(0));
+    std::array<TcpSocket, 4> clients;
+    std::vector<TcpSocket> servers;
+    for (auto& client : clients) {
+        ASSERT_TRUE(client.connect("127.0.0.1", *listener.local_port()));
+        auto server = listener.accept();
+        ASSERT_TRUE(server.has_value());
+        servers.push_back(std::move(*server));
+    }
+
+    const std::string payload = "report";
+    ring.submit_and_wait(0ms); // the wake read queued at construction, out of the way
+    const std::uint64_t before = ring.enters();
+    for (std::size_t i = 0; i < servers.size(); ++i) {
+        ASSERT_TRUE(ring.send(servers[i].raw_fd(), std::as_bytes(std::span(payload)), i));
+    }
+    ring.submit_and_wait(1000ms);
+    EXPECT_EQ(ring.enters(), before + 1);
+
+    const auto seen = collect(ring, servers.size());
+    ASSERT_EQ(seen.size(), servers.size());
+    for (const auto& completion : seen) {
+        EXPECT_EQ(completion.res, static_cast<std::int32_t>(payload.size()));
+    }
+    for (auto& client : clients) {
+        std::array<std::byte, 16> buf{};
+        const auto n = client.read(buf);
+        ASSERT_TRUE(n.has_value());
+        EXPECT_EQ(*n, payload.size());
+    }
+}
+
+TEST(Uring, WakeEndsAWaitFromAnotherThreadAndIsNeverReported) {
+    Uring ring(kEntries, kBuffers, kBufferSize);
+    if (!ring.is_open()) {
+        GTEST_SKIP() << "no io_uring here";
+    }
+    std::size_t reported = 0;
+    auto tally = [&reported](const UringCompletion&) { ++reported; };
+    std::jthread waker([&ring] {
+        std::this_thread::sleep_for(20ms);
+        ring.wake();
+    });
+    const auto start = std::chrono::steady_clock::now();
+    ring.submit_and_wait(-1ms); // indefinitely, but for the wake
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 5s);
+    ring.for_each_completion(tally);
+    EXPECT_EQ(reported, 0u);
+
+    // Re-armed: a second wake ends a second wait just the same.
+    ring.wake();
+    ring.submit_and_wait(1000ms);
+    ring.for_each_completion(tally);
+    const auto quiet = std::chrono::steady_clock::now();
+    ring.submit_and_wait(20ms);
+    ring.for_each_completion(tally);
+    EXPECT_GE(std::chrono::steady_clock::now() - quiet, 15ms);
+    EXPECT_EQ(reported, 0u);
+}
@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "common/wait_strategy.hpp"
+
+using namespace mdh;
+using namespace std::chrono_literals;
+
+TEST(WaitStrategy, ReturnsAtOnceWhenAlreadyReadyWithoutParking) {
+    for (const WaitPolicy policy : {WaitPolicy::BusySpin, WaitPolicy::SpinThenYield, WaitPolicy::Park}) {
+        WaitStrategy wait(policy);
+        int checks = 0;
+        wait.wait_until([&] { return ++checks > 0; });
+        EXPECT_EQ(checks, 1);
+        EXPECT_EQ(wait.park_count(), 0u);
+    }
+}
+
+TEST(WaitStrategy, NotifyIsANoOpWithNobodyWaiting) {
+    WaitStrategy wait(WaitPolicy::Park);
+    wait.notify();
+    wait.notify();
+    EXPECT_EQ(wait.park_count(), 0u);
+}
+
+// The consumer outlasts its spin, parks, and must be woken by the producer's
+// notify() -- nothing else ever clears the flag it sleeps on, so a lost
+// wake-up would hang this test rather than slow it down.
+TEST(WaitStrategy, ParkedConsumerIsWokenByNotify) {
+    WaitStrategy wait(WaitPolicy::Park);
+    std::atomic<bool> published{false};
+    std::atomic<bool> woke{false};
+
+    std::jthread consumer([&] {
+        wait.wait_until([&] { return published.load(std::memory_order_acquire); });
+        woke.store(true);
+    });
+
+    // Long enough for the consumer to get past its spin on any scheduler.
+    const auto deadline = std::chrono::steady_clock::now() + 2s;
+    while (wait.park_count() == 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(1ms);
+    }
+    ASSERT_GE(wait.park_count(), 1u);
+    EXPECT_FALSE(woke.load());
+
+    published.store(true, std::memory_order_release);
+    wait.notify();
+    consumer.join();
+    EXPECT_TRUE(woke.load());
+}
+
+// Many publish/wait round trips, each a fresh chance for the producer's
+// notify() to slip in between the consumer's last check and its sleep. The
+// count only reaches kRounds if every one of them was seen.
+TEST(WaitStrategy, NoWakeUpIsLostAcrossManyRoundTrips) {
+    constexpr int kRounds = 20'000;
+    for (const WaitPolicy policy : {WaitPolicy::SpinThenYield, WaitPolicy::Park}) {
+        WaitStrategy wait(policy);
+        std::atomic<int> published{0};
+        int consumed = 0;
+
+        std::jthread consumer([&] {
+            while (consumed < kRounds) {
+                wait.wait_until([&] { return published.load(std::memory_order_acquire) > consumed; });
+                consumed = published.load(std::memory_order_acquire);
+            }
+        });
+        for (int i = 1; i <= kRounds; ++i) {
+            published.store(i, std::memory_order_release);
+            wait.notify();
+            if (i % 64 == 0) {
+                std::this_thread::yield(); // let the consumer run dry and park now and then
+            }
+        }
+        consumer.join();
+        EXPECT_EQ(consumed, kRounds);
+    }
+}
+
+// With a deadline, every policy gives up once it passes -- Park from its
+// sleep, not after it -- and reports that nothing came.
+TEST(WaitStrategy, AWaitWithADeadlineGivesUpAtIt) {
+    for (const WaitPolicy policy : {WaitPolicy::BusySpin, WaitPolicy::SpinThenYield, WaitPolicy::Park}) {
+        WaitStrategy wait(policy);
+        const auto start = std::chrono::steady_clock::now();
+        EXPECT_FALSE(wait.wait_until([] { return false; }, start + 20ms));
+        const auto waited = std::chrono::steady_clock::now() - start;
+        EXPECT_GE(waited, 20ms);
+        EXPECT_LT(waited, 2s);
+    }
+}
+
+// ...and a notify() before it ends the wait there, long before the deadline.
+TEST(WaitStrategy, ParkedConsumerWithADeadlineIsWokenByNotify) {
+    WaitStrategy wait(WaitPolicy::Park);
+    std::atomic<bool> published{false};
+    std::atomic<bool> ready{false};
+
+    std::jthread consumer([&] {
+        ready.store(wait.wait_until([&] { return published.load(std::memory_order_acquire); },
+                                    std::chrono::steady_clock::now() + 60s));
+    });
+    const auto deadline = std::chrono::steady_clock::now() + 2s;
+    while (wait.park_count() == 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(1ms);
+    }
+    ASSERT_GE(wait.park_count(), 1u);
+
+    published.store(true, std::memory_order_release);
+    wait.notify();
+    consumer.join(); // hangs for a minute if the wake-up was lost
+    EXPECT_TRUE(ready.load());
+}